@@ -13,10 +13,17 @@
 #include "AfxStreams.h"
 #include "csgo_GameEvents.h"
 
+#include <shared/AfxInteropProtocol.h>
+#include <shared/AfxInteropReplay.h>
+#include <shared/AfxInteropSharedMemory.h>
+#include <shared/AfxInteropStream.h>
+#include <shared/StringTools.h>
+
 #include <Windows.h>
 
 #include <set>
 #include <queue>
+#include <vector>
 
 #include <atomic>
 #include <mutex>
@@ -67,12 +74,75 @@ extern Hook_VClient_RenderView g_Hook_VClient_RenderView;
 extern SOURCESDK::IVRenderView_csgo * g_pVRenderView_csgo;
 
 namespace AfxInterop {
+	using namespace AfxInteropProtocol;
+
 	IAfxInteropSurface* m_Surface = NULL;
 
+	class CNamedPipeTransport : public IAfxInteropTransport
+	{
+	public:
+		/// <param name="hPipe">Is referenced, so it can be (re-)opened later.</param>
+		CNamedPipeTransport(HANDLE & hPipe) : m_hPipe(hPipe)
+		{
+
+		}
+
+		virtual size_t ReadSome(void * data, size_t size) override
+		{
+			DWORD bytesRead;
+
+			if (!ReadFile(m_hPipe, data, (DWORD)size, &bytesRead, NULL))
+			{
+				Tier0_Warning("!ReadBytes: GetLastError=%d\n", GetLastError());
+				return 0;
+			}
+
+			return bytesRead;
+		}
+
+		virtual bool GetReadable(size_t & outSize) override
+		{
+			DWORD bytesAvail;
+
+			if (!PeekNamedPipe(m_hPipe, NULL, 0, NULL, &bytesAvail, NULL))
+				return false;
+
+			outSize = bytesAvail;
+
+			return true;
+		}
+
+		virtual bool WriteAll(void const * data, size_t size) override
+		{
+			DWORD bytesWritten;
+
+			if (!WriteFile(m_hPipe, data, (DWORD)size, &bytesWritten, NULL) || size != bytesWritten)
+				return false;
+
+			return true;
+		}
+
+		virtual bool Flush(void) override
+		{
+			if (!FlushFileBuffers(m_hPipe))
+				return false;
+
+			return true;
+		}
+
+	private:
+		HANDLE & m_hPipe;
+	};
+
 	class CInteropClient : public CAfxGameEventListenerSerialzer
 	{
 	public:
-		CInteropClient(const char * pipeName) : m_EnginePipeName(pipeName)
+		CInteropClient(const char * pipeName)
+			: m_DrawingTransport(m_hDrawingPipe)
+			, m_DrawingStream(&m_DrawingTransport)
+			, m_EngineTransport(m_hEnginePipe)
+			, m_EngineStream(&m_EngineTransport)
+			, m_EnginePipeName(pipeName)
 		{
 
 		}
@@ -96,21 +166,28 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (!WriteInt32(m_hEnginePipe, EngineMessage_BeforeFrameStart)) { errorLine = __LINE__; goto error; }
+			if (8 <= m_EngineVersion)
+			{
+				if (!ReadReplies()) { errorLine = __LINE__; goto error; }
+
+				return;
+			}
 
-			if (!SendCommands(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+			if (!WriteInt32(m_EngineStream, EngineMessage_BeforeFrameStart)) { errorLine = __LINE__; goto error; }
 
-			if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+			if (!SendCommands(m_EngineStream)) { errorLine = __LINE__; goto error; }
+
+			if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
 			UINT32 commandCount;
 
-			if (!ReadCompressedUInt32(m_hEnginePipe, commandCount)) { errorLine = __LINE__; goto error; }
+			if (!ReadCompressedUInt32(m_EngineStream, commandCount)) { errorLine = __LINE__; goto error; }
 
 			for (UINT32 i = 0; i < commandCount; ++i)
 			{
 				std::string command;
 
-				if (!ReadStringUTF8(m_hEnginePipe, command)) { errorLine = __LINE__; goto error; }
+				if (!ReadStringUTF8(m_EngineStream, command)) { errorLine = __LINE__; goto error; }
 
 				g_VEngineClient->ExecuteClientCmd(command.c_str());
 			}
@@ -131,11 +208,14 @@ namespace AfxInterop {
 
 			if (!m_EngineConnected) return;
 
+			// Version 8 sends all of the frame in AfterFrameRenderStart:
+			if (8 <= m_EngineVersion) return;
+
 			int errorLine = 0;
 
-			if (!WriteInt32(m_hEnginePipe, EngineMessage_BeforeFrameRenderStart)) { errorLine = __LINE__; goto error; }
+			if (!WriteInt32(m_EngineStream, EngineMessage_BeforeFrameRenderStart)) { errorLine = __LINE__; goto error; }
 
-			if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+			if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
 			if (7 <= m_EngineVersion)
 			{
@@ -156,291 +236,41 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (!WriteInt32(m_hEnginePipe, EngineMessage_AfterFrameRenderStart)) { errorLine = __LINE__; goto error; }
-
-			if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
-
+			if (8 <= m_EngineVersion)
 			{
-				UINT32 numCalcs;
-				std::string calcName;
-
-				std::queue<HandleCalcResult*> handleCalcResults;
-				std::queue<VecAngCalcResult*> vecAngCalcResults;
-				std::queue<CamCalcResult*> camCalcResults;
-				std::queue<FovCalcResult*> fovCalcResults;
-				std::queue<BoolCalcResult*> boolCalcResults;
-				std::queue<IntCalcResult*> intCalcResults;
-
-				// Read and compute handle calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvHandleCalc* calc = g_MirvHandleCalcs.GetByName(calcName.c_str()))
-					{
-						SOURCESDK::CSGO::CBaseHandle handle;
-
-						if (calc->CalcHandle(handle))
-						{
-							handleCalcResults.push(new HandleCalcResult(handle.ToInt()));
-						}
-						else handleCalcResults.push(nullptr);
-					}
-					else handleCalcResults.push(nullptr);
-				}
-
-				// Read and compute vecang calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvVecAngCalc* calc = g_MirvVecAngCalcs.GetByName(calcName.c_str()))
-					{
-						SOURCESDK::Vector vector;
-						SOURCESDK::QAngle qangle;
-
-						if (calc->CalcVecAng(vector, qangle))
-						{
-							vecAngCalcResults.push(new VecAngCalcResult(vector.x, vector.y, vector.z, qangle.x, qangle.y, qangle.z));
-						}
-						else vecAngCalcResults.push(nullptr);
-					}
-					else vecAngCalcResults.push(nullptr);
-				}
-
-				// Read and compute cam calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvCamCalc* calc = g_MirvCamCalcs.GetByName(calcName.c_str()))
-					{
-						SOURCESDK::Vector vector;
-						SOURCESDK::QAngle qangle;
-						float fov;
-
-						if (calc->CalcCam(vector, qangle, fov))
-						{
-							camCalcResults.push(new CamCalcResult(vector.x, vector.y, vector.z, qangle.x, qangle.y, qangle.z, fov));
-						}
-						else camCalcResults.push(nullptr);
-					}
-					else camCalcResults.push(nullptr);
-				}
-
-				// Read and compute fov calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvFovCalc* calc = g_MirvFovCalcs.GetByName(calcName.c_str()))
-					{
-						float fov;
-
-						if (calc->CalcFov(fov))
-						{
-							fovCalcResults.push(new FovCalcResult(fov));
-						}
-						else fovCalcResults.push(nullptr);
-					}
-					else fovCalcResults.push(nullptr);
-				}
-
-				// Read and compute bool calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvBoolCalc* calc = g_MirvBoolCalcs.GetByName(calcName.c_str()))
-					{
-						bool result;
-
-						if (calc->CalcBool(result))
-						{
-							boolCalcResults.push(new BoolCalcResult(result));
-						}
-						else boolCalcResults.push(nullptr);
-					}
-					else boolCalcResults.push(nullptr);
-				}
-
-				// Read and compute int calcs:
-
-				if (!ReadCompressedUInt32(m_hEnginePipe, numCalcs)) { errorLine = __LINE__; goto error; }
-
-				for (UINT32 i = 0; i < numCalcs; ++i)
-				{
-					if (!ReadStringUTF8(m_hEnginePipe, calcName)) { errorLine = __LINE__; goto error; }
-
-					if (IMirvIntCalc* calc = g_MirvIntCalcs.GetByName(calcName.c_str()))
-					{
-						int result;
-
-						if (calc->CalcInt(result))
-						{
-							intCalcResults.push(new IntCalcResult(result));
-						}
-						else intCalcResults.push(nullptr);
-					}
-					else intCalcResults.push(nullptr);
-				}
-
-				// Write handle calc result:
-
-				while (!handleCalcResults.empty())
-				{
-					HandleCalcResult* result = handleCalcResults.front();
-					handleCalcResults.pop();
-
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
-
-						if (!WriteInt32(m_hEnginePipe, result->IntHandle)) { errorLine = __LINE__; goto error; }
-
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
-
-				// Write vec ang calc result:
-
-				while (!vecAngCalcResults.empty())
-				{
-					VecAngCalcResult* result = vecAngCalcResults.front();
-					vecAngCalcResults.pop();
-
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
-
-						if (!WriteSingle(m_hEnginePipe, result->X)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Y)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Z)) { errorLine = __LINE__; goto error; }
-
-						if (!WriteSingle(m_hEnginePipe, result->Pitch)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Yaw)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Roll)) { errorLine = __LINE__; goto error; }
-
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
-
-				// Write cam calc result:
+				int frameCount = AfxInterop::GetFrameCount();
 
-				while (!camCalcResults.empty())
-				{
-					CamCalcResult* result = camCalcResults.front();
-					camCalcResults.pop();
-
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
-
-						if (!WriteSingle(m_hEnginePipe, result->X)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Y)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Z)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, EngineMessage_Frame)) { errorLine = __LINE__; goto error; }
 
-						if (!WriteSingle(m_hEnginePipe, result->Pitch)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Yaw)) { errorLine = __LINE__; goto error; }
-						if (!WriteSingle(m_hEnginePipe, result->Roll)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, frameCount)) { errorLine = __LINE__; goto error; }
 
-						if (!WriteSingle(m_hEnginePipe, result->Fov)) { errorLine = __LINE__; goto error; }
-
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
+				if (!SendCommands(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
-				// Write fov calc result:
+				if (!WriteCalcResults(m_PipelineCalcs, true)) { errorLine = __LINE__; goto error; }
 
-				while (!fovCalcResults.empty())
-				{
-					FovCalcResult* result = fovCalcResults.front();
-					fovCalcResults.pop();
+				// The client answers when it wants to, see ReadReplies:
 
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
+				if (!m_EngineStream.Send()) { errorLine = __LINE__; goto error; }
 
-						if (!WriteSingle(m_hEnginePipe, result->Fov)) { errorLine = __LINE__; goto error; }
+				m_PipelineSentFrame = frameCount;
 
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
-
-				// Write bool calc result:
-
-				while (!boolCalcResults.empty())
-				{
-					BoolCalcResult* result = boolCalcResults.front();
-					boolCalcResults.pop();
-
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
+				return;
+			}
 
-						if (!WriteBoolean(m_hEnginePipe, result->Result)) { errorLine = __LINE__; goto error; }
+			if (!WriteInt32(m_EngineStream, EngineMessage_AfterFrameRenderStart)) { errorLine = __LINE__; goto error; }
 
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
+			if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
-				// Write int calc result:
+			{
+				CalcNames calcs;
 
-				while (!intCalcResults.empty())
-				{
-					IntCalcResult* result = intCalcResults.front();
-					intCalcResults.pop();
+				if (!ReadCalcNames(calcs)) { errorLine = __LINE__; goto error; }
 
-					if (result)
-					{
-						if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
+				if (!WriteCalcResults(calcs, false)) { errorLine = __LINE__; goto error; }
 
-						if (!WriteInt32(m_hEnginePipe, result->Result)) { errorLine = __LINE__; goto error; }
+				// Do not flush here, since we are not waiting for data, but hand the results to the pipe:
 
-						delete result;
-					}
-					else
-					{
-						if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-					}
-				}
-
-				// Do not flush here, since we are not waiting for data.
+				if (!m_EngineStream.Send()) { errorLine = __LINE__; goto error; }
 			}
 
 			return;
@@ -455,28 +285,45 @@ namespace AfxInterop {
 		{
 			if (!m_EngineConnected) return false;
 
+			if (8 <= m_EngineVersion)
+			{
+				// From the latest reply:
+
+				if (!m_PipelineOverrideView) return false;
+
+				Tx = m_PipelineView[0];
+				Ty = m_PipelineView[1];
+				Tz = m_PipelineView[2];
+				Rx = m_PipelineView[3];
+				Ry = m_PipelineView[4];
+				Rz = m_PipelineView[5];
+				Fov = m_PipelineView[6];
+
+				return true;
+			}
+
 			int errorLine = 0;
 
-			if (!WriteInt32(m_hEnginePipe, EngineMessage_OnViewOverride)) { errorLine = __LINE__; goto error; }
+			if (!WriteInt32(m_EngineStream, EngineMessage_OnViewOverride)) { errorLine = __LINE__; goto error; }
 
-			if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+			if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
 			{
 				bool overrideView;
 
-				if (!ReadBoolean(m_hEnginePipe, overrideView)) { errorLine = __LINE__; goto error; }
+				if (!ReadBoolean(m_EngineStream, overrideView)) { errorLine = __LINE__; goto error; }
 
 				if (overrideView)
 				{
 					FLOAT tTx, tTy, tTz, tRx, tRy, tRz, tFov;
 
-					if (!ReadSingle(m_hEnginePipe, tTx)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tTy)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tTz)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tRx)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tRy)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tRz)) { errorLine = __LINE__; goto error; }
-					if (!ReadSingle(m_hEnginePipe, tFov)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tTx)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tTy)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tTz)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tRx)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tRy)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tRz)) { errorLine = __LINE__; goto error; }
+					if (!ReadSingle(m_EngineStream, tFov)) { errorLine = __LINE__; goto error; }
 
 					Tx = tTx;
 					Ty = tTy;
@@ -518,18 +365,18 @@ namespace AfxInterop {
 			int errorLine = 0;
 			{
 
-				if (!WriteInt32(m_hEnginePipe, EngineMessage_OnRenderView)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, EngineMessage_OnRenderView)) { errorLine = __LINE__; goto error; }
 
-				if (!WriteInt32(m_hEnginePipe, engineFrame)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, engineFrame)) { errorLine = __LINE__; goto error; }
 
-				if (!WriteSingle(m_hEnginePipe, g_MirvTime.GetAbsoluteFrameTime())) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, g_MirvTime.GetTime())) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, g_MirvTime.GetFrameTime())) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, g_MirvTime.GetAbsoluteFrameTime())) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, g_MirvTime.GetTime())) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, g_MirvTime.GetFrameTime())) { errorLine = __LINE__; goto error; }
 
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledX)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledY)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledWidth)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledHeight)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledX)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledY)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledWidth)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledHeight)) { errorLine = __LINE__; goto error; }
 
 				SOURCESDK::VMatrix worldToView;
 				SOURCESDK::VMatrix viewToProjection;
@@ -538,52 +385,63 @@ namespace AfxInterop {
 
 				g_pVRenderView_csgo->GetMatricesForView(view, &worldToView, &viewToProjection, &worldToProjection, &worldToPixels);
 
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][3])) { errorLine = __LINE__; goto error; }
-
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][3])) { errorLine = __LINE__; goto error; }
-
-				if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
-
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.BeforeTranslucentShadow)) { errorLine = __LINE__; goto error; }
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.AfterTranslucentShadow)) { errorLine = __LINE__; goto error; }
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.BeforeTranslucent)) { errorLine = __LINE__; goto error; }
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.AfterTranslucent)) { errorLine = __LINE__; goto error; }
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.BeforeHud)) { errorLine = __LINE__; goto error; }
-				if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.AfterHud)) { errorLine = __LINE__; goto error; }
-
-				if (6 <= m_EngineVersion && m_EngineVersion <= 7)
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][3])) { errorLine = __LINE__; goto error; }
+
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][3])) { errorLine = __LINE__; goto error; }
+
+				if (8 <= m_EngineVersion)
 				{
-					if (!ReadBoolean(m_hEnginePipe, m_EnabledFeatures.AfterRenderView)) { errorLine = __LINE__; goto error; }
+					// From the latest reply:
+
+					if (!m_EngineStream.Send()) { errorLine = __LINE__; goto error; }
+
+					m_EnabledFeatures = m_PipelineFeatures;
+				}
+				else
+				{
+					if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
+
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.BeforeTranslucentShadow)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.AfterTranslucentShadow)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.BeforeTranslucent)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.AfterTranslucent)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.BeforeHud)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.AfterHud)) { errorLine = __LINE__; goto error; }
+
+					if (6 <= m_EngineVersion && m_EngineVersion <= 7)
+					{
+						if (!ReadBoolean(m_EngineStream, m_EnabledFeatures.AfterRenderView)) { errorLine = __LINE__; goto error; }
+					}
 				}
 			}
 
@@ -603,8 +461,8 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 			{
-				if (!WriteInt32(m_hEnginePipe, EngineMessage_OnRenderViewEnd)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, EngineMessage_OnRenderViewEnd)) { errorLine = __LINE__; goto error; }
+				if (!FlushEngine()) { errorLine = __LINE__; goto error; }
 			}
 
 			if(m_EngineVersion != 6 || m_EnabledFeatures.AfterRenderView)
@@ -656,14 +514,14 @@ namespace AfxInterop {
 					}
 				}
 
-				if (!WriteInt32(m_hEnginePipe, message)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, message)) { errorLine = __LINE__; goto error; }
 
 				SOURCESDK::CViewSetup_csgo& view = rendering3dView->AfxHackGetViewSetup();
 
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledX)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledY)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledWidth)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hEnginePipe, view.m_nUnscaledHeight)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledX)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledY)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledWidth)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, view.m_nUnscaledHeight)) { errorLine = __LINE__; goto error; }
 
 				SOURCESDK::VMatrix worldToView;
 				SOURCESDK::VMatrix viewToProjection;
@@ -672,39 +530,42 @@ namespace AfxInterop {
 
 				g_pVRenderView_csgo->GetMatricesForView(view, &worldToView, &viewToProjection, &worldToProjection, &worldToPixels);
 
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[0][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[1][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[2][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, worldToView.m[3][3])) { errorLine = __LINE__; goto error; }
-
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[0][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[1][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[2][3])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][0])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][1])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][2])) { errorLine = __LINE__; goto error; }
-				if (!WriteSingle(m_hEnginePipe, viewToProjection.m[3][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[0][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[1][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[2][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, worldToView.m[3][3])) { errorLine = __LINE__; goto error; }
+
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[0][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[1][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[2][3])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][0])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][1])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][2])) { errorLine = __LINE__; goto error; }
+				if (!WriteSingle(m_EngineStream, viewToProjection.m[3][3])) { errorLine = __LINE__; goto error; }
+
+				// The server might need these before it answers on the drawing pipe:
+				if (!m_EngineStream.Send()) { errorLine = __LINE__; goto error; }
 
 				QueueOrExecute(ctx->GetOrg(), new CAfxLeafExecute_Functor(new COn_DrawTranslucentRenderablesFunctor(this, bInSkybox, bShadowDepth, afterCall)));
 
@@ -723,12 +584,12 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(m_EngineVersion == 7)
+			if(7 <= m_EngineVersion)
 			{
 				if (!m_EngineConnected) return;
 
-				if (!WriteInt32(m_hEnginePipe, EngineMessage_OnBeforeHud)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, EngineMessage_OnBeforeHud)) { errorLine = __LINE__; goto error; }
+				if (!FlushEngine()) { errorLine = __LINE__; goto error; }
 			}
 
 			QueueOrExecute(ctx->GetOrg(), new CAfxLeafExecute_Functor(new CBeforeHudFunctor(this)));
@@ -747,12 +608,12 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (m_EngineVersion == 7)
+			if (7 <= m_EngineVersion)
 			{
 				if (!m_EngineConnected) return;
 
-				if (!WriteInt32(m_hEnginePipe, EngineMessage_OnAfterHud)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_EngineStream, EngineMessage_OnAfterHud)) { errorLine = __LINE__; goto error; }
+				if (!FlushEngine()) { errorLine = __LINE__; goto error; }
 			}
 
 			QueueOrExecute(ctx->GetOrg(), new CAfxLeafExecute_Functor(new CAfterHudFunctor(this)));
@@ -777,7 +638,7 @@ namespace AfxInterop {
 
 			if (!m_DrawingConnected) return;
 
-			if (6 <= m_DrawingVersion && m_DrawingVersion <= 7)
+			if (6 <= m_DrawingVersion)
 			{
 				m_DrawingSkip = false;
 				return;
@@ -787,12 +648,12 @@ namespace AfxInterop {
 
 			while (true)
 			{
-				if (!WriteInt32(m_hDrawingPipe, DrawingMessage_PreapareDraw)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hDrawingPipe, frameCount)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hDrawingPipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, DrawingMessage_PreapareDraw)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, frameCount)) { errorLine = __LINE__; goto error; }
+				if (!Flush(m_DrawingStream)) { errorLine = __LINE__; goto error; }
 
 				INT32 prepareDrawReply;
-				if (!ReadInt32(m_hDrawingPipe, prepareDrawReply)) { errorLine = __LINE__; goto error; }
+				if (!ReadInt32(m_DrawingStream, prepareDrawReply)) { errorLine = __LINE__; goto error; }
 
 				switch (prepareDrawReply)
 				{
@@ -810,10 +671,10 @@ namespace AfxInterop {
 					bool colorDepthTextureWasLost;
 					HANDLE sharedColorDepthTextureHandle;
 
-					if (!ReadBoolean(m_hDrawingPipe, colorTextureWasLost)) { errorLine = __LINE__; goto error; }
-					if (!ReadHandle(m_hDrawingPipe, sharedColorTextureHandle)) { errorLine = __LINE__; goto error; }
-					if (!ReadBoolean(m_hDrawingPipe, colorDepthTextureWasLost)) { errorLine = __LINE__; goto error; }
-					if (!ReadHandle(m_hDrawingPipe, sharedColorDepthTextureHandle)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_DrawingStream, colorTextureWasLost)) { errorLine = __LINE__; goto error; }
+					if (!ReadHandle(m_DrawingStream, sharedColorTextureHandle)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_DrawingStream, colorDepthTextureWasLost)) { errorLine = __LINE__; goto error; }
+					if (!ReadHandle(m_DrawingStream, sharedColorDepthTextureHandle)) { errorLine = __LINE__; goto error; }
 
 					m_DrawingMainSurface = mainSurface;
 
@@ -925,7 +786,7 @@ namespace AfxInterop {
 				}
 
 
-				if (6 <= m_DrawingVersion && m_DrawingVersion <= 7)
+				if (6 <= m_DrawingVersion)
 				{
 					if(!HandleVersion6DrawingMessage(message, m_DrawingFrameCount)) { errorLine = __LINE__; goto error; }
 				}
@@ -933,13 +794,13 @@ namespace AfxInterop {
 				{
 					AfxD3D_WaitForGPU();
 
-					if (!WriteInt32(m_hDrawingPipe, message)) { errorLine = __LINE__; goto error; }
+					if (!WriteInt32(m_DrawingStream, message)) { errorLine = __LINE__; goto error; }
 
-					if (!Flush(m_hDrawingPipe)) { errorLine = __LINE__; goto error; }
+					if (!Flush(m_DrawingStream)) { errorLine = __LINE__; goto error; }
 
 					bool done;
 					do {
-						if (!ReadBoolean(m_hDrawingPipe, done)) { errorLine = __LINE__; goto error; }
+						if (!ReadBoolean(m_DrawingStream, done)) { errorLine = __LINE__; goto error; }
 					} while (!done);
 				}
 
@@ -960,7 +821,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (6 <= m_DrawingVersion && m_DrawingVersion <= 7)
+			if (6 <= m_DrawingVersion)
 			{
 				if (!HandleVersion6DrawingMessage(DrawingMessage_BeforeHud, m_DrawingFrameCount)) { errorLine = __LINE__; goto error; }
 			}
@@ -968,13 +829,13 @@ namespace AfxInterop {
 			{
 				AfxD3D_WaitForGPU();
 
-				if (!WriteInt32(m_hDrawingPipe, DrawingMessage_BeforeHud)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, DrawingMessage_BeforeHud)) { errorLine = __LINE__; goto error; }
 
-				if (!Flush(m_hDrawingPipe)) { errorLine = __LINE__; goto error; }
+				if (!Flush(m_DrawingStream)) { errorLine = __LINE__; goto error; }
 
 				bool done;
 				do {
-					if (!ReadBoolean(m_hDrawingPipe, done)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_DrawingStream, done)) { errorLine = __LINE__; goto error; }
 				} while (!done);
 			}
 
@@ -994,18 +855,18 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (6 <= m_DrawingVersion && m_DrawingVersion <= 7)
+			if (6 <= m_DrawingVersion)
 			{
 				if (!HandleVersion6DrawingMessage(DrawingMessage_AfterHud, m_DrawingFrameCount)) { errorLine = __LINE__; goto error; }
 			}
 			else
 			{
 				AfxD3D_WaitForGPU();
-				if (!WriteInt32(m_hDrawingPipe, DrawingMessage_AfterHud)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hDrawingPipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, DrawingMessage_AfterHud)) { errorLine = __LINE__; goto error; }
+				if (!Flush(m_DrawingStream)) { errorLine = __LINE__; goto error; }
 				bool done;
 				do {
-					if (!ReadBoolean(m_hDrawingPipe, done)) { errorLine = __LINE__; goto error; }
+					if (!ReadBoolean(m_DrawingStream, done)) { errorLine = __LINE__; goto error; }
 				} while (!done);
 			}
 
@@ -1025,13 +886,14 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (6 <= m_DrawingVersion && m_DrawingVersion <= 7)
+			if (6 <= m_DrawingVersion)
 			{
 				if (!HandleVersion6DrawingMessage(DrawingMessage_OnRenderViewEnd, m_DrawingFrameCount)) { errorLine = __LINE__; goto error; }
 			}
 			else
 			{
-				if (!WriteInt32(m_hDrawingPipe, DrawingMessage_OnRenderViewEnd)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, DrawingMessage_OnRenderViewEnd)) { errorLine = __LINE__; goto error; }
+				if (!m_DrawingStream.Send()) { errorLine = __LINE__; goto error; }
 			}
 
 			return;
@@ -1077,28 +939,45 @@ namespace AfxInterop {
 						std::string strPipeName("\\\\.\\pipe\\");
 						strPipeName.append(m_DrawingPipeName);
 
-						while (true)
+						if (m_DrawingSharedMemory)
 						{
-							m_hDrawingPipe = CreateFile(strPipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
-							if (m_hDrawingPipe != INVALID_HANDLE_VALUE)
-								break;
-
-							DWORD lastError = GetLastError();
-
-							if (lastError != ERROR_PIPE_BUSY)
+							if (!m_DrawingSharedMemoryTransport.Open(m_DrawingPipeName.c_str()))
 							{
-								Tier0_Warning("Could not open pipe. GLE=%d (%s)\n", lastError, strPipeName.c_str());
+								Tier0_Warning("Could not open shared memory (%s).\n", m_DrawingPipeName.c_str());
 								{ errorLine = __LINE__; goto error; }
 							}
 
-							if (!WaitNamedPipe(strPipeName.c_str(), 5000))
+							m_DrawingStream.SetTransport(&m_DrawingSharedMemoryTransport);
+
+							Tier0_Msg("Connected to shared memory \"%s\".\n", m_DrawingPipeName.c_str());
+						}
+						else
+						{
+							while (true)
 							{
-								Tier0_Warning("WaitNamedPipe: timed out (%s).\n", strPipeName.c_str());
-								{ errorLine = __LINE__; goto error; }
+								m_hDrawingPipe = CreateFile(strPipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+								if (m_hDrawingPipe != INVALID_HANDLE_VALUE)
+									break;
+
+								DWORD lastError = GetLastError();
+
+								if (lastError != ERROR_PIPE_BUSY)
+								{
+									Tier0_Warning("Could not open pipe. GLE=%d (%s)\n", lastError, strPipeName.c_str());
+									{ errorLine = __LINE__; goto error; }
+								}
+
+								if (!WaitNamedPipe(strPipeName.c_str(), 5000))
+								{
+									Tier0_Warning("WaitNamedPipe: timed out (%s).\n", strPipeName.c_str());
+									{ errorLine = __LINE__; goto error; }
+								}
 							}
-						}
 
-						Tier0_Msg("Connected to \"%s\".\n", strPipeName.c_str());
+							m_DrawingStream.SetTransport(&m_DrawingTransport);
+
+							Tier0_Msg("Connected to \"%s\".\n", strPipeName.c_str());
+						}
 						m_DrawingPreConnect = true;
 					}
 					else if (m_EngineConnected)
@@ -1132,6 +1011,10 @@ namespace AfxInterop {
 				m_hDrawingPipe = INVALID_HANDLE_VALUE;
 			}
 
+			m_DrawingSharedMemoryTransport.Close();
+
+			m_DrawingStream.Reset();
+
 			m_DrawingConnected = false;
 			m_DrawingPreConnect = false;
 
@@ -1175,61 +1058,96 @@ namespace AfxInterop {
 
 							m_DrawingPipeName = m_EnginePipeName;
 							m_DrawingPipeName.append("_drawing");
+							m_DrawingSharedMemory = m_EngineSharedMemory;
 
-							while (true)
+							if (m_EngineSharedMemory)
 							{
-								m_hEnginePipe = CreateFile(strPipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
-								if (m_hEnginePipe != INVALID_HANDLE_VALUE)
-									break;
-
-								DWORD lastError = GetLastError();
-
-								if (lastError != ERROR_PIPE_BUSY)
+								if (!m_EngineSharedMemoryTransport.Open(m_EnginePipeName.c_str()))
 								{
-									Tier0_Warning("Could not open pipe. GLE=%d (%s)\n", lastError, strPipeName.c_str());
+									Tier0_Warning("Could not open shared memory (%s).\n", m_EnginePipeName.c_str());
 									{ errorLine = __LINE__; goto error; }
 								}
 
-								if (!WaitNamedPipe(strPipeName.c_str(), 5000))
+								Tier0_Msg("Connected to shared memory \"%s\".\n", m_EnginePipeName.c_str());
+							}
+							else
+							{
+								while (true)
 								{
-									Tier0_Warning("WaitNamedPipe: timed out (%s).\n", strPipeName.c_str());
-									{ errorLine = __LINE__; goto error; }
+									m_hEnginePipe = CreateFile(strPipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+									if (m_hEnginePipe != INVALID_HANDLE_VALUE)
+										break;
+
+									DWORD lastError = GetLastError();
+
+									if (lastError != ERROR_PIPE_BUSY)
+									{
+										Tier0_Warning("Could not open pipe. GLE=%d (%s)\n", lastError, strPipeName.c_str());
+										{ errorLine = __LINE__; goto error; }
+									}
+
+									if (!WaitNamedPipe(strPipeName.c_str(), 5000))
+									{
+										Tier0_Warning("WaitNamedPipe: timed out (%s).\n", strPipeName.c_str());
+										{ errorLine = __LINE__; goto error; }
+									}
 								}
+
+								Tier0_Msg("Connected to \"%s\".\n", strPipeName.c_str());
 							}
 
-							Tier0_Msg("Connected to \"%s\".\n", strPipeName.c_str());
+							IAfxInteropTransport * engineTransport = m_EngineSharedMemory ? (IAfxInteropTransport *)&m_EngineSharedMemoryTransport : &m_EngineTransport;
+
+							if (!m_EngineRecordFileName.empty())
+							{
+								std::wstring wideFileName;
+
+								if (UTF8StringToWideString(m_EngineRecordFileName.c_str(), wideFileName) && m_EngineRecorder.Open(wideFileName.c_str(), engineTransport))
+								{
+									engineTransport = &m_EngineRecorder;
+
+									Tier0_Msg("Recording to \"%s\".\n", m_EngineRecordFileName.c_str());
+								}
+								else
+									Tier0_Warning("Could not record to \"%s\".\n", m_EngineRecordFileName.c_str());
+							}
+
+							m_EngineStream.SetTransport(engineTransport);
 
 							m_EnginePreConnect = true;
 							m_DrawingWantsConnect = true;
 						}
 						else if(m_DrawingPreConnect) // do not do furhter stuff until drawing thread is preconnected (to maintain backwards compat)
 						{
-							if (!ReadInt32(m_hEnginePipe, m_EngineVersion)) { errorLine = __LINE__; goto error; }
+							if (!ReadInt32(m_EngineStream, m_EngineVersion)) { errorLine = __LINE__; goto error; }
 
 							switch (m_EngineVersion)
 							{
 							case 5:
 							case 6:
 							case 7:
+							case 8:
 								break;
 							default:
 								Tier0_Warning("Version %d is not supported.\n", m_EngineVersion);
-								if (!WriteBoolean(m_hEnginePipe, false)) { errorLine = __LINE__; goto error; }
-								if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+								if (!WriteBoolean(m_EngineStream, false)) { errorLine = __LINE__; goto error; }
+								if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 								{ errorLine = __LINE__; goto error; }
 							}
 
-							if (!WriteBoolean(m_hEnginePipe, true)) { errorLine = __LINE__; goto error; }
+							if (!WriteBoolean(m_EngineStream, true)) { errorLine = __LINE__; goto error; }
 
-							if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+							if (!Flush(m_EngineStream)) { errorLine = __LINE__; goto error; }
 
-							if (!ReadBoolean(m_hEnginePipe, m_EngineServer64Bit)) { errorLine = __LINE__; goto error; }
+							if (!ReadBoolean(m_EngineStream, m_EngineServer64Bit)) { errorLine = __LINE__; goto error; }
 
 							if (7 <= m_EngineVersion)
 							{
 								if(!ReadGameEventSettings(false)) { errorLine = __LINE__; goto error; }
 							}
 
+							ResetPipeline();
+
 							m_DrawingVersion = m_EngineVersion;
 							m_EngineConnected = true;
 							return true;
@@ -1258,6 +1176,15 @@ namespace AfxInterop {
 				m_hEnginePipe = INVALID_HANDLE_VALUE;
 			}
 
+			m_EngineSharedMemoryTransport.Close();
+
+			if (m_EngineRecorder.IsOpen() && !m_EngineRecorder.Close())
+			{
+				Tier0_Warning("AfxInterop::Disconnect: Could not write \"%s\".\n", m_EngineRecordFileName.c_str());
+			}
+
+			m_EngineStream.Reset();
+
 			m_EngineConnected = false;
 			m_EnginePreConnect = false;
 			m_DrawingWantsConnect = false;
@@ -1291,6 +1218,50 @@ namespace AfxInterop {
 					);
 					return true;
 				}
+				else if (0 == _stricmp("transport", arg1))
+				{
+					if (3 <= argc)
+					{
+						const char* arg2 = args->ArgV(2);
+
+						if (0 == _stricmp("pipe", arg2))
+						{
+							m_EngineSharedMemory = false;
+							return true;
+						}
+						else if (0 == _stricmp("sharedMemory", arg2))
+						{
+							m_EngineSharedMemory = true;
+							return true;
+						}
+					}
+
+					Tier0_Msg(
+						"afx_interop transport pipe|sharedMemory - Use named pipes (default) or shared memory (named like the pipes), takes effect on next connect.\n"
+						"Current value: %s\n"
+						, m_EngineSharedMemory ? "sharedMemory" : "pipe"
+					);
+					return true;
+				}
+				else if (0 == _stricmp("record", arg1))
+				{
+					if (3 <= argc)
+					{
+						const char* arg2 = args->ArgV(2);
+
+						m_EngineRecordFileName = arg2;
+
+						return true;
+					}
+
+					Tier0_Msg(
+						"afx_interop record <sFileName> - Record the engine connection's data into a file (\"\" = don't record, default), takes effect on next connect.\n"
+						"The recordings can be inspected and replayed with afx-interop-replay (InteropTools).\n"
+						"Current value: \"%s\"\n"
+						, m_EngineRecordFileName.c_str()
+					);
+					return true;
+				}
 				else if (0 == _stricmp("connect", arg1))
 				{
 					if (3 <= argc)
@@ -1315,6 +1286,22 @@ namespace AfxInterop {
 
 					AddCommand(&subArgs);
 
+					return true;
+				}
+				else if (0 == _stricmp("stats", arg1))
+				{
+					if (3 <= argc && 0 == _stricmp("reset", args->ArgV(2)))
+					{
+						m_EngineStream.ResetStats();
+						m_DrawingStream.ResetStats();
+
+						return true;
+					}
+
+					PrintStreamStats("engine", m_EngineStream.GetStats());
+					PrintStreamStats("drawing", m_DrawingStream.GetStats());
+					Tier0_Msg("%s stats reset - Reset the statistics.\n", args->ArgV(0));
+
 					return true;
 				}
 			}
@@ -1322,13 +1309,27 @@ namespace AfxInterop {
 			const char* arg0 = args->ArgV(0);
 
 			Tier0_Msg("%s pipeName [...] - Name of the pipe to connect to.\n", arg0);
+			Tier0_Msg("%s transport [...] - Named pipes or shared memory.\n", arg0);
+			Tier0_Msg("%s record [...] - Record the engine connection (for replaying it without the game).\n", arg0);
 			Tier0_Msg("%s connect [...] - Controls if interop connection is enabled.\n", arg0);
 			Tier0_Msg("%s send [<arg1>[ <arg2> [ ...]] - Queues a command to be sent to the server (lossy if connection is unstable).\n", arg0);
+			Tier0_Msg("%s stats [...] - Transport statistics (calls to read / write / flush and time spent in them).\n", arg0);
 
 			return false;
 		}
 
 	protected:
+		static void PrintStreamStats(const char * name, const AfxInteropStreamStats & stats)
+		{
+			Tier0_Msg(
+				"%s: %llu reads (%llu bytes, %llu us), %llu writes (%llu bytes, %llu us), %llu flushes (%llu us)\n"
+				, name
+				, stats.Reads, stats.BytesRead, stats.ReadMicroseconds
+				, stats.Writes, stats.BytesWritten, stats.WriteMicroseconds
+				, stats.Flushes, stats.FlushMicroseconds
+			);
+		}
+
 		~CInteropClient()
 		{
 			Shutdown();
@@ -1341,7 +1342,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 			
-			if (!WriteInt32(m_hEnginePipe, EngineMessage_OnGameEvent)) { errorLine = __LINE__; goto error; }
+			if (!WriteInt32(m_EngineStream, EngineMessage_OnGameEvent)) { errorLine = __LINE__; goto error; }
 
 			return true;
 
@@ -1358,7 +1359,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if (!Flush(m_hEnginePipe)) { errorLine = __LINE__; goto error; }
+			if (!FlushEngine()) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1375,7 +1376,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteCString(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteCString(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1392,7 +1393,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteSingle(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteSingle(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1409,7 +1410,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteInt32(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteInt32(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1426,7 +1427,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteInt16(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteInt16(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1443,7 +1444,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteByte(m_hEnginePipe, (BYTE)value)) { errorLine = __LINE__; goto error; }
+			if(!WriteByte(m_EngineStream, (BYTE)value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1460,7 +1461,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteBoolean(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteBoolean(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1477,7 +1478,7 @@ namespace AfxInterop {
 
 			int errorLine = 0;
 
-			if(!WriteUInt64(m_hEnginePipe, value)) { errorLine = __LINE__; goto error; }
+			if(!WriteUInt64(m_EngineStream, value)) { errorLine = __LINE__; goto error; }
 
 			return;
 
@@ -1490,80 +1491,6 @@ namespace AfxInterop {
 	private:
 		std::atomic_int m_RefCount;
 
-		struct HandleCalcResult
-		{
-			INT32 IntHandle;
-
-			HandleCalcResult(INT32 intHandle)
-				: IntHandle(intHandle)
-			{
-			}
-		};
-
-		struct VecAngCalcResult
-		{
-			FLOAT X;
-			FLOAT Y;
-			FLOAT Z;
-			FLOAT Pitch;
-			FLOAT Yaw;
-			FLOAT Roll;
-
-			VecAngCalcResult(FLOAT x, FLOAT y, FLOAT z, FLOAT pitch, FLOAT yaw, FLOAT roll)
-				: X(x), Y(y), Z(z), Pitch(pitch), Yaw(yaw), Roll(roll)
-			{
-
-			}
-		};
-
-		struct CamCalcResult
-		{
-			FLOAT X;
-			FLOAT Y;
-			FLOAT Z;
-			FLOAT Pitch;
-			FLOAT Yaw;
-			FLOAT Roll;
-			FLOAT Fov;
-
-			CamCalcResult(FLOAT x, FLOAT y, FLOAT z, FLOAT pitch, FLOAT yaw, FLOAT roll, FLOAT fov)
-				: X(x), Y(y), Z(z), Pitch(pitch), Yaw(yaw), Roll(roll), Fov(fov)
-			{
-
-			}
-
-		};
-
-		struct FovCalcResult
-		{
-			FLOAT Fov;
-
-			FovCalcResult(FLOAT fov)
-				: Fov(fov)
-			{
-			}
-		};
-
-		struct BoolCalcResult
-		{
-			BOOL Result;
-
-			BoolCalcResult(BOOL result)
-				: Result(result)
-			{
-			}
-		};
-
-		struct IntCalcResult
-		{
-			INT32 Result;
-
-			IntCalcResult(INT32 result)
-				: Result(result)
-			{
-			}
-		};
-
 		enum DrawingMessage
 		{
 			DrawingMessage_Invalid = 0,
@@ -1719,6 +1646,10 @@ namespace AfxInterop {
 		bool m_DrawingConnected = false;
 
 		HANDLE m_hDrawingPipe = INVALID_HANDLE_VALUE;
+		CNamedPipeTransport m_DrawingTransport;
+		bool m_DrawingSharedMemory = false;
+		CAfxInteropSharedMemoryTransport m_DrawingSharedMemoryTransport;
+		CAfxInteropStream m_DrawingStream;
 
 		bool m_DrawingSkip = true;
 		int m_DrawingFrameCount = -1;
@@ -1739,12 +1670,12 @@ namespace AfxInterop {
 
 			while (true)
 			{
-				if (!WriteInt32(m_hDrawingPipe, message)) { errorLine = __LINE__; goto error; }
-				if (!WriteInt32(m_hDrawingPipe, frameCount)) { errorLine = __LINE__; goto error; }
-				if (!Flush(m_hDrawingPipe)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, message)) { errorLine = __LINE__; goto error; }
+				if (!WriteInt32(m_DrawingStream, frameCount)) { errorLine = __LINE__; goto error; }
+				if (!Flush(m_DrawingStream)) { errorLine = __LINE__; goto error; }
 
 				INT32 prepareDrawReply;
-				if (!ReadInt32(m_hDrawingPipe, prepareDrawReply)) { errorLine = __LINE__; goto error; }
+				if (!ReadInt32(m_DrawingStream, prepareDrawReply)) { errorLine = __LINE__; goto error; }
 
 				switch (prepareDrawReply)
 				{
@@ -1760,10 +1691,10 @@ namespace AfxInterop {
 					UINT32 texHeight;
 					UINT32 d3dFormat;
 
-					if (!ReadHandle(m_hDrawingPipe, sharedTextureHandle)) { errorLine = __LINE__; goto error; }
-					if (!ReadUInt32(m_hDrawingPipe, texWidth)) { errorLine = __LINE__; goto error; }
-					if (!ReadUInt32(m_hDrawingPipe, texHeight)) { errorLine = __LINE__; goto error; }
-					if (!ReadUInt32(m_hDrawingPipe, d3dFormat)) { errorLine = __LINE__; goto error; }
+					if (!ReadHandle(m_DrawingStream, sharedTextureHandle)) { errorLine = __LINE__; goto error; }
+					if (!ReadUInt32(m_DrawingStream, texWidth)) { errorLine = __LINE__; goto error; }
+					if (!ReadUInt32(m_DrawingStream, texHeight)) { errorLine = __LINE__; goto error; }
+					if (!ReadUInt32(m_DrawingStream, d3dFormat)) { errorLine = __LINE__; goto error; }
 
 					if (m_SharedSurface.Handle && m_SharedSurface.Handle != sharedTextureHandle)
 					{
@@ -1795,7 +1726,8 @@ namespace AfxInterop {
 						AfxD3D_WaitForGPU(); // TODO: Improve. We are slowing down more than we have to.
 					}
 					
-					if (!WriteBoolean(m_hDrawingPipe, true)) { errorLine = __LINE__; goto error; }
+					if (!WriteBoolean(m_DrawingStream, true)) { errorLine = __LINE__; goto error; }
+					if (!m_DrawingStream.Send()) { errorLine = __LINE__; goto error; }
 
 					return true;
 				}
@@ -1810,25 +1742,6 @@ namespace AfxInterop {
 			return false;
 		}
 
-		enum EngineMessage {
-			EngineMessage_Invalid = 0,
-			EngineMessage_LevelInitPreEntity = 1,
-			EngineMessage_LevelShutDown = 2,
-			EngineMessage_BeforeFrameStart = 3,
-			EngineMessage_OnRenderView = 4,
-			EngineMessage_OnRenderViewEnd = 5,
-			EngineMessage_BeforeFrameRenderStart = 6,
-			EngineMessage_AfterFrameRenderStart = 7,
-			EngineMessage_OnViewOverride = 8,
-			EngineMessage_BeforeTranslucentShadow = 9,
-			EngineMessage_AfterTranslucentShadow = 10,
-			EngineMessage_BeforeTranslucent = 11,
-			EngineMessage_AfterTranslucent = 12,
-			EngineMessage_OnBeforeHud = 13,
-			EngineMessage_OnAfterHud = 14,
-			EngineMessage_OnGameEvent = 15
-		};
-
 		class CConsole
 		{
 		public:
@@ -1872,6 +1785,12 @@ namespace AfxInterop {
 		bool m_EngineConnected = false;
 
 		HANDLE m_hEnginePipe = INVALID_HANDLE_VALUE;
+		CNamedPipeTransport m_EngineTransport;
+		bool m_EngineSharedMemory = false;
+		CAfxInteropSharedMemoryTransport m_EngineSharedMemoryTransport;
+		std::string m_EngineRecordFileName;
+		CAfxInteropRecorder m_EngineRecorder;
+		CAfxInteropStream m_EngineStream;
 
 		std::string m_EnginePipeName;
 
@@ -1882,15 +1801,15 @@ namespace AfxInterop {
 		int m_EngineVersion = 5;
 		int m_DrawingVersion = 5;
 
-		bool ConsoleSend(HANDLE hPipe, CConsole & command)
+		bool ConsoleSend(CAfxInteropStream & stream, CConsole & command)
 		{
-			if (!WriteCompressedUInt32(hPipe, (UINT32)command.GetArgCount())) return false;
+			if (!WriteCompressedUInt32(stream, (UINT32)command.GetArgCount())) return false;
 
 			bool okay = true;
 
 			while (command.HasArg())
 			{
-				okay = okay && WriteStringUTF8(hPipe, command.GetArgFront());
+				okay = okay && WriteStringUTF8(stream, command.GetArgFront());
 				command.PopArgFront();
 			}
 
@@ -1903,77 +1822,57 @@ namespace AfxInterop {
 			m_Commands.emplace(args);
 		}
 
-		bool SendCommands(HANDLE hPipe)
+		bool SendCommands(CAfxInteropStream & stream)
 		{
-			if (!WriteCompressedUInt32(hPipe, (UINT32)m_Commands.size())) return false;
+			if (!WriteCompressedUInt32(stream, (UINT32)m_Commands.size())) return false;
 
 			bool okay = true;
 
 			while (!m_Commands.empty())
 			{
-				okay = okay && ConsoleSend(hPipe, m_Commands.front());
+				okay = okay && ConsoleSend(stream, m_Commands.front());
 				m_Commands.pop();
 			}
 
 			return okay;
 		}
 
-		bool ReadBytes(HANDLE hFile, LPVOID lpBuffer, int offset, DWORD numBytes)
+		bool ReadBytes(CAfxInteropStream & stream, LPVOID lpBuffer, int offset, DWORD numBytes)
 		{
-			lpBuffer = &(((char*)lpBuffer)[offset]);
-			BOOL success = false;
-
-			do
-			{
-				DWORD bytesRead;
-
-				success = ReadFile(hFile, lpBuffer, numBytes, &bytesRead, NULL);
-
-				if (!success)
-				{
-					Tier0_Warning("!ReadBytes: GetLastError=%d\n", GetLastError());
-					return false;
-				}
-
-				numBytes -= bytesRead;
-				lpBuffer = &(((char*)lpBuffer)[bytesRead]);
-
-			} while (0 < numBytes);
-
-			return true;
+			return stream.Read(&(((char*)lpBuffer)[offset]), numBytes);
 		}
 
-		bool ReadBoolean(HANDLE hFile, bool& outValue)
+		bool ReadBoolean(CAfxInteropStream & stream, bool& outValue)
 		{
 			BYTE useVal;
 
-			bool result = ReadBytes(hFile, &useVal, 0, sizeof(useVal));
+			bool result = ReadBytes(stream, &useVal, 0, sizeof(useVal));
 
 			if (result) outValue = 0 != useVal ? true : false;
 
 			return result;
 		}
 
-		bool ReadByte(HANDLE hFile, BYTE& outValue)
+		bool ReadByte(CAfxInteropStream & stream, BYTE& outValue)
 		{
-			return ReadBytes(hFile, &outValue, 0, sizeof(outValue));
+			return ReadBytes(stream, &outValue, 0, sizeof(outValue));
 		}
 
-		bool ReadSByte(HANDLE hFile, signed char& value)
+		bool ReadSByte(CAfxInteropStream & stream, signed char& value)
 		{
-			return ReadByte(hFile, (BYTE&)value);
+			return ReadByte(stream, (BYTE&)value);
 		}
 
-		bool ReadUInt32(HANDLE hFile, UINT32& outValue)
+		bool ReadUInt32(CAfxInteropStream & stream, UINT32& outValue)
 		{
-			return ReadBytes(hFile, &outValue, 0, sizeof(outValue));
+			return ReadBytes(stream, &outValue, 0, sizeof(outValue));
 		}
 
-		bool ReadCompressedUInt32(HANDLE hFile, UINT32& outValue)
+		bool ReadCompressedUInt32(CAfxInteropStream & stream, UINT32& outValue)
 		{
 			BYTE value;
 
-			if (!ReadByte(hFile, value))
+			if (!ReadByte(stream, value))
 				return false;
 
 			if (value < 255)
@@ -1982,19 +1881,19 @@ namespace AfxInterop {
 				return true;
 			}
 
-			return ReadUInt32(hFile, outValue);
+			return ReadUInt32(stream, outValue);
 		}
 
-		bool ReadInt32(HANDLE hFile, INT32& outValue)
+		bool ReadInt32(CAfxInteropStream & stream, INT32& outValue)
 		{
-			return ReadBytes(hFile, &outValue, 0, sizeof(outValue));
+			return ReadBytes(stream, &outValue, 0, sizeof(outValue));
 		}
 
-		bool ReadCompressedInt32(HANDLE hFile, INT32& outValue)
+		bool ReadCompressedInt32(CAfxInteropStream & stream, INT32& outValue)
 		{
 			signed char value;
 
-			if (!ReadSByte(hFile, value))
+			if (!ReadSByte(stream, value))
 				return false;
 
 			if (value < 127)
@@ -2003,14 +1902,14 @@ namespace AfxInterop {
 				return true;
 			}
 
-			return ReadInt32(hFile, outValue);
+			return ReadInt32(stream, outValue);
 		}
 
-		bool ReadHandle(HANDLE hFile, HANDLE& outValue)
+		bool ReadHandle(CAfxInteropStream & stream, HANDLE& outValue)
 		{
 			DWORD value32;
 
-			if (ReadBytes(hFile, &value32, 0, sizeof(value32)))
+			if (ReadBytes(stream, &value32, 0, sizeof(value32)))
 			{
 				outValue = ULongToHandle(value32);
 				return true;
@@ -2019,125 +1918,415 @@ namespace AfxInterop {
 			return false;
 		}
 
-		bool ReadSingle(HANDLE hFile, FLOAT& outValue)
+		bool ReadSingle(CAfxInteropStream & stream, FLOAT& outValue)
 		{
-			return ReadBytes(hFile, &outValue, 0, sizeof(outValue));
+			return ReadBytes(stream, &outValue, 0, sizeof(outValue));
 		}
 
-		bool ReadStringUTF8(HANDLE hFile, std::string& outValue)
+		bool ReadStringUTF8(CAfxInteropStream & stream, std::string& outValue)
 		{
 			UINT32 length;
 
-			if (!ReadCompressedUInt32(hFile, length)) return false;
+			if (!ReadCompressedUInt32(stream, length)) return false;
 
 			outValue.resize(length);
 
-			if (!ReadBytes(hFile, &outValue[0], 0, length)) return false;
+			if (!ReadBytes(stream, &outValue[0], 0, length)) return false;
 
 			return true;
 		}
 
-		bool WriteBytes(HANDLE hFile, LPVOID lpBuffer, int offset, DWORD numBytes)
+		bool WriteBytes(CAfxInteropStream & stream, LPVOID lpBuffer, int offset, DWORD numBytes)
 		{
-			DWORD bytesWritten;
-
-			if (!WriteFile(hFile, &(((char*)lpBuffer)[offset]), numBytes, &bytesWritten, NULL) || numBytes != bytesWritten)
-				return false;
-
-			return true;
+			return stream.Write(&(((char*)lpBuffer)[offset]), numBytes);
 		}
 
-		bool WriteBoolean(HANDLE hFile, bool value) {
+		bool WriteBoolean(CAfxInteropStream & stream, bool value) {
 
 			BYTE useVal = value ? 1 : 0;
 
-			return WriteBytes(hFile, &useVal, 0, sizeof(useVal));
+			return WriteBytes(stream, &useVal, 0, sizeof(useVal));
 		}
 
-		bool WriteByte(HANDLE hFile, BYTE value) {
+		bool WriteByte(CAfxInteropStream & stream, BYTE value) {
 
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteSByte(HANDLE hFile, signed char value)
+		bool WriteSByte(CAfxInteropStream & stream, signed char value)
 		{
-			return WriteByte(hFile, (BYTE)value);
+			return WriteByte(stream, (BYTE)value);
 		}
 
-		bool WriteInt16(HANDLE hFile, INT16 value) {
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+		bool WriteInt16(CAfxInteropStream & stream, INT16 value) {
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteUInt32(HANDLE hFile, UINT32 value) {
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+		bool WriteUInt32(CAfxInteropStream & stream, UINT32 value) {
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteCompressedUInt32(HANDLE hFile, UINT32 value)
+		bool WriteCompressedUInt32(CAfxInteropStream & stream, UINT32 value)
 		{
 			if (0 <= value && value <= 255 - 1)
-				return WriteByte(hFile, (BYTE)value);
+				return WriteByte(stream, (BYTE)value);
 
-			return WriteByte(hFile, 255) && WriteUInt32(hFile, value);
+			return WriteByte(stream, 255) && WriteUInt32(stream, value);
 		}
 
-		bool WriteInt32(HANDLE hFile, INT32 value) {
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+		bool WriteInt32(CAfxInteropStream & stream, INT32 value) {
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteCompressedInt32(HANDLE hFile, INT32 value)
+		bool WriteCompressedInt32(CAfxInteropStream & stream, INT32 value)
 		{
 			if (-128 <= value && value <= 127 - 1)
-				return WriteSByte(hFile, (signed char)value);
+				return WriteSByte(stream, (signed char)value);
 
-			return WriteSByte(hFile, 127)
-				&& WriteUInt32(hFile, value);
+			return WriteSByte(stream, 127)
+				&& WriteUInt32(stream, value);
 		}
 
-		bool WriteUInt64(HANDLE hFile, uint64_t value) {
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+		bool WriteUInt64(CAfxInteropStream & stream, uint64_t value) {
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteSingle(HANDLE hFile, FLOAT value)
+		bool WriteSingle(CAfxInteropStream & stream, FLOAT value)
 		{
-			return WriteBytes(hFile, &value, 0, sizeof(value));
+			return WriteBytes(stream, &value, 0, sizeof(value));
 		}
 
-		bool WriteCString(HANDLE hFile, const char* value)
+		bool WriteCString(CAfxInteropStream & stream, const char* value)
 		{
 			UINT32 length = (UINT32)(strlen(value));
 
-			return WriteCompressedUInt32(hFile, length)
-				&& WriteBytes(hFile, (LPVOID)value, 0, length);
+			return WriteCompressedUInt32(stream, length)
+				&& WriteBytes(stream, (LPVOID)value, 0, length);
 		}
 
-		bool WriteStringUTF8(HANDLE hFile, const std::string value)
+		bool WriteStringUTF8(CAfxInteropStream & stream, const std::string value)
 		{
 			UINT32 length = (UINT32)value.length();
 
-			return WriteCompressedUInt32(hFile, length)
-				&& WriteBytes(hFile, (LPVOID)value.c_str(), 0, length);
+			return WriteCompressedUInt32(stream, length)
+				&& WriteBytes(stream, (LPVOID)value.c_str(), 0, length);
 		}
 
-		bool WriteHandle(HANDLE hFile, HANDLE value)
+		bool WriteHandle(CAfxInteropStream & stream, HANDLE value)
 		{
 			DWORD value32 = HandleToULong(value);
 
-			return WriteBytes(hFile, &value32, 0, sizeof(value32));
+			return WriteBytes(stream, &value32, 0, sizeof(value32));
 		}
 
-		bool Flush(HANDLE hFile)
+		/// <remarks>Hands what was written to the pipe, the reads only do that if they have to wait for the server.</remarks>
+		bool Flush(CAfxInteropStream & stream)
 		{
-			if (!FlushFileBuffers(hFile))
-				return false;
+			return stream.Flush();
+		}
+
+		/// <summary>Names of the calcs the client wants the results of.</summary>
+		struct CalcNames
+		{
+			std::vector<std::string> Handle;
+			std::vector<std::string> VecAng;
+			std::vector<std::string> Cam;
+			std::vector<std::string> Fov;
+			std::vector<std::string> Bool;
+			std::vector<std::string> Int;
+		};
+
+		bool ReadCalcNames(std::vector<std::string>& outNames)
+		{
+			UINT32 numCalcs;
+
+			if (!ReadCompressedUInt32(m_EngineStream, numCalcs)) return false;
+
+			outNames.resize(numCalcs);
+
+			for (UINT32 i = 0; i < numCalcs; ++i)
+			{
+				if (!ReadStringUTF8(m_EngineStream, outNames[i])) return false;
+			}
+
+			return true;
+		}
+
+		bool ReadCalcNames(CalcNames& outCalcs)
+		{
+			return ReadCalcNames(outCalcs.Handle)
+				&& ReadCalcNames(outCalcs.VecAng)
+				&& ReadCalcNames(outCalcs.Cam)
+				&& ReadCalcNames(outCalcs.Fov)
+				&& ReadCalcNames(outCalcs.Bool)
+				&& ReadCalcNames(outCalcs.Int);
+		}
+
+		/// <summary>Computes the calcs and writes their results.</summary>
+		/// <param name="withCounts">Write the number of results before each kind (version 8), otherwise the client knows it from its request.</param>
+		bool WriteCalcResults(const CalcNames& calcs, bool withCounts)
+		{
+			// Handle calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.Handle.size())) return false;
+
+			for (auto it = calcs.Handle.begin(); it != calcs.Handle.end(); ++it)
+			{
+				IMirvHandleCalc* calc = g_MirvHandleCalcs.GetByName(it->c_str());
+				SOURCESDK::CSGO::CBaseHandle handle;
+
+				if (calc && calc->CalcHandle(handle))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteInt32(m_EngineStream, handle.ToInt())) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
+
+			// Vec ang calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.VecAng.size())) return false;
+
+			for (auto it = calcs.VecAng.begin(); it != calcs.VecAng.end(); ++it)
+			{
+				IMirvVecAngCalc* calc = g_MirvVecAngCalcs.GetByName(it->c_str());
+				SOURCESDK::Vector vector;
+				SOURCESDK::QAngle qangle;
+
+				if (calc && calc->CalcVecAng(vector, qangle))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteSingle(m_EngineStream, vector.x)) return false;
+					if (!WriteSingle(m_EngineStream, vector.y)) return false;
+					if (!WriteSingle(m_EngineStream, vector.z)) return false;
+
+					if (!WriteSingle(m_EngineStream, qangle.x)) return false;
+					if (!WriteSingle(m_EngineStream, qangle.y)) return false;
+					if (!WriteSingle(m_EngineStream, qangle.z)) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
+
+			// Cam calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.Cam.size())) return false;
+
+			for (auto it = calcs.Cam.begin(); it != calcs.Cam.end(); ++it)
+			{
+				IMirvCamCalc* calc = g_MirvCamCalcs.GetByName(it->c_str());
+				SOURCESDK::Vector vector;
+				SOURCESDK::QAngle qangle;
+				float fov;
+
+				if (calc && calc->CalcCam(vector, qangle, fov))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteSingle(m_EngineStream, vector.x)) return false;
+					if (!WriteSingle(m_EngineStream, vector.y)) return false;
+					if (!WriteSingle(m_EngineStream, vector.z)) return false;
+
+					if (!WriteSingle(m_EngineStream, qangle.x)) return false;
+					if (!WriteSingle(m_EngineStream, qangle.y)) return false;
+					if (!WriteSingle(m_EngineStream, qangle.z)) return false;
+
+					if (!WriteSingle(m_EngineStream, fov)) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
+
+			// Fov calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.Fov.size())) return false;
+
+			for (auto it = calcs.Fov.begin(); it != calcs.Fov.end(); ++it)
+			{
+				IMirvFovCalc* calc = g_MirvFovCalcs.GetByName(it->c_str());
+				float fov;
+
+				if (calc && calc->CalcFov(fov))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteSingle(m_EngineStream, fov)) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
+
+			// Bool calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.Bool.size())) return false;
+
+			for (auto it = calcs.Bool.begin(); it != calcs.Bool.end(); ++it)
+			{
+				IMirvBoolCalc* calc = g_MirvBoolCalcs.GetByName(it->c_str());
+				bool result;
+
+				if (calc && calc->CalcBool(result))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteBoolean(m_EngineStream, result)) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
+
+			// Int calcs:
+
+			if (withCounts && !WriteCompressedUInt32(m_EngineStream, (UINT32)calcs.Int.size())) return false;
+
+			for (auto it = calcs.Int.begin(); it != calcs.Int.end(); ++it)
+			{
+				IMirvIntCalc* calc = g_MirvIntCalcs.GetByName(it->c_str());
+				int result;
+
+				if (calc && calc->CalcInt(result))
+				{
+					if (!WriteBoolean(m_EngineStream, true)) return false;
+
+					if (!WriteInt32(m_EngineStream, result)) return false;
+				}
+				else if (!WriteBoolean(m_EngineStream, false)) return false;
+			}
 
 			return true;
 		}
 
+		//
+		// Version 8 (pipelined):
+
+		CalcNames m_PipelineCalcs;
+		bool m_PipelineWait = false;
+		int m_PipelineSentFrame = -1;
+		int m_PipelineRepliedFrame = -1;
+		UINT32 m_PipelineReplySize = 0;
+		bool m_PipelineOverrideView = false;
+		FLOAT m_PipelineView[7];
+		EnabledFeatures_t m_PipelineFeatures;
+
+		void ResetPipeline()
+		{
+			m_PipelineCalcs = CalcNames();
+			m_PipelineWait = false;
+			m_PipelineSentFrame = -1;
+			m_PipelineRepliedFrame = -1;
+			m_PipelineReplySize = 0;
+			m_PipelineOverrideView = false;
+			m_PipelineFeatures.Clear();
+		}
+
+		/// <summary>Applies the replies of the client that have arrived completely.</summary>
+		/// <remarks>Only blocks if the client asked to wait for its reply to the last frame.</remarks>
+		bool ReadReplies()
+		{
+			while (true)
+			{
+				bool wait = m_PipelineWait && m_PipelineRepliedFrame < m_PipelineSentFrame;
+				size_t readable;
+
+				if (!m_EngineStream.GetReadable(readable)) return false;
+
+				if (0 == m_PipelineReplySize)
+				{
+					if (!wait && readable < sizeof(UINT32)) return true;
+
+					if (!ReadUInt32(m_EngineStream, m_PipelineReplySize)) return false;
+
+					continue;
+				}
+
+				if (!wait && readable < m_PipelineReplySize) return true;
+
+				UINT32 replySize = m_PipelineReplySize;
+				unsigned long long replyStart = m_EngineStream.GetReadPosition();
+
+				m_PipelineReplySize = 0;
+
+				if (!ReadReply()) return false;
+
+				unsigned long long replyRead = m_EngineStream.GetReadPosition() - replyStart;
+
+				if (replySize < replyRead)
+				{
+					Tier0_Warning("AfxInterop::ReadReplies: Read %llu bytes of a reply of %u bytes, client version mismatch?\n", replyRead, replySize);
+					return false;
+				}
+
+				// Skip what a newer client might have added:
+				if (replyRead < replySize && !m_EngineStream.Skip((size_t)(replySize - replyRead))) return false;
+			}
+		}
+
+		bool ReadReply()
+		{
+			INT32 frame;
+
+			if (!ReadInt32(m_EngineStream, frame)) return false;
+
+			if (!ReadBoolean(m_EngineStream, m_PipelineWait)) return false;
+
+			UINT32 commandCount;
+
+			if (!ReadCompressedUInt32(m_EngineStream, commandCount)) return false;
+
+			for (UINT32 i = 0; i < commandCount; ++i)
+			{
+				std::string command;
+
+				if (!ReadStringUTF8(m_EngineStream, command)) return false;
+
+				g_VEngineClient->ExecuteClientCmd(command.c_str());
+			}
+
+			bool hasValue;
+
+			if (!ReadBoolean(m_EngineStream, hasValue)) return false;
+
+			if (hasValue && !ReadGameEventSettings(true)) return false;
+
+			if (!ReadBoolean(m_EngineStream, hasValue)) return false;
+
+			if (hasValue && !ReadCalcNames(m_PipelineCalcs)) return false;
+
+			if (!ReadBoolean(m_EngineStream, m_PipelineOverrideView)) return false;
+
+			if (m_PipelineOverrideView)
+			{
+				for (int i = 0; i < 7; ++i)
+				{
+					if (!ReadSingle(m_EngineStream, m_PipelineView[i])) return false;
+				}
+			}
+
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.BeforeTranslucentShadow)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.AfterTranslucentShadow)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.BeforeTranslucent)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.AfterTranslucent)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.BeforeHud)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.AfterHud)) return false;
+			if (!ReadBoolean(m_EngineStream, m_PipelineFeatures.AfterRenderView)) return false;
+
+			m_PipelineRepliedFrame = frame;
+
+			return true;
+		}
+
+		/// <summary>Flush for messages the client doesn't answer, in version 8 it doesn't wait for the client to read them.</summary>
+		bool FlushEngine()
+		{
+			if (8 <= m_EngineVersion)
+				return m_EngineStream.Send();
+
+			return Flush(m_EngineStream);
+		}
+
 		bool ReadGameEventSettings(bool delta)
 		{
 			bool bEnable;
 
-			if (!ReadBoolean(m_hEnginePipe, bEnable)) return false;
+			if (!ReadBoolean(m_EngineStream, bEnable)) return false;
 
 			if (!bEnable)
 			{
@@ -2157,7 +2346,7 @@ namespace AfxInterop {
 				bool bChanged;
 
 				// Read if any changes:
-				if (!ReadBoolean(m_hEnginePipe, bChanged)) return false;
+				if (!ReadBoolean(m_EngineStream, bChanged)) return false;
 
 				if (!bChanged) return true;
 			}
@@ -2165,13 +2354,13 @@ namespace AfxInterop {
 			{
 				bool bValue;
 
-				if (!ReadBoolean(m_hEnginePipe, bValue)) return false;
+				if (!ReadBoolean(m_EngineStream, bValue)) return false;
 				TransmitClientTime = bValue;
 
-				if (!ReadBoolean(m_hEnginePipe, bValue)) return false;
+				if (!ReadBoolean(m_EngineStream, bValue)) return false;
 				TransmitTick = bValue;
 
-				if (!ReadBoolean(m_hEnginePipe, bValue)) return false;
+				if (!ReadBoolean(m_EngineStream, bValue)) return false;
 				TransmitSystemTime = bValue;
 			}
 
@@ -2182,22 +2371,22 @@ namespace AfxInterop {
 			{
 				// Read whitelist removals:
 
-				if (!ReadCompressedUInt32(m_hEnginePipe, listSize)) return false;
+				if (!ReadCompressedUInt32(m_EngineStream, listSize)) return false;
 
 				for (unsigned int i = 0; i < listSize; ++i)
 				{
-					if (!ReadStringUTF8(m_hEnginePipe, eventName)) return false;
+					if (!ReadStringUTF8(m_EngineStream, eventName)) return false;
 					CAfxGameEventListenerSerialzer::UnWhiteList(eventName.c_str());
 				}
 			}
 
 			// Read whitelist additions:
 
-			if (!ReadCompressedUInt32(m_hEnginePipe, listSize)) return false;
+			if (!ReadCompressedUInt32(m_EngineStream, listSize)) return false;
 
 			for(unsigned int i = 0; i < listSize; ++i)
 			{
-				if (!ReadStringUTF8(m_hEnginePipe, eventName)) return false;
+				if (!ReadStringUTF8(m_EngineStream, eventName)) return false;
 				CAfxGameEventListenerSerialzer::WhiteList(eventName.c_str());
 			}
 
@@ -2205,37 +2394,37 @@ namespace AfxInterop {
 			{
 				// Read blacklist removals:
 
-				if (!ReadCompressedUInt32(m_hEnginePipe, listSize)) return false;
+				if (!ReadCompressedUInt32(m_EngineStream, listSize)) return false;
 
 				for (unsigned int i = 0; i < listSize; ++i)
 				{
-					if (!ReadStringUTF8(m_hEnginePipe, eventName)) return false;
+					if (!ReadStringUTF8(m_EngineStream, eventName)) return false;
 					CAfxGameEventListenerSerialzer::UnBlackList(eventName.c_str());
 				}
 			}
 
 			// Read blacklist additions:
 
-			if (!ReadCompressedUInt32(m_hEnginePipe, listSize)) return false;
+			if (!ReadCompressedUInt32(m_EngineStream, listSize)) return false;
 
 			for (unsigned int i = 0; i < listSize; ++i)
 			{
-				if (!ReadStringUTF8(m_hEnginePipe, eventName)) return false;
+				if (!ReadStringUTF8(m_EngineStream, eventName)) return false;
 				CAfxGameEventListenerSerialzer::BlackList(eventName.c_str());
 			}
 
 			// Read enrichments:
 
-			if (!ReadCompressedUInt32(m_hEnginePipe, listSize)) return false;
+			if (!ReadCompressedUInt32(m_EngineStream, listSize)) return false;
 
 			for (unsigned int i = 0; i < listSize; ++i)
 			{
 				std::string propertyName;
 				unsigned int enrichmentType;
 
-				if (!ReadStringUTF8(m_hEnginePipe, eventName)) return false;
-				if (!ReadStringUTF8(m_hEnginePipe, propertyName)) return false;
-				if (!ReadUInt32(m_hEnginePipe, enrichmentType)) return false;
+				if (!ReadStringUTF8(m_EngineStream, eventName)) return false;
+				if (!ReadStringUTF8(m_EngineStream, propertyName)) return false;
+				if (!ReadUInt32(m_EngineStream, enrichmentType)) return false;
 				
 				CAfxGameEventListenerSerialzer::EnrichSet(eventName.c_str(), propertyName.c_str(), enrichmentType);
 			}
@@ -344,28 +344,6 @@ private:
 	bool m_Value;
 };
 
-#ifdef AFX_MIRV_PGL
-
-class AfxSupplyCamData_Functor
-	: public CAfxFunctor
-{
-public:
-	AfxSupplyCamData_Functor(MirvPgl::CamData const & value)
-		: m_Value(value)
-	{
-	}
-
-	virtual void operator()()
-	{
-		MirvPgl::DrawingThread_SupplyCamData(m_Value);
-	}
-
-private:
-	MirvPgl::CamData m_Value;
-};
-
-#endif
-
 class AfxDrawGuidesFunctor
 	: public CAfxFunctor
 {
@@ -6603,9 +6581,14 @@ void CAfxStreams::Console_Record_Start()
 			g_Hook_VClient_RenderView.ExportBegin(camFileName.c_str(), frameTime);
 		}
 
-		for (std::list<CEntityBvhCapture *>::iterator it = m_EntityBvhCaptures.begin(); it != m_EntityBvhCaptures.end(); ++it)
+		if (!m_EntityBvhCaptures.empty())
 		{
-			(*it)->StartCapture(m_TakeDir, frameTime);
+			m_EntityBvhExport = new BvhBatchExport(frameTime);
+
+			for (std::list<CEntityBvhCapture *>::iterator it = m_EntityBvhCaptures.begin(); it != m_EntityBvhCaptures.end(); ++it)
+			{
+				(*it)->StartCapture(m_EntityBvhExport, m_TakeDir);
+			}
 		}
 
 		if (m_CamExport)
@@ -6613,7 +6596,7 @@ void CAfxStreams::Console_Record_Start()
 			std::wstring camFileName(m_TakeDir);
 			camFileName.append(L"\\cam_main.cam");
 
-			m_CamExportObj = new CamExport(camFileName.c_str(), m_CamExportScaleFov);
+			m_CamExportObj = new CamExport(camFileName.c_str(), m_CamExportScaleFov, m_CamExportFormat);
 		}
 
 		Tier0_Msg("done.\n");
@@ -6676,6 +6659,12 @@ void CAfxStreams::Console_Record_End()
 			(*it)->EndCapture();
 		}
 
+		if (m_EntityBvhExport)
+		{
+			delete m_EntityBvhExport;
+			m_EntityBvhExport = nullptr;
+		}
+
 		if (m_GameRecording)
 		{
 			if (CClientTools * instance = CClientTools::Instance()) instance->EndRecording();
@@ -8748,7 +8737,7 @@ void CAfxStreams::View_Render(IAfxBaseClientDll * cl, SOURCESDK::vrect_t_csgo *r
 
 	if (MirvPgl::IsDataActive())
 	{
-		QueueOrExecute(GetCurrentContext()->GetOrg(), new CAfxLeafExecute_Functor(new AfxSupplyCamData_Functor(GetMirvPglCamData(rect))));
+		MirvPgl::SupplyCamData(GetMirvPglCamData(rect));
 	}
 
 	cl->GetParent()->View_Render(rect);
@@ -9315,6 +9304,7 @@ IAfxStreamContext * CAfxStreams::FindStreamContext(IAfxMatRenderContext * ctx)
 
 CAfxStreams::CEntityBvhCapture::CEntityBvhCapture(int entityIndex, Origin_e origin, Angles_e angles)
 : m_BvhExport(0)
+, m_BvhExportIndex(-1)
 , m_EntityIndex(entityIndex)
 , m_Origin(origin)
 , m_Angles(angles)
@@ -9326,27 +9316,26 @@ CAfxStreams::CEntityBvhCapture::~CEntityBvhCapture()
 	EndCapture();
 }
 
-void CAfxStreams::CEntityBvhCapture::StartCapture(std::wstring const & takePath, double frameTime)
+void CAfxStreams::CEntityBvhCapture::StartCapture(BvhBatchExport * bvhExport, std::wstring const & takePath)
 {
 	EndCapture();
 
 	std::wostringstream os;
 	os << takePath << L"\\cam_ent_" << m_EntityIndex << L".bvh";
 
-	m_BvhExport = new BvhExport(
+	m_BvhExportIndex = bvhExport->AddFile(
 		os.str().c_str(),
-		"MdtCam",
-		frameTime
+		"MdtCam"
 	);
+
+	if (0 <= m_BvhExportIndex)
+		m_BvhExport = bvhExport;
 }
 
 void CAfxStreams::CEntityBvhCapture::EndCapture(void)
 {
-	if (!m_BvhExport)
-		return;
-
-	delete m_BvhExport;
 	m_BvhExport = 0;
+	m_BvhExportIndex = -1;
 }
 
 void CAfxStreams::CEntityBvhCapture::CaptureFrame(void)
@@ -9376,7 +9365,7 @@ void CAfxStreams::CEntityBvhCapture::CaptureFrame(void)
 		a.z = 0;
 	}
 
-	m_BvhExport->WriteFrame(
+	m_BvhExport->WriteFrame(m_BvhExportIndex,
 		-o.y, +o.z, -o.x,
 		-a.z, -a.x, +a.y
 	);
@@ -9408,6 +9397,9 @@ void CAfxStreams::ShutDown(void)
 			m_EntityBvhCaptures.pop_front();
 		}
 
+		delete m_EntityBvhExport;
+		m_EntityBvhExport = nullptr;
+
 		while (!m_Streams.empty())
 		{
 			m_Streams.front()->Release();
@@ -3238,6 +3238,9 @@ public:
 	CamExport::ScaleFov CamExportScaleFov_get(void) { return m_CamExportScaleFov;  }
 	void CamExportScaleFov_set(CamExport::ScaleFov value) { m_CamExportScaleFov = value;  }
 
+	CamExport::Format CamExportFormat_get(void) { return m_CamExportFormat;  }
+	void CamExportFormat_set(CamExport::Format value) { m_CamExportFormat = value;  }
+
 	void Console_GameRecording(IWrpCommandArgs * args);
 
 	/// <param name="streamName">stream name to preview or empty string if to preview nothing.</param>
@@ -3321,7 +3324,8 @@ private:
 		CEntityBvhCapture(int entityIndex, Origin_e origin, Angles_e angles);
 		~CEntityBvhCapture();
 
-		void StartCapture(std::wstring const & takePath, double frameTime);
+		/// <summary>Adds the entity's file to bvhExport, which must outlive the capture (or until EndCapture).</summary>
+		void StartCapture(BvhBatchExport * bvhExport, std::wstring const & takePath);
 		void EndCapture(void);
 
 		void CaptureFrame(void);
@@ -3334,7 +3338,8 @@ private:
 		Origin_e m_Origin;
 		Angles_e m_Angles;
 		int m_EntityIndex;
-		BvhExport * m_BvhExport;
+		BvhBatchExport * m_BvhExport;
+		int m_BvhExportIndex;
 	};
 
 
@@ -3380,8 +3385,10 @@ private:
 	int m_Frame;
 	bool m_CamBvh;
 	std::list<CEntityBvhCapture *> m_EntityBvhCaptures;
+	BvhBatchExport * m_EntityBvhExport = nullptr;
 	bool m_CamExport = false;
 	CamExport::ScaleFov m_CamExportScaleFov = CamExport::SF_None;
+	CamExport::Format m_CamExportFormat = CamExport::F_Text;
 	CamExport * m_CamExportObj = 0;
 	bool m_GameRecording;
 
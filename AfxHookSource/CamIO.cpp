@@ -2,9 +2,15 @@
 
 #include "CamIO.h"
 
+#include <shared/AfxFileCache.h>
+#include <shared/AfxRefCounted.h>
+#include <shared/ParseTools.h>
+
+#include <Windows.h>
+
+#include <algorithm>
 #include <string>
-#include <sstream>
-#include <share.h>
+#include <vector>
 
 double CamIO::DoFovScaling(double width, double height, double fov)
 {
@@ -23,173 +29,488 @@ double CamIO::UndoFovScaling(double width, double height, double fov)
 }
 
 
-CamExport::CamExport(const wchar_t * fileName, ScaleFov scaleFov)
-	: m_Ofs(fileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc)
+// CamExport ///////////////////////////////////////////////////////////////////
+
+/// <summary>Number of frames buffered before they are handed to the writer thread.</summary>
+#define CAMEXPORT_BATCH_FRAMES 256
+
+static const char CAMIO_BINARY_MAGIC[16] = "advancedfx CamB";
+static const int CAMIO_BINARY_VERSION = 1;
+static const size_t CAMIO_BINARY_HEADER_SIZE = 32;
+
+CamExport::CamExport(const wchar_t * fileName, ScaleFov scaleFov, Format format)
+	: m_Format(format)
 {
+	static_assert(sizeof(CamData) == 8 * sizeof(double), "CamData must be the 8 doubles of a binary record.");
+
 	m_ScaleFov = scaleFov;
 
-	m_Ofs << "advancedfx Cam" << std::endl;
-	m_Ofs << "version 1" << std::endl;
-	m_Ofs << "scaleFov " << (m_ScaleFov == SF_AlienSwarm ? "alienSwarm" : "none") << std::endl;
-	m_Ofs << "channels time xPosition yPosition zPosition xRotation yRotation zRotation fov" << std::endl;
-	m_Ofs << "DATA" << std::endl;
+	if (0 != _wfopen_s(&m_File, fileName, L"wb"))
+		m_File = nullptr;
+
+	if (nullptr == m_File)
+		return;
+
+	if (F_Binary == m_Format)
+	{
+		unsigned char header[CAMIO_BINARY_HEADER_SIZE] = { 0 };
+		int version = CAMIO_BINARY_VERSION;
+		int binaryScaleFov = (int)m_ScaleFov;
+
+		memcpy(&header[0], CAMIO_BINARY_MAGIC, sizeof(CAMIO_BINARY_MAGIC));
+		memcpy(&header[16], &version, sizeof(version));
+		memcpy(&header[20], &binaryScaleFov, sizeof(binaryScaleFov));
+
+		fwrite(header, sizeof(header), 1, m_File);
+	}
+	else
+	{
+		fprintf(m_File,
+			"advancedfx Cam\n"
+			"version 1\n"
+			"scaleFov %s\n"
+			"channels time xPosition yPosition zPosition xRotation yRotation zRotation fov\n"
+			"DATA\n"
+			, m_ScaleFov == SF_AlienSwarm ? "alienSwarm" : "none"
+		);
+	}
+
+	m_Frames.reserve(CAMEXPORT_BATCH_FRAMES);
 
-	m_Ofs << std::fixed;
-	m_Ofs.precision(6);
+	m_Thread = std::thread(WriterThread, this);
 }
 
 CamExport::~CamExport()
 {
-	m_Ofs.close();
+	if (nullptr == m_File)
+		return;
+
+	HandOverFrames();
+
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+		m_Quit = true;
+	}
+	m_PendingCondition.notify_one();
+
+	m_Thread.join();
+
+	fclose(m_File);
 }
 
 void CamExport::WriteFrame(double width, double height, const CamData & camData)
 {
-	m_Ofs << camData.Time << " " << camData.XPosition << " " << camData.YPosition << " " << camData.ZPosition << " " << camData.XRotation << " " << camData.YRotation << " " << camData.ZRotation << " " << DoFovScaling(width, height, camData.Fov) << std::endl;
-}
+	CamData frame(camData);
+	frame.Fov = DoFovScaling(width, height, camData.Fov);
 
-void afx_std_string_remove_CR(std::string & inOutValue) {
-	if (!inOutValue.empty() && '\r' == *(--inOutValue.end()))
-		inOutValue.erase(--inOutValue.end());
+	WriteRawFrame(frame);
 }
 
-CamImport::CamImport(char const * fileName, double startTime)
-	: m_Ifs(fileName, std::ifstream::in | std::ofstream::binary, _SH_DENYWR)
-	, m_StartTime(startTime)
+void CamExport::WriteRawFrame(const CamData & camData)
 {
-	int version = 0;
-	m_ScaleFov = SF_None;
+	if (nullptr == m_File)
+		return;
 
-	char magic[14 + 1 + 1] = { 0 };
+	m_Frames.push_back(camData);
 
-	m_Ifs.getline(magic, sizeof(magic) / sizeof(char), '\n'); if ('\r' == magic[14]) magic[14] = '\0';
-	if (0 != strcmp(magic, "advancedfx Cam"))m_Ifs.clear(m_Ifs.rdstate() | std::ifstream::badbit);
+	if (CAMEXPORT_BATCH_FRAMES <= m_Frames.size())
+		HandOverFrames();
+}
 
+void CamExport::HandOverFrames(void)
+{
+	if (m_Frames.empty())
+		return;
 
-	while (m_Ifs.good())
 	{
-		std::string line;
-
-		std::getline(m_Ifs, line, '\n'); afx_std_string_remove_CR(line);
-
-		std::istringstream iss(line);
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+		m_PendingFrames.insert(m_PendingFrames.end(), m_Frames.begin(), m_Frames.end());
+	}
+	m_PendingCondition.notify_one();
 
-		std::string verb;
+	m_Frames.clear();
+}
 
-		iss >> verb;
+void CamExport::WriterThread(CamExport * self)
+{
+	std::vector<CamData> frames;
 
-		if (0 == verb.compare("DATA"))
-			break;
-		else if (0 == verb.compare("version"))
-		{
-			iss >> version;
-		}
-		else if (0 == verb.compare("scaleFov"))
+	while (true)
+	{
+		bool quit;
 		{
-			std::string arg;
+			std::unique_lock<std::mutex> lock(self->m_PendingMutex);
 
-			iss >> arg;
+			while (!self->m_Quit && self->m_PendingFrames.empty())
+				self->m_PendingCondition.wait(lock);
 
-			if (0 == arg.compare("alienSwarm"))
-				m_ScaleFov = SF_AlienSwarm;
+			frames.swap(self->m_PendingFrames);
+			quit = self->m_Quit;
 		}
-	}
 
-	if (1 != version) m_Ifs.setstate(m_Ifs.rdstate() | std::ifstream::badbit);
+		self->WriteFrames(frames);
+		frames.clear();
 
-	m_DataStart = m_Ifs.tellg();
+		if (quit)
+			break;
+	}
 }
 
-CamImport::~CamImport()
+void CamExport::WriteFrames(std::vector<CamData> const & frames)
 {
-	m_Ifs.close();
-}
+	if (frames.empty())
+		return;
 
-void CamImport::SetStart(double startTime)
-{
-	m_StartTime = startTime;
+	if (F_Binary == m_Format)
+	{
+		fwrite(&frames[0], sizeof(CamData), frames.size(), m_File);
+		return;
+	}
+
+	for (std::vector<CamData>::const_iterator it = frames.begin(); it != frames.end(); ++it)
+	{
+		fprintf(m_File, "%f %f %f %f %f %f %f %f\n", it->Time, it->XPosition, it->YPosition, it->ZPosition, it->XRotation, it->YRotation, it->ZRotation, it->Fov);
+	}
 }
 
-bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
+// CamImportFile ///////////////////////////////////////////////////////////////
+
+/// <summary>Memory mapped .cam file with an index of the frames.</summary>
+class CamImportFile : public advancedfx::CRefCounted
 {
-	if (m_Ifs.bad())
-		return false;
+public:
+	/// <returns>The (AddRef'ed) instance for fileName, shared with other importers of the same file as long as it didn't change.</returns>
+	static CamImportFile * Open(char const * fileName)
+	{
+		CamImportFile * result = m_Files.Find(fileName);
 
-	if (time - m_StartTime < 0)
-		return false;
+		if (nullptr == result) result = new CamImportFile(fileName);
 
-	if (m_HasFinalFrame && m_FinalFrameTime - m_FirstFrameTime < time - m_StartTime)
-		return false;
+		result->AddRef();
 
-	// Jump direcltly to beginning if possible and required:
+		return result;
+	}
 
-	if (m_HasLastFrame && 0 >= time - m_StartTime)
+	bool IsBad() const
 	{
-		if (m_Ifs.seekg(m_DataStart).bad()) return false;
-
-		m_HasLastFrame = false; // potentially invalid, go into backwards seek mode.
+		return m_Bad;
 	}
 
-	// Seek backwards if required:
+	CamIO::ScaleFov GetScaleFov() const
+	{
+		return m_ScaleFov;
+	}
 
-	while (
-		!m_HasLastFrame // has not read any frame yet
-		|| m_LastFrame.Time - m_FirstFrameTime > time - m_StartTime // OR time is before current interval
-		&& m_Ifs.tellg() != m_DataStart // AND not at start of current file
-		)
+	size_t GetFrameCount() const
 	{
-		int lineBreakCount = 0;
+		return m_Binary ? m_BinaryFrameCount : m_Times.size();
+	}
 
-		while (m_Ifs.tellg() != m_DataStart)
+	double GetFrameTime(size_t index) const
+	{
+		if (m_Binary)
 		{
-			if(m_Ifs.seekg(-1, std::ios_base::cur).bad()) return false;
+			double time;
+			memcpy(&time, m_Data + CAMIO_BINARY_HEADER_SIZE + index * sizeof(CamIO::CamData), sizeof(time));
+			return time;
+		}
+
+		return m_Times[index];
+	}
+
+	/// <returns>Index of the first frame not before time, GetFrameCount() if there is none.</returns>
+	size_t FindFrame(double time) const
+	{
+		if (!m_Binary)
+			return std::lower_bound(m_Times.begin(), m_Times.end(), time) - m_Times.begin();
 
-			char c = m_Ifs.peek();
+		// Binary search directly on the records:
 
-			if (m_Ifs.bad())
-				return false;
+		size_t first = 0;
+		size_t count = m_BinaryFrameCount;
 
-			if ('\n' == c)
-				++lineBreakCount;
+		while (0 < count)
+		{
+			size_t step = count / 2;
 
-			if (3 <= lineBreakCount)
+			if (GetFrameTime(first + step) < time)
 			{
-				if (m_Ifs.seekg(1, std::ios_base::cur).bad()) return false;
+				first += step + 1;
+				count -= step + 1;
+			}
+			else
+				count = step;
+		}
+
+		return first;
+	}
 
+	bool ReadFrame(size_t index, CamIO::CamData & outCamData) const
+	{
+		if (m_Binary)
+		{
+			memcpy(&outCamData, m_Data + CAMIO_BINARY_HEADER_SIZE + index * sizeof(CamIO::CamData), sizeof(CamIO::CamData));
+			return true;
+		}
+
+		char const * pos = m_Data + m_Offsets[index];
+		char const * end = m_Data + m_Size;
+
+		double * values[8] = {
+			&outCamData.Time,
+			&outCamData.XPosition,
+			&outCamData.YPosition,
+			&outCamData.ZPosition,
+			&outCamData.XRotation,
+			&outCamData.YRotation,
+			&outCamData.ZRotation,
+			&outCamData.Fov
+		};
+
+		for (int i = 0; i < 8; ++i)
+		{
+			ParseSkipBlanks(pos, end);
+			if (!ParseDouble(pos, end, *values[i])) return false;
+		}
+
+		return true;
+	}
+
+protected:
+	virtual ~CamImportFile()
+	{
+		m_Files.Remove(m_FileName.c_str(), this);
+
+		if (m_Data) UnmapViewOfFile(m_Data);
+		if (m_Mapping) CloseHandle(m_Mapping);
+		if (INVALID_HANDLE_VALUE != m_File) CloseHandle(m_File);
+	}
+
+private:
+	static CAfxFileCache<CamImportFile> m_Files;
+
+	std::string m_FileName;
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = NULL;
+	char const * m_Data = nullptr;
+	size_t m_Size = 0;
+	bool m_Bad = true;
+	CamIO::ScaleFov m_ScaleFov = CamIO::SF_None;
+	std::vector<double> m_Times;
+	std::vector<size_t> m_Offsets;
+	bool m_Binary = false;
+	size_t m_BinaryFrameCount = 0;
+
+	CamImportFile(char const * fileName)
+		: m_FileName(fileName)
+	{
+		m_File = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (INVALID_HANDLE_VALUE == m_File) return;
+
+		// Taken while we hold the file open, so an export replacing it
+		// later on gets a new instance:
+		AfxFileIdentity identity;
+		if (AfxFileIdentity_Get(fileName, identity)) m_Files.Add(fileName, identity, this);
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(m_File, &fileSize) || 0 == fileSize.QuadPart || (ULONGLONG)(size_t)-1 < (ULONGLONG)fileSize.QuadPart) return;
+
+		m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (NULL == m_Mapping) return;
+
+		m_Data = (char const *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (nullptr == m_Data) return;
+
+		m_Size = (size_t)fileSize.QuadPart;
+
+		m_Bad = !BuildIndex();
+	}
+
+	static bool ReadToken(char const * & inOutPos, char const * end, std::string & outToken)
+	{
+		ParseSkipBlanks(inOutPos, end);
+
+		char const * start = inOutPos;
+
+		while (inOutPos < end && ' ' != *inOutPos && '\t' != *inOutPos && '\r' != *inOutPos && '\n' != *inOutPos)
+			++inOutPos;
+
+		outToken.assign(start, inOutPos);
+
+		return start != inOutPos;
+	}
+
+	bool BuildIndex()
+	{
+		if (CAMIO_BINARY_HEADER_SIZE <= m_Size && 0 == memcmp(m_Data, CAMIO_BINARY_MAGIC, sizeof(CAMIO_BINARY_MAGIC)))
+		{
+			// Binary format needs no index, the records have a fixed size.
+
+			int version;
+			int binaryScaleFov;
+
+			memcpy(&version, m_Data + 16, sizeof(version));
+			memcpy(&binaryScaleFov, m_Data + 20, sizeof(binaryScaleFov));
+
+			if (CAMIO_BINARY_VERSION != version) return false;
+
+			m_ScaleFov = CamIO::SF_AlienSwarm == binaryScaleFov ? CamIO::SF_AlienSwarm : CamIO::SF_None;
+			m_Binary = true;
+			m_BinaryFrameCount = (m_Size - CAMIO_BINARY_HEADER_SIZE) / sizeof(CamIO::CamData);
+
+			return true;
+		}
+
+		char const * pos = m_Data;
+		char const * end = m_Data + m_Size;
+
+		static const char magic[] = "advancedfx Cam";
+		size_t magicLength = sizeof(magic) / sizeof(char) - 1;
+
+		if (m_Size < magicLength || 0 != strncmp(pos, magic, magicLength)) return false;
+		pos += magicLength;
+		if (pos < end && '\r' == *pos) ++pos;
+		if (pos < end && '\n' != *pos) return false;
+		ParseSkipLine(pos, end);
+
+		int version = 0;
+		bool hasData = false;
+		std::string verb;
+		std::string arg;
+
+		while (pos < end)
+		{
+			ReadToken(pos, end, verb);
+
+			if (0 == verb.compare("DATA"))
+			{
+				ParseSkipLine(pos, end);
+				hasData = true;
 				break;
 			}
+			else if (0 == verb.compare("version"))
+			{
+				ReadToken(pos, end, arg);
+				version = atoi(arg.c_str());
+			}
+			else if (0 == verb.compare("scaleFov"))
+			{
+				ReadToken(pos, end, arg);
+				if (0 == arg.compare("alienSwarm"))
+					m_ScaleFov = CamIO::SF_AlienSwarm;
+			}
+
+			ParseSkipLine(pos, end);
 		}
 
-		bool hadFrame = m_HasLastFrame;
+		if (1 != version || !hasData) return false;
 
-		m_HasLastFrame = ReadDataLine(m_LastFrame);
-		if (!m_HasLastFrame)
-			return false;
+		// Only the time is parsed here, the rest on demand:
+
+		m_Times.reserve(m_Size / 64);
+		m_Offsets.reserve(m_Size / 64);
 
-		if (!hadFrame)
+		while (pos < end)
 		{
-			// First frame read.
-			m_FirstFrameTime = m_LastFrame.Time;
+			char const * lineStart = pos;
+			double time;
+
+			ParseSkipBlanks(pos, end);
+			if (!ParseDouble(pos, end, time)) break;
+
+			m_Times.push_back(time);
+			m_Offsets.push_back(lineStart - m_Data);
+
+			ParseSkipLine(pos, end);
 		}
 
-		m_LastQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_LastFrame.YRotation, m_LastFrame.ZRotation, m_LastFrame.XRotation)));
-		m_NextFrame = m_LastFrame;
-		m_NextQuat = m_LastQuat;
+		return true;
 	}
+};
 
-	// Read next frame and Seek forward if required
+CAfxFileCache<CamImportFile> CamImportFile::m_Files;
 
-	while (m_NextFrame.Time - m_FirstFrameTime < time - m_StartTime)
+// CamImport ///////////////////////////////////////////////////////////////////
+
+CamImport::CamImport(char const * fileName, double startTime)
+	: m_File(CamImportFile::Open(fileName))
+	, m_StartTime(startTime)
+{
+	m_ScaleFov = m_File->GetScaleFov();
+}
+
+CamImport::~CamImport()
+{
+	m_File->Release();
+}
+
+bool CamImport::IsBad()
+{
+	return m_File->IsBad();
+}
+
+void CamImport::SetStart(double startTime)
+{
+	m_StartTime = startTime;
+}
+
+bool CamImport::ReadFrame(size_t index, CamData & outCamData, Afx::Math::Quaternion & outQuat)
+{
+	if (!m_File->ReadFrame(index, outCamData))
+		return false;
+
+	outQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(outCamData.YRotation, outCamData.ZRotation, outCamData.XRotation)));
+
+	return true;
+}
+
+bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
+{
+	if (m_File->IsBad())
+		return false;
+
+	size_t frameCount = m_File->GetFrameCount();
+
+	if (time - m_StartTime < 0 || frameCount < 1)
+		return false;
+
+	double firstFrameTime = m_File->GetFrameTime(0);
+	double orgTime = time - m_StartTime + firstFrameTime;
+
+	// Binary search for the interval, frames are sorted by time:
+
+	size_t nextIndex = m_File->FindFrame(orgTime);
+	if (frameCount <= nextIndex)
+		return false;
+
+	size_t lastIndex = 0 < nextIndex ? nextIndex - 1 : 0;
+
+	// Only parse frames we don't have already:
+
+	if (lastIndex != m_LastIndex)
+	{
+		if (lastIndex == m_NextIndex)
+		{
+			m_LastFrame = m_NextFrame;
+			m_LastQuat = m_NextQuat;
+		}
+		else if (!ReadFrame(lastIndex, m_LastFrame, m_LastQuat))
+		{
+			m_LastIndex = m_NextIndex = (size_t)-1;
+			return false;
+		}
+
+		m_LastIndex = lastIndex;
+		m_NextIndex = (size_t)-1;
+	}
+
+	if (nextIndex != m_NextIndex)
 	{
-		m_LastFrame = m_NextFrame;
-		m_LastQuat = m_NextQuat;
-		
-		if (!ReadDataLine(m_NextFrame)) {
-			m_FinalFrameTime = m_LastFrame.Time;
-			m_HasFinalFrame = true;
+		if (!ReadFrame(nextIndex, m_NextFrame, m_NextQuat))
+		{
+			m_NextIndex = (size_t)-1;
 			return false;
 		}
-		m_NextQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_NextFrame.YRotation, m_NextFrame.ZRotation, m_NextFrame.XRotation)));
 
 		// Make sure we will travel the short way:
 		double dotProduct = DotProduct(m_NextQuat, m_LastQuat);
@@ -197,9 +518,9 @@ bool CamImport::GetCamData(double time, double width, double height, CamData & o
 		{
 			m_NextQuat = -1.0 * m_NextQuat;
 		}
-	}
 
-	double orgTime = time - m_StartTime + m_FirstFrameTime;
+		m_NextIndex = nextIndex;
+	}
 
 	double delta = m_NextFrame.Time - m_LastFrame.Time;
 	double t = delta ? ((orgTime - m_LastFrame.Time) / delta) : 0;
@@ -218,18 +539,34 @@ bool CamImport::GetCamData(double time, double width, double height, CamData & o
 	return true;
 }
 
-bool CamImport::ReadDataLine(CamData & outCamData)
+// CamIO::Convert //////////////////////////////////////////////////////////////
+
+bool CamIO::Convert(char const * inFileName, const wchar_t * outFileName, Format format)
 {
-	std::string line;
+	CamImportFile * file = CamImportFile::Open(inFileName);
 
-	if (!std::getline(m_Ifs, line, '\n'))
-		return false;
+	bool bOk = !file->IsBad();
+
+	if (bOk)
+	{
+		CamExport camExport(outFileName, file->GetScaleFov(), format);
+
+		bOk = !camExport.IsBad();
 
-	afx_std_string_remove_CR(line);
+		size_t frameCount = file->GetFrameCount();
 
-	std::istringstream iss(line);
+		for (size_t i = 0; bOk && i < frameCount; ++i)
+		{
+			CamData camData;
+
+			bOk = file->ReadFrame(i, camData);
+
+			if (bOk)
+				camExport.WriteRawFrame(camData);
+		}
+	}
 
-	iss >> outCamData.Time >> outCamData.XPosition >> outCamData.YPosition >> outCamData.ZPosition >> outCamData.XRotation >> outCamData.YRotation >> outCamData.ZRotation >> outCamData.Fov;
+	file->Release();
 
-	return !iss.fail();
+	return bOk;
 }
@@ -4,8 +4,10 @@
 #include "FovScaling.h"
 
 #include <stdio.h>
-#include <fstream>
-#include <map>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 class CamIO
@@ -17,6 +19,18 @@ public:
 		SF_AlienSwarm
 	};
 
+	enum Format
+	{
+		/// <summary>Human readable text.</summary>
+		F_Text = 0,
+
+		/// <summary>
+		/// Header (char[16] "advancedfx CamB", int32 version = 1, int32 scaleFov, 8 bytes reserved),
+		/// followed by fixed size little-endian records with the 8 CamData doubles each.
+		/// </summary>
+		F_Binary
+	};
+
 	struct CamData
 	{
 		double Time = 0;
@@ -29,6 +43,9 @@ public:
 		double Fov = 90;
 	};
 
+	/// <summary>Converts a .cam file (any format) to the given format.</summary>
+	static bool Convert(char const * inFileName, const wchar_t * outFileName, Format format);
+
 protected:
 	ScaleFov m_ScaleFov = SF_None;
 
@@ -37,23 +54,55 @@ protected:
 };
 
 
+/// <remarks>
+/// Frames are only buffered on the calling thread,
+/// formatting and writing is done by a background thread.
+/// </remarks>
 class CamExport : public CamIO
 {
 public:
-	CamExport(const wchar_t * fileName, ScaleFov scaleFov);
+	CamExport(const wchar_t * fileName, ScaleFov scaleFov, Format format = F_Text);
 
+	/// <remarks>Blocks until all frames are written.</remarks>
 	~CamExport();
 
+	bool IsBad() { return nullptr == m_File; }
+
 	void WriteFrame(
 		double width, double height
 		, const CamData & camData
 	);
 
+	/// <summary>Like WriteFrame, but the FOV is written as is (already scaled as the file's ScaleFov says).</summary>
+	void WriteRawFrame(const CamData & camData);
+
 private:
-	std::ofstream m_Ofs;
+	Format m_Format;
+	FILE * m_File = nullptr;
+
+	/// <summary>Frames of the calling thread, not yet handed to the writer.</summary>
+	std::vector<CamData> m_Frames;
+
+	std::mutex m_PendingMutex;
+	std::condition_variable m_PendingCondition;
+	std::vector<CamData> m_PendingFrames;
+	bool m_Quit = false;
+
+	std::thread m_Thread;
+
+	void HandOverFrames(void);
+
+	static void WriterThread(CamExport * self);
+
+	void WriteFrames(std::vector<CamData> const & frames);
 };
 
-/// <remarks>Going back in time is very inefficient, you should avoid that or improve code for that.</remarks>
+class CamImportFile;
+
+/// <remarks>
+/// The file is memory mapped and indexed when opened, so seeking in any direction is cheap.<br />
+/// Instances importing the same file share the mapping and index.
+/// </remarks>
 class CamImport : public CamIO
 {
 public:
@@ -66,20 +115,17 @@ public:
 	/// <remarks>If the function fails outCamData content is undefined.</remarks>
 	bool GetCamData(double time, double width, double height, CamData & outCamData);
 
-	bool IsBad() { return m_Ifs.bad(); }
+	bool IsBad();
 
 private:
-	std::ifstream m_Ifs;
+	CamImportFile * m_File;
 	double m_StartTime;
-	std::streampos m_DataStart;
-	double m_FirstFrameTime;
-	bool m_HasLastFrame = false;
-	double m_FinalFrameTime;
-	bool m_HasFinalFrame = false;
+	size_t m_LastIndex = (size_t)-1;
 	CamData m_LastFrame;
 	Afx::Math::Quaternion m_LastQuat;
+	size_t m_NextIndex = (size_t)-1;
 	CamData m_NextFrame;
 	Afx::Math::Quaternion m_NextQuat;
 
-	bool ReadDataLine(CamData & outCamData);
+	bool ReadFrame(size_t index, CamData & outCamData, Afx::Math::Quaternion & outQuat);
 };
@@ -61,6 +61,7 @@ CCampathDrawer::CCampathDrawer()
 , m_VertexBuffer(0)
 , m_VertexBufferVertexCount(0)
 , m_LockedVertexBuffer(0)
+, m_Trajectory(c_CameraTrajectoryEpsilon, c_CameraTrajectoryMaxPointsPerInterval)
 {
 	m_Device = 0;
 	m_PixelShader = 0;
@@ -586,48 +587,11 @@ void CCampathDrawer::OnPostRenderAllTools()
 		{
 			if(m_RebuildDrawing)
 			{
-				// Rebuild trajectory points.
-				// This operation can be quite expensive (up to O(N^2)),
-				// so it should be done only when s.th.
-				// changed (which is what we do here).
+				// Update trajectory points.
+				// Re-sampling is expensive, so this is done only when s.th.
+				// changed and only for the segments that changed.
 
-				m_TrajectoryPoints.clear();
-				
-				CamPathIterator last = g_Hook_VClient_RenderView.m_CamPath.GetBegin();				
-				CamPathIterator it = last;
-
-				TempPoint * pts = new TempPoint[c_CameraTrajectoryMaxPointsPerInterval];
-
-				for(++it; it != g_Hook_VClient_RenderView.m_CamPath.GetEnd(); ++it)
-				{
-					double delta = it.GetTime() -last.GetTime();
-
-					for(size_t i = 0; i<c_CameraTrajectoryMaxPointsPerInterval; i++)
-					{
-						double t = last.GetTime() + delta*((double)i/(c_CameraTrajectoryMaxPointsPerInterval-1));
-
-						CamPathValue cpv = g_Hook_VClient_RenderView.m_CamPath.Eval(t);
-
-						pts[i].t = t;
-						pts[i].y = Vector3(cpv.X, cpv.Y, cpv.Z);
-						pts[i].nextPt = i+1 <c_CameraTrajectoryMaxPointsPerInterval ? &(pts[i+1]) : 0;
-					}
-
-					RamerDouglasPeucker(&(pts[0]), &(pts[c_CameraTrajectoryMaxPointsPerInterval-1]), c_CameraTrajectoryEpsilon);
-
-					// add all points except the last one (to avoid duplicates):
-					for(TempPoint * pt = &(pts[0]); pt && pt->nextPt; pt = pt->nextPt)
-					{
-						m_TrajectoryPoints.push_back(pt->t);
-					}
-
-					last = it;
-				}
-
-				// add last point:
-				m_TrajectoryPoints.push_back(pts[c_CameraTrajectoryMaxPointsPerInterval-1].t);
-
-				delete[] pts;
+				m_Trajectory.Update(g_Hook_VClient_RenderView.m_CamPath);
 
 				m_RebuildDrawing = false;
 			}
@@ -637,74 +601,15 @@ void CCampathDrawer::OnPostRenderAllTools()
 
 			AutoPolyLineStart();
 
-			std::list<double>::iterator itPts = m_TrajectoryPoints.begin();
-
-			CamPathIterator itKeysLast = g_Hook_VClient_RenderView.m_CamPath.GetBegin();
-			CamPathIterator itKeysNext = itKeysLast;
-			++itKeysNext;
+			std::vector<CamPathTrajectory::Point> const & points = m_Trajectory.GetPoints();
 
-			bool hasLastPt = false;
-			bool hasNextPt = false;
-			bool hasCurPt = false;
-			
-			double lastPtTime;
-			CamPathValue lastPtValue;
-			double curPtTime;
-			CamPathValue curPtValue;
-			double nextPtTime;
-			CamPathValue nextPtValue;
-
-			do
+			for(size_t i = 0; i < points.size(); ++i)
 			{
-				if(hasNextPt)
-				{
-					hasLastPt = true;
-					lastPtTime = curPtTime;
-					lastPtValue = curPtValue;
-
-					hasCurPt = true;
-					curPtTime = nextPtTime;
-					curPtValue = nextPtValue;
-
-					hasNextPt = false;
-				}
-				else
-				{
-					hasCurPt = true;
-					curPtTime = *itPts;
-					curPtValue = g_Hook_VClient_RenderView.m_CamPath.Eval(curPtTime);
-					++itPts;
-				}
-
-				while(itKeysNext.GetTime() < curPtTime)
-				{
-					itKeysLast = itKeysNext;
-					++itKeysNext;
-				}
-
-				if(itPts != m_TrajectoryPoints.end())
-				{
-					hasNextPt = true;
-					nextPtTime = *itPts;
-					nextPtValue = g_Hook_VClient_RenderView.m_CamPath.Eval(nextPtTime);
-					++itPts;
-				}
-				else
-				{
-					// current point is last point.
-					hasNextPt = false;
-					nextPtValue = curPtValue;
-				}
-
-				if(!hasLastPt)
-				{
-					// current point is first point.
-					lastPtValue = curPtValue;
-				}
+				CamPathTrajectory::Point const & curPt = points[i];
 
 				// emit current point:
 				{
-					double deltaTime = abs(curTime -curPtTime);
+					double deltaTime = abs(curTime -g_Hook_VClient_RenderView.m_CamPath.DirectToTime(curPt.T));
 
 					DWORD colour;
 
@@ -713,9 +618,9 @@ void CCampathDrawer::OnPostRenderAllTools()
 					{
 						double t = (deltaTime -0.0)/1.0;
 						colour = D3DCOLOR_RGBA(
-							ValToUCCondInv(255.0*t, curPtValue.Selected),
-							ValToUCCondInv(255, curPtValue.Selected),
-							ValToUCCondInv(0, curPtValue.Selected),
+							ValToUCCondInv(255.0*t, curPt.Selected),
+							ValToUCCondInv(255, curPt.Selected),
+							ValToUCCondInv(0, curPt.Selected),
 							(unsigned char)(127*(1.0-t))+128
 						);
 					}
@@ -724,30 +629,29 @@ void CCampathDrawer::OnPostRenderAllTools()
 					{
 						double t = (deltaTime -1.0)/1.0;
 						colour = D3DCOLOR_RGBA(
-							ValToUCCondInv(255, curPtValue.Selected),
-							ValToUCCondInv(255.0*(1.0-t), curPtValue.Selected),
-							ValToUCCondInv(0, curPtValue.Selected),
+							ValToUCCondInv(255, curPt.Selected),
+							ValToUCCondInv(255.0*(1.0-t), curPt.Selected),
+							ValToUCCondInv(0, curPt.Selected),
 							(unsigned char)(64*(1.0-t))+64
 						);
 					}
 					else
 					{
 						colour = D3DCOLOR_RGBA(
-							ValToUCCondInv(255, curPtValue.Selected),
-							ValToUCCondInv(0, curPtValue.Selected),
-							ValToUCCondInv(0, curPtValue.Selected),
+							ValToUCCondInv(255, curPt.Selected),
+							ValToUCCondInv(0, curPt.Selected),
+							ValToUCCondInv(0, curPt.Selected),
 							64
 						);
 					}
 
 					AutoPolyLinePoint(
-						Vector3(lastPtValue.X,lastPtValue.Y,lastPtValue.Z)
-						, Vector3(curPtValue.X,curPtValue.Y,curPtValue.Z)
+						0 < i ? points[i -1].Y : curPt.Y
+						, curPt.Y
 						, colour
-						, Vector3(nextPtValue.X,nextPtValue.Y,nextPtValue.Z));
+						, i +1 < points.size() ? points[i +1].Y : curPt.Y);
 				}
 			}
-			while(hasNextPt);
 
 			AutoPolyLineFlush();
 		}
@@ -1017,31 +921,6 @@ void CCampathDrawer::UnloadVertexBuffer()
 	if(m_VertexBuffer) { m_VertexBuffer->Release(); m_VertexBuffer = 0; }
 }
 
-void CCampathDrawer::RamerDouglasPeucker(TempPoint * start, TempPoint * end, double epsilon)
-{
-	double dmax = 0;
-	TempPoint * index = start;
-
-	for(TempPoint * i = start->nextPt; i && i != end; i = i->nextPt)
-	{
-		double d = ShortestDistanceToSegment(i, start, end);
-		if(d > dmax)
-		{
-			index = i;
-			dmax = d;
-		}
-	}
-
-	// If max distance is greater than epsilon, recursively simplify
-	if ( dmax > epsilon )
-	{
-		RamerDouglasPeucker(start, index, epsilon);
-		RamerDouglasPeucker(index, end, epsilon);
-	} else {
-		start->nextPt = end;
-	}
-}
-
 void CCampathDrawer::Reset()
 {
 	UnloadVertexBuffer();
@@ -1051,22 +930,3 @@ void CCampathDrawer::Reset()
 		m_DigitsTexture = nullptr;
 	}
 }
-
-double CCampathDrawer::ShortestDistanceToSegment(TempPoint * pt, TempPoint * start, TempPoint * end)
-{
-	double ESx = end->y.X - start->y.X;
-	double ESy = end->y.Y - start->y.Y;
-	double ESz = end->y.Z - start->y.Z;
-	double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
-	double t = dESdES ? (
-		(pt->y.X-start->y.X)*ESx +(pt->y.Y -start->y.Y)*ESy + (pt->y.Z -start->y.Z)*ESz
-	) / dESdES : 0.0;
-
-	if(t <= 0.0)
-		return (start->y -pt->y).Length();
-	else
-	if(1.0 <= t)
-		return (pt->y -end->y).Length();
-
-	return (pt->y -(start->y +t*(end->y -start->y))).Length();
-}
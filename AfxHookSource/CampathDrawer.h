@@ -3,8 +3,8 @@
 #include "SourceInterfaces.h"
 #include "AfxShaders.h"
 #include <shared/CamPath.h>
+#include <shared/CamPathTrajectory.h>
 #include <d3d9.h>
-#include <list>
 
 #define CCampathDrawer_VertexFVF D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX0 | D3DFVF_TEXCOORDSIZE3(0) | D3DFVF_TEX1 | D3DFVF_TEXCOORDSIZE3(1) | D3DFVF_TEX2 | D3DFVF_TEXCOORDSIZE3(2)
 
@@ -47,13 +47,6 @@ private:
 		FLOAT t2u, t2v, t2w; // Unit vector pointing to next line point
 	};
 
-	struct TempPoint
-	{
-		double t;
-		Vector3 y;
-		TempPoint * nextPt;
-	};
-
 	bool m_DrawKeyframeAxis = false;
 	bool m_DrawKeyframeCam = true;
 
@@ -69,7 +62,7 @@ private:
 	IDirect3DVertexBuffer9 * m_VertexBuffer;
 	UINT m_VertexBufferVertexCount; // c_VertexBufferVertexCount
 	Vertex * m_LockedVertexBuffer;
-	std::list<double> m_TrajectoryPoints;
+	CamPathTrajectory m_Trajectory;
 	float m_DrawKeyframIndex = 18.0f;
 	IDirect3DTexture9* m_DigitsTexture = nullptr;
 	IAfxPixelShader* m_DrawTextureShader = nullptr;
@@ -90,10 +83,6 @@ private:
 	void UnlockVertexBuffer();
 	void UnloadVertexBuffer();
 
-	/// <summary>For reducing the number of points.</summary>
-	void RamerDouglasPeucker(TempPoint * start, TempPoint * end, double epsilon);
-	double ShortestDistanceToSegment(TempPoint * pt, TempPoint * start, TempPoint * end);
-
 	void DrawCamera(const CamPathValue & cpv, DWORD colour, FLOAT screenInfo[4]);
 };
 
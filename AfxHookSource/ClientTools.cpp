@@ -6,6 +6,7 @@
 #include "CamIO.h"
 #include "WrpConsole.h"
 
+#include <shared/AfxGameRecordParser.h>
 #include <shared/StringTools.h>
 
 #include <iostream>
@@ -38,11 +39,11 @@ void CClientTools::OnBeforeFrameRenderStart(void)
 	if (!m_Recording)
 		return;
 
-	if (m_File)
+	if (m_Writer.IsOpen())
 	{
 		WriteDictionary("afxFrame");
 		Write((float)g_Hook_VClient_RenderView.GetGlobals()->absoluteframetime_get());
-		m_HiddenFileOffset = ftell(m_File);
+		m_HiddenBufferOffset = m_Writer.GetOffset();
 		Write((int)0);
 	}
 	
@@ -65,17 +66,12 @@ void CClientTools::OnAfterFrameRenderEnd(void)
 		Write((float)ScaleFov(g_Hook_VClient_RenderView.LastWidth, g_Hook_VClient_RenderView.LastHeight, (float)g_Hook_VClient_RenderView.LastCameraFov));
 	}
 
-	if (m_File && m_HiddenFileOffset && 0 < m_Hidden.size())
+	if (m_Writer.IsOpen() && m_HiddenBufferOffset && 0 < m_Hidden.size())
 	{
 		WriteDictionary("afxHidden");
 
-		size_t curOffset = ftell(m_File);
-
-		int offset = (int)(curOffset - m_HiddenFileOffset);
-
-		fseek(m_File, m_HiddenFileOffset, SEEK_SET);
-		Write((int)offset);
-		fseek(m_File, curOffset, SEEK_SET);
+		// The placeholder is still in the writer's buffer, so it can be patched in memory:
+		m_Writer.PatchInt(m_HiddenBufferOffset, (int)(m_Writer.GetOffset() - m_HiddenBufferOffset));
 
 		Write((int)m_Hidden.size());
 
@@ -85,10 +81,13 @@ void CClientTools::OnAfterFrameRenderEnd(void)
 		}
 
 		m_Hidden.clear();
-		m_HiddenFileOffset = 0;
 	}
 
 	WriteDictionary("afxFrameEnd");
+
+	m_HiddenBufferOffset = 0;
+
+	m_Writer.EndFrame();
 }
 
 bool CClientTools::GetRecording(void)
@@ -102,22 +101,12 @@ void CClientTools::StartRecording(wchar_t const * fileName)
 
 	m_Recording = true;
 
-	Dictionary_Clear();
-	m_File = 0;
-
-	m_HiddenFileOffset = 0;
+	m_HiddenBufferOffset = 0;
 	m_Hidden.clear();
 
-	_wfopen_s(&m_File, fileName, L"wb");
+	m_Writer.SetUnchangedThreshold(m_UnchangedThreshold);
 
-	if (m_File)
-	{
-		fputs("afxGameRecord", m_File);
-		fputc('\0', m_File);
-		int version = 5;
-		fwrite(&version, sizeof(version), 1, m_File);
-	}
-	else
+	if (!m_Writer.Open(fileName, m_RecordVersion))
 		Tier0_Warning("ERROR opening file \"%s\" for writing.\n", fileName);
 
 	if (!EnableRecordingMode_get() && !SuppotsAutoEnableRecordingMode()) {
@@ -135,86 +124,97 @@ void CClientTools::EndRecording()
 	if (!m_Recording)
 		return;
 
-	if (m_File)
+	if (m_Writer.IsOpen())
 	{
-		fclose(m_File);
-	}
+		if (!m_Writer.Close())
+			Tier0_Warning("ERROR writing AGR file.\n");
 
-	Dictionary_Clear();
+		if (0 < m_Writer.GetUnchangedCount())
+		{
+			Tier0_Msg("%i of %i entity states were unchanged (saved %lld bytes before compression).\n", m_Writer.GetUnchangedCount(), m_Writer.GetEntityCount(), m_Writer.GetUnchangedBytesSaved());
+		}
+	}
 
 	m_Recording = false;
 }
 
 void CClientTools::WriteDictionary(char const * value)
 {
-	int idx = Dictionary_Get(value);
-
-	Write(idx);
-
-	if (-1 == idx)
-	{
-		Write(value);
-	}
+	m_Writer.WriteDictionary(value);
 }
 
 void CClientTools::Write(bool value)
 {
-	if (!m_File) return;
-
-	unsigned char ucValue = value ? 1 : 0;
-
-	fwrite(&ucValue, sizeof(ucValue), 1, m_File);
+	m_Writer.Write(value);
 }
 
 void CClientTools::Write(int value)
 {
-	if (!m_File) return;
-
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_Writer.Write(value);
 }
 
 void CClientTools::Write(float value)
 {
-	if (!m_File) return;
-
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_Writer.Write(value);
 }
 
 void CClientTools::Write(double value)
 {
-	if (!m_File) return;
-
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_Writer.Write(value);
 }
 
 void CClientTools::Write(char const * value)
 {
-	if (!m_File) return;
-
-	fputs(value, m_File);
-	fputc('\0', m_File);
+	m_Writer.Write(value);
 }
 
 void CClientTools::Write(SOURCESDK::Vector const & value)
 {
-	Write((float)value.x);
-	Write((float)value.y);
-	Write((float)value.z);
+	float values[3] = { (float)value.x, (float)value.y, (float)value.z };
+
+	m_Writer.Write(values, 3);
 }
 
 void CClientTools::Write(SOURCESDK::QAngle const & value)
 {
-	Write((float)value.x);
-	Write((float)value.y);
-	Write((float)value.z);
+	float values[3] = { (float)value.x, (float)value.y, (float)value.z };
+
+	m_Writer.Write(values, 3);
 }
 
 void CClientTools::Write(SOURCESDK::Quaternion const & value)
 {
-	Write((float)value.x);
-	Write((float)value.y);
-	Write((float)value.z);
-	Write((float)value.w);
+	float values[4] = { (float)value.x, (float)value.y, (float)value.z, (float)value.w };
+
+	m_Writer.Write(values, 4);
+}
+
+void CClientTools::BeginBones(int entityHandle, int numBones)
+{
+	m_Writer.BeginBones(entityHandle, numBones);
+}
+
+void CClientTools::WriteBone(SOURCESDK::Vector const & position, SOURCESDK::Quaternion const & rotation)
+{
+	float positionValues[3] = { (float)position.x, (float)position.y, (float)position.z };
+	float rotationValues[4] = { (float)rotation.x, (float)rotation.y, (float)rotation.z, (float)rotation.w };
+
+	m_Writer.WriteBone(positionValues, rotationValues);
+}
+
+void CClientTools::BeginEntity(int entityHandle)
+{
+	m_Writer.BeginEntity(entityHandle);
+}
+
+void CClientTools::EndEntity(void)
+{
+	m_Writer.EndEntity();
+}
+
+void CClientTools::WriteDeleted(int entityHandle)
+{
+	m_Writer.WriteDeleted(entityHandle);
 }
 
 void CClientTools::MarkHidden(int value)
@@ -385,6 +385,46 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 			);
 			return true;
 		}
+		else if (0 == _stricmp("version", cmd1))
+		{
+			if (3 <= argc)
+			{
+				int value = atoi(args->ArgV(2));
+
+				if (value == AFXGAMERECORD_VERSION_RAW || value == AFXGAMERECORD_VERSION_COMPRESSED)
+				{
+					clientTools->RecordVersion_set(value);
+					return true;
+				}
+			}
+
+			Tier0_Msg(
+				"%s version %i|%i - AGR version to record: %i (default) can be read by all importers, %i is much smaller (compressed) and has a frame index for seeking, but has to be converted with mirv_agr convert for older importers.\n"
+				"Current value: %i.\n"
+				, prefix
+				, AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED
+				, AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED
+				, clientTools->RecordVersion_get()
+			);
+			return true;
+		}
+		else if (0 == _stricmp("unchangedThreshold", cmd1))
+		{
+			if (3 <= argc)
+			{
+				clientTools->UnchangedThreshold_set((float)atof(args->ArgV(2)));
+				return true;
+			}
+
+			Tier0_Msg(
+				"%s unchangedThreshold -1|<fThreshold> - Version %i only: Entity states that don't differ by more than <fThreshold> in any value (position, angles, bones, ...) from the last one written for the entity are written as small \"unchanged\" records (i.e. for dropped weapons or dead players). 0 only for exactly the same state, -1 (default) disables it.\n"
+				"Current value: %f.\n"
+				, prefix
+				, AFXGAMERECORD_VERSION_COMPRESSED
+				, clientTools->UnchangedThreshold_get()
+			);
+			return true;
+		}
 		else if (0 == _stricmp("debug", cmd1))
 		{
 			if (3 <= argc)
@@ -413,6 +453,8 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 		"%s recordProjectiles [...]\n"
 		"%s recordViewmodels [...]\n"
 		"%s recordInvisible [...] - (not recommended)\n"
+		"%s version [...]\n"
+		"%s unchangedThreshold [...]\n"
 		"%s debug [...]\n"
 		, prefix
 		, prefix
@@ -422,6 +464,8 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 		, prefix
 		, prefix
 		, prefix
+		, prefix
+		, prefix
 	);
 
 	return false;
@@ -495,6 +539,35 @@ CON_COMMAND(mirv_agr, "AFX GameRecord")
 			);
 			return;
 		}
+		else if (!_stricmp(cmd1, "convert"))
+		{
+			if (5 <= argc)
+			{
+				std::wstring wideInPath;
+				std::wstring wideOutPath;
+
+				if (UTF8StringToWideString(args->ArgV(2), wideInPath)
+					&& UTF8StringToWideString(args->ArgV(3), wideOutPath)
+					&& AfxGameRecordConvert(wideInPath.c_str(), wideOutPath.c_str(), atoi(args->ArgV(4))))
+				{
+					Tier0_Msg("Converted AGR.\n");
+					return;
+				}
+
+				Tier0_Warning(
+					"Error.\n"
+				);
+				return;
+			}
+
+			Tier0_Msg(
+				"%s convert <sInFilePath> <sOutFilePath> %i|%i - Convert AGR <sInFilePath> to the given version, i.e. %i for importers that don't support version %i yet.\n"
+				, prefix
+				, AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED
+				, AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED
+			);
+			return;
+		}
 	}
 
 	if (ClientTools_Console_Cfg(args))
@@ -510,6 +583,8 @@ CON_COMMAND(mirv_agr, "AFX GameRecord")
 	Tier0_Msg(
 		"%s start <sFilePath> - Start recording to file <sFilePath>, you should set a low host_framerate before (i.e. 30) and give the \".agr\" file extension.\n"
 		"%s stop - Stop recording.\n"
+		"%s convert [...] - Convert an AGR to another version.\n"
+		, prefix
 		, prefix
 		, prefix
 	);
@@ -3,6 +3,8 @@
 #include "SourceInterfaces.h"
 #include "WrpConsole.h"
 
+#include <shared/AfxGameRecord.h>
+
 #include <string>
 #include <set>
 #include <map>
@@ -126,6 +128,26 @@ public:
 		m_RecordPlayerCameras = value;
 	}
 
+	int RecordVersion_get(void)
+	{
+		return m_RecordVersion;
+	}
+
+	void RecordVersion_set(int value)
+	{
+		m_RecordVersion = value;
+	}
+
+	float UnchangedThreshold_get(void)
+	{
+		return m_UnchangedThreshold;
+	}
+
+	void UnchangedThreshold_set(float value)
+	{
+		m_UnchangedThreshold = value;
+	}
+
 protected:
 	virtual float ScaleFov(int width, int height, float fov) { return fov; }
 
@@ -140,19 +162,32 @@ protected:
 	void Write(SOURCESDK::QAngle const & value);
 	void Write(SOURCESDK::Quaternion const & value);
 
+	/// <summary>Writes the bone count, must be followed by numBones WriteBone calls.</summary>
+	void BeginBones(int entityHandle, int numBones);
+
+	void WriteBone(SOURCESDK::Vector const & position, SOURCESDK::Quaternion const & rotation);
+
+	/// <summary>Writes "entity_state" and the handle, must be ended with EndEntity after the "/" token and view model flag.</summary>
+	void BeginEntity(int entityHandle);
+
+	void EndEntity(void);
+
+	void WriteDeleted(int entityHandle);
+
 	void MarkHidden(int value);
 
 private:
 	static CClientTools * m_Instance;
 
-	std::map<std::string, int> m_Dictionary;
-
-	size_t m_HiddenFileOffset;
+	/// <summary>Offset (see CAfxGameRecordWriter::GetOffset) of the current frame's afxHidden offset placeholder, 0 if none.</summary>
+	size_t m_HiddenBufferOffset;
 	std::set<int> m_Hidden;
 
 	bool m_EnableRecording = false;
 	bool m_Recording;
-	FILE * m_File;
+	CAfxGameRecordWriter m_Writer;
+	int m_RecordVersion = AFXGAMERECORD_VERSION_RAW;
+	float m_UnchangedThreshold = -1;
 
 	int m_Debug = 0;
 	bool m_RecordCamera = true;
@@ -162,29 +197,6 @@ private:
 	bool m_RecordProjectiles = true;
 	int m_RecordViewModels = 0;
 	bool m_RecordInvisible = false;
-
-	void Dictionary_Clear()
-	{
-		m_Dictionary.clear();
-	}
-
-	int Dictionary_Get(char const * value)
-	{
-		std::string sValue(value);
-
-		std::map<std::string, int>::iterator it = m_Dictionary.find(sValue);
-
-		if (it != m_Dictionary.end())
-		{
-			const std::pair<const std::string, int> & pair = *it;
-			return pair.second;
-		}
-
-		size_t oldDictSize = m_Dictionary.size();
-
-		m_Dictionary[sValue] = oldDictSize;
-		return -1;
-	}
 };
 
 bool ClientTools_Console_Cfg(IWrpCommandArgs * args);
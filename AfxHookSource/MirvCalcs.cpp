@@ -10,6 +10,7 @@
 #include "CamIO.h"
 #include "csgo/ClientToolsCsgo.h"
 
+#include <shared/AfxFrameCache.h>
 #include <shared/StringTools.h>
 #include <ctype.h>
 
@@ -28,6 +29,8 @@ CMirvBoolCalcs g_MirvBoolCalcs;
 CMirvIntCalcs g_MirvIntCalcs;
 CMirvFloatCalcs g_MirvFloatCalcs;
 
+CAfxFrameCacheClock g_MirvCalcsFrameCache;
+
 int g_LevelInitCount = 0;
 
 void CalcDeltaSmooth(double deltaT, double targetDeltaPos, double & resultDeltaPos, double & lastVel, double LimitVelocity, double LimitAcceleration)
@@ -411,6 +414,22 @@ private:
 	int m_RefCount = 0;
 };
 
+struct MirvCalcVecAng
+{
+	SOURCESDK::Vector Vector;
+	SOURCESDK::QAngle Angles;
+};
+
+struct MirvCalcCam
+{
+	SOURCESDK::Vector Vector;
+	SOURCESDK::QAngle Angles;
+	float Fov;
+};
+
+// The CalcX functions return the result cached for the frame (see MirvCalcs_AfterFrameRenderStart),
+// subclasses implement DoCalcX.
+
 class CMirvHandleCalc : public CMirvCalc, public IMirvHandleCalc
 {
 public:
@@ -452,6 +471,13 @@ public:
 	}
 
 	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	{
+		return m_Cache.Get(g_MirvCalcsFrameCache, outHandle, [this](SOURCESDK::CSGO::CBaseHandle & outValue) {
+			return DoCalcHandle(outValue);
+		});
+	}
+
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		return false;
 	}
@@ -460,6 +486,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<SOURCESDK::CSGO::CBaseHandle> m_Cache;
 };
 
 
@@ -473,7 +502,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		outHandle = m_Handle;
 		return true;
@@ -532,7 +561,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(m_Index);
 
@@ -602,7 +631,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		// Left screen side keys: 1, 2, 3, 4, 5
 		// Right screen side keys: 6, 7, 8, 9, 0
@@ -714,7 +743,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -809,7 +838,7 @@ public:
 	{
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(g_VEngineClient->GetLocalPlayer());
 
@@ -854,7 +883,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -917,7 +946,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -1021,6 +1050,19 @@ public:
 	}
 
 	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	{
+		MirvCalcVecAng result;
+
+		if (!m_Cache.Get(g_MirvCalcsFrameCache, result, [this](MirvCalcVecAng & outValue) {
+			return DoCalcVecAng(outValue.Vector, outValue.Angles);
+		})) return false;
+
+		outVector = result.Vector;
+		outAngles = result.Angles;
+		return true;
+	}
+
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		return false;
 	}
@@ -1029,6 +1071,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<MirvCalcVecAng> m_Cache;
 };
 
 
@@ -1073,6 +1118,20 @@ public:
 	}
 
 	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	{
+		MirvCalcCam result;
+
+		if (!m_Cache.Get(g_MirvCalcsFrameCache, result, [this](MirvCalcCam & outValue) {
+			return DoCalcCam(outValue.Vector, outValue.Angles, outValue.Fov);
+		})) return false;
+
+		outVector = result.Vector;
+		outAngles = result.Angles;
+		outFov = result.Fov;
+		return true;
+	}
+
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
 		return false;
 	}
@@ -1081,6 +1140,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<MirvCalcCam> m_Cache;
 };
 
 double CalcExpSmooth(double deltaT, double oldVal, double newVal)
@@ -1226,7 +1288,7 @@ public:
 		);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1393,7 +1455,7 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1472,6 +1534,13 @@ public:
 	}
 
 	virtual bool CalcFov(float & outFov)
+	{
+		return m_Cache.Get(g_MirvCalcsFrameCache, outFov, [this](float & outValue) {
+			return DoCalcFov(outValue);
+		});
+	}
+
+	virtual bool DoCalcFov(float & outFov)
 	{
 		return false;
 	}
@@ -1480,6 +1549,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<float> m_Cache;
 };
 
 class CMirvVecAngValueCalc : public CMirvVecAngCalc
@@ -1503,7 +1575,7 @@ public:
 		Tier0_Msg(", fn: \"value\", x: %f, y: %f, z: %f, rX: %f, rY: %f, rZ: %f", m_Vec.x, m_Vec.y, m_Vec.z, m_Ang.z, m_Ang.x, m_Ang.y);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		outVector = m_Vec;
 		outAngles = m_Ang;
@@ -1697,7 +1769,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1850,7 +1922,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		bool calcedHandle = m_Handle->CalcHandle(handle);
@@ -1932,7 +2004,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		bool calcedHandle = m_Handle->CalcHandle(handle);
@@ -1985,7 +2057,7 @@ public:
 		Tier0_Msg(", false: "); m_CondFalse->Console_PrintBegin(); m_CondFalse->Console_PrintEnd();
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		bool condition;
 
@@ -2032,7 +2104,7 @@ public:
 		Tier0_Msg(", b: "); m_B->Console_PrintBegin(); m_B->Console_PrintEnd();
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		return m_A->CalcVecAng(outVector, outAngles) || m_B->CalcVecAng(outVector, outAngles);
 	}
@@ -2241,7 +2313,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -2392,7 +2464,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector aVector;
 		SOURCESDK::QAngle aAngles;
@@ -2466,7 +2538,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector sourceVector;
 		SOURCESDK::QAngle sourceAngles;
@@ -2602,7 +2674,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::CSGO::CBaseHandle resetHandle;
@@ -2756,7 +2828,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::Vector sourceVector;
@@ -2834,7 +2906,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::Vector sourceVector;
@@ -2982,7 +3054,7 @@ public:
 		);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
 		CamIO::CamData outCamData;
 
@@ -3043,8 +3115,11 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
+		// Changes within the frame (set up when the view is rendered):
+		g_MirvCalcsFrameCache.MarkVolatile();
+
 		outVector.x = g_Hook_VClient_RenderView.GameCameraOrigin[0];
 		outVector.y = g_Hook_VClient_RenderView.GameCameraOrigin[1];
 		outVector.z = g_Hook_VClient_RenderView.GameCameraOrigin[2];
@@ -3086,8 +3161,11 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
+		// Changes within the frame (whenever the view is overridden):
+		g_MirvCalcsFrameCache.MarkVolatile();
+
 		outVector.x = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[0];
 		outVector.y = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[1];
 		outVector.z = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[2];
@@ -3131,7 +3209,7 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector& outVector, SOURCESDK::QAngle& outAngles, float& outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector& outVector, SOURCESDK::QAngle& outAngles, float& outFov)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 
@@ -3185,7 +3263,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		float dummyFov;
 
@@ -3225,7 +3303,7 @@ public:
 		CMirvFovCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcFov(float & outFov)
+	virtual bool DoCalcFov(float & outFov)
 	{
 		SOURCESDK::Vector dummyVector;
 		SOURCESDK::QAngle dummyAngles;
@@ -3284,7 +3362,14 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(void)
+	virtual bool CalcBool(bool & outResult)
+	{
+		return m_Cache.Get(g_MirvCalcsFrameCache, outResult, [this](bool & outValue) {
+			return DoCalcBool(outValue);
+		});
+	}
+
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		return false;
 	}
@@ -3293,6 +3378,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<bool> m_Cache;
 };
 
 class CMirvBoolAndCalc : public CMirvBoolCalc
@@ -3316,7 +3404,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValueA, calcValueB;
 
@@ -3362,7 +3450,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValueA, calcValueB;
 
@@ -3412,7 +3500,7 @@ public:
 
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValue;
 
@@ -3453,7 +3541,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle dummy;
 
@@ -3490,7 +3578,7 @@ public:
 		Tier0_Msg(", vecAng: "); m_VecAng->Console_PrintBegin(); m_VecAng->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::Vector dummyVec;
 		SOURCESDK::QAngle dummyAng;
@@ -3528,7 +3616,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -3578,7 +3666,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle calcValueA, calcValueB;
 
@@ -3624,7 +3712,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		int calcValueA, calcValueB;
 
@@ -3670,7 +3758,7 @@ public:
 		Tier0_Msg(", wildCardString: \"%s\"", m_WildCardString.c_str());
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 
@@ -3742,7 +3830,14 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
-	virtual bool CalcInt(void)
+	virtual bool CalcInt(int & outResult)
+	{
+		return m_Cache.Get(g_MirvCalcsFrameCache, outResult, [this](int & outValue) {
+			return DoCalcInt(outValue);
+		});
+	}
+
+	virtual bool DoCalcInt(int & outResult)
 	{
 		return false;
 	}
@@ -3751,6 +3846,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<int> m_Cache;
 };
 
 
@@ -3770,7 +3868,7 @@ public:
 		Tier0_Msg(", fn: \"value\", value: %i", m_Value);
 	}
 
-	virtual bool CalcInt(int & outResult)
+	virtual bool DoCalcInt(int & outResult)
 	{
 		outResult = m_Value;
 
@@ -3804,7 +3902,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcInt(int & outResult)
+	virtual bool DoCalcInt(int & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -3875,7 +3973,14 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
-	virtual bool CalcFloat(void)
+	virtual bool CalcFloat(float & outResult)
+	{
+		return m_Cache.Get(g_MirvCalcsFrameCache, outResult, [this](float & outValue) {
+			return DoCalcFloat(outValue);
+		});
+	}
+
+	virtual bool DoCalcFloat(float & outResult)
 	{
 		return false;
 	}
@@ -3884,6 +3989,9 @@ public:
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+private:
+	CAfxFrameCached<float> m_Cache;
 };
 
 
@@ -3903,7 +4011,7 @@ public:
 		Tier0_Msg(", fn: \"value\", value: %f", m_Value);
 	}
 
-	virtual bool CalcFloat(float& outResult)
+	virtual bool DoCalcFloat(float& outResult)
 	{
 		outResult = m_Value;
 
@@ -3944,7 +4052,7 @@ public:
 		Tier0_Msg(", false: "); m_CondFalse->Console_PrintBegin(); m_CondFalse->Console_PrintEnd();
 	}
 
-	virtual bool CalcFloat(float& outResult)
+	virtual bool DoCalcFloat(float& outResult)
 	{
 		bool condition;
 
@@ -6566,11 +6674,58 @@ void mirv_calcs_float(IWrpCommandArgs* args)
 
 
 
+void mirv_calcs_cache(IWrpCommandArgs * args)
+{
+	int argc = args->ArgC();
+	char const * arg0 = args->ArgV(0);
+
+	if (2 <= argc)
+	{
+		char const * arg1 = args->ArgV(1);
+
+		if (0 == _stricmp("enabled", arg1))
+		{
+			if (3 <= argc)
+			{
+				g_MirvCalcsFrameCache.SetEnabled(0 != atoi(args->ArgV(2)));
+				return;
+			}
+
+			Tier0_Msg(
+				"%s enabled 0|1 - Evaluate each calc at most once per frame (1, default) or each time it is used (0).\n"
+				"Current value: %i\n"
+				, arg0
+				, g_MirvCalcsFrameCache.GetEnabled() ? 1 : 0
+			);
+			return;
+		}
+		else if (0 == _stricmp("stats", arg1))
+		{
+			Tier0_Msg(
+				"Last frame: %u evaluations, %u cached results used.\n"
+				, g_MirvCalcsFrameCache.GetLastEvaluations()
+				, g_MirvCalcsFrameCache.GetLastHits()
+			);
+			return;
+		}
+	}
+
+	Tier0_Msg(
+		"%s enabled [...] - Cache the results per frame.\n"
+		"%s stats - Print the evaluations of the last frame.\n"
+		, arg0
+		, arg0
+	);
+}
+
 CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mirv_cam, mirv_aim")
 {
 	int argc = args->ArgC();
 	char const * arg0 = args->ArgV(0);
 
+	// Calcs can be added, removed or edited, so the results so far can be wrong:
+	g_MirvCalcsFrameCache.Invalidate();
+
 	if (2 <= argc)
 	{
 		char const * arg1 = args->ArgV(1);
@@ -6617,6 +6772,12 @@ CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mir
 			mirv_calcs_float(&sub);
 			return;
 		}
+		else if (0 == _stricmp("cache", arg1))
+		{
+			CSubWrpCommandArgs sub(args, 2);
+			mirv_calcs_cache(&sub);
+			return;
+		}
 	}
 
 	Tier0_Msg(
@@ -6627,6 +6788,8 @@ CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mir
 		"%s bool [...] - Calc that returns true or false (if it could be evaluated that is).\n"
 		"%s int [...] - Calc that returns an integer or nothing.\n"
 		"%s float [...] - Calc that returns an integer or nothing.\n"
+		"%s cache [...] - Per frame cache of the results.\n"
+		, arg0
 		, arg0
 		, arg0
 		, arg0
@@ -6640,4 +6803,16 @@ CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mir
 void MirvCalcs_LevelInitPreEntity()
 {
 	++g_LevelInitCount;
+
+	g_MirvCalcsFrameCache.Invalidate();
+}
+
+void MirvCalcs_AfterFrameRenderStart()
+{
+	g_MirvCalcsFrameCache.BeginFrame();
+}
+
+void MirvCalcs_AfterFrameRenderEnd()
+{
+	g_MirvCalcsFrameCache.EndFrame();
 }
@@ -257,3 +257,8 @@ extern CMirvFloatCalcs g_MirvFloatCalcs;
 
 void MirvCalcs_LevelInitPreEntity();
 
+/// <summary>Called once the entities are set up for rendering, calc results are cached from now on until MirvCalcs_AfterFrameRenderEnd.</summary>
+void MirvCalcs_AfterFrameRenderStart();
+
+void MirvCalcs_AfterFrameRenderEnd();
+
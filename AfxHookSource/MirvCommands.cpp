@@ -903,11 +903,37 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 							);
 							return;
 						}
+						else if (!_stricmp("format", cmd3))
+						{
+							if (5 <= argc)
+							{
+								char const * arg4 = args->ArgV(4);
+
+								if (!_stricmp("text", arg4))
+								{
+									g_AfxStreams.CamExportFormat_set(CamExport::F_Text);
+									return;
+								}
+								else if (!_stricmp("binary", arg4))
+								{
+									g_AfxStreams.CamExportFormat_set(CamExport::F_Binary);
+									return;
+								}
+							}
+
+							Tier0_Msg(
+								"mirv_streams record cam format text|binary - Human readable text (default) or binary (smaller and faster, can be converted with mirv_camio convert).\n"
+								"Current value: %s\n"
+								, g_AfxStreams.CamExportFormat_get() == CamExport::F_Binary ? "binary" : "text"
+							);
+							return;
+						}
 					}
 
 					Tier0_Msg(
 						"mirv_streams record cam enabled [...]\n"
 						"mirv_streams record cam fovScaling [...]\n"
+						"mirv_streams record cam format [...]\n"
 					);
 					return;
 				}
@@ -2,8 +2,6 @@
 
 #ifdef AFX_MIRV_PGL
 // Shit needs to be included for d3d9.h or we a doomed (great!):
-#include <deps/release/easywsclient/easywsclient.hpp>
-#include <deps/release/easywsclient/easywsclient.cpp>
 #pragma comment( lib, "ws2_32" )
 #include <WinSock2.h>
 #endif
@@ -19,6 +17,9 @@
 #include "csgo_GameEvents.h"
 
 #include <shared/AfxMath.h>
+#include <shared/AfxMessageQueue.h>
+#include <shared/AfxPglProtocol.h>
+#include <shared/AfxWebSocket.h>
 
 #include <math.h>
 
@@ -30,7 +31,6 @@
 #include <atomic>
 #include <mutex>
 #include <shared_mutex>
-#include <condition_variable>
 #include <chrono>
 
 extern WrpVEngineClient * g_VEngineClient;
@@ -38,8 +38,6 @@ extern WrpVEngineClient * g_VEngineClient;
 
 using namespace std::chrono_literals;
 
-using easywsclient::WebSocket;
-
 namespace MirvPgl
 {
 	const D3DVERTEXELEMENT9 g_Drawing_VBDecl_Position[] =
@@ -64,8 +62,10 @@ namespace MirvPgl
 	const int g_Drawing_nNumBatchInstance = 120;
 
 	const int m_CheckRestoreEveryTicks = 5000;
-	const int m_ThreadSleepMsIfNoData = 1;
+	/// <summary>Version each connection starts with (in "hello"), the server can switch to m_Version4 with mirv_pgl protocol.</summary>
 	const uint32_t m_Version = 2;
+	const uint32_t m_Version4 = 4;
+	const size_t m_SendRingSize = 4 * 1024 * 1024;
 
 	// Version: 3.0.3 (2017-10-31T10:37Z)
 	// 
@@ -894,124 +894,75 @@ namespace MirvPgl
 	{
 	}
 
-	class CThreadData
+	/// <summary>Position in m_SendRing that the drawing thread publishes when the frame is presented.</summary>
+	struct PublishMark
 	{
-	public:
-		void Prepare(std::vector<std::uint8_t> const & data)
-		{
-			m_IsCancelled = false;
-			m_Data = data;
-		}
+		size_t Position;
 
-		void Cancel()
-		{
-			m_IsCancelled = true;
-		}
-
-		bool IsCancelled()
-		{
-			return m_IsCancelled;
-		}
-
-		std::vector<uint8_t> & AccessData()
-		{
-			return m_Data;
-		}
-
-	private:
-		std::atomic_bool m_IsCancelled;
-		std::vector<uint8_t> m_Data;
+		/// <summary>Marks from before the last cancel are ignored.</summary>
+		unsigned int Epoch;
 	};
 
-	void DrawingThread_SupplyThreadData(CThreadData * threadData);
+	void DrawingThread_SupplyPublishMark(PublishMark const & mark);
 
-	class CSupplyThreadData_Functor
+	class CSupplyPublishMark_Functor
 		: public CAfxFunctor
 	{
 	public:
-		CSupplyThreadData_Functor(CThreadData * threadData)
-			: m_Value(threadData)
+		CSupplyPublishMark_Functor(PublishMark const & mark)
+			: m_Value(mark)
 		{
 		}
 
 		virtual void operator()()
 		{
-			DrawingThread_SupplyThreadData(m_Value);
+			DrawingThread_SupplyPublishMark(m_Value);
 		}
 
 	private:
-		CThreadData * m_Value;
+		PublishMark m_Value;
 	};
 
+	/// <summary>
+	///   Messages are serialized on the main thread directly into this queue's ring,
+	///   the drawing thread publishes them when the frame is presented and the
+	///   send thread sends them from the ring.
+	/// </summary>
+	CAfxMessageQueue m_SendQueue(m_SendRingSize);
+	CAfxByteRing & m_SendRing = m_SendQueue.GetRing();
 
-	class CThreadDataPool
-	{
-	public:
-		/// <remarks>Must only be called from main thread.</remarks>
-		std::vector<std::uint8_t> & AccessNextThreadData(void)
-		{
-			return m_Data;
-		}
-
-		/// <remarks>Must only be called from main thread.</remarks>
-		CThreadData * Acquire(void)
-		{
-			std::unique_lock<std::mutex> lock(m_ThreadDataQueueMutex);
-
-			CThreadData * threadData;
-			
-			if (m_ThreadDataAvailable.empty())
-			{
-				threadData = new CThreadData();
-			}
-			else
-			{
-				threadData = m_ThreadDataAvailable.front();
-				m_ThreadDataAvailable.pop();
-			}
-
-			threadData->Prepare(m_Data);
+	/// <summary>Encodes the messages into m_SendQueue in the connection's protocol version.</summary>
+	CAfxPglWriter m_Writer(m_SendQueue);
 
-			m_Data.clear();
+	/// <remarks>Only written on main thread (with m_DataForSendThreadMutex locked).</remarks>
+	unsigned int m_PublishEpoch = 0;
 
-			m_ThreadDataInUse.insert(threadData);
+	/// <summary>Write position of the last mark queued for the drawing thread.</summary>
+	size_t m_QueuedPosition = 0;
 
-			return threadData;
-		}
+	bool m_WarnedSendQueueFull = false;
 
-		void Return(CThreadData * threadData)
-		{
-			threadData->Cancel();
-
-			std::unique_lock<std::mutex> lock(m_ThreadDataQueueMutex);
-
-			m_ThreadDataInUse.erase(threadData);
-
-			m_ThreadDataAvailable.push(threadData);
-		}
-
-		void Cancel(void)
+	/// <returns>false if the message has been dropped.</returns>
+	bool EndMessage(void)
+	{
+		if (!m_Writer.End())
 		{
-			std::unique_lock<std::mutex> lock(m_ThreadDataQueueMutex);
-
-			for (std::set<CThreadData *>::iterator it = m_ThreadDataInUse.begin(); it != m_ThreadDataInUse.end(); ++it)
+			if (!m_WarnedSendQueueFull)
 			{
-				(*it)->Cancel();
+				m_WarnedSendQueueFull = true;
+				Tier0_Warning("MirvPgl: Send queue full, dropping messages (server too slow or not connected), see mirv_pgl queue.\n");
 			}
 
-			m_Data.clear();
+			return false;
 		}
 
-	private:
-		std::vector<std::uint8_t> m_Data;
-		std::queue<CThreadData *> m_ThreadDataAvailable;
-		std::set<CThreadData *> m_ThreadDataInUse;
-		std::mutex m_ThreadDataQueueMutex;
-	} m_ThreadDataPool;
+		return true;
+	}
 
 	bool m_WsaActive = false;
 
-	WebSocket * m_Ws = 0;
+	/// <remarks>Only the send thread deletes it (with m_WsMutex locked), Wake is called with m_WsMutex locked.</remarks>
+	CAfxWebSocket * m_Ws = 0;
 	bool m_WantWs = false;
 	std::string m_WsUrl("ws://host:port/path");
 	std::mutex m_WsMutex;
@@ -1019,98 +970,39 @@ namespace MirvPgl
 	std::list<std::string> m_Commands;
 	std::mutex m_CommandsMutex;
 
-	std::vector<uint8_t> m_SendThreadTempData;
-
-	std::vector<uint8_t> m_DataForSendThread;
-	std::condition_variable m_DataForSendThreadAvailableCondition;
 	std::mutex m_DataForSendThreadMutex;
 	bool m_InTransaction;
 
 	bool m_DataActive = false;
 
 	std::thread * m_Thread = 0;
-	bool m_WantClose = false;
+	std::atomic_bool m_WantClose(false);
 
 	DWORD m_LastCheckRestoreTick = 0;
 
-	CThreadData * m_DrawingThread_ThreadData = 0;
+	bool m_DrawingThread_HasPublishMark = false;
+	PublishMark m_DrawingThread_PublishMark;
 
 	std::string m_CurrentLevel;
 
-	void AppendCString(char const * cstr, std::vector<uint8_t> &outVec)
-	{
-		std::string str(cstr);
-		outVec.insert(outVec.end(), str.begin(), str.end());
-		outVec.push_back(static_cast<uint8_t>('\0'));
-	}
-
-	void AppendFloat(float_t value, std::vector<uint8_t> &outVec)
+	/// <summary>Discards the data that has not been published yet.</summary>
+	void CancelUnpublished(void)
 	{
-		uint8_t data[sizeof(value)];
-		memcpy(&(data[0]), &value, sizeof(value));
+		std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
 
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
-	}
-
-	void AppendInt32(int32_t value, std::vector<uint8_t> &outVec)
-	{
-		uint8_t data[sizeof(value)];
-		memcpy(&(data[0]), &value, sizeof(value));
-
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
-	}
-
-	void AppendInt16(int16_t value, std::vector<uint8_t> &outVec)
-	{
-		uint8_t data[sizeof(value)];
-		memcpy(&(data[0]), &value, sizeof(value));
-
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
-	}
-
-	void AppendByte(uint8_t value, std::vector<uint8_t> &outVec)
-	{
-		outVec.push_back(value);
-	}
-
-	void AppendBoolean(uint8_t value, std::vector<uint8_t> &outVec)
-	{
-		AppendByte(value ? 1 : 0, outVec);
+		++m_PublishEpoch;
+		m_SendRing.Truncate(m_SendRing.GetPublishedPosition());
+		m_QueuedPosition = m_SendRing.GetWritePosition();
 	}
 
-	void AppendUInt64(uint64_t value, std::vector<uint8_t> &outVec)
+	/// <summary>Discards all data, the send thread must not be running.</summary>
+	void ResetSendRing(void)
 	{
-		uint8_t data[sizeof(value)];
-		memcpy(&(data[0]), &value, sizeof(value));
+		std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
 
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
-	}
-
-	void AppendHello(std::vector<uint8_t> &outVec)
-	{
-		uint8_t data[1 * sizeof(uint32_t)];
-		uint32_t version = m_Version;
-
-		AppendCString("hello", outVec);
-		memcpy(&(data[0 * sizeof(uint32_t)]), &version, sizeof(uint32_t));
-
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
-	}
-
-	void AppendCamData(CamData const camData, std::vector<uint8_t> &outVec)
-	{
-		uint8_t data[8 * sizeof(float)];
-
-		memcpy(&(data[0 * sizeof(float)]), &camData.Time, sizeof(float));
-		memcpy(&(data[1 * sizeof(float)]), &camData.XPosition, sizeof(float));
-		memcpy(&(data[2 * sizeof(float)]), &camData.YPosition, sizeof(float));
-		memcpy(&(data[3 * sizeof(float)]), &camData.ZPosition, sizeof(float));
-		memcpy(&(data[4 * sizeof(float)]), &camData.XRotation, sizeof(float));
-		memcpy(&(data[5 * sizeof(float)]), &camData.YRotation, sizeof(float));
-		memcpy(&(data[6 * sizeof(float)]), &camData.ZRotation, sizeof(float));
-		memcpy(&(data[7 * sizeof(float)]), &camData.Fov, sizeof(float));
-
-		outVec.insert(outVec.end(), std::begin(data), std::end(data));
+		++m_PublishEpoch;
+		m_SendQueue.Reset();
+		m_QueuedPosition = 0;
 	}
 
 	void Recv_String(const std::string & message)
@@ -1118,15 +1010,15 @@ namespace MirvPgl
 		// lul
 	}
 
-	void Recv_Bytes(const std::vector<uint8_t>& message)
+	void Recv_Bytes(uint8_t const * messageBegin, uint8_t const * messageEnd)
 	{
-		std::vector<uint8_t>::const_iterator itBegin = message.begin();
+		uint8_t const * itBegin = messageBegin;
 
-		while (itBegin != message.end())
+		while (itBegin != messageEnd)
 		{
-			std::vector<uint8_t>::const_iterator itDelim = message.end();
+			uint8_t const * itDelim = messageEnd;
 
-			for (std::vector<uint8_t>::const_iterator it = itBegin; it != message.end(); ++it)
+			for (uint8_t const * it = itBegin; it != messageEnd; ++it)
 			{
 				if ((uint8_t)'\0' == *it)
 				{
@@ -1135,7 +1027,7 @@ namespace MirvPgl
 				}
 			}
 
-			if (message.end() != itDelim && itBegin != itDelim)
+			if (messageEnd != itDelim && itBegin != itDelim)
 			{
 				std::string strCode(itBegin, itDelim);
 
@@ -1145,12 +1037,12 @@ namespace MirvPgl
 				{
 					std::unique_lock<std::mutex> lock(m_CommandsMutex);
 
-					std::vector<uint8_t>::const_iterator itCmdStart = itDelim + 1;
-					std::vector<uint8_t>::const_iterator itCmdEnd = itCmdStart;
+					uint8_t const * itCmdStart = itDelim + 1;
+					uint8_t const * itCmdEnd = itCmdStart;
 
 					bool foundDelim = false;
 
-					for (std::vector<uint8_t>::const_iterator it = itCmdStart; it != message.end(); ++it)
+					for (uint8_t const * it = itCmdStart; it != messageEnd; ++it)
 					{
 						if ((uint8_t)'\0' == *it)
 						{
@@ -1187,16 +1079,32 @@ namespace MirvPgl
 		}
 	}
 
+	class CWsReceiver : public IAfxWebSocketReceiver
+	{
+	public:
+		virtual void OnBinaryMessage(unsigned char const * data, size_t size) override
+		{
+			Recv_Bytes(data, data + size);
+		}
+	};
+
+	void WakeThread(void)
+	{
+		std::unique_lock<std::mutex> wsLock(m_WsMutex);
+
+		if (m_Ws) m_Ws->Wake();
+	}
+
 	void Thread()
 	{
-		m_SendThreadTempData.clear();
+		CWsReceiver receiver;
 
 		while (true)
 		{
 			{
 				std::unique_lock<std::mutex> wsLock(m_WsMutex);
 
-				if (WebSocket::CLOSED == m_Ws->getReadyState())
+				if (CAfxWebSocket::State_Closed == m_Ws->GetState())
 				{
 					delete m_Ws;
 					m_Ws = 0;
@@ -1204,30 +1112,35 @@ namespace MirvPgl
 				}
 			}
 
-			m_Ws->poll();
-
-			// this would eat our shit: m_Ws->dispatch(Recv_String); 
-			m_Ws->dispatchBinary(Recv_Bytes);
-
-			std::unique_lock<std::mutex> dataLock(m_DataForSendThreadMutex);
-
-			m_DataForSendThreadAvailableCondition.wait_for(dataLock, m_ThreadSleepMsIfNoData * 1ms, [] { return !m_DataForSendThread.empty() || m_WantClose; }); // if we don't need to send data, we are a bit lazy in order to save some CPU. Of course this assumes, that the data we get from network can wait that long ;)
-
-			if (!m_DataForSendThread.empty())
+			if (m_WantClose)
 			{
-				m_SendThreadTempData = std::move(m_DataForSendThread);
-				m_DataForSendThread.clear();
-				dataLock.unlock();
+				m_Ws->Close();
+			}
+			else
+			{
+				unsigned char const * data[2];
+				size_t size[2];
+				size_t readable = m_SendRing.GetReadable(data, size);
+
+				// Copied masked into the send buffer straight from the ring.
+				// If the server is behind, the socket refuses it and the data
+				// stays in the ring (until the socket is writable again), where
+				// the queue's limits (maxBytes, camMaxBacklog) can see it:
+				if (0 < readable && m_Ws->SendBinary(data, size, 2))
+				{
+					m_SendRing.Consume(readable);
+				}
+			}
 
-				m_Ws->sendBinary(m_SendThreadTempData);
+			{
+				// Locked, because Poll can close the socket that WakeThread uses:
+				std::unique_lock<std::mutex> wsLock(m_WsMutex);
 
-				m_SendThreadTempData.clear();
+				m_Ws->Poll(&receiver);
 			}
-			else
-				dataLock.unlock();
 
-			if (m_WantClose)
-				m_Ws->close();
+			// Blocks (without using CPU) until there is network activity or DrawingThread_UnleashData / EndThread wake us:
+			m_Ws->Wait();
 		}
 	}
 
@@ -1237,7 +1150,7 @@ namespace MirvPgl
 		{
 			m_WantClose = true;
 			
-			m_DataForSendThreadAvailableCondition.notify_one();
+			WakeThread();
 
 			m_Thread->join();
 			
@@ -1288,6 +1201,49 @@ namespace MirvPgl
 	}
 
 	void Restart_MirvPglGameEventSerializer();
+	void ForgetKnownGameEvents();
+
+	bool m_Deflate = false;
+
+	/// <summary>Publishes all data right away (instead of when the frame is presented), so that CancelUnpublished won't discard it.</summary>
+	void PublishNow(void)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+
+			++m_PublishEpoch; // The pending marks are behind.
+			m_SendRing.Publish(m_SendRing.GetWritePosition());
+			m_QueuedPosition = m_SendRing.GetWritePosition();
+		}
+
+		WakeThread();
+	}
+
+	bool Protocol_set(uint32_t version)
+	{
+		if (!m_WantWs || (m_Version != version && m_Version4 != version))
+			return false;
+
+		// The "hello" is still in the current version, the following messages are in the new one:
+		m_Writer.Begin();
+		if (!m_Writer.WriteHelloAndEnd(version))
+		{
+			Tier0_Warning("MirvPgl: Send queue full, could not switch protocol.\n");
+			return false;
+		}
+
+		// The server's table of descriptions starts over with the hello, too:
+		ForgetKnownGameEvents();
+
+		PublishNow();
+
+		return true;
+	}
+
+	uint32_t Protocol_get(void)
+	{
+		return m_Writer.GetVersion();
+	}
 
 	void Start()
 	{
@@ -1297,11 +1253,26 @@ namespace MirvPgl
 		{
 			m_WantWs = true;
 
-			m_Ws = WebSocket::from_url(m_WsUrl);
+			CAfxWebSocket * ws = new CAfxWebSocket();
+			ws->SetDeflate(m_Deflate);
 
-			if (0 != m_Ws)
+			if (!ws->Open(m_WsUrl.c_str()))
 			{
-				AppendHello(m_ThreadDataPool.AccessNextThreadData());
+				delete ws;
+			}
+			else
+			{
+				{
+					std::unique_lock<std::mutex> wsLock(m_WsMutex);
+
+					m_Ws = ws;
+				}
+
+				m_WarnedSendQueueFull = false;
+
+				m_Writer.SetVersion(m_Version);
+				m_Writer.Begin();
+				m_Writer.WriteHelloAndEnd(m_Version);
 
 				Restart_MirvPglGameEventSerializer();
 
@@ -1313,11 +1284,12 @@ namespace MirvPgl
 	void Stop()
 	{
 		m_DataActive = false;
-		m_ThreadDataPool.Cancel();
-		m_ThreadDataPool.AccessNextThreadData().clear();
+		CancelUnpublished();
 
 		EndThread();
 
+		ResetSendRing();
+
 		m_WantWs = false;
 	}
 
@@ -1334,15 +1306,16 @@ namespace MirvPgl
 		{
 			m_DataActive = true;
 
-			std::vector<uint8_t> & data = m_ThreadDataPool.AccessNextThreadData();
-
-			AppendCString("dataStart", data);
+			m_Writer.Begin();
+			m_Writer.WriteMessage(AfxPglMessage_DataStart);
+			EndMessage();
 
 			if (!m_CurrentLevel.empty())
 			{
-
-				AppendCString("levelInit", data);
-				AppendCString(m_CurrentLevel.c_str(), data);
+				m_Writer.Begin();
+				m_Writer.WriteMessage(AfxPglMessage_LevelInit);
+				m_Writer.WriteCString(m_CurrentLevel.c_str());
+				EndMessage();
 			}
 		}
 	}
@@ -1353,12 +1326,18 @@ namespace MirvPgl
 		{
 			m_DataActive = false;
 
-			m_ThreadDataPool.Cancel();
+			CancelUnpublished();
 
 			if (m_WantWs)
 			{
-				AppendCString("dataStop", m_ThreadDataPool.AccessNextThreadData());
+				m_Writer.Begin();
+				m_Writer.WriteMessage(AfxPglMessage_DataStop);
+				EndMessage();
 			}
+
+			// The server forgets them with "dataStop" and cancelled messages might have carried them:
+			m_Writer.Reset();
+			ForgetKnownGameEvents();
 		}
 	}
 
@@ -1397,10 +1376,43 @@ namespace MirvPgl
 		}
 	}
 
+	void QueuePublishMark(void)
+	{
+		PublishMark mark;
+
+		mark.Position = m_QueuedPosition = m_SendRing.GetWritePosition();
+		mark.Epoch = m_PublishEpoch;
+
+		QueueOrExecute(GetCurrentContext()->GetOrg(), new CAfxLeafExecute_Functor(new CSupplyPublishMark_Functor(mark)));
+	}
+
 	void QueueThreadDataForDrawingThread(void)
 	{
-		if(m_DataActive || !m_ThreadDataPool.AccessNextThreadData().empty())
-			QueueOrExecute(GetCurrentContext()->GetOrg(), new CAfxLeafExecute_Functor(new CSupplyThreadData_Functor(m_ThreadDataPool.Acquire())));
+		if (m_SendRing.GetWritePosition() != m_QueuedPosition)
+			QueuePublishMark();
+	}
+
+	void SupplyCamData(CamData const & camData)
+	{
+		if (!m_Writer.BeginLatest(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count()))
+			return; // Coalesced, the next one will carry the latest data.
+
+		float data[8] = {
+			camData.Time,
+			camData.XPosition,
+			camData.YPosition,
+			camData.ZPosition,
+			camData.XRotation,
+			camData.YRotation,
+			camData.ZRotation,
+			camData.Fov
+		};
+
+		m_Writer.WriteMessage(AfxPglMessage_Cam);
+		m_Writer.WriteCam(data);
+		EndMessage();
+
+		QueuePublishMark();
 	}
 
 	void QueueDrawing(CamData const & camData, int width, int height)
@@ -1415,10 +1427,10 @@ namespace MirvPgl
 		if (!m_DataActive)
 			return;
 
-		std::vector<uint8_t> & data = m_ThreadDataPool.AccessNextThreadData();
-
-		AppendCString("levelInit", data);
-		AppendCString(mapName, data);
+		m_Writer.Begin();
+		m_Writer.WriteMessage(AfxPglMessage_LevelInit);
+		m_Writer.WriteCString(mapName);
+		EndMessage();
 	}
 
 	void SupplyLevelShutdown()
@@ -1428,7 +1440,9 @@ namespace MirvPgl
 		if (!m_DataActive)
 			return;
 
-		AppendCString("levelShutdown", m_ThreadDataPool.AccessNextThreadData());
+		m_Writer.Begin();
+		m_Writer.WriteMessage(AfxPglMessage_LevelShutdown);
+		EndMessage();
 	}
 
 	void ExecuteQueuedCommands()
@@ -1447,17 +1461,11 @@ namespace MirvPgl
 		}
 	}
 
-	void DrawingThread_SupplyThreadData(CThreadData * threadData)
+	void DrawingThread_SupplyPublishMark(PublishMark const & mark)
 	{
-		if (m_DrawingThread_ThreadData)
-		{
-			// should not happen.
-			Assert(0);
-
-			m_ThreadDataPool.Return(m_DrawingThread_ThreadData);
-		}
-
-		m_DrawingThread_ThreadData = threadData;
+		// A later mark (i.e. from the cam of another view) includes the earlier ones:
+		m_DrawingThread_PublishMark = mark;
+		m_DrawingThread_HasPublishMark = true;
 	}
 
 	void D3D9_BeginDevice(IDirect3DDevice9 * device)
@@ -1475,34 +1483,20 @@ namespace MirvPgl
 		CDrawing_Functor::D3D9_Reset();
 	}
 
-	void DrawingThread_SupplyCamData(CamData const & camData)
-	{
-		if(m_DrawingThread_ThreadData)
-		{
-			std::vector<uint8_t> & data = m_DrawingThread_ThreadData->AccessData();
-
-			AppendCString("cam", data);
-			AppendCamData(camData, data);
-		}
-	}
-
 	void DrawingThread_UnleashData()
 	{
-		if (m_DrawingThread_ThreadData && !m_DrawingThread_ThreadData->IsCancelled())
+		if (m_DrawingThread_HasPublishMark)
 		{
-			std::vector<uint8_t> & data = m_DrawingThread_ThreadData->AccessData();
+			m_DrawingThread_HasPublishMark = false;
 
 			std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
 
-			m_DataForSendThread.insert(m_DataForSendThread.end(), data.begin(), data.end());
+			if (m_DrawingThread_PublishMark.Epoch == m_PublishEpoch)
+				m_SendRing.Publish(m_DrawingThread_PublishMark.Position);
 
 			lock.unlock();
 
-			m_DataForSendThreadAvailableCondition.notify_one();
-
-			m_ThreadDataPool.Return(m_DrawingThread_ThreadData);
-
-			m_DrawingThread_ThreadData = 0;
+			WakeThread();
 		}
 	}
 
@@ -1514,55 +1508,55 @@ namespace MirvPgl
 			if (!m_WantWs)
 				return false;
 
-			m_Data = &(m_ThreadDataPool.AccessNextThreadData());
-
-			AppendCString("gameEvent", *m_Data);
+			m_Writer.Begin();
+			m_Writer.WriteMessage(AfxPglMessage_GameEvent);
 
 			return true;
 		}
 
 		virtual void EndSerialize() override
 		{
-
+			if (!EndMessage())
+			{
+				// The server might not know the event's description now:
+				ForgetKnownEvents();
+			}
 		}
 
 		virtual void WriteCString(const char * value) override
 		{
-			AppendCString(value, *m_Data);
+			m_Writer.WriteCString(value);
 		}
 
 		virtual void WriteFloat(float value) override
 		{
-			AppendFloat(value, *m_Data);
+			m_Writer.WriteFloat(value);
 		}
 
 		virtual void WriteLong(long value) override
 		{
-			AppendInt32(value, *m_Data);
+			m_Writer.WriteInt32(value);
 		}
 
 		virtual void WriteShort(short value) override
 		{
-			AppendInt16(value, *m_Data);
+			m_Writer.WriteInt16(value);
 		}
 
 		virtual void WriteByte(char value)
 		{
-			AppendByte((uint8_t)value, *m_Data);
+			m_Writer.WriteByte((uint8_t)value);
 		}
 
 		virtual void WriteBoolean(bool value)
 		{
-			AppendBoolean(value, *m_Data);
+			m_Writer.WriteBoolean(value);
 		}
 
 		virtual void WriteUInt64(unsigned __int64 value)
 		{
-			AppendUInt64(value, *m_Data);
+			m_Writer.WriteUInt64(value);
 		}
-
-	private:
-		std::vector<uint8_t> * m_Data;
 	} g_MirvPglGameEventSerializer;
 
 	void Restart_MirvPglGameEventSerializer()
@@ -1571,6 +1565,11 @@ namespace MirvPgl
 		g_MirvPglGameEventSerializer.Restart();
 		g_MirvPglGameEventSerializer.SetUseGameEventCache(false);
 	}
+
+	void ForgetKnownGameEvents()
+	{
+		g_MirvPglGameEventSerializer.ForgetKnownEvents();
+	}
 }
 
 CON_COMMAND(mirv_pgl, "PGL")
@@ -1622,6 +1621,124 @@ CON_COMMAND(mirv_pgl, "PGL")
 			);
 			return;
 		}
+		else if (0 == _stricmp("protocol", cmd1))
+		{
+			if (3 <= argc)
+			{
+				if (!MirvPgl::Protocol_set((uint32_t)atoi(args->ArgV(2))))
+					Tier0_Warning("Error: Not started or unsupported version.\n");
+				return;
+			}
+
+			Tier0_Msg(
+				"mirv_pgl protocol 2|4 - Switch the current connection to the given protocol version, meant to be exec-ed by the server in response to \"hello\" (each connection starts with version 2).\n"
+				"Current value: %u\n"
+				, MirvPgl::Protocol_get()
+			);
+			return;
+		}
+		else if (0 == _stricmp("deflate", cmd1))
+		{
+			if (3 <= argc)
+			{
+				MirvPgl::m_Deflate = 0 != atoi(args->ArgV(2));
+				return;
+			}
+
+			Tier0_Msg(
+				"mirv_pgl deflate 0|1 - Offer compression (permessage-deflate) to the server with the next start, it is used if the server accepts it.\n"
+				"Current value: %i\n"
+				, MirvPgl::m_Deflate ? 1 : 0
+			);
+			return;
+		}
+		else if (0 == _stricmp("queue", cmd1))
+		{
+			if (3 <= argc)
+			{
+				char const * cmd2 = args->ArgV(2);
+
+				if (0 == _stricmp("maxBytes", cmd2))
+				{
+					if (4 <= argc)
+					{
+						MirvPgl::m_SendQueue.SetMaxBytes((size_t)atoi(args->ArgV(3)));
+						return;
+					}
+
+					Tier0_Msg(
+						"mirv_pgl queue maxBytes <iBytes> - Messages that don't fit anymore are dropped (limited to %u).\n"
+						"Current value: %u\n"
+						, (unsigned int)MirvPgl::m_SendRing.GetCapacity()
+						, (unsigned int)MirvPgl::m_SendQueue.GetMaxBytes()
+					);
+					return;
+				}
+				else if (0 == _stricmp("camsPerSecond", cmd2))
+				{
+					if (4 <= argc)
+					{
+						MirvPgl::m_SendQueue.SetMaxLatestPerSecond(atof(args->ArgV(3)));
+						return;
+					}
+
+					Tier0_Msg(
+						"mirv_pgl queue camsPerSecond <fMax> - Maximum number of \"cam\" messages per second, the ones in between are skipped (0 = no limit).\n"
+						"Current value: %f\n"
+						, MirvPgl::m_SendQueue.GetMaxLatestPerSecond()
+					);
+					return;
+				}
+				else if (0 == _stricmp("camMaxBacklog", cmd2))
+				{
+					if (4 <= argc)
+					{
+						MirvPgl::m_SendQueue.SetMaxLatestBacklog((size_t)atoi(args->ArgV(3)));
+						return;
+					}
+
+					Tier0_Msg(
+						"mirv_pgl queue camMaxBacklog <iBytes> - \"cam\" messages are skipped while more than this is queued (the server is behind), so the server gets the latest instead of old ones (0 = never skip).\n"
+						"Current value: %u\n"
+						, (unsigned int)MirvPgl::m_SendQueue.GetMaxLatestBacklog()
+					);
+					return;
+				}
+				else if (0 == _stricmp("stats", cmd2))
+				{
+					AfxMessageQueueStats const & stats = MirvPgl::m_SendQueue.GetStats();
+
+					Tier0_Msg(
+						"Messages queued: %llu (%llu bytes)\n"
+						"Messages dropped (queue full): %llu\n"
+						"\"cam\" messages skipped (coalesced): %llu\n"
+						"Maximum backlog: %u bytes\n"
+						"Current backlog: %u bytes\n"
+						, stats.Messages
+						, stats.Bytes
+						, stats.Dropped
+						, stats.Coalesced
+						, (unsigned int)stats.MaxBacklog
+						, (unsigned int)MirvPgl::m_SendRing.GetUsed()
+					);
+					return;
+				}
+				else if (0 == _stricmp("resetStats", cmd2))
+				{
+					MirvPgl::m_SendQueue.ResetStats();
+					return;
+				}
+			}
+
+			Tier0_Msg(
+				"mirv_pgl queue maxBytes [...] - Bound of the send queue.\n"
+				"mirv_pgl queue camsPerSecond [...] - Rate limit for \"cam\" messages.\n"
+				"mirv_pgl queue camMaxBacklog [...] - Skip \"cam\" messages while the server is behind.\n"
+				"mirv_pgl queue stats - Print counters.\n"
+				"mirv_pgl queue resetStats - Reset counters.\n"
+			);
+			return;
+		}
 		else if (0 == _stricmp("draw", cmd1))
 		{
 			CSubWrpCommandArgs subArgs(args, 2);
@@ -1787,6 +1904,9 @@ CON_COMMAND(mirv_pgl, "PGL")
 		"mirv_pgl dataStart - Start sending data.\n"
 		"mirv_pgl dataStop - Stop sending data.\n"
 		"mirv_pgl url [...] - Set url to use with start.\n"
+		"mirv_pgl protocol [...] - Switch protocol version.\n"
+		"mirv_pgl deflate [...] - Compression.\n"
+		"mirv_pgl queue [...] - Send queue policy (throttling) and counters.\n"
 		"mirv_pgl draw [...] - Controls on-screen data drawing.\n"
 		"mirv_pgl events [...] - Control game event data (disabled by default, requires start with version 3 or newer).\n"
 	);
@@ -4,6 +4,13 @@
 
 /*
 
+Changes from version 2.0.3 to version 4:
+- Added the more compact protocol version 4 (see "Version 4" below), the server has to request it, so older servers keep working:
+  Each connection still starts with "hello" version 2, a server that supports version 4 answers with exec "mirv_pgl protocol 4",
+  which makes the client send a "hello" with version 4 (still in version 2 format), all following messages are in version 4 then.
+- Added optional compression: "mirv_pgl deflate 1" makes the client offer the permessage-deflate WebSocket extension (RFC 7692),
+  it is used if the server accepts it (i.e. the ws package with perMessageDeflate enabled, like misc/mirv_pgl_test/server.js does).
+
 Changes from version 2.0.2 to version 2.0.3:
 - The messages "transBegin" and "transEnd" have been added, so that the server can group messsage that must be processed together (in order to avoid side effects).
 - Added "gameEvent" message, for decoding it we recommend to have a look at the sample code in misc/mirv_pgl_test/server.js,
@@ -35,7 +42,7 @@ Tip1:
 Tip2:
   1) With "mirv_cvar_hack host_sleep x" you can make the game sleep x milliseconds, this is great for throttling, since you can enforce a maximum FPS this way (any value you want).
   2) Not as useful but should be mentioned: With "mirv_cvar_hack fps_max 30" you can throttle the game down as low as 30 FPS.
-  This is not exactly the throttling that you might have thought off, but this should be pretty okay, because that way you can be sure that data for each frame is sent (nothing dropped).
+  This way you can be sure that data for each frame is sent (nothing dropped), otherwise see "Throttling" below.
 
 
 Changes from version 0 to version 1:
@@ -49,7 +56,18 @@ Usage:
 
 
 It is a good idea to run with the FPS limited (either by vsync or by fps_max).
-Otherwise the network / server will be flooded with "cam" messages or the send buffer will overflow eventually, since there is currently no throttling at all implemented so far.
+Otherwise the network / server will be flooded with "cam" messages or the send queue will overflow eventually, unless you configure throttling (see below).
+
+
+Throttling:
+
+mirv_pgl queue maxBytes <iBytes> - Bound of the send queue (default and maximum 4 MiB), messages that don't fit are dropped (a warning is printed once per connection).
+mirv_pgl queue camsPerSecond <fMax> - Maximum rate of "cam" messages (default 0 = no limit).
+mirv_pgl queue camMaxBacklog <iBytes> - Skip "cam" messages while more than this is queued, i.e. because the server is behind (default 0 = never skip).
+mirv_pgl queue stats - Prints the counters (messages / bytes queued, dropped, skipped, backlog).
+
+Skipped "cam" messages are coalesced: The next "cam" that is sent carries the latest data, the server just gets fewer of them.
+All other messages are lossless, they are only dropped when the queue is full.
 
 
 Console commands:
@@ -57,6 +75,8 @@ Console commands:
 mirv_pgl url [<url>] - Set the server's URL, example: mirv_pgl url "ws://localhost:31337/mirv"
 mirv_pgl start - (Re-)Starts connectinion to server.
 mirv_pgl stop - Stops connection to server.
+mirv_pgl protocol 2|4 - Switches the current connection's protocol version (sends "hello"), meant to be exec-ed by the server.
+mirv_pgl deflate 0|1 - Offer compression (permessage-deflate) with the next start (default 0).
 
 It is safe to exec mirv_pgl stop from the server, but how will you reconnect then?
 
@@ -88,9 +108,10 @@ Messages sent to server:
 Purpose:
   Is sent upon (re)-connecting.
   If received with unexpected version, server should close the connection.
+  In version 4 it can be sent again (if the server execs mirv_pgl protocol), everything after it is in the new version.
 Format:
   CString cmd = "hello"
-  UInt32 version = 3;
+  UInt32 version = 2; (or 4)
 
 "dataStart"
 Purpose:
@@ -137,6 +158,24 @@ Format:
   Float fov;
 
 
+Version 4:
+  All messages sent to the server have the same content, but are encoded differently:
+  - The CString cmd is replaced by a VarUInt opcode:
+    0 = "hello" (followed by UInt32 version), 1 = "dataStart", 2 = "dataStop", 3 = "levelInit", 4 = "levelShutdown", 5 = "cam", 6 = "gameEvent"
+  - VarUInt is an unsigned integer in 7 bit groups, least significant first, the high bit is set on all but the last byte.
+  - Int32 and Int16 (i.e. in "gameEvent") are VarUInt zig-zag encoded: (n << 1) ^ (n >> 31), so small negative numbers stay small.
+  - UInt64 is VarUInt.
+  - Float, Byte and Boolean are unchanged.
+  - A CString is a VarUInt reference to a table of interned strings:
+    0 = a new string follows as CString, it is appended to the table (index 0, 1, 2, ...),
+    1 = a CString follows, that is not added to the table (the table is full or the string is long),
+    n >= 2 = the string at index n - 2 of the table.
+  - "cam" has 8 VarUInt instead of the 8 Floats: The bits of each Float xor-ed with the bits of the same Float of the previous "cam"
+    (0 for the first one), so unchanged values are 1 byte.
+  - The table of interned strings and the previous "cam" are cleared on "hello" and on "dataStop".
+  - Since "hello" also starts over the game event descriptions, they are sent again as well.
+
+
 Messages received:
 
 "exec"
@@ -158,7 +197,6 @@ Purpose:
 
 
 Ideas for the future:
-- Implement throttling.
 - Implement black image command with feedback when presented.
 - Implement white image command with feedback when presented.
 - Implement optional time-code (float) graphic overlay at top of screen, this would allow syncing the images and the camdata on remote PC perfectly (as long as turned on).
@@ -185,8 +223,6 @@ namespace MirvPgl
 		CamData(float time, float xPosition, float yPosition, float zPosition, float xRotation, float yRotation, float zRotation, float fov);
 	};
 
-	class CThreadData;
-
 	// On Main thread:
 
 	void Init();
@@ -207,6 +243,7 @@ namespace MirvPgl
 	void CheckStartedAndRestoreIfDown();
 	void ExecuteQueuedCommands();
 	void QueueThreadDataForDrawingThread(void);
+	void SupplyCamData(CamData const & camData);
 	void QueueDrawing(CamData const & camData, int width, int height);
 
 	void SupplyLevelInit(char const * mapName);
@@ -218,8 +255,6 @@ namespace MirvPgl
 	void D3D9_EndDevice();
 	void D3D9_Reset();
 
-	void DrawingThread_SupplyCamData(CamData const & camData);
-
 	void DrawingThread_UnleashData();
 }
 
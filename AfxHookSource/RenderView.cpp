@@ -578,7 +578,8 @@ void Hook_VClient_RenderView::Console_CamIO(IWrpCommandArgs * args)
 			{
 				char const * cmd2 = args->ArgV(2);
 
-				if (0 == _stricmp("start", cmd2) && 5 <= argc)
+				if (0 == _stricmp("start", cmd2) && 5 <= argc
+					&& (argc < 6 || 0 == _stricmp("text", args->ArgV(5)) || 0 == _stricmp("binary", args->ArgV(5))))
 				{
 					if (0 != m_CamExport)
 					{
@@ -590,7 +591,10 @@ void Hook_VClient_RenderView::Console_CamIO(IWrpCommandArgs * args)
 
 					if (UTF8StringToWideString(args->ArgV(3), fileName))
 					{
-						m_CamExport = new CamExport(fileName.c_str(), 0 == _stricmp("alienSwarm", args->ArgV(4)) ? CamExport::SF_AlienSwarm : CamExport::SF_None);
+						CamIO::Format format = 6 <= argc && 0 == _stricmp("binary", args->ArgV(5)) ? CamIO::F_Binary : CamIO::F_Text;
+
+						m_CamExport = new CamExport(fileName.c_str(), 0 == _stricmp("alienSwarm", args->ArgV(4)) ? CamExport::SF_AlienSwarm : CamExport::SF_None, format);
+						if (m_CamExport->IsBad()) Tier0_Warning("Error: Can not open \"%s\" for writing.\n", args->ArgV(3));
 					}
 					else
 						Tier0_Warning("Error: Can not convert \"%s\" from UTF-8 to WideString.\n", args->ArgV(3));
@@ -613,13 +617,34 @@ void Hook_VClient_RenderView::Console_CamIO(IWrpCommandArgs * args)
 			}
 
 			Tier0_Msg(
-				"%s export start <fileName> <fovScaling> - Starts exporting to file <fileName>, <fovScaling> can be \"none\" for engine FOV or \"alienSwarm\" for scaling like Alien Swarm SDK (i.e. CS:GO).\n"
+				"%s export start <fileName> <fovScaling> [text|binary] - Starts exporting to file <fileName>, <fovScaling> can be \"none\" for engine FOV or \"alienSwarm\" for scaling like Alien Swarm SDK (i.e. CS:GO), the format is text (default) or binary (smaller and faster).\n"
 				"%s export end - Stops exporting.\n"
 				, cmd0
 				, cmd0
 			);
 			return;
 		}
+		else if (0 == _stricmp("convert", cmd1))
+		{
+			if (5 <= argc && (0 == _stricmp("text", args->ArgV(4)) || 0 == _stricmp("binary", args->ArgV(4))))
+			{
+				std::wstring outFileName(L"");
+				CamIO::Format format = 0 == _stricmp("binary", args->ArgV(4)) ? CamIO::F_Binary : CamIO::F_Text;
+
+				if (!UTF8StringToWideString(args->ArgV(3), outFileName))
+					Tier0_Warning("Error: Can not convert \"%s\" from UTF-8 to WideString.\n", args->ArgV(3));
+				else if (!CamIO::Convert(args->ArgV(2), outFileName.c_str(), format))
+					Tier0_Warning("Error: Converting \"%s\" to \"%s\" failed.\n", args->ArgV(2), args->ArgV(3));
+
+				return;
+			}
+
+			Tier0_Msg(
+				"%s convert <inFileName> <outFileName> text|binary - Converts a cam file (text or binary) to the given format.\n"
+				, cmd0
+			);
+			return;
+		}
 		else if (0 == _stricmp("import", cmd1))
 		{
 			if (3 <= argc)
@@ -648,7 +673,7 @@ void Hook_VClient_RenderView::Console_CamIO(IWrpCommandArgs * args)
 			}
 
 			Tier0_Msg(
-				"%s import start <fileName> - Starts importing cam from file <fileName>.\n"
+				"%s import start <fileName> - Starts importing cam from file <fileName> (text or binary format).\n"
 				"%s import end - Stops importing.\n"
 				, cmd0
 				, cmd0
@@ -660,6 +685,8 @@ void Hook_VClient_RenderView::Console_CamIO(IWrpCommandArgs * args)
 	Tier0_Msg(
 		"%s export [...] - Controls export of new camera motion data.\n"
 		"%s import [...] - Controls import of new camera motion data.\n"
+		"%s convert [...] - Converts between text and binary format.\n"
+		, cmd0
 		, cmd0
 		, cmd0
 	);
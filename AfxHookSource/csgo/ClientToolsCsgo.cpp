@@ -390,8 +390,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntity((int)hEntity);
 				{
 					SOURCESDK::CSGO::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::CSGO::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -421,7 +420,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 						if (pBaseAnimatingRs->m_pBoneList)
 						{
 							bool hasError = false;
-							Write(pBaseAnimatingRs->m_pBoneList);
+							Write((int)hEntity, pBaseAnimatingRs->m_pBoneList);
 						}
 					}
 				}
@@ -444,6 +443,8 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 				bool viewModel = msg->GetBool("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -454,8 +455,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -603,9 +603,9 @@ float CClientToolsCsgo::ScaleFov(int width, int height, float fov)
 	return (float)AlienSwarm_FovScaling(g_Hook_VClient_RenderView.LastWidth, g_Hook_VClient_RenderView.LastHeight, g_Hook_VClient_RenderView.LastCameraFov);
 }
 
-void CClientToolsCsgo::Write(SOURCESDK::CSGO::CBoneList const * value)
+void CClientToolsCsgo::Write(int entityHandle, SOURCESDK::CSGO::CBoneList const * value)
 {
-	Write((int)value->m_nBones);
+	BeginBones(entityHandle, (int)value->m_nBones);
 
 	for (int i = 0; i < value->m_nBones; ++i)
 	{
@@ -627,8 +627,7 @@ void CClientToolsCsgo::Write(SOURCESDK::CSGO::CBoneList const * value)
 			);
 		}
 
-		Write(value->m_vecPos[i]);
-		Write(value->m_quatRot[i]);
+		WriteBone(value->m_vecPos[i], value->m_quatRot[i]);
 	}
 }
 
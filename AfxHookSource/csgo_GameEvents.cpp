@@ -36,6 +36,96 @@ enum CsgoGameEventKeyType
 	CsgoGameEventKeyType_Uint64 = 7
 };
 
+void CAfxGameEventListener::FireEvent(SOURCESDK::CSGO::CGameEvent * gameEvent)
+{
+	if (nullptr == gameEvent) return;
+
+	SOURCESDK::CSGO::CGameEventDescriptor * descriptor = gameEvent->m_pDescriptor;
+
+	if (nullptr == descriptor || descriptor->eventid < 0)
+	{
+		if (!IsAllowed(gameEvent->GetName()))
+			return;
+	}
+	else
+	{
+		const char * eventName = gameEvent->GetName();
+		bool stale;
+		bool & allowed = m_FilterAllowed.Get((size_t)descriptor->eventid, eventName, descriptor->keys, stale);
+
+		if (stale)
+			allowed = IsAllowed(eventName);
+
+		if (!allowed)
+			return;
+	}
+
+	FireHandledEvent(gameEvent);
+}
+
+bool CAfxGameEventListener::IsAllowed(const char * eventName) const
+{
+	if (!m_WhiteList.empty() && m_WhiteList.end() == m_WhiteList.find(eventName))
+		return false;
+
+	if (!m_BlackList.empty() && m_BlackList.end() != m_BlackList.find(eventName))
+		return false;
+
+	return true;
+}
+
+CAfxGameEventListenerSerialzer::CPlan & CAfxGameEventListenerSerialzer::GetPlan(SOURCESDK::CSGO::CGameEventDescriptor * descriptor, const char * eventName)
+{
+	bool stale;
+	CPlan & plan = m_Plans.Get((size_t)descriptor->eventid, eventName, descriptor->keys, stale);
+
+	if (stale)
+		MakePlan(descriptor, eventName, plan);
+
+	return plan;
+}
+
+void CAfxGameEventListenerSerialzer::MakePlan(SOURCESDK::CSGO::CGameEventDescriptor * descriptor, const char * eventName, CPlan & outPlan) const
+{
+	auto itEnrichments = m_Enrichments.find(eventName);
+
+	if (descriptor->keys)
+	{
+		for (SOURCESDK::CSGO::KeyValues *key = descriptor->keys->GetFirstSubKey(); key; key = key->GetNextKey())
+		{
+			CPlanKey planKey;
+			planKey.Name = key->GetName();
+			planKey.Type = key->GetInt();
+			planKey.Enrichments = EnrichmentType_None;
+
+			if (itEnrichments != m_Enrichments.end())
+			{
+				auto it = itEnrichments->second.find(planKey.Name);
+				if (it != itEnrichments->second.end())
+					planKey.Enrichments = it->second;
+			}
+
+			switch (planKey.Type)
+			{
+			case CsgoGameEventKeyType_CString:
+			case CsgoGameEventKeyType_Float:
+			case CsgoGameEventKeyType_Long:
+			case CsgoGameEventKeyType_Short:
+			case CsgoGameEventKeyType_Byte:
+			case CsgoGameEventKeyType_Bool:
+			case CsgoGameEventKeyType_Uint64:
+				break;
+			default:
+				if (EnrichmentType_None == planKey.Enrichments)
+					continue;
+				break;
+			}
+
+			outPlan.Keys.emplace_back(std::move(planKey));
+		}
+	}
+}
+
 void CAfxGameEventListenerSerialzer::FireHandledEvent(SOURCESDK::CSGO::CGameEvent * gameEvent)
 {
 	if (SOURCESDK::CSGO::CGameEventDescriptor * descriptor = gameEvent->m_pDescriptor)
@@ -43,8 +133,25 @@ void CAfxGameEventListenerSerialzer::FireHandledEvent(SOURCESDK::CSGO::CGameEven
 		if (!BeginSerialize()) return;
 
 		int eventId = descriptor->eventid;
+		const char * eventName = gameEvent->GetName();
+
+		// Ids below 0 can't be cached by id, so such events are planned
+		// and sent with their description every time:
+
+		CPlan uncachedPlan;
+		bool * known = nullptr;
 
-		if (m_UseCache && m_KnownEventIds.end() != m_KnownEventIds.find(eventId))
+		if (0 <= eventId)
+		{
+			bool stale;
+			known = &m_KnownEventIds.Get((size_t)eventId, eventName, descriptor->keys, stale);
+		}
+		else
+			MakePlan(descriptor, eventName, uncachedPlan);
+
+		const CPlan & plan = known ? GetPlan(descriptor, eventName) : uncachedPlan;
+
+		if (m_UseCache && known && *known)
 		{
 			WriteLong(eventId);
 		}
@@ -52,43 +159,33 @@ void CAfxGameEventListenerSerialzer::FireHandledEvent(SOURCESDK::CSGO::CGameEven
 		{
 			WriteLong(0);
 			WriteLong(eventId);
-			WriteCString(gameEvent->GetName());
+			WriteCString(eventName);
 
-			if (descriptor->keys)
+			for (auto it = plan.Keys.begin(); it != plan.Keys.end(); ++it)
 			{
-				if (SOURCESDK::CSGO::KeyValues *key = descriptor->keys->GetFirstSubKey())
+				switch (it->Type)
 				{
-					while (key)
+				case CsgoGameEventKeyType_CString:
+				case CsgoGameEventKeyType_Float:
+				case CsgoGameEventKeyType_Long:
+				case CsgoGameEventKeyType_Short:
+				case CsgoGameEventKeyType_Byte:
+				case CsgoGameEventKeyType_Bool:
+				case CsgoGameEventKeyType_Uint64:
 					{
-						int type = key->GetInt();
-
-						switch (type)
-						{
-						case CsgoGameEventKeyType_CString:
-						case CsgoGameEventKeyType_Float:
-						case CsgoGameEventKeyType_Long:
-						case CsgoGameEventKeyType_Short:
-						case CsgoGameEventKeyType_Byte:
-						case CsgoGameEventKeyType_Bool:
-						case CsgoGameEventKeyType_Uint64:
-							{
-								WriteBoolean(true);
-								WriteCString(key->GetName());
-								WriteLong(type);
-							}
-							break;
-						default:
-							break;
-						}
-
-						key = key->GetNextKey();
+						WriteBoolean(true);
+						WriteCString(it->Name.c_str());
+						WriteLong(it->Type);
 					}
+					break;
+				default:
+					break;
 				}
 			}
 
 			WriteBoolean(false);
 
-			m_KnownEventIds.insert(eventId);
+			if (known) *known = true;
 		}
 
 		if (TransmitClientTime)
@@ -120,196 +217,181 @@ void CAfxGameEventListenerSerialzer::FireHandledEvent(SOURCESDK::CSGO::CGameEven
 			WriteUInt64((unsigned __int64)result);
 		}
 
-		if (descriptor->keys)
+		for (auto it = plan.Keys.begin(); it != plan.Keys.end(); ++it)
 		{
-			if (SOURCESDK::CSGO::KeyValues *key = descriptor->keys->GetFirstSubKey())
+			const char * keyName = it->Name.c_str();
+
+			switch (it->Type)
 			{
-				const char * eventName = gameEvent->GetName();
+			case CsgoGameEventKeyType_CString:
+				WriteCString(gameEvent->GetString(keyName));
+				break;
+			case CsgoGameEventKeyType_Float:
+				WriteFloat(gameEvent->GetFloat(keyName));
+				break;
+			case CsgoGameEventKeyType_Long:
+				WriteLong(gameEvent->GetInt(keyName));
+				break;
+			case CsgoGameEventKeyType_Short:
+				WriteShort(gameEvent->GetInt(keyName));
+				break;
+			case CsgoGameEventKeyType_Byte:
+				WriteByte(gameEvent->GetInt(keyName));
+				break;
+			case CsgoGameEventKeyType_Bool:
+				WriteBoolean(gameEvent->GetBool(keyName));
+				break;
+			case CsgoGameEventKeyType_Uint64:
+				WriteUInt64(gameEvent->GetUint64(keyName));
+				break;
+			default:
+				break;
+			}
 
-				while (key)
-				{
-					const char * keyName = key->GetName();
-					int type = key->GetInt();
+			if (EnrichmentType_None != it->Enrichments)
+				WriteEnrichments(it->Enrichments, gameEvent->GetInt(keyName));
+		}
+
+		EndSerialize();
+	}
+}
+
+void CAfxGameEventListenerSerialzer::WriteEnrichments(unsigned int enrichmentType, int keyValue)
+{
+	if (enrichmentType & EnrichmentType_UseridWithSteamId)
+	{
+		int userId = keyValue;
+		unsigned __int64 xuid = 0;
+
+		if (g_VEngineClient && CClientToolsCsgo::Instance())
+		{
+			if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
+			{
+				int entnum = pEngineCsgo->GetPlayerForUserID(userId);
 
-					switch (type)
+				if(SOURCESDK::g_Entitylist_csgo)
+				{
+					if (SOURCESDK::IClientNetworkable_csgo * networkable = SOURCESDK::g_Entitylist_csgo->GetClientNetworkable(entnum))
 					{
-					case CsgoGameEventKeyType_CString:
-						WriteCString(gameEvent->GetString(keyName));
-						break;
-					case CsgoGameEventKeyType_Float:
-						WriteFloat(gameEvent->GetFloat(keyName));
-						break;
-					case CsgoGameEventKeyType_Long:
-						WriteLong(gameEvent->GetInt(keyName));
-						break;
-					case CsgoGameEventKeyType_Short:
-						WriteShort(gameEvent->GetInt(keyName));
-						break;
-					case CsgoGameEventKeyType_Byte:
-						WriteByte(gameEvent->GetInt(keyName));
-						break;
-					case CsgoGameEventKeyType_Bool:
-						WriteBoolean(gameEvent->GetBool(keyName));
-						break;
-					case CsgoGameEventKeyType_Uint64:
-						WriteUInt64(gameEvent->GetUint64(keyName));
-						break;
-					default:
-						break;
+						SOURCESDK::player_info_t_csgo pInfo;
+
+						if (pEngineCsgo->GetPlayerInfo(networkable->entindex(), &pInfo))
+						{
+							xuid = pInfo.xuid;
+						}
 					}
+				}
+			}
+		}
 
-					auto it1 = m_Enrichments.find(eventName);
-					if (it1 != m_Enrichments.end())
+		WriteUInt64(xuid);
+	}
+	if (enrichmentType & EnrichmentType_EntnumWithOrigin)
+	{
+		int entnum = keyValue;
+		SOURCESDK::Vector value;
+		value.x = 0;
+		value.y = 0;
+		value.z = 0;
+		if (SOURCESDK::g_Entitylist_csgo)
+		{
+			if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
+			{
+				if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
+				{
+					value = be->GetAbsOrigin();
+				}
+			}
+		}
+
+		WriteFloat(value.x);
+		WriteFloat(value.y);
+		WriteFloat(value.z);
+	}
+	if (enrichmentType & EnrichmentType_EntnumWithAngles)
+	{
+		int entnum = keyValue;
+		SOURCESDK::QAngle value;
+		value.x = 0;
+		value.y = 0;
+		value.z = 0;
+
+		if (SOURCESDK::g_Entitylist_csgo)
+		{
+			if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
+			{
+				if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
+				{
+					value = be->GetAbsAngles();
+				}
+			}
+		}
+
+		WriteFloat(value.x);
+		WriteFloat(value.y);
+		WriteFloat(value.z);
+	}
+	if (enrichmentType & EnrichmentType_UseridWithEyePosition)
+	{
+		int userid = keyValue;
+		SOURCESDK::Vector value;
+		value.x = 0;
+		value.y = 0;
+		value.z = 0;
+
+		if (g_VEngineClient && CClientToolsCsgo::Instance())
+		{
+			if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
+			{
+				int entnum = pEngineCsgo->GetPlayerForUserID(userid);
+
+				if (SOURCESDK::g_Entitylist_csgo)
+				{
+					if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
 					{
-						auto it2 = it1->second.find(keyName);
-						if (it2 != it1->second.end())
+						if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
 						{
-							DWORD enrichmentType = it2->second;
-
-							if (enrichmentType & EnrichmentType_UseridWithSteamId)
-							{
-								int userId = gameEvent->GetInt(keyName);
-								unsigned __int64 xuid = 0;
-
-								if (g_VEngineClient && CClientToolsCsgo::Instance())
-								{
-									if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
-									{
-										int entnum = pEngineCsgo->GetPlayerForUserID(userId);
-
-										if(SOURCESDK::g_Entitylist_csgo)
-										{
-											if (SOURCESDK::IClientNetworkable_csgo * networkable = SOURCESDK::g_Entitylist_csgo->GetClientNetworkable(entnum))
-											{
-												SOURCESDK::player_info_t_csgo pInfo;
-
-												if (pEngineCsgo->GetPlayerInfo(networkable->entindex(), &pInfo))
-												{
-													xuid = pInfo.xuid;
-												}
-											}
-										}
-									}
-								}
-
-								WriteUInt64(xuid);
-							}
-							if (enrichmentType & EnrichmentType_EntnumWithOrigin)
-							{
-								int entnum = gameEvent->GetInt(keyName);
-								SOURCESDK::Vector value;
-								value.x = 0;
-								value.y = 0;
-								value.z = 0;
-								if (SOURCESDK::g_Entitylist_csgo)
-								{
-									if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
-									{
-										if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
-										{
-											value = be->GetAbsOrigin();
-										}
-									}
-								}
-
-								WriteFloat(value.x);
-								WriteFloat(value.y);
-								WriteFloat(value.z);
-							}
-							if (enrichmentType & EnrichmentType_EntnumWithAngles)
-							{
-								int entnum = gameEvent->GetInt(keyName);
-								SOURCESDK::QAngle value;
-								value.x = 0;
-								value.y = 0;
-								value.z = 0;
-
-								if (SOURCESDK::g_Entitylist_csgo)
-								{
-									if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
-									{
-										if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
-										{
-											value = be->GetAbsAngles();
-										}
-									}
-								}
-
-								WriteFloat(value.x);
-								WriteFloat(value.y);
-								WriteFloat(value.z);
-							}
-							if (enrichmentType & EnrichmentType_UseridWithEyePosition)
-							{
-								int userid = gameEvent->GetInt(keyName);
-								SOURCESDK::Vector value;
-								value.x = 0;
-								value.y = 0;
-								value.z = 0;
-
-								if (g_VEngineClient && CClientToolsCsgo::Instance())
-								{
-									if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
-									{
-										int entnum = pEngineCsgo->GetPlayerForUserID(userid);
-
-										if (SOURCESDK::g_Entitylist_csgo)
-										{
-											if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
-											{
-												if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
-												{
-													value = be->EyePosition();
-												}
-											}
-										}
-									}
-								}
-
-								WriteFloat(value.x);
-								WriteFloat(value.y);
-								WriteFloat(value.z);
-							}
-							if (enrichmentType & EnrichmentType_UseridWithEyeAngels)
-							{
-								int userid = gameEvent->GetInt(keyName);
-								SOURCESDK::QAngle value;
-								value.x = 0;
-								value.y = 0;
-								value.z = 0;
-
-								if (g_VEngineClient && CClientToolsCsgo::Instance())
-								{
-									if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
-									{
-										int entnum = pEngineCsgo->GetPlayerForUserID(userid);
-
-										if (SOURCESDK::g_Entitylist_csgo)
-										{
-											if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
-											{
-												if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
-												{
-													value = be->EyeAngles();
-												}
-											}
-										}
-									}
-								}
-
-								WriteFloat(value.x);
-								WriteFloat(value.y);
-								WriteFloat(value.z);
-							}
+							value = be->EyePosition();
 						}
 					}
+				}
+			}
+		}
+
+		WriteFloat(value.x);
+		WriteFloat(value.y);
+		WriteFloat(value.z);
+	}
+	if (enrichmentType & EnrichmentType_UseridWithEyeAngels)
+	{
+		int userid = keyValue;
+		SOURCESDK::QAngle value;
+		value.x = 0;
+		value.y = 0;
+		value.z = 0;
+
+		if (g_VEngineClient && CClientToolsCsgo::Instance())
+		{
+			if (SOURCESDK::IVEngineClient_014_csgo * pEngineCsgo = g_VEngineClient->GetVEngineClient_csgo())
+			{
+				int entnum = pEngineCsgo->GetPlayerForUserID(userid);
 
-					key = key->GetNextKey();
+				if (SOURCESDK::g_Entitylist_csgo)
+				{
+					if (SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(entnum))
+					{
+						if (SOURCESDK::C_BaseEntity_csgo * be = ce->GetBaseEntity())
+						{
+							value = be->EyeAngles();
+						}
+					}
 				}
 			}
 		}
 
-		EndSerialize();
+		WriteFloat(value.x);
+		WriteFloat(value.y);
+		WriteFloat(value.z);
 	}
 }
 
@@ -2,9 +2,12 @@
 
 #include "SourceInterfaces.h"
 
+#include "../shared/AfxEventIdCache.h"
+
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 
 class IAfxGameEventListener
 {
@@ -15,20 +18,7 @@ public:
 class CAfxGameEventListener : public IAfxGameEventListener
 {
 public:
-	virtual void FireEvent(SOURCESDK::CSGO::CGameEvent * gameEvent)
-	{
-		if (nullptr == gameEvent) return;
-
-		const char * eventName = gameEvent->GetName();
-
-		if (!m_WhiteList.empty() && m_WhiteList.end() == m_WhiteList.find(eventName))
-			return;
-
-		if (!m_BlackList.empty() && m_BlackList.end() != m_BlackList.find(eventName))
-			return;
-
-		FireHandledEvent(gameEvent);
-	}
+	virtual void FireEvent(SOURCESDK::CSGO::CGameEvent * gameEvent);
 
 	virtual void Restart()
 	{
@@ -39,33 +29,39 @@ public:
 	void ClearWhiteList()
 	{
 		m_WhiteList.clear();
+		ForgetFilter();
 	}
 
 	void WhiteList(const char * eventName)
 	{
 		if (m_WhiteList.end() == m_WhiteList.find(eventName)) m_WhiteList.emplace(eventName);
+		ForgetFilter();
 	}
 
 	void UnWhiteList(const char * eventName)
 	{
 		auto it = m_WhiteList.find(eventName);
 		if (it != m_WhiteList.end()) m_WhiteList.erase(it);
+		ForgetFilter();
 	}
 
 	void ClearBlackList()
 	{
 		m_BlackList.clear();
+		ForgetFilter();
 	}
 
 	void BlackList(const char * eventName)
 	{
 		if (m_BlackList.end() == m_BlackList.find(eventName)) m_BlackList.emplace(eventName);
+		ForgetFilter();
 	}
 
 	void UnBlackList(const char * eventName)
 	{
 		auto it = m_BlackList.find(eventName);
 		if (it != m_BlackList.end()) m_BlackList.erase(it);
+		ForgetFilter();
 	}
 
 
@@ -75,6 +71,16 @@ protected:
 private:
 	std::set<std::string> m_BlackList;
 	std::set<std::string> m_WhiteList;
+
+	/// <summary>If an event id is allowed, so the lists are only searched on the first event of a type.</summary>
+	CAfxEventIdCache<bool> m_FilterAllowed;
+
+	void ForgetFilter()
+	{
+		m_FilterAllowed.Clear();
+	}
+
+	bool IsAllowed(const char * eventName) const;
 };
 
 class CAfxGameEventListenerSerialzer : public CAfxGameEventListener
@@ -101,7 +107,7 @@ public:
 
 		ClearEnrichments();
 
-		m_KnownEventIds.clear();
+		ForgetKnownEvents();
 
 		CAfxGameEventListener::Restart();
 	}
@@ -109,6 +115,7 @@ public:
 	void ClearEnrichments()
 	{
 		m_Enrichments.clear();
+		m_Plans.Clear();
 	}
 
 	void Enrich(const char* eventName, const char* eventProperty, bool enable, EnrichmentType_e enrichmentType)
@@ -126,6 +133,8 @@ public:
 					m_Enrichments.erase(eventName);
 			}
 		}
+
+		m_Plans.Clear();
 	}
 
 	void EnrichSet(const char* eventName, const char* eventProperty, unsigned int enrichmentType)
@@ -138,6 +147,8 @@ public:
 			if (enrichment.empty())
 				m_Enrichments.erase(eventName);
 		}
+
+		m_Plans.Clear();
 	}
 
 	void EnrichUseridWithSteamId(const char * eventName, const char * eventProperty, bool enable = true)
@@ -173,8 +184,14 @@ public:
 		return m_UseCache;
 	}
 
+	/// <summary>Makes the next event of each type be sent with its description again, i.e. if a serialized event got lost.</summary>
+	void ForgetKnownEvents() {
+		m_KnownEventIds.Clear();
+	}
+
 protected:
 
+	/// <remarks>Call ClearEnrichments, Enrich or EnrichSet to change it, so the plans are compiled again.</remarks>
 	std::map<std::string, std::map<std::string, unsigned int>> m_Enrichments;
 
 	virtual void FireHandledEvent(SOURCESDK::CSGO::CGameEvent * gameEvent) override;
@@ -207,9 +224,33 @@ protected:
 	virtual void WriteUInt64(unsigned __int64 value) = 0;
 
 private:
+	struct CPlanKey
+	{
+		std::string Name;
+		int Type;
+		unsigned int Enrichments;
+	};
+
+	/// <summary>What to serialize for an event id, compiled on its first event.</summary>
+	struct CPlan
+	{
+		std::vector<CPlanKey> Keys;
+	};
+
 	bool m_UseCache = true;
-		
-	std::set<int> m_KnownEventIds;
+
+	CAfxEventIdCache<CPlan> m_Plans;
+
+	/// <summary>If the event id has been sent with its description.</summary>
+	/// <remarks>Kept apart from m_Plans, since the description doesn't depend on the enrichments.</remarks>
+	CAfxEventIdCache<bool> m_KnownEventIds;
+
+	/// <remarks>Only for event ids not below 0.</remarks>
+	CPlan & GetPlan(SOURCESDK::CSGO::CGameEventDescriptor * descriptor, const char * eventName);
+
+	void MakePlan(SOURCESDK::CSGO::CGameEventDescriptor * descriptor, const char * eventName, CPlan & outPlan) const;
+
+	void WriteEnrichments(unsigned int enrichmentType, int keyValue);
 };
 
 class CAfxGameEvents
@@ -115,8 +115,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntity((int)hEntity);
 				{
 					SOURCESDK::CSSV34::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::CSSV34::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -145,7 +144,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 						Write((bool)(0 != pBaseAnimatingRs->m_pBoneList));
 						if (pBaseAnimatingRs->m_pBoneList)
 						{
-							Write(pBaseAnimatingRs->m_pBoneList);
+							Write((int)hEntity, pBaseAnimatingRs->m_pBoneList);
 						}
 					}
 				}
@@ -155,6 +154,8 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 				bool viewModel = 0 != msg->GetInt("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -165,8 +166,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -236,13 +236,12 @@ void CClientToolsCssV34::EndRecording()
 	CClientTools::EndRecording();
 }
 
-void CClientToolsCssV34::Write(SOURCESDK::CSSV34::CBoneList const * value)
+void CClientToolsCssV34::Write(int entityHandle, SOURCESDK::CSSV34::CBoneList const * value)
 {
-	Write((int)value->m_nBones);
+	BeginBones(entityHandle, (int)value->m_nBones);
 
 	for (int i = 0; i < value->m_nBones; ++i)
 	{
-		Write(value->m_vecPos[i]);
-		Write(value->m_quatRot[i]);
+		WriteBone(value->m_vecPos[i], value->m_quatRot[i]);
 	}
 }
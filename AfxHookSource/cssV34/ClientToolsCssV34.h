@@ -38,7 +38,7 @@ private:
 	SOURCESDK::CSSV34::IClientTools * m_ClientTools;
 	std::map<SOURCESDK::CSSV34::HTOOLHANDLE, bool> m_TrackedHandles;
 
-	void Write(SOURCESDK::CSSV34::CBoneList const * value);
+	void Write(int entityHandle, SOURCESDK::CSSV34::CBoneList const * value);
 
 	void OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE hEntity, SOURCESDK::CSSV34::KeyValues * msg);
 };
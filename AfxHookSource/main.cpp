@@ -572,6 +572,9 @@ int __fastcall new_CVClient_Init_Garrysmod(void* This, void* Edx, SOURCESDK::Cre
 }
 
 
+void MirvCalcs_AfterFrameRenderStart();
+void MirvCalcs_AfterFrameRenderEnd();
+
 void Shared_BeforeFrameRenderStart(void)
 {
 	g_MirvTime.OnFrameRenderStart();
@@ -579,8 +582,14 @@ void Shared_BeforeFrameRenderStart(void)
 	if (CClientTools * instance = CClientTools::Instance()) instance->OnBeforeFrameRenderStart();
 }
 
+void Shared_AfterFrameRenderStart(void)
+{
+	MirvCalcs_AfterFrameRenderStart();
+}
+
 void Shared_AfterFrameRenderEnd(void)
 {
+	MirvCalcs_AfterFrameRenderEnd();
 	if (CClientTools * instance = CClientTools::Instance()) instance->OnAfterFrameRenderEnd();
 	Mirv_Voice_OnAfterFrameRenderEnd();
 	AfxHookSource::Gui::OnGameFrameRenderEnd();
@@ -620,6 +629,9 @@ void __fastcall new_CVClient_FrameStageNotify_TF2(void* This, void* Edx, SOURCES
 
 	switch (curStage)
 	{
+	case SOURCESDK::TF2::FRAME_RENDER_START:
+		Shared_AfterFrameRenderStart();
+		break;
 	case SOURCESDK::TF2::FRAME_RENDER_END:
 		Shared_AfterFrameRenderEnd();
 		break;
@@ -655,6 +667,9 @@ void __fastcall new_CVClient_FrameStageNotify_CSSV34(void* This, void* Edx, SOUR
 
 	switch (curStage)
 	{
+	case SOURCESDK::CSSV34::FRAME_RENDER_START:
+		Shared_AfterFrameRenderStart();
+		break;
 	case SOURCESDK::CSSV34::FRAME_RENDER_END:
 		Shared_AfterFrameRenderEnd();
 		break;
@@ -1294,6 +1309,8 @@ void CAfxBaseClientDll::FrameStageNotify(SOURCESDK::CSGO::ClientFrameStage_t cur
 	switch (curStage)
 	{
 	case SOURCESDK::CSGO::FRAME_RENDER_START:
+		Shared_AfterFrameRenderStart();
+
 #ifdef AFX_INTEROP
 		AfxInterop::AfterFrameRenderStart();
 #endif
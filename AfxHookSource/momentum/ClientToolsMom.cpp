@@ -117,8 +117,7 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntity((int)hEntity);
 				{
 					SOURCESDK::TF2::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::TF2::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -147,7 +146,7 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 						Write((bool)(0 != pBaseAnimatingRs->m_pBoneList));
 						if (pBaseAnimatingRs->m_pBoneList)
 						{
-							Write(pBaseAnimatingRs->m_pBoneList);
+							Write((int)hEntity, pBaseAnimatingRs->m_pBoneList);
 						}
 					}
 				}
@@ -157,6 +156,8 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 				bool viewModel = msg->GetBool("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -167,8 +168,7 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -243,13 +243,12 @@ float CClientToolsMom::ScaleFov(int width, int height, float fov)
 	return (float)AlienSwarm_FovScaling(g_Hook_VClient_RenderView.LastWidth, g_Hook_VClient_RenderView.LastHeight, g_Hook_VClient_RenderView.LastCameraFov);
 }
 
-void CClientToolsMom::Write(SOURCESDK::TF2::CBoneList const * value)
+void CClientToolsMom::Write(int entityHandle, SOURCESDK::TF2::CBoneList const * value)
 {
-	Write((int)value->m_nBones);
+	BeginBones(entityHandle, (int)value->m_nBones);
 
 	for (int i = 0; i < value->m_nBones; ++i)
 	{
-		Write(value->m_vecPos[i]);
-		Write(value->m_quatRot[i]);
+		WriteBone(value->m_vecPos[i], value->m_quatRot[i]);
 	}
 }
@@ -114,8 +114,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntity((int)hEntity);
 				{
 					SOURCESDK::TF2::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::TF2::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -144,7 +143,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 						Write((bool)(0 != pBaseAnimatingRs->m_pBoneList));
 						if (pBaseAnimatingRs->m_pBoneList)
 						{
-							Write(pBaseAnimatingRs->m_pBoneList);
+							Write((int)hEntity, pBaseAnimatingRs->m_pBoneList);
 						}
 					}
 				}
@@ -154,6 +153,8 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 				bool viewModel = msg->GetBool("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -164,8 +165,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -240,13 +240,12 @@ float CClientToolsTf2::ScaleFov(int width, int height, float fov)
 	return (float)AlienSwarm_FovScaling(g_Hook_VClient_RenderView.LastWidth, g_Hook_VClient_RenderView.LastHeight, g_Hook_VClient_RenderView.LastCameraFov);
 }
 
-void CClientToolsTf2::Write(SOURCESDK::TF2::CBoneList const * value)
+void CClientToolsTf2::Write(int entityHandle, SOURCESDK::TF2::CBoneList const * value)
 {
-	Write((int)value->m_nBones);
+	BeginBones(entityHandle, (int)value->m_nBones);
 
 	for (int i = 0; i < value->m_nBones; ++i)
 	{
-		Write(value->m_vecPos[i]);
-		Write(value->m_quatRot[i]);
+		WriteBone(value->m_vecPos[i], value->m_quatRot[i]);
 	}
 }
@@ -0,0 +1,115 @@
+#include "stdafx.h"
+
+#include "AgrTools.h"
+
+#include <shared/AfxGameRecordParser.h>
+
+#include <locale.h>
+#include <set>
+
+/// <summary>Only passes entity_state and deleted records of the given entities on.</summary>
+class CAgrFilterVisitor : public CAfxGameRecordWriteVisitor
+{
+public:
+	CAgrFilterVisitor(CAfxGameRecordWriter & writer, std::set<int> const & handles)
+	: CAfxGameRecordWriteVisitor(writer)
+	, m_Handles(handles)
+	{
+	}
+
+	virtual void OnEntity(AfxGameRecordEntity const & entity)
+	{
+		if (m_Handles.end() != m_Handles.find(entity.Handle))
+			CAfxGameRecordWriteVisitor::OnEntity(entity);
+	}
+
+	virtual void OnDeleted(int handle)
+	{
+		if (m_Handles.end() != m_Handles.find(handle))
+			CAfxGameRecordWriteVisitor::OnDeleted(handle);
+	}
+
+	virtual void OnHidden(int count, int const * handles)
+	{
+		m_Hidden.clear();
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (m_Handles.end() != m_Handles.find(handles[i]))
+				m_Hidden.push_back(handles[i]);
+		}
+
+		CAfxGameRecordWriteVisitor::OnHidden((int)m_Hidden.size(), m_Hidden.empty() ? 0 : &m_Hidden[0]);
+	}
+
+private:
+	std::set<int> const & m_Handles;
+	std::vector<int> m_Hidden;
+};
+
+int main(int argc, char * argv[])
+{
+	setlocale(LC_ALL, "");
+
+	std::wstring inFileName;
+	std::wstring outFileName;
+	std::set<int> handles;
+	int version = -1;
+
+	bool usage = argc < 3
+		|| !AgrTools_ToWide(argv[1], inFileName)
+		|| !AgrTools_ToWide(argv[2], outFileName);
+
+	for (int i = 3; !usage && i < argc; ++i)
+	{
+		int handle;
+
+		if (0 == strcmp("--entity", argv[i]) && i + 1 < argc && AgrTools_ToInt(argv[i + 1], handle)) { handles.insert(handle); ++i; }
+		else if (0 == strcmp("--version", argv[i]) && i + 1 < argc && AgrTools_ToVersion(argv[i + 1], version)) ++i;
+		else usage = true;
+	}
+
+	if (usage || handles.empty())
+	{
+		fprintf(stderr,
+			"Usage: agr-filter <in.agr> <out.agr> --entity <handle> [--entity <handle> ...] [--version 5|6]\n"
+			"Copies all frames, but only the records of the given entity handles (camera records are kept).\n"
+			"--version: Version of the output file, default is the version of the input file.\n"
+		);
+		return 2;
+	}
+
+	CAfxGameRecordParser parser;
+
+	if (!parser.Open(inFileName.c_str()))
+	{
+		fprintf(stderr, "Error: Could not open %s (or not a supported AGR).\n", argv[1]);
+		return 1;
+	}
+
+	CAfxGameRecordWriter writer;
+
+	if (!writer.Open(outFileName.c_str(), -1 == version ? parser.GetVersion() : version))
+	{
+		fprintf(stderr, "Error: Could not create %s.\n", argv[2]);
+		return 1;
+	}
+
+	CAgrFilterVisitor visitor(writer, handles);
+
+	bool ok = parser.Parse(&visitor);
+
+	if (!writer.Close())
+	{
+		fprintf(stderr, "Error: Could not write %s.\n", argv[2]);
+		return 1;
+	}
+
+	if (!ok)
+	{
+		fprintf(stderr, "Error: Invalid data in %s.\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include "stdafx.h"
+
+#include "AgrTools.h"
+
+#include <shared/AfxGameRecordParser.h>
+
+#include <locale.h>
+
+int main(int argc, char * argv[])
+{
+	setlocale(LC_ALL, "");
+
+	std::wstring inFileName;
+	std::wstring outFileName;
+	int firstFrame;
+	int frameCount;
+	int version = -1;
+
+	bool usage = argc < 5
+		|| !AgrTools_ToWide(argv[1], inFileName)
+		|| !AgrTools_ToWide(argv[2], outFileName)
+		|| !AgrTools_ToInt(argv[3], firstFrame) || firstFrame < 0
+		|| !AgrTools_ToInt(argv[4], frameCount) || frameCount < -1;
+
+	for (int i = 5; !usage && i < argc; ++i)
+	{
+		if (0 == strcmp("--version", argv[i]) && i + 1 < argc && AgrTools_ToVersion(argv[i + 1], version)) ++i;
+		else usage = true;
+	}
+
+	if (usage)
+	{
+		fprintf(stderr,
+			"Usage: agr-slice <in.agr> <out.agr> <firstFrame> <frameCount> [--version 5|6]\n"
+			"Copies frameCount frames (-1 for all remaining) starting at frame firstFrame (0 is the first frame).\n"
+			"--version: Version of the output file, default is the version of the input file.\n"
+			"Deletions directly before firstFrame and between the copied frames are kept.\n"
+		);
+		return 2;
+	}
+
+	CAfxGameRecordParser parser;
+
+	if (!parser.Open(inFileName.c_str()))
+	{
+		fprintf(stderr, "Error: Could not open %s (or not a supported AGR).\n", argv[1]);
+		return 1;
+	}
+
+	CAfxGameRecordWriter writer;
+
+	if (!writer.Open(outFileName.c_str(), -1 == version ? parser.GetVersion() : version))
+	{
+		fprintf(stderr, "Error: Could not create %s.\n", argv[2]);
+		return 1;
+	}
+
+	CAfxGameRecordWriteVisitor visitor(writer);
+
+	bool ok = parser.Parse(&visitor, firstFrame, frameCount);
+
+	if (!writer.Close())
+	{
+		fprintf(stderr, "Error: Could not write %s.\n", argv[2]);
+		return 1;
+	}
+
+	if (!ok)
+	{
+		fprintf(stderr, "Error: Invalid data in %s (or frame %i doesn't exist).\n", argv[1], firstFrame);
+		return 1;
+	}
+
+	return 0;
+}
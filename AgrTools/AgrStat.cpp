@@ -0,0 +1,113 @@
+#include "stdafx.h"
+
+#include "AgrTools.h"
+
+#include <shared/AfxGameRecordParser.h>
+
+#include <chrono>
+#include <locale.h>
+#include <set>
+
+class CAgrStatVisitor : public IAfxGameRecordVisitor
+{
+public:
+	int Frames = 0;
+	float FirstFrameTime = 0;
+	float LastFrameTime = 0;
+	long long EntityStates = 0;
+	long long Bones = 0;
+	long long Cameras = 0;
+	long long Deleted = 0;
+	long long Hidden = 0;
+	std::set<int> Handles;
+	std::set<char const *> ModelNames;
+
+	virtual void OnFrame(int frame, float frameTime)
+	{
+		if (0 == Frames) FirstFrameTime = frameTime;
+		LastFrameTime = frameTime;
+	}
+
+	virtual void OnCamera(float const * values)
+	{
+		++Cameras;
+	}
+
+	virtual void OnEntity(AfxGameRecordEntity const & entity)
+	{
+		++EntityStates;
+		Bones += entity.NumBones;
+		Handles.insert(entity.Handle);
+
+		// Model names are interned by the parser, so the pointer is enough:
+		if (entity.ModelName) ModelNames.insert(entity.ModelName);
+	}
+
+	virtual void OnDeleted(int handle)
+	{
+		++Deleted;
+	}
+
+	virtual void OnHidden(int count, int const * handles)
+	{
+		Hidden += count;
+	}
+
+	virtual void OnFrameEnd(int frame)
+	{
+		++Frames;
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	setlocale(LC_ALL, "");
+
+	std::wstring inFileName;
+
+	if (2 != argc || !AgrTools_ToWide(argv[1], inFileName))
+	{
+		fprintf(stderr,
+			"Usage: agr-stat <in.agr>\n"
+			"Prints statistics about an afxGameRecord file (version 5 or 6).\n"
+		);
+		return 2;
+	}
+
+	CAfxGameRecordParser parser;
+
+	if (!parser.Open(inFileName.c_str()))
+	{
+		fprintf(stderr, "Error: Could not open %s (or not a supported AGR).\n", argv[1]);
+		return 1;
+	}
+
+	CAgrStatVisitor visitor;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool ok = parser.Parse(&visitor);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("version:         %i\n", parser.GetVersion());
+	printf("file size:       %zu bytes\n", parser.GetFileSize());
+	printf("index:           %s\n", 0 <= parser.GetFrameCount() ? "yes" : "no");
+	printf("frames:          %i\n", visitor.Frames);
+	printf("duration:        %f s\n", visitor.Frames ? visitor.LastFrameTime - visitor.FirstFrameTime : 0.0f);
+	printf("entity states:   %lld\n", visitor.EntityStates);
+	printf("entities:        %zu\n", visitor.Handles.size());
+	printf("models:          %zu\n", visitor.ModelNames.size());
+	printf("bones:           %lld\n", visitor.Bones);
+	printf("cameras:         %lld\n", visitor.Cameras);
+	printf("deleted:         %lld\n", visitor.Deleted);
+	printf("hidden:          %lld\n", visitor.Hidden);
+	if (visitor.Frames) printf("bytes per frame: %.1f\n", (double)parser.GetFileSize() / visitor.Frames);
+	printf("parse time:      %f s (%.1f MB/s)\n", seconds, 0 < seconds ? parser.GetFileSize() / seconds / 1e6 : 0.0);
+
+	if (!ok)
+	{
+		fprintf(stderr, "Error: Invalid data after frame %i.\n", visitor.Frames);
+		return 1;
+	}
+
+	return 0;
+}
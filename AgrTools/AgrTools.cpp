@@ -0,0 +1,45 @@
+#include "stdafx.h"
+
+#include "AgrTools.h"
+
+#include <shared/AfxGameRecord.h>
+
+#include <errno.h>
+#include <limits.h>
+
+bool AgrTools_ToWide(char const * value, std::wstring & outValue)
+{
+	size_t size = mbstowcs(nullptr, value, 0);
+	if ((size_t)-1 == size)
+		return false;
+
+	outValue.resize(size);
+	if (0 < size) mbstowcs(&outValue[0], value, size + 1);
+
+	return true;
+}
+
+bool AgrTools_ToInt(char const * value, int & outValue)
+{
+	char * end;
+
+	errno = 0;
+	long result = strtol(value, &end, 10);
+
+	if (end == value || '\0' != *end || 0 != errno || result < INT_MIN || INT_MAX < result)
+		return false;
+
+	outValue = (int)result;
+	return true;
+}
+
+bool AgrTools_ToVersion(char const * value, int & outVersion)
+{
+	int version;
+
+	if (!AgrTools_ToInt(value, version) || (AFXGAMERECORD_VERSION_RAW != version && AFXGAMERECORD_VERSION_COMPRESSED != version))
+		return false;
+
+	outVersion = version;
+	return true;
+}
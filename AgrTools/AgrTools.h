@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+/// <summary>Converts a command line argument (in the current locale) to a wide string.</summary>
+bool AgrTools_ToWide(char const * value, std::wstring & outValue);
+
+/// <summary>Parses an int command line argument.</summary>
+bool AgrTools_ToInt(char const * value, int & outValue);
+
+/// <summary>Parses the value of --version (5 or 6).</summary>
+bool AgrTools_ToVersion(char const * value, int & outVersion);
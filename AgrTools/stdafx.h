@@ -0,0 +1,43 @@
+#pragma once
+
+// Portability layer for the shared/ code used by the tools, so they build
+// without Windows headers (MSVC provides all of this natively).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#ifndef _WIN32
+
+#include <string>
+
+#define abstract
+#define __declspec(x)
+
+#define _fseeki64 fseeko
+#define _ftelli64 ftello
+
+inline int _wfopen_s(FILE ** pFile, wchar_t const * fileName, wchar_t const * mode)
+{
+	std::string narrowFileName;
+	std::string narrowMode;
+
+	size_t size = wcstombs(nullptr, fileName, 0);
+	if ((size_t)-1 == size)
+	{
+		*pFile = nullptr;
+		return 1;
+	}
+
+	narrowFileName.resize(size);
+	wcstombs(&narrowFileName[0], fileName, size + 1);
+
+	for (; *mode; ++mode) narrowMode += (char)*mode;
+
+	*pFile = fopen(narrowFileName.c_str(), narrowMode.c_str());
+
+	return *pFile ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,408 @@
+#include "stdafx.h"
+
+#include <shared/AfxInteropProtocol.h>
+#include <shared/AfxInteropReplay.h>
+#include <shared/AfxInteropSharedMemory.h>
+#include <shared/AfxInteropStandIn.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <locale.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+static bool InteropReplay_ToWide(char const * value, std::wstring & outValue)
+{
+	size_t size = mbstowcs(nullptr, value, 0);
+	if ((size_t)-1 == size)
+		return false;
+
+	outValue.resize(size);
+	if (0 < size) mbstowcs(&outValue[0], value, size + 1);
+
+	return true;
+}
+
+static bool InteropReplay_ToInt(char const * value, int & outValue)
+{
+	char * end;
+
+	errno = 0;
+	long result = strtol(value, &end, 10);
+
+	if (end == value || '\0' != *end || 0 != errno || result < INT_MIN || INT_MAX < result)
+		return false;
+
+	outValue = (int)result;
+	return true;
+}
+
+static int InteropReplay_Usage(void)
+{
+	fprintf(stderr,
+		"Usage: afx-interop-replay <command> ...\n"
+		"Records, inspects and replays the message stream of an AfxInterop engine connection.\n"
+		"\n"
+		"afx-interop-replay synth <out.rec> [--version 7|8] [--frames <n>] [--no-wait] [--transport pipe|sharedMemory]\n"
+		"  Runs the stand-in engine against the stand-in client and records the engine's side.\n"
+		"  --version: Engine protocol, default is 8. --no-wait: Version 8 client doesn't make the engine wait for its replies.\n"
+		"afx-interop-replay stat <in.rec>\n"
+		"  Prints the exchanges of a recording (i.e. from afx_interop record) by message.\n"
+		"afx-interop-replay bench <in.rec> [--transport pipe|sharedMemory] [--repeat <n>] [--histogram]\n"
+		"  Replays both sides against each other at full speed and prints the latencies\n"
+		"  (engine side: from sending a message until its answer is read) and the throughput.\n"
+		"afx-interop-replay play <in.rec> --side engine|client --name <name> [--histogram]\n"
+		"  Replays one side over the shared memory <name> against another process:\n"
+		"  engine: opens the memory a client created, client: creates it and waits for the engine.\n"
+	);
+	return 2;
+}
+
+static bool InteropReplay_ToTransport(char const * value, bool & outSharedMemory)
+{
+	if (0 == strcmp("pipe", value)) outSharedMemory = false;
+	else if (0 == strcmp("sharedMemory", value)) outSharedMemory = true;
+	else return false;
+
+	return true;
+}
+
+/// <summary>The engine's and the client's end of an in process connection.</summary>
+class CInteropReplayConnection
+{
+public:
+	bool Connect(bool sharedMemory)
+	{
+		m_SharedMemory = sharedMemory;
+
+		if (sharedMemory)
+		{
+			std::string name = "afxInteropReplay_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+			return m_ClientSharedMemory.Create(name.c_str()) && m_EngineSharedMemory.Open(name.c_str());
+		}
+
+		return CAfxInteropPipeTransport::Connect(m_EnginePipe, m_ClientPipe);
+	}
+
+	IAfxInteropTransport * GetEngine(void)
+	{
+		return m_SharedMemory ? (IAfxInteropTransport *)&m_EngineSharedMemory : &m_EnginePipe;
+	}
+
+	IAfxInteropTransport * GetClient(void)
+	{
+		return m_SharedMemory ? (IAfxInteropTransport *)&m_ClientSharedMemory : &m_ClientPipe;
+	}
+
+	/// <summary>Lets the client see a disconnect.</summary>
+	void CloseEngine(void)
+	{
+		if (m_SharedMemory) m_EngineSharedMemory.Close();
+		else m_EnginePipe.CloseWrite();
+	}
+
+private:
+	bool m_SharedMemory = false;
+	CAfxInteropPipeTransport m_EnginePipe;
+	CAfxInteropPipeTransport m_ClientPipe;
+	CAfxInteropSharedMemoryTransport m_EngineSharedMemory;
+	CAfxInteropSharedMemoryTransport m_ClientSharedMemory;
+};
+
+static void InteropReplay_PrintLatencies(AfxInteropReplayStats const & stats, bool histogram)
+{
+	printf("%-24s %8s %10s %10s %10s %10s %10s %10s\n", "message", "count", "mean us", "min us", "p50 us", "p90 us", "p99 us", "max us");
+
+	for (int i = 0; i < AfxInteropProtocol::EngineMessage_Max + 2; ++i)
+	{
+		CAfxInteropLatencyHistogram const & latencies = stats.Latencies[i];
+		if (0 == latencies.GetCount()) continue;
+
+		printf("%-24s %8zu %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+			CAfxInteropRecording::GetMessageName(i - 1), latencies.GetCount(), latencies.GetMean(), latencies.GetMin(),
+			latencies.GetPercentile(50), latencies.GetPercentile(90), latencies.GetPercentile(99), latencies.GetMax());
+
+		if (histogram)
+		{
+			for (size_t j = 0; j < latencies.GetBucketCount(); ++j)
+			{
+				if (0 < latencies.GetBucketSize(j)) printf("  <= %10.3f us: %zu\n", latencies.GetBucketUpperBound(j), latencies.GetBucketSize(j));
+			}
+		}
+	}
+}
+
+static void InteropReplay_PrintThroughput(AfxInteropReplayStats const & stats)
+{
+	double seconds = 0 < stats.Seconds ? stats.Seconds : 1e-9;
+
+	printf("%zu exchanges, %zu bytes written, %zu bytes read in %.3f s: %.0f exchanges/s, %.2f MiB/s\n",
+		stats.Exchanges, stats.BytesWritten, stats.BytesRead, stats.Seconds,
+		stats.Exchanges / seconds, (stats.BytesWritten + stats.BytesRead) / seconds / (1024.0 * 1024.0));
+
+	if (0 < stats.BytesDiffering) printf("%zu bytes read differ from the recording.\n", stats.BytesDiffering);
+}
+
+static bool InteropReplay_Load(char const * fileName, CAfxInteropRecording & outRecording)
+{
+	std::wstring wideFileName;
+
+	if (!InteropReplay_ToWide(fileName, wideFileName) || !outRecording.Load(wideFileName.c_str()))
+	{
+		fprintf(stderr, "Error: Could not read %s (or not an AfxInterop recording).\n", fileName);
+		return false;
+	}
+
+	return true;
+}
+
+static void InteropReplay_RunClient(CAfxInteropStandInClient * client, bool * outResult)
+{
+	*outResult = client->Run();
+}
+
+static int InteropReplay_Synth(int argc, char * argv[])
+{
+	AfxInteropStandInSettings settings;
+	bool sharedMemory = false;
+	std::wstring outFileName;
+
+	bool ok = 3 <= argc && InteropReplay_ToWide(argv[2], outFileName);
+
+	for (int i = 3; ok && i < argc; ++i)
+	{
+		if (0 == strcmp("--version", argv[i]) && i + 1 < argc && InteropReplay_ToInt(argv[i + 1], settings.Version) && 7 <= settings.Version && settings.Version <= 8) ++i;
+		else if (0 == strcmp("--frames", argv[i]) && i + 1 < argc && InteropReplay_ToInt(argv[i + 1], settings.Frames) && 0 <= settings.Frames) ++i;
+		else if (0 == strcmp("--no-wait", argv[i])) settings.Wait = false;
+		else if (0 == strcmp("--transport", argv[i]) && i + 1 < argc && InteropReplay_ToTransport(argv[i + 1], sharedMemory)) ++i;
+		else ok = false;
+	}
+
+	if (!ok) return InteropReplay_Usage();
+
+	CInteropReplayConnection connection;
+
+	if (!connection.Connect(sharedMemory))
+	{
+		fprintf(stderr, "Error: Could not create the transport.\n");
+		return 1;
+	}
+
+	CAfxInteropRecorder recorder;
+
+	if (!recorder.Open(outFileName.c_str(), connection.GetEngine()))
+	{
+		fprintf(stderr, "Error: Could not create %s.\n", argv[2]);
+		return 1;
+	}
+
+	CAfxInteropStandInEngine engine(&recorder, settings);
+	CAfxInteropStandInClient client(connection.GetClient(), settings);
+
+	bool clientResult = false;
+	std::thread clientThread(InteropReplay_RunClient, &client, &clientResult);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool engineResult = engine.Run();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	connection.CloseEngine();
+	clientThread.join();
+
+	bool recorded = recorder.Close();
+
+	if (!engineResult || !clientResult)
+	{
+		fprintf(stderr, "Error: The stand-ins failed (engine: %s, client: %s).\n", engineResult ? "ok" : "failed", clientResult ? "ok" : "failed");
+		return 1;
+	}
+
+	if (!recorded)
+	{
+		fprintf(stderr, "Error: Could not write %s.\n", argv[2]);
+		return 1;
+	}
+
+	printf("%i frames (version %i) in %.3f s: %.0f frames/s\n", settings.Frames, settings.Version, seconds, 0 < seconds ? settings.Frames / seconds : 0.0);
+
+	return 0;
+}
+
+static int InteropReplay_Stat(int argc, char * argv[])
+{
+	if (3 != argc) return InteropReplay_Usage();
+
+	CAfxInteropRecording recording;
+	if (!InteropReplay_Load(argv[2], recording)) return 1;
+
+	struct MessageStat
+	{
+		size_t Exchanges = 0;
+		size_t SentBytes = 0;
+		size_t ReceivedBytes = 0;
+		unsigned long long RecordedTime = 0;
+	} stats[AfxInteropProtocol::EngineMessage_Max + 2];
+
+	std::vector<AfxInteropExchange> const & exchanges = recording.GetExchanges();
+
+	for (size_t i = 0; i < exchanges.size(); ++i)
+	{
+		MessageStat & stat = stats[exchanges[i].Message + 1];
+		++stat.Exchanges;
+		stat.SentBytes += exchanges[i].SentBytes;
+		stat.ReceivedBytes += exchanges[i].ReceivedBytes;
+		stat.RecordedTime += exchanges[i].RecordedTime;
+	}
+
+	std::vector<AfxInteropRecordingChunk> const & chunks = recording.GetChunks();
+	unsigned long long duration = chunks.empty() ? 0 : chunks.back().Time - chunks.front().Time;
+
+	printf("%zu chunks, %zu exchanges, %.3f s recorded\n", chunks.size(), exchanges.size(), duration / 1000000.0);
+	printf("%-24s %10s %12s %12s %14s\n", "message", "exchanges", "sent bytes", "recv bytes", "mean rec. us");
+
+	for (int i = 0; i < AfxInteropProtocol::EngineMessage_Max + 2; ++i)
+	{
+		MessageStat const & stat = stats[i];
+		if (0 == stat.Exchanges) continue;
+
+		printf("%-24s %10zu %12zu %12zu %14.2f\n",
+			CAfxInteropRecording::GetMessageName(i - 1), stat.Exchanges, stat.SentBytes, stat.ReceivedBytes, (double)stat.RecordedTime / stat.Exchanges);
+	}
+
+	return 0;
+}
+
+static void InteropReplay_ReplayClient(CAfxInteropRecording const * recording, IAfxInteropTransport * transport, AfxInteropReplayStats * outStats, bool * outResult)
+{
+	*outResult = recording->Replay(false, transport, *outStats);
+}
+
+static int InteropReplay_Bench(int argc, char * argv[])
+{
+	bool sharedMemory = false;
+	int repeat = 1;
+	bool histogram = false;
+
+	bool ok = 3 <= argc;
+
+	for (int i = 3; ok && i < argc; ++i)
+	{
+		if (0 == strcmp("--transport", argv[i]) && i + 1 < argc && InteropReplay_ToTransport(argv[i + 1], sharedMemory)) ++i;
+		else if (0 == strcmp("--repeat", argv[i]) && i + 1 < argc && InteropReplay_ToInt(argv[i + 1], repeat) && 1 <= repeat) ++i;
+		else if (0 == strcmp("--histogram", argv[i])) histogram = true;
+		else ok = false;
+	}
+
+	if (!ok) return InteropReplay_Usage();
+
+	CAfxInteropRecording recording;
+	if (!InteropReplay_Load(argv[2], recording)) return 1;
+
+	AfxInteropReplayStats engineStats;
+	AfxInteropReplayStats clientStats;
+
+	for (int i = 0; i < repeat; ++i)
+	{
+		CInteropReplayConnection connection;
+
+		if (!connection.Connect(sharedMemory))
+		{
+			fprintf(stderr, "Error: Could not create the transport.\n");
+			return 1;
+		}
+
+		bool clientResult = false;
+		std::thread clientThread(InteropReplay_ReplayClient, &recording, connection.GetClient(), &clientStats, &clientResult);
+
+		bool engineResult = recording.Replay(true, connection.GetEngine(), engineStats);
+
+		connection.CloseEngine();
+		clientThread.join();
+
+		if (!engineResult || !clientResult)
+		{
+			fprintf(stderr, "Error: Replay failed (engine: %s, client: %s).\n", engineResult ? "ok" : "failed", clientResult ? "ok" : "failed");
+			return 1;
+		}
+	}
+
+	printf("Transport: %s, %i run(s)\n\nEngine side (round trips):\n", sharedMemory ? "sharedMemory" : "pipe", repeat);
+	InteropReplay_PrintLatencies(engineStats, histogram);
+	InteropReplay_PrintThroughput(engineStats);
+
+	printf("\nClient side (engine turnaround):\n");
+	InteropReplay_PrintLatencies(clientStats, histogram);
+	InteropReplay_PrintThroughput(clientStats);
+
+	return 0;
+}
+
+static int InteropReplay_Play(int argc, char * argv[])
+{
+	int side = -1;
+	char const * name = nullptr;
+	bool histogram = false;
+
+	bool ok = 3 <= argc;
+
+	for (int i = 3; ok && i < argc; ++i)
+	{
+		if (0 == strcmp("--side", argv[i]) && i + 1 < argc && (0 == strcmp("engine", argv[i + 1]) || 0 == strcmp("client", argv[i + 1])))
+		{
+			side = 0 == strcmp("engine", argv[i + 1]) ? 1 : 0;
+			++i;
+		}
+		else if (0 == strcmp("--name", argv[i]) && i + 1 < argc) name = argv[++i];
+		else if (0 == strcmp("--histogram", argv[i])) histogram = true;
+		else ok = false;
+	}
+
+	if (!ok || -1 == side || nullptr == name) return InteropReplay_Usage();
+
+	CAfxInteropRecording recording;
+	if (!InteropReplay_Load(argv[2], recording)) return 1;
+
+	CAfxInteropSharedMemoryTransport transport;
+
+	if (1 == side ? !transport.Open(name) : !transport.Create(name))
+	{
+		fprintf(stderr, "Error: Could not %s the shared memory %s.\n", 1 == side ? "open" : "create", name);
+		return 1;
+	}
+
+	AfxInteropReplayStats stats;
+
+	bool result = recording.Replay(1 == side, &transport, stats);
+
+	transport.Close();
+
+	InteropReplay_PrintLatencies(stats, histogram);
+	InteropReplay_PrintThroughput(stats);
+
+	if (!result)
+	{
+		fprintf(stderr, "Error: The other side disconnected after %zu of %zu exchanges.\n", stats.Exchanges, recording.GetExchanges().size());
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	setlocale(LC_ALL, "");
+
+	if (argc < 2) return InteropReplay_Usage();
+
+	if (0 == strcmp("synth", argv[1])) return InteropReplay_Synth(argc, argv);
+	if (0 == strcmp("stat", argv[1])) return InteropReplay_Stat(argc, argv);
+	if (0 == strcmp("bench", argv[1])) return InteropReplay_Bench(argc, argv);
+	if (0 == strcmp("play", argv[1])) return InteropReplay_Play(argc, argv);
+
+	return InteropReplay_Usage();
+}
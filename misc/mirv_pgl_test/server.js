@@ -44,14 +44,80 @@ function findDelim(buffer,idx)
 	return delim;
 }
 
-function BufferReader(buffer)
+// Protocol state that lasts between messages (see "Version 4" in AfxHookSource/MirvPgl.h).
+function PglState()
+{
+	this.version = 2;
+	this.reset();
+}
+
+PglState.prototype.reset = function reset() {
+	this.strings = [];
+	this.cam = new Uint32Array(8);
+};
+
+var pglCmds = ['hello', 'dataStart', 'dataStop', 'levelInit', 'levelShutdown', 'cam', 'gameEvent'];
+
+function BufferReader(buffer, pglState)
 {
 	this.buffer = buffer
 	this.index = 0;
+	this.pglState = pglState;
 }
 
+BufferReader.prototype.readVarUInt = function readVarUInt() {
+	var result = bigInt(0);
+	var shift = 0;
+	var byte;
+	
+	do
+	{
+		byte = this.readUInt8();
+		result = result.or(bigInt(byte & 0x7f).shiftLeft(shift));
+		shift += 7;
+	}
+	while(byte & 0x80);
+	
+	return result;
+};
+
+BufferReader.prototype.readZigZag = function readZigZag() {
+	var value = this.readVarUInt().toJSNumber();
+	
+	return (value % 2) ? -(value + 1) / 2 : value / 2;
+};
+
+BufferReader.prototype.readCmd = function readCmd() {
+	if(4 <= this.pglState.version)
+	{
+		var cmd = pglCmds[this.readVarUInt().toJSNumber()];
+		if(undefined === cmd) throw "BufferReader.prototype.readCmd";
+		return cmd;
+	}
+	
+	return this.readCString();
+};
+
+BufferReader.prototype.readCam = function readCam() {
+	var result = [];
+	
+	for(var i = 0; i < 8; ++i)
+	{
+		if(4 <= this.pglState.version)
+		{
+			this.pglState.cam[i] ^= this.readVarUInt().toJSNumber();
+			result.push(new Float32Array(this.pglState.cam.buffer, 4 * i, 1)[0]);
+		}
+		else result.push(this.readFloatLE());
+	}
+	
+	return result;
+};
+
 BufferReader.prototype.readBigUInt64LE = function readBigUInt64LE(base) {
 	
+	if(4 <= this.pglState.version) return this.readVarUInt();
+	
 	var lo = this.readUInt32LE()
 	var hi = this.readUInt32LE();
 	
@@ -66,6 +132,8 @@ BufferReader.prototype.readUInt32LE = function readInt32LE() {
 };
 
 BufferReader.prototype.readInt32LE = function readInt32LE() {
+	if(4 <= this.pglState.version) return this.readZigZag();
+	
 	var result = this.buffer.readInt32LE(this.index);
 	this.index += 4;
 	
@@ -73,6 +141,8 @@ BufferReader.prototype.readInt32LE = function readInt32LE() {
 };
 
 BufferReader.prototype.readInt16LE = function readInt16LE() {
+	if(4 <= this.pglState.version) return this.readZigZag();
+	
 	var result = this.buffer.readInt16LE(this.index);
 	this.index += 2;
 	
@@ -106,12 +176,28 @@ BufferReader.prototype.readFloatLE = function readFloatLE() {
 
 BufferReader.prototype.readCString = function readCString()
 {
+	var reference = 1;
+	
+	if(4 <= this.pglState.version)
+	{
+		reference = this.readVarUInt().toJSNumber();
+		
+		if(2 <= reference)
+		{
+			var interned = this.pglState.strings[reference - 2];
+			if(undefined === interned) throw "BufferReader.prototype.readCString";
+			return interned;
+		}
+	}
+	
 	var delim = findDelim(this.buffer, this.index);
 	if(this.index <= delim)
 	{
 		var result = this.buffer.toString('utf8', this.index, delim);
 		this.index = delim + 1;
 		
+		if(0 == reference) this.pglState.strings.push(result);
+		
 		return result;
 	}
 	
@@ -296,7 +382,8 @@ Console.prototype.print = function print(msg) {
 var ws = null;
 var wsConsole = new Console();
 var server = http.createServer();
-var wss = new WebSocketServer({server: server, path: '/mirv'});
+// perMessageDeflate: Accept compression if the client offers it (mirv_pgl deflate 1).
+var wss = new WebSocketServer({server: server, path: '/mirv', perMessageDeflate: true});
 
 wsConsole.on('close', function close() {
   if (ws) ws.close();
@@ -587,17 +674,18 @@ wss.on('connection', function(newWs) {
 	wsConsole.print('/mirv	 connected');
 	
 	var gameEventUnserializer = new GameEventUnserializer(enrichments);
+	var pglState = new PglState();
 	
     ws.on('message', function(data) {
         if (data instanceof Buffer)
 		{
-			var bufferReader = new BufferReader(Buffer.from(data));
+			var bufferReader = new BufferReader(Buffer.from(data), pglState);
 			
 			try
 			{
 				while(!bufferReader.eof())
 				{
-					var cmd = bufferReader.readCString();
+					var cmd = bufferReader.readCmd();
 					wsConsole.print(cmd);
 					
 					switch(cmd)
@@ -606,12 +694,26 @@ wss.on('connection', function(newWs) {
 						{
 							var version = bufferReader.readUInt32LE();
 							wsConsole.print('version = '+version);
+							
+							if(4 == version)
+							{
+								// Switched (as requested below), the following messages are in version 4:
+								pglState.version = 4;
+								pglState.reset();
+								break;
+							}
+							
 							if(2 != version) throw "Error: version mismatch";
 							
 							ws.send(new Uint8Array(Buffer.from(
 								'transBegin\0'
 							,'utf8')), {binary: true});
 							
+							// Request the more compact version 4:
+							ws.send(new Uint8Array(Buffer.from(
+								'exec\0mirv_pgl protocol 4\0','utf8'
+							)), {binary: true});
+							
 							ws.send(new Uint8Array(Buffer.from(
 								'exec\0mirv_pgl events enrich clientTime 1\0','utf8'
 							)), {binary: true});
@@ -647,6 +749,7 @@ wss.on('connection', function(newWs) {
 					case 'dataStart':
 						break;
 					case 'dataStop':
+						pglState.reset();
 						break;
 					case 'levelInit':
 						{
@@ -658,22 +761,15 @@ wss.on('connection', function(newWs) {
 						break;
 					case 'cam':
 						{
-							var time = bufferReader.readFloatLE();
-							wsConsole.print('time = '+time);
-							var xPosition = bufferReader.readFloatLE();
-							wsConsole.print('xPosition = '+xPosition);
-							var yPosition = bufferReader.readFloatLE();
-							wsConsole.print('yPosition = '+yPosition);
-							var zPosition = bufferReader.readFloatLE();
-							wsConsole.print('zPosition = '+zPosition);
-							var xRotation = bufferReader.readFloatLE();
-							wsConsole.print('xRotation = '+xRotation);
-							var yRotation = bufferReader.readFloatLE();
-							wsConsole.print('yRotation = '+yRotation);
-							var zRotation = bufferReader.readFloatLE();
-							wsConsole.print('zRotation = '+zRotation);
-							var fov = bufferReader.readFloatLE();
-							wsConsole.print('fov = '+fov);
+							var cam = bufferReader.readCam();
+							wsConsole.print('time = '+cam[0]);
+							wsConsole.print('xPosition = '+cam[1]);
+							wsConsole.print('yPosition = '+cam[2]);
+							wsConsole.print('zPosition = '+cam[3]);
+							wsConsole.print('xRotation = '+cam[4]);
+							wsConsole.print('yRotation = '+cam[5]);
+							wsConsole.print('zRotation = '+cam[6]);
+							wsConsole.print('fov = '+cam[7]);
 						}
 						break;
 					case 'gameEvent':
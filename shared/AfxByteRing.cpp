@@ -0,0 +1,108 @@
+#include "stdafx.h"
+
+#include "AfxByteRing.h"
+
+#include <assert.h>
+#include <string.h>
+
+CAfxByteRing::CAfxByteRing(size_t capacity)
+: m_Capacity(1)
+, m_Write(0)
+, m_Published(0)
+, m_Read(0)
+{
+	while (m_Capacity < capacity)
+		m_Capacity <<= 1;
+
+	m_Data = new unsigned char[m_Capacity];
+}
+
+CAfxByteRing::~CAfxByteRing()
+{
+	delete[] m_Data;
+}
+
+size_t CAfxByteRing::GetCapacity(void) const
+{
+	return m_Capacity;
+}
+
+void CAfxByteRing::Reset(void)
+{
+	m_Write = 0;
+	m_Published.store(0, std::memory_order_relaxed);
+	m_Read.store(0, std::memory_order_relaxed);
+}
+
+bool CAfxByteRing::Write(void const * data, size_t size)
+{
+	size_t read = m_Read.load(std::memory_order_acquire);
+
+	if (m_Capacity - (m_Write - read) < size)
+		return false;
+
+	size_t offset = m_Write & (m_Capacity - 1);
+	size_t first = m_Capacity - offset;
+
+	if (size < first)
+		first = size;
+
+	memcpy(m_Data + offset, data, first);
+	memcpy(m_Data, (unsigned char const *)data + first, size - first);
+
+	m_Write += size;
+
+	return true;
+}
+
+size_t CAfxByteRing::GetWritePosition(void) const
+{
+	return m_Write;
+}
+
+size_t CAfxByteRing::GetUsed(void) const
+{
+	return m_Write - m_Read.load(std::memory_order_acquire);
+}
+
+void CAfxByteRing::Truncate(size_t position)
+{
+	assert(position - m_Published.load(std::memory_order_relaxed) <= m_Write - m_Published.load(std::memory_order_relaxed));
+
+	m_Write = position;
+}
+
+void CAfxByteRing::Publish(size_t position)
+{
+	m_Published.store(position, std::memory_order_release);
+}
+
+size_t CAfxByteRing::GetPublishedPosition(void) const
+{
+	return m_Published.load(std::memory_order_relaxed);
+}
+
+size_t CAfxByteRing::GetReadable(unsigned char const * outData[2], size_t outSize[2]) const
+{
+	size_t published = m_Published.load(std::memory_order_acquire);
+	size_t read = m_Read.load(std::memory_order_relaxed);
+
+	size_t size = published - read;
+	size_t offset = read & (m_Capacity - 1);
+	size_t first = m_Capacity - offset;
+
+	if (size < first)
+		first = size;
+
+	outData[0] = m_Data + offset;
+	outSize[0] = first;
+	outData[1] = m_Data;
+	outSize[1] = size - first;
+
+	return size;
+}
+
+void CAfxByteRing::Consume(size_t size)
+{
+	m_Read.store(m_Read.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
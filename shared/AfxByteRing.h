@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+
+/// <summary>
+///   Single producer, single consumer byte ring.<br />
+///   The producer serializes into the ring in place and publishes what it
+///   wrote up to a position, the consumer reads the published bytes as (at
+///   most two) slices of the ring, without them being copied in between.
+/// </summary>
+/// <remarks>
+///   Positions count the bytes written since Reset and wrap around like
+///   size_t does, only their differences are meaningful.<br />
+///   Write, Truncate and GetWritePosition must only be called by the
+///   producer. Publish can also be called by another thread the producer
+///   hands positions to, the producer must not truncate before such a
+///   position then (unless it made sure it won't be published).
+///   GetReadable and Consume must only be called by the consumer.
+/// </remarks>
+class CAfxByteRing
+{
+public:
+	/// <param name="capacity">Is rounded up to a power of 2.</param>
+	CAfxByteRing(size_t capacity);
+
+	~CAfxByteRing();
+
+	size_t GetCapacity(void) const;
+
+	/// <summary>Discards all bytes.</summary>
+	/// <remarks>Neither the producer nor the consumer must use the ring meanwhile.</remarks>
+	void Reset(void);
+
+	//
+	// Producer:
+
+	/// <returns>false if there is not enough free space, nothing is written then.</returns>
+	bool Write(void const * data, size_t size);
+
+	size_t GetWritePosition(void) const;
+
+	/// <summary>Number of bytes written, but not consumed yet.</summary>
+	size_t GetUsed(void) const;
+
+	/// <summary>Discards the bytes written from position on.</summary>
+	/// <param name="position">Must not be before the published position.</param>
+	void Truncate(size_t position);
+
+	/// <summary>Makes the bytes written up to position readable for the consumer.</summary>
+	/// <param name="position">Must not be before the published position or after the write position.</param>
+	void Publish(size_t position);
+
+	size_t GetPublishedPosition(void) const;
+
+	//
+	// Consumer:
+
+	/// <summary>Gets the published bytes that have not been consumed yet.</summary>
+	/// <param name="outData">The bytes are outData[0] (outSize[0] bytes) followed by outData[1] (outSize[1] bytes).</param>
+	/// <returns>outSize[0] + outSize[1].</returns>
+	size_t GetReadable(unsigned char const * outData[2], size_t outSize[2]) const;
+
+	/// <summary>Frees size bytes of the readable bytes for the producer.</summary>
+	void Consume(size_t size);
+
+private:
+	unsigned char * m_Data;
+	size_t m_Capacity;
+
+	size_t m_Write;
+	std::atomic<size_t> m_Published;
+	std::atomic<size_t> m_Read;
+};
@@ -1,14 +1,19 @@
 #pragma once
 
-#include <Windows.h>
-
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+
 class CAfxColorLut
 {
 public:
-	template<typename ... SubTs> class CDimensions;
+	/// <remarks>The primary template is the (empty) innermost dimension.</remarks>
+	template<typename ... SubTs> class CDimensions
+	{
+	public:
+	};
 
 	template<typename ... SubTs> class CDimensions<size_t, SubTs ...>
 	{
@@ -44,11 +49,6 @@ public:
 		CDimensions<SubTs ...> m_Sub;
 	};
 
-	template<> class CDimensions<>
-	{
-	public:
-	};
-
 	bool New (size_t resR, size_t resG, size_t resB, size_t resA)
 	{
 		delete m_Root;
@@ -97,7 +97,7 @@ public:
 	{
 		char magic[sizeof(m_Magic) / sizeof(m_Magic[0])];
 		int version;
-		unsigned __int32 resR, resG, resB, resA;
+		uint32_t resR, resG, resB, resA;
 
 		if (1 != fread(magic, sizeof(magic), 1, file)
 			|| '\0' != magic[sizeof(magic) / sizeof(magic[0]) - 1]
@@ -131,10 +131,10 @@ public:
 
 		int version = 1;
 
-		unsigned __int32 resR = m_Dimensions.GetSize();
-		unsigned __int32 resG = m_Dimensions.GetSub().GetSize();
-		unsigned __int32 resB = m_Dimensions.GetSub().GetSub().GetSize();
-		unsigned __int32 resA = m_Dimensions.GetSub().GetSub().GetSub().GetSize();
+		uint32_t resR = (uint32_t)m_Dimensions.GetSize();
+		uint32_t resG = (uint32_t)m_Dimensions.GetSub().GetSize();
+		uint32_t resB = (uint32_t)m_Dimensions.GetSub().GetSub().GetSize();
+		uint32_t resA = (uint32_t)m_Dimensions.GetSub().GetSub().GetSub().GetSize();
 
 		if (1 != fwrite(m_Magic, sizeof(m_Magic), 1, file)
 			|| 1 != fwrite(&version, sizeof(version), 1, file)
@@ -221,7 +221,7 @@ public:
 
 		CRgba() {}
 		CRgba(float r, float g, float b, float a) : R(r), G(g), B(b), A(a) {}
-		CRgba(const CRgbaUc & val) : R(max(0,min(val.R / 255.0f,1))), G(max(0, min(val.G / 255.0f, 1))), B(max(0, min(val.B / 255.0f, 1))), A(max(0, min(val.A / 255.0f, 1))) {}
+		CRgba(const CRgbaUc & val) : R((std::max)(0.0f, (std::min)(val.R / 255.0f, 1.0f))), G((std::max)(0.0f, (std::min)(val.G / 255.0f, 1.0f))), B((std::max)(0.0f, (std::min)(val.B / 255.0f, 1.0f))), A((std::max)(0.0f, (std::min)(val.A / 255.0f, 1.0f))) {}
 		CRgba(const CRgba& other) : R(other.R), G(other.G), B(other.B), A(other.A) {}
 
 		bool operator<(const CRgba& other) const
@@ -281,7 +281,8 @@ public:
 
 	bool Query(float r, float g, float b, float a, float& outR, float& outG, float& outB, float& outA);
 
-	typedef BOOL (CALLBACK * IteratePutCallback_t)(float r, float g, float b, float a, float & outR, float & outG, float & outB, float & outA);
+	/// <remarks>Same as BOOL (CALLBACK *)(...), so it can be marshalled from a delegate.</remarks>
+	typedef int (__stdcall * IteratePutCallback_t)(float r, float g, float b, float a, float & outR, float & outG, float & outB, float & outA);
 
 	bool IteratePut(IteratePutCallback_t callBack)
 	{
@@ -315,10 +316,10 @@ public:
 						}
 
 						CRgbaUc* val = rootA->GetValue(resA, a);
-						val->R = (unsigned char)min(max(0, outR * 255.0f), 255.0f);
-						val->G = (unsigned char)min(max(0, outG * 255.0f), 255.0f);
-						val->B = (unsigned char)min(max(0, outB * 255.0f), 255.0f);
-						val->A = (unsigned char)min(max(0, outA * 255.0f), 255.0f);
+						val->R = (unsigned char)(std::min)((std::max)(0.0f, outR * 255.0f), 255.0f);
+						val->G = (unsigned char)(std::min)((std::max)(0.0f, outG * 255.0f), 255.0f);
+						val->B = (unsigned char)(std::min)((std::max)(0.0f, outB * 255.0f), 255.0f);
+						val->A = (unsigned char)(std::min)((std::max)(0.0f, outA * 255.0f), 255.0f);
 					}
 				}
 			}
@@ -372,7 +373,7 @@ private:
 			}
 
 			float fIndex = key * (count - 1);
-			size_t index = min(max(0, (size_t)(fIndex)), count - 1);
+			size_t index = (std::min)((std::max)((size_t)0, (size_t)(fIndex)), count - 1);
 
 			if (other && index +  1< count)
 			{
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+/// <summary>
+///   Values by event id (i.e. compiled game event serialization plans or
+///   white / black list decisions), so they are only made on the first
+///   event of a type.
+/// </summary>
+/// <remarks>
+///   The game assigns the ids again when it receives a new game event list
+///   (i.e. from a new server or demo), so an entry remembers the name and
+///   identity (i.e. the descriptor's keys) of the event it was made for and
+///   is made again if they differ.
+/// </remarks>
+template<typename TValue> class CAfxEventIdCache
+{
+public:
+	/// <param name="outStale">Is set to true if the value has been reset to TValue() and has to be made (again).</param>
+	TValue & Get(size_t id, char const * name, void const * identity, bool & outStale)
+	{
+		if (m_Entries.size() <= id)
+			m_Entries.resize(id + 1);
+
+		Entry & entry = m_Entries[id];
+
+		if (entry.Valid && entry.Identity == identity && 0 == strcmp(entry.Name.c_str(), name))
+		{
+			outStale = false;
+			return entry.Value;
+		}
+
+		entry.Valid = true;
+		entry.Identity = identity;
+		entry.Name = name;
+		entry.Value = TValue();
+
+		outStale = true;
+		return entry.Value;
+	}
+
+	/// <summary>Makes all values stale.</summary>
+	void Clear(void)
+	{
+		m_Entries.clear();
+	}
+
+private:
+	struct Entry
+	{
+		bool Valid = false;
+		void const * Identity = nullptr;
+		std::string Name;
+		TValue Value = TValue();
+	};
+
+	std::vector<Entry> m_Entries;
+};
@@ -0,0 +1,53 @@
+#include "stdafx.h"
+
+#include "AfxFileCache.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+bool AfxFileIdentity_Get(char const * fileName, AfxFileIdentity & outIdentity)
+{
+	// No access asked, so this doesn't conflict with writers or the file being open:
+	HANDLE file = CreateFileA(fileName, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+
+	BY_HANDLE_FILE_INFORMATION info;
+	bool result = 0 != GetFileInformationByHandle(file, &info);
+
+	CloseHandle(file);
+
+	if (!result)
+		return false;
+
+	outIdentity.Device = info.dwVolumeSerialNumber;
+	outIdentity.Index = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+	outIdentity.Size = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	outIdentity.LastWriteTime = (long long)(((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+
+	return true;
+}
+
+#else
+
+bool AfxFileIdentity_Get(char const * fileName, AfxFileIdentity & outIdentity)
+{
+	struct stat info;
+
+	if (0 != stat(fileName, &info))
+		return false;
+
+	outIdentity.Device = (unsigned long long)info.st_dev;
+	outIdentity.Index = (unsigned long long)info.st_ino;
+	outIdentity.Size = (unsigned long long)info.st_size;
+	outIdentity.LastWriteTime = (long long)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+/// <summary>
+///   What a version of a file is recognized by: the file itself (volume and
+///   file index on Windows, device and inode otherwise), its size and the
+///   time it was last written.
+/// </summary>
+struct AfxFileIdentity
+{
+	unsigned long long Device = 0;
+	unsigned long long Index = 0;
+	unsigned long long Size = 0;
+	long long LastWriteTime = 0;
+
+	bool operator == (AfxFileIdentity const & other) const
+	{
+		return Device == other.Device && Index == other.Index && Size == other.Size && LastWriteTime == other.LastWriteTime;
+	}
+
+	bool operator != (AfxFileIdentity const & other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/// <returns>false if the file can't be found.</returns>
+bool AfxFileIdentity_Get(char const * fileName, AfxFileIdentity & outIdentity);
+
+/// <summary>
+///   Shares what has been made from a file (i.e. its memory mapping and an
+///   index) between the users of the file name, for as long as the file is
+///   not replaced or written to.
+/// </summary>
+/// <remarks>
+///   The values are not owned, a value's owner has to Remove it before it's
+///   deleted.
+/// </remarks>
+template<class TValue> class CAfxFileCache
+{
+public:
+	/// <returns>The value cached for fileName, nullptr if there is none or if the file changed since.</returns>
+	TValue * Find(char const * fileName) const
+	{
+		typename std::map<std::string, Entry>::const_iterator it = m_Entries.find(fileName);
+
+		if (it == m_Entries.end())
+			return nullptr;
+
+		AfxFileIdentity identity;
+
+		if (!AfxFileIdentity_Get(fileName, identity) || identity != it->second.Identity)
+			return nullptr;
+
+		return it->second.Value;
+	}
+
+	/// <summary>Caches value for fileName, an older value for fileName is forgotten (but stays valid for its users).</summary>
+	/// <param name="identity">Identity of the file value has been made from.</param>
+	void Add(char const * fileName, AfxFileIdentity const & identity, TValue * value)
+	{
+		Entry & entry = m_Entries[fileName];
+		entry.Identity = identity;
+		entry.Value = value;
+	}
+
+	/// <summary>Removes value, if it's (still) the one cached for fileName.</summary>
+	void Remove(char const * fileName, TValue * value)
+	{
+		typename std::map<std::string, Entry>::iterator it = m_Entries.find(fileName);
+
+		if (it != m_Entries.end() && it->second.Value == value)
+			m_Entries.erase(it);
+	}
+
+private:
+	struct Entry
+	{
+		AfxFileIdentity Identity;
+		TValue * Value = nullptr;
+	};
+
+	std::map<std::string, Entry> m_Entries;
+};
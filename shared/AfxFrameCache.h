@@ -0,0 +1,195 @@
+#pragma once
+
+// Memoizes the results of expression graphs (i.e. mirv_calcs) per frame,
+// so a node that several consumers (and other nodes) ask for in a frame
+// is evaluated only once.
+
+/// <summary>
+///   Frame stamps for CAfxFrameCached results: a result is valid until the
+///   frame ends or Invalidate is called.
+/// </summary>
+/// <remarks>
+///   Outside BeginFrame / EndFrame nothing is cached, so whoever asks
+///   then (i.e. while the entities are not set up for rendering yet) gets
+///   an evaluation as before.
+/// </remarks>
+class CAfxFrameCacheClock
+{
+public:
+	CAfxFrameCacheClock()
+		: m_Stamp(1)
+		, m_InFrame(false)
+		, m_Volatile(false)
+		, m_Enabled(true)
+		, m_Evaluations(0)
+		, m_Hits(0)
+		, m_LastEvaluations(0)
+		, m_LastHits(0)
+	{
+	}
+
+	/// <summary>Results of earlier frames become invalid, results are cached until EndFrame.</summary>
+	void BeginFrame(void)
+	{
+		NextStamp();
+		m_InFrame = true;
+
+		m_LastEvaluations = m_Evaluations;
+		m_LastHits = m_Hits;
+		m_Evaluations = 0;
+		m_Hits = 0;
+	}
+
+	void EndFrame(void)
+	{
+		m_InFrame = false;
+	}
+
+	/// <summary>Invalidates all results, i.e. after a node's parameters or the graph changed.</summary>
+	void Invalidate(void)
+	{
+		NextStamp();
+	}
+
+	/// <summary>Default is true, false evaluates each time a result is asked for (for comparison).</summary>
+	void SetEnabled(bool value)
+	{
+		m_Enabled = value;
+		NextStamp();
+	}
+
+	bool GetEnabled(void) const
+	{
+		return m_Enabled;
+	}
+
+	/// <returns>The stamp of the current results, 0 if results must not be cached.</returns>
+	unsigned int GetStamp(void) const
+	{
+		return m_InFrame && m_Enabled ? m_Stamp : 0;
+	}
+
+	/// <summary>
+	///   Called by a node while it is evaluated, if its result can change
+	///   within a frame (i.e. it reads the current view): neither it nor the
+	///   nodes depending on it are cached then.
+	/// </summary>
+	void MarkVolatile(void)
+	{
+		m_Volatile = true;
+	}
+
+	/// <summary>Used by CAfxFrameCached around an evaluation.</summary>
+	bool ExchangeVolatile(bool value)
+	{
+		bool result = m_Volatile;
+		m_Volatile = value;
+		return result;
+	}
+
+	void CountEvaluation(void)
+	{
+		++m_Evaluations;
+	}
+
+	void CountHit(void)
+	{
+		++m_Hits;
+	}
+
+	/// <summary>Evaluations in the current frame (outside frames: since the last frame).</summary>
+	unsigned int GetEvaluations(void) const
+	{
+		return m_Evaluations;
+	}
+
+	/// <summary>Results served from the cache in the current frame.</summary>
+	unsigned int GetHits(void) const
+	{
+		return m_Hits;
+	}
+
+	/// <summary>Evaluations in the previous frame (including after its EndFrame).</summary>
+	unsigned int GetLastEvaluations(void) const
+	{
+		return m_LastEvaluations;
+	}
+
+	unsigned int GetLastHits(void) const
+	{
+		return m_LastHits;
+	}
+
+private:
+	unsigned int m_Stamp;
+	bool m_InFrame;
+	bool m_Volatile;
+	bool m_Enabled;
+	unsigned int m_Evaluations;
+	unsigned int m_Hits;
+	unsigned int m_LastEvaluations;
+	unsigned int m_LastHits;
+
+	void NextStamp(void)
+	{
+		++m_Stamp;
+		if (0 == m_Stamp) m_Stamp = 1;
+	}
+};
+
+/// <summary>A node's result, valid for one stamp of a CAfxFrameCacheClock.</summary>
+template<typename TValue> class CAfxFrameCached
+{
+public:
+	CAfxFrameCached()
+		: m_Stamp(0)
+		, m_Result(false)
+	{
+	}
+
+	/// <summary>
+	///   Returns the cached result if there is one, otherwise calls
+	///   evaluate(outValue) and caches what it returns.
+	/// </summary>
+	/// <remarks>outValue is only set if the result is true.</remarks>
+	template<typename TEvaluate> bool Get(CAfxFrameCacheClock & clock, TValue & outValue, TEvaluate evaluate)
+	{
+		unsigned int stamp = clock.GetStamp();
+
+		if (0 != stamp && stamp == m_Stamp)
+		{
+			clock.CountHit();
+			if (m_Result) outValue = m_Value;
+			return m_Result;
+		}
+
+		clock.CountEvaluation();
+
+		bool outerVolatile = clock.ExchangeVolatile(false);
+
+		TValue value;
+		bool result = evaluate(value);
+
+		bool isVolatile = clock.ExchangeVolatile(outerVolatile);
+
+		// Whoever asked for this depends on what this depends on:
+		if (isVolatile) clock.MarkVolatile();
+
+		if (result) outValue = value;
+
+		// If the clock advanced meanwhile, the result is stale already:
+		if (!isVolatile && 0 != stamp && stamp == clock.GetStamp())
+		{
+			m_Stamp = stamp;
+			m_Result = result;
+			if (result) m_Value = value;
+		}
+
+		return result;
+	}
+
+private:
+	unsigned int m_Stamp;
+	bool m_Result;
+	TValue m_Value;
+};
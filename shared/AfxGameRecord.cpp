@@ -0,0 +1,1420 @@
+#include "stdafx.h"
+
+#include "AfxGameRecord.h"
+
+#include <zlib.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+/// <summary>Positions are stored in 1/AFXGAMERECORD_POSITION_SCALE units in version 6.</summary>
+#define AFXGAMERECORD_POSITION_SCALE 1024.0
+
+/// <summary>Positions are clamped to this, so that deltas can't overflow.</summary>
+#define AFXGAMERECORD_MAX_POSITION 1000000.0
+
+/// <summary>Max. value of a quantized quaternion component (15 bits).</summary>
+#define AFXGAMERECORD_ROTATION_MAX 32767
+
+/// <summary>Size of reads from version 5 files.</summary>
+#define AFXGAMERECORD_READ_SIZE (64 * 1024)
+
+/// <summary>Max. encoded size of a bone: 6 varints of max. 5 bytes.</summary>
+#define AFXGAMERECORD_MAX_BONE_SIZE (6 * 5)
+
+static unsigned char * AfxGameRecord_WriteVarUInt(unsigned int value, unsigned char * out)
+{
+	while (0x80 <= value)
+	{
+		*out = (unsigned char)(value | 0x80);
+		++out;
+		value >>= 7;
+	}
+
+	*out = (unsigned char)value;
+
+	return out + 1;
+}
+
+static bool AfxGameRecord_ReadVarUInt(unsigned char const * & inOutPos, unsigned char const * end, unsigned int & outValue)
+{
+	unsigned int value = 0;
+
+	for (int shift = 0; shift < 35 && inOutPos < end; shift += 7)
+	{
+		unsigned char byte = *inOutPos;
+		++inOutPos;
+
+		value |= (unsigned int)(byte & 0x7f) << shift;
+
+		if (0 == (byte & 0x80))
+		{
+			outValue = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>Rounds to nearest (away from zero on ties), value must be in int range.</summary>
+static int AfxGameRecord_Round(double value)
+{
+	return value < 0 ? -(int)(0.5 - value) : (int)(value + 0.5);
+}
+
+static unsigned int AfxGameRecord_ZigZag(int value)
+{
+	return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int AfxGameRecord_UnZigZag(unsigned int value)
+{
+	return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+// CAfxGameRecordBoneCoder /////////////////////////////////////////////////////
+
+CAfxGameRecordBoneCoder::CAfxGameRecordBoneCoder()
+: m_Generation(1)
+, m_Bones(0)
+, m_NextBone(0)
+{
+}
+
+void CAfxGameRecordBoneCoder::Reset(void)
+{
+	// Entities that were used since the last reset keep their memory, so
+	// coding doesn't allocate at every block start:
+	for (std::map<int, Entity>::iterator it = m_Entities.begin(); it != m_Entities.end(); )
+	{
+		if (it->second.Generation != m_Generation)
+			it = m_Entities.erase(it);
+		else
+			++it;
+	}
+
+	++m_Generation;
+	m_Bones = 0;
+	m_NextBone = 0;
+}
+
+void CAfxGameRecordBoneCoder::BeginBones(int entityHandle, int numBones)
+{
+	if (numBones < 0) numBones = 0;
+
+	Entity & entity = m_Entities[entityHandle];
+
+	m_Bones = &entity.Bones;
+	m_NextBone = 0;
+
+	if (entity.Generation != m_Generation || m_Bones->size() != (size_t)numBones)
+	{
+		Bone bone;
+		for (int i = 0; i < 3; ++i)
+		{
+			bone.Position[i] = 0;
+			bone.Rotation[i] = 0;
+		}
+		bone.RotationIndex = 3;
+
+		m_Bones->assign(numBones, bone);
+
+		entity.Generation = m_Generation;
+	}
+}
+
+CAfxGameRecordBoneCoder::Bone * CAfxGameRecordBoneCoder::NextBone(void)
+{
+	if (!m_Bones || m_Bones->size() <= m_NextBone)
+		return 0;
+
+	return &(*m_Bones)[m_NextBone++];
+}
+
+void CAfxGameRecordBoneCoder::EncodeBone(float const position[3], float const rotation[4], std::vector<unsigned char> & out)
+{
+	unsigned char data[AFXGAMERECORD_MAX_BONE_SIZE];
+	unsigned char * pData = data;
+
+	Bone dummy;
+	Bone * bone = NextBone();
+	if (!bone)
+	{
+		// Called more often than announced, keep the stream decodable at least:
+		bone = &dummy;
+		for (int i = 0; i < 3; ++i) { dummy.Position[i] = 0; dummy.Rotation[i] = 0; }
+		dummy.RotationIndex = 3;
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		double value = position[i];
+
+		if (!(-AFXGAMERECORD_MAX_POSITION <= value)) value = value != value ? 0.0 : -AFXGAMERECORD_MAX_POSITION; // NaN or too small
+		if (AFXGAMERECORD_MAX_POSITION < value) value = AFXGAMERECORD_MAX_POSITION;
+
+		int quantized = AfxGameRecord_Round(value * AFXGAMERECORD_POSITION_SCALE);
+
+		pData = AfxGameRecord_WriteVarUInt(AfxGameRecord_ZigZag(quantized - bone->Position[i]), pData);
+		bone->Position[i] = quantized;
+	}
+
+	double q[4] = { rotation[0], rotation[1], rotation[2], rotation[3] };
+	double length = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+
+	if (!(0 < length && length < 1e10))
+	{
+		// Invalid (e.g. NaN), use identity:
+		q[0] = 0; q[1] = 0; q[2] = 0; q[3] = 1;
+		length = 1;
+	}
+
+	int largestIndex = 0;
+	for (int i = 1; i < 4; ++i)
+	{
+		if (fabs(q[largestIndex]) < fabs(q[i])) largestIndex = i;
+	}
+
+	// q and -q are the same rotation, so make the dropped component positive:
+	double scale = (q[largestIndex] < 0 ? -1.0 : 1.0) / length;
+
+	int quantized[3];
+	for (int i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largestIndex) continue;
+
+		// Other components are in [-1/sqrt(2), 1/sqrt(2)]:
+		double value = (q[i] * scale * sqrt(0.5) + 0.5) * AFXGAMERECORD_ROTATION_MAX + 0.5;
+		if (value < 0) value = 0;
+		if (AFXGAMERECORD_ROTATION_MAX < value) value = AFXGAMERECORD_ROTATION_MAX;
+
+		quantized[j++] = (int)value;
+	}
+
+	bool sameIndex = largestIndex == bone->RotationIndex;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned int delta = AfxGameRecord_ZigZag(quantized[i] - (sameIndex ? bone->Rotation[i] : 0));
+
+		pData = AfxGameRecord_WriteVarUInt(0 == i ? (delta << 2) | (unsigned int)largestIndex : delta, pData);
+
+		bone->Rotation[i] = quantized[i];
+	}
+
+	bone->RotationIndex = largestIndex;
+
+	out.insert(out.end(), data, pData);
+}
+
+bool CAfxGameRecordBoneCoder::DecodeBone(unsigned char const * & inOutPos, unsigned char const * end, float outPosition[3], float outRotation[4])
+{
+	Bone * bone = NextBone();
+	if (!bone)
+		return false;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned int delta;
+		if (!AfxGameRecord_ReadVarUInt(inOutPos, end, delta))
+			return false;
+
+		bone->Position[i] += AfxGameRecord_UnZigZag(delta);
+		outPosition[i] = (float)(bone->Position[i] / AFXGAMERECORD_POSITION_SCALE);
+	}
+
+	int largestIndex = 0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned int delta;
+		if (!AfxGameRecord_ReadVarUInt(inOutPos, end, delta))
+			return false;
+
+		if (0 == i)
+		{
+			largestIndex = (int)(delta & 3);
+			delta >>= 2;
+
+			if (largestIndex != bone->RotationIndex)
+			{
+				bone->Rotation[0] = 0;
+				bone->Rotation[1] = 0;
+				bone->Rotation[2] = 0;
+				bone->RotationIndex = largestIndex;
+			}
+		}
+
+		bone->Rotation[i] += AfxGameRecord_UnZigZag(delta);
+	}
+
+	double sum = 0;
+
+	for (int i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largestIndex) continue;
+
+		double value = ((double)bone->Rotation[j++] / AFXGAMERECORD_ROTATION_MAX - 0.5) / sqrt(0.5);
+		sum += value * value;
+		outRotation[i] = (float)value;
+	}
+
+	outRotation[largestIndex] = (float)sqrt(1.0 < sum ? 0.0 : 1.0 - sum);
+
+	return true;
+}
+
+// CAfxGameRecordDictionary ////////////////////////////////////////////////////
+
+/// <summary>Initial number of slots (power of 2), enough for a typical recording.</summary>
+#define AFXGAMERECORD_DICTIONARY_SLOTS 512
+
+CAfxGameRecordDictionary::CAfxGameRecordDictionary()
+{
+	Clear();
+}
+
+void CAfxGameRecordDictionary::Clear(void)
+{
+	Slot empty = { 0, -1 };
+	PointerSlot emptyPointer = { 0, -1 };
+
+	m_Strings.clear();
+	m_Slots.assign(AFXGAMERECORD_DICTIONARY_SLOTS, empty);
+
+	for (size_t i = 0; i < AFXGAMERECORD_DICTIONARY_POINTER_SLOTS; ++i)
+	{
+		m_PointerSlots[i] = emptyPointer;
+	}
+}
+
+unsigned int CAfxGameRecordDictionary::Hash(char const * value, size_t & outLength)
+{
+	// FNV-1a:
+	unsigned int hash = 2166136261u;
+	char const * pos = value;
+
+	for (; *pos; ++pos)
+	{
+		hash ^= (unsigned char)*pos;
+		hash *= 16777619u;
+	}
+
+	outLength = pos - value;
+
+	return hash;
+}
+
+size_t CAfxGameRecordDictionary::GetPointerSlot(char const * value)
+{
+	// Fibonacci hashing of the address:
+	unsigned int address = (unsigned int)(size_t)value;
+
+	return ((address * 2654435761u) >> 24) & (AFXGAMERECORD_DICTIONARY_POINTER_SLOTS - 1);
+}
+
+int CAfxGameRecordDictionary::Lookup(char const * value, bool add)
+{
+	PointerSlot & pointerSlot = m_PointerSlots[GetPointerSlot(value)];
+
+	if (pointerSlot.Pointer == value && 0 == strcmp(value, m_Strings[pointerSlot.Index].c_str()))
+		return pointerSlot.Index;
+
+	size_t length;
+	unsigned int hash = Hash(value, length);
+	size_t mask = m_Slots.size() - 1;
+
+	for (size_t i = hash & mask; ; i = (i + 1) & mask)
+	{
+		Slot & slot = m_Slots[i];
+
+		if (-1 == slot.Index)
+		{
+			if (!add)
+				return -1;
+
+			slot.Hash = hash;
+			slot.Index = (int)m_Strings.size();
+			m_Strings.push_back(std::string(value, length));
+
+			pointerSlot.Pointer = value;
+			pointerSlot.Index = slot.Index;
+
+			// Keep the load factor below 1/2, so probe sequences stay short:
+			if (m_Slots.size() < 2 * m_Strings.size())
+				Grow();
+
+			return -1;
+		}
+
+		if (slot.Hash == hash)
+		{
+			std::string const & str = m_Strings[slot.Index];
+
+			if (str.size() == length && 0 == memcmp(str.c_str(), value, length))
+			{
+				pointerSlot.Pointer = value;
+				pointerSlot.Index = slot.Index;
+
+				return slot.Index;
+			}
+		}
+	}
+}
+
+void CAfxGameRecordDictionary::Grow(void)
+{
+	Slot empty = { 0, -1 };
+	std::vector<Slot> oldSlots(2 * m_Slots.size(), empty);
+
+	m_Slots.swap(oldSlots);
+
+	size_t mask = m_Slots.size() - 1;
+
+	for (size_t i = 0; i < oldSlots.size(); ++i)
+	{
+		if (-1 == oldSlots[i].Index)
+			continue;
+
+		size_t j = oldSlots[i].Hash & mask;
+
+		while (-1 != m_Slots[j].Index) j = (j + 1) & mask;
+
+		m_Slots[j] = oldSlots[i];
+	}
+}
+
+// CAfxGameRecordWriter ////////////////////////////////////////////////////////
+
+CAfxGameRecordWriter::CAfxGameRecordWriter()
+: m_Version(AFXGAMERECORD_VERSION_RAW)
+, m_BlockFrames(0)
+, m_FrameCount(0)
+, m_UnchangedThreshold(-1)
+, m_EntityCount(0)
+, m_UnchangedCount(0)
+, m_UnchangedBytesSaved(0)
+, m_InEntity(false)
+, m_EntityHandle(0)
+, m_EntityGeneration(1)
+{
+}
+
+void CAfxGameRecordWriter::SetUnchangedThreshold(float value)
+{
+	m_UnchangedThreshold = value;
+}
+
+float CAfxGameRecordWriter::GetUnchangedThreshold(void) const
+{
+	return m_UnchangedThreshold;
+}
+
+int CAfxGameRecordWriter::GetEntityCount(void) const
+{
+	return m_EntityCount;
+}
+
+int CAfxGameRecordWriter::GetUnchangedCount(void) const
+{
+	return m_UnchangedCount;
+}
+
+long long CAfxGameRecordWriter::GetUnchangedBytesSaved(void) const
+{
+	return m_UnchangedBytesSaved;
+}
+
+bool CAfxGameRecordWriter::Open(wchar_t const * fileName, int version)
+{
+	Close();
+
+	if (version != AFXGAMERECORD_VERSION_RAW && version != AFXGAMERECORD_VERSION_COMPRESSED)
+		return false;
+
+	if (!m_File.Open(fileName))
+		return false;
+
+	m_Version = version;
+	m_Buffer.clear();
+	m_BlockFrames = 0;
+	m_Dictionary.Clear();
+	m_BoneCoder.Reset();
+	m_FrameCount = 0;
+	m_Block.FirstFrame = 0;
+	m_Block.DictionarySize = 0;
+	m_Index.clear();
+	m_EntityCount = 0;
+	m_UnchangedCount = 0;
+	m_UnchangedBytesSaved = 0;
+	m_InEntity = false;
+	m_EntitySnapshots.clear();
+
+	Write("afxGameRecord");
+	Write(m_Version);
+
+	// The header is never compressed:
+	m_File.Write(m_Buffer);
+
+	return true;
+}
+
+bool CAfxGameRecordWriter::IsOpen(void) const
+{
+	return m_File.IsOpen();
+}
+
+bool CAfxGameRecordWriter::Close(void)
+{
+	if (!m_File.IsOpen())
+		return true;
+
+	EndBlock();
+
+	bool ok = AFXGAMERECORD_VERSION_COMPRESSED != m_Version || WriteIndex();
+
+	m_Dictionary.Clear();
+	m_BoneCoder.Reset();
+	m_Index.clear();
+	m_InEntity = false;
+	m_EntitySnapshots.clear();
+
+	return m_File.Close() && ok;
+}
+
+int CAfxGameRecordWriter::GetVersion(void) const
+{
+	return m_Version;
+}
+
+void CAfxGameRecordWriter::WriteDictionary(char const * value)
+{
+	if (!m_File.IsOpen()) return;
+
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_Dictionary, -1, value };
+		m_EntityValues.push_back(entityValue);
+		return;
+	}
+
+	int index = m_Dictionary.FindOrAdd(value);
+
+	Write(index);
+
+	if (-1 == index)
+		Write(value);
+}
+
+void CAfxGameRecordWriter::Write(bool value)
+{
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_Bool, value ? 1 : 0, 0 };
+		m_EntityValues.push_back(entityValue);
+		return;
+	}
+
+	unsigned char ucValue = value ? 1 : 0;
+
+	WriteBytes(&ucValue, sizeof(ucValue));
+}
+
+void CAfxGameRecordWriter::Write(int value)
+{
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_Int, value, 0 };
+		m_EntityValues.push_back(entityValue);
+		return;
+	}
+
+	WriteBytes(&value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::Write(float value)
+{
+	Write(&value, 1);
+}
+
+void CAfxGameRecordWriter::Write(double value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::Write(char const * value)
+{
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_String, 0, value };
+		m_EntityValues.push_back(entityValue);
+		return;
+	}
+
+	WriteBytes(value, strlen(value) + 1);
+}
+
+void CAfxGameRecordWriter::Write(float const * values, size_t count)
+{
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_Floats, (int)count, 0 };
+		m_EntityValues.push_back(entityValue);
+		m_EntityFloats.insert(m_EntityFloats.end(), values, values + count);
+		return;
+	}
+
+	WriteBytes(values, count * sizeof(float));
+}
+
+void CAfxGameRecordWriter::WriteBytes(void const * data, size_t size)
+{
+	if (!m_File.IsOpen()) return;
+
+	unsigned char const * bytes = (unsigned char const *)data;
+	m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+}
+
+void CAfxGameRecordWriter::BeginBones(int entityHandle, int numBones)
+{
+	if (m_InEntity)
+	{
+		EntityValue entityValue = { EntityValueType_Bones, numBones, 0 };
+		m_EntityValues.push_back(entityValue);
+		return;
+	}
+
+	Write(numBones);
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+		m_BoneCoder.BeginBones(entityHandle, numBones);
+}
+
+void CAfxGameRecordWriter::WriteBone(float const position[3], float const rotation[4])
+{
+	if (!m_File.IsOpen()) return;
+
+	if (m_InEntity)
+	{
+		m_EntityFloats.insert(m_EntityFloats.end(), position, position + 3);
+		m_EntityFloats.insert(m_EntityFloats.end(), rotation, rotation + 4);
+		return;
+	}
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+	{
+		m_BoneCoder.EncodeBone(position, rotation, m_Buffer);
+		return;
+	}
+
+	Write(position, 3);
+	Write(rotation, 4);
+}
+
+void CAfxGameRecordWriter::BeginEntity(int entityHandle)
+{
+	if (!m_File.IsOpen()) return;
+
+	++m_EntityCount;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED != m_Version || m_UnchangedThreshold < 0)
+	{
+		WriteDictionary("entity_state");
+		Write(entityHandle);
+		return;
+	}
+
+	m_InEntity = true;
+	m_EntityHandle = entityHandle;
+	m_EntityValues.clear();
+	m_EntityFloats.clear();
+}
+
+void CAfxGameRecordWriter::EndEntity(void)
+{
+	if (!m_InEntity) return;
+
+	m_InEntity = false;
+
+	EntitySnapshot & snapshot = m_EntitySnapshots[m_EntityHandle];
+
+	if (snapshot.Generation == m_EntityGeneration && IsUnchanged(snapshot))
+	{
+		size_t offset = m_Buffer.size();
+
+		WriteDictionary("entity_unchanged");
+		Write(m_EntityHandle);
+		Write(snapshot.Frame);
+
+		++m_UnchangedCount;
+		m_UnchangedBytesSaved += (long long)snapshot.Size - (long long)(m_Buffer.size() - offset);
+		return;
+	}
+
+	WriteEntity(snapshot);
+}
+
+void CAfxGameRecordWriter::WriteDeleted(int entityHandle)
+{
+	WriteDictionary("deleted");
+	Write(entityHandle);
+
+	std::map<int, EntitySnapshot>::iterator it = m_EntitySnapshots.find(entityHandle);
+
+	if (it != m_EntitySnapshots.end())
+		it->second.Generation = 0;
+}
+
+bool CAfxGameRecordWriter::IsUnchanged(EntitySnapshot const & snapshot)
+{
+	if (snapshot.Values.size() != m_EntityValues.size() || snapshot.Floats.size() != m_EntityFloats.size())
+		return false;
+
+	for (size_t i = 0; i < m_EntityValues.size(); ++i)
+	{
+		EntityValue const & value = m_EntityValues[i];
+		EntityValue const & oldValue = snapshot.Values[i];
+
+		if (value.Type != oldValue.Type)
+			return false;
+
+		switch (value.Type)
+		{
+		case EntityValueType_Dictionary:
+			// The pointer might be a different one, but is likely in the dictionary's pointer cache:
+			if (m_Dictionary.Find(value.String) != oldValue.Value)
+				return false;
+			break;
+		case EntityValueType_String:
+			// Not kept (the pointer is only valid until EndEntity) and not used by the recorders:
+			return false;
+		default:
+			if (value.Value != oldValue.Value)
+				return false;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < m_EntityFloats.size(); ++i)
+	{
+		// Also false for NAN:
+		if (!(fabs(m_EntityFloats[i] - snapshot.Floats[i]) <= m_UnchangedThreshold))
+			return false;
+	}
+
+	return true;
+}
+
+void CAfxGameRecordWriter::WriteEntity(EntitySnapshot & snapshot)
+{
+	size_t offset = m_Buffer.size();
+
+	WriteDictionary("entity_state");
+	Write(m_EntityHandle);
+
+	float const * floats = m_EntityFloats.empty() ? 0 : &m_EntityFloats[0];
+
+	for (size_t i = 0; i < m_EntityValues.size(); ++i)
+	{
+		EntityValue & value = m_EntityValues[i];
+
+		switch (value.Type)
+		{
+		case EntityValueType_Dictionary:
+			value.Value = m_Dictionary.FindOrAdd(value.String);
+			Write(value.Value);
+			if (-1 == value.Value)
+			{
+				Write(value.String);
+				value.Value = m_Dictionary.GetCount() - 1;
+			}
+			break;
+		case EntityValueType_Bool:
+			Write(0 != value.Value);
+			break;
+		case EntityValueType_Int:
+			Write(value.Value);
+			break;
+		case EntityValueType_String:
+			Write(value.String);
+			break;
+		case EntityValueType_Floats:
+			Write(floats, value.Value);
+			floats += value.Value;
+			break;
+		case EntityValueType_Bones:
+			BeginBones(m_EntityHandle, value.Value);
+			for (int bone = 0; bone < value.Value; ++bone)
+			{
+				WriteBone(floats, floats + 3);
+				floats += 7;
+			}
+			break;
+		}
+	}
+
+	snapshot.Values = m_EntityValues;
+	snapshot.Floats = m_EntityFloats;
+	snapshot.Frame = m_FrameCount;
+	snapshot.Size = m_Buffer.size() - offset;
+	snapshot.Generation = m_EntityGeneration;
+}
+
+void CAfxGameRecordWriter::ResetEntitySnapshots(void)
+{
+	// Forget entities not written during the block, the others are kept to re-use their memory:
+	for (std::map<int, EntitySnapshot>::iterator it = m_EntitySnapshots.begin(); it != m_EntitySnapshots.end(); )
+	{
+		if (it->second.Generation != m_EntityGeneration)
+			it = m_EntitySnapshots.erase(it);
+		else
+			++it;
+	}
+
+	++m_EntityGeneration;
+}
+
+size_t CAfxGameRecordWriter::GetOffset(void) const
+{
+	return m_Buffer.size();
+}
+
+void CAfxGameRecordWriter::PatchInt(size_t offset, int value)
+{
+	if (m_Buffer.size() < offset + sizeof(value))
+		return;
+
+	memcpy(&m_Buffer[offset], &value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::EndFrame(void)
+{
+	if (!m_File.IsOpen()) return;
+
+	++m_FrameCount;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+	{
+		++m_BlockFrames;
+
+		if (m_BlockFrames < AFXGAMERECORD_BLOCK_FRAMES)
+			return;
+	}
+
+	EndBlock();
+}
+
+void CAfxGameRecordWriter::EndBlock(void)
+{
+	bool compressed = AFXGAMERECORD_VERSION_COMPRESSED == m_Version;
+
+	if (compressed && !m_Buffer.empty())
+		m_Index.push_back(m_Block);
+
+	m_File.Write(m_Buffer, compressed);
+
+	if (compressed)
+	{
+		m_BlockFrames = 0;
+		m_BoneCoder.Reset();
+		ResetEntitySnapshots();
+		m_Block.FirstFrame = m_FrameCount;
+		m_Block.DictionarySize = m_Dictionary.GetCount();
+	}
+}
+
+bool CAfxGameRecordWriter::WriteIndex(void)
+{
+	// The block offsets are only known after the I/O thread compressed them:
+	long long indexOffset = (long long)m_File.Flush() + 8;
+	std::vector<size_t> const & offsets = m_File.GetCompressedBlockOffsets();
+
+	if (offsets.size() != m_Index.size())
+		return false;
+
+	// End marker:
+	Write((int)0);
+	Write((int)0);
+
+	Write(m_FrameCount);
+	Write((int)m_Index.size());
+
+	for (size_t i = 0; i < m_Index.size(); ++i)
+	{
+		long long offset = (long long)offsets[i];
+
+		Write(m_Index[i].FirstFrame);
+		WriteBytes(&offset, sizeof(offset));
+		Write(m_Index[i].DictionarySize);
+	}
+
+	Write(m_Dictionary.GetCount());
+
+	for (int i = 0; i < m_Dictionary.GetCount(); ++i)
+	{
+		Write(m_Dictionary.Get(i));
+	}
+
+	WriteBytes(&indexOffset, sizeof(indexOffset));
+	WriteBytes("afxIndex", 8);
+
+	m_File.Write(m_Buffer);
+
+	return true;
+}
+
+// CAfxGameRecordIndex /////////////////////////////////////////////////////////
+
+CAfxGameRecordIndex::CAfxGameRecordIndex()
+: m_FrameCount(-1)
+{
+}
+
+CAfxGameRecordIndex::Entry const * CAfxGameRecordIndex::Find(int frame) const
+{
+	Entry key;
+	key.FirstFrame = frame;
+
+	std::vector<Entry>::const_iterator it = std::upper_bound(m_Entries.begin(), m_Entries.end(), key);
+	if (it == m_Entries.begin())
+		return 0;
+
+	return &*(--it);
+}
+
+void CAfxGameRecordIndex::Clear(void)
+{
+	m_FrameCount = -1;
+	m_Entries.clear();
+	m_Dictionary.clear();
+}
+
+long long CAfxGameRecordIndex::GetIndexOffset(unsigned char const * trailer)
+{
+	if (0 != memcmp(&trailer[8], "afxIndex", 8))
+		return -1;
+
+	long long indexOffset;
+	memcpy(&indexOffset, trailer, sizeof(indexOffset));
+
+	return indexOffset;
+}
+
+static bool AfxGameRecord_ReadIndexBytes(unsigned char const * & inOutPos, unsigned char const * end, void * outData, size_t size)
+{
+	if ((size_t)(end - inOutPos) < size)
+		return false;
+
+	memcpy(outData, inOutPos, size);
+	inOutPos += size;
+
+	return true;
+}
+
+bool CAfxGameRecordIndex::Parse(unsigned char const * data, size_t size, long long indexOffset)
+{
+	Clear();
+
+	unsigned char const * pos = data;
+	unsigned char const * end = data + size;
+
+	int frameCount;
+	int blockCount;
+
+	if (!AfxGameRecord_ReadIndexBytes(pos, end, &frameCount, sizeof(frameCount))
+		|| !AfxGameRecord_ReadIndexBytes(pos, end, &blockCount, sizeof(blockCount))
+		|| frameCount < 0 || blockCount < 0 || (size_t)(end - pos) / 16 < (size_t)blockCount)
+		return false;
+
+	std::vector<Entry> entries(blockCount);
+
+	for (int i = 0; i < blockCount; ++i)
+	{
+		Entry & entry = entries[i];
+
+		if (!AfxGameRecord_ReadIndexBytes(pos, end, &entry.FirstFrame, sizeof(entry.FirstFrame))
+			|| !AfxGameRecord_ReadIndexBytes(pos, end, &entry.FileOffset, sizeof(entry.FileOffset))
+			|| !AfxGameRecord_ReadIndexBytes(pos, end, &entry.DictionarySize, sizeof(entry.DictionarySize))
+			|| entry.FirstFrame < (0 < i ? entries[i - 1].FirstFrame : 0)
+			|| entry.FileOffset < AFXGAMERECORD_HEADER_SIZE || indexOffset <= entry.FileOffset
+			|| entry.DictionarySize < (0 < i ? entries[i - 1].DictionarySize : 0))
+			return false;
+	}
+
+	int dictionaryCount;
+
+	if (!AfxGameRecord_ReadIndexBytes(pos, end, &dictionaryCount, sizeof(dictionaryCount))
+		|| dictionaryCount < 0 || (size_t)(end - pos) < (size_t)dictionaryCount
+		|| (!entries.empty() && dictionaryCount < entries.back().DictionarySize))
+		return false;
+
+	std::vector<std::string> dictionary(dictionaryCount);
+
+	for (int i = 0; i < dictionaryCount; ++i)
+	{
+		unsigned char const * zero = (unsigned char const *)memchr(pos, '\0', end - pos);
+		if (!zero)
+			return false;
+
+		dictionary[i].assign((char const *)pos, (char const *)zero);
+		pos = zero + 1;
+	}
+
+	m_FrameCount = frameCount;
+	m_Entries.swap(entries);
+	m_Dictionary.swap(dictionary);
+
+	return true;
+}
+
+// CAfxGameRecordReader ////////////////////////////////////////////////////////
+
+struct AfxGameRecordSkipState
+{
+	std::string Token;
+	std::vector<float> Positions;
+	std::vector<float> Rotations;
+};
+
+static bool AfxGameRecord_SkipToken(CAfxGameRecordReader & reader, AfxGameRecordSkipState & state, bool & outFrameEnd);
+
+CAfxGameRecordReader::CAfxGameRecordReader()
+: m_File(NULL)
+, m_Version(0)
+, m_Pos(0)
+{
+}
+
+CAfxGameRecordReader::~CAfxGameRecordReader()
+{
+	Close();
+}
+
+bool CAfxGameRecordReader::Open(wchar_t const * fileName)
+{
+	Close();
+
+	_wfopen_s(&m_File, fileName, L"rb");
+
+	if (!m_File)
+		return false;
+
+	char magic[14];
+	int version;
+
+	if (1 != fread(magic, sizeof(magic), 1, m_File)
+		|| 0 != memcmp(magic, "afxGameRecord", sizeof(magic))
+		|| 1 != fread(&version, sizeof(version), 1, m_File)
+		|| (version != AFXGAMERECORD_VERSION_RAW && version != AFXGAMERECORD_VERSION_COMPRESSED))
+	{
+		Close();
+		return false;
+	}
+
+	m_Version = version;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+	{
+		ReadIndex();
+
+		if (0 != _fseeki64(m_File, AFXGAMERECORD_HEADER_SIZE, SEEK_SET))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CAfxGameRecordReader::Close(void)
+{
+	if (m_File)
+	{
+		fclose(m_File);
+		m_File = NULL;
+	}
+
+	m_Version = 0;
+	m_Data.clear();
+	m_Pos = 0;
+	m_Dictionary.clear();
+	m_BoneCoder.Reset();
+	m_Index.Clear();
+}
+
+int CAfxGameRecordReader::GetVersion(void) const
+{
+	return m_Version;
+}
+
+int CAfxGameRecordReader::GetFrameCount(void) const
+{
+	return m_Index.GetFrameCount();
+}
+
+bool CAfxGameRecordReader::SeekFrame(int frame)
+{
+	if (!m_File || frame < 0 || (0 <= m_Index.GetFrameCount() && m_Index.GetFrameCount() <= frame))
+		return false;
+
+	long long fileOffset = AFXGAMERECORD_HEADER_SIZE;
+	int dictionarySize = 0;
+	int skipFrames = frame;
+
+	if (CAfxGameRecordIndex::Entry const * entry = m_Index.Find(frame))
+	{
+		fileOffset = entry->FileOffset;
+		dictionarySize = entry->DictionarySize;
+		skipFrames = frame - entry->FirstFrame;
+	}
+
+	if (!Restart(fileOffset, dictionarySize))
+		return false;
+
+	// Frames in between have to be decoded (the bone coder's state):
+	AfxGameRecordSkipState state;
+
+	while (0 < skipFrames)
+	{
+		bool frameEnd = false;
+
+		if (IsEnd() || !AfxGameRecord_SkipToken(*this, state, frameEnd))
+			return false;
+
+		if (frameEnd)
+			--skipFrames;
+	}
+
+	return !IsEnd();
+}
+
+bool CAfxGameRecordReader::Restart(long long fileOffset, int dictionarySize)
+{
+	if (0 != _fseeki64(m_File, fileOffset, SEEK_SET))
+		return false;
+
+	m_Data.clear();
+	m_Pos = 0;
+	m_Dictionary.assign(m_Index.GetDictionary().begin(), m_Index.GetDictionary().begin() + dictionarySize);
+	m_BoneCoder.Reset();
+
+	return true;
+}
+
+void CAfxGameRecordReader::ReadIndex(void)
+{
+	unsigned char trailer[AFXGAMERECORD_INDEX_TRAILER_SIZE];
+
+	if (0 != _fseeki64(m_File, -AFXGAMERECORD_INDEX_TRAILER_SIZE, SEEK_END)
+		|| 1 != fread(trailer, sizeof(trailer), 1, m_File))
+		return;
+
+	long long indexOffset = CAfxGameRecordIndex::GetIndexOffset(trailer);
+	long long indexEnd = _ftelli64(m_File) - AFXGAMERECORD_INDEX_TRAILER_SIZE;
+
+	if (indexOffset < AFXGAMERECORD_HEADER_SIZE || indexEnd <= indexOffset
+		|| 0 != _fseeki64(m_File, indexOffset, SEEK_SET))
+		return;
+
+	std::vector<unsigned char> data((size_t)(indexEnd - indexOffset));
+
+	if (1 != fread(&data[0], data.size(), 1, m_File))
+		return;
+
+	m_Index.Parse(&data[0], data.size(), indexOffset);
+}
+
+bool CAfxGameRecordReader::IsEnd(void)
+{
+	return m_Pos == m_Data.size() && !Fill();
+}
+
+bool CAfxGameRecordReader::Fill(void)
+{
+	if (!m_File)
+		return false;
+
+	m_Data.erase(m_Data.begin(), m_Data.begin() + m_Pos);
+	m_Pos = 0;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+	{
+		unsigned char sizes[8];
+		if (1 != fread(sizes, sizeof(sizes), 1, m_File))
+			return false;
+
+		uLong rawSize = sizes[0] | (sizes[1] << 8) | (sizes[2] << 16) | ((uLong)sizes[3] << 24);
+		uLong compressedSize = sizes[4] | (sizes[5] << 8) | (sizes[6] << 16) | ((uLong)sizes[7] << 24);
+
+		m_Compressed.resize(compressedSize);
+		if (0 < compressedSize && 1 != fread(&m_Compressed[0], compressedSize, 1, m_File))
+			return false;
+
+		size_t oldSize = m_Data.size();
+		m_Data.resize(oldSize + rawSize);
+
+		uLongf destLen = rawSize;
+		if (0 == rawSize
+			|| Z_OK != uncompress(&m_Data[oldSize], &destLen, m_Compressed.empty() ? 0 : &m_Compressed[0], compressedSize)
+			|| destLen != rawSize)
+		{
+			m_Data.resize(oldSize);
+			return false;
+		}
+
+		// Each block starts with a fresh state:
+		m_BoneCoder.Reset();
+
+		return true;
+	}
+
+	size_t oldSize = m_Data.size();
+	m_Data.resize(oldSize + AFXGAMERECORD_READ_SIZE);
+
+	size_t read = fread(&m_Data[oldSize], 1, AFXGAMERECORD_READ_SIZE, m_File);
+	m_Data.resize(oldSize + read);
+
+	return 0 < read;
+}
+
+bool CAfxGameRecordReader::ReadBytes(void * outData, size_t size)
+{
+	while (m_Data.size() - m_Pos < size)
+	{
+		if (!Fill())
+			return false;
+	}
+
+	if (0 < size)
+	{
+		memcpy(outData, &m_Data[m_Pos], size);
+		m_Pos += size;
+	}
+
+	return true;
+}
+
+bool CAfxGameRecordReader::Read(bool & outValue)
+{
+	unsigned char ucValue;
+
+	if (!ReadBytes(&ucValue, sizeof(ucValue)))
+		return false;
+
+	outValue = 0 != ucValue;
+	return true;
+}
+
+bool CAfxGameRecordReader::Read(int & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordReader::Read(float & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordReader::Read(std::string & outValue)
+{
+	outValue.clear();
+
+	while (true)
+	{
+		if (m_Pos == m_Data.size() && !Fill())
+			return false;
+
+		unsigned char const * begin = &m_Data[m_Pos];
+		unsigned char const * zero = (unsigned char const *)memchr(begin, '\0', m_Data.size() - m_Pos);
+
+		if (zero)
+		{
+			outValue.append((char const *)begin, (char const *)zero);
+			m_Pos += zero - begin + 1;
+			return true;
+		}
+
+		outValue.append((char const *)begin, m_Data.size() - m_Pos);
+		m_Pos = m_Data.size();
+	}
+}
+
+bool CAfxGameRecordReader::Read(float * outValues, size_t count)
+{
+	return ReadBytes(outValues, count * sizeof(float));
+}
+
+bool CAfxGameRecordReader::ReadDictionary(std::string & outValue)
+{
+	int index;
+
+	if (!Read(index))
+		return false;
+
+	if (-1 == index)
+	{
+		if (!Read(outValue))
+			return false;
+
+		m_Dictionary.push_back(outValue);
+		return true;
+	}
+
+	if (index < 0 || m_Dictionary.size() <= (size_t)index)
+		return false;
+
+	outValue = m_Dictionary[index];
+	return true;
+}
+
+bool CAfxGameRecordReader::ReadBones(int entityHandle, std::vector<float> & outPositions, std::vector<float> & outRotations)
+{
+	int numBones;
+
+	if (!Read(numBones) || numBones < 0)
+		return false;
+
+	outPositions.resize(3 * (size_t)numBones);
+	outRotations.resize(4 * (size_t)numBones);
+
+	if (0 == numBones)
+		return true;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED != m_Version)
+	{
+		for (int i = 0; i < numBones; ++i)
+		{
+			if (!Read(&outPositions[3 * i], 3) || !Read(&outRotations[4 * i], 4))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Bone lists never cross blocks, since blocks contain whole frames:
+	if (m_Pos == m_Data.size() && !Fill())
+		return false;
+
+	m_BoneCoder.BeginBones(entityHandle, numBones);
+
+	unsigned char const * pos = &m_Data[m_Pos];
+	unsigned char const * end = pos + (m_Data.size() - m_Pos);
+
+	for (int i = 0; i < numBones; ++i)
+	{
+		if (!m_BoneCoder.DecodeBone(pos, end, &outPositions[3 * i], &outRotations[4 * i]))
+			return false;
+	}
+
+	m_Pos = pos - &m_Data[0];
+
+	return true;
+}
+
+// AfxGameRecord_SkipToken ////////////////////////////////////////////////////
+
+static bool AfxGameRecord_SkipFloats(CAfxGameRecordReader & reader, size_t count)
+{
+	float values[8];
+
+	return count <= 8 && reader.Read(values, count);
+}
+
+static bool AfxGameRecord_SkipEntityState(CAfxGameRecordReader & reader, AfxGameRecordSkipState & state)
+{
+	int handle;
+	if (!reader.Read(handle))
+		return false;
+
+	while (true)
+	{
+		if (!reader.ReadDictionary(state.Token))
+			return false;
+
+		if (0 == state.Token.compare("/"))
+		{
+			bool viewModel;
+			return reader.Read(viewModel);
+		}
+		else if (0 == state.Token.compare("baseentity"))
+		{
+			bool visible;
+			if (!reader.ReadDictionary(state.Token) || !reader.Read(visible) || !AfxGameRecord_SkipFloats(reader, 6))
+				return false;
+		}
+		else if (0 == state.Token.compare("baseanimating"))
+		{
+			bool hasBoneList;
+			if (!reader.Read(hasBoneList))
+				return false;
+
+			if (hasBoneList && !reader.ReadBones(handle, state.Positions, state.Rotations))
+				return false;
+		}
+		else if (0 == state.Token.compare("camera"))
+		{
+			bool thirdPerson;
+			if (!reader.Read(thirdPerson) || !AfxGameRecord_SkipFloats(reader, 7))
+				return false;
+		}
+		else
+			return false;
+	}
+}
+
+static bool AfxGameRecord_SkipToken(CAfxGameRecordReader & reader, AfxGameRecordSkipState & state, bool & outFrameEnd)
+{
+	if (!reader.ReadDictionary(state.Token))
+		return false;
+
+	if (0 == state.Token.compare("afxFrame"))
+	{
+		float frameTime;
+		int hiddenOffset;
+		return reader.Read(frameTime) && reader.Read(hiddenOffset);
+	}
+	else if (0 == state.Token.compare("afxHidden"))
+	{
+		int count;
+		if (!reader.Read(count) || count < 0)
+			return false;
+
+		for (int i = 0; i < count; ++i)
+		{
+			int index;
+			if (!reader.Read(index))
+				return false;
+		}
+	}
+	else if (0 == state.Token.compare("afxFrameEnd"))
+	{
+		outFrameEnd = true;
+	}
+	else if (0 == state.Token.compare("afxCam"))
+	{
+		return AfxGameRecord_SkipFloats(reader, 7);
+	}
+	else if (0 == state.Token.compare("deleted"))
+	{
+		int handle;
+		return reader.Read(handle);
+	}
+	else if (0 == state.Token.compare("entity_state"))
+	{
+		return AfxGameRecord_SkipEntityState(reader, state);
+	}
+	else if (0 == state.Token.compare("entity_unchanged"))
+	{
+		int handle;
+		int frame;
+		return reader.Read(handle) && reader.Read(frame);
+	}
+	else
+		return false;
+
+	return true;
+}
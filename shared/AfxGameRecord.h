@@ -0,0 +1,460 @@
+#pragma once
+
+#include "AfxWriteBehindFile.h"
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// afxGameRecord (.agr) files
+//
+// All versions start with "afxGameRecord\0" and the int32 version.
+//
+// Version 5: The token stream follows as is.
+//
+// Version 6: The token stream follows as zlib blocks (see
+// CAfxWriteBehindFile::Write) of AFXGAMERECORD_BLOCK_FRAMES whole frames.
+// Bone lists are quantized and delta coded (see CAfxGameRecordBoneCoder),
+// the coder's state is reset at every block start, so only the dictionary
+// is shared between blocks. Everything else is the same as in version 5,
+// except that an entity_state record can be replaced by
+//   "entity_unchanged", int32 entityHandle, int32 frame
+// if the entity's state is the same as the one written for it in frame
+// (within the same block and not deleted since, see
+// CAfxGameRecordWriter::SetUnchangedThreshold).
+// The blocks are followed by an end marker block (both sizes 0) and the
+// index (see CAfxGameRecordReader::SeekFrame), little endian:
+//   int32 frameCount, int32 blockCount,
+//   blockCount x { int32 firstFrame, int64 fileOffset, int32 dictionarySize },
+//   int32 dictionaryCount, dictionaryCount x null-terminated string,
+//   int64 fileOffset of the index, "afxIndex" (8 bytes, no terminator).
+// dictionarySize is the number of dictionary entries defined before the
+// block, so a reader can start at any block with the first dictionarySize
+// strings. The index is missing if the recording was not closed properly.
+
+#define AFXGAMERECORD_VERSION_RAW 5
+#define AFXGAMERECORD_VERSION_COMPRESSED 6
+
+/// <summary>Number of frames per zlib block in version 6.</summary>
+#define AFXGAMERECORD_BLOCK_FRAMES 64
+
+/// <summary>Size of "afxGameRecord\0" and the version.</summary>
+#define AFXGAMERECORD_HEADER_SIZE (14 + 4)
+
+/// <summary>Size of the index offset and "afxIndex" at the end of version 6 files.</summary>
+#define AFXGAMERECORD_INDEX_TRAILER_SIZE (8 + 8)
+
+/// <summary>
+///   Version 6 bone list coding, the same state is used for encoding
+///   and decoding.
+/// </summary>
+/// <remarks>
+///   Per bone:<br />
+///   Position: 3 x varint(zigzag(delta)) of the components in 1/1024 units
+///   against the same bone of the entity's previous bone list.<br />
+///   Rotation: smallest three quaternion components in 15 bits each,
+///   varint((zigzag(delta0) &lt;&lt; 2) | largestIndex), varint(zigzag(delta1)),
+///   varint(zigzag(delta2)), deltas are against 0 if the largest index
+///   differs from the previous one.<br />
+///   A different bone count resets the entity's state.
+/// </remarks>
+class CAfxGameRecordBoneCoder
+{
+public:
+	CAfxGameRecordBoneCoder();
+
+	/// <summary>Forgets all entities (the state of all bones is 0 afterwards).</summary>
+	void Reset(void);
+
+	void BeginBones(int entityHandle, int numBones);
+
+	/// <param name="position">x, y, z</param>
+	/// <param name="rotation">Quaternion x, y, z, w</param>
+	void EncodeBone(float const position[3], float const rotation[4], std::vector<unsigned char> & out);
+
+	/// <returns>false on invalid data.</returns>
+	bool DecodeBone(unsigned char const * & inOutPos, unsigned char const * end, float outPosition[3], float outRotation[4]);
+
+private:
+	struct Bone
+	{
+		int Position[3];
+		int Rotation[3];
+		int RotationIndex;
+	};
+
+	struct Entity
+	{
+		std::vector<Bone> Bones;
+
+		/// <summary>The bones are only valid if this equals m_Generation.</summary>
+		unsigned int Generation;
+
+		Entity()
+		: Generation(0)
+		{
+		}
+	};
+
+	std::map<int, Entity> m_Entities;
+	unsigned int m_Generation;
+	std::vector<Bone> * m_Bones;
+	size_t m_NextBone;
+
+	Bone * NextBone(void);
+};
+
+/// <summary>Number of pointer cache slots of CAfxGameRecordDictionary (power of 2).</summary>
+#define AFXGAMERECORD_DICTIONARY_POINTER_SLOTS 256
+
+/// <summary>
+///   The string to index dictionary of CAfxGameRecordWriter, it is called for
+///   every token and model name of every entity in every frame.
+/// </summary>
+/// <remarks>
+///   Open addressing hash table (linear probing) that is searched with the
+///   char const * directly, so a lookup doesn't allocate.<br />
+///   Before hashing a small cache keyed by the pointer is tried, which hits
+///   for string literals and engine owned strings (i.e. model names). Since
+///   the memory behind a pointer can be reused for a different string (i.e.
+///   after a map change), a hit is still confirmed with a strcmp, but that
+///   is cheaper than hashing and probing.
+/// </remarks>
+class CAfxGameRecordDictionary
+{
+public:
+	CAfxGameRecordDictionary();
+
+	/// <returns>The index of value or -1 if it was added (with index GetCount() - 1).</returns>
+	int FindOrAdd(char const * value)
+	{
+		return Lookup(value, true);
+	}
+
+	/// <returns>The index of value or -1 if it is not in the dictionary.</returns>
+	int Find(char const * value)
+	{
+		return Lookup(value, false);
+	}
+
+	int GetCount(void) const
+	{
+		return (int)m_Strings.size();
+	}
+
+	char const * Get(int index) const
+	{
+		return m_Strings[index].c_str();
+	}
+
+	void Clear(void);
+
+private:
+	struct Slot
+	{
+		unsigned int Hash;
+
+		/// <summary>-1 if the slot is empty.</summary>
+		int Index;
+	};
+
+	struct PointerSlot
+	{
+		char const * Pointer;
+		int Index;
+	};
+
+	std::vector<std::string> m_Strings;
+	std::vector<Slot> m_Slots;
+	PointerSlot m_PointerSlots[AFXGAMERECORD_DICTIONARY_POINTER_SLOTS];
+
+	static unsigned int Hash(char const * value, size_t & outLength);
+
+	static size_t GetPointerSlot(char const * value);
+
+	int Lookup(char const * value, bool add);
+
+	/// <summary>Doubles the number of slots and re-inserts all strings.</summary>
+	void Grow(void);
+};
+
+/// <summary>Index of a version 6 AGR.</summary>
+class CAfxGameRecordIndex
+{
+public:
+	struct Entry
+	{
+		int FirstFrame;
+		long long FileOffset;
+		int DictionarySize;
+
+		bool operator < (Entry const & other) const
+		{
+			return FirstFrame < other.FirstFrame;
+		}
+	};
+
+	CAfxGameRecordIndex();
+
+	/// <returns>-1 if there is no index.</returns>
+	int GetFrameCount(void) const
+	{
+		return m_FrameCount;
+	}
+
+	/// <returns>The entry of the block containing frame, 0 if there is none.</returns>
+	Entry const * Find(int frame) const;
+
+	/// <summary>The complete dictionary, the first Entry::DictionarySize entries are valid at a block start.</summary>
+	std::vector<std::string> const & GetDictionary(void) const
+	{
+		return m_Dictionary;
+	}
+
+	void Clear(void);
+
+	/// <param name="trailer">The last AFXGAMERECORD_INDEX_TRAILER_SIZE bytes of the file.</param>
+	/// <returns>File offset of the index, -1 if there is none.</returns>
+	static long long GetIndexOffset(unsigned char const * trailer);
+
+	/// <param name="data">The index, from GetIndexOffset to the trailer.</param>
+	/// <returns>false if the index is invalid (the index is cleared then).</returns>
+	bool Parse(unsigned char const * data, size_t size, long long indexOffset);
+
+private:
+	int m_FrameCount;
+	std::vector<Entry> m_Entries;
+	std::vector<std::string> m_Dictionary;
+};
+
+/// <summary>Writes version 5 or 6 AGRs, see CClientTools.</summary>
+class CAfxGameRecordWriter
+{
+public:
+	CAfxGameRecordWriter();
+
+	/// <summary>
+	///   Version 6 only: An entity state (see BeginEntity) that doesn't differ by more than
+	///   threshold in any float from the last one written for the entity (in the same block)
+	///   is written as entity_unchanged record. Negative (default) disables this, 0 only elides
+	///   identical states.
+	/// </summary>
+	/// <remarks>
+	///   Off by default, since the saving has only been measured on synthetic scenes so far
+	///   (see Benchmarks.cpp), not on real recordings.
+	/// </remarks>
+	void SetUnchangedThreshold(float value);
+
+	float GetUnchangedThreshold(void) const;
+
+	/// <returns>Number of entity states since Open.</returns>
+	int GetEntityCount(void) const;
+
+	/// <returns>Number of entity states since Open that were written as entity_unchanged.</returns>
+	int GetUnchangedCount(void) const;
+
+	/// <returns>Uncompressed bytes saved by entity_unchanged records since Open.</returns>
+	long long GetUnchangedBytesSaved(void) const;
+
+	/// <summary>Creates the file and writes the header.</summary>
+	bool Open(wchar_t const * fileName, int version);
+
+	bool IsOpen(void) const;
+
+	/// <summary>Ends the current block (if any), writes the index (version 6) and closes the file.</summary>
+	/// <returns>false if writing failed.</returns>
+	bool Close(void);
+
+	int GetVersion(void) const;
+
+	void WriteDictionary(char const * value);
+
+	void Write(bool value);
+	void Write(int value);
+	void Write(float value);
+	void Write(double value);
+	void Write(char const * value);
+	void Write(float const * values, size_t count);
+
+	void WriteBytes(void const * data, size_t size);
+
+	/// <summary>Writes the bone count, must be followed by numBones WriteBone calls.</summary>
+	void BeginBones(int entityHandle, int numBones);
+
+	void WriteBone(float const position[3], float const rotation[4]);
+
+	/// <summary>
+	///   Writes "entity_state" and the handle. The state (WriteDictionary, Write and WriteBone
+	///   calls, but not WriteBytes) must be ended by EndEntity after the "/" token and the view model flag.
+	/// </summary>
+	void BeginEntity(int entityHandle);
+
+	void EndEntity(void);
+
+	/// <summary>Writes a "deleted" record and forgets the entity's state.</summary>
+	void WriteDeleted(int entityHandle);
+
+	/// <summary>Offset of the next byte to be written, only valid until the next EndFrame.</summary>
+	size_t GetOffset(void) const;
+
+	/// <summary>Overwrites an int written after the last EndFrame at offset (see GetOffset).</summary>
+	void PatchInt(size_t offset, int value);
+
+	/// <summary>Hands over the frame(s) to the file, in version 6 only every AFXGAMERECORD_BLOCK_FRAMES frames.</summary>
+	void EndFrame(void);
+
+private:
+	CAfxWriteBehindFile m_File;
+	int m_Version;
+	std::vector<unsigned char> m_Buffer;
+	int m_BlockFrames;
+	CAfxGameRecordDictionary m_Dictionary;
+	CAfxGameRecordBoneCoder m_BoneCoder;
+
+	struct IndexEntry
+	{
+		int FirstFrame;
+		int DictionarySize;
+	};
+
+	int m_FrameCount;
+	IndexEntry m_Block;
+	std::vector<IndexEntry> m_Index;
+
+	enum EntityValueType
+	{
+		EntityValueType_Dictionary,
+		EntityValueType_Bool,
+		EntityValueType_Int,
+		EntityValueType_String,
+		EntityValueType_Floats,
+		EntityValueType_Bones
+	};
+
+	/// <summary>A Write call between BeginEntity and EndEntity.</summary>
+	struct EntityValue
+	{
+		EntityValueType Type;
+
+		/// <summary>
+		///   Dictionary: index (-1 until written), Bool / Int: value,
+		///   Floats: number of floats, Bones: number of bones (7 floats each).
+		/// </summary>
+		int Value;
+
+		/// <summary>Dictionary / String, only valid until EndEntity.</summary>
+		char const * String;
+	};
+
+	struct EntitySnapshot
+	{
+		std::vector<EntityValue> Values;
+		std::vector<float> Floats;
+		int Frame;
+
+		/// <summary>Size of the written entity_state record.</summary>
+		size_t Size;
+
+		/// <summary>Only valid if this equals m_EntityGeneration (one per block).</summary>
+		unsigned int Generation;
+
+		EntitySnapshot()
+		: Generation(0)
+		{
+		}
+	};
+
+	float m_UnchangedThreshold;
+	int m_EntityCount;
+	int m_UnchangedCount;
+	long long m_UnchangedBytesSaved;
+
+	/// <summary>true if the Write calls go to m_EntityValues and m_EntityFloats.</summary>
+	bool m_InEntity;
+	int m_EntityHandle;
+	std::vector<EntityValue> m_EntityValues;
+	std::vector<float> m_EntityFloats;
+	std::map<int, EntitySnapshot> m_EntitySnapshots;
+	unsigned int m_EntityGeneration;
+
+	bool IsUnchanged(EntitySnapshot const & snapshot);
+
+	void WriteEntity(EntitySnapshot & snapshot);
+
+	void ResetEntitySnapshots(void);
+
+	void EndBlock(void);
+
+	/// <returns>false if writing failed.</returns>
+	bool WriteIndex(void);
+};
+
+/// <summary>Reads version 5 and 6 AGRs token by token (the reference decoder for version 6).</summary>
+class CAfxGameRecordReader
+{
+public:
+	CAfxGameRecordReader();
+
+	/// <summary>Calls Close.</summary>
+	~CAfxGameRecordReader();
+
+	/// <summary>Opens the file and reads the header.</summary>
+	/// <returns>false if the file can not be opened or the version is not supported.</returns>
+	bool Open(wchar_t const * fileName);
+
+	void Close(void);
+
+	int GetVersion(void) const;
+
+	/// <returns>Number of frames according to the index, -1 if there is no index.</returns>
+	int GetFrameCount(void) const;
+
+	/// <summary>Positions the reader at the start of the given frame (0 is the first one), the next token is its afxFrame.</summary>
+	/// <remarks>
+	///   With an index this seeks to the block containing the frame in O(log n)
+	///   and decodes at most AFXGAMERECORD_BLOCK_FRAMES - 1 frames, otherwise
+	///   all frames before are decoded.
+	/// </remarks>
+	/// <returns>false if the frame does not exist or the data is invalid.</returns>
+	bool SeekFrame(int frame);
+
+	/// <returns>true if all data has been read (or the file is not open).</returns>
+	bool IsEnd(void);
+
+	bool ReadBytes(void * outData, size_t size);
+
+	bool Read(bool & outValue);
+	bool Read(int & outValue);
+	bool Read(float & outValue);
+	bool Read(std::string & outValue);
+	bool Read(float * outValues, size_t count);
+
+	bool ReadDictionary(std::string & outValue);
+
+	/// <summary>Reads a bone list (as written by CAfxGameRecordWriter::BeginBones and WriteBone).</summary>
+	/// <param name="outPositions">3 floats per bone.</param>
+	/// <param name="outRotations">4 floats (quaternion x, y, z, w) per bone.</param>
+	bool ReadBones(int entityHandle, std::vector<float> & outPositions, std::vector<float> & outRotations);
+
+private:
+	FILE * m_File;
+	int m_Version;
+	std::vector<unsigned char> m_Data;
+	size_t m_Pos;
+	std::vector<unsigned char> m_Compressed;
+	std::vector<std::string> m_Dictionary;
+	CAfxGameRecordBoneCoder m_BoneCoder;
+
+	CAfxGameRecordIndex m_Index;
+
+	/// <summary>Makes new data available, if there is any.</summary>
+	bool Fill(void);
+
+	/// <summary>Reads the index if there is one, leaves the file position undefined.</summary>
+	void ReadIndex(void);
+
+	/// <summary>Discards buffered data and continues reading at fileOffset.</summary>
+	bool Restart(long long fileOffset, int dictionarySize);
+};
@@ -0,0 +1,620 @@
+#include "stdafx.h"
+
+#include "AfxGameRecordParser.h"
+
+#include <zlib.h>
+
+#include <string.h>
+
+// CAfxGameRecordWriteVisitor /////////////////////////////////////////////////
+
+CAfxGameRecordWriteVisitor::CAfxGameRecordWriteVisitor(CAfxGameRecordWriter & writer)
+: m_Writer(writer)
+, m_HiddenOffset(0)
+{
+}
+
+void CAfxGameRecordWriteVisitor::OnFrame(int /*frame*/, float frameTime)
+{
+	m_Writer.WriteDictionary("afxFrame");
+	m_Writer.Write(frameTime);
+	m_HiddenOffset = m_Writer.GetOffset();
+	m_Writer.Write((int)0);
+}
+
+void CAfxGameRecordWriteVisitor::OnCamera(float const * values)
+{
+	m_Writer.WriteDictionary("afxCam");
+	m_Writer.Write(values, 7);
+}
+
+void CAfxGameRecordWriteVisitor::OnEntity(AfxGameRecordEntity const & entity)
+{
+	m_Writer.BeginEntity(entity.Handle);
+
+	if (entity.HasBaseEntity)
+	{
+		m_Writer.WriteDictionary("baseentity");
+		m_Writer.WriteDictionary(entity.ModelName);
+		m_Writer.Write(entity.Visible);
+		m_Writer.Write(entity.RenderOrigin, 3);
+		m_Writer.Write(entity.RenderAngles, 3);
+	}
+
+	if (entity.HasBaseAnimating)
+	{
+		m_Writer.WriteDictionary("baseanimating");
+		m_Writer.Write(entity.HasBoneList);
+
+		if (entity.HasBoneList)
+		{
+			m_Writer.BeginBones(entity.Handle, entity.NumBones);
+
+			for (int i = 0; i < entity.NumBones; ++i)
+			{
+				m_Writer.WriteBone(&entity.BonePositions[3 * i], &entity.BoneRotations[4 * i]);
+			}
+		}
+	}
+
+	if (entity.HasCamera)
+	{
+		m_Writer.WriteDictionary("camera");
+		m_Writer.Write(entity.ThirdPerson);
+		m_Writer.Write(entity.EyePosition, 3);
+		m_Writer.Write(entity.EyeAngles, 3);
+		m_Writer.Write(entity.Fov);
+	}
+
+	m_Writer.WriteDictionary("/");
+	m_Writer.Write(entity.ViewModel);
+	m_Writer.EndEntity();
+}
+
+void CAfxGameRecordWriteVisitor::OnDeleted(int handle)
+{
+	m_Writer.WriteDeleted(handle);
+}
+
+void CAfxGameRecordWriteVisitor::OnHidden(int count, int const * handles)
+{
+	m_Writer.WriteDictionary("afxHidden");
+
+	if (m_HiddenOffset)
+		m_Writer.PatchInt(m_HiddenOffset, (int)(m_Writer.GetOffset() - m_HiddenOffset));
+
+	m_Writer.Write(count);
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_Writer.Write(handles[i]);
+	}
+}
+
+void CAfxGameRecordWriteVisitor::OnFrameEnd(int /*frame*/)
+{
+	m_Writer.WriteDictionary("afxFrameEnd");
+	m_Writer.EndFrame();
+	m_HiddenOffset = 0;
+}
+
+// AfxGameRecordConvert ////////////////////////////////////////////////////////
+
+bool AfxGameRecordConvert(wchar_t const * inFileName, wchar_t const * outFileName, int outVersion)
+{
+	CAfxGameRecordParser parser;
+	CAfxGameRecordWriter writer;
+
+	if (!parser.Open(inFileName) || !writer.Open(outFileName, outVersion))
+		return false;
+
+	CAfxGameRecordWriteVisitor visitor(writer);
+
+	bool ok = parser.Parse(&visitor);
+
+	if (!writer.Close())
+		ok = false;
+
+	return ok;
+}
+
+// CAfxGameRecordParser ////////////////////////////////////////////////////////
+
+CAfxGameRecordParser::CAfxGameRecordParser()
+: m_Version(0)
+, m_Pos(0)
+, m_End(0)
+, m_NextBlockOffset(0)
+, m_Invalid(false)
+, m_EntityGeneration(1)
+{
+}
+
+bool CAfxGameRecordParser::Open(wchar_t const * fileName)
+{
+	Close();
+
+	if (!m_File.Open(fileName))
+		return false;
+
+	unsigned char const * data = m_File.GetData();
+	size_t size = m_File.GetSize();
+
+	int version;
+
+	if (size < AFXGAMERECORD_HEADER_SIZE
+		|| 0 != memcmp(data, "afxGameRecord", 14))
+	{
+		Close();
+		return false;
+	}
+
+	memcpy(&version, data + 14, sizeof(version));
+
+	if (version != AFXGAMERECORD_VERSION_RAW && version != AFXGAMERECORD_VERSION_COMPRESSED)
+	{
+		Close();
+		return false;
+	}
+
+	m_Version = version;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version && AFXGAMERECORD_HEADER_SIZE + AFXGAMERECORD_INDEX_TRAILER_SIZE <= size)
+	{
+		size_t indexEnd = size - AFXGAMERECORD_INDEX_TRAILER_SIZE;
+		long long indexOffset = CAfxGameRecordIndex::GetIndexOffset(data + indexEnd);
+
+		if (AFXGAMERECORD_HEADER_SIZE <= indexOffset && indexOffset < (long long)indexEnd)
+			m_Index.Parse(data + indexOffset, indexEnd - (size_t)indexOffset, indexOffset);
+	}
+
+	return true;
+}
+
+void CAfxGameRecordParser::Close(void)
+{
+	m_File.Close();
+	m_Version = 0;
+	m_Index.Clear();
+	m_Pos = 0;
+	m_End = 0;
+	m_NextBlockOffset = 0;
+	m_Invalid = false;
+	m_Dictionary.clear();
+	m_DictionaryStrings.clear();
+	m_BoneCoder.Reset();
+	m_Entities.clear();
+}
+
+int CAfxGameRecordParser::GetVersion(void) const
+{
+	return m_Version;
+}
+
+int CAfxGameRecordParser::GetFrameCount(void) const
+{
+	return m_Index.GetFrameCount();
+}
+
+size_t CAfxGameRecordParser::GetFileSize(void) const
+{
+	return m_File.GetSize();
+}
+
+bool CAfxGameRecordParser::Parse(IAfxGameRecordVisitor * visitor, int firstFrame, int frameCount)
+{
+	if (!m_File.IsOpen() || firstFrame < 0)
+		return false;
+
+	size_t fileOffset = AFXGAMERECORD_HEADER_SIZE;
+	int dictionarySize = 0;
+	int frame = 0;
+
+	if (CAfxGameRecordIndex::Entry const * entry = m_Index.Find(firstFrame))
+	{
+		fileOffset = (size_t)entry->FileOffset;
+		dictionarySize = entry->DictionarySize;
+		frame = entry->FirstFrame;
+	}
+
+	if (!Restart(fileOffset, dictionarySize))
+		return false;
+
+	bool inFrame = false;
+
+	while (frameCount < 0 || frame < firstFrame + frameCount)
+	{
+		if (IsEnd())
+			return !m_Invalid && !inFrame && (firstFrame < frame || 0 == firstFrame);
+
+		IAfxGameRecordVisitor * frameVisitor = firstFrame <= frame ? visitor : 0;
+
+		char const * token;
+
+		if (!ReadDictionary(token))
+			return false;
+
+		if (0 == strcmp(token, "entity_state"))
+		{
+			AfxGameRecordEntity const * entity;
+
+			if (!ReadEntity(frame, entity))
+				return false;
+
+			if (frameVisitor) frameVisitor->OnEntity(*entity);
+		}
+		else if (0 == strcmp(token, "entity_unchanged"))
+		{
+			int handle;
+			int entityFrame;
+
+			if (!Read(handle) || !Read(entityFrame))
+				return false;
+
+			std::map<int, CachedEntity>::iterator it = m_Entities.find(handle);
+
+			if (it == m_Entities.end() || it->second.Generation != m_EntityGeneration || it->second.Frame != entityFrame)
+				return false;
+
+			if (frameVisitor) frameVisitor->OnEntity(it->second.Entity);
+		}
+		else if (0 == strcmp(token, "afxFrame"))
+		{
+			float frameTime;
+			int hiddenOffset;
+
+			if (!Read(frameTime) || !Read(hiddenOffset))
+				return false;
+
+			inFrame = true;
+
+			if (frameVisitor) frameVisitor->OnFrame(frame, frameTime);
+		}
+		else if (0 == strcmp(token, "afxFrameEnd"))
+		{
+			inFrame = false;
+
+			if (frameVisitor) frameVisitor->OnFrameEnd(frame);
+
+			++frame;
+		}
+		else if (0 == strcmp(token, "afxCam"))
+		{
+			float values[7];
+
+			if (!Read(values, 7))
+				return false;
+
+			if (frameVisitor) frameVisitor->OnCamera(values);
+		}
+		else if (0 == strcmp(token, "deleted"))
+		{
+			int handle;
+
+			if (!Read(handle))
+				return false;
+
+			std::map<int, CachedEntity>::iterator it = m_Entities.find(handle);
+
+			if (it != m_Entities.end())
+				it->second.Generation = 0;
+
+			if (frameVisitor) frameVisitor->OnDeleted(handle);
+		}
+		else if (0 == strcmp(token, "afxHidden"))
+		{
+			int count;
+
+			if (!Read(count) || count < 0)
+				return false;
+
+			if (m_Hidden.size() < (size_t)count)
+				m_Hidden.resize(count);
+
+			if (0 < count && !ReadBytes(&m_Hidden[0], count * sizeof(int)))
+				return false;
+
+			if (frameVisitor) frameVisitor->OnHidden(count, 0 < count ? &m_Hidden[0] : 0);
+		}
+		else
+			return false;
+	}
+
+	return true;
+}
+
+bool CAfxGameRecordParser::Restart(size_t fileOffset, int dictionarySize)
+{
+	if (m_File.GetSize() < fileOffset)
+		return false;
+
+	m_Invalid = false;
+	m_Dictionary.clear();
+	m_DictionaryStrings.clear();
+	m_BoneCoder.Reset();
+	ResetEntities();
+
+	std::vector<std::string> const & indexDictionary = m_Index.GetDictionary();
+
+	for (int i = 0; i < dictionarySize; ++i)
+	{
+		m_Dictionary.push_back(indexDictionary[i].c_str());
+	}
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+	{
+		m_NextBlockOffset = fileOffset;
+		m_Pos = 0;
+		m_End = 0;
+	}
+	else
+	{
+		m_Pos = m_File.GetData() + fileOffset;
+		m_End = m_File.GetData() + m_File.GetSize();
+	}
+
+	return true;
+}
+
+bool CAfxGameRecordParser::NextBlock(void)
+{
+	if (AFXGAMERECORD_VERSION_COMPRESSED != m_Version)
+		return false;
+
+	unsigned char const * data = m_File.GetData();
+	size_t size = m_File.GetSize();
+
+	// Tolerated, so files that were not closed properly can still be read:
+	if (size - m_NextBlockOffset < 8)
+		return false;
+
+	unsigned char const * sizes = data + m_NextBlockOffset;
+
+	uLong rawSize = sizes[0] | (sizes[1] << 8) | (sizes[2] << 16) | ((uLong)sizes[3] << 24);
+	uLong compressedSize = sizes[4] | (sizes[5] << 8) | (sizes[6] << 16) | ((uLong)sizes[7] << 24);
+
+	// End marker:
+	if (0 == rawSize)
+		return false;
+
+	if (size - m_NextBlockOffset - 8 < compressedSize)
+	{
+		m_Invalid = true;
+		return false;
+	}
+
+	if (m_Block.size() < rawSize)
+		m_Block.resize(rawSize);
+
+	uLongf destLen = rawSize;
+	if (Z_OK != uncompress(&m_Block[0], &destLen, sizes + 8, compressedSize) || destLen != rawSize)
+	{
+		m_Invalid = true;
+		return false;
+	}
+
+	m_NextBlockOffset += 8 + compressedSize;
+	m_Pos = &m_Block[0];
+	m_End = m_Pos + rawSize;
+
+	// Each block starts with a fresh state:
+	m_BoneCoder.Reset();
+	ResetEntities();
+
+	return true;
+}
+
+bool CAfxGameRecordParser::IsEnd(void)
+{
+	return m_Pos == m_End && !NextBlock();
+}
+
+bool CAfxGameRecordParser::ReadBytes(void * outData, size_t size)
+{
+	// Blocks only contain whole frames, so values never cross blocks.
+	if ((size_t)(m_End - m_Pos) < size)
+		return false;
+
+	memcpy(outData, m_Pos, size);
+	m_Pos += size;
+
+	return true;
+}
+
+bool CAfxGameRecordParser::Read(bool & outValue)
+{
+	if (m_Pos == m_End)
+		return false;
+
+	outValue = 0 != *m_Pos;
+	++m_Pos;
+
+	return true;
+}
+
+bool CAfxGameRecordParser::Read(int & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordParser::Read(float & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordParser::Read(float * outValues, size_t count)
+{
+	return ReadBytes(outValues, count * sizeof(float));
+}
+
+bool CAfxGameRecordParser::ReadDictionary(char const * & outValue)
+{
+	int index;
+
+	if (!Read(index))
+		return false;
+
+	if (-1 == index)
+	{
+		unsigned char const * zero = (unsigned char const *)memchr(m_Pos, '\0', m_End - m_Pos);
+		if (!zero)
+			return false;
+
+		if (AFXGAMERECORD_VERSION_COMPRESSED == m_Version)
+		{
+			// The block is overwritten later, so the string has to be copied:
+			m_DictionaryStrings.push_back(std::string((char const *)m_Pos, (char const *)zero));
+			outValue = m_DictionaryStrings.back().c_str();
+		}
+		else
+			outValue = (char const *)m_Pos;
+
+		m_Dictionary.push_back(outValue);
+		m_Pos = zero + 1;
+
+		return true;
+	}
+
+	if (index < 0 || m_Dictionary.size() <= (size_t)index)
+		return false;
+
+	outValue = m_Dictionary[index];
+
+	return true;
+}
+
+void CAfxGameRecordParser::ResetEntities(void)
+{
+	for (std::map<int, CachedEntity>::iterator it = m_Entities.begin(); it != m_Entities.end(); )
+	{
+		if (it->second.Generation != m_EntityGeneration)
+			it = m_Entities.erase(it);
+		else
+			++it;
+	}
+
+	++m_EntityGeneration;
+}
+
+bool CAfxGameRecordParser::ReadEntity(int frame, AfxGameRecordEntity const * & outEntity)
+{
+	int handle;
+
+	if (!Read(handle))
+		return false;
+
+	CachedEntity & cached = m_Entities[handle];
+	AfxGameRecordEntity & entity = cached.Entity;
+
+	// Invalid until completely read:
+	cached.Generation = 0;
+
+	entity.Handle = handle;
+	entity.HasBaseEntity = false;
+	entity.ModelName = 0;
+	entity.HasBaseAnimating = false;
+	entity.HasBoneList = false;
+	entity.NumBones = 0;
+	entity.BonePositions = 0;
+	entity.BoneRotations = 0;
+	entity.HasCamera = false;
+
+	while (true)
+	{
+		char const * token;
+
+		if (!ReadDictionary(token))
+			return false;
+
+		if (0 == strcmp(token, "/"))
+		{
+			if (!Read(entity.ViewModel))
+				return false;
+
+			cached.Frame = frame;
+			cached.Generation = m_EntityGeneration;
+			outEntity = &entity;
+
+			return true;
+		}
+		else if (0 == strcmp(token, "baseentity"))
+		{
+			entity.HasBaseEntity = true;
+
+			if (!ReadDictionary(entity.ModelName)
+				|| !Read(entity.Visible)
+				|| !Read(entity.RenderOrigin, 3)
+				|| !Read(entity.RenderAngles, 3))
+				return false;
+		}
+		else if (0 == strcmp(token, "baseanimating"))
+		{
+			entity.HasBaseAnimating = true;
+
+			if (!Read(entity.HasBoneList))
+				return false;
+
+			if (entity.HasBoneList && !ReadBones(cached))
+				return false;
+		}
+		else if (0 == strcmp(token, "camera"))
+		{
+			entity.HasCamera = true;
+
+			if (!Read(entity.ThirdPerson)
+				|| !Read(entity.EyePosition, 3)
+				|| !Read(entity.EyeAngles, 3)
+				|| !Read(entity.Fov))
+				return false;
+		}
+		else
+			return false;
+	}
+}
+
+bool CAfxGameRecordParser::ReadBones(CachedEntity & cached)
+{
+	AfxGameRecordEntity & entity = cached.Entity;
+	int numBones;
+
+	if (!Read(numBones) || numBones < 0)
+		return false;
+
+	if (cached.BonePositions.size() < 3 * (size_t)numBones)
+	{
+		cached.BonePositions.resize(3 * (size_t)numBones);
+		cached.BoneRotations.resize(4 * (size_t)numBones);
+	}
+
+	entity.NumBones = numBones;
+
+	if (0 == numBones)
+		return true;
+
+	float * positions = &cached.BonePositions[0];
+	float * rotations = &cached.BoneRotations[0];
+
+	entity.BonePositions = positions;
+	entity.BoneRotations = rotations;
+
+	if (AFXGAMERECORD_VERSION_COMPRESSED != m_Version)
+	{
+		for (int i = 0; i < numBones; ++i)
+		{
+			if (!Read(&positions[3 * i], 3) || !Read(&rotations[4 * i], 4))
+				return false;
+		}
+
+		return true;
+	}
+
+	m_BoneCoder.BeginBones(entity.Handle, numBones);
+
+	for (int i = 0; i < numBones; ++i)
+	{
+		if (!m_BoneCoder.DecodeBone(m_Pos, m_End, &positions[3 * i], &rotations[4 * i]))
+			return false;
+	}
+
+	return true;
+}
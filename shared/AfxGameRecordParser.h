@@ -0,0 +1,184 @@
+#pragma once
+
+#include "AfxGameRecord.h"
+#include "AfxMappedFile.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/// <summary>An entity_state record, see CAfxGameRecordParser for how long the pointers are valid.</summary>
+struct AfxGameRecordEntity
+{
+	int Handle;
+
+	bool HasBaseEntity;
+	char const * ModelName;
+	bool Visible;
+	float RenderOrigin[3];
+	float RenderAngles[3];
+
+	bool HasBaseAnimating;
+	bool HasBoneList;
+	int NumBones;
+	/// <summary>3 floats per bone.</summary>
+	float const * BonePositions;
+	/// <summary>4 floats (quaternion x, y, z, w) per bone.</summary>
+	float const * BoneRotations;
+
+	bool HasCamera;
+	bool ThirdPerson;
+	float EyePosition[3];
+	float EyeAngles[3];
+	float Fov;
+
+	bool ViewModel;
+};
+
+/// <summary>Receives the records of an AGR in file order.</summary>
+class __declspec(novtable) IAfxGameRecordVisitor abstract
+{
+public:
+	virtual void OnFrame(int frame, float frameTime) abstract = 0;
+
+	/// <param name="values">x, y, z, pitch, yaw, roll, fov</param>
+	virtual void OnCamera(float const * values) abstract = 0;
+
+	/// <remarks>Also for entity_unchanged records (with the state they refer to).</remarks>
+	virtual void OnEntity(AfxGameRecordEntity const & entity) abstract = 0;
+
+	/// <remarks>Can also happen between frames (before OnFrame of the next frame).</remarks>
+	virtual void OnDeleted(int handle) abstract = 0;
+
+	virtual void OnHidden(int count, int const * handles) abstract = 0;
+
+	virtual void OnFrameEnd(int frame) abstract = 0;
+};
+
+/// <summary>Writes the visited records to a CAfxGameRecordWriter (e.g. to slice, filter or convert an AGR).</summary>
+class CAfxGameRecordWriteVisitor : public IAfxGameRecordVisitor
+{
+public:
+	/// <param name="writer">Must be open.</param>
+	CAfxGameRecordWriteVisitor(CAfxGameRecordWriter & writer);
+
+	virtual void OnFrame(int frame, float frameTime);
+
+	virtual void OnCamera(float const * values);
+
+	virtual void OnEntity(AfxGameRecordEntity const & entity);
+
+	virtual void OnDeleted(int handle);
+
+	virtual void OnHidden(int count, int const * handles);
+
+	virtual void OnFrameEnd(int frame);
+
+private:
+	CAfxGameRecordWriter & m_Writer;
+	size_t m_HiddenOffset;
+};
+
+/// <summary>Re-writes an AGR with the given version, e.g. to make a version 6 AGR readable for version 5 importers.</summary>
+/// <returns>false on error.</returns>
+bool AfxGameRecordConvert(wchar_t const * inFileName, wchar_t const * outFileName, int outVersion);
+
+/// <summary>
+///   Memory mapped, streaming AGR (version 5 and 6) parser that doesn't
+///   allocate per frame (only for new dictionary entries, entities and
+///   larger bone lists than before).<br />
+///   entity_unchanged records are visited as the entity_state they refer to.
+/// </summary>
+/// <remarks>
+///   Pointers handed to the visitor are only valid during the callback,
+///   except AfxGameRecordEntity::ModelName, which is valid until the next
+///   Parse or Close.
+/// </remarks>
+class CAfxGameRecordParser
+{
+public:
+	CAfxGameRecordParser();
+
+	/// <summary>Maps the file, reads the header and the index (if any).</summary>
+	/// <returns>false if the file can't be mapped or the version is not supported.</returns>
+	bool Open(wchar_t const * fileName);
+
+	void Close(void);
+
+	int GetVersion(void) const;
+
+	/// <returns>Number of frames according to the index, -1 if there is no index.</returns>
+	int GetFrameCount(void) const;
+
+	/// <returns>Size of the file in bytes.</returns>
+	size_t GetFileSize(void) const;
+
+	/// <summary>Parses the frames firstFrame up to firstFrame + frameCount (exclusive).</summary>
+	/// <remarks>
+	///   Frames before firstFrame are decoded without being visited, with an
+	///   index only the ones in the same block.
+	/// </remarks>
+	/// <param name="visitor">Can be 0 (only validates the data).</param>
+	/// <param name="frameCount">-1 for all remaining frames.</param>
+	/// <returns>false on invalid data (or if firstFrame doesn't exist), the visitor might have been called for some records already then.</returns>
+	bool Parse(IAfxGameRecordVisitor * visitor, int firstFrame = 0, int frameCount = -1);
+
+private:
+	CAfxMappedFile m_File;
+	int m_Version;
+	CAfxGameRecordIndex m_Index;
+
+	unsigned char const * m_Pos;
+	unsigned char const * m_End;
+
+	/// <summary>Version 6: file offset of the next block.</summary>
+	size_t m_NextBlockOffset;
+	/// <summary>Version 6: the next block is corrupt.</summary>
+	bool m_Invalid;
+	std::vector<unsigned char> m_Block;
+
+	std::vector<char const *> m_Dictionary;
+	std::deque<std::string> m_DictionaryStrings;
+
+	CAfxGameRecordBoneCoder m_BoneCoder;
+	std::vector<int> m_Hidden;
+
+	/// <summary>Last entity_state of an entity, for entity_unchanged records.</summary>
+	struct CachedEntity
+	{
+		AfxGameRecordEntity Entity;
+		std::vector<float> BonePositions;
+		std::vector<float> BoneRotations;
+		int Frame;
+
+		/// <summary>Only valid if this equals m_EntityGeneration (one per block).</summary>
+		unsigned int Generation;
+
+		CachedEntity()
+		: Generation(0)
+		{
+		}
+	};
+
+	std::map<int, CachedEntity> m_Entities;
+	unsigned int m_EntityGeneration;
+
+	void ResetEntities(void);
+
+	bool Restart(size_t fileOffset, int dictionarySize);
+
+	/// <returns>false if there is no more data.</returns>
+	bool NextBlock(void);
+
+	bool IsEnd(void);
+
+	bool ReadBytes(void * outData, size_t size);
+	bool Read(bool & outValue);
+	bool Read(int & outValue);
+	bool Read(float & outValue);
+	bool Read(float * outValues, size_t count);
+	bool ReadDictionary(char const * & outValue);
+	bool ReadEntity(int frame, AfxGameRecordEntity const * & outEntity);
+	bool ReadBones(CachedEntity & entity);
+};
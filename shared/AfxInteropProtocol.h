@@ -0,0 +1,32 @@
+#pragma once
+
+// Message ids of the AfxInterop engine connection, shared by AfxHookSource
+// (AfxInterop.cpp) and the stand-ins / replay tools (AfxInteropStandIn.h,
+// AfxInteropReplay.h).
+
+namespace AfxInteropProtocol {
+
+enum EngineMessage {
+	EngineMessage_Invalid = 0,
+	EngineMessage_LevelInitPreEntity = 1,
+	EngineMessage_LevelShutDown = 2,
+	EngineMessage_BeforeFrameStart = 3,
+	EngineMessage_OnRenderView = 4,
+	EngineMessage_OnRenderViewEnd = 5,
+	EngineMessage_BeforeFrameRenderStart = 6,
+	EngineMessage_AfterFrameRenderStart = 7,
+	EngineMessage_OnViewOverride = 8,
+	EngineMessage_BeforeTranslucentShadow = 9,
+	EngineMessage_AfterTranslucentShadow = 10,
+	EngineMessage_BeforeTranslucent = 11,
+	EngineMessage_AfterTranslucent = 12,
+	EngineMessage_OnBeforeHud = 13,
+	EngineMessage_OnAfterHud = 14,
+	EngineMessage_OnGameEvent = 15,
+	EngineMessage_Frame = 16
+};
+
+/// <summary>Highest EngineMessage.</summary>
+const int EngineMessage_Max = EngineMessage_Frame;
+
+} // namespace AfxInteropProtocol {
@@ -0,0 +1,564 @@
+#include "stdafx.h"
+
+#include "AfxInteropReplay.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+using namespace AfxInteropProtocol;
+
+#define AFXINTEROPRECORDING_MAGIC 0x52495841 // "AXIR"
+#define AFXINTEROPRECORDING_VERSION 1
+
+// Byte direction, UInt64 time, UInt32 size:
+#define AFXINTEROPRECORDING_CHUNK_HEADER_SIZE 13
+
+#define AFXINTEROPRECORDER_BUFFER_SIZE (64 * 1024)
+
+// 4 buckets per power of 2 from 1 ns to 2^40 ns (about 1100 s):
+#define AFXINTEROPLATENCYHISTOGRAM_BUCKETS_PER_OCTAVE 4
+#define AFXINTEROPLATENCYHISTOGRAM_BUCKETS (40 * AFXINTEROPLATENCYHISTOGRAM_BUCKETS_PER_OCTAVE)
+
+static void AppendUInt32(std::vector<unsigned char> & buffer, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i) buffer.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void AppendUInt64(std::vector<unsigned char> & buffer, uint64_t value)
+{
+	for (int i = 0; i < 8; ++i) buffer.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static uint32_t GetUInt32(unsigned char const * data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t GetUInt64(unsigned char const * data)
+{
+	return (uint64_t)GetUInt32(data) | ((uint64_t)GetUInt32(data + 4) << 32);
+}
+
+static double MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CAfxInteropPipeTransport::CAfxInteropPipeTransport()
+#ifdef _WIN32
+	: m_Read(NULL)
+	, m_Write(NULL)
+#else
+	: m_Read(-1)
+	, m_Write(-1)
+#endif
+{
+}
+
+CAfxInteropPipeTransport::~CAfxInteropPipeTransport()
+{
+	CloseWrite();
+	CloseRead();
+}
+
+bool CAfxInteropPipeTransport::Connect(CAfxInteropPipeTransport & a, CAfxInteropPipeTransport & b)
+{
+	a.CloseWrite();
+	a.CloseRead();
+	b.CloseWrite();
+	b.CloseRead();
+
+#ifdef _WIN32
+	if (!CreatePipe(&a.m_Read, &b.m_Write, NULL, 0))
+	{
+		a.m_Read = b.m_Write = NULL;
+		return false;
+	}
+	if (!CreatePipe(&b.m_Read, &a.m_Write, NULL, 0))
+	{
+		b.m_Read = a.m_Write = NULL;
+		return false;
+	}
+#else
+	int fds[2];
+	if (0 != pipe(fds)) return false;
+	a.m_Read = fds[0];
+	b.m_Write = fds[1];
+	if (0 != pipe(fds)) return false;
+	b.m_Read = fds[0];
+	a.m_Write = fds[1];
+#endif
+
+	return true;
+}
+
+void CAfxInteropPipeTransport::CloseWrite(void)
+{
+#ifdef _WIN32
+	if (NULL != m_Write) CloseHandle(m_Write);
+	m_Write = NULL;
+#else
+	if (-1 != m_Write) close(m_Write);
+	m_Write = -1;
+#endif
+}
+
+void CAfxInteropPipeTransport::CloseRead(void)
+{
+#ifdef _WIN32
+	if (NULL != m_Read) CloseHandle(m_Read);
+	m_Read = NULL;
+#else
+	if (-1 != m_Read) close(m_Read);
+	m_Read = -1;
+#endif
+}
+
+size_t CAfxInteropPipeTransport::ReadSome(void * data, size_t size)
+{
+#ifdef _WIN32
+	DWORD result;
+	if (!ReadFile(m_Read, data, (DWORD)size, &result, NULL)) return 0;
+	return result;
+#else
+	ssize_t result = read(m_Read, data, size);
+	return result < 0 ? 0 : (size_t)result;
+#endif
+}
+
+bool CAfxInteropPipeTransport::GetReadable(size_t & outSize)
+{
+#ifdef _WIN32
+	DWORD available;
+	if (!PeekNamedPipe(m_Read, NULL, 0, NULL, &available, NULL)) return false;
+	outSize = available;
+#else
+	int available;
+	if (0 != ioctl(m_Read, FIONREAD, &available)) return false;
+	outSize = (size_t)available;
+#endif
+	return true;
+}
+
+bool CAfxInteropPipeTransport::WriteAll(void const * data, size_t size)
+{
+	for (size_t written = 0; written < size; )
+	{
+#ifdef _WIN32
+		DWORD result;
+		if (!WriteFile(m_Write, (char const *)data + written, (DWORD)(size - written), &result, NULL)) return false;
+#else
+		ssize_t result = write(m_Write, (char const *)data + written, size - written);
+		if (result <= 0) return false;
+#endif
+		written += (size_t)result;
+	}
+	return true;
+}
+
+bool CAfxInteropPipeTransport::Flush(void)
+{
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CAfxInteropRecorder::CAfxInteropRecorder()
+	: m_Transport(nullptr)
+{
+}
+
+CAfxInteropRecorder::~CAfxInteropRecorder()
+{
+	Close();
+}
+
+bool CAfxInteropRecorder::Open(wchar_t const * fileName, IAfxInteropTransport * transport)
+{
+	Close();
+
+	if (!m_File.Open(fileName)) return false;
+
+	m_Transport = transport;
+	m_Start = std::chrono::steady_clock::now();
+
+	m_Buffer.clear();
+	m_Buffer.reserve(AFXINTEROPRECORDER_BUFFER_SIZE);
+	AppendUInt32(m_Buffer, AFXINTEROPRECORDING_MAGIC);
+	AppendUInt32(m_Buffer, AFXINTEROPRECORDING_VERSION);
+
+	return true;
+}
+
+bool CAfxInteropRecorder::IsOpen(void) const
+{
+	return m_File.IsOpen();
+}
+
+bool CAfxInteropRecorder::Close(void)
+{
+	if (!m_File.IsOpen()) return true;
+
+	if (!m_Buffer.empty()) m_File.Write(m_Buffer);
+	m_Transport = nullptr;
+
+	return m_File.Close();
+}
+
+void CAfxInteropRecorder::AddChunk(bool sent, void const * data, size_t size)
+{
+	uint64_t time = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_Start).count();
+
+	m_Buffer.push_back(sent ? 1 : 0);
+	AppendUInt64(m_Buffer, time);
+	AppendUInt32(m_Buffer, (uint32_t)size);
+	m_Buffer.insert(m_Buffer.end(), (unsigned char const *)data, (unsigned char const *)data + size);
+
+	if (AFXINTEROPRECORDER_BUFFER_SIZE <= m_Buffer.size()) m_File.Write(m_Buffer);
+}
+
+size_t CAfxInteropRecorder::ReadSome(void * data, size_t size)
+{
+	size_t result = m_Transport->ReadSome(data, size);
+
+	if (0 < result) AddChunk(false, data, result);
+
+	return result;
+}
+
+bool CAfxInteropRecorder::GetReadable(size_t & outSize)
+{
+	return m_Transport->GetReadable(outSize);
+}
+
+bool CAfxInteropRecorder::WriteAll(void const * data, size_t size)
+{
+	if (0 < size) AddChunk(true, data, size);
+
+	return m_Transport->WriteAll(data, size);
+}
+
+bool CAfxInteropRecorder::Flush(void)
+{
+	return m_Transport->Flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CAfxInteropLatencyHistogram::CAfxInteropLatencyHistogram()
+	: m_Buckets(AFXINTEROPLATENCYHISTOGRAM_BUCKETS, 0)
+	, m_Count(0)
+	, m_Sum(0)
+	, m_Min(0)
+	, m_Max(0)
+{
+}
+
+void CAfxInteropLatencyHistogram::Add(double microseconds)
+{
+	double nanoseconds = 1000.0 * microseconds;
+
+	int bucket = 1.0 < nanoseconds ? (int)floor(AFXINTEROPLATENCYHISTOGRAM_BUCKETS_PER_OCTAVE * log2(nanoseconds)) : 0;
+	if (bucket < 0) bucket = 0;
+	else if (AFXINTEROPLATENCYHISTOGRAM_BUCKETS <= bucket) bucket = AFXINTEROPLATENCYHISTOGRAM_BUCKETS - 1;
+
+	++m_Buckets[bucket];
+
+	if (0 == m_Count || microseconds < m_Min) m_Min = microseconds;
+	if (0 == m_Count || m_Max < microseconds) m_Max = microseconds;
+	m_Sum += microseconds;
+	++m_Count;
+}
+
+double CAfxInteropLatencyHistogram::GetMin(void) const
+{
+	return m_Min;
+}
+
+double CAfxInteropLatencyHistogram::GetMax(void) const
+{
+	return m_Max;
+}
+
+double CAfxInteropLatencyHistogram::GetMean(void) const
+{
+	return 0 < m_Count ? m_Sum / m_Count : 0;
+}
+
+double CAfxInteropLatencyHistogram::GetPercentile(double percentile) const
+{
+	if (0 == m_Count) return 0;
+
+	size_t target = (size_t)ceil(percentile / 100.0 * m_Count);
+	if (target < 1) target = 1;
+	else if (m_Count < target) target = m_Count;
+
+	size_t count = 0;
+	size_t i = 0;
+
+	for (; i + 1 < m_Buckets.size(); ++i)
+	{
+		count += m_Buckets[i];
+		if (target <= count) break;
+	}
+
+	double upperBound = GetBucketUpperBound(i);
+
+	return upperBound < m_Max ? upperBound : m_Max;
+}
+
+double CAfxInteropLatencyHistogram::GetBucketUpperBound(size_t bucket) const
+{
+	return pow(2.0, (double)(bucket + 1) / AFXINTEROPLATENCYHISTOGRAM_BUCKETS_PER_OCTAVE) / 1000.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+AfxInteropReplayStats::AfxInteropReplayStats()
+	: Exchanges(0)
+	, BytesWritten(0)
+	, BytesRead(0)
+	, BytesDiffering(0)
+	, Seconds(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool CAfxInteropRecording::Load(wchar_t const * fileName)
+{
+	m_Data.clear();
+	m_Chunks.clear();
+	m_Exchanges.clear();
+
+	FILE * file = nullptr;
+	_wfopen_s(&file, fileName, L"rb");
+	if (nullptr == file) return false;
+
+	std::vector<unsigned char> data;
+	unsigned char buffer[64 * 1024];
+	size_t count;
+
+	while (0 < (count = fread(buffer, 1, sizeof(buffer), file)))
+	{
+		data.insert(data.end(), buffer, buffer + count);
+	}
+
+	bool ok = 0 == ferror(file);
+	fclose(file);
+
+	if (!ok || data.size() < 8
+		|| AFXINTEROPRECORDING_MAGIC != GetUInt32(&data[0])
+		|| AFXINTEROPRECORDING_VERSION != GetUInt32(&data[4])) return false;
+
+	for (size_t pos = 8; pos < data.size(); )
+	{
+		if (data.size() - pos < AFXINTEROPRECORDING_CHUNK_HEADER_SIZE) return false;
+
+		AfxInteropRecordingChunk chunk;
+		chunk.Sent = 0 != data[pos];
+		chunk.Time = GetUInt64(&data[pos + 1]);
+		chunk.Size = GetUInt32(&data[pos + 9]);
+		chunk.Offset = pos + AFXINTEROPRECORDING_CHUNK_HEADER_SIZE;
+
+		if (data.size() - chunk.Offset < chunk.Size) return false;
+
+		m_Chunks.push_back(chunk);
+		pos = chunk.Offset + chunk.Size;
+	}
+
+	m_Data.swap(data);
+
+	BuildExchanges();
+
+	return true;
+}
+
+// The messages that the engine waits for an answer to (version 8: only
+// the Frame replies). Messages without answer are sent together with the
+// next one, so that one names the exchange:
+static bool IsAnsweredMessage(int32_t message)
+{
+	switch (message)
+	{
+	case EngineMessage_BeforeFrameStart:
+	case EngineMessage_BeforeFrameRenderStart:
+	case EngineMessage_AfterFrameRenderStart:
+	case EngineMessage_OnViewOverride:
+	case EngineMessage_OnRenderView:
+	case EngineMessage_Frame:
+		return true;
+	}
+
+	return false;
+}
+
+void CAfxInteropRecording::BuildExchanges(void)
+{
+	for (size_t i = 0; i < m_Chunks.size(); )
+	{
+		AfxInteropExchange exchange;
+		exchange.Message = -1;
+		exchange.FirstChunk = i;
+		exchange.SentBytes = 0;
+		exchange.ReceivedBytes = 0;
+
+		int firstMessage = -1;
+
+		for (; i < m_Chunks.size() && m_Chunks[i].Sent; ++i)
+		{
+			AfxInteropRecordingChunk const & chunk = m_Chunks[i];
+
+			// The stream hands over what was buffered since the last read,
+			// so a message usually starts a chunk (after i.e. the calc results
+			// of the message before it):
+			if (4 <= chunk.Size)
+			{
+				int32_t message = (int32_t)GetUInt32(&m_Data[chunk.Offset]);
+
+				if (EngineMessage_Invalid < message && message <= EngineMessage_Max)
+				{
+					if (-1 == firstMessage) firstMessage = message;
+
+					if (IsAnsweredMessage(message) && EngineMessage_Frame != exchange.Message) exchange.Message = message;
+				}
+			}
+
+			exchange.SentBytes += chunk.Size;
+		}
+
+		if (-1 == exchange.Message) exchange.Message = firstMessage;
+
+		exchange.FirstReceivedChunk = i;
+
+		for (; i < m_Chunks.size() && !m_Chunks[i].Sent; ++i)
+		{
+			exchange.ReceivedBytes += m_Chunks[i].Size;
+		}
+
+		exchange.EndChunk = i;
+
+		exchange.RecordedTime = m_Chunks[exchange.EndChunk - 1].Time - m_Chunks[exchange.FirstChunk].Time;
+
+		m_Exchanges.push_back(exchange);
+	}
+}
+
+bool CAfxInteropRecording::ReplayWrite(IAfxInteropTransport * transport, size_t beginChunk, size_t endChunk, AfxInteropReplayStats & outStats) const
+{
+	for (size_t i = beginChunk; i < endChunk; ++i)
+	{
+		AfxInteropRecordingChunk const & chunk = m_Chunks[i];
+
+		if (!transport->WriteAll(&m_Data[chunk.Offset], chunk.Size)) return false;
+
+		outStats.BytesWritten += chunk.Size;
+	}
+
+	return true;
+}
+
+bool CAfxInteropRecording::ReplayRead(IAfxInteropTransport * transport, size_t beginChunk, size_t endChunk, std::vector<unsigned char> & buffer, AfxInteropReplayStats & outStats) const
+{
+	for (size_t i = beginChunk; i < endChunk; ++i)
+	{
+		AfxInteropRecordingChunk const & chunk = m_Chunks[i];
+		unsigned char const * expected = &m_Data[chunk.Offset];
+
+		buffer.resize(chunk.Size);
+
+		for (size_t pos = 0; pos < chunk.Size; )
+		{
+			size_t count = transport->ReadSome(&buffer[pos], chunk.Size - pos);
+			if (0 == count) return false;
+			pos += count;
+		}
+
+		for (size_t j = 0; j < chunk.Size; ++j)
+		{
+			if (buffer[j] != expected[j]) ++outStats.BytesDiffering;
+		}
+
+		outStats.BytesRead += chunk.Size;
+	}
+
+	return true;
+}
+
+bool CAfxInteropRecording::Replay(bool engineSide, IAfxInteropTransport * transport, AfxInteropReplayStats & outStats) const
+{
+	std::vector<unsigned char> buffer;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point answered = start;
+
+	for (size_t i = 0; i < m_Exchanges.size(); ++i)
+	{
+		AfxInteropExchange const & exchange = m_Exchanges[i];
+		CAfxInteropLatencyHistogram & latencies = outStats.Latencies[exchange.Message + 1];
+
+		if (engineSide)
+		{
+			std::chrono::steady_clock::time_point sending = std::chrono::steady_clock::now();
+
+			if (!ReplayWrite(transport, exchange.FirstChunk, exchange.FirstReceivedChunk, outStats)
+				|| !ReplayRead(transport, exchange.FirstReceivedChunk, exchange.EndChunk, buffer, outStats)) return false;
+
+			latencies.Add(MicrosecondsSince(sending));
+		}
+		else
+		{
+			if (!ReplayRead(transport, exchange.FirstChunk, exchange.FirstReceivedChunk, buffer, outStats)) return false;
+
+			// The engine's turnaround, from our last answer until its message is read:
+			latencies.Add(MicrosecondsSince(answered));
+
+			if (!ReplayWrite(transport, exchange.FirstReceivedChunk, exchange.EndChunk, outStats)) return false;
+
+			answered = std::chrono::steady_clock::now();
+		}
+
+		++outStats.Exchanges;
+	}
+
+	outStats.Seconds += MicrosecondsSince(start) / 1000000.0;
+
+	return true;
+}
+
+char const * CAfxInteropRecording::GetMessageName(int message)
+{
+	switch (message)
+	{
+	case -1: return "Connect";
+	case EngineMessage_Invalid: return "Invalid";
+	case EngineMessage_LevelInitPreEntity: return "LevelInitPreEntity";
+	case EngineMessage_LevelShutDown: return "LevelShutDown";
+	case EngineMessage_BeforeFrameStart: return "BeforeFrameStart";
+	case EngineMessage_OnRenderView: return "OnRenderView";
+	case EngineMessage_OnRenderViewEnd: return "OnRenderViewEnd";
+	case EngineMessage_BeforeFrameRenderStart: return "BeforeFrameRenderStart";
+	case EngineMessage_AfterFrameRenderStart: return "AfterFrameRenderStart";
+	case EngineMessage_OnViewOverride: return "OnViewOverride";
+	case EngineMessage_BeforeTranslucentShadow: return "BeforeTranslucentShadow";
+	case EngineMessage_AfterTranslucentShadow: return "AfterTranslucentShadow";
+	case EngineMessage_BeforeTranslucent: return "BeforeTranslucent";
+	case EngineMessage_AfterTranslucent: return "AfterTranslucent";
+	case EngineMessage_OnBeforeHud: return "OnBeforeHud";
+	case EngineMessage_OnAfterHud: return "OnAfterHud";
+	case EngineMessage_OnGameEvent: return "OnGameEvent";
+	case EngineMessage_Frame: return "Frame";
+	}
+
+	return "Unknown";
+}
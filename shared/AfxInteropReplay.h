@@ -0,0 +1,234 @@
+#pragma once
+
+#include "AfxInteropProtocol.h"
+#include "AfxInteropStream.h"
+#include "AfxWriteBehindFile.h"
+
+#include <stddef.h>
+
+#include <chrono>
+#include <vector>
+
+/// <summary>
+///   One end of a pair of anonymous pipes (in process), to compare the other
+///   transports against named pipes without a pipe server.
+/// </summary>
+class CAfxInteropPipeTransport : public IAfxInteropTransport
+{
+public:
+	CAfxInteropPipeTransport();
+
+	~CAfxInteropPipeTransport();
+
+	/// <summary>Connects two ends: what one writes the other reads.</summary>
+	static bool Connect(CAfxInteropPipeTransport & a, CAfxInteropPipeTransport & b);
+
+	/// <summary>Closes the writing end, so the other end reads 0 (like a disconnect).</summary>
+	void CloseWrite(void);
+
+	virtual size_t ReadSome(void * data, size_t size) override;
+
+	virtual bool GetReadable(size_t & outSize) override;
+
+	virtual bool WriteAll(void const * data, size_t size) override;
+
+	/// <summary>Returns at once (anonymous pipes can't wait for the reader).</summary>
+	virtual bool Flush(void) override;
+
+private:
+#ifdef _WIN32
+	void * m_Read;
+	void * m_Write;
+#else
+	int m_Read;
+	int m_Write;
+#endif
+
+	void CloseRead(void);
+};
+
+/// <summary>
+///   Records everything read from and written to a transport into a file
+///   (see CAfxInteropRecording for the format), i.e. AfxHookSource's side of
+///   a session with a real client.
+/// </summary>
+/// <remarks>Open, the transport calls and Close must be called from the same thread.</remarks>
+class CAfxInteropRecorder : public IAfxInteropTransport
+{
+public:
+	CAfxInteropRecorder();
+
+	/// <summary>Calls Close.</summary>
+	~CAfxInteropRecorder();
+
+	/// <param name="transport">The transport to record, not owned.</param>
+	bool Open(wchar_t const * fileName, IAfxInteropTransport * transport);
+
+	bool IsOpen(void) const;
+
+	/// <returns>false if writing the file failed.</returns>
+	bool Close(void);
+
+	virtual size_t ReadSome(void * data, size_t size) override;
+
+	virtual bool GetReadable(size_t & outSize) override;
+
+	virtual bool WriteAll(void const * data, size_t size) override;
+
+	virtual bool Flush(void) override;
+
+private:
+	IAfxInteropTransport * m_Transport;
+	CAfxWriteBehindFile m_File;
+	std::vector<unsigned char> m_Buffer;
+	std::chrono::steady_clock::time_point m_Start;
+
+	void AddChunk(bool sent, void const * data, size_t size);
+};
+
+/// <summary>Latencies in buckets of a quarter power of 2 (about 19% wide), from 1 ns to about 1000 s.</summary>
+class CAfxInteropLatencyHistogram
+{
+public:
+	CAfxInteropLatencyHistogram();
+
+	void Add(double microseconds);
+
+	size_t GetCount(void) const
+	{
+		return m_Count;
+	}
+
+	double GetMin(void) const;
+
+	double GetMax(void) const;
+
+	double GetMean(void) const;
+
+	/// <returns>Upper bound (at most GetMax) of the bucket that contains the percentile (0 to 100) in microseconds, 0 if empty.</returns>
+	double GetPercentile(double percentile) const;
+
+	size_t GetBucketCount(void) const
+	{
+		return m_Buckets.size();
+	}
+
+	/// <returns>Upper bound of the bucket in microseconds.</returns>
+	double GetBucketUpperBound(size_t bucket) const;
+
+	size_t GetBucketSize(size_t bucket) const
+	{
+		return m_Buckets[bucket];
+	}
+
+private:
+	std::vector<size_t> m_Buckets;
+	size_t m_Count;
+	double m_Sum;
+	double m_Min;
+	double m_Max;
+};
+
+struct AfxInteropRecordingChunk
+{
+	/// <summary>true: written by the recorded side, false: read.</summary>
+	bool Sent;
+
+	/// <summary>Microseconds since the recording started.</summary>
+	unsigned long long Time;
+
+	size_t Offset;
+	size_t Size;
+};
+
+/// <summary>What the recorded (engine) side sends, then what it reads before it sends again.</summary>
+struct AfxInteropExchange
+{
+	/// <summary>
+	///   The EngineMessage whose answer is read (Frame if any, else the last
+	///   message the engine waits for, else the first), -1 if no message is sent (connecting).
+	/// </summary>
+	int Message;
+
+	/// <summary>Chunks [FirstChunk, FirstReceivedChunk) are sent, [FirstReceivedChunk, EndChunk) received.</summary>
+	size_t FirstChunk;
+	size_t FirstReceivedChunk;
+	size_t EndChunk;
+
+	size_t SentBytes;
+	size_t ReceivedBytes;
+
+	/// <summary>Recorded time from the first chunk to the end of the last in microseconds.</summary>
+	unsigned long long RecordedTime;
+};
+
+struct AfxInteropReplayStats
+{
+	/// <summary>Index is Message + 1 (0: connecting).</summary>
+	CAfxInteropLatencyHistogram Latencies[AfxInteropProtocol::EngineMessage_Max + 2];
+
+	size_t Exchanges;
+	size_t BytesWritten;
+	size_t BytesRead;
+
+	/// <summary>Read bytes that differ from the recording, i.e. a real client that answers differently.</summary>
+	size_t BytesDiffering;
+
+	double Seconds;
+
+	AfxInteropReplayStats();
+};
+
+/// <summary>
+///   A recorded session, file format (little endian):<br />
+///   UInt32 magic "AXIR", UInt32 version 1, then chunks:
+///   Byte 1 if sent (0 if read), UInt64 microseconds since start, UInt32 size, data.
+/// </summary>
+class CAfxInteropRecording
+{
+public:
+	/// <returns>false if the file can't be read or is not a recording.</returns>
+	bool Load(wchar_t const * fileName);
+
+	std::vector<AfxInteropRecordingChunk> const & GetChunks(void) const
+	{
+		return m_Chunks;
+	}
+
+	unsigned char const * GetChunkData(AfxInteropRecordingChunk const & chunk) const
+	{
+		return &m_Data[chunk.Offset];
+	}
+
+	std::vector<AfxInteropExchange> const & GetExchanges(void) const
+	{
+		return m_Exchanges;
+	}
+
+	/// <summary>
+	///   Plays one side of the recording at full speed (ignoring the recorded
+	///   times), the other side can be a real client / engine or another replay.
+	/// </summary>
+	/// <param name="engineSide">
+	///   true: write what was sent and read what was read, latency is from
+	///   the first write of an exchange until all of its answer is read.<br />
+	///   false: the other way around, latency is from the previous exchange's
+	///   last write until this exchange is read completely.
+	/// </param>
+	/// <returns>false if the transport fails.</returns>
+	bool Replay(bool engineSide, IAfxInteropTransport * transport, AfxInteropReplayStats & outStats) const;
+
+	/// <returns>Name of an AfxInteropExchange::Message.</returns>
+	static char const * GetMessageName(int message);
+
+private:
+	std::vector<unsigned char> m_Data;
+	std::vector<AfxInteropRecordingChunk> m_Chunks;
+	std::vector<AfxInteropExchange> m_Exchanges;
+
+	void BuildExchanges(void);
+
+	bool ReplayWrite(IAfxInteropTransport * transport, size_t beginChunk, size_t endChunk, AfxInteropReplayStats & outStats) const;
+
+	bool ReplayRead(IAfxInteropTransport * transport, size_t beginChunk, size_t endChunk, std::vector<unsigned char> & buffer, AfxInteropReplayStats & outStats) const;
+};
@@ -0,0 +1,493 @@
+#include "stdafx.h"
+
+#include "AfxInteropSharedMemory.h"
+
+#include <string.h>
+
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Shared memory layout (and futex) requires plain 32 bit atomics.");
+
+#define AFXINTEROPSHAREDMEMORY_MAGIC 0x53584641 // "AFXS"
+#define AFXINTEROPSHAREDMEMORY_VERSION 1
+
+/// <summary>Sleeps are not infinite, so a Close that came before the sleep is noticed.</summary>
+#define AFXINTEROPSHAREDMEMORY_SLEEP_MS 100
+
+CAfxInteropSharedMemoryTransport::CAfxInteropSharedMemoryTransport()
+: m_Header(0)
+, m_RingSize(0)
+, m_MappedSize(0)
+, m_ReadRing(0)
+, m_WriteRing(1)
+, m_SpinCount(100)
+#ifdef _WIN32
+, m_Mapping(NULL)
+#else
+, m_File(-1)
+, m_Unlink(false)
+#endif
+{
+	m_RingData[0] = 0;
+	m_RingData[1] = 0;
+
+#ifdef _WIN32
+	for (int ring = 0; ring < 2; ++ring)
+	{
+		for (int event = 0; event < 2; ++event) m_Events[ring][event] = NULL;
+	}
+#endif
+}
+
+CAfxInteropSharedMemoryTransport::~CAfxInteropSharedMemoryTransport()
+{
+	Close();
+}
+
+bool CAfxInteropSharedMemoryTransport::Create(char const * name, size_t ringSize)
+{
+	Close();
+
+	uint32_t size = 4096;
+	while (size < ringSize && size < 0x40000000) size <<= 1;
+
+	m_Name = name;
+
+	if (!Map(true, sizeof(Header) + 2 * (size_t)size) || !OpenEvents(true))
+	{
+		Close();
+		return false;
+	}
+
+	// The memory is zeroed by the OS, so positions and flags are 0 already.
+
+	m_Header->Version = AFXINTEROPSHAREDMEMORY_VERSION;
+	m_Header->RingSize = size;
+	m_Header->Magic.store(AFXINTEROPSHAREDMEMORY_MAGIC, std::memory_order_release);
+
+	m_RingSize = size;
+	m_RingData[0] = (unsigned char *)m_Header + sizeof(Header);
+	m_RingData[1] = m_RingData[0] + size;
+	m_ReadRing = 1;
+	m_WriteRing = 0;
+
+	return true;
+}
+
+bool CAfxInteropSharedMemoryTransport::Open(char const * name)
+{
+	Close();
+
+	m_Name = name;
+
+	if (!Map(false, 0)
+		|| AFXINTEROPSHAREDMEMORY_MAGIC != m_Header->Magic.load(std::memory_order_acquire)
+		|| AFXINTEROPSHAREDMEMORY_VERSION != m_Header->Version
+		|| m_MappedSize < sizeof(Header) + 2 * (size_t)m_Header->RingSize
+		|| !OpenEvents(false))
+	{
+		Close();
+		return false;
+	}
+
+	m_RingSize = m_Header->RingSize;
+	m_RingData[0] = (unsigned char *)m_Header + sizeof(Header);
+	m_RingData[1] = m_RingData[0] + m_RingSize;
+	m_ReadRing = 0;
+	m_WriteRing = 1;
+
+	return true;
+}
+
+void CAfxInteropSharedMemoryTransport::Close(void)
+{
+	if (m_Header && AFXINTEROPSHAREDMEMORY_MAGIC == m_Header->Magic.load(std::memory_order_acquire))
+	{
+		m_Header->Closed.store(1);
+
+		for (int ring = 0; ring < 2; ++ring)
+		{
+			WakeUp(ring, Event_Data);
+			WakeUp(ring, Event_Space);
+		}
+	}
+
+	CloseEvents();
+	Unmap();
+
+	m_RingSize = 0;
+	m_RingData[0] = 0;
+	m_RingData[1] = 0;
+}
+
+bool CAfxInteropSharedMemoryTransport::GetClosed(void) const
+{
+	return 0 == m_Header || 0 != m_Header->Closed.load(std::memory_order_acquire);
+}
+
+void CAfxInteropSharedMemoryTransport::SetSpinCount(unsigned int value)
+{
+	m_SpinCount = value;
+}
+
+size_t CAfxInteropSharedMemoryTransport::ReadSome(void * data, size_t size)
+{
+	if (0 == m_Header || 0 == size)
+		return 0;
+
+	Ring & ring = m_Header->Rings[m_ReadRing];
+	uint32_t readPos = ring.ReadPos.load(std::memory_order_relaxed);
+
+	if (!WaitChange(m_ReadRing, Event_Data, readPos))
+		return 0;
+
+	uint32_t count = ring.WritePos.load(std::memory_order_acquire) - readPos;
+	if (size < count) count = (uint32_t)size;
+
+	uint32_t offset = readPos & (m_RingSize - 1);
+	uint32_t first = m_RingSize - offset;
+	if (count < first) first = count;
+
+	memcpy(data, m_RingData[m_ReadRing] + offset, first);
+	memcpy((unsigned char *)data + first, m_RingData[m_ReadRing], count - first);
+
+	ring.ReadPos.store(readPos + count);
+
+	if (0 != ring.WriterSleeping.load())
+		WakeUp(m_ReadRing, Event_Space);
+
+	return count;
+}
+
+bool CAfxInteropSharedMemoryTransport::GetReadable(size_t & outSize)
+{
+	if (0 == m_Header)
+		return false;
+
+	Ring & ring = m_Header->Rings[m_ReadRing];
+
+	outSize = ring.WritePos.load(std::memory_order_acquire) - ring.ReadPos.load(std::memory_order_relaxed);
+
+	return 0 < outSize || !GetClosed();
+}
+
+bool CAfxInteropSharedMemoryTransport::WriteAll(void const * data, size_t size)
+{
+	if (GetClosed())
+		return false;
+
+	Ring & ring = m_Header->Rings[m_WriteRing];
+	uint32_t writePos = ring.WritePos.load(std::memory_order_relaxed);
+	unsigned char const * inData = (unsigned char const *)data;
+
+	while (0 < size)
+	{
+		uint32_t readPos = ring.ReadPos.load(std::memory_order_acquire);
+		uint32_t count = m_RingSize - (writePos - readPos);
+
+		if (0 == count)
+		{
+			if (!WaitChange(m_WriteRing, Event_Space, readPos))
+				return false;
+
+			continue;
+		}
+
+		if (size < count) count = (uint32_t)size;
+
+		uint32_t offset = writePos & (m_RingSize - 1);
+		uint32_t first = m_RingSize - offset;
+		if (count < first) first = count;
+
+		memcpy(m_RingData[m_WriteRing] + offset, inData, first);
+		memcpy(m_RingData[m_WriteRing], inData + first, count - first);
+
+		writePos += count;
+		ring.WritePos.store(writePos);
+
+		if (0 != ring.ReaderSleeping.load())
+			WakeUp(m_WriteRing, Event_Data);
+
+		inData += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool CAfxInteropSharedMemoryTransport::Flush(void)
+{
+	if (0 == m_Header)
+		return false;
+
+	Ring & ring = m_Header->Rings[m_WriteRing];
+	uint32_t writePos = ring.WritePos.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		uint32_t readPos = ring.ReadPos.load(std::memory_order_acquire);
+
+		if (writePos == readPos)
+			return true;
+
+		if (!WaitChange(m_WriteRing, Event_Space, readPos))
+			return false;
+	}
+}
+
+std::atomic<uint32_t> & CAfxInteropSharedMemoryTransport::GetEventValue(int ring, Event event)
+{
+	return Event_Data == event ? m_Header->Rings[ring].WritePos : m_Header->Rings[ring].ReadPos;
+}
+
+bool CAfxInteropSharedMemoryTransport::WaitChange(int ring, Event event, uint32_t expected)
+{
+	std::atomic<uint32_t> & value = GetEventValue(ring, event);
+	std::atomic<uint32_t> & sleeping = Event_Data == event ? m_Header->Rings[ring].ReaderSleeping : m_Header->Rings[ring].WriterSleeping;
+
+	for (unsigned int i = 0; ; ++i)
+	{
+		if (expected != value.load(std::memory_order_acquire))
+			return true;
+
+		if (0 != m_Header->Closed.load(std::memory_order_acquire))
+			return expected != value.load(std::memory_order_acquire);
+
+		if (i < m_SpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// The other side stores the value and then checks sleeping, we do
+		// it the other way around, so one of us notices the other
+		// (both sequentially consistent):
+		sleeping.store(1);
+
+		if (expected == value.load() && 0 == m_Header->Closed.load())
+			SleepWhile(ring, event, expected);
+
+		sleeping.store(0);
+	}
+}
+
+#ifdef _WIN32
+
+bool CAfxInteropSharedMemoryTransport::Map(bool create, size_t size)
+{
+	if (create)
+	{
+		m_Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, m_Name.c_str());
+		if (NULL == m_Mapping || ERROR_ALREADY_EXISTS == GetLastError())
+			return false;
+	}
+	else
+	{
+		m_Mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_Name.c_str());
+		if (NULL == m_Mapping)
+			return false;
+	}
+
+	void * view = MapViewOfFile(m_Mapping, FILE_MAP_ALL_ACCESS, 0, 0, create ? size : 0);
+	if (NULL == view)
+		return false;
+
+	m_Header = (Header *)view;
+
+	if (!create)
+	{
+		MEMORY_BASIC_INFORMATION info;
+		if (0 == VirtualQuery(view, &info, sizeof(info)))
+			return false;
+
+		size = info.RegionSize;
+	}
+
+	m_MappedSize = size;
+
+	return sizeof(Header) <= m_MappedSize;
+}
+
+void CAfxInteropSharedMemoryTransport::Unmap(void)
+{
+	if (m_Header)
+	{
+		UnmapViewOfFile(m_Header);
+		m_Header = 0;
+	}
+
+	if (NULL != m_Mapping)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = NULL;
+	}
+
+	m_MappedSize = 0;
+}
+
+bool CAfxInteropSharedMemoryTransport::OpenEvents(bool create)
+{
+	static char const * const suffixes[2][2] = {
+		{ "_0_data", "_0_space" },
+		{ "_1_data", "_1_space" }
+	};
+
+	for (int ring = 0; ring < 2; ++ring)
+	{
+		for (int event = 0; event < 2; ++event)
+		{
+			std::string name(m_Name);
+			name.append(suffixes[ring][event]);
+
+			m_Events[ring][event] = create
+				? CreateEventA(NULL, FALSE, FALSE, name.c_str())
+				: OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+
+			if (NULL == m_Events[ring][event])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void CAfxInteropSharedMemoryTransport::CloseEvents(void)
+{
+	for (int ring = 0; ring < 2; ++ring)
+	{
+		for (int event = 0; event < 2; ++event)
+		{
+			if (NULL != m_Events[ring][event])
+			{
+				CloseHandle(m_Events[ring][event]);
+				m_Events[ring][event] = NULL;
+			}
+		}
+	}
+}
+
+void CAfxInteropSharedMemoryTransport::SleepWhile(int ring, Event event, uint32_t expected)
+{
+	// Auto-reset event, if it was set before we got here, this returns at once:
+	WaitForSingleObject(m_Events[ring][event], AFXINTEROPSHAREDMEMORY_SLEEP_MS);
+}
+
+void CAfxInteropSharedMemoryTransport::WakeUp(int ring, Event event)
+{
+	if (NULL != m_Events[ring][event])
+		SetEvent(m_Events[ring][event]);
+}
+
+#else
+
+bool CAfxInteropSharedMemoryTransport::Map(bool create, size_t size)
+{
+	std::string shmName("/");
+	shmName.append(m_Name);
+
+	if (create)
+	{
+		m_File = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (-1 == m_File)
+			return false;
+
+		m_Unlink = true;
+
+		if (0 != ftruncate(m_File, (off_t)size))
+			return false;
+	}
+	else
+	{
+		m_File = shm_open(shmName.c_str(), O_RDWR, 0);
+		if (-1 == m_File)
+			return false;
+
+		struct stat info;
+		if (0 != fstat(m_File, &info) || (off_t)sizeof(Header) > info.st_size)
+			return false;
+
+		size = (size_t)info.st_size;
+	}
+
+	void * view = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+	if (MAP_FAILED == view)
+		return false;
+
+	m_Header = (Header *)view;
+	m_MappedSize = size;
+
+	return true;
+}
+
+void CAfxInteropSharedMemoryTransport::Unmap(void)
+{
+	if (m_Header)
+	{
+		munmap(m_Header, m_MappedSize);
+		m_Header = 0;
+	}
+
+	if (-1 != m_File)
+	{
+		close(m_File);
+		m_File = -1;
+	}
+
+	if (m_Unlink)
+	{
+		std::string shmName("/");
+		shmName.append(m_Name);
+
+		shm_unlink(shmName.c_str());
+		m_Unlink = false;
+	}
+
+	m_MappedSize = 0;
+}
+
+bool CAfxInteropSharedMemoryTransport::OpenEvents(bool /*create*/)
+{
+	// The positions in the shared memory are waited on directly.
+	return true;
+}
+
+void CAfxInteropSharedMemoryTransport::CloseEvents(void)
+{
+}
+
+void CAfxInteropSharedMemoryTransport::SleepWhile(int ring, Event event, uint32_t expected)
+{
+#ifdef __linux__
+	// Not FUTEX_PRIVATE_FLAG, since the other side is another process:
+	struct timespec timeout = { 0, AFXINTEROPSHAREDMEMORY_SLEEP_MS * 1000 * 1000 };
+	syscall(SYS_futex, (uint32_t *)&GetEventValue(ring, event), FUTEX_WAIT, expected, &timeout, NULL, 0);
+#else
+	std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+}
+
+void CAfxInteropSharedMemoryTransport::WakeUp(int ring, Event event)
+{
+#ifdef __linux__
+	syscall(SYS_futex, (uint32_t *)&GetEventValue(ring, event), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+#endif
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "AfxInteropStream.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+/// <summary>
+///   AfxInterop transport through shared memory instead of a named pipe, so
+///   the data is not copied through the kernel:<br />
+///   One single producer / single consumer ring per direction, a side that
+///   has to wait yields a few times and then sleeps on a futex (Linux) or a named
+///   event (Windows), which the other side only signals if someone sleeps.
+/// </summary>
+/// <remarks>
+///   One side Creates the memory (the interop client application, which
+///   AfxHookSource connects to), the other side Opens it. It is a single
+///   connection, to connect again the memory has to be created again.<br />
+///   A side that exits without Close is not noticed, the other side then
+///   waits forever (as with a pipe that is not closed).<br />
+///   Each direction must only be used by one thread at a time.
+/// </remarks>
+class CAfxInteropSharedMemoryTransport : public IAfxInteropTransport
+{
+public:
+	CAfxInteropSharedMemoryTransport();
+
+	/// <summary>Calls Close.</summary>
+	~CAfxInteropSharedMemoryTransport();
+
+	/// <summary>Creates the memory, fails if it exists already.</summary>
+	/// <param name="name">Name of the memory (and events), i.e. the pipe name.</param>
+	/// <param name="ringSize">Size of each ring, rounded up to a power of 2 (at least 4096).</param>
+	bool Create(char const * name, size_t ringSize = 1024 * 1024);
+
+	/// <summary>Opens the memory created by the other side.</summary>
+	/// <returns>false if it does not exist (yet) or is not compatible.</returns>
+	bool Open(char const * name);
+
+	/// <summary>Tells the other side that the connection is closed (it can still read what was written) and unmaps the memory.</summary>
+	void Close(void);
+
+	bool IsOpen(void) const
+	{
+		return 0 != m_Header;
+	}
+
+	/// <returns>If either side closed the connection.</returns>
+	bool GetClosed(void) const;
+
+	/// <summary>How often to check for data / space (yielding in between) before sleeping, default is 100.</summary>
+	void SetSpinCount(unsigned int value);
+
+	virtual size_t ReadSome(void * data, size_t size) override;
+
+	virtual bool GetReadable(size_t & outSize) override;
+
+	virtual bool WriteAll(void const * data, size_t size) override;
+
+	/// <summary>Blocks until the other side has read everything written.</summary>
+	virtual bool Flush(void) override;
+
+private:
+	struct Ring
+	{
+		/// <summary>Bytes written in total (wrapping), the reader sleeps on this.</summary>
+		alignas(64) std::atomic<uint32_t> WritePos;
+		std::atomic<uint32_t> ReaderSleeping;
+
+		/// <summary>Bytes read in total (wrapping), the writer sleeps on this.</summary>
+		alignas(64) std::atomic<uint32_t> ReadPos;
+		std::atomic<uint32_t> WriterSleeping;
+	};
+
+	struct Header
+	{
+		/// <summary>Set last by Create.</summary>
+		std::atomic<uint32_t> Magic;
+		uint32_t Version;
+		uint32_t RingSize;
+		std::atomic<uint32_t> Closed;
+
+		/// <summary>0: written by the creator, 1: written by the opener.</summary>
+		Ring Rings[2];
+	};
+
+	enum Event
+	{
+		Event_Data = 0,
+		Event_Space = 1
+	};
+
+	Header * m_Header;
+	unsigned char * m_RingData[2];
+	uint32_t m_RingSize;
+	size_t m_MappedSize;
+	int m_ReadRing;
+	int m_WriteRing;
+	unsigned int m_SpinCount;
+	std::string m_Name;
+
+#ifdef _WIN32
+	void * m_Mapping;
+
+	/// <summary>[ring][Event]</summary>
+	void * m_Events[2][2];
+#else
+	int m_File;
+
+	/// <summary>If we created the memory and have to unlink it.</summary>
+	bool m_Unlink;
+#endif
+
+	bool Map(bool create, size_t size);
+
+	void Unmap(void);
+
+	bool OpenEvents(bool create);
+
+	void CloseEvents(void);
+
+	/// <returns>Event_Data: ring's WritePos, Event_Space: ring's ReadPos.</returns>
+	std::atomic<uint32_t> & GetEventValue(int ring, Event event);
+
+	/// <summary>Sleeps while the event's value is expected (with a timeout, spurious wake ups are possible).</summary>
+	void SleepWhile(int ring, Event event, uint32_t expected);
+
+	void WakeUp(int ring, Event event);
+
+	/// <summary>Spins and sleeps until the event's value is not expected anymore.</summary>
+	/// <returns>false if the connection is closed (and the value unchanged).</returns>
+	bool WaitChange(int ring, Event event, uint32_t expected);
+};
@@ -0,0 +1,662 @@
+#include "stdafx.h"
+
+#include "AfxInteropStandIn.h"
+
+#include "AfxInteropProtocol.h"
+
+using namespace AfxInteropProtocol;
+
+// Encoding as in AfxHookSource/AfxInterop.cpp (little endian, like the machines it runs on):
+
+static bool WriteBoolean(CAfxInteropStream & stream, bool value)
+{
+	unsigned char byteValue = value ? 1 : 0;
+	return stream.Write(&byteValue, sizeof(byteValue));
+}
+
+static bool ReadBoolean(CAfxInteropStream & stream, bool & outValue)
+{
+	unsigned char byteValue;
+	if (!stream.Read(&byteValue, sizeof(byteValue))) return false;
+	outValue = 0 != byteValue;
+	return true;
+}
+
+static bool WriteInt32(CAfxInteropStream & stream, int32_t value)
+{
+	return stream.Write(&value, sizeof(value));
+}
+
+static bool ReadInt32(CAfxInteropStream & stream, int32_t & outValue)
+{
+	return stream.Read(&outValue, sizeof(outValue));
+}
+
+static bool WriteUInt32(CAfxInteropStream & stream, uint32_t value)
+{
+	return stream.Write(&value, sizeof(value));
+}
+
+static bool ReadUInt32(CAfxInteropStream & stream, uint32_t & outValue)
+{
+	return stream.Read(&outValue, sizeof(outValue));
+}
+
+static bool WriteCompressedUInt32(CAfxInteropStream & stream, uint32_t value)
+{
+	unsigned char byteValue = (unsigned char)(value < 255 ? value : 255);
+	return stream.Write(&byteValue, sizeof(byteValue)) && (value < 255 || WriteUInt32(stream, value));
+}
+
+static bool ReadCompressedUInt32(CAfxInteropStream & stream, uint32_t & outValue)
+{
+	unsigned char byteValue;
+	if (!stream.Read(&byteValue, sizeof(byteValue))) return false;
+	if (byteValue < 255)
+	{
+		outValue = byteValue;
+		return true;
+	}
+	return ReadUInt32(stream, outValue);
+}
+
+static uint32_t GetCompressedUInt32Size(uint32_t value)
+{
+	return value < 255 ? 1 : 5;
+}
+
+static bool WriteSingle(CAfxInteropStream & stream, float value)
+{
+	return stream.Write(&value, sizeof(value));
+}
+
+static bool ReadSingle(CAfxInteropStream & stream, float & outValue)
+{
+	return stream.Read(&outValue, sizeof(outValue));
+}
+
+static bool WriteStringUTF8(CAfxInteropStream & stream, std::string const & value)
+{
+	return WriteCompressedUInt32(stream, (uint32_t)value.size()) && stream.Write(value.c_str(), value.size());
+}
+
+static bool ReadStringUTF8(CAfxInteropStream & stream, std::string & outValue)
+{
+	uint32_t length;
+	if (!ReadCompressedUInt32(stream, length)) return false;
+	outValue.resize(length);
+	return 0 == length || stream.Read(&outValue[0], length);
+}
+
+/// <summary>Commands the engine sends: count, then each command's argument count and arguments.</summary>
+static bool SkipCommands(CAfxInteropStream & stream)
+{
+	uint32_t count;
+	std::string arg;
+
+	if (!ReadCompressedUInt32(stream, count)) return false;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t argCount;
+
+		if (!ReadCompressedUInt32(stream, argCount)) return false;
+
+		for (uint32_t j = 0; j < argCount; ++j)
+		{
+			if (!ReadStringUTF8(stream, arg)) return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>Kinds of calcs in the order of the protocol.</summary>
+static char const * const g_CalcKindNames[6] = { "handle", "vecAng", "cam", "fov", "bool", "int" };
+
+/// <summary>Size of a calc result (after the Boolean that tells if it succeeded).</summary>
+static const size_t g_CalcResultSizes[6] = { 4, 6 * 4, 7 * 4, 4, 1, 4 };
+
+/// <summary>Frame, 3 times, x, y, width, height, worldToView and viewToProjection matrix.</summary>
+static const size_t g_ViewSize = 4 + 3 * 4 + 4 * 4 + 2 * 16 * 4;
+
+/// <summary>x, y, width, height, worldToView and viewToProjection matrix.</summary>
+static const size_t g_TranslucentSize = 4 * 4 + 2 * 16 * 4;
+
+AfxInteropStandInSettings::AfxInteropStandInSettings()
+: Version(8)
+, Frames(1000)
+, Features(true)
+, Wait(true)
+, ReplyPadding(0)
+{
+	static const unsigned int calcs[6] = { 2, 4, 1, 1, 1, 1 };
+	for (int i = 0; i < 6; ++i) Calcs[i] = calcs[i];
+}
+
+//
+// CAfxInteropStandInEngine
+
+CAfxInteropStandInEngine::CAfxInteropStandInEngine(IAfxInteropTransport * transport, AfxInteropStandInSettings const & settings)
+: m_Settings(settings)
+, m_Stream(transport)
+, m_Version(0)
+, m_PipelineWait(false)
+, m_PipelineSentFrame(-1)
+, m_PipelineRepliedFrame(-1)
+, m_PipelineReplySize(0)
+{
+	for (int i = 0; i < 7; ++i) m_Features[i] = false;
+}
+
+bool CAfxInteropStandInEngine::Run(void)
+{
+	if (!Connect())
+		return false;
+
+	for (int frame = 0; frame < m_Settings.Frames; ++frame)
+	{
+		if (!Frame(frame))
+			return false;
+	}
+
+	// The replies to the last frames are read too, so all of them are checked:
+	if (8 <= m_Version && !ReadReplies(true))
+		return false;
+
+	return m_Stream.Send();
+}
+
+bool CAfxInteropStandInEngine::Connect(void)
+{
+	int32_t version;
+
+	if (!ReadInt32(m_Stream, version)) return false;
+
+	if (version < 7 || 8 < version)
+	{
+		WriteBoolean(m_Stream, false);
+		m_Stream.Flush();
+		return false;
+	}
+
+	m_Version = version;
+
+	if (!WriteBoolean(m_Stream, true) || !m_Stream.Flush()) return false;
+
+	bool server64Bit;
+
+	if (!ReadBoolean(m_Stream, server64Bit)) return false;
+
+	return ReadGameEventSettings(false);
+}
+
+bool CAfxInteropStandInEngine::Frame(int frame)
+{
+	if (8 <= m_Version)
+	{
+		// BeforeFrameStart:
+
+		if (!ReadReplies(false)) return false;
+
+		// AfterFrameRenderStart:
+
+		if (!WriteInt32(m_Stream, EngineMessage_Frame)
+			|| !WriteInt32(m_Stream, frame)
+			|| !WriteCompressedUInt32(m_Stream, 0)
+			|| !WriteCalcResults(frame, true)
+			|| !m_Stream.Send()) return false;
+
+		m_PipelineSentFrame = frame;
+
+		// OnRenderView:
+
+		if (!WriteInt32(m_Stream, EngineMessage_OnRenderView) || !WriteView(frame) || !m_Stream.Send()) return false;
+	}
+	else
+	{
+		// BeforeFrameStart:
+
+		uint32_t count;
+		std::string command;
+
+		if (!WriteInt32(m_Stream, EngineMessage_BeforeFrameStart) || !WriteCompressedUInt32(m_Stream, 0) || !m_Stream.Flush()) return false;
+
+		if (!ReadCompressedUInt32(m_Stream, count)) return false;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!ReadStringUTF8(m_Stream, command)) return false;
+		}
+
+		// BeforeFrameRenderStart:
+
+		if (!WriteInt32(m_Stream, EngineMessage_BeforeFrameRenderStart) || !m_Stream.Flush()) return false;
+
+		if (!ReadGameEventSettings(true)) return false;
+
+		// AfterFrameRenderStart:
+
+		if (!WriteInt32(m_Stream, EngineMessage_AfterFrameRenderStart) || !m_Stream.Flush()) return false;
+
+		if (!ReadCalcNames(m_Calcs) || !WriteCalcResults(frame, false) || !m_Stream.Send()) return false;
+
+		// OnViewOverride:
+
+		bool overrideView;
+		float value;
+
+		if (!WriteInt32(m_Stream, EngineMessage_OnViewOverride) || !m_Stream.Flush()) return false;
+
+		if (!ReadBoolean(m_Stream, overrideView)) return false;
+
+		for (int i = 0; overrideView && i < 7; ++i)
+		{
+			if (!ReadSingle(m_Stream, value)) return false;
+		}
+
+		// OnRenderView:
+
+		if (!WriteInt32(m_Stream, EngineMessage_OnRenderView) || !WriteView(frame) || !m_Stream.Flush()) return false;
+
+		for (int i = 0; i < 7; ++i)
+		{
+			if (!ReadBoolean(m_Stream, m_Features[i])) return false;
+		}
+	}
+
+	static const EngineMessage translucentMessages[4] = {
+		EngineMessage_BeforeTranslucentShadow,
+		EngineMessage_AfterTranslucentShadow,
+		EngineMessage_BeforeTranslucent,
+		EngineMessage_AfterTranslucent
+	};
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (!m_Features[i]) continue;
+
+		if (!WriteInt32(m_Stream, translucentMessages[i])) return false;
+
+		for (size_t j = 0; j < g_TranslucentSize; j += 4)
+		{
+			if (!WriteSingle(m_Stream, (float)(j / 4))) return false;
+		}
+
+		if (!m_Stream.Send()) return false;
+	}
+
+	// Messages the client doesn't answer, version 8 doesn't wait for them to be read:
+
+	if (m_Features[4] && (!WriteInt32(m_Stream, EngineMessage_OnBeforeHud) || !(8 <= m_Version ? m_Stream.Send() : m_Stream.Flush()))) return false;
+
+	if (m_Features[5] && (!WriteInt32(m_Stream, EngineMessage_OnAfterHud) || !(8 <= m_Version ? m_Stream.Send() : m_Stream.Flush()))) return false;
+
+	if (!WriteInt32(m_Stream, EngineMessage_OnRenderViewEnd) || !(8 <= m_Version ? m_Stream.Send() : m_Stream.Flush())) return false;
+
+	return true;
+}
+
+bool CAfxInteropStandInEngine::WriteView(int frame)
+{
+	if (!WriteInt32(m_Stream, frame)) return false;
+
+	if (!WriteSingle(m_Stream, frame / 128.0f) || !WriteSingle(m_Stream, frame / 128.0f) || !WriteSingle(m_Stream, 1 / 128.0f)) return false;
+
+	if (!WriteInt32(m_Stream, 0) || !WriteInt32(m_Stream, 0) || !WriteInt32(m_Stream, 1920) || !WriteInt32(m_Stream, 1080)) return false;
+
+	for (int i = 0; i < 2 * 16; ++i)
+	{
+		if (!WriteSingle(m_Stream, 0 == i % 5 ? 1.0f : 0.0f)) return false;
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInEngine::WriteCalcResults(int frame, bool withCounts)
+{
+	for (int kind = 0; kind < 6; ++kind)
+	{
+		std::vector<std::string> const & names = m_Calcs.Kinds[kind];
+
+		if (withCounts && !WriteCompressedUInt32(m_Stream, (uint32_t)names.size())) return false;
+
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			if (!WriteBoolean(m_Stream, true)) return false;
+
+			switch (kind)
+			{
+			case 0: // handle
+			case 5: // int
+				if (!WriteInt32(m_Stream, frame + (int)i)) return false;
+				break;
+			case 4: // bool
+				if (!WriteBoolean(m_Stream, 0 != (frame + i) % 2)) return false;
+				break;
+			default: // vecAng, cam, fov
+				for (size_t j = 0; j < g_CalcResultSizes[kind]; j += 4)
+				{
+					if (!WriteSingle(m_Stream, (float)(frame + i + j))) return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInEngine::ReadCalcNames(CalcNames & outCalcs)
+{
+	for (int kind = 0; kind < 6; ++kind)
+	{
+		uint32_t count;
+
+		if (!ReadCompressedUInt32(m_Stream, count)) return false;
+
+		outCalcs.Kinds[kind].resize(count);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!ReadStringUTF8(m_Stream, outCalcs.Kinds[kind][i])) return false;
+		}
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInEngine::ReadGameEventSettings(bool delta)
+{
+	bool value;
+	uint32_t count;
+	std::string name;
+
+	if (!ReadBoolean(m_Stream, value)) return false;
+
+	if (!value) return true;
+
+	if (delta)
+	{
+		// Changed:
+		if (!ReadBoolean(m_Stream, value)) return false;
+
+		if (!value) return true;
+	}
+
+	// Transmit client time, tick, system time:
+	for (int i = 0; i < 3; ++i)
+	{
+		if (!ReadBoolean(m_Stream, value)) return false;
+	}
+
+	// Whitelist (removals), additions, blacklist (removals), additions:
+	for (int list = 0; list < 4; ++list)
+	{
+		if (!delta && 0 == list % 2) continue;
+
+		if (!ReadCompressedUInt32(m_Stream, count)) return false;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!ReadStringUTF8(m_Stream, name)) return false;
+		}
+	}
+
+	// Enrichments:
+
+	if (!ReadCompressedUInt32(m_Stream, count)) return false;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t enrichmentType;
+
+		if (!ReadStringUTF8(m_Stream, name) || !ReadStringUTF8(m_Stream, name) || !ReadUInt32(m_Stream, enrichmentType)) return false;
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInEngine::ReadReplies(bool waitForAll)
+{
+	while (true)
+	{
+		bool wait = (waitForAll || m_PipelineWait) && m_PipelineRepliedFrame < m_PipelineSentFrame;
+		size_t readable;
+
+		if (!m_Stream.GetReadable(readable)) return false;
+
+		if (0 == m_PipelineReplySize)
+		{
+			if (!wait && readable < sizeof(uint32_t)) return true;
+
+			if (!ReadUInt32(m_Stream, m_PipelineReplySize)) return false;
+
+			continue;
+		}
+
+		if (!wait && readable < m_PipelineReplySize) return true;
+
+		uint32_t replySize = m_PipelineReplySize;
+		unsigned long long replyStart = m_Stream.GetReadPosition();
+
+		m_PipelineReplySize = 0;
+
+		if (!ReadReply()) return false;
+
+		unsigned long long replyRead = m_Stream.GetReadPosition() - replyStart;
+
+		// Skip what a newer client might have added, but don't read on if the stream is out of sync:
+		if (replySize < replyRead || (replyRead < replySize && !m_Stream.Skip((size_t)(replySize - replyRead)))) return false;
+	}
+}
+
+bool CAfxInteropStandInEngine::ReadReply(void)
+{
+	int32_t frame;
+	uint32_t count;
+	std::string command;
+	bool value;
+	float view;
+
+	if (!ReadInt32(m_Stream, frame) || !ReadBoolean(m_Stream, m_PipelineWait)) return false;
+
+	if (!ReadCompressedUInt32(m_Stream, count)) return false;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (!ReadStringUTF8(m_Stream, command)) return false;
+	}
+
+	if (!ReadBoolean(m_Stream, value) || (value && !ReadGameEventSettings(true))) return false;
+
+	if (!ReadBoolean(m_Stream, value) || (value && !ReadCalcNames(m_Calcs))) return false;
+
+	if (!ReadBoolean(m_Stream, value)) return false;
+
+	for (int i = 0; value && i < 7; ++i)
+	{
+		if (!ReadSingle(m_Stream, view)) return false;
+	}
+
+	for (int i = 0; i < 7; ++i)
+	{
+		if (!ReadBoolean(m_Stream, m_Features[i])) return false;
+	}
+
+	m_PipelineRepliedFrame = frame;
+
+	return true;
+}
+
+//
+// CAfxInteropStandInClient
+
+CAfxInteropStandInClient::CAfxInteropStandInClient(IAfxInteropTransport * transport, AfxInteropStandInSettings const & settings)
+: m_Settings(settings)
+, m_Stream(transport)
+, m_Frames(0)
+, m_CalcsSent(false)
+{
+}
+
+bool CAfxInteropStandInClient::Run(void)
+{
+	bool accepted;
+
+	if (!WriteInt32(m_Stream, m_Settings.Version) || !m_Stream.Send()) return false;
+
+	if (!ReadBoolean(m_Stream, accepted) || !accepted) return false;
+
+	// Server 64 bit, game events disabled:
+	if (!WriteBoolean(m_Stream, 8 == sizeof(void *)) || !WriteBoolean(m_Stream, false) || !m_Stream.Send()) return false;
+
+	while (true)
+	{
+		int32_t message;
+		int32_t frame;
+
+		// Fails if the engine disconnected:
+		if (!ReadInt32(m_Stream, message)) return true;
+
+		switch (message)
+		{
+		case EngineMessage_BeforeFrameStart:
+			if (!SkipCommands(m_Stream)) return false;
+			if (!WriteCompressedUInt32(m_Stream, 0) || !m_Stream.Send()) return false;
+			break;
+		case EngineMessage_BeforeFrameRenderStart:
+			// Game events stay disabled:
+			if (!WriteBoolean(m_Stream, false) || !m_Stream.Send()) return false;
+			break;
+		case EngineMessage_AfterFrameRenderStart:
+			if (!WriteCalcNames() || !m_Stream.Send() || !ReadCalcResults(false)) return false;
+			break;
+		case EngineMessage_OnViewOverride:
+			if (!WriteBoolean(m_Stream, true)) return false;
+			for (int i = 0; i < 7; ++i)
+			{
+				if (!WriteSingle(m_Stream, (float)(m_Frames + i))) return false;
+			}
+			if (!m_Stream.Send()) return false;
+			break;
+		case EngineMessage_OnRenderView:
+			if (!m_Stream.Skip(g_ViewSize)) return false;
+			++m_Frames;
+			if (m_Settings.Version < 8 && (!WriteFeatures() || !m_Stream.Send())) return false;
+			break;
+		case EngineMessage_BeforeTranslucentShadow:
+		case EngineMessage_AfterTranslucentShadow:
+		case EngineMessage_BeforeTranslucent:
+		case EngineMessage_AfterTranslucent:
+			if (!m_Stream.Skip(g_TranslucentSize)) return false;
+			break;
+		case EngineMessage_OnBeforeHud:
+		case EngineMessage_OnAfterHud:
+		case EngineMessage_OnRenderViewEnd:
+			break;
+		case EngineMessage_Frame:
+			if (!ReadInt32(m_Stream, frame) || !SkipCommands(m_Stream)) return false;
+			if (!ReadCalcResults(true) || !WriteReply(frame) || !m_Stream.Send()) return false;
+			break;
+		default:
+			return false;
+		}
+	}
+}
+
+bool CAfxInteropStandInClient::WriteCalcNames(void)
+{
+	for (int kind = 0; kind < 6; ++kind)
+	{
+		if (!WriteCompressedUInt32(m_Stream, m_Settings.Calcs[kind])) return false;
+
+		for (unsigned int i = 0; i < m_Settings.Calcs[kind]; ++i)
+		{
+			if (!WriteStringUTF8(m_Stream, g_CalcKindNames[kind] + std::to_string(i))) return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t CAfxInteropStandInClient::GetCalcNamesSize(void) const
+{
+	uint32_t size = 0;
+
+	for (int kind = 0; kind < 6; ++kind)
+	{
+		size += GetCompressedUInt32Size(m_Settings.Calcs[kind]);
+
+		for (unsigned int i = 0; i < m_Settings.Calcs[kind]; ++i)
+		{
+			uint32_t length = (uint32_t)(strlen(g_CalcKindNames[kind]) + std::to_string(i).size());
+			size += GetCompressedUInt32Size(length) + length;
+		}
+	}
+
+	return size;
+}
+
+bool CAfxInteropStandInClient::ReadCalcResults(bool withCounts)
+{
+	for (int kind = 0; kind < 6; ++kind)
+	{
+		uint32_t count = m_Settings.Calcs[kind];
+
+		if (withCounts && !ReadCompressedUInt32(m_Stream, count)) return false;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			bool ok;
+
+			if (!ReadBoolean(m_Stream, ok) || (ok && !m_Stream.Skip(g_CalcResultSizes[kind]))) return false;
+		}
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInClient::WriteReply(int frame)
+{
+	bool sendCalcs = !m_CalcsSent;
+
+	// Frame, wait, commands, game events, calcs, view override, features:
+	uint32_t size = 4 + 1 + 1 + 1 + 1 + (sendCalcs ? GetCalcNamesSize() : 0) + 1 + 7 * 4 + 7 + (uint32_t)m_Settings.ReplyPadding;
+
+	if (!WriteUInt32(m_Stream, size)
+		|| !WriteInt32(m_Stream, frame)
+		|| !WriteBoolean(m_Stream, m_Settings.Wait)
+		|| !WriteCompressedUInt32(m_Stream, 0)
+		|| !WriteBoolean(m_Stream, false)
+		|| !WriteBoolean(m_Stream, sendCalcs)
+		|| (sendCalcs && !WriteCalcNames())
+		|| !WriteBoolean(m_Stream, true)) return false;
+
+	for (int i = 0; i < 7; ++i)
+	{
+		if (!WriteSingle(m_Stream, (float)(frame + i))) return false;
+	}
+
+	m_CalcsSent = true;
+
+	if (!WriteFeatures()) return false;
+
+	for (int i = 0; i < m_Settings.ReplyPadding; ++i)
+	{
+		if (!WriteBoolean(m_Stream, false)) return false;
+	}
+
+	return true;
+}
+
+bool CAfxInteropStandInClient::WriteFeatures(void)
+{
+	// BeforeTranslucentShadow, AfterTranslucentShadow, BeforeTranslucent, AfterTranslucent, BeforeHud, AfterHud, AfterRenderView:
+	return WriteBoolean(m_Stream, false)
+		&& WriteBoolean(m_Stream, false)
+		&& WriteBoolean(m_Stream, m_Settings.Features)
+		&& WriteBoolean(m_Stream, m_Settings.Features)
+		&& WriteBoolean(m_Stream, m_Settings.Features)
+		&& WriteBoolean(m_Stream, m_Settings.Features)
+		&& WriteBoolean(m_Stream, true);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "AfxInteropStream.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct AfxInteropStandInSettings
+{
+	/// <summary>Engine protocol version, 7 (round trips per message) or 8 (pipelined), default is 8.</summary>
+	int Version;
+
+	/// <summary>Number of frames the engine sends, default is 1000.</summary>
+	int Frames;
+
+	/// <summary>Number of calcs the client asks for: handle, vecAng, cam, fov, bool, int, default is 2, 4, 1, 1, 1, 1.</summary>
+	unsigned int Calcs[6];
+
+	/// <summary>If the client enables the translucent and Hud features (4 more engine messages per frame), default is true.</summary>
+	bool Features;
+
+	/// <summary>Version 8: if the client asks the engine to wait for its reply to the previous frame, default is true.</summary>
+	bool Wait;
+
+	/// <summary>Version 8: number of bytes the client appends to its replies (like fields of a newer client), negative values make the size it states for them too small instead, default is 0.</summary>
+	int ReplyPadding;
+
+	AfxInteropStandInSettings();
+};
+
+/// <summary>
+///   Plays AfxHookSource's side of the AfxInterop engine connection
+///   (see AfxHookSource/AfxInterop.cpp) with synthetic frames, so the
+///   protocol can be run without the game.
+/// </summary>
+/// <remarks>
+///   Calcs always succeed, with values from the frame number. No commands
+///   and no game events are sent.
+/// </remarks>
+class CAfxInteropStandInEngine
+{
+public:
+	/// <param name="transport">Not owned.</param>
+	CAfxInteropStandInEngine(IAfxInteropTransport * transport, AfxInteropStandInSettings const & settings);
+
+	/// <summary>Connects and sends settings.Frames frames.</summary>
+	/// <returns>false on error or data the engine would not accept.</returns>
+	bool Run(void);
+
+	CAfxInteropStream & GetStream(void)
+	{
+		return m_Stream;
+	}
+
+private:
+	struct CalcNames
+	{
+		std::vector<std::string> Kinds[6];
+	};
+
+	AfxInteropStandInSettings m_Settings;
+	CAfxInteropStream m_Stream;
+	int m_Version;
+	CalcNames m_Calcs;
+	bool m_Features[7];
+
+	bool m_PipelineWait;
+	int m_PipelineSentFrame;
+	int m_PipelineRepliedFrame;
+	uint32_t m_PipelineReplySize;
+
+	bool Connect(void);
+
+	bool Frame(int frame);
+
+	bool WriteView(int frame);
+
+	bool WriteCalcResults(int frame, bool withCounts);
+
+	bool ReadCalcNames(CalcNames & outCalcs);
+
+	bool ReadGameEventSettings(bool delta);
+
+	/// <param name="waitForAll">If to wait for the replies to all frames sent, otherwise only if the client asked to.</param>
+	bool ReadReplies(bool waitForAll);
+
+	bool ReadReply(void);
+};
+
+/// <summary>
+///   Plays the interop client's side of the engine connection, answers
+///   whatever the engine sends (AfxHookSource or CAfxInteropStandInEngine).
+/// </summary>
+class CAfxInteropStandInClient
+{
+public:
+	/// <param name="transport">Not owned.</param>
+	CAfxInteropStandInClient(IAfxInteropTransport * transport, AfxInteropStandInSettings const & settings);
+
+	/// <summary>Connects and answers until the engine disconnects.</summary>
+	/// <returns>false on error or unexpected data (not for a disconnect between messages).</returns>
+	bool Run(void);
+
+	/// <returns>Number of OnRenderView messages received.</returns>
+	int GetFrames(void) const
+	{
+		return m_Frames;
+	}
+
+	CAfxInteropStream & GetStream(void)
+	{
+		return m_Stream;
+	}
+
+private:
+	AfxInteropStandInSettings m_Settings;
+	CAfxInteropStream m_Stream;
+	int m_Frames;
+	bool m_CalcsSent;
+
+	bool WriteCalcNames(void);
+
+	uint32_t GetCalcNamesSize(void) const;
+
+	bool ReadCalcResults(bool withCounts);
+
+	bool WriteReply(int frame);
+
+	bool WriteFeatures(void);
+};
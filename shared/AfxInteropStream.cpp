@@ -0,0 +1,245 @@
+#include "stdafx.h"
+
+#include "AfxInteropStream.h"
+
+#include <string.h>
+
+#include <chrono>
+
+static unsigned long long AfxInteropStream_MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+CAfxInteropStream::CAfxInteropStream(IAfxInteropTransport * transport, size_t bufferSize)
+: m_Transport(transport)
+, m_Buffered(true)
+, m_ReadBuffer(bufferSize)
+, m_ReadPos(0)
+, m_ReadEnd(0)
+, m_ReadPosition(0)
+, m_WriteBuffer(bufferSize)
+, m_WriteEnd(0)
+{
+	ResetStats();
+}
+
+void CAfxInteropStream::SetTransport(IAfxInteropTransport * transport)
+{
+	m_Transport = transport;
+
+	Reset();
+}
+
+void CAfxInteropStream::Reset(void)
+{
+	m_ReadPos = 0;
+	m_ReadEnd = 0;
+	m_ReadPosition = 0;
+	m_WriteEnd = 0;
+}
+
+void CAfxInteropStream::SetBuffered(bool value)
+{
+	m_Buffered = value;
+}
+
+bool CAfxInteropStream::GetBuffered(void) const
+{
+	return m_Buffered;
+}
+
+size_t CAfxInteropStream::TransportReadSome(void * data, size_t size)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	size_t result = m_Transport->ReadSome(data, size);
+
+	m_ReadMicroseconds += AfxInteropStream_MicrosecondsSince(start);
+	++m_Reads;
+	m_BytesRead += result;
+
+	return result;
+}
+
+bool CAfxInteropStream::TransportWriteAll(void const * data, size_t size)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool result = m_Transport->WriteAll(data, size);
+
+	m_WriteMicroseconds += AfxInteropStream_MicrosecondsSince(start);
+	++m_Writes;
+	if (result) m_BytesWritten += size;
+
+	return result;
+}
+
+bool CAfxInteropStream::Send(void)
+{
+	if (0 == m_Transport)
+		return false;
+
+	if (0 == m_WriteEnd)
+		return true;
+
+	size_t size = m_WriteEnd;
+	m_WriteEnd = 0;
+
+	return TransportWriteAll(&m_WriteBuffer[0], size);
+}
+
+bool CAfxInteropStream::Read(void * data, size_t size)
+{
+	if (0 == m_Transport)
+		return false;
+
+	unsigned char * outData = (unsigned char *)data;
+
+	while (0 < size)
+	{
+		if (m_ReadPos < m_ReadEnd)
+		{
+			size_t count = m_ReadEnd - m_ReadPos;
+			if (size < count) count = size;
+
+			memcpy(outData, &m_ReadBuffer[m_ReadPos], count);
+			m_ReadPos += count;
+			m_ReadPosition += count;
+			outData += count;
+			size -= count;
+			continue;
+		}
+
+		// The other side might wait for what we wrote, before it answers:
+		if (!Send())
+			return false;
+
+		if (!m_Buffered || m_ReadBuffer.size() <= size)
+		{
+			size_t count = TransportReadSome(outData, size);
+			if (0 == count)
+				return false;
+
+			m_ReadPosition += count;
+			outData += count;
+			size -= count;
+			continue;
+		}
+
+		m_ReadPos = 0;
+		m_ReadEnd = TransportReadSome(&m_ReadBuffer[0], m_ReadBuffer.size());
+		if (0 == m_ReadEnd)
+			return false;
+	}
+
+	return true;
+}
+
+bool CAfxInteropStream::Skip(size_t size)
+{
+	unsigned char buffer[256];
+
+	while (0 < size)
+	{
+		size_t count = size < sizeof(buffer) ? size : sizeof(buffer);
+		if (!Read(buffer, count))
+			return false;
+
+		size -= count;
+	}
+
+	return true;
+}
+
+unsigned long long CAfxInteropStream::GetReadPosition(void) const
+{
+	return m_ReadPosition;
+}
+
+bool CAfxInteropStream::GetReadable(size_t & outSize)
+{
+	if (0 == m_Transport || !m_Transport->GetReadable(outSize))
+		return false;
+
+	outSize += m_ReadEnd - m_ReadPos;
+
+	return true;
+}
+
+bool CAfxInteropStream::Write(void const * data, size_t size)
+{
+	if (0 == m_Transport)
+		return false;
+
+	if (!m_Buffered)
+		return TransportWriteAll(data, size);
+
+	if (m_WriteBuffer.size() - m_WriteEnd < size)
+	{
+		if (!Send())
+			return false;
+
+		if (m_WriteBuffer.size() <= size)
+			return TransportWriteAll(data, size);
+	}
+
+	if (0 < size)
+	{
+		memcpy(&m_WriteBuffer[m_WriteEnd], data, size);
+		m_WriteEnd += size;
+	}
+
+	return true;
+}
+
+bool CAfxInteropStream::Flush(void)
+{
+	if (0 == m_Transport)
+		return false;
+
+	if (!Send())
+		return false;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool result = m_Transport->Flush();
+
+	m_FlushMicroseconds += AfxInteropStream_MicrosecondsSince(start);
+	++m_Flushes;
+
+	return result;
+}
+
+size_t CAfxInteropStream::GetPendingWriteSize(void) const
+{
+	return m_WriteEnd;
+}
+
+AfxInteropStreamStats CAfxInteropStream::GetStats(void) const
+{
+	AfxInteropStreamStats stats;
+
+	stats.Reads = m_Reads;
+	stats.Writes = m_Writes;
+	stats.Flushes = m_Flushes;
+	stats.BytesRead = m_BytesRead;
+	stats.BytesWritten = m_BytesWritten;
+	stats.ReadMicroseconds = m_ReadMicroseconds;
+	stats.WriteMicroseconds = m_WriteMicroseconds;
+	stats.FlushMicroseconds = m_FlushMicroseconds;
+
+	return stats;
+}
+
+void CAfxInteropStream::ResetStats(void)
+{
+	m_Reads = 0;
+	m_Writes = 0;
+	m_Flushes = 0;
+	m_BytesRead = 0;
+	m_BytesWritten = 0;
+	m_ReadMicroseconds = 0;
+	m_WriteMicroseconds = 0;
+	m_FlushMicroseconds = 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+/// <summary>What a CAfxInteropStream reads from and writes to, i.e. a named pipe.</summary>
+class __declspec(novtable) IAfxInteropTransport abstract
+{
+public:
+	/// <summary>Blocks until at least one byte is available and reads up to size bytes.</summary>
+	/// <returns>Number of bytes read, 0 on error.</returns>
+	virtual size_t ReadSome(void * data, size_t size) abstract = 0;
+
+	/// <summary>Number of bytes that can be read without blocking.</summary>
+	/// <returns>false on error.</returns>
+	virtual bool GetReadable(size_t & outSize) abstract = 0;
+
+	/// <returns>false on error.</returns>
+	virtual bool WriteAll(void const * data, size_t size) abstract = 0;
+
+	/// <summary>Blocks until the other side has read everything written.</summary>
+	/// <returns>false on error.</returns>
+	virtual bool Flush(void) abstract = 0;
+};
+
+struct AfxInteropStreamStats
+{
+	/// <summary>Calls to IAfxInteropTransport::ReadSome.</summary>
+	unsigned long long Reads;
+
+	/// <summary>Calls to IAfxInteropTransport::WriteAll.</summary>
+	unsigned long long Writes;
+
+	/// <summary>Calls to IAfxInteropTransport::Flush.</summary>
+	unsigned long long Flushes;
+
+	unsigned long long BytesRead;
+	unsigned long long BytesWritten;
+
+	/// <summary>Time spent in ReadSome, WriteAll and Flush in microseconds.</summary>
+	unsigned long long ReadMicroseconds;
+	unsigned long long WriteMicroseconds;
+	unsigned long long FlushMicroseconds;
+};
+
+/// <summary>
+///   Buffers the reads and writes of an AfxInterop connection, so that the
+///   primitives (a bool, a float, ...) don't cost a transport call each:<br />
+///   Reads are read ahead (as much as is available).<br />
+///   Writes are collected until Flush or until a read has to wait for the
+///   other side (which might wait for what we wrote).
+/// </summary>
+/// <remarks>
+///   For a single thread, except for GetStats, which can be called from any.
+/// </remarks>
+class CAfxInteropStream
+{
+public:
+	/// <param name="transport">Not owned, can be 0 and be set later.</param>
+	/// <param name="bufferSize">Size of each buffer, bigger writes go to the transport directly.</param>
+	CAfxInteropStream(IAfxInteropTransport * transport = 0, size_t bufferSize = 64 * 1024);
+
+	/// <summary>Also calls Reset.</summary>
+	void SetTransport(IAfxInteropTransport * transport);
+
+	/// <summary>Discards the buffered data, i.e. after a disconnect.</summary>
+	void Reset(void);
+
+	/// <summary>Whether to buffer, default is true, false calls the transport for each read / write (for comparison).</summary>
+	void SetBuffered(bool value);
+
+	bool GetBuffered(void) const;
+
+	/// <summary>Reads exactly size bytes.</summary>
+	bool Read(void * data, size_t size);
+
+	/// <summary>Reads exactly size bytes and discards them.</summary>
+	bool Skip(size_t size);
+
+	/// <summary>Number of bytes read since Reset, i.e. to check how much of a message has been read.</summary>
+	unsigned long long GetReadPosition(void) const;
+
+	/// <summary>Number of bytes that can be read without blocking (buffered and from the transport).</summary>
+	/// <returns>false on error.</returns>
+	bool GetReadable(size_t & outSize);
+
+	bool Write(void const * data, size_t size);
+
+	/// <summary>Hands the buffered data to the transport, without waiting for the other side to read it.</summary>
+	bool Send(void);
+
+	/// <summary>Sends the buffered data and flushes the transport.</summary>
+	bool Flush(void);
+
+	/// <returns>Number of bytes written, but not handed to the transport yet.</returns>
+	size_t GetPendingWriteSize(void) const;
+
+	AfxInteropStreamStats GetStats(void) const;
+
+	void ResetStats(void);
+
+private:
+	IAfxInteropTransport * m_Transport;
+	bool m_Buffered;
+
+	std::vector<unsigned char> m_ReadBuffer;
+	size_t m_ReadPos;
+	size_t m_ReadEnd;
+	unsigned long long m_ReadPosition;
+
+	std::vector<unsigned char> m_WriteBuffer;
+	size_t m_WriteEnd;
+
+	std::atomic<unsigned long long> m_Reads;
+	std::atomic<unsigned long long> m_Writes;
+	std::atomic<unsigned long long> m_Flushes;
+	std::atomic<unsigned long long> m_BytesRead;
+	std::atomic<unsigned long long> m_BytesWritten;
+	std::atomic<unsigned long long> m_ReadMicroseconds;
+	std::atomic<unsigned long long> m_WriteMicroseconds;
+	std::atomic<unsigned long long> m_FlushMicroseconds;
+
+	size_t TransportReadSome(void * data, size_t size);
+
+	bool TransportWriteAll(void const * data, size_t size);
+};
@@ -0,0 +1,139 @@
+#include "stdafx.h"
+
+#include "AfxMappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+CAfxMappedFile::CAfxMappedFile()
+: m_File(INVALID_HANDLE_VALUE)
+, m_Mapping(NULL)
+, m_Data(0)
+, m_Size(0)
+{
+}
+
+bool CAfxMappedFile::Open(wchar_t const * fileName)
+{
+	Close();
+
+	m_File = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == m_File)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_File, &fileSize) || 0 == fileSize.QuadPart || (ULONGLONG)(size_t)-1 < (ULONGLONG)fileSize.QuadPart)
+	{
+		Close();
+		return false;
+	}
+
+	m_Mapping = CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == m_Mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = (unsigned char const *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (0 == m_Data)
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void CAfxMappedFile::Close(void)
+{
+	if (m_Data) UnmapViewOfFile(m_Data);
+	if (m_Mapping) CloseHandle(m_Mapping);
+	if (INVALID_HANDLE_VALUE != m_File) CloseHandle(m_File);
+
+	m_File = INVALID_HANDLE_VALUE;
+	m_Mapping = NULL;
+	m_Data = 0;
+	m_Size = 0;
+}
+
+#else
+
+CAfxMappedFile::CAfxMappedFile()
+: m_File(-1)
+, m_Data(0)
+, m_Size(0)
+{
+}
+
+bool CAfxMappedFile::Open(wchar_t const * fileName)
+{
+	Close();
+
+	std::string narrowFileName;
+	char buffer[MB_LEN_MAX];
+
+	for (; *fileName; ++fileName)
+	{
+		int length = wctomb(buffer, *fileName);
+		if (length < 0)
+			return false;
+
+		narrowFileName.append(buffer, length);
+	}
+
+	m_File = open(narrowFileName.c_str(), O_RDONLY);
+	if (-1 == m_File)
+		return false;
+
+	struct stat fileStat;
+	if (0 != fstat(m_File, &fileStat) || 0 == fileStat.st_size || (unsigned long long)(size_t)-1 < (unsigned long long)fileStat.st_size)
+	{
+		Close();
+		return false;
+	}
+
+	void * data = mmap(0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (MAP_FAILED == data)
+	{
+		Close();
+		return false;
+	}
+
+	madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+	m_Data = (unsigned char const *)data;
+	m_Size = (size_t)fileStat.st_size;
+
+	return true;
+}
+
+void CAfxMappedFile::Close(void)
+{
+	if (m_Data) munmap((void *)m_Data, m_Size);
+	if (-1 != m_File) close(m_File);
+
+	m_File = -1;
+	m_Data = 0;
+	m_Size = 0;
+}
+
+#endif
+
+CAfxMappedFile::~CAfxMappedFile()
+{
+	Close();
+}
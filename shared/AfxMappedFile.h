@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+
+/// <summary>Read-only memory mapping of a whole file.</summary>
+/// <remarks>
+///   On 32 bit builds files larger than the free address space can't be mapped.
+/// </remarks>
+class CAfxMappedFile
+{
+public:
+	CAfxMappedFile();
+
+	/// <summary>Calls Close.</summary>
+	~CAfxMappedFile();
+
+	/// <returns>false if the file can't be opened or mapped (empty files can't be mapped either).</returns>
+	bool Open(wchar_t const * fileName);
+
+	void Close(void);
+
+	bool IsOpen(void) const
+	{
+		return 0 != m_Data;
+	}
+
+	unsigned char const * GetData(void) const
+	{
+		return m_Data;
+	}
+
+	size_t GetSize(void) const
+	{
+		return m_Size;
+	}
+
+private:
+#ifdef _WIN32
+	void * m_File;
+	void * m_Mapping;
+#else
+	int m_File;
+#endif
+	unsigned char const * m_Data;
+	size_t m_Size;
+};
@@ -351,6 +351,136 @@ void qspline_interp(
     slew3(xi - x[klo],h[klo],y[klo],q,omega,alpha,dum1);
 }
 
+// Computes only the coefficients of slew3_init that are needed for the
+// attitude quaternion (a), into the given array instead of the globals.
+static void slew3_coefficients(
+	double dt, double dtheta, double e[], double wi[], double wf[],
+	double outA[3][3]
+)
+{
+  int i;
+  double sa, ca, c1, c2;
+  double b0, bvec1[3], bvec2[3], bvec[3];
+
+  // Same guard as slew3_init, but leave a rotation free segment instead of
+  // stale coefficients (can't happen with strictly increasing times):
+  if(dt <= 0.0)
+  {
+    for(i = 0;i < 3;i++)
+      outA[0][i] = outA[1][i] = outA[2][i] = 0.0;
+    return;
+  }
+
+  sa = sin(dtheta);
+  ca = cos(dtheta);
+
+  /* final angular rate terms. */
+
+  if(dtheta > AFX_MATH_EPS)
+  {
+    c1 = 0.5*sa*dtheta/(1.0 - ca);
+
+    c2 = 0.5*dtheta;
+
+    b0 = e[0]*wf[0] + e[1]*wf[1] + e[2]*wf[2];
+
+    crossp(e,wf,bvec2);
+
+    crossp(bvec2,e,bvec1);
+
+    for(i = 0;i < 3;i++)
+      bvec[i] = b0*e[i] + c1*bvec1[i] + c2*bvec2[i];
+  }
+  else
+  {
+    for(i = 0;i < 3;i++)
+      bvec[i] = wf[i];
+  }
+
+  /* compute coefficients. */
+
+  for(i = 0;i < 3;i++)
+  {
+    outA[2][i] = e[i]*dtheta;
+    outA[0][i] = wi[i]*dt;
+    outA[1][i] = (bvec[i]*dt - 3.0*outA[2][i]);
+  }
+}
+
+/// <summary>Precomputes the per segment coefficients, so that qspline_segments_interp doesn't need to redo the setup per evaluation.</summary>
+/// <param name="n">number of input points (n >= 4).</param>
+/// <param name="x">input vector of n time values.</param>
+/// <param name="y">input vector of quaternion values.</param>
+/// <param name="h">vector of n-1 x-interval values (from qspline_init).</param>
+/// <param name="dtheta">vector of n-1 rotation angles (from qspline_init).</param>
+/// <param name="e">array of n-1 rotation axis vectors (from qspline_init).</param>
+/// <param name="w">n intermediate angular rates (from qspline_init).</param>
+/// <param name="outSegments">out: n-1 segments.</param>
+void qspline_segments(
+	int n, double x[], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3],
+	QSplineSegment outSegments[]
+)
+{
+	for(int i = 0; i < n - 1; ++i)
+	{
+		QSplineSegment & segment = outSegments[i];
+
+		segment.X = x[i];
+		segment.H = h[i];
+
+		for(int j = 0; j < 4; ++j)
+			segment.Y[j] = y[i][j];
+
+		slew3_coefficients(h[i], dtheta[i], e[i], w[i], w[i+1], segment.A);
+	}
+}
+
+/// <summary>Interpolates a quaternion value, gives the same result as qspline_interp.</summary>
+/// <param name="n">number of input points (n>=4)</param>
+/// <param name="xi">input time</param>
+/// <param name="segments">n-1 segments from qspline_segments.</param>
+/// <param name="q">out: interpolated quaternion value.</param>
+void qspline_segments_interp(
+	int n, double xi, QSplineSegment const segments[],
+	double q[4]
+)
+{
+	int klo, khi, k;
+
+	klo = 0;
+	khi = n - 1;
+	while (khi - klo > 1)
+	{
+		k = (khi + klo) >> 1;
+		if (segments[k].X > xi) khi = k;
+		else klo = k;
+	}
+
+	QSplineSegment const & segment = segments[klo];
+	double const * qi = segment.Y;
+
+	// Same as the quaternion part of slew3:
+
+	double x = 0.0 < segment.H ? (xi - segment.X) / segment.H : 0.0;
+	double x1 = x - 1.0;
+	double x2 = x1 * x1;
+
+	double th0[3], u[3];
+
+	for(int i = 0; i < 3; ++i)
+		th0[i] = ((x*segment.A[2][i] + x1*segment.A[1][i])*x + x2*segment.A[0][i])*x;
+
+	double ang = unvec(th0,u);
+	double ca = cos(0.5*ang);
+	double sa = sin(0.5*ang);
+
+	q[0] = ca*qi[0] + sa*( u[2]*qi[1] - u[1]*qi[2] + u[0]*qi[3]);
+	q[1] = ca*qi[1] + sa*(-u[2]*qi[0] + u[0]*qi[2] + u[1]*qi[3]);
+	q[2] = ca*qi[2] + sa*( u[1]*qi[0] - u[0]*qi[1] + u[2]*qi[3]);
+	q[3] = ca*qi[3] + sa*(-u[0]*qi[0] - u[1]*qi[1] - u[2]*qi[2]);
+}
+
 // Note: This function has been slighlty modified from it's original (definition only).
 double getang(double qi[], double qf[], double e[])
 /*
@@ -37,6 +37,7 @@ u x v = (u_1 X + u_2 Y + u_3 Z) x (v_1 X + v_2 Y + v_3 Z)
 
 #include "AfxRefCounted.h"
 #include <map>
+#include <vector>
 
 namespace Afx {
 namespace Math {
@@ -79,6 +80,33 @@ void qspline_interp(
 	double q[4], double omega[3], double alpha[3]
 );
 
+/// <summary>Precomputed coefficients of one qspline segment.</summary>
+struct QSplineSegment
+{
+	/// <summary>Start time.</summary>
+	double X;
+
+	/// <summary>Duration.</summary>
+	double H;
+
+	/// <summary>Start quaternion.</summary>
+	double Y[4];
+
+	/// <summary>Coefficients of the third-order rotation vector polynomial.</summary>
+	double A[3][3];
+};
+
+void qspline_segments(
+	int n, double x[], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3],
+	QSplineSegment outSegments[]
+);
+
+void qspline_segments_interp(
+	int n, double xi, QSplineSegment const segments[],
+	double q[4]
+);
+
 double getang(double qi[], double qf[], double e[]);
 
 // Vector3 /////////////////////////////////////////////////////////////////////
@@ -218,7 +246,7 @@ public:
 	{
 	}
 
-	CInterpolationMapViewIterator(typename CInterpolationMap<TMap>::const_iterator & mapIterator, T (* selector)(TMap const & value))
+	CInterpolationMapViewIterator(typename CInterpolationMap<TMap>::const_iterator const & mapIterator, T (* selector)(TMap const & value))
 	: m_MapIterator(mapIterator)
 	, m_Selector(selector)
 	{
@@ -636,8 +664,6 @@ class CSCubicQuaternionInterpolation
 : public CInterpolation<Quaternion>
 {
 public:
-	// TODO: make thread safe.
-	/// <remarks>Currently NOT threadsafe (TODO), because of use of temporary static global variables (slew3_*).</remarks>
 	CSCubicQuaternionInterpolation(CInterpolationMapView<TMap, Quaternion> * view)
 	: CInterpolation<Quaternion>()
 	, m_View(view)
@@ -645,11 +671,6 @@ public:
 		InterpolationMapChanged();
 	}
 
-	virtual ~CSCubicQuaternionInterpolation()
-	{
-		Free();
-	}
-
 	virtual void InterpolationMapChanged(void)
 	{
 		m_Rebuild = true;
@@ -662,6 +683,7 @@ public:
 
 	/// <remarks>
 	/// Must not be called if CanEval() returns false!<br />
+	/// Currently NOT threadsafe, because the segments are rebuilt on the first call after InterpolationMapChanged.
 	/// </remarks>
 	virtual Quaternion Eval(double t)
 	{
@@ -673,14 +695,17 @@ public:
 		{
 			m_Rebuild = false;
 
-			Free();
+			// Temporary qspline_init output, only the segments are kept:
+			std::vector<double> T(n);
+			std::vector<double> Q_y(4 * n);
+			std::vector<double> Q_h(n-1);
+			std::vector<double> Q_dtheta(n-1);
+			std::vector<double> Q_e(3 * (n-1));
+			std::vector<double> Q_w(3 * n);
 
-			m_Build.T = new double[n];
-			m_Build.Q_y = new double[n][4];
-			m_Build.Q_h = new double[n-1];
-			m_Build.Q_dtheta = new double[n-1];
-			m_Build.Q_e = new double[n-1][3];
-			m_Build.Q_w = new double[n][3];
+			double (*y)[4] = reinterpret_cast<double (*)[4]>(&Q_y[0]);
+			double (*e)[3] = reinterpret_cast<double (*)[3]>(&Q_e[0]);
+			double (*w)[3] = reinterpret_cast<double (*)[3]>(&Q_w[0]);
 
 			{
 				Quaternion QLast;
@@ -689,7 +714,7 @@ public:
 				CInterpolationMapViewIterator<TMap, Quaternion> itEnd = m_View->GetEnd();
 				for(CInterpolationMapViewIterator<TMap, Quaternion> it = m_View->GetBegin(); it != itEnd; ++it)
 				{
-					m_Build.T[i] = it.GetTime();
+					T[i] = it.GetTime();
 
 					Quaternion Q = it.GetValue();
 				
@@ -704,10 +729,10 @@ public:
 						}
 					}
 
-					m_Build.Q_y[i][0] = Q.X;
-					m_Build.Q_y[i][1] = Q.Y;
-					m_Build.Q_y[i][2] = Q.Z;
-					m_Build.Q_y[i][3] = Q.W;
+					y[i][0] = Q.X;
+					y[i][1] = Q.Y;
+					y[i][2] = Q.Z;
+					y[i][3] = Q.W;
 
 					QLast = Q;
 					i++;
@@ -716,12 +741,15 @@ public:
 
 			double wi[3] = {0.0,0.0,0.0};
 			double wf[3] = {0.0,0.0,0.0};
-			qspline_init(n, 2, AFX_MATH_EPS, wi, wf, m_Build.T, m_Build.Q_y, m_Build.Q_h, m_Build.Q_dtheta, m_Build.Q_e, m_Build.Q_w);
+			qspline_init(n, 2, AFX_MATH_EPS, wi, wf, &T[0], y, &Q_h[0], &Q_dtheta[0], e, w);
+
+			m_Segments.resize(n-1);
+			qspline_segments(n, &T[0], y, &Q_h[0], &Q_dtheta[0], e, w, &m_Segments[0]);
 		}
 
-		double Q[4],dum1[4],dum2[4];
+		double Q[4];
 
-		qspline_interp(n, t, m_Build.T, m_Build.Q_y, m_Build.Q_h, m_Build.Q_dtheta, m_Build.Q_e, m_Build.Q_w, Q, dum1, dum2);
+		qspline_segments_interp(n, t, &m_Segments[0], Q);
 
 		return Quaternion(Q[3], Q[0], Q[1], Q[2]);
 	}
@@ -729,43 +757,10 @@ public:
 private:
 	CInterpolationMapView<TMap, Quaternion> * m_View;
 
-	struct Build_s
-	{
-		double * T;
-		double (*Q_y)[4];
-		double * Q_h;
-		double * Q_dtheta;
-		double (*Q_e)[3];
-		double (*Q_w)[3];
-
-		Build_s()
-		: T(0)
-		, Q_y(0)
-		, Q_h(0)
-		, Q_dtheta(0)
-		, Q_e(0)
-		, Q_w(0)
-		{
-		}
-	} m_Build;
+	/// <summary>Per segment coefficients, computed on rebuild.</summary>
+	std::vector<QSplineSegment> m_Segments;
 
 	bool m_Rebuild;
-
-	void Free()
-	{
-		delete [] m_Build.Q_w;
-		m_Build.Q_w = 0;
-		delete [] m_Build.Q_e;
-		m_Build.Q_e = 0;
-		delete m_Build.Q_dtheta;
-		m_Build.Q_dtheta = 0;
-		delete m_Build.Q_h;
-		m_Build.Q_h = 0;
-		delete [] m_Build.Q_y;
-		m_Build.Q_y = 0;
-		delete m_Build.T;
-		m_Build.T = 0;
-	}
 };
 
 } // namespace Afx {
@@ -0,0 +1,129 @@
+#include "stdafx.h"
+
+#include "AfxMessageQueue.h"
+
+CAfxMessageQueue::CAfxMessageQueue(size_t capacity)
+: m_Ring(capacity)
+, m_MaxLatestPerSecond(0)
+, m_MaxLatestBacklog(0)
+, m_LatestTimeValid(false)
+, m_NextLatestTime(0)
+, m_MessageStart(0)
+, m_Failed(false)
+{
+	m_MaxBytes = m_Ring.GetCapacity();
+
+	ResetStats();
+}
+
+CAfxByteRing & CAfxMessageQueue::GetRing(void)
+{
+	return m_Ring;
+}
+
+void CAfxMessageQueue::Reset(void)
+{
+	m_Ring.Reset();
+	m_LatestTimeValid = false;
+}
+
+void CAfxMessageQueue::SetMaxBytes(size_t maxBytes)
+{
+	m_MaxBytes = maxBytes < m_Ring.GetCapacity() ? maxBytes : m_Ring.GetCapacity();
+}
+
+size_t CAfxMessageQueue::GetMaxBytes(void) const
+{
+	return m_MaxBytes;
+}
+
+void CAfxMessageQueue::SetMaxLatestPerSecond(double value)
+{
+	m_MaxLatestPerSecond = 0 < value ? value : 0;
+	m_LatestTimeValid = false;
+}
+
+double CAfxMessageQueue::GetMaxLatestPerSecond(void) const
+{
+	return m_MaxLatestPerSecond;
+}
+
+void CAfxMessageQueue::SetMaxLatestBacklog(size_t maxBacklog)
+{
+	m_MaxLatestBacklog = maxBacklog;
+}
+
+size_t CAfxMessageQueue::GetMaxLatestBacklog(void) const
+{
+	return m_MaxLatestBacklog;
+}
+
+AfxMessageQueueStats const & CAfxMessageQueue::GetStats(void) const
+{
+	return m_Stats;
+}
+
+void CAfxMessageQueue::ResetStats(void)
+{
+	m_Stats.Messages = 0;
+	m_Stats.Bytes = 0;
+	m_Stats.Dropped = 0;
+	m_Stats.Coalesced = 0;
+	m_Stats.MaxBacklog = 0;
+}
+
+void CAfxMessageQueue::Begin(void)
+{
+	m_MessageStart = m_Ring.GetWritePosition();
+	m_Failed = false;
+}
+
+bool CAfxMessageQueue::BeginLatest(double time)
+{
+	if ((0 < m_MaxLatestPerSecond && m_LatestTimeValid && time < m_NextLatestTime)
+		|| (0 < m_MaxLatestBacklog && m_MaxLatestBacklog < m_Ring.GetUsed()))
+	{
+		++m_Stats.Coalesced;
+		return false;
+	}
+
+	if (0 < m_MaxLatestPerSecond)
+	{
+		double interval = 1.0 / m_MaxLatestPerSecond;
+
+		// Keep the average rate, unless we are more than an interval behind (i.e. after a pause):
+		m_NextLatestTime = m_LatestTimeValid && time < m_NextLatestTime + interval ? m_NextLatestTime + interval : time + interval;
+		m_LatestTimeValid = true;
+	}
+
+	Begin();
+
+	return true;
+}
+
+void CAfxMessageQueue::Write(void const * data, size_t size)
+{
+	if (m_Failed)
+		return;
+
+	if (m_MaxBytes < m_Ring.GetUsed() + size || !m_Ring.Write(data, size))
+		m_Failed = true;
+}
+
+bool CAfxMessageQueue::End(void)
+{
+	if (m_Failed)
+	{
+		m_Ring.Truncate(m_MessageStart);
+		++m_Stats.Dropped;
+		return false;
+	}
+
+	size_t used = m_Ring.GetUsed();
+
+	++m_Stats.Messages;
+	m_Stats.Bytes += m_Ring.GetWritePosition() - m_MessageStart;
+	if (m_Stats.MaxBacklog < used) m_Stats.MaxBacklog = used;
+
+	return true;
+}
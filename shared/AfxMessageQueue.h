@@ -0,0 +1,92 @@
+#pragma once
+
+#include "AfxByteRing.h"
+
+struct AfxMessageQueueStats
+{
+	unsigned long long Messages;
+	unsigned long long Bytes;
+
+	/// <summary>Messages dropped, because the queue was full.</summary>
+	unsigned long long Dropped;
+
+	/// <summary>"Latest value" messages skipped, because of the rate limit or the backlog.</summary>
+	unsigned long long Coalesced;
+
+	/// <summary>Highest number of bytes that were queued, but not consumed yet.</summary>
+	size_t MaxBacklog;
+};
+
+/// <summary>
+///   Bounded queue of messages, serialized into a CAfxByteRing, with a
+///   send policy:<br />
+///   Messages begun with Begin are lossless, they are only dropped if the
+///   queue is full.<br />
+///   Messages begun with BeginLatest only carry the latest value of
+///   something (i.e. a camera), they are skipped if they come faster than
+///   the rate limit or if the consumer is behind, so that the next one
+///   carries the latest value instead of adding to the backlog.
+/// </summary>
+/// <remarks>
+///   Everything except GetRing is for the producer thread only, the
+///   consumer uses GetRing.
+/// </remarks>
+class CAfxMessageQueue
+{
+public:
+	/// <param name="capacity">Capacity of the ring, see CAfxByteRing.</param>
+	CAfxMessageQueue(size_t capacity);
+
+	CAfxByteRing & GetRing(void);
+
+	/// <summary>Discards all messages (and unpublished bytes), see CAfxByteRing::Reset.</summary>
+	void Reset(void);
+
+	/// <summary>The queue is full if a message would make more than maxBytes queued (but not consumed yet).</summary>
+	/// <remarks>Is limited to the ring's capacity.</remarks>
+	void SetMaxBytes(size_t maxBytes);
+
+	size_t GetMaxBytes(void) const;
+
+	/// <param name="value">0 for no limit.</param>
+	void SetMaxLatestPerSecond(double value);
+
+	double GetMaxLatestPerSecond(void) const;
+
+	/// <summary>"Latest value" messages are skipped while more than maxBacklog bytes are queued, 0 to never skip them for that.</summary>
+	void SetMaxLatestBacklog(size_t maxBacklog);
+
+	size_t GetMaxLatestBacklog(void) const;
+
+	AfxMessageQueueStats const & GetStats(void) const;
+
+	void ResetStats(void);
+
+	/// <summary>Begins a lossless message.</summary>
+	void Begin(void);
+
+	/// <summary>Begins a "latest value" message.</summary>
+	/// <param name="time">Time in seconds (monotonic), for the rate limit.</param>
+	/// <returns>false if the message is to be skipped (coalesced), Write and End must not be called then.</returns>
+	bool BeginLatest(double time);
+
+	void Write(void const * data, size_t size);
+
+	/// <returns>false if the message has been dropped (queue full).</returns>
+	bool End(void);
+
+private:
+	CAfxByteRing m_Ring;
+
+	size_t m_MaxBytes;
+	double m_MaxLatestPerSecond;
+	size_t m_MaxLatestBacklog;
+
+	AfxMessageQueueStats m_Stats;
+
+	bool m_LatestTimeValid;
+	double m_NextLatestTime;
+
+	size_t m_MessageStart;
+	bool m_Failed;
+};
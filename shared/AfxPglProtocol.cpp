@@ -0,0 +1,448 @@
+#include "stdafx.h"
+
+#include "AfxPglProtocol.h"
+
+#include <string.h>
+
+static char const * const g_AfxPglMessageNames[] = {
+	"hello",
+	"dataStart",
+	"dataStop",
+	"levelInit",
+	"levelShutdown",
+	"cam",
+	"gameEvent"
+};
+
+#define AFXPGL_MESSAGE_COUNT (sizeof(g_AfxPglMessageNames) / sizeof(g_AfxPglMessageNames[0]))
+
+// Version 4 string references:
+#define AFXPGL_STRING_NEW 0
+#define AFXPGL_STRING_LITERAL 1
+#define AFXPGL_STRING_INDEX 2
+
+////////////////////////////////////////////////////////////////////////////////
+
+CAfxPglWriter::CAfxPglWriter(CAfxMessageQueue & queue)
+: m_Queue(queue)
+, m_Version(2)
+, m_StringsAtBegin(0)
+{
+	Reset();
+}
+
+void CAfxPglWriter::SetVersion(uint32_t version)
+{
+	m_Version = version;
+
+	Reset();
+}
+
+uint32_t CAfxPglWriter::GetVersion(void) const
+{
+	return m_Version;
+}
+
+void CAfxPglWriter::Reset(void)
+{
+	m_StringIndices.clear();
+	m_Strings.clear();
+	m_StringsAtBegin = 0;
+
+	memset(m_Cam, 0, sizeof(m_Cam));
+}
+
+void CAfxPglWriter::Begin(void)
+{
+	m_StringsAtBegin = m_Strings.size();
+	memcpy(m_CamAtBegin, m_Cam, sizeof(m_Cam));
+
+	m_Queue.Begin();
+}
+
+bool CAfxPglWriter::BeginLatest(double time)
+{
+	if (!m_Queue.BeginLatest(time))
+		return false;
+
+	m_StringsAtBegin = m_Strings.size();
+	memcpy(m_CamAtBegin, m_Cam, sizeof(m_Cam));
+
+	return true;
+}
+
+bool CAfxPglWriter::End(void)
+{
+	if (!m_Queue.End())
+	{
+		RollBack();
+		return false;
+	}
+
+	return true;
+}
+
+void CAfxPglWriter::RollBack(void)
+{
+	while (m_StringsAtBegin < m_Strings.size())
+	{
+		m_StringIndices.erase(m_Strings.back());
+		m_Strings.pop_back();
+	}
+
+	memcpy(m_Cam, m_CamAtBegin, sizeof(m_Cam));
+}
+
+void CAfxPglWriter::WriteVarint(uint64_t value)
+{
+	unsigned char data[10];
+	size_t size = 0;
+
+	while (0x80 <= value)
+	{
+		data[size++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	data[size++] = (unsigned char)value;
+
+	m_Queue.Write(data, size);
+}
+
+void CAfxPglWriter::WriteMessage(AfxPglMessage message)
+{
+	if (4 <= m_Version)
+		WriteVarint((uint64_t)message);
+	else
+		m_Queue.Write(g_AfxPglMessageNames[message], strlen(g_AfxPglMessageNames[message]) + 1);
+}
+
+bool CAfxPglWriter::WriteHelloAndEnd(uint32_t version)
+{
+	WriteMessage(AfxPglMessage_Hello);
+	m_Queue.Write(&version, sizeof(version));
+
+	if (!End())
+		return false;
+
+	SetVersion(version);
+
+	return true;
+}
+
+void CAfxPglWriter::WriteCString(char const * value)
+{
+	size_t size = strlen(value) + 1;
+
+	if (m_Version < 4)
+	{
+		m_Queue.Write(value, size);
+		return;
+	}
+
+	if (AFXPGL_MAX_INTERNED_STRING_LENGTH < size - 1)
+	{
+		WriteVarint(AFXPGL_STRING_LITERAL);
+		m_Queue.Write(value, size);
+		return;
+	}
+
+	std::string key(value, size - 1);
+	auto it = m_StringIndices.find(key);
+
+	if (it != m_StringIndices.end())
+	{
+		WriteVarint(AFXPGL_STRING_INDEX + (uint64_t)it->second);
+	}
+	else if (m_Strings.size() < AFXPGL_MAX_INTERNED_STRINGS)
+	{
+		WriteVarint(AFXPGL_STRING_NEW);
+		m_Queue.Write(value, size);
+
+		m_StringIndices.emplace(key, (uint32_t)m_Strings.size());
+		m_Strings.emplace_back(std::move(key));
+	}
+	else
+	{
+		WriteVarint(AFXPGL_STRING_LITERAL);
+		m_Queue.Write(value, size);
+	}
+}
+
+void CAfxPglWriter::WriteFloat(float value)
+{
+	m_Queue.Write(&value, sizeof(value));
+}
+
+void CAfxPglWriter::WriteInt32(int32_t value)
+{
+	if (4 <= m_Version)
+		WriteVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+	else
+		m_Queue.Write(&value, sizeof(value));
+}
+
+void CAfxPglWriter::WriteInt16(int16_t value)
+{
+	if (4 <= m_Version)
+		WriteVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 15));
+	else
+		m_Queue.Write(&value, sizeof(value));
+}
+
+void CAfxPglWriter::WriteByte(uint8_t value)
+{
+	m_Queue.Write(&value, sizeof(value));
+}
+
+void CAfxPglWriter::WriteBoolean(bool value)
+{
+	WriteByte(value ? 1 : 0);
+}
+
+void CAfxPglWriter::WriteUInt64(uint64_t value)
+{
+	if (4 <= m_Version)
+		WriteVarint(value);
+	else
+		m_Queue.Write(&value, sizeof(value));
+}
+
+void CAfxPglWriter::WriteCam(float const values[8])
+{
+	if (m_Version < 4)
+	{
+		m_Queue.Write(values, 8 * sizeof(float));
+		return;
+	}
+
+	// Unchanged values become 1 byte, slowly changing ones keep the high bits (sign, exponent) and get shorter too:
+	for (int i = 0; i < 8; ++i)
+	{
+		uint32_t bits;
+		memcpy(&bits, &values[i], sizeof(bits));
+
+		WriteVarint(bits ^ m_Cam[i]);
+		m_Cam[i] = bits;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CAfxPglReader::CAfxPglReader()
+: m_Version(2)
+, m_Data(0)
+, m_Size(0)
+, m_Pos(0)
+, m_Failed(false)
+{
+	Reset();
+}
+
+void CAfxPglReader::SetVersion(uint32_t version)
+{
+	m_Version = version;
+
+	Reset();
+}
+
+uint32_t CAfxPglReader::GetVersion(void) const
+{
+	return m_Version;
+}
+
+void CAfxPglReader::Reset(void)
+{
+	m_Strings.clear();
+	memset(m_Cam, 0, sizeof(m_Cam));
+}
+
+void CAfxPglReader::SetData(unsigned char const * data, size_t size)
+{
+	m_Data = data;
+	m_Size = size;
+	m_Pos = 0;
+}
+
+bool CAfxPglReader::Eof(void) const
+{
+	return m_Failed || m_Size <= m_Pos;
+}
+
+bool CAfxPglReader::Failed(void) const
+{
+	return m_Failed;
+}
+
+bool CAfxPglReader::Read(void * outData, size_t size)
+{
+	if (m_Failed || m_Size - m_Pos < size)
+	{
+		m_Failed = true;
+		memset(outData, 0, size);
+		return false;
+	}
+
+	memcpy(outData, m_Data + m_Pos, size);
+	m_Pos += size;
+
+	return true;
+}
+
+uint64_t CAfxPglReader::ReadVarint(void)
+{
+	uint64_t value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		uint8_t byte;
+		if (!Read(&byte, 1))
+			return 0;
+
+		value |= (uint64_t)(byte & 0x7f) << shift;
+
+		if (0 == (byte & 0x80))
+			return value;
+	}
+
+	m_Failed = true;
+	return 0;
+}
+
+AfxPglMessage CAfxPglReader::ReadMessage(void)
+{
+	if (4 <= m_Version)
+	{
+		uint64_t opcode = ReadVarint();
+
+		return !m_Failed && opcode < AFXPGL_MESSAGE_COUNT ? (AfxPglMessage)opcode : AfxPglMessage_Unknown;
+	}
+
+	std::string name;
+	if (ReadCString(name))
+	{
+		for (size_t i = 0; i < AFXPGL_MESSAGE_COUNT; ++i)
+		{
+			if (0 == strcmp(g_AfxPglMessageNames[i], name.c_str()))
+				return (AfxPglMessage)i;
+		}
+	}
+
+	return AfxPglMessage_Unknown;
+}
+
+uint32_t CAfxPglReader::ReadUInt32(void)
+{
+	uint32_t value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+bool CAfxPglReader::ReadCString(std::string & outValue)
+{
+	uint64_t reference = AFXPGL_STRING_LITERAL;
+
+	if (4 <= m_Version)
+	{
+		reference = ReadVarint();
+
+		if (AFXPGL_STRING_INDEX <= reference)
+		{
+			if (m_Failed || m_Strings.size() <= reference - AFXPGL_STRING_INDEX)
+			{
+				m_Failed = true;
+				return false;
+			}
+
+			outValue = m_Strings[(size_t)(reference - AFXPGL_STRING_INDEX)];
+			return true;
+		}
+	}
+
+	if (m_Failed)
+		return false;
+
+	unsigned char const * end = (unsigned char const *)memchr(m_Data + m_Pos, 0, m_Size - m_Pos);
+	if (0 == end)
+	{
+		m_Failed = true;
+		return false;
+	}
+
+	outValue.assign((char const *)m_Data + m_Pos, (char const *)end);
+	m_Pos = end - m_Data + 1;
+
+	if (AFXPGL_STRING_NEW == reference)
+		m_Strings.push_back(outValue);
+
+	return true;
+}
+
+float CAfxPglReader::ReadFloat(void)
+{
+	float value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+int32_t CAfxPglReader::ReadInt32(void)
+{
+	if (4 <= m_Version)
+	{
+		uint32_t value = (uint32_t)ReadVarint();
+		return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+	}
+
+	int32_t value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+int16_t CAfxPglReader::ReadInt16(void)
+{
+	if (4 <= m_Version)
+	{
+		uint32_t value = (uint32_t)ReadVarint();
+		return (int16_t)((int32_t)(value >> 1) ^ -(int32_t)(value & 1));
+	}
+
+	int16_t value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+uint8_t CAfxPglReader::ReadByte(void)
+{
+	uint8_t value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+bool CAfxPglReader::ReadBoolean(void)
+{
+	return 0 != ReadByte();
+}
+
+uint64_t CAfxPglReader::ReadUInt64(void)
+{
+	if (4 <= m_Version)
+		return ReadVarint();
+
+	uint64_t value;
+	Read(&value, sizeof(value));
+	return value;
+}
+
+void CAfxPglReader::ReadCam(float outValues[8])
+{
+	if (m_Version < 4)
+	{
+		Read(outValues, 8 * sizeof(float));
+		return;
+	}
+
+	for (int i = 0; i < 8; ++i)
+	{
+		m_Cam[i] ^= (uint32_t)ReadVarint();
+		memcpy(&outValues[i], &m_Cam[i], sizeof(float));
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "AfxMessageQueue.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+/// <summary>Messages sent to the MirvPgl server, in version 4 the value is the opcode.</summary>
+enum AfxPglMessage
+{
+	AfxPglMessage_Unknown = -1,
+	AfxPglMessage_Hello = 0,
+	AfxPglMessage_DataStart = 1,
+	AfxPglMessage_DataStop = 2,
+	AfxPglMessage_LevelInit = 3,
+	AfxPglMessage_LevelShutdown = 4,
+	AfxPglMessage_Cam = 5,
+	AfxPglMessage_GameEvent = 6
+};
+
+/// <summary>Maximum number of interned strings (per connection, until reset).</summary>
+#define AFXPGL_MAX_INTERNED_STRINGS 4096
+
+/// <summary>Longer strings are not interned.</summary>
+#define AFXPGL_MAX_INTERNED_STRING_LENGTH 255
+
+/// <summary>
+///   Writes MirvPgl messages into a CAfxMessageQueue, in protocol version 2
+///   or 4 (see MirvPgl.h for the format).
+/// </summary>
+/// <remarks>
+///   If a message is dropped (End returns false), the state it changed
+///   (interned strings, previous cam) is rolled back, so the server's state
+///   stays in sync.
+/// </remarks>
+class CAfxPglWriter
+{
+public:
+	CAfxPglWriter(CAfxMessageQueue & queue);
+
+	/// <summary>Switches the format of the following messages, also calls Reset.</summary>
+	void SetVersion(uint32_t version);
+
+	uint32_t GetVersion(void) const;
+
+	/// <summary>Forgets the interned strings and the previous cam (both sides do that on "hello" and "dataStop").</summary>
+	void Reset(void);
+
+	/// <summary>See CAfxMessageQueue::Begin.</summary>
+	void Begin(void);
+
+	/// <summary>See CAfxMessageQueue::BeginLatest.</summary>
+	bool BeginLatest(double time);
+
+	/// <summary>See CAfxMessageQueue::End.</summary>
+	bool End(void);
+
+	/// <summary>Writes the message's name (version 2) or opcode (version 4).</summary>
+	void WriteMessage(AfxPglMessage message);
+
+	/// <summary>Writes a "hello" message and switches to version afterwards.</summary>
+	/// <remarks>Must be inside Begin / End, End is called by this.</remarks>
+	/// <returns>See End.</returns>
+	bool WriteHelloAndEnd(uint32_t version);
+
+	/// <remarks>Interned in version 4.</remarks>
+	void WriteCString(char const * value);
+
+	void WriteFloat(float value);
+
+	/// <remarks>Zig-zag varint in version 4.</remarks>
+	void WriteInt32(int32_t value);
+
+	/// <remarks>Zig-zag varint in version 4.</remarks>
+	void WriteInt16(int16_t value);
+
+	void WriteByte(uint8_t value);
+
+	void WriteBoolean(bool value);
+
+	/// <remarks>Varint in version 4.</remarks>
+	void WriteUInt64(uint64_t value);
+
+	/// <summary>The 8 floats of a "cam" message.</summary>
+	/// <remarks>In version 4 as varints of the bits xor-ed with the previous cam's.</remarks>
+	void WriteCam(float const values[8]);
+
+private:
+	CAfxMessageQueue & m_Queue;
+	uint32_t m_Version;
+
+	std::unordered_map<std::string, uint32_t> m_StringIndices;
+	std::deque<std::string> m_Strings;
+	size_t m_StringsAtBegin;
+
+	uint32_t m_Cam[8];
+	uint32_t m_CamAtBegin[8];
+
+	void WriteVarint(uint64_t value);
+
+	void RollBack(void);
+};
+
+/// <summary>Reads what CAfxPglWriter wrote (i.e. for testing and tools).</summary>
+/// <remarks>After an error (i.e. out of data) all reads fail.</remarks>
+class CAfxPglReader
+{
+public:
+	CAfxPglReader();
+
+	void SetVersion(uint32_t version);
+
+	uint32_t GetVersion(void) const;
+
+	void Reset(void);
+
+	/// <summary>Sets the (binary frame's) data to read from, the state is kept.</summary>
+	void SetData(unsigned char const * data, size_t size);
+
+	bool Eof(void) const;
+
+	bool Failed(void) const;
+
+	/// <summary>Reads the message's name / opcode.</summary>
+	/// <remarks>
+	///   For "hello" read the version with ReadUInt32 and call
+	///   SetVersion with it, for "dataStop" call Reset.
+	/// </remarks>
+	AfxPglMessage ReadMessage(void);
+
+	uint32_t ReadUInt32(void);
+
+	bool ReadCString(std::string & outValue);
+
+	float ReadFloat(void);
+
+	int32_t ReadInt32(void);
+
+	int16_t ReadInt16(void);
+
+	uint8_t ReadByte(void);
+
+	bool ReadBoolean(void);
+
+	uint64_t ReadUInt64(void);
+
+	void ReadCam(float outValues[8]);
+
+private:
+	uint32_t m_Version;
+	unsigned char const * m_Data;
+	size_t m_Size;
+	size_t m_Pos;
+	bool m_Failed;
+
+	std::deque<std::string> m_Strings;
+
+	uint32_t m_Cam[8];
+
+	bool Read(void * outData, size_t size);
+
+	uint64_t ReadVarint(void);
+};
@@ -0,0 +1,753 @@
+#include "stdafx.h"
+
+#include "AfxWebSocket.h"
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment( lib, "ws2_32" )
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <zlib.h>
+
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+
+#define AFXWEBSOCKET_INVALID_SOCKET ((uintptr_t)INVALID_SOCKET)
+#define AFXWEBSOCKET_SEND_FLAGS 0
+
+static void AfxWebSocket_CloseSocket(uintptr_t socket)
+{
+	closesocket((SOCKET)socket);
+}
+
+static bool AfxWebSocket_SetNonBlocking(uintptr_t socket)
+{
+	u_long mode = 1;
+	return 0 == ioctlsocket((SOCKET)socket, FIONBIO, &mode);
+}
+
+static bool AfxWebSocket_WouldBlock(void)
+{
+	return WSAEWOULDBLOCK == WSAGetLastError();
+}
+
+#else
+
+#define AFXWEBSOCKET_INVALID_SOCKET (-1)
+#define AFXWEBSOCKET_SEND_FLAGS MSG_NOSIGNAL
+
+static void AfxWebSocket_CloseSocket(int socket)
+{
+	close(socket);
+}
+
+static bool AfxWebSocket_SetNonBlocking(int socket)
+{
+	int flags = fcntl(socket, F_GETFL, 0);
+	return -1 != flags && -1 != fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+}
+
+static bool AfxWebSocket_WouldBlock(void)
+{
+	return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+}
+
+#endif
+
+/// <summary>The empty block deflate's Z_SYNC_FLUSH ends with, which permessage-deflate leaves out.</summary>
+static const unsigned char g_AfxWebSocket_DeflateTail[4] = { 0x00, 0x00, 0xff, 0xff };
+
+/// <summary>Receive this much at once at least.</summary>
+#define AFXWEBSOCKET_RECEIVE_SIZE (64 * 1024)
+
+/// <summary>Default for SetMaxPendingSendSize.</summary>
+#define AFXWEBSOCKET_MAX_PENDING_SEND_SIZE (64 * 1024)
+
+enum AfxWebSocketOpcode
+{
+	AfxWebSocketOpcode_Continuation = 0x0,
+	AfxWebSocketOpcode_Text = 0x1,
+	AfxWebSocketOpcode_Binary = 0x2,
+	AfxWebSocketOpcode_Close = 0x8,
+	AfxWebSocketOpcode_Ping = 0x9,
+	AfxWebSocketOpcode_Pong = 0xa
+};
+
+CAfxWebSocket::CAfxWebSocket()
+: m_State(State_Closed)
+, m_Socket(AFXWEBSOCKET_INVALID_SOCKET)
+, m_WakeSocket(AFXWEBSOCKET_INVALID_SOCKET)
+, m_RxOffset(0)
+, m_TxOffset(0)
+, m_MaxPendingSendSize(AFXWEBSOCKET_MAX_PENDING_SEND_SIZE)
+, m_MessageOpcode(0)
+, m_MessageCompressed(false)
+, m_OfferDeflate(false)
+, m_Deflater(0)
+, m_Inflater(0)
+, m_DeflateNoContextTakeover(false)
+, m_InflateNoContextTakeover(false)
+{
+	m_MaskState = (uint32_t)std::chrono::high_resolution_clock::now().time_since_epoch().count() | 1;
+}
+
+CAfxWebSocket::~CAfxWebSocket()
+{
+	Disconnect();
+}
+
+void CAfxWebSocket::SetDeflate(bool value)
+{
+	m_OfferDeflate = value;
+}
+
+bool CAfxWebSocket::GetDeflate(void) const
+{
+	return m_OfferDeflate;
+}
+
+bool CAfxWebSocket::GetDeflateActive(void) const
+{
+	return 0 != m_Deflater;
+}
+
+bool CAfxWebSocket::Open(char const * url)
+{
+	Disconnect();
+
+	if (0 != strncmp(url, "ws://", 5))
+		return false;
+
+	std::string hostPort(url + 5);
+	std::string path("/");
+
+	size_t slash = hostPort.find('/');
+	if (std::string::npos != slash)
+	{
+		path = hostPort.substr(slash);
+		hostPort.resize(slash);
+	}
+
+	std::string host(hostPort);
+	std::string port("80");
+
+	size_t colon = hostPort.rfind(':');
+	if (std::string::npos != colon)
+	{
+		host = hostPort.substr(0, colon);
+		port = hostPort.substr(colon + 1);
+	}
+
+	if (!Connect(host, port) || !Handshake(hostPort, path) || !CreateWakeSocket() || !AfxWebSocket_SetNonBlocking(m_Socket))
+	{
+		Disconnect();
+		return false;
+	}
+
+	m_State = State_Open;
+
+	return true;
+}
+
+bool CAfxWebSocket::Connect(std::string const & host, std::string const & port)
+{
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo * result;
+	if (0 != getaddrinfo(host.c_str(), port.c_str(), &hints, &result))
+		return false;
+
+	for (addrinfo * ai = result; ai; ai = ai->ai_next)
+	{
+		Socket_t socket = (Socket_t)::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (AFXWEBSOCKET_INVALID_SOCKET == socket)
+			continue;
+
+		if (0 == connect(socket, ai->ai_addr, (int)ai->ai_addrlen))
+		{
+			m_Socket = socket;
+			break;
+		}
+
+		AfxWebSocket_CloseSocket(socket);
+	}
+
+	freeaddrinfo(result);
+
+	if (AFXWEBSOCKET_INVALID_SOCKET == m_Socket)
+		return false;
+
+	// Messages are small and latency matters:
+	int noDelay = 1;
+	setsockopt(m_Socket, IPPROTO_TCP, TCP_NODELAY, (char const *)&noDelay, sizeof(noDelay));
+
+	return true;
+}
+
+bool CAfxWebSocket::Handshake(std::string const & host, std::string const & path)
+{
+	static char const base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	// Random 16 bytes, base64 encoded (that's 21 random characters, one with the low 2 bits 0 and "=="):
+	std::string key;
+	for (int i = 0; i < 22; ++i)
+	{
+		m_MaskState ^= m_MaskState << 13; m_MaskState ^= m_MaskState >> 17; m_MaskState ^= m_MaskState << 5;
+		key += base64[i < 21 ? m_MaskState % 64 : (m_MaskState % 16) * 4];
+	}
+	key += "==";
+
+	std::string request =
+		"GET " + path + " HTTP/1.1\r\n"
+		"Host: " + host + "\r\n"
+		"Upgrade: websocket\r\n"
+		"Connection: Upgrade\r\n"
+		"Sec-WebSocket-Key: " + key + "\r\n"
+		"Sec-WebSocket-Version: 13\r\n"
+		+ std::string(m_OfferDeflate ? "Sec-WebSocket-Extensions: permessage-deflate\r\n" : "")
+		+ "\r\n";
+
+	for (size_t sent = 0; sent < request.size(); )
+	{
+		int result = send(m_Socket, request.c_str() + sent, (int)(request.size() - sent), AFXWEBSOCKET_SEND_FLAGS);
+		if (result <= 0)
+			return false;
+		sent += result;
+	}
+
+	// Read the response header, anything after it already belongs to the first frames:
+	char buffer[1024];
+	std::string response;
+	size_t headerEnd;
+	while (std::string::npos == (headerEnd = response.find("\r\n\r\n")))
+	{
+		if (16 * 1024 < response.size())
+			return false;
+
+		int result = recv(m_Socket, buffer, sizeof(buffer), 0);
+		if (result <= 0)
+			return false;
+
+		response.append(buffer, result);
+	}
+
+	if (0 != response.compare(0, 13, "HTTP/1.1 101 "))
+		return false;
+
+	m_RxBuffer.assign(response.begin() + headerEnd + 4, response.end());
+	m_RxOffset = 0;
+
+	response.resize(headerEnd + 2);
+
+	return ParseExtensions(response);
+}
+
+bool CAfxWebSocket::ParseExtensions(std::string const & response)
+{
+	std::string header(response);
+	std::transform(header.begin(), header.end(), header.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+	size_t start = header.find("\r\nsec-websocket-extensions:");
+	if (std::string::npos == start)
+		return true;
+
+	std::string extensions = header.substr(start + 2, header.find("\r\n", start + 2) - start - 2);
+
+	if (!m_OfferDeflate || std::string::npos == extensions.find("permessage-deflate"))
+		return false; // Nothing else was offered.
+
+	m_DeflateNoContextTakeover = std::string::npos != extensions.find("client_no_context_takeover");
+	m_InflateNoContextTakeover = std::string::npos != extensions.find("server_no_context_takeover");
+
+	m_Deflater = new z_stream;
+	memset(m_Deflater, 0, sizeof(z_stream));
+	if (Z_OK != deflateInit2(m_Deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY))
+	{
+		delete m_Deflater;
+		m_Deflater = 0;
+		return false;
+	}
+
+	m_Inflater = new z_stream;
+	memset(m_Inflater, 0, sizeof(z_stream));
+	if (Z_OK != inflateInit2(m_Inflater, -15))
+	{
+		delete m_Inflater;
+		m_Inflater = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void CAfxWebSocket::Deflate(unsigned char const * const * data, size_t const * size, size_t count)
+{
+	m_Deflated.resize(64);
+	m_Deflater->avail_out = (uInt)m_Deflated.size();
+	m_Deflater->next_out = m_Deflated.data();
+
+	for (size_t i = 0; i <= count; ++i)
+	{
+		bool flush = i == count;
+
+		m_Deflater->next_in = flush ? Z_NULL : (Bytef *)data[i];
+		m_Deflater->avail_in = flush ? 0 : (uInt)size[i];
+
+		do
+		{
+			if (0 == m_Deflater->avail_out)
+			{
+				size_t used = m_Deflated.size();
+				m_Deflated.resize(2 * used);
+				m_Deflater->next_out = m_Deflated.data() + used;
+				m_Deflater->avail_out = (uInt)(m_Deflated.size() - used);
+			}
+
+			deflate(m_Deflater, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+		}
+		while (0 < m_Deflater->avail_in || 0 == m_Deflater->avail_out);
+	}
+
+	m_Deflated.resize(m_Deflated.size() - m_Deflater->avail_out - sizeof(g_AfxWebSocket_DeflateTail));
+
+	if (m_DeflateNoContextTakeover)
+		deflateReset(m_Deflater);
+}
+
+bool CAfxWebSocket::Inflate(unsigned char const * data, size_t size)
+{
+	m_Inflated.resize(size * 4 + 64);
+	m_Inflater->next_out = m_Inflated.data();
+	m_Inflater->avail_out = (uInt)m_Inflated.size();
+
+	for (int i = 0; i < 2; ++i)
+	{
+		m_Inflater->next_in = i ? (Bytef *)g_AfxWebSocket_DeflateTail : (Bytef *)data;
+		m_Inflater->avail_in = i ? (uInt)sizeof(g_AfxWebSocket_DeflateTail) : (uInt)size;
+
+		while (0 < m_Inflater->avail_in)
+		{
+			if (0 == m_Inflater->avail_out)
+			{
+				size_t used = m_Inflated.size();
+				m_Inflated.resize(2 * used);
+				m_Inflater->next_out = m_Inflated.data() + used;
+				m_Inflater->avail_out = (uInt)(m_Inflated.size() - used);
+			}
+
+			int result = inflate(m_Inflater, Z_SYNC_FLUSH);
+			if (Z_STREAM_END == result)
+			{
+				// The server ended the stream (final block), the next message starts a new one:
+				inflateReset(m_Inflater);
+				break;
+			}
+			if (Z_OK != result && !(Z_BUF_ERROR == result && 0 == m_Inflater->avail_out))
+				return false;
+		}
+	}
+
+	m_Inflated.resize(m_Inflated.size() - m_Inflater->avail_out);
+
+	if (m_InflateNoContextTakeover)
+		inflateReset(m_Inflater);
+
+	return true;
+}
+
+bool CAfxWebSocket::CreateWakeSocket(void)
+{
+	m_WakeSocket = (Socket_t)socket(AF_INET, SOCK_DGRAM, 0);
+	if (AFXWEBSOCKET_INVALID_SOCKET == m_WakeSocket)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+
+	socklen_t addressSize = sizeof(address);
+
+	return 0 == bind(m_WakeSocket, (sockaddr const *)&address, sizeof(address))
+		&& 0 == getsockname(m_WakeSocket, (sockaddr *)&address, &addressSize)
+		&& 0 == connect(m_WakeSocket, (sockaddr const *)&address, sizeof(address))
+		&& AfxWebSocket_SetNonBlocking(m_WakeSocket);
+}
+
+CAfxWebSocket::State CAfxWebSocket::GetState(void) const
+{
+	return m_State;
+}
+
+bool CAfxWebSocket::SendBinary(unsigned char const * const * data, size_t const * size, size_t count)
+{
+	if (State_Open != m_State || m_MaxPendingSendSize <= GetPendingSendSize())
+		return false;
+
+	if (m_Deflater)
+	{
+		Deflate(data, size, count);
+
+		unsigned char const * deflatedData = m_Deflated.data();
+		size_t deflatedSize = m_Deflated.size();
+
+		// RSV1 marks the message as compressed:
+		SendFrame(0x40 | AfxWebSocketOpcode_Binary, &deflatedData, &deflatedSize, 1);
+	}
+	else
+		SendFrame(AfxWebSocketOpcode_Binary, data, size, count);
+
+	return true;
+}
+
+bool CAfxWebSocket::SendBinary(void const * data, size_t size)
+{
+	unsigned char const * bytes = (unsigned char const *)data;
+
+	return SendBinary(&bytes, &size, 1);
+}
+
+size_t CAfxWebSocket::GetPendingSendSize(void) const
+{
+	return m_TxBuffer.size() - m_TxOffset;
+}
+
+void CAfxWebSocket::SetMaxPendingSendSize(size_t value)
+{
+	m_MaxPendingSendSize = value;
+}
+
+size_t CAfxWebSocket::GetMaxPendingSendSize(void) const
+{
+	return m_MaxPendingSendSize;
+}
+
+void CAfxWebSocket::Close(void)
+{
+	if (State_Open != m_State)
+		return;
+
+	SendFrame(AfxWebSocketOpcode_Close, 0, 0, 0);
+	m_State = State_Closing;
+}
+
+void CAfxWebSocket::Disconnect(void)
+{
+	if (AFXWEBSOCKET_INVALID_SOCKET != m_Socket)
+	{
+		AfxWebSocket_CloseSocket(m_Socket);
+		m_Socket = AFXWEBSOCKET_INVALID_SOCKET;
+	}
+
+	if (AFXWEBSOCKET_INVALID_SOCKET != m_WakeSocket)
+	{
+		AfxWebSocket_CloseSocket(m_WakeSocket);
+		m_WakeSocket = AFXWEBSOCKET_INVALID_SOCKET;
+	}
+
+	if (m_Deflater)
+	{
+		deflateEnd(m_Deflater);
+		delete m_Deflater;
+		m_Deflater = 0;
+	}
+
+	if (m_Inflater)
+	{
+		inflateEnd(m_Inflater);
+		delete m_Inflater;
+		m_Inflater = 0;
+	}
+
+	m_State = State_Closed;
+	m_RxBuffer.clear();
+	m_RxOffset = 0;
+	m_TxBuffer.clear();
+	m_TxOffset = 0;
+	m_Message.clear();
+}
+
+void CAfxWebSocket::Wait(int timeoutMs)
+{
+	if (State_Closed == m_State)
+		return;
+
+	fd_set readFds;
+	fd_set writeFds;
+	FD_ZERO(&readFds);
+	FD_ZERO(&writeFds);
+	FD_SET(m_Socket, &readFds);
+	FD_SET(m_WakeSocket, &readFds);
+	if (0 < GetPendingSendSize())
+		FD_SET(m_Socket, &writeFds);
+
+	timeval timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+	int maxFd = (int)(m_Socket < m_WakeSocket ? m_WakeSocket : m_Socket);
+
+	if (0 < select(maxFd + 1, &readFds, &writeFds, 0, 0 <= timeoutMs ? &timeout : 0) && FD_ISSET(m_WakeSocket, &readFds))
+	{
+		char buffer[64];
+		while (0 < recv(m_WakeSocket, buffer, sizeof(buffer), 0))
+			;
+	}
+}
+
+void CAfxWebSocket::Wake(void)
+{
+	char wake = 0;
+	send(m_WakeSocket, &wake, 1, AFXWEBSOCKET_SEND_FLAGS);
+}
+
+void CAfxWebSocket::Poll(IAfxWebSocketReceiver * receiver)
+{
+	if (State_Closed == m_State)
+		return;
+
+	if (!Receive())
+	{
+		Disconnect();
+		return;
+	}
+
+	while (State_Closed != m_State && ParseFrame(receiver))
+		;
+
+	if (State_Closed == m_State)
+		return;
+
+	if (m_RxOffset == m_RxBuffer.size())
+	{
+		m_RxBuffer.clear();
+		m_RxOffset = 0;
+	}
+
+	Flush();
+}
+
+bool CAfxWebSocket::Receive(void)
+{
+	while (true)
+	{
+		if (m_RxOffset && m_RxBuffer.capacity() < m_RxBuffer.size() + AFXWEBSOCKET_RECEIVE_SIZE)
+		{
+			m_RxBuffer.erase(m_RxBuffer.begin(), m_RxBuffer.begin() + m_RxOffset);
+			m_RxOffset = 0;
+		}
+
+		size_t oldSize = m_RxBuffer.size();
+		m_RxBuffer.resize(oldSize + AFXWEBSOCKET_RECEIVE_SIZE);
+
+		int result = recv(m_Socket, (char *)&m_RxBuffer[oldSize], AFXWEBSOCKET_RECEIVE_SIZE, 0);
+
+		m_RxBuffer.resize(oldSize + (0 < result ? result : 0));
+
+		if (0 == result)
+			return false; // Closed by server.
+
+		if (result < 0)
+			return AfxWebSocket_WouldBlock();
+
+		if (result < AFXWEBSOCKET_RECEIVE_SIZE)
+			return true;
+	}
+}
+
+bool CAfxWebSocket::ParseFrame(IAfxWebSocketReceiver * receiver)
+{
+	unsigned char const * data = m_RxBuffer.data() + m_RxOffset;
+	size_t available = m_RxBuffer.size() - m_RxOffset;
+
+	if (available < 2)
+		return false;
+
+	bool fin = 0 != (data[0] & 0x80);
+	bool compressed = 0 != (data[0] & 0x40);
+	unsigned char opcode = data[0] & 0x0f;
+	bool masked = 0 != (data[1] & 0x80);
+	uint64_t payloadSize = data[1] & 0x7f;
+	size_t headerSize = 2;
+
+	if (126 == payloadSize)
+	{
+		headerSize += 2;
+		if (available < headerSize) return false;
+		payloadSize = ((uint64_t)data[2] << 8) | data[3];
+	}
+	else if (127 == payloadSize)
+	{
+		headerSize += 8;
+		if (available < headerSize) return false;
+		payloadSize = 0;
+		for (int i = 0; i < 8; ++i) payloadSize = (payloadSize << 8) | data[2 + i];
+	}
+
+	unsigned char const * mask = data + headerSize;
+	if (masked) headerSize += 4;
+
+	if (available < headerSize || available - headerSize < payloadSize)
+		return false;
+
+	unsigned char * payload = m_RxBuffer.data() + m_RxOffset + headerSize;
+	size_t size = (size_t)payloadSize;
+
+	if (masked)
+	{
+		for (size_t i = 0; i < size; ++i) payload[i] ^= mask[i & 3];
+	}
+
+	m_RxOffset += headerSize + size;
+
+	switch (opcode)
+	{
+	case AfxWebSocketOpcode_Continuation:
+	case AfxWebSocketOpcode_Text:
+	case AfxWebSocketOpcode_Binary:
+		if (AfxWebSocketOpcode_Continuation != opcode)
+		{
+			m_MessageOpcode = opcode;
+			m_MessageCompressed = compressed;
+			m_Message.clear();
+		}
+
+		if (fin && m_Message.empty())
+		{
+			// Not fragmented (the usual case), no need to copy:
+			OnMessage(receiver, payload, size);
+		}
+		else
+		{
+			m_Message.insert(m_Message.end(), payload, payload + size);
+
+			if (fin)
+			{
+				OnMessage(receiver, m_Message.data(), m_Message.size());
+				m_Message.clear();
+			}
+		}
+		break;
+	case AfxWebSocketOpcode_Close:
+		if (State_Open == m_State)
+		{
+			SendFrame(AfxWebSocketOpcode_Close, 0, 0, 0);
+			m_State = State_Closing;
+		}
+		else
+			Disconnect(); // Answer to our close.
+		break;
+	case AfxWebSocketOpcode_Ping:
+		{
+			unsigned char const * pongData = payload;
+			SendFrame(AfxWebSocketOpcode_Pong, &pongData, &size, 1);
+		}
+		break;
+	}
+
+	return true;
+}
+
+void CAfxWebSocket::OnMessage(IAfxWebSocketReceiver * receiver, unsigned char const * data, size_t size)
+{
+	if (m_MessageCompressed)
+	{
+		if (!m_Inflater || !Inflate(data, size))
+		{
+			Disconnect();
+			return;
+		}
+
+		data = m_Inflated.data();
+		size = m_Inflated.size();
+	}
+
+	if (AfxWebSocketOpcode_Binary == m_MessageOpcode && receiver)
+		receiver->OnBinaryMessage(data, size);
+}
+
+void CAfxWebSocket::SendFrame(unsigned char opcode, unsigned char const * const * data, size_t const * size, size_t count)
+{
+	uint64_t payloadSize = 0;
+	for (size_t i = 0; i < count; ++i) payloadSize += size[i];
+
+	if (m_TxOffset == m_TxBuffer.size())
+	{
+		m_TxBuffer.clear();
+		m_TxOffset = 0;
+	}
+
+	m_TxBuffer.push_back(0x80 | opcode);
+
+	if (payloadSize < 126)
+		m_TxBuffer.push_back(0x80 | (unsigned char)payloadSize);
+	else if (payloadSize < 65536)
+	{
+		m_TxBuffer.push_back(0x80 | 126);
+		for (int i = 1; 0 <= i; --i) m_TxBuffer.push_back((unsigned char)(payloadSize >> (8 * i)));
+	}
+	else
+	{
+		m_TxBuffer.push_back(0x80 | 127);
+		for (int i = 7; 0 <= i; --i) m_TxBuffer.push_back((unsigned char)(payloadSize >> (8 * i)));
+	}
+
+	m_MaskState ^= m_MaskState << 13; m_MaskState ^= m_MaskState >> 17; m_MaskState ^= m_MaskState << 5;
+
+	unsigned char mask[4] = { (unsigned char)m_MaskState, (unsigned char)(m_MaskState >> 8), (unsigned char)(m_MaskState >> 16), (unsigned char)(m_MaskState >> 24) };
+	m_TxBuffer.insert(m_TxBuffer.end(), mask, mask + 4);
+
+	size_t offset = m_TxBuffer.size();
+	m_TxBuffer.resize(offset + (size_t)payloadSize);
+
+	unsigned char * out = m_TxBuffer.data() + offset;
+	size_t maskIndex = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (size_t j = 0; j < size[i]; ++j)
+		{
+			out[maskIndex] = data[i][j] ^ mask[maskIndex & 3];
+			++maskIndex;
+		}
+	}
+}
+
+void CAfxWebSocket::Flush(void)
+{
+	while (m_TxOffset < m_TxBuffer.size())
+	{
+		int result = send(m_Socket, (char const *)&m_TxBuffer[m_TxOffset], (int)(m_TxBuffer.size() - m_TxOffset), AFXWEBSOCKET_SEND_FLAGS);
+
+		if (result < 0)
+		{
+			if (!AfxWebSocket_WouldBlock())
+				Disconnect();
+			return;
+		}
+
+		m_TxOffset += result;
+	}
+
+	if (State_Closing == m_State)
+		Disconnect(); // Our close (or the answer to the server's) has been sent.
+}
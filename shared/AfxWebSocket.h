@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct z_stream_s;
+
+class __declspec(novtable) IAfxWebSocketReceiver abstract
+{
+public:
+	/// <param name="data">Only valid during the call.</param>
+	virtual void OnBinaryMessage(unsigned char const * data, size_t size) abstract = 0;
+};
+
+/// <summary>
+///   Minimal WebSocket (RFC 6455) client for ws:// URLs, that is driven
+///   by a single network thread, which blocks in Wait until the socket is
+///   ready or another thread calls Wake (i.e. because there is new data to
+///   send), so it doesn't need to poll.
+/// </summary>
+/// <remarks>
+///   Text messages are ignored, pings are answered.<br />
+///   Supports the permessage-deflate extension (RFC 7692), if enabled with
+///   SetDeflate and accepted by the server.<br />
+///   The server's Sec-WebSocket-Accept is not verified.<br />
+///   On Windows WinSock must have been initialized (WSAStartup).<br />
+///   Except Wake all functions must be called from the same thread.
+/// </remarks>
+class CAfxWebSocket
+{
+public:
+	enum State
+	{
+		State_Closed,
+		State_Open,
+		State_Closing
+	};
+
+	CAfxWebSocket();
+
+	/// <summary>Calls Disconnect.</summary>
+	~CAfxWebSocket();
+
+	/// <summary>Whether to offer permessage-deflate on the next Open, default is false.</summary>
+	void SetDeflate(bool value);
+
+	bool GetDeflate(void) const;
+
+	/// <returns>If the messages are compressed (the server accepted permessage-deflate).</returns>
+	bool GetDeflateActive(void) const;
+
+	/// <summary>Connects and does the opening handshake (blocking).</summary>
+	/// <param name="url">ws://host[:port][/path]</param>
+	/// <returns>false on error.</returns>
+	bool Open(char const * url);
+
+	State GetState(void) const;
+
+	/// <summary>Queues a binary message that consists of count slices (i.e. of a CAfxByteRing), they are copied masked into the send buffer.</summary>
+	/// <returns>
+	///   false if the message was not queued, because the connection is not
+	///   open or GetMaxPendingSendSize or more bytes are still pending (try
+	///   again once the socket has become writable, so the backlog stays
+	///   with the caller).
+	/// </returns>
+	bool SendBinary(unsigned char const * const * data, size_t const * size, size_t count);
+
+	bool SendBinary(void const * data, size_t size);
+
+	/// <returns>Bytes queued, but not sent yet.</returns>
+	size_t GetPendingSendSize(void) const;
+
+	/// <summary>SendBinary refuses messages while this much is pending, default is 64 KiB.</summary>
+	/// <remarks>Control frames (pong, close) are always queued.</remarks>
+	void SetMaxPendingSendSize(size_t value);
+
+	size_t GetMaxPendingSendSize(void) const;
+
+	/// <summary>Starts the closing handshake, the connection is closed once the queued data and the close frame have been sent.</summary>
+	void Close(void);
+
+	/// <summary>Closes the connection right away.</summary>
+	void Disconnect(void);
+
+	/// <summary>
+	///   Blocks until data has been received, queued data can be sent,
+	///   Wake has been called (since the last Wait) or timeoutMs passed.
+	/// </summary>
+	/// <param name="timeoutMs">-1 to wait without timeout.</param>
+	void Wait(int timeoutMs = -1);
+
+	/// <summary>Makes the current or the next Wait return, can be called from any thread while open.</summary>
+	void Wake(void);
+
+	/// <summary>Receives and sends what is possible without blocking.</summary>
+	/// <param name="receiver">Is called for each complete binary message, can be 0.</param>
+	void Poll(IAfxWebSocketReceiver * receiver);
+
+private:
+#ifdef _WIN32
+	typedef uintptr_t Socket_t;
+#else
+	typedef int Socket_t;
+#endif
+
+	State m_State;
+	Socket_t m_Socket;
+
+	/// <summary>UDP socket connected to itself, Wake sends a byte to it.</summary>
+	Socket_t m_WakeSocket;
+
+	std::vector<unsigned char> m_RxBuffer;
+	size_t m_RxOffset;
+	std::vector<unsigned char> m_TxBuffer;
+	size_t m_TxOffset;
+	size_t m_MaxPendingSendSize;
+
+	/// <summary>Payload of a fragmented message so far.</summary>
+	std::vector<unsigned char> m_Message;
+	unsigned char m_MessageOpcode;
+
+	/// <summary>If the current fragmented message is compressed.</summary>
+	bool m_MessageCompressed;
+
+	uint32_t m_MaskState;
+
+	bool m_OfferDeflate;
+	z_stream_s * m_Deflater;
+	z_stream_s * m_Inflater;
+	bool m_DeflateNoContextTakeover;
+	bool m_InflateNoContextTakeover;
+	std::vector<unsigned char> m_Deflated;
+	std::vector<unsigned char> m_Inflated;
+
+	bool Connect(std::string const & host, std::string const & port);
+
+	bool Handshake(std::string const & host, std::string const & path);
+
+	bool CreateWakeSocket(void);
+
+	/// <summary>Creates m_Deflater and m_Inflater if the server accepted the extension.</summary>
+	bool ParseExtensions(std::string const & response);
+
+	/// <summary>Compresses the slices into m_Deflated.</summary>
+	void Deflate(unsigned char const * const * data, size_t const * size, size_t count);
+
+	/// <summary>Decompresses into m_Inflated.</summary>
+	bool Inflate(unsigned char const * data, size_t size);
+
+	void OnMessage(IAfxWebSocketReceiver * receiver, unsigned char const * data, size_t size);
+
+	void SendFrame(unsigned char opcode, unsigned char const * const * data, size_t const * size, size_t count);
+
+	/// <returns>false if the connection has been closed.</returns>
+	bool Receive(void);
+
+	/// <returns>false if there is no complete frame.</returns>
+	bool ParseFrame(IAfxWebSocketReceiver * receiver);
+
+	void Flush(void);
+};
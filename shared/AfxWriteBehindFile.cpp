@@ -0,0 +1,221 @@
+#include "stdafx.h"
+
+#include "AfxWriteBehindFile.h"
+
+#include <zlib.h>
+
+/// <summary>If more bytes than this are pending, Write blocks until the I/O thread caught up.</summary>
+#define AFXWRITEBEHINDFILE_MAX_PENDING (64 * 1024 * 1024)
+
+/// <summary>Number of emptied buffers kept for re-use.</summary>
+#define AFXWRITEBEHINDFILE_MAX_FREE_BUFFERS 4
+
+/// <summary>zlib compression level for compressed blocks, favours speed, since the I/O thread has to keep up.</summary>
+#define AFXWRITEBEHINDFILE_COMPRESSION_LEVEL 3
+
+CAfxWriteBehindFile::CAfxWriteBehindFile()
+: m_File(NULL)
+, m_Size(0)
+, m_PendingSize(0)
+, m_FileSize(0)
+, m_Quit(false)
+, m_Error(false)
+{
+}
+
+CAfxWriteBehindFile::~CAfxWriteBehindFile()
+{
+	Close();
+}
+
+bool CAfxWriteBehindFile::Open(wchar_t const * fileName)
+{
+	Close();
+
+	_wfopen_s(&m_File, fileName, L"wb");
+
+	if (!m_File)
+		return false;
+
+	m_Size = 0;
+	m_FileSize = 0;
+	m_CompressedBlockOffsets.clear();
+	m_Quit = false;
+	m_Error = false;
+	m_Thread = std::thread(WriterThread, this);
+
+	return true;
+}
+
+bool CAfxWriteBehindFile::IsOpen(void) const
+{
+	return NULL != m_File;
+}
+
+bool CAfxWriteBehindFile::Close(void)
+{
+	if (!m_File)
+		return true;
+
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+		m_Quit = true;
+	}
+	m_PendingCondition.notify_one();
+
+	m_Thread.join();
+
+	if (0 != fclose(m_File))
+		m_Error = true;
+
+	m_File = NULL;
+
+	return !m_Error;
+}
+
+void CAfxWriteBehindFile::Write(std::vector<unsigned char> & inOutBuffer, bool compress)
+{
+	if (!m_File || inOutBuffer.empty())
+	{
+		inOutBuffer.clear();
+		return;
+	}
+
+	m_Size += inOutBuffer.size();
+
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+
+		while (AFXWRITEBEHINDFILE_MAX_PENDING < m_PendingSize)
+			m_WrittenCondition.wait(lock);
+
+		m_PendingSize += inOutBuffer.size();
+
+		if (!compress && !m_Pending.empty() && !m_Pending.back().Compress)
+		{
+			// Small uncompressed writes are merged, so the I/O thread doesn't see them one by one:
+			m_Pending.back().Data.insert(m_Pending.back().Data.end(), inOutBuffer.begin(), inOutBuffer.end());
+			inOutBuffer.clear();
+		}
+		else
+		{
+			m_Pending.push_back(Block());
+			m_Pending.back().Compress = compress;
+			m_Pending.back().Data.swap(inOutBuffer);
+
+			if (!m_FreeBuffers.empty())
+			{
+				inOutBuffer.swap(m_FreeBuffers.back());
+				m_FreeBuffers.pop_back();
+			}
+		}
+	}
+	m_PendingCondition.notify_one();
+}
+
+size_t CAfxWriteBehindFile::GetSize(void) const
+{
+	return m_Size;
+}
+
+size_t CAfxWriteBehindFile::Flush(void)
+{
+	std::unique_lock<std::mutex> lock(m_PendingMutex);
+
+	while (0 < m_PendingSize)
+		m_WrittenCondition.wait(lock);
+
+	return m_FileSize;
+}
+
+std::vector<size_t> const & CAfxWriteBehindFile::GetCompressedBlockOffsets(void) const
+{
+	return m_CompressedBlockOffsets;
+}
+
+void CAfxWriteBehindFile::WriterThread(CAfxWriteBehindFile * self)
+{
+	Block block;
+	std::vector<unsigned char> compressBuffer;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(self->m_PendingMutex);
+
+			if (!block.Data.empty())
+			{
+				self->m_PendingSize -= block.Data.size();
+
+				block.Data.clear();
+
+				if (self->m_FreeBuffers.size() < AFXWRITEBEHINDFILE_MAX_FREE_BUFFERS)
+				{
+					self->m_FreeBuffers.push_back(std::vector<unsigned char>());
+					self->m_FreeBuffers.back().swap(block.Data);
+				}
+
+				self->m_WrittenCondition.notify_one();
+			}
+
+			while (!self->m_Quit && self->m_Pending.empty())
+				self->m_PendingCondition.wait(lock);
+
+			if (self->m_Pending.empty())
+				break; // quit and nothing left.
+
+			block.Data.swap(self->m_Pending.front().Data);
+			block.Compress = self->m_Pending.front().Compress;
+			self->m_Pending.pop_front();
+		}
+
+		if (!self->WriteBlock(block, compressBuffer))
+			self->m_Error = true;
+	}
+}
+
+bool CAfxWriteBehindFile::WriteBlock(Block const & block, std::vector<unsigned char> & compressBuffer)
+{
+	if (!block.Compress)
+	{
+		if (1 != fwrite(&block.Data[0], block.Data.size(), 1, m_File))
+			return false;
+
+		AddFileSize(block.Data.size(), false);
+		return true;
+	}
+
+	uLong sourceLen = (uLong)block.Data.size();
+	uLongf destLen = compressBound(sourceLen);
+
+	compressBuffer.resize(8 + destLen);
+
+	if (Z_OK != compress2(&compressBuffer[8], &destLen, &block.Data[0], sourceLen, AFXWRITEBEHINDFILE_COMPRESSION_LEVEL))
+		return false;
+
+	unsigned int sizes[2] = { (unsigned int)sourceLen, (unsigned int)destLen };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		compressBuffer[4 * i + 0] = (unsigned char)(sizes[i] & 0xff);
+		compressBuffer[4 * i + 1] = (unsigned char)((sizes[i] >> 8) & 0xff);
+		compressBuffer[4 * i + 2] = (unsigned char)((sizes[i] >> 16) & 0xff);
+		compressBuffer[4 * i + 3] = (unsigned char)((sizes[i] >> 24) & 0xff);
+	}
+
+	if (1 != fwrite(&compressBuffer[0], 8 + destLen, 1, m_File))
+		return false;
+
+	AddFileSize(8 + destLen, true);
+	return true;
+}
+
+void CAfxWriteBehindFile::AddFileSize(size_t size, bool compressedBlock)
+{
+	std::unique_lock<std::mutex> lock(m_PendingMutex);
+
+	if (compressedBlock)
+		m_CompressedBlockOffsets.push_back(m_FileSize);
+
+	m_FileSize += size;
+}
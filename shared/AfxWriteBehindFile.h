@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+///   Binary file that is written by its own I/O thread, so that the
+///   producing thread only has to hand over memory buffers.
+/// </summary>
+/// <remarks>
+///   Open, Write and Close must be called from the same thread.
+/// </remarks>
+class CAfxWriteBehindFile
+{
+public:
+	CAfxWriteBehindFile();
+
+	/// <summary>Calls Close.</summary>
+	~CAfxWriteBehindFile();
+
+	/// <summary>Creates (or truncates) the file and starts the I/O thread.</summary>
+	bool Open(wchar_t const * fileName);
+
+	bool IsOpen(void) const;
+
+	/// <summary>Writes all data handed over so far, then closes the file.</summary>
+	/// <returns>false if writing (or compressing) any data failed.</returns>
+	bool Close(void);
+
+	/// <summary>Hands over the contents of inOutBuffer to the I/O thread.</summary>
+	/// <remarks>
+	///   inOutBuffer is empty afterwards, but usually keeps a capacity,
+	///   so it can be re-used without allocating.<br />
+	///   Blocks if the I/O thread is too far behind.
+	/// </remarks>
+	/// <param name="compress">
+	///   If true the data is written as a zlib block (compressed on the I/O thread):
+	///   uint32 uncompressed size, uint32 compressed size, compressed data (compress2 format), little endian.
+	/// </param>
+	void Write(std::vector<unsigned char> & inOutBuffer, bool compress = false);
+
+	/// <summary>Number of (uncompressed) bytes handed over so far.</summary>
+	size_t GetSize(void) const;
+
+	/// <summary>Waits until all data handed over so far is written.</summary>
+	/// <returns>The file size (after compression).</returns>
+	size_t Flush(void);
+
+	/// <summary>File offsets of the compressed blocks, only complete after Flush.</summary>
+	std::vector<size_t> const & GetCompressedBlockOffsets(void) const;
+
+private:
+	struct Block
+	{
+		std::vector<unsigned char> Data;
+		bool Compress;
+	};
+
+	FILE * m_File;
+	size_t m_Size;
+
+	std::mutex m_PendingMutex;
+	std::condition_variable m_PendingCondition;
+	std::condition_variable m_WrittenCondition;
+	std::deque<Block> m_Pending;
+	size_t m_PendingSize;
+	std::vector<std::vector<unsigned char>> m_FreeBuffers;
+	size_t m_FileSize;
+	std::vector<size_t> m_CompressedBlockOffsets;
+	bool m_Quit;
+	bool m_Error;
+	std::thread m_Thread;
+
+	static void WriterThread(CAfxWriteBehindFile * self);
+
+	/// <summary>Called on the I/O thread.</summary>
+	bool WriteBlock(Block const & block, std::vector<unsigned char> & compressBuffer);
+
+	/// <summary>Called on the I/O thread after a block has been written.</summary>
+	void AddFileSize(size_t size, bool compressedBlock);
+};
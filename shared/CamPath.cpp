@@ -6,7 +6,8 @@
 #include <deps/release/rapidxml/rapidxml_print.hpp>
 #include <iterator>
 #include <stdio.h>
-#include <fstream>
+#include <string.h>
+#include <string>
 #include <algorithm>
 
 #define _USE_MATH_DEFINES
@@ -96,6 +97,36 @@ char const * CamPath::QuaternionInterp_ToString(QuaternionInterp value)
 	return "[unkown]";
 }
 
+bool CamPath::SpeedInterp_FromString(char const * value, SpeedInterp & outValue)
+{
+	if(!_stricmp(value,"default"))
+	{
+		outValue = SI_DEFAULT;
+		return true;
+	}
+	else
+	if(!_stricmp(value,"constant"))
+	{
+		outValue = SI_CONSTANT;
+		return true;
+	}
+
+	return false;
+}
+
+char const * CamPath::SpeedInterp_ToString(SpeedInterp value)
+{
+	switch(value)
+	{
+	case SI_DEFAULT:
+		return "default";
+	case SI_CONSTANT:
+		return "constant";
+	}
+
+	return "[unkown]";
+}
+
 CamPathValue::CamPathValue()
 : X(0.0), Y(0.0), Z(0.0), R(), Fov(90.0), Selected(false)
 {
@@ -111,7 +142,7 @@ CamPathValue::CamPathValue(double x, double y, double z, double pitch, double ya
 {
 }
 
-CamPathIterator::CamPathIterator(CInterpolationMap<CamPathValue>::const_iterator & it) : wrapped(it)
+CamPathIterator::CamPathIterator(CInterpolationMap<CamPathValue>::const_iterator const & it) : wrapped(it)
 {
 }
 
@@ -144,18 +175,21 @@ bool CamPathIterator::operator != (CamPathIterator const &it) const
 // CamPath /////////////////////////////////////////////////////////////////////
 
 CamPath::CamPath()
-: m_OnChanged(0)
-, m_Offset(0)
-, m_Enabled(false)
+: m_Enabled(false)
 , m_PositionInterpMethod(DI_DEFAULT)
 , m_RotationInterpMethod(QI_DEFAULT)
 , m_FovInterpMethod(DI_DEFAULT)
+, m_SpeedInterpMethod(SI_DEFAULT)
+, m_OnChanged(0)
+, m_Offset(0)
 , m_XView(&m_Map, XSelector)
 , m_YView(&m_Map, YSelector)
 , m_ZView(&m_Map, ZSelector)
 , m_RView(&m_Map, RSelector)
 , m_FovView(&m_Map, FovSelector)
 , m_SelectedView(&m_Map, SelectedSelector)
+, m_ArcLengthRebuild(true)
+, m_ArcLengthInterpMethod(DI_DEFAULT)
 {
 	m_XInterp = new CCubicDoubleInterpolation<CamPathValue>(&m_XView);
 	m_YInterp = new CCubicDoubleInterpolation<CamPathValue>(&m_YView);
@@ -279,6 +313,18 @@ CamPath::DoubleInterp CamPath::FovInterpMethod_get(void)
 	return m_FovInterpMethod;
 }
 
+void CamPath::SpeedInterpMethod_set(SpeedInterp value)
+{
+	m_SpeedInterpMethod = value;
+
+	Changed();
+}
+
+CamPath::SpeedInterp CamPath::SpeedInterpMethod_get(void)
+{
+	return m_SpeedInterpMethod;
+}
+
 void CamPath::Add(double time, CamPathValue value)
 {
 	m_Map[time] = value;
@@ -288,6 +334,8 @@ void CamPath::Add(double time, CamPathValue value)
 
 void CamPath::Changed()
 {
+	m_ArcLengthRebuild = true;
+
 	if(m_OnChanged) m_OnChanged->CamPathChanged(this);
 }
 
@@ -362,6 +410,14 @@ bool CamPath::CanEval(void)
 }
 
 CamPathValue CamPath::Eval(double t)
+{
+	if(SI_CONSTANT == m_SpeedInterpMethod)
+		t = ArcLength_Reparameterise(t);
+
+	return EvalDirect(t);
+}
+
+CamPathValue CamPath::EvalDirect(double t)
 {
 	CamPathValue val;
 	
@@ -375,6 +431,303 @@ CamPathValue CamPath::Eval(double t)
 	return val;
 }
 
+Vector3 CamPath::EvalDirectPosition(double t)
+{
+	return Vector3(m_XInterp->Eval(t), m_YInterp->Eval(t), m_ZInterp->Eval(t));
+}
+
+double CamPath::DirectToTime(double t)
+{
+	if(SI_CONSTANT != m_SpeedInterpMethod)
+		return t;
+
+	if(m_ArcLengthRebuild)
+		ArcLength_Rebuild();
+
+	if(m_ArcLengthT.size() < 2) return t;
+
+	double lowerT = m_ArcLengthT.front();
+	double upperT = m_ArcLengthT.back();
+	double length = m_ArcLengthS.back();
+
+	if(t <= lowerT || upperT <= t || length <= 0.0) return t;
+
+	// Binary search for the first table entry past t:
+	size_t idx = std::upper_bound(m_ArcLengthT.begin(), m_ArcLengthT.end(), t) -m_ArcLengthT.begin();
+
+	if(idx < 1) return lowerT;
+	if(m_ArcLengthT.size() <= idx) return upperT;
+
+	double s0 = m_ArcLengthS[idx -1];
+	double s1 = m_ArcLengthS[idx];
+	double t0 = m_ArcLengthT[idx -1];
+	double t1 = m_ArcLengthT[idx];
+
+	double s = t1 <= t0 ? s0 : s0 +(s1 -s0) * (t -t0) / (t1 -t0);
+
+	return lowerT +(upperT -lowerT) * s / length;
+}
+
+double CamPath::GetArcLength()
+{
+	if(m_ArcLengthRebuild)
+		ArcLength_Rebuild();
+
+	return m_ArcLengthS.empty() ? 0.0 : m_ArcLengthS.back();
+}
+
+// Minimum number of sub-intervals per keyframe segment, so that the linear
+// interpolation inside a table entry stays accurate on long segments:
+#define CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS 16
+
+// Maximum adaptive refinement depth per sub-interval:
+#define CAMPATH_ARCLENGTH_MAX_DEPTH 8
+
+// Relative tolerance for the adaptive Gauss-Legendre quadrature:
+#define CAMPATH_ARCLENGTH_TOLERANCE 1.0e-6
+
+double CamPath::ArcLength_Speed(double t, double h)
+{
+	double dX = m_XInterp->Eval(t +h) -m_XInterp->Eval(t -h);
+	double dY = m_YInterp->Eval(t +h) -m_YInterp->Eval(t -h);
+	double dZ = m_ZInterp->Eval(t +h) -m_ZInterp->Eval(t -h);
+
+	return sqrt(dX*dX +dY*dY +dZ*dZ) / (2.0 * h);
+}
+
+double CamPath::ArcLength_GaussLegendre(double a, double b)
+{
+	// 5-point Gauss-Legendre nodes and weights on [-1,1]:
+	static const double nodes[5] = { 0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+	static const double weights[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
+
+	double half = 0.5 * (b -a);
+	double mid = 0.5 * (a +b);
+
+	// The smallest node distance to an interval border is about 0.047 * (b-a),
+	// so the central difference never reaches into the neighbouring keyframe segment:
+	double h = 1.0e-3 * (b -a);
+
+	double result = 0;
+	for(int i = 0; i < 5; ++i)
+	{
+		result += weights[i] * ArcLength_Speed(mid +half * nodes[i], h);
+	}
+
+	return half * result;
+}
+
+void CamPath::ArcLength_Refine(ArcLengthSegment & segment, double a, double b, double whole, double tol, int depth)
+{
+	double mid = 0.5 * (a +b);
+	double left = ArcLength_GaussLegendre(a, mid);
+	double right = ArcLength_GaussLegendre(mid, b);
+
+	// Stop when the quadrature converged, the minimum subdivisions keep the
+	// table fine enough for the linear interpolation:
+	if(depth <= 0 || fabs(left +right -whole) <= tol)
+	{
+		double s = segment.S.empty() ? 0.0 : segment.S.back();
+
+		segment.T.push_back(mid);
+		segment.S.push_back(s +left);
+		segment.T.push_back(b);
+		segment.S.push_back(s +left +right);
+		return;
+	}
+
+	ArcLength_Refine(segment, a, mid, left, 0.5 * tol, depth -1);
+	ArcLength_Refine(segment, mid, b, right, 0.5 * tol, depth -1);
+}
+
+void CamPath::ArcLength_BuildSegment(ArcLengthSegment & segment)
+{
+	segment.T.clear();
+	segment.S.clear();
+	segment.Probes.clear();
+
+	double step = (segment.T1 -segment.T0) / CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS;
+
+	segment.Probes.push_back(EvalDirectPosition(segment.T0));
+
+	for(int i = 0; i < CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS; ++i)
+	{
+		double a = segment.T0 +i * step;
+		double b = i +1 < CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS ? segment.T0 +(i +1) * step : segment.T1;
+		double whole = ArcLength_GaussLegendre(a, b);
+
+		segment.Probes.push_back(EvalDirectPosition(b));
+
+		ArcLength_Refine(segment, a, b, whole, CAMPATH_ARCLENGTH_TOLERANCE * (1.0 +whole), CAMPATH_ARCLENGTH_MAX_DEPTH);
+	}
+}
+
+bool CamPath::ArcLength_ValidateSegment(size_t index)
+{
+	if(ArcLengthSegmentState_Unknown == m_ArcLengthSegmentStates[index])
+	{
+		ArcLengthSegment const & segment = m_ArcLengthSegments[index];
+
+		double tolerance = CAMPATH_ARCLENGTH_TOLERANCE * (1.0 +(segment.S.empty() ? 0.0 : segment.S.back()));
+		double step = (segment.T1 -segment.T0) / CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS;
+
+		m_ArcLengthSegmentStates[index] = ArcLengthSegmentState_Valid;
+
+		for(size_t i = 0; i < segment.Probes.size(); ++i)
+		{
+			double t = i < CAMPATH_ARCLENGTH_MIN_SUBDIVISIONS ? segment.T0 +i * step : segment.T1;
+
+			if(tolerance < (EvalDirectPosition(t) -segment.Probes[i]).Length())
+			{
+				m_ArcLengthSegmentStates[index] = ArcLengthSegmentState_Invalid;
+				break;
+			}
+		}
+	}
+
+	return ArcLengthSegmentState_Valid == m_ArcLengthSegmentStates[index];
+}
+
+void CamPath::ArcLength_Rebuild(void)
+{
+	m_ArcLengthRebuild = false;
+
+	m_ArcLengthT.clear();
+	m_ArcLengthS.clear();
+
+	std::vector<ArcLengthKey> oldKeys;
+	oldKeys.swap(m_ArcLengthKeys);
+	size_t oldKeyIndex = 0;
+
+	std::vector<ArcLengthSegment> oldSegments;
+	oldSegments.swap(m_ArcLengthSegments);
+	size_t oldIndex = 0;
+
+	if(!CanEval()) return;
+
+	// The interpolation method changes the whole curve:
+	bool allChanged = oldKeys.empty() || m_ArcLengthInterpMethod != m_PositionInterpMethod;
+	m_ArcLengthInterpMethod = m_PositionInterpMethod;
+
+	std::vector<size_t> changedKeys;
+
+	for(CInterpolationMap<CamPathValue>::const_iterator it = m_Map.begin(); it != m_Map.end(); ++it)
+	{
+		ArcLengthKey key;
+		key.T = it->first;
+		key.X = it->second.X;
+		key.Y = it->second.Y;
+		key.Z = it->second.Z;
+
+		// Both are sorted by time, so we can walk the old keys along:
+		while(oldKeyIndex < oldKeys.size() && oldKeys[oldKeyIndex].T < key.T)
+			++oldKeyIndex;
+
+		bool changed = allChanged
+			|| oldKeys.size() <= oldKeyIndex
+			|| oldKeys[oldKeyIndex].T != key.T
+			|| oldKeys[oldKeyIndex].X != key.X
+			|| oldKeys[oldKeyIndex].Y != key.Y
+			|| oldKeys[oldKeyIndex].Z != key.Z
+			// A keyframe before this one was removed:
+			|| (!m_ArcLengthKeys.empty() && (0 == oldKeyIndex || oldKeys[oldKeyIndex -1].T != m_ArcLengthKeys.back().T));
+
+		if(changed) changedKeys.push_back(m_ArcLengthKeys.size());
+
+		m_ArcLengthKeys.push_back(key);
+	}
+
+	m_ArcLengthSegments.resize(m_ArcLengthKeys.size() -1);
+	m_ArcLengthSegmentStates.assign(m_ArcLengthSegments.size(), ArcLengthSegmentState_Unknown);
+
+	for(size_t i = 0; i < m_ArcLengthSegments.size(); ++i)
+	{
+		ArcLengthSegment & segment = m_ArcLengthSegments[i];
+
+		segment.T0 = m_ArcLengthKeys[i].T;
+		segment.T1 = m_ArcLengthKeys[i +1].T;
+
+		while(oldIndex < oldSegments.size() && oldSegments[oldIndex].T0 < segment.T0)
+			++oldIndex;
+
+		if(!allChanged
+			&& oldIndex < oldSegments.size()
+			&& oldSegments[oldIndex].T0 == segment.T0
+			&& oldSegments[oldIndex].T1 == segment.T1)
+		{
+			segment.Probes.swap(oldSegments[oldIndex].Probes);
+			segment.T.swap(oldSegments[oldIndex].T);
+			segment.S.swap(oldSegments[oldIndex].S);
+		}
+		else
+			m_ArcLengthSegmentStates[i] = ArcLengthSegmentState_Invalid;
+	}
+
+	// The segments next to a changed keyframe are always rebuilt. The effect
+	// of a change on the cubic spline decays with the distance (in
+	// keyframes), so we walk on until a segment is still valid:
+	for(size_t i = 0; i < changedKeys.size(); ++i)
+	{
+		size_t key = changedKeys[i];
+
+		if(0 < key) m_ArcLengthSegmentStates[key -1] = ArcLengthSegmentState_Invalid;
+		if(key < m_ArcLengthSegments.size()) m_ArcLengthSegmentStates[key] = ArcLengthSegmentState_Invalid;
+
+		for(size_t j = key; 0 < j && !ArcLength_ValidateSegment(j -1); --j);
+		for(size_t j = key; j < m_ArcLengthSegments.size() && !ArcLength_ValidateSegment(j); ++j);
+	}
+
+	m_ArcLengthT.push_back(m_ArcLengthKeys.front().T);
+	m_ArcLengthS.push_back(0.0);
+
+	for(size_t i = 0; i < m_ArcLengthSegments.size(); ++i)
+	{
+		ArcLengthSegment & segment = m_ArcLengthSegments[i];
+
+		if(ArcLengthSegmentState_Invalid == m_ArcLengthSegmentStates[i])
+			ArcLength_BuildSegment(segment);
+
+		double s = m_ArcLengthS.back();
+
+		for(size_t j = 0; j < segment.T.size(); ++j)
+		{
+			m_ArcLengthT.push_back(segment.T[j]);
+			m_ArcLengthS.push_back(s +segment.S[j]);
+		}
+	}
+}
+
+double CamPath::ArcLength_Reparameterise(double t)
+{
+	if(m_ArcLengthRebuild)
+		ArcLength_Rebuild();
+
+	if(m_ArcLengthT.size() < 2) return t;
+
+	double lowerT = m_ArcLengthT.front();
+	double upperT = m_ArcLengthT.back();
+	double length = m_ArcLengthS.back();
+
+	if(t <= lowerT || upperT <= t || length <= 0.0) return t;
+
+	double s = length * (t -lowerT) / (upperT -lowerT);
+
+	// Binary search for the first table entry past s:
+	size_t idx = std::upper_bound(m_ArcLengthS.begin(), m_ArcLengthS.end(), s) -m_ArcLengthS.begin();
+
+	if(idx < 1) return lowerT;
+	if(m_ArcLengthS.size() <= idx) return upperT;
+
+	double s0 = m_ArcLengthS[idx -1];
+	double s1 = m_ArcLengthS[idx];
+	double t0 = m_ArcLengthT[idx -1];
+	double t1 = m_ArcLengthT[idx];
+
+	if(s1 <= s0) return t0;
+
+	return t0 +(t1 -t0) * (s -s0) / (s1 -s0);
+}
+
 void CamPath::OnChanged_set(ICamPathChanged * value)
 {
 	m_OnChanged = value;
@@ -403,6 +756,8 @@ bool CamPath::Save(wchar_t const * fileName)
 		cam->append_attribute(doc.allocate_attribute("rotationInterp", QuaternionInterp_ToString(m_RotationInterpMethod)));
 	if(DI_DEFAULT != m_FovInterpMethod)
 		cam->append_attribute(doc.allocate_attribute("fovInterp", DoubleInterp_ToString(m_FovInterpMethod)));
+	if(SI_DEFAULT != m_SpeedInterpMethod)
+		cam->append_attribute(doc.allocate_attribute("speedInterp", SpeedInterp_ToString(m_SpeedInterpMethod)));
 	if (m_Offset)
 		cam->append_attribute(doc.allocate_attribute("offset", double2xml(doc, m_Offset)));
 	doc.append_node(cam);
@@ -449,23 +804,195 @@ bool CamPath::Save(wchar_t const * fileName)
 	std::string xmlString;
 	rapidxml::print(std::back_inserter(xmlString), doc);
 
-	std::ofstream ofs(fileName, std::ios_base::binary);
+	FILE * pFile = 0;
+
+	_wfopen_s(&pFile, fileName, L"wb");
+
+	if(!pFile)
+		return false;
+
+	bool bOk = xmlString.size() == fwrite(xmlString.c_str(), sizeof(char), xmlString.size(), pFile);
 
-	bool bOk = !ofs.fail();
+	if(0 != fclose(pFile))
+		bOk = false;
+	
+	return bOk;
+}
+
+// Binary campath format
+//
+// All values are little-endian (as in memory on x86), the per keyframe values
+// are stored column wise (structure of arrays), so that each column can be
+// streamed with big block reads / writes:
+//
+// char[12] "afxCamPathB\0"
+// int32 version (CAMPATH_BINARY_VERSION)
+// uint8 positionInterp, uint8 rotationInterp, uint8 fovInterp, uint8 speedInterp
+// double offset
+// uint32 count
+// double[count] t
+// double[count] x, double[count] y, double[count] z
+// double[count] qw, double[count] qx, double[count] qy, double[count] qz
+// double[count] fov
+// uint8[count] selected
+
+static const char CAMPATH_BINARY_MAGIC[12] = "afxCamPathB";
+
+#define CAMPATH_BINARY_VERSION 1
+
+// Number of values buffered per column when streaming:
+#define CAMPATH_BINARY_CHUNK 4096
+
+static double CamPathBinary_T(double time, CamPathValue const & /*value*/) { return time; }
+static double CamPathBinary_X(double /*time*/, CamPathValue const & value) { return value.X; }
+static double CamPathBinary_Y(double /*time*/, CamPathValue const & value) { return value.Y; }
+static double CamPathBinary_Z(double /*time*/, CamPathValue const & value) { return value.Z; }
+static double CamPathBinary_QW(double /*time*/, CamPathValue const & value) { return value.R.W; }
+static double CamPathBinary_QX(double /*time*/, CamPathValue const & value) { return value.R.X; }
+static double CamPathBinary_QY(double /*time*/, CamPathValue const & value) { return value.R.Y; }
+static double CamPathBinary_QZ(double /*time*/, CamPathValue const & value) { return value.R.Z; }
+static double CamPathBinary_Fov(double /*time*/, CamPathValue const & value) { return value.Fov; }
+static unsigned char CamPathBinary_Selected(double /*time*/, CamPathValue const & value) { return value.Selected ? 1 : 0; }
+
+template<class T> static bool CamPathBinary_WriteColumn(FILE * pFile, CInterpolationMap<CamPathValue> & map, T (* selector)(double time, CamPathValue const & value))
+{
+	T buffer[CAMPATH_BINARY_CHUNK];
+	size_t count = 0;
 
-	if (bOk)
+	for(CInterpolationMap<CamPathValue>::const_iterator it = map.begin(); it != map.end(); ++it)
 	{
-		ofs << doc;
+		buffer[count] = selector(it->first, it->second);
+		++count;
+
+		if(CAMPATH_BINARY_CHUNK == count)
+		{
+			if(count != fwrite(buffer, sizeof(T), count, pFile)) return false;
+			count = 0;
+		}
 	}
 
-	if (ofs.fail())
+	return count == fwrite(buffer, sizeof(T), count, pFile);
+}
+
+bool CamPath::SaveBinary(wchar_t const * fileName)
+{
+	FILE * pFile = 0;
+
+	_wfopen_s(&pFile, fileName, L"wb");
+
+	if(!pFile)
+		return false;
+
+	int version = CAMPATH_BINARY_VERSION;
+	unsigned char interp[4] = {
+		(unsigned char)m_PositionInterpMethod,
+		(unsigned char)m_RotationInterpMethod,
+		(unsigned char)m_FovInterpMethod,
+		(unsigned char)m_SpeedInterpMethod
+	};
+	unsigned int count = (unsigned int)m_Map.size();
+
+	bool bOk =
+		1 == fwrite(CAMPATH_BINARY_MAGIC, sizeof(CAMPATH_BINARY_MAGIC), 1, pFile)
+		&& 1 == fwrite(&version, sizeof(version), 1, pFile)
+		&& 1 == fwrite(interp, sizeof(interp), 1, pFile)
+		&& 1 == fwrite(&m_Offset, sizeof(m_Offset), 1, pFile)
+		&& 1 == fwrite(&count, sizeof(count), 1, pFile)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_T)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_X)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_Y)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_Z)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_QW)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_QX)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_QY)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_QZ)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_Fov)
+		&& CamPathBinary_WriteColumn(pFile, m_Map, CamPathBinary_Selected);
+
+	if(0 != fclose(pFile))
 		bOk = false;
 
-	ofs.close();
-	
 	return bOk;
 }
 
+/// <remarks>The magic has already been read from pFile.</remarks>
+bool CamPath::LoadBinary(FILE * pFile)
+{
+	int version;
+	unsigned char interp[4];
+	double offset;
+	unsigned int count;
+
+	if(!(
+		1 == fread(&version, sizeof(version), 1, pFile)
+		&& CAMPATH_BINARY_VERSION == version
+		&& 1 == fread(interp, sizeof(interp), 1, pFile)
+		&& 1 == fread(&offset, sizeof(offset), 1, pFile)
+		&& 1 == fread(&count, sizeof(count), 1, pFile)
+	))
+		return false;
+
+	// The columns are read into one block, so a broken file can not leave a half loaded path behind:
+
+	const size_t columns = 9;
+
+	// Don't trust count before allocating for it:
+	long position = ftell(pFile);
+	if(position < 0 || 0 != fseek(pFile, 0, SEEK_END))
+		return false;
+	long end = ftell(pFile);
+	if(end < position || 0 != fseek(pFile, position, SEEK_SET))
+		return false;
+	if((unsigned long)(end - position) / (columns * sizeof(double) + sizeof(unsigned char)) < count)
+		return false;
+
+	std::vector<double> values((size_t)count * columns);
+	std::vector<unsigned char> selected(count);
+
+	if(!(
+		values.size() == fread(values.data(), sizeof(double), values.size(), pFile)
+		&& selected.size() == fread(selected.data(), sizeof(unsigned char), selected.size(), pFile)
+	))
+		return false;
+
+	// Clear current Campath:
+	SelectNone();
+	Clear();
+
+	PositionInterpMethod_set(interp[0] < _DI_COUNT ? (DoubleInterp)interp[0] : DI_DEFAULT);
+	RotationInterpMethod_set(interp[1] < _QI_COUNT ? (QuaternionInterp)interp[1] : QI_DEFAULT);
+	FovInterpMethod_set(interp[2] < _DI_COUNT ? (DoubleInterp)interp[2] : DI_DEFAULT);
+	SpeedInterpMethod_set(interp[3] < _SI_COUNT ? (SpeedInterp)interp[3] : SI_DEFAULT);
+	SetOffset(offset);
+
+	double const * t = values.data() + 0 * (size_t)count;
+	double const * x = values.data() + 1 * (size_t)count;
+	double const * y = values.data() + 2 * (size_t)count;
+	double const * z = values.data() + 3 * (size_t)count;
+	double const * qw = values.data() + 4 * (size_t)count;
+	double const * qx = values.data() + 5 * (size_t)count;
+	double const * qy = values.data() + 6 * (size_t)count;
+	double const * qz = values.data() + 7 * (size_t)count;
+	double const * fov = values.data() + 8 * (size_t)count;
+
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		CamPathValue r;
+		r.X = x[i];
+		r.Y = y[i];
+		r.Z = z[i];
+		r.R = Quaternion(qw[i], qx[i], qy[i], qz[i]);
+		r.Fov = fov[i];
+		r.Selected = 0 != selected[i];
+
+		// Times are stored sorted, so inserting at the end is constant time
+		// (and we don't notify for each point like Add does):
+		m_Map.insert(m_Map.end(), CInterpolationMap<CamPathValue>::value_type(t[i], r));
+	}
+
+	return true;
+}
+
 bool CamPath::Load(wchar_t const * fileName)
 {
 	bool bOk = false;
@@ -476,6 +1003,21 @@ bool CamPath::Load(wchar_t const * fileName)
 
 	if(!pFile)
 		return false;
+
+	char magic[sizeof(CAMPATH_BINARY_MAGIC)];
+
+	if(sizeof(magic) == fread(magic, sizeof(char), sizeof(magic), pFile)
+		&& 0 == memcmp(magic, CAMPATH_BINARY_MAGIC, sizeof(magic)))
+	{
+		bOk = LoadBinary(pFile);
+
+		fclose(pFile);
+
+		DoInterpolationMapChangedAll();
+		Changed();
+
+		return bOk;
+	}
 	
 	fseek(pFile, 0, SEEK_END);
 	size_t fileSize = ftell(pFile);
@@ -517,6 +1059,11 @@ bool CamPath::Load(wchar_t const * fileName)
 				if(fovInterpA) DoubleInterp_FromString(fovInterpA->value(), fovInterp);
 				FovInterpMethod_set(fovInterp);
 
+				rapidxml::xml_attribute<> * speedInterpA = cur_node->first_attribute("speedInterp");
+				SpeedInterp speedInterp = SI_DEFAULT;
+				if(speedInterpA) SpeedInterp_FromString(speedInterpA->value(), speedInterp);
+				SpeedInterpMethod_set(speedInterp);
+
 				rapidxml::xml_attribute<>* offsetA = cur_node->first_attribute("offset");
 				double offset = offsetA ? atof(offsetA->value()) : 0.0;
 				SetOffset(offset);
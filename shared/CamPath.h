@@ -3,6 +3,9 @@
 #include "AfxRefCounted.h"
 #include "AfxMath.h"
 
+#include <vector>
+#include <stdio.h>
+
 using namespace Afx;
 using namespace Afx::Math;
 
@@ -29,7 +32,7 @@ struct CamPathIterator
 public:
 	CInterpolationMap<CamPathValue>::const_iterator wrapped;
 
-	CamPathIterator(CInterpolationMap<CamPathValue>::const_iterator & it);
+	CamPathIterator(CInterpolationMap<CamPathValue>::const_iterator const & it);
 
 	double GetTime();
 
@@ -68,12 +71,21 @@ public:
 		_QI_COUNT = 3,
 	};
 
+	enum SpeedInterp {
+		SI_DEFAULT = 0,
+		SI_CONSTANT = 1,
+		_SI_COUNT = 2
+	};
+
 	static bool DoubleInterp_FromString(char const * value, DoubleInterp & outValue);
 	static char const * DoubleInterp_ToString(DoubleInterp value);
 
 	static bool QuaternionInterp_FromString(char const * value, QuaternionInterp & outValue);
 	static char const * QuaternionInterp_ToString(QuaternionInterp value);
 
+	static bool SpeedInterp_FromString(char const * value, SpeedInterp & outValue);
+	static char const * SpeedInterp_ToString(SpeedInterp value);
+
 	CamPath();
 	
 	~CamPath();
@@ -90,6 +102,13 @@ public:
 	void FovInterpMethod_set(DoubleInterp value);
 	DoubleInterp FovInterpMethod_get(void);
 
+	/// <remarks>
+	/// SI_CONSTANT re-parameterises the path by arc length, so the camera moves
+	/// with constant speed between the first and the last keyframe time.
+	/// </remarks>
+	void SpeedInterpMethod_set(SpeedInterp value);
+	SpeedInterp SpeedInterpMethod_get(void);
+
 	void Add(double time, CamPathValue value);
 
 	void Remove(double time);
@@ -110,10 +129,43 @@ public:
 
 	/// <remarks>
 	/// Must not be called if CanEval() returns false!<br />
+	/// NOT threadsafe: with SI_CONSTANT the arc length table is updated on the first call after a change (only around keyframes that moved).
 	/// </remarks>
 	CamPathValue Eval(double t);
 
+	/// <summary>Evaluates the path at t ignoring the speed interpolation method (keyframe timing).</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// </remarks>
+	CamPathValue EvalDirect(double t);
+
+	/// <summary>Like EvalDirect, but only evaluates the position, which is a lot cheaper.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// </remarks>
+	Vector3 EvalDirectPosition(double t);
+
+	/// <summary>Inverse of the speed interpolation: Returns the time at which Eval is where EvalDirect is at t.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// NOT threadsafe, see Eval.
+	/// </remarks>
+	double DirectToTime(double t);
+
+	/// <summary>Length of the path's position curve between first and last keyframe.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// NOT threadsafe, see Eval.
+	/// </remarks>
+	double GetArcLength();
+
+	/// <summary>Saves the path in XML format.</summary>
 	bool Save(wchar_t const * fileName);
+
+	/// <summary>Saves the path in the binary campath format, which is a lot faster and smaller for big paths.</summary>
+	bool SaveBinary(wchar_t const * fileName);
+
+	/// <summary>Loads the path from XML or binary campath format (auto-detected).</summary>
 	bool Load(wchar_t const * fileName);
 	
 	/// <remarks>In the current implementation if points happen to fall on the same time value, then the last point's value will be used (no interpolation).</remarks>
@@ -199,6 +251,7 @@ private:
 	DoubleInterp m_PositionInterpMethod;
 	QuaternionInterp m_RotationInterpMethod;
 	DoubleInterp m_FovInterpMethod;
+	SpeedInterp m_SpeedInterpMethod;
 	ICamPathChanged * m_OnChanged;
 	double m_Offset;
 	
@@ -222,4 +275,62 @@ private:
 	void CopyMap(CInterpolationMap<CamPathValue> & dst, CInterpolationMap<CamPathValue> & src);
 
 	void DoInterpolationMapChangedAll(void);
+
+	bool LoadBinary(FILE * pFile);
+
+	/// <summary>Keyframe position as seen by the last ArcLength_Rebuild, for detecting changes.</summary>
+	struct ArcLengthKey
+	{
+		double T;
+		double X;
+		double Y;
+		double Z;
+	};
+
+	/// <summary>Arc length table of a keyframe segment.</summary>
+	struct ArcLengthSegment
+	{
+		double T0;
+		double T1;
+
+		/// <summary>Positions at the borders of the sub-intervals, for detecting changes.</summary>
+		std::vector<Vector3> Probes;
+
+		/// <summary>S[i] is the length of the segment up to time T[i] (T0 itself is not in the table).</summary>
+		std::vector<double> T;
+		std::vector<double> S;
+	};
+
+	enum ArcLengthSegmentState
+	{
+		ArcLengthSegmentState_Unknown,
+		ArcLengthSegmentState_Valid,
+		ArcLengthSegmentState_Invalid
+	};
+
+	/// <summary>Cumulative arc length table: m_ArcLengthS[i] is the length of the path up to time m_ArcLengthT[i].</summary>
+	std::vector<double> m_ArcLengthT;
+	std::vector<double> m_ArcLengthS;
+	bool m_ArcLengthRebuild;
+
+	std::vector<ArcLengthKey> m_ArcLengthKeys;
+	std::vector<ArcLengthSegment> m_ArcLengthSegments;
+	DoubleInterp m_ArcLengthInterpMethod;
+
+	/// <summary>ArcLengthSegmentState per m_ArcLengthSegments entry during ArcLength_Rebuild.</summary>
+	std::vector<unsigned char> m_ArcLengthSegmentStates;
+
+	/// <summary>Rebuilds the tables of the segments around keyframes that changed and joins them.</summary>
+	void ArcLength_Rebuild(void);
+	void ArcLength_BuildSegment(ArcLengthSegment & segment);
+
+	/// <summary>Checks if m_ArcLengthSegments[index] is still valid, unless already known.</summary>
+	bool ArcLength_ValidateSegment(size_t index);
+
+	void ArcLength_Refine(ArcLengthSegment & segment, double a, double b, double whole, double tol, int depth);
+	double ArcLength_Speed(double t, double h);
+	double ArcLength_GaussLegendre(double a, double b);
+
+	/// <summary>Maps a time to the time at which the path has travelled the same fraction of its length.</summary>
+	double ArcLength_Reparameterise(double t);
 };
@@ -0,0 +1,351 @@
+#include "stdafx.h"
+
+#include "CamPathTrajectory.h"
+
+#include <thread>
+
+/// <summary>Max. number of segments sampled before they are simplified, limits the memory used for samples.</summary>
+#define CAMPATHTRAJECTORY_BATCH_SEGMENTS 64
+
+/// <summary>A segment is re-sampled if any of its points moved further than this fraction of epsilon.</summary>
+#define CAMPATHTRAJECTORY_VALID_FRACTION 0.1
+
+/// <summary>Min. number of dirty segments per thread, below that starting a thread costs more than it saves.</summary>
+#define CAMPATHTRAJECTORY_SEGMENTS_PER_THREAD 16
+
+CamPathTrajectory::CamPathTrajectory(double epsilon, size_t pointsPerSegment)
+: m_Epsilon(epsilon)
+, m_PointsPerSegment(pointsPerSegment)
+, m_PositionInterpMethod(CamPath::DI_DEFAULT)
+, m_NextDirtySegment(0)
+, m_DirtySegmentsEnd(0)
+{
+}
+
+void CamPathTrajectory::Clear(void)
+{
+	m_Segments.clear();
+	m_Points.clear();
+	m_Keys.clear();
+}
+
+std::vector<CamPathTrajectory::Point> const & CamPathTrajectory::GetPoints(void) const
+{
+	return m_Points;
+}
+
+size_t CamPathTrajectory::Update(CamPath & camPath)
+{
+	std::vector<Segment> oldSegments;
+	oldSegments.swap(m_Segments);
+	size_t oldIndex = 0;
+
+	std::vector<Key> oldKeys;
+	oldKeys.swap(m_Keys);
+	size_t oldKeyIndex = 0;
+
+	// The interpolation method changes the whole curve:
+	bool allChanged = oldKeys.empty() || m_PositionInterpMethod != camPath.PositionInterpMethod_get();
+	m_PositionInterpMethod = camPath.PositionInterpMethod_get();
+
+	m_ChangedKeys.clear();
+	m_DirtySegments.clear();
+
+	CamPathIterator itEnd = camPath.GetEnd();
+
+	for(CamPathIterator it = camPath.GetBegin(); it != itEnd; ++it)
+	{
+		CamPathValue value = it.GetValue();
+
+		Key key;
+		key.T = it.GetTime();
+		key.Y = Vector3(value.X, value.Y, value.Z);
+		key.Selected = value.Selected;
+
+		// Both are sorted by time, so we can walk the old keys along:
+		while(oldKeyIndex < oldKeys.size() && oldKeys[oldKeyIndex].T < key.T)
+			++oldKeyIndex;
+
+		bool changed = allChanged
+			|| oldKeys.size() <= oldKeyIndex
+			|| oldKeys[oldKeyIndex].T != key.T
+			|| oldKeys[oldKeyIndex].Y.X != key.Y.X
+			|| oldKeys[oldKeyIndex].Y.Y != key.Y.Y
+			|| oldKeys[oldKeyIndex].Y.Z != key.Y.Z
+			|| oldKeys[oldKeyIndex].Selected != key.Selected
+			// A keyframe before this one was removed:
+			|| (!m_Keys.empty() && (0 == oldKeyIndex || oldKeys[oldKeyIndex -1].T != m_Keys.back().T));
+
+		if(changed) m_ChangedKeys.push_back(m_Keys.size());
+
+		m_Keys.push_back(key);
+	}
+
+	m_Segments.resize(m_Keys.empty() ? 0 : m_Keys.size() -1);
+	m_SegmentStates.assign(m_Segments.size(), SegmentState_Unknown);
+
+	for(size_t i = 0; i < m_Segments.size(); ++i)
+	{
+		Segment & segment = m_Segments[i];
+
+		segment.T0 = m_Keys[i].T;
+		segment.T1 = m_Keys[i +1].T;
+		segment.Selected0 = m_Keys[i].Selected;
+		segment.Selected1 = m_Keys[i +1].Selected;
+
+		while(oldIndex < oldSegments.size() && oldSegments[oldIndex].T0 < segment.T0)
+			++oldIndex;
+
+		if(oldIndex < oldSegments.size()
+			&& oldSegments[oldIndex].T0 == segment.T0
+			&& oldSegments[oldIndex].T1 == segment.T1
+			&& oldSegments[oldIndex].Selected0 == segment.Selected0
+			&& oldSegments[oldIndex].Selected1 == segment.Selected1)
+		{
+			segment.Points.swap(oldSegments[oldIndex].Points);
+			segment.Probes.swap(oldSegments[oldIndex].Probes);
+		}
+		else
+			m_SegmentStates[i] = SegmentState_Invalid;
+	}
+
+	if(allChanged)
+	{
+		for(size_t i = 0; i < m_Segments.size(); ++i)
+			ValidateSegment(camPath, i);
+	}
+	else
+	{
+		// Only the curve around changed keyframes can have moved and the
+		// effect of a change decays with the distance (in keyframes), so we
+		// walk away from each changed keyframe until a segment is still valid:
+		for(size_t i = 0; i < m_ChangedKeys.size(); ++i)
+		{
+			size_t key = m_ChangedKeys[i];
+
+			for(size_t j = key; 0 < j && !ValidateSegment(camPath, j -1); --j);
+			for(size_t j = key; j < m_Segments.size() && !ValidateSegment(camPath, j); ++j);
+		}
+	}
+
+	for(size_t i = 0; i < m_Segments.size(); ++i)
+	{
+		if(SegmentState_Invalid != m_SegmentStates[i]) continue;
+
+		m_Segments[i].Points.clear();
+		m_Segments[i].Probes.clear();
+		m_DirtySegments.push_back(i);
+	}
+
+	for(size_t first = 0; first < m_DirtySegments.size(); first += CAMPATHTRAJECTORY_BATCH_SEGMENTS)
+	{
+		size_t count = m_DirtySegments.size() -first;
+		if(CAMPATHTRAJECTORY_BATCH_SEGMENTS < count) count = CAMPATHTRAJECTORY_BATCH_SEGMENTS;
+
+		// CamPath is not thread-safe, so sampling is done here:
+
+		m_Samples.resize(count * m_PointsPerSegment);
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			Segment & segment = m_Segments[m_DirtySegments[first +i]];
+			segment.SamplesOffset = i * m_PointsPerSegment;
+			SampleSegment(camPath, segment);
+		}
+
+		SimplifySegments(first, count);
+	}
+
+	m_Points.clear();
+
+	for(size_t i = 0; i < m_Segments.size(); ++i)
+	{
+		std::vector<Point> & points = m_Segments[i].Points;
+
+		// Skip the first point except for the first segment (it's the last point of the previous one):
+		m_Points.insert(m_Points.end(), points.begin() +(0 < i ? 1 : 0), points.end());
+	}
+
+	return m_DirtySegments.size();
+}
+
+double CamPathTrajectory::GetSampleTime(Segment const & segment, size_t index)
+{
+	if(m_PointsPerSegment <= index +1)
+		return segment.T1;
+
+	return segment.T0 +(segment.T1 -segment.T0)*((double)index/(m_PointsPerSegment -1));
+}
+
+bool CamPathTrajectory::IsSegmentValid(CamPath & camPath, Segment const & segment)
+{
+	double tolerance = CAMPATHTRAJECTORY_VALID_FRACTION * m_Epsilon;
+
+	for(std::vector<Point>::const_iterator it = segment.Points.begin(); it != segment.Points.end(); ++it)
+	{
+		if(tolerance < (camPath.EvalDirectPosition(it->T) -it->Y).Length())
+			return false;
+	}
+
+	for(std::vector<Point>::const_iterator it = segment.Probes.begin(); it != segment.Probes.end(); ++it)
+	{
+		if(tolerance < (camPath.EvalDirectPosition(it->T) -it->Y).Length())
+			return false;
+	}
+
+	return true;
+}
+
+bool CamPathTrajectory::ValidateSegment(CamPath & camPath, size_t index)
+{
+	unsigned char & state = m_SegmentStates[index];
+
+	if(SegmentState_Unknown == state)
+		state = IsSegmentValid(camPath, m_Segments[index]) ? SegmentState_Valid : SegmentState_Invalid;
+
+	return SegmentState_Valid == state;
+}
+
+void CamPathTrajectory::SampleSegment(CamPath & camPath, Segment & segment)
+{
+	Vector3 * samples = &m_Samples[segment.SamplesOffset];
+
+	for(size_t i = 0; i < m_PointsPerSegment; ++i)
+	{
+		samples[i] = camPath.EvalDirectPosition(GetSampleTime(segment, i));
+	}
+}
+
+void CamPathTrajectory::SimplifySegments(size_t first, size_t count)
+{
+	size_t numThreads = std::thread::hardware_concurrency();
+	if(count / CAMPATHTRAJECTORY_SEGMENTS_PER_THREAD < numThreads) numThreads = count / CAMPATHTRAJECTORY_SEGMENTS_PER_THREAD;
+	if(numThreads < 1) numThreads = 1;
+
+	if(m_Workspaces.size() < numThreads) m_Workspaces.resize(numThreads);
+
+	m_NextDirtySegment = first;
+	m_DirtySegmentsEnd = first +count;
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads -1);
+
+	for(size_t i = 1; i < numThreads; ++i)
+	{
+		threads.push_back(std::thread(SimplifySegmentsWorker, this, &m_Workspaces[i]));
+	}
+
+	SimplifySegmentsWorker(this, &m_Workspaces[0]);
+
+	for(size_t i = 0; i < threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+}
+
+void CamPathTrajectory::SimplifySegmentsWorker(CamPathTrajectory * self, Workspace * workspace)
+{
+	for(size_t i = self->m_NextDirtySegment++; i < self->m_DirtySegmentsEnd; i = self->m_NextDirtySegment++)
+	{
+		self->SimplifySegment(*workspace, self->m_Segments[self->m_DirtySegments[i]]);
+	}
+}
+
+void CamPathTrajectory::SimplifySegment(Workspace & workspace, Segment & segment)
+{
+	size_t count = m_PointsPerSegment;
+	Vector3 const * samples = &m_Samples[segment.SamplesOffset];
+
+	std::vector<unsigned char> & keep = workspace.Keep;
+	std::vector<size_t> & stack = workspace.Stack;
+
+	keep.assign(count, 0);
+	keep[0] = 1;
+	keep[count -1] = 1;
+
+	// The intervals on the stack don't overlap, so this is enough:
+	stack.reserve(2 * count);
+	stack.clear();
+	stack.push_back(0);
+	stack.push_back(count -1);
+
+	while(!stack.empty())
+	{
+		size_t end = stack.back();
+		stack.pop_back();
+		size_t start = stack.back();
+		stack.pop_back();
+
+		double dmax = 0;
+		size_t index = start;
+
+		for(size_t i = start +1; i < end; ++i)
+		{
+			double d = ShortestDistanceToSegment(samples[i], samples[start], samples[end]);
+			if(d > dmax)
+			{
+				index = i;
+				dmax = d;
+			}
+		}
+
+		// If max distance is greater than epsilon, simplify both sides:
+		if(dmax > m_Epsilon)
+		{
+			keep[index] = 1;
+			stack.push_back(index);
+			stack.push_back(end);
+			stack.push_back(start);
+			stack.push_back(index);
+		}
+	}
+
+	segment.Points.clear();
+	segment.Probes.clear();
+
+	bool selected = segment.Selected0 && segment.Selected1;
+	size_t lastKept = 0;
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		if(!keep[i]) continue;
+
+		if(0 < i && 2 <= i -lastKept)
+		{
+			size_t probe = (lastKept +i) / 2;
+
+			Point pt;
+			pt.T = GetSampleTime(segment, probe);
+			pt.Y = samples[probe];
+			pt.Selected = selected;
+			segment.Probes.push_back(pt);
+		}
+
+		Point pt;
+		pt.T = GetSampleTime(segment, i);
+		pt.Y = samples[i];
+		pt.Selected = 0 == i ? segment.Selected0 : (count -1 == i ? segment.Selected1 : selected);
+		segment.Points.push_back(pt);
+
+		lastKept = i;
+	}
+}
+
+double CamPathTrajectory::ShortestDistanceToSegment(Vector3 const & y, Vector3 const & start, Vector3 const & end)
+{
+	double ESx = end.X - start.X;
+	double ESy = end.Y - start.Y;
+	double ESz = end.Z - start.Z;
+	double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
+	double t = dESdES ? (
+		(y.X-start.X)*ESx +(y.Y -start.Y)*ESy + (y.Z -start.Z)*ESz
+	) / dESdES : 0.0;
+
+	if(t <= 0.0)
+		return (start -y).Length();
+	else
+	if(1.0 <= t)
+		return (y -end).Length();
+
+	return (y -(start +t*(end -start))).Length();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "CamPath.h"
+
+#include <atomic>
+#include <vector>
+
+/// <summary>
+///   Builds the simplified polyline of a CamPath's position curve,
+///   segment (keyframe interval) wise, so that on a change only the segments
+///   that actually changed need to be re-sampled.
+/// </summary>
+/// <remarks>
+///   This is CPU only (no drawing), so it can be tested on its own.<br />
+///   Sampling is done with CamPath::EvalDirectPosition, so the points are in
+///   keyframe time (use CamPath::DirectToTime to get the time at which the
+///   camera is there).
+/// </remarks>
+class CamPathTrajectory
+{
+public:
+	struct Point
+	{
+		/// <summary>Keyframe time, see CamPath::EvalDirect.</summary>
+		double T;
+
+		Vector3 Y;
+
+		bool Selected;
+	};
+
+	/// <param name="epsilon">Max. distance of the samples to the simplified line in world units, must be at least 0.0.</param>
+	/// <param name="pointsPerSegment">Number of samples per segment, must be at least 2.</param>
+	CamPathTrajectory(double epsilon, size_t pointsPerSegment);
+
+	void Clear(void);
+
+	/// <summary>Brings the trajectory up to date with camPath.</summary>
+	/// <remarks>
+	///   Must not be called if camPath.CanEval() returns false!<br />
+	///   A segment is re-used if its keyframe times and selection did not
+	///   change and its points moved less than a fraction of epsilon.
+	///   Only segments around keyframes that changed are checked for that.
+	/// </remarks>
+	/// <returns>Number of segments that had to be re-sampled.</returns>
+	size_t Update(CamPath & camPath);
+
+	/// <summary>Points of all segments in time order (without duplicates at the keyframes).</summary>
+	std::vector<Point> const & GetPoints(void) const;
+
+private:
+	struct Segment
+	{
+		double T0;
+		double T1;
+		bool Selected0;
+		bool Selected1;
+
+		/// <summary>Simplified points, including both ends.</summary>
+		std::vector<Point> Points;
+
+		/// <summary>Samples half way between the simplified points, for detecting changes.</summary>
+		std::vector<Point> Probes;
+
+		/// <summary>Offset into m_Samples while being re-sampled.</summary>
+		size_t SamplesOffset;
+	};
+
+	/// <summary>Keyframe as seen by the last Update, for detecting changes.</summary>
+	struct Key
+	{
+		double T;
+		Vector3 Y;
+		bool Selected;
+	};
+
+	enum SegmentState
+	{
+		SegmentState_Unknown,
+		SegmentState_Valid,
+		SegmentState_Invalid
+	};
+
+	/// <summary>Per thread memory for the point reduction, so it doesn't allocate.</summary>
+	struct Workspace
+	{
+		std::vector<unsigned char> Keep;
+		std::vector<size_t> Stack;
+	};
+
+	double m_Epsilon;
+	size_t m_PointsPerSegment;
+
+	std::vector<Segment> m_Segments;
+	std::vector<Point> m_Points;
+
+	std::vector<Key> m_Keys;
+	CamPath::DoubleInterp m_PositionInterpMethod;
+
+	/// <summary>Indices into m_Keys of the keyframes that changed since the last Update.</summary>
+	std::vector<size_t> m_ChangedKeys;
+
+	/// <summary>SegmentState per m_Segments entry during Update.</summary>
+	std::vector<unsigned char> m_SegmentStates;
+
+	/// <summary>Samples of all dirty segments, m_PointsPerSegment each.</summary>
+	std::vector<Vector3> m_Samples;
+
+	/// <summary>Indices into m_Segments.</summary>
+	std::vector<size_t> m_DirtySegments;
+
+	/// <summary>Next index into m_DirtySegments to be simplified by a worker.</summary>
+	std::atomic<size_t> m_NextDirtySegment;
+	size_t m_DirtySegmentsEnd;
+
+	std::vector<Workspace> m_Workspaces;
+
+	double GetSampleTime(Segment const & segment, size_t index);
+
+	bool IsSegmentValid(CamPath & camPath, Segment const & segment);
+
+	/// <summary>Checks m_Segments[index] with IsSegmentValid unless already known.</summary>
+	bool ValidateSegment(CamPath & camPath, size_t index);
+
+	void SampleSegment(CamPath & camPath, Segment & segment);
+
+	/// <summary>Simplifies m_DirtySegments[first] to m_DirtySegments[first +count -1], in parallel if there are enough.</summary>
+	void SimplifySegments(size_t first, size_t count);
+
+	static void SimplifySegmentsWorker(CamPathTrajectory * self, Workspace * workspace);
+
+	/// <summary>Iterative Ramer-Douglas-Peucker over the segment's samples.</summary>
+	void SimplifySegment(Workspace & workspace, Segment & segment);
+
+	/// <summary>Distance of y to the line segment from start to end.</summary>
+	static double ShortestDistanceToSegment(Vector3 const & y, Vector3 const & start, Vector3 const & end);
+};
@@ -179,13 +179,13 @@ public:
 	void Sample(unsigned char const * data, double time);
 
 protected:
-	virtual void EasySamplerBase::MakeFrame()
+	virtual void MakeFrame()
 	{
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
 
-	virtual void EasySamplerBase::SubSample(
+	virtual void SubSample(
 		double timeA,
 		double timeB,
 		double subTimeA,
@@ -265,13 +265,13 @@ public:
 	void Sample(float const * data, double time);
 
 protected:
-	virtual void EasySamplerBase::MakeFrame()
+	virtual void MakeFrame()
 	{
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
 
-	virtual void EasySamplerBase::SubSample(
+	virtual void SubSample(
 		double timeA,
 		double timeB,
 		double subTimeA,
@@ -330,11 +330,25 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 
 			return;
 		}
-		else if (!_stricmp("save", subcmd) && 3 == argc)
+		else if (!_stricmp("save", subcmd) && (3 == argc || 4 == argc))
 		{
+			bool binary = false;
+
+			if (4 == argc)
+			{
+				char const* arg3 = args->ArgV(3);
+
+				if (!_stricmp("binary", arg3)) binary = true;
+				else if (_stricmp("xml", arg3))
+				{
+					conWarning("Unknown format %s.\n", arg3);
+					return;
+				}
+			}
+
 			std::wstring wideString;
 			bool bOk = UTF8StringToWideString(args->ArgV(2), wideString)
-				&& camPath->Save(wideString.c_str())
+				&& (binary ? camPath->SaveBinary(wideString.c_str()) : camPath->Save(wideString.c_str()))
 				;
 
 			if (bOk) conMessage("Saving campath: %s.\n", "OK");
@@ -342,6 +356,31 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 
 			return;
 		}
+		else if (!_stricmp("convert", subcmd) && 5 == argc)
+		{
+			char const* arg4 = args->ArgV(4);
+			bool binary = !_stricmp("binary", arg4);
+
+			if (!binary && _stricmp("xml", arg4))
+			{
+				conWarning("Unknown format %s.\n", arg4);
+				return;
+			}
+
+			CamPath tempPath;
+			std::wstring wideInString;
+			std::wstring wideOutString;
+			bool bOk = UTF8StringToWideString(args->ArgV(2), wideInString)
+				&& UTF8StringToWideString(args->ArgV(3), wideOutString)
+				&& tempPath.Load(wideInString.c_str())
+				&& (binary ? tempPath.SaveBinary(wideOutString.c_str()) : tempPath.Save(wideOutString.c_str()))
+				;
+
+			if (bOk) conMessage("Converting campath: %s.\n", "OK");
+			else conWarning("Converting campath: %s.\n", "ERROR");
+
+			return;
+		}
 		else if (!_stricmp("edit", subcmd))
 		{
 			if (3 <= argc)
@@ -713,12 +752,42 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 															);
 															return;
 														}
+														else
+															if (!_stricmp(arg3, "speed"))
+															{
+																if (5 <= argc)
+																{
+																	char const* arg4 = args->ArgV(4);
+																	CamPath::SpeedInterp value;
+
+																	if (CamPath::SpeedInterp_FromString(arg4, value))
+																	{
+																		camPath->SpeedInterpMethod_set(value);
+																		return;
+																	}
+																}
+
+
+																conMessage("%s edit interp speed ", args->ArgV(0));
+																for (CamPath::SpeedInterp i = CamPath::SI_DEFAULT; i < CamPath::_SI_COUNT; i = (CamPath::SpeedInterp)((int)i + 1))
+																{
+																	conMessage("%s%s", i != CamPath::SI_DEFAULT ? "|" : "", CamPath::SpeedInterp_ToString(i));
+																}
+																conMessage(" - default uses the keyframe timing, constant moves the camera with constant speed along the path between the first and last keyframe time.\n"
+																	"Current value: %s\n", CamPath::SpeedInterp_ToString(camPath->SpeedInterpMethod_get())
+																);
+																if (camPath->CanEval())
+																	conMessage("Path length: %f\n", camPath->GetArcLength());
+																return;
+															}
 											}
 
 											conMessage(
 												"%s edit interp position [...]\n"
 												"%s edit interp rotation [...]\n"
 												"%s edit interp fov [...]\n"
+												"%s edit interp speed [...]\n"
+												, args->ArgV(0)
 												, args->ArgV(0)
 												, args->ArgV(0)
 												, args->ArgV(0)
@@ -1019,8 +1088,9 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 	conMessage("%s clear - Removes all [or all selected] keyframes.\n", args->ArgV(0));
 	conMessage("%s print - Prints keyframes.\n", args->ArgV(0));
 	conMessage("%s remove <id> - Removes a keyframe.\n", args->ArgV(0));
-	conMessage("%s load <fileName> - Loads the campath from the file (XML format).\n", args->ArgV(0));
-	conMessage("%s save <fileName> - Saves the campath to the file (XML format).\n", args->ArgV(0));
+	conMessage("%s load <fileName> - Loads the campath from the file (XML or binary format, detected automatically).\n", args->ArgV(0));
+	conMessage("%s save <fileName> [xml|binary] - Saves the campath to the file (default: XML format, binary is a lot faster for big paths).\n", args->ArgV(0));
+	conMessage("%s convert <inFileName> <outFileName> xml|binary - Converts a campath file to the given format (does not affect the current campath).\n", args->ArgV(0));
 	conMessage("%s edit [...] - Edit properties of the path [or selected keyframes].\n", args->ArgV(0));
 	conMessage("%s select [...] - Keyframe selection.\n", args->ArgV(0));
 	conMessage("%s offset [...] - Offset campath.\n", args->ArgV(0));
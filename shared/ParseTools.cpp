@@ -0,0 +1,120 @@
+#include "stdafx.h"
+
+#include "ParseTools.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+void ParseSkipBlanks(char const * & inOutPos, char const * end)
+{
+	while(inOutPos < end && (' ' == *inOutPos || '\t' == *inOutPos))
+		++inOutPos;
+}
+
+void ParseSkipLine(char const * & inOutPos, char const * end)
+{
+	while(inOutPos < end && '\n' != *inOutPos)
+		++inOutPos;
+
+	if(inOutPos < end)
+		++inOutPos;
+}
+
+bool ParseDouble(char const * & inOutPos, char const * end, double & outValue)
+{
+	// Powers of ten that are exact in a double:
+	static const double exactPowers[23] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	char const * pos = inOutPos;
+
+	bool negative = false;
+	if(pos < end && ('-' == *pos || '+' == *pos))
+	{
+		negative = '-' == *pos;
+		++pos;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0; // significant digits in mantissa
+	int exponent = 0;
+	bool hasDigits = false;
+	bool exact = true;
+
+	for(; pos < end && '0' <= *pos && *pos <= '9'; ++pos)
+	{
+		hasDigits = true;
+		if(0 == mantissa && '0' == *pos) continue;
+		if(digits < 19) { mantissa = 10 * mantissa + (*pos - '0'); ++digits; }
+		else { ++exponent; exact = false; }
+	}
+
+	if(pos < end && '.' == *pos)
+	{
+		++pos;
+		for(; pos < end && '0' <= *pos && *pos <= '9'; ++pos)
+		{
+			hasDigits = true;
+			if(0 == mantissa && '0' == *pos) { --exponent; continue; }
+			if(digits < 19) { mantissa = 10 * mantissa + (*pos - '0'); ++digits; --exponent; }
+			else exact = false;
+		}
+	}
+
+	if(!hasDigits)
+		return false;
+
+	if(pos < end && ('e' == *pos || 'E' == *pos))
+	{
+		char const * expPos = pos +1;
+		bool expNegative = false;
+
+		if(expPos < end && ('-' == *expPos || '+' == *expPos))
+		{
+			expNegative = '-' == *expPos;
+			++expPos;
+		}
+
+		if(expPos < end && '0' <= *expPos && *expPos <= '9')
+		{
+			int expValue = 0;
+			for(; expPos < end && '0' <= *expPos && *expPos <= '9'; ++expPos)
+			{
+				if(expValue < 100000) expValue = 10 * expValue + (*expPos - '0');
+			}
+			exponent += expNegative ? -expValue : expValue;
+			pos = expPos;
+		}
+	}
+
+	if(exact && mantissa <= ((uint64_t)1 << 53) && -22 <= exponent && exponent <= 22)
+	{
+		// Both operands are exact, so the result is correctly rounded:
+		double value = (double)mantissa;
+		value = exponent < 0 ? value / exactPowers[-exponent] : value * exactPowers[exponent];
+		outValue = negative ? -value : value;
+	}
+	else
+	{
+		// Rare, let the CRT do the hard work (on a 0-terminated copy):
+
+		char buffer[128];
+		size_t length = (size_t)(pos - inOutPos);
+		if(sizeof(buffer) <= length) return false;
+
+		for(size_t i = 0; i < length; ++i)
+		{
+			// Make it independent of the locale's decimal point:
+			buffer[i] = '.' == inOutPos[i] ? *localeconv()->decimal_point : inOutPos[i];
+		}
+		buffer[length] = '\0';
+
+		outValue = strtod(buffer, 0);
+	}
+
+	inOutPos = pos;
+	return true;
+}
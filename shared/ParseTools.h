@@ -0,0 +1,16 @@
+#pragma once
+
+// Fast parsing from character ranges that don't need to be 0-terminated
+// (e.g. memory mapped files), independent of the current locale.
+
+/// <summary>Skips spaces and tabs.</summary>
+void ParseSkipBlanks(char const * & inOutPos, char const * end);
+
+/// <summary>Skips past the next line feed (or to end).</summary>
+void ParseSkipLine(char const * & inOutPos, char const * end);
+
+/// <summary>Parses a decimal floating point number: [+|-]digits[.digits][(e|E)[+|-]digits]</summary>
+/// <remarks>Results are correctly rounded. No hex, inf or nan support.</remarks>
+/// <param name="inOutPos">Is advanced past the number on success.</param>
+/// <returns>false if there is no valid number at inOutPos.</returns>
+bool ParseDouble(char const * & inOutPos, char const * end, double & outValue);
@@ -2,7 +2,6 @@
 
 #include "RawOutput.h"
 
-#include <windows.h>
 #include <stdio.h>
 
 int CalcPitch(int width, unsigned char bytePerPixel, int byteAlignment)
@@ -19,6 +18,20 @@ int CalcPitch(int width, unsigned char bytePerPixel, int byteAlignment)
 	return pitch;
 }
 
+static void RawOutput_PutU16(unsigned char * p, unsigned short value)
+{
+	p[0] = (unsigned char)(value & 0xFF);
+	p[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static void RawOutput_PutU32(unsigned char * p, unsigned int value)
+{
+	p[0] = (unsigned char)(value & 0xFF);
+	p[1] = (unsigned char)((value >> 8) & 0xFF);
+	p[2] = (unsigned char)((value >> 16) & 0xFF);
+	p[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
 // see RawOutput.h
 bool WriteRawBitmap(
 	unsigned char const * pData,
@@ -35,87 +48,88 @@ bool WriteRawBitmap(
 	_wfopen_s(&pFile, fileName, L"wb");
 	if (!pFile) return false;
 
-	BITMAPINFOHEADER bmInfoH;
-	BITMAPFILEHEADER bmFileH;
+	// The headers are written byte wise (little-endian), so we don't depend on
+	// the Windows BITMAPFILEHEADER / BITMAPINFOHEADER / RGBQUAD structures:
+
+	const unsigned int sizeOfFileHeader = 14; // sizeof(BITMAPFILEHEADER)
+	const unsigned int sizeOfInfoHeader = 40; // sizeof(BITMAPINFOHEADER)
+	const unsigned int sizeOfRgbQuad = 4; // sizeof(RGBQUAD)
+
+	unsigned char bmFileH[sizeOfFileHeader];
+	unsigned char bmInfoH[sizeOfInfoHeader];
 
 	//
 	// Construct the BITMAPINFOHEADER:
 
-	bmInfoH.biSize = sizeof(bmInfoH);
-	bmInfoH.biWidth = (LONG)usWidth;
-	bmInfoH.biHeight = (LONG)usHeight;
-	bmInfoH.biPlanes = 1;
-	bmInfoH.biBitCount = ucBpp;
-	bmInfoH.biCompression = BI_RGB;
-
-	bmInfoH.biSizeImage =
+	unsigned int biSizeImage =
 		// biHeight * 4 * ceil( cClrBits / 8 ) * biWidth
-		(((bmInfoH.biWidth * ucBpp +31) & ~31)>>3) * (LONG)usHeight; 
-
-
-	bmInfoH.biXPelsPerMeter = 0; // dunno
-	bmInfoH.biYPelsPerMeter = 0; // dunno
-	
-	bmInfoH.biClrUsed = 0;
-	if( ucBpp < 24 ) bmInfoH.biClrUsed = 1 << ucBpp;
-
-	bmInfoH.biClrImportant = 0; // all color indexies important lol
+		((((unsigned int)usWidth * ucBpp +31) & ~31)>>3) * (unsigned int)usHeight; 
+
+	unsigned int biClrUsed = 0;
+	if( ucBpp < 24 ) biClrUsed = 1 << ucBpp;
+
+	RawOutput_PutU32(&bmInfoH[0], sizeOfInfoHeader); // biSize
+	RawOutput_PutU32(&bmInfoH[4], usWidth); // biWidth
+	RawOutput_PutU32(&bmInfoH[8], usHeight); // biHeight
+	RawOutput_PutU16(&bmInfoH[12], 1); // biPlanes
+	RawOutput_PutU16(&bmInfoH[14], ucBpp); // biBitCount
+	RawOutput_PutU32(&bmInfoH[16], 0); // biCompression = BI_RGB
+	RawOutput_PutU32(&bmInfoH[20], biSizeImage); // biSizeImage
+	RawOutput_PutU32(&bmInfoH[24], 0); // biXPelsPerMeter, dunno
+	RawOutput_PutU32(&bmInfoH[28], 0); // biYPelsPerMeter, dunno
+	RawOutput_PutU32(&bmInfoH[32], biClrUsed); // biClrUsed
+	RawOutput_PutU32(&bmInfoH[36], 0); // biClrImportant, all color indexies important lol
 
 	//
 	// construct the BITMAPFILEHEADER:
 
-	bmFileH.bfType = 0x4d42; // 0x42='B', 0x4d = 'M'
-	bmFileH.bfSize = bmInfoH.biSize
-		+ bmInfoH.biClrUsed * sizeof(RGBQUAD) + bmInfoH.biSizeImage;
-
-    bmFileH.bfReserved1 = 0; 
-    bmFileH.bfReserved2 = 0;
- 
-    bmFileH.bfOffBits =
-		(DWORD)sizeof(BITMAPFILEHEADER) + 
-        bmInfoH.biSize + bmInfoH.biClrUsed * sizeof (RGBQUAD);
+	RawOutput_PutU16(&bmFileH[0], 0x4d42); // bfType, 0x42='B', 0x4d = 'M'
+	RawOutput_PutU32(&bmFileH[2], sizeOfInfoHeader + biClrUsed * sizeOfRgbQuad + biSizeImage); // bfSize
+	RawOutput_PutU16(&bmFileH[6], 0); // bfReserved1
+	RawOutput_PutU16(&bmFileH[8], 0); // bfReserved2
+	RawOutput_PutU32(&bmFileH[10], sizeOfFileHeader + sizeOfInfoHeader + biClrUsed * sizeOfRgbQuad); // bfOffBits
 
 	//
 	//	write out headers:
 
-	fwrite(&bmFileH, sizeof(BITMAPFILEHEADER), 1, pFile);
-	fwrite(&bmInfoH, sizeof(BITMAPINFOHEADER), 1, pFile);
+	fwrite(bmFileH, sizeof(bmFileH), 1, pFile);
+	fwrite(bmInfoH, sizeof(bmInfoH), 1, pFile);
 
 	//
 	//	write out fake pallete if required:
 
-	RGBQUAD rgbquad;
-	rgbquad.rgbReserved = 0;
-	if( bmInfoH.biClrUsed <= 256)
+	unsigned char rgbquad[sizeOfRgbQuad]; // Blue, Green, Red, Reserved
+	rgbquad[3] = 0;
+	if( biClrUsed <= 256)
 	{
 		// gray fade (okay may have some rounding errors hehe):
-		float tmpf = (BYTE)(255.0f / (bmInfoH.biClrUsed-1)); // TODO: check if the BYTE conversion is correct
-		for( DWORD cols = 0; cols<bmInfoH.biClrUsed; cols++)
+		float tmpf = (unsigned char)(255.0f / (biClrUsed-1)); // TODO: check if the BYTE conversion is correct
+		for( unsigned int cols = 0; cols<biClrUsed; cols++)
 		{
-			rgbquad.rgbRed = (BYTE)((float)cols * tmpf);
-			rgbquad.rgbGreen = rgbquad.rgbRed;
-			rgbquad.rgbBlue = rgbquad.rgbRed;
-			fwrite(&rgbquad,sizeof(rgbquad),1,pFile);
+			rgbquad[2] = (unsigned char)((float)cols * tmpf);
+			rgbquad[1] = rgbquad[2];
+			rgbquad[0] = rgbquad[2];
+			fwrite(rgbquad,sizeof(rgbquad),1,pFile);
 		}
 	} else {
 		// simply encode it into RGB:
-		for( DWORD cols = 0; cols<bmInfoH.biClrUsed; cols++)
+		for( unsigned int cols = 0; cols<biClrUsed; cols++)
 		{
-			rgbquad.rgbRed = (BYTE)(cols & 0xFF0000);
-			rgbquad.rgbGreen = (BYTE)(cols & 0x00FF00);
-			rgbquad.rgbBlue = (BYTE)(cols & 0x0000FF);
-			fwrite(&rgbquad,sizeof(rgbquad),1,pFile);
+			rgbquad[2] = (unsigned char)(cols & 0xFF0000);
+			rgbquad[1] = (unsigned char)(cols & 0x00FF00);
+			rgbquad[0] = (unsigned char)(cols & 0x0000FF);
+			fwrite(rgbquad,sizeof(rgbquad),1,pFile);
 		}
 	}
 
 	//
 	//	write out image data:
 
-	LONG realLineSize = bmInfoH.biSizeImage / usHeight;
+	int realLineSize = (int)(biSizeImage / usHeight);
 
 	if(pitch == realLineSize)
 	{
-		fwrite(pData, sizeof(unsigned char), bmInfoH.biSizeImage, pFile);
+		fwrite(pData, sizeof(unsigned char), biSizeImage, pFile);
 		fclose(pFile);
 		return true;
 	}
@@ -124,7 +138,7 @@ bool WriteRawBitmap(
 		int iPaddings = realLineSize-pitch;
 		char pad=0x00;
 
-		for( LONG line=0; line<usHeight; line++)
+		for( int line=0; line<usHeight; line++)
 		{
 			fwrite(pData, sizeof(unsigned char), pitch, pFile);
 			pData += pitch;
@@ -6,10 +6,6 @@
 //
 // Raw means dumb, no checks etc..
 
-#include <windows.h>
-#include <winbase.h>
-
-
 int CalcPitch(int width, unsigned char bytePerPixel, int byteAlignment);
 
 //	WriteRawTarga
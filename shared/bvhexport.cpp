@@ -7,6 +7,37 @@
 using namespace std;
 
 
+/// <summary>Max. number of frames per file that are buffered before they are handed to the writer thread.</summary>
+#define BVHBATCHEXPORT_BATCH_FRAMES 256
+
+static void BvhBeginContent(FILE *pFile, char const * pRootName, double frameTime, long &ulTPos)
+{
+	char szTmp[1024];
+
+	fputs("HIERARCHY\n",pFile);
+
+	fputs("ROOT ",pFile);
+	fputs(pRootName,pFile);
+	fputs("\n{\n\tOFFSET 0.00 0.00 0.00\n\tCHANNELS 6 Xposition Yposition Zposition Zrotation Xrotation Yrotation\n\tEnd Site\n\t{\n\t\tOFFSET 0.00 0.00 -1.00\n\t}\n}\n",pFile);
+
+	fputs("MOTION\n",pFile);
+	ulTPos = ftell(pFile);
+	fputs("Frames: 0123456789A\n",pFile);
+
+	_snprintf_s(szTmp, _TRUNCATE,"Frame Time: %f\n", frameTime);
+	fputs(szTmp,pFile);
+}
+
+static void BvhEndContent(FILE *pFile, long ulTPos, unsigned int frameCount)
+{
+	char pTmp[100];
+
+	fseek(pFile, ulTPos, SEEK_SET);
+	_snprintf_s(pTmp, _TRUNCATE, "Frames: %11i", frameCount);
+	fputs(pTmp, pFile);
+}
+
+
 // BvhExport //////////////////////////////////////////////////////////////////
 
 BvhExport::BvhExport(wchar_t const * fileName, char const * rootName, double frameTime)
@@ -15,49 +46,165 @@ BvhExport::BvhExport(wchar_t const * fileName, char const * rootName, double fra
 	_wfopen_s(&m_pMotionFile, fileName, L"wb");
 
 	if (m_pMotionFile != NULL)
-		BeginContent(m_pMotionFile, rootName, frameTime, m_lMotionTPos);
+		BvhBeginContent(m_pMotionFile, rootName, frameTime, m_lMotionTPos);
 }
 
 BvhExport::~BvhExport()
 {
-	char pTmp[100];
-
 	if (m_pMotionFile) {
-		fseek(m_pMotionFile, m_lMotionTPos, SEEK_SET);
-		_snprintf_s(pTmp, _TRUNCATE, "Frames: %11i", m_FrameCount);
-		fputs(pTmp, m_pMotionFile);
+		BvhEndContent(m_pMotionFile, m_lMotionTPos, m_FrameCount);
 		fclose(m_pMotionFile);
 		m_pMotionFile = NULL;
 	}
 }
 
-void BvhExport::BeginContent(FILE *pFile, char const * pRootName, double frameTime, long &ulTPos)
+void BvhExport::WriteFrame(double Xposition, double Yposition, double Zposition, double Zrotation, double Xrotation, double Yrotation) {
+	char pszT[1024];
+
+	_snprintf_s(pszT, _TRUNCATE, "%f %f %f %f %f %f\n", Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation);
+
+	if (m_pMotionFile) fputs(pszT, m_pMotionFile);
+
+	m_FrameCount++;
+}
+
+
+// BvhBatchExport /////////////////////////////////////////////////////////////
+
+BvhBatchExport::BvhBatchExport(double frameTime)
+: m_FrameTime(frameTime)
+, m_PendingCount(0)
+, m_Quit(false)
 {
-	char szTmp[1024];
+	m_Thread = std::thread(WriterThread, this);
+}
 
-	fputs("HIERARCHY\n",pFile);
+BvhBatchExport::~BvhBatchExport()
+{
+	for (size_t i = 0; i < m_Files.size(); ++i)
+	{
+		HandOverFrames(m_Files[i]);
+	}
 
-	fputs("ROOT ",pFile);
-	fputs(pRootName,pFile);
-	fputs("\n{\n\tOFFSET 0.00 0.00 0.00\n\tCHANNELS 6 Xposition Yposition Zposition Zrotation Xrotation Yrotation\n\tEnd Site\n\t{\n\t\tOFFSET 0.00 0.00 -1.00\n\t}\n}\n",pFile);
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+		m_Quit = true;
+	}
+	m_PendingCondition.notify_one();
 
-	fputs("MOTION\n",pFile);
-	ulTPos = ftell(pFile);
-	fputs("Frames: 0123456789A\n",pFile);
+	m_Thread.join();
 
-	_snprintf_s(szTmp, _TRUNCATE,"Frame Time: %f\n", frameTime);
-	fputs(szTmp,pFile);
+	for (size_t i = 0; i < m_Files.size(); ++i)
+	{
+		File * file = m_Files[i];
+
+		BvhEndContent(file->MotionFile, file->MotionTPos, file->FrameCount);
+		fclose(file->MotionFile);
+
+		delete file;
+	}
 }
 
-void BvhExport::WriteFrame(double Xposition, double Yposition, double Zposition, double Zrotation, double Xrotation, double Yrotation) {
-	char pszT[1024];
+int BvhBatchExport::AddFile(wchar_t const * fileName, char const * rootName)
+{
+	FILE * motionFile = NULL;
 
-	_snprintf_s(pszT, _TRUNCATE, "%f %f %f %f %f %f\n", Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation);
+	_wfopen_s(&motionFile, fileName, L"wb");
 
-	if (m_pMotionFile) fputs(pszT, m_pMotionFile);
+	if (!motionFile)
+		return -1;
 
-	m_FrameCount++;
+	File * file = new File();
+	file->MotionFile = motionFile;
+	file->FrameCount = 0;
+	file->Frames.reserve(6 * BVHBATCHEXPORT_BATCH_FRAMES);
+
+	BvhBeginContent(file->MotionFile, rootName, m_FrameTime, file->MotionTPos);
+
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+		m_Files.push_back(file);
+	}
+
+	return (int)m_Files.size() -1;
 }
 
+void BvhBatchExport::WriteFrame(int index, double Xposition, double Yposition, double Zposition, double Zrotation, double Xrotation, double Yrotation)
+{
+	File * file = m_Files[index];
+
+	double frame[6] = { Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation };
+
+	file->Frames.insert(file->Frames.end(), frame, frame + 6);
+	file->FrameCount++;
 
+	if (6 * BVHBATCHEXPORT_BATCH_FRAMES <= file->Frames.size())
+		HandOverFrames(file);
+}
+
+void BvhBatchExport::HandOverFrames(File * file)
+{
+	if (file->Frames.empty())
+		return;
 
+	{
+		std::unique_lock<std::mutex> lock(m_PendingMutex);
+
+		if (file->PendingFrames.empty())
+			file->PendingFrames.swap(file->Frames);
+		else
+			file->PendingFrames.insert(file->PendingFrames.end(), file->Frames.begin(), file->Frames.end());
+
+		++m_PendingCount;
+	}
+	m_PendingCondition.notify_one();
+
+	file->Frames.clear();
+	file->Frames.reserve(6 * BVHBATCHEXPORT_BATCH_FRAMES);
+}
+
+void BvhBatchExport::WriterThread(BvhBatchExport * self)
+{
+	std::vector<File *> files;
+
+	while (true)
+	{
+		bool quit;
+		{
+			std::unique_lock<std::mutex> lock(self->m_PendingMutex);
+
+			while (!self->m_Quit && 0 == self->m_PendingCount)
+				self->m_PendingCondition.wait(lock);
+
+			// Only the writer thread touches WritingFrames, so it is enough to swap under the lock:
+			files = self->m_Files;
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				files[i]->WritingFrames.swap(files[i]->PendingFrames);
+			}
+
+			self->m_PendingCount = 0;
+			quit = self->m_Quit;
+		}
+
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			WriteFrames(files[i]);
+		}
+
+		if (quit)
+			break;
+	}
+}
+
+void BvhBatchExport::WriteFrames(File * file)
+{
+	std::vector<double> & frames = file->WritingFrames;
+
+	for (size_t i = 0; i + 6 <= frames.size(); i += 6)
+	{
+		fprintf(file->MotionFile, "%f %f %f %f %f %f\n", frames[i], frames[i + 1], frames[i + 2], frames[i + 3], frames[i + 4], frames[i + 5]);
+	}
+
+	frames.clear();
+}
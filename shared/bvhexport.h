@@ -1,7 +1,11 @@
 #pragma once
 
 #include <stdio.h>
-#include <windows.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 // BvhExport ///////////////////////////////////////////////////////////////////
@@ -24,9 +28,71 @@ private:
 	unsigned int m_FrameCount;
 	FILE * m_pMotionFile;
 	long m_lMotionTPos;
+};
+
+
+// BvhBatchExport //////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Writes many BVH files (e.g. one per entity) at once, with a single
+///   writer thread doing the formatting and the file I/O.
+/// </summary>
+/// <remarks>
+///   AddFile and WriteFrame must be called from the same thread.<br />
+///   The frame counts in the headers are patched once, on destruction.
+/// </remarks>
+class BvhBatchExport
+{
+public:
+	/// <summary>Starts the writer thread.</summary>
+	BvhBatchExport(double frameTime);
+
+	/// <summary>Writes the remaining frames and closes all BVH files.</summary>
+	~BvhBatchExport();
+
+	/// <summary>Creates a new BVH file.</summary>
+	/// <returns>Index for WriteFrame or -1 if the file could not be created.</returns>
+	int AddFile(wchar_t const * fileName, char const * rootName);
+
+	/// <summary>Only buffers the frame, cheap enough to be called for many files per frame.</summary>
+	void WriteFrame(int index,
+		double Xposition, double Yposition, double Zposition,
+		double Zrotation, double Xrotation, double Yrotation
+	);
+
+private:
+	struct File
+	{
+		FILE * MotionFile;
+		long MotionTPos;
+		unsigned int FrameCount;
+
+		/// <summary>6 values per frame, owned by the calling thread.</summary>
+		std::vector<double> Frames;
+
+		/// <summary>Guarded by m_PendingMutex.</summary>
+		std::vector<double> PendingFrames;
+
+		/// <summary>Owned by the writer thread.</summary>
+		std::vector<double> WritingFrames;
+	};
+
+	double m_FrameTime;
+
+	/// <summary>Only changed by the calling thread and under m_PendingMutex.</summary>
+	std::vector<File *> m_Files;
+
+	std::mutex m_PendingMutex;
+	std::condition_variable m_PendingCondition;
+	size_t m_PendingCount;
+	bool m_Quit;
+	std::thread m_Thread;
+
+	void HandOverFrames(File * file);
 
-	void BeginContent(FILE *pFile ,char const * pRootName, double frameTime, long &ulTPos);
+	static void WriterThread(BvhBatchExport * self);
 
+	static void WriteFrames(File * file);
 };
 
 
@@ -2,33 +2,16 @@
 
 #include "bvhimport.h"
 
+#include "ParseTools.h"
+
 #include <stdio.h>
-#include <windows.h>
-
-
-/// <remarks> If pz is 0, the function returns </remarks>
-char * CrLfZ2LfZ(char * opz) {
-	char *pz = opz;
-
-	if(pz) {
-		while(char c = *pz) {
-			if(
-				'\r' == c
-				&& '\n' == *(pz+1)
-				&& '\0' == *(pz+2)
-			) {
-				// \r\n\0
-				*pz = '\n';
-				*(pz+1) = '\0';
-				break;
-			}
+#include <string.h>
 
-			pz++;
-		}
-	}
+#include <string>
 
-	return opz;
-}
+
+/// <summary>Max. number of frames to reserve memory for before the frames are actually read, protects against bogus frame counts.</summary>
+#define BVHIMPORT_MAX_RESERVE_FRAMES (1 << 20)
 
 inline int myround(double x)
 {
@@ -36,6 +19,85 @@ inline int myround(double x)
 }
 
 
+// BvhLineReader ///////////////////////////////////////////////////////////////
+
+/// <summary>Reads a file line by line in big chunks, without copying the lines.</summary>
+class BvhLineReader
+{
+public:
+	BvhLineReader(FILE * file)
+	: m_File(file)
+	, m_Buffer(64 * 1024)
+	, m_Pos(0)
+	, m_End(0)
+	, m_Eof(false)
+	{
+	}
+
+	/// <summary>Returns the next line without the line break (\n or \r\n).</summary>
+	/// <remarks>The line is valid until the next call.</remarks>
+	/// <returns>false if there are no more lines.</returns>
+	bool ReadLine(char const * & outBegin, char const * & outEnd)
+	{
+		while(true)
+		{
+			char const * begin = m_Buffer.data() +m_Pos;
+			char const * lineFeed = (char const *)memchr(begin, '\n', m_End -m_Pos);
+
+			if(lineFeed || (m_Eof && m_Pos < m_End))
+			{
+				outBegin = begin;
+				outEnd = lineFeed ? lineFeed : m_Buffer.data() +m_End;
+				m_Pos = lineFeed ? lineFeed +1 -m_Buffer.data() : m_End;
+
+				if(outBegin < outEnd && '\r' == *(outEnd -1))
+					--outEnd;
+
+				return true;
+			}
+
+			if(m_Eof)
+				return false;
+
+			// Move the incomplete line to the front and fill up the rest:
+
+			memmove(m_Buffer.data(), begin, m_End -m_Pos);
+			m_End -= m_Pos;
+			m_Pos = 0;
+
+			if(m_End == m_Buffer.size())
+				m_Buffer.resize(2 * m_Buffer.size());
+
+			size_t read = fread(m_Buffer.data() +m_End, sizeof(char), m_Buffer.size() -m_End, m_File);
+			m_End += read;
+
+			if(0 == read)
+				m_Eof = true;
+		}
+	}
+
+	/// <summary>Like ReadLine, but returns a copy.</summary>
+	bool ReadLine(std::string & outLine)
+	{
+		char const * begin;
+		char const * end;
+
+		if(!ReadLine(begin, end))
+			return false;
+
+		outLine.assign(begin, end);
+		return true;
+	}
+
+private:
+	FILE * m_File;
+	std::vector<char> m_Buffer;
+	size_t m_Pos;
+	size_t m_End;
+	bool m_Eof;
+};
+
+
 // BvhImport //////////////////////////////////////////////////////////////////
 
 BvhImport::BvhImport()
@@ -45,35 +107,28 @@ BvhImport::BvhImport()
 
 void BvhImport::CloseMotionFile()
 {
-	if(m_Active)
-	{
-		m_Active = false;
-		fclose(m_File);
-	}
+	m_Active = false;
+	std::vector<double>().swap(m_Motion);
 }
 
-int BvhImport::DecodeBvhChannel(char * pszRemainder, char * & aoutNewRemainder)
+int BvhImport::DecodeBvhChannel(char const * & inOutPos, char const * end)
 {
-	aoutNewRemainder = pszRemainder;
-	if(!pszRemainder)
+	ParseSkipBlanks(inOutPos, end);
+
+	if(end -inOutPos < 9)
 		return -1;
 
 	int iret = -1;
 
-	while(0 != *pszRemainder && (' ' == *pszRemainder || '\t' == *pszRemainder) )
-	{
-		pszRemainder++;
-	}
-
-	if(pszRemainder == strstr(pszRemainder,"Xposition")) iret = BC_Xposition;
-	if(pszRemainder == strstr(pszRemainder,"Yposition")) iret = BC_Yposition;
-	if(pszRemainder == strstr(pszRemainder,"Zposition")) iret = BC_Zposition;
-	if(pszRemainder == strstr(pszRemainder,"Zrotation")) iret = BC_Zrotation;
-	if(pszRemainder == strstr(pszRemainder,"Xrotation")) iret = BC_Xrotation;
-	if(pszRemainder == strstr(pszRemainder,"Yrotation")) iret = BC_Yrotation;
+	if(0 == strncmp(inOutPos,"Xposition",9)) iret = BC_Xposition;
+	if(0 == strncmp(inOutPos,"Yposition",9)) iret = BC_Yposition;
+	if(0 == strncmp(inOutPos,"Zposition",9)) iret = BC_Zposition;
+	if(0 == strncmp(inOutPos,"Zrotation",9)) iret = BC_Zrotation;
+	if(0 == strncmp(inOutPos,"Xrotation",9)) iret = BC_Xrotation;
+	if(0 == strncmp(inOutPos,"Yrotation",9)) iret = BC_Yrotation;
 
 	if(0 <= iret)
-		aoutNewRemainder = pszRemainder + 9;
+		inOutPos += 9;
 
 	return iret;
 }
@@ -85,64 +140,20 @@ bool BvhImport::CopyToCampath(double timeOfs, double fov, CamPath & camPath)
 	if(!m_Active)
 		return true;
 
-	// we start at the first frame
-	if(fseek(m_File,m_MotionFPos,SEEK_SET))
-	{
-		// read error
-		CloseMotionFile();
-		return false;
-	}
+	int frames = (int)(m_Motion.size() / 6);
 
-	for(m_LastFrame = 0; m_LastFrame < m_Frames; ++m_LastFrame)
+	for(int frame = 0; frame < frames; ++frame)
 	{
-		char * pc;
-
-		// read current frame:
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-		if(!pc)
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
-
-		// decode frame:
-		int ichan;
-		char tc = 0;
-		char * pc2;
-		double fff;
-
-		pc = ms_readbuff;
-		for(ichan = 0; ichan < 6; ichan++)
-		{
-			pc2 = strchr(pc,' ');
-			if(!pc2)
-				pc2 = strchr(pc,'\t');
-			if(!pc2)
-				pc2 = pc + strlen(pc);
-
-			tc = *pc2;
-			*pc2 = 0;
-
-			fff = 0;
-			fff = atof(pc);
+		double const * cache = &m_Motion[6 * frame];
 
-			m_Cache[channelcode[ichan]] = fff;
+		double Ty = (-cache[0]);
+		double Tz = (+cache[1]);
+		double Tx = (-cache[2]);
+		double Rz = (-cache[3]);
+		double Rx = (-cache[4]);
+		double Ry = (+cache[5]);
 
-			*pc2 = tc;
-			pc = pc2;
-
-			while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
-		}
-
-		double Ty = (-m_Cache[0]);
-		double Tz = (+m_Cache[1]);
-		double Tx = (-m_Cache[2]);
-		double Rz = (-m_Cache[3]);
-		double Rx = (-m_Cache[4]);
-		double Ry = (+m_Cache[5]);
-
-		camPath.Add(timeOfs +m_LastFrame * m_FrameTime, CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
+		camPath.Add(timeOfs +frame * m_FrameTime, CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
 	}
 
 	return true;
@@ -150,136 +161,15 @@ bool BvhImport::CopyToCampath(double timeOfs, double fov, CamPath & camPath)
 
 bool BvhImport::GetCamPosition(double fTimeOfs, double outCamdata[6])
 {
-	char * pc;
-
 	if(!m_Active || !outCamdata)
 		return false; // not active
 
 	// calc targetframe:
 	int iCurFrame = myround(fTimeOfs / m_FrameTime);
-	if(iCurFrame < 0 || iCurFrame >= m_Frames)
+	if(iCurFrame < 0 || iCurFrame >= (int)(m_Motion.size() / 6))
 		return false; // out of range
 
-	if(	iCurFrame == m_LastFrame)
-	{
-		// pEngfuncs->Con_DPrintf("Using cached cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-		memcpy(outCamdata,m_Cache,sizeof(m_Cache));
-		return true;
-	}
-
-	if(0 == iCurFrame)
-	{
-		// we start at the first frame
-		if(fseek(m_File,m_MotionFPos,SEEK_SET))
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
-	} else {
-		// seek to frame position:
-		pc = 0;
-		
-		int iSeekFrames;
-		if(0 <= m_LastFrame)
-			iSeekFrames = iCurFrame - m_LastFrame -1;
-		else
-			iSeekFrames = iCurFrame;
-		
-		while(iSeekFrames)
-		{
-			if(0<iSeekFrames)
-			{
-				// seek forward
-				pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-				if(!pc)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-				iSeekFrames--;
-			}
-			else
-			{
-				// seek backward
-				char ac=0;
-				bool bReadErr = false;
-				int iReadBreaks = 2;
-
-				while(!bReadErr && 0<iReadBreaks)
-				{
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-
-					if(!bReadErr)
-						bReadErr = 1 != fread(&ac,sizeof(char),1,m_File);
-
-					bReadErr = bReadErr || ftell(m_File)<m_MotionFPos;
-
-					if('\n' == ac)
-						iReadBreaks--;
-
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-				}
-
-				bReadErr = bReadErr || 0 != fseek(m_File,+1,SEEK_CUR);
-
-				if(bReadErr)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-
-				iSeekFrames++;
-			}
-		}
-	}
-
-	// read current frame:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc)
-	{
-		// read error
-		CloseMotionFile();
-		return false;
-	}
-
-	m_LastFrame = iCurFrame;
-
-	// decode frame:
-	int ichan;
-	char tc = 0;
-	char * pc2;
-	double fff;
-
-	pc = ms_readbuff;
-	for(ichan = 0; ichan < 6; ichan++)
-	{
-		pc2 = strchr(pc,' ');
-		if(!pc2)
-			pc2 = strchr(pc,'\t');
-		if(!pc2)
-			pc2 = pc + strlen(pc);
-
-		tc = *pc2;
-		*pc2 = 0;
-
-		fff = 0;
-		fff = atof(pc);
-
-		m_Cache[channelcode[ichan]] = fff;
-
-		*pc2 = tc;
-		pc = pc2;
-
-		while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
-	}
-
-	// pEngfuncs->Con_DPrintf("Imported cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-	memcpy(outCamdata,m_Cache,sizeof(m_Cache));
+	memcpy(outCamdata, &m_Motion[6 * iCurFrame], 6 * sizeof(double));
 	return true;
 }
 
@@ -291,113 +181,110 @@ bool BvhImport::IsActive()
 
 bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 {
-	char * pc;
-	char * pc2;
+	CloseMotionFile();
 
-	if(m_Active)
-		CloseMotionFile();
+	FILE * file = 0;
 
-	_wfopen_s(&m_File, fileName, L"rb");
+	_wfopen_s(&file, fileName, L"rb");
 
-	if(!m_File)
+	if(!file)
 		return false;
 
+	m_Active = ReadMotionFile(file);
+
+	fclose(file);
+
+	if(!m_Active)
+		CloseMotionFile();
+
+	return m_Active;
+}
+
+bool BvhImport::ReadMotionFile(FILE * file)
+{
+	BvhLineReader reader(file);
+	std::string line;
+
 	// check if this could be a valid BVH file:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"HIERARCHY\n"))
-	{
-		fclose(m_File);
+	if(!reader.ReadLine(line) || line.compare("HIERARCHY"))
 		return false;
-	}
 
 	// skip till first channels entry:
-	pc2 = 0;
-	while(!pc2)
+	size_t channelsPos = std::string::npos;
+	while(std::string::npos == channelsPos)
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-		if(!pc)
-		{
-			fclose(m_File);
+		if(!reader.ReadLine(line))
 			return false;
-		}
 
-		pc2 = strstr(ms_readbuff,"CHANNELS 6 ");
+		channelsPos = line.find("CHANNELS 6 ");
 	}
 
 	// determine channel assignment:
-	pc2 += strlen("CHANNELS 6 ");
-
-	for(int i=0; i<6; i++) channelcode[i]=-1;
+	char const * pc = line.c_str() +channelsPos +strlen("CHANNELS 6 ");
+	char const * lineEnd = line.c_str() +line.length();
 
 	for(int i=0; i <6; i++)
 	{
-		int icode = DecodeBvhChannel(pc2,pc2);
-
-		if(0 <= icode)
-			channelcode[i]=icode;
-	}
+		channelcode[i] = DecodeBvhChannel(pc, lineEnd);
 
-	for(int i=0; i<6; i++)
-	{
-		if(channelcode[i]<0)
-		{
-			fclose(m_File);
+		if(channelcode[i] < 0)
 			return false;
-		}
 	}
 
 	// skip till MOTION entry:
-	pc2 = 0;
-	while(!pc2)
+	do
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-		if(!pc)
-		{
-			fclose(m_File);
+		if(!reader.ReadLine(line))
 			return false;
-		}
-
-		pc2 = strstr(ms_readbuff,"MOTION\n");
 	}
+	while(line.length() < strlen("MOTION") || line.compare(line.length() -strlen("MOTION"), std::string::npos, "MOTION"));
 
 	// read frames:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"Frames:") <= 0)
-	{
-		fclose(m_File);
+	if(!reader.ReadLine(line) || line.compare(0, strlen("Frames:"), "Frames:"))
+		return false;
+	int frames = atoi(line.c_str() +strlen("Frames:"));
+	if(frames < 0)
 		return false;
-	}
-	pc += strlen("Frames:");
-	m_Frames = atoi(pc);
 
 	// read frame time:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"Frame Time:") <= 0)
-	{
-		fclose(m_File);
+	if(!reader.ReadLine(line) || line.compare(0, strlen("Frame Time:"), "Frame Time:"))
 		return false;
-	}
-	pc += strlen("Frame Time:");
-	m_FrameTime = atof(pc);
-	if(m_FrameTime <= 0)
-	{
-		fclose(m_File);
+	pc = line.c_str() +strlen("Frame Time:");
+	lineEnd = line.c_str() +line.length();
+	ParseSkipBlanks(pc, lineEnd);
+	if(!ParseDouble(pc, lineEnd, m_FrameTime) || m_FrameTime <= 0)
 		return false;
-	}
 
-	m_MotionFPos = ftell(m_File);
-	m_LastFrame = -1;
-	m_Active = true;
+	// read the motion data:
+
+	m_Motion.reserve(6 * (size_t)(frames < BVHIMPORT_MAX_RESERVE_FRAMES ? frames : BVHIMPORT_MAX_RESERVE_FRAMES));
+
+	for(int frame = 0; frame < frames; ++frame)
+	{
+		char const * pos;
+		char const * end;
+
+		if(!reader.ReadLine(pos, end))
+			return false;
+
+		double cache[6];
+
+		for(int ichan = 0; ichan < 6; ichan++)
+		{
+			ParseSkipBlanks(pos, end);
+
+			if(!ParseDouble(pos, end, cache[channelcode[ichan]]))
+				return false;
+		}
+
+		m_Motion.insert(m_Motion.end(), cache, cache +6);
+	}
 
 	return true;
 }
 
 
-char BvhImport::ms_readbuff[1024];
-
 BvhImport::~BvhImport()
 {
 	CloseMotionFile();
 }
-
-
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <stdio.h>
-#include <windows.h>
+
+#include <vector>
 
 #include "CamPath.h"
 
-/// <remarks> not thread safe, due to ms_readbuff </remarks>
+/// <remarks>
+///   The MOTION section is read completely on load, so no file is kept open
+///   and instances don't share any state.
+/// </remarks>
 class BvhImport
 {
 public:
@@ -28,13 +32,12 @@ private:
 
 	int channelcode[6];
 	bool m_Active;
-	FILE * m_File;
-	double m_Cache[6];
-	int m_Frames;
-	int m_LastFrame;
 	double m_FrameTime;
-	long m_MotionFPos;
-	static char ms_readbuff[1024];
 
-	int DecodeBvhChannel(char * pszRemainder, char * & aoutNewRemainder);
+	/// <summary>6 values per frame, already in BvhChannel_t order.</summary>
+	std::vector<double> m_Motion;
+
+	int DecodeBvhChannel(char const * & inOutPos, char const * end);
+
+	bool ReadMotionFile(FILE * file);
 };
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxByteRing.h>
+
+#include <thread>
+#include <vector>
+
+static std::vector<unsigned char> AfxByteRingTests_ReadAll(CAfxByteRing & ring)
+{
+	unsigned char const * data[2];
+	size_t size[2];
+
+	size_t readable = ring.GetReadable(data, size);
+
+	std::vector<unsigned char> result(data[0], data[0] + size[0]);
+	result.insert(result.end(), data[1], data[1] + size[1]);
+
+	ring.Consume(readable);
+
+	return result;
+}
+
+AFX_TEST(AfxByteRing_WriteAndRead)
+{
+	CAfxByteRing ring(10);
+	AFX_CHECK(16 == ring.GetCapacity());
+
+	unsigned char bytes[16];
+	for (int i = 0; i < 16; ++i) bytes[i] = (unsigned char)i;
+
+	unsigned char const * data[2];
+	size_t size[2];
+
+	AFX_CHECK(ring.Write(bytes, 10));
+	AFX_CHECK(10 == ring.GetWritePosition());
+	AFX_CHECK(0 == ring.GetReadable(data, size)); // Not published yet.
+
+	ring.Publish(6);
+	AFX_CHECK(6 == ring.GetReadable(data, size));
+	AFX_CHECK(6 == size[0] && 0 == size[1]);
+	AFX_CHECK(0 == memcmp(data[0], bytes, 6));
+
+	// Full:
+	AFX_CHECK(!ring.Write(bytes, 7));
+	AFX_CHECK(10 == ring.GetWritePosition());
+
+	ring.Consume(6);
+	AFX_CHECK(0 == ring.GetReadable(data, size));
+
+	// Wraps around:
+	AFX_CHECK(ring.Write(bytes, 12));
+	ring.Publish(ring.GetWritePosition());
+	AFX_CHECK(16 == ring.GetReadable(data, size));
+	AFX_CHECK(10 == size[0] && 6 == size[1]);
+	AFX_CHECK(data[1] < data[0]);
+
+	std::vector<unsigned char> result = AfxByteRingTests_ReadAll(ring);
+	AFX_CHECK(16 == result.size());
+	AFX_CHECK(0 == memcmp(&result[0], bytes + 6, 4));
+	AFX_CHECK(0 == memcmp(&result[4], bytes, 12));
+
+	ring.Reset();
+	AFX_CHECK(0 == ring.GetWritePosition());
+	AFX_CHECK(0 == ring.GetReadable(data, size));
+	AFX_CHECK(ring.Write(bytes, 16));
+}
+
+AFX_TEST(AfxByteRing_Truncate)
+{
+	CAfxByteRing ring(16);
+
+	AFX_CHECK(ring.Write("abc", 3));
+	ring.Publish(3);
+
+	size_t messageStart = ring.GetWritePosition();
+	AFX_CHECK(ring.Write("defg", 4));
+	ring.Truncate(messageStart);
+	AFX_CHECK(3 == ring.GetWritePosition());
+
+	AFX_CHECK(ring.Write("x", 1));
+	ring.Publish(ring.GetWritePosition());
+
+	std::vector<unsigned char> result = AfxByteRingTests_ReadAll(ring);
+	AFX_CHECK(4 == result.size());
+	AFX_CHECK(0 == memcmp(&result[0], "abcx", 4));
+
+	// Truncated bytes free space again:
+	AFX_CHECK(ring.Write("0123456789abcdef", 16));
+	AFX_CHECK(!ring.Write("0", 1));
+	ring.Truncate(4);
+	AFX_CHECK(ring.Write("0", 1));
+}
+
+static void AfxByteRingTests_Consumer(CAfxByteRing * ring, size_t total, std::vector<unsigned char> * outResult)
+{
+	while (outResult->size() < total)
+	{
+		std::vector<unsigned char> result = AfxByteRingTests_ReadAll(*ring);
+
+		if (result.empty())
+			std::this_thread::yield();
+		else
+			outResult->insert(outResult->end(), result.begin(), result.end());
+	}
+}
+
+AFX_TEST(AfxByteRing_Threads)
+{
+	CAfxByteRing ring(256);
+
+	std::vector<unsigned char> expected;
+	for (int i = 0; i < 100000; ++i) expected.push_back((unsigned char)(i * 7 + i / 256));
+
+	std::vector<unsigned char> result;
+	std::thread consumer(AfxByteRingTests_Consumer, &ring, expected.size(), &result);
+
+	size_t written = 0;
+	while (written < expected.size())
+	{
+		size_t size = 1 + written % 61;
+		if (expected.size() - written < size) size = expected.size() - written;
+
+		if (ring.Write(&expected[written], size))
+		{
+			written += size;
+
+			// Publish only every other write, like messages of a frame:
+			if (0 == written % 2 || written == expected.size()) ring.Publish(ring.GetWritePosition());
+		}
+		else
+		{
+			ring.Publish(ring.GetWritePosition());
+			std::this_thread::yield();
+		}
+	}
+
+	consumer.join();
+
+	AFX_CHECK(result == expected);
+}
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxColorLut.h>
+
+static int __stdcall AfxColorLutTests_Invert(float r, float g, float b, float a, float & outR, float & outG, float & outB, float & outA)
+{
+	outR = 1.0f - r;
+	outG = 1.0f - g;
+	outB = 1.0f - b;
+	outA = a;
+	return 1;
+}
+
+static void AfxColorLutTests_CheckInvert(CAfxColorLut & lut)
+{
+	for (int i = 0; i <= 8; ++i)
+	{
+		float value = i / 8.0f;
+		float r, g, b, a;
+
+		AFX_CHECK(lut.Query(value, 0.25f, 1.0f, 0.5f, r, g, b, a));
+
+		AFX_CHECK_NEAR(r, 1.0f - value, 1.0 / 255);
+		AFX_CHECK_NEAR(g, 0.75f, 1.0 / 255);
+		AFX_CHECK_NEAR(b, 0.0f, 1.0 / 255);
+		AFX_CHECK_NEAR(a, 0.5f, 1.0 / 255);
+	}
+}
+
+AFX_TEST(AfxColorLut_IteratePut_Query)
+{
+	CAfxColorLut lut;
+
+	AFX_CHECK(lut.New(5, 5, 5, 3));
+
+	lut.IteratePut(AfxColorLutTests_Invert);
+
+	AfxColorLutTests_CheckInvert(lut);
+}
+
+AFX_TEST(AfxColorLut_SaveLoad)
+{
+	CAfxColorLut lut;
+
+	AFX_CHECK(lut.New(4, 3, 3, 2));
+
+	lut.IteratePut(AfxColorLutTests_Invert);
+
+	FILE * file = tmpfile();
+	AFX_CHECK(nullptr != file);
+	if (nullptr == file) return;
+
+	AFX_CHECK(lut.SaveToFile(file));
+
+	rewind(file);
+
+	CAfxColorLut loaded;
+	AFX_CHECK(loaded.LoadFromFile(file));
+
+	fclose(file);
+
+	AfxColorLutTests_CheckInvert(loaded);
+}
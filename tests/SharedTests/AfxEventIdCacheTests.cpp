@@ -0,0 +1,67 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxEventIdCache.h>
+
+#include <string>
+
+// Like CAfxGameEventListenerSerialzer (AfxHookSource/csgo_GameEvents.cpp)
+// uses it, the identities stand in for the game event descriptors' keys.
+
+AFX_TEST(AfxEventIdCache_MadeOnce)
+{
+	CAfxEventIdCache<std::string> cache;
+	int keys;
+	bool stale;
+
+	std::string & value = cache.Get(3, "player_death", &keys, stale);
+	AFX_CHECK(stale);
+	AFX_CHECK(value.empty());
+	value = "plan";
+
+	AFX_CHECK("plan" == cache.Get(3, "player_death", &keys, stale));
+	AFX_CHECK(!stale);
+
+	// Other ids don't affect it:
+	cache.Get(40, "player_hurt", &keys, stale);
+	AFX_CHECK(stale);
+	AFX_CHECK("plan" == cache.Get(3, "player_death", &keys, stale));
+	AFX_CHECK(!stale);
+}
+
+AFX_TEST(AfxEventIdCache_IdsReassigned)
+{
+	CAfxEventIdCache<std::string> cache;
+	int oldKeys;
+	int newKeys;
+	bool stale;
+
+	cache.Get(3, "player_death", &oldKeys, stale) = "player_death plan";
+
+	// A new game event list (new server or demo) assigns the id to another event:
+	std::string & value = cache.Get(3, "player_hurt", &newKeys, stale);
+	AFX_CHECK(stale);
+	AFX_CHECK(value.empty());
+	value = "player_hurt plan";
+
+	// Same name, but the event got described again (its keys might differ):
+	AFX_CHECK(cache.Get(3, "player_hurt", &oldKeys, stale).empty());
+	AFX_CHECK(stale);
+}
+
+AFX_TEST(AfxEventIdCache_Clear)
+{
+	CAfxEventIdCache<bool> cache;
+	int keys;
+	bool stale;
+
+	cache.Get(0, "round_start", &keys, stale) = true;
+	AFX_CHECK(cache.Get(0, "round_start", &keys, stale));
+	AFX_CHECK(!stale);
+
+	cache.Clear();
+
+	AFX_CHECK(!cache.Get(0, "round_start", &keys, stale));
+	AFX_CHECK(stale);
+}
@@ -0,0 +1,107 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxFileCache.h>
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Like CamImportFile (AfxHookSource/CamIO.cpp) uses it, the values stand in
+// for the mapped and indexed .cam files.
+
+struct CAfxFileCacheTestsFile
+{
+	std::string Content;
+};
+
+static void AfxFileCacheTests_Write(char const * fileName, char const * content)
+{
+	if (FILE * file = fopen(fileName, "wb"))
+	{
+		fputs(content, file);
+		fclose(file);
+	}
+}
+
+static CAfxFileCacheTestsFile * AfxFileCacheTests_Import(CAfxFileCache<CAfxFileCacheTestsFile> & cache, std::vector<std::unique_ptr<CAfxFileCacheTestsFile>> & files, char const * fileName)
+{
+	if (CAfxFileCacheTestsFile * file = cache.Find(fileName))
+		return file;
+
+	AfxFileIdentity identity;
+	if (!AfxFileIdentity_Get(fileName, identity))
+		return nullptr;
+
+	CAfxFileCacheTestsFile * file = new CAfxFileCacheTestsFile();
+	files.emplace_back(file);
+
+	if (FILE * pFile = fopen(fileName, "rb"))
+	{
+		char buffer[256];
+		size_t size = fread(buffer, 1, sizeof(buffer), pFile);
+		file->Content.assign(buffer, size);
+		fclose(pFile);
+	}
+
+	cache.Add(fileName, identity, file);
+
+	return file;
+}
+
+AFX_TEST(AfxFileCache_Overwritten)
+{
+	CAfxFileCache<CAfxFileCacheTestsFile> cache;
+	std::vector<std::unique_ptr<CAfxFileCacheTestsFile>> files;
+
+	AfxFileCacheTests_Write("SharedTests_filecache.cam", "first");
+
+	CAfxFileCacheTestsFile * first = AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam");
+	AFX_CHECK(first && "first" == first->Content);
+
+	// Shared while unchanged:
+	AFX_CHECK(first == AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam"));
+
+	// I.e. a new export to the same file:
+	AfxFileCacheTests_Write("SharedTests_filecache.cam", "second export");
+
+	CAfxFileCacheTestsFile * second = AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam");
+	AFX_CHECK(second && second != first && "second export" == second->Content);
+	AFX_CHECK(second == AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam"));
+
+	// The old value's owner going away doesn't remove the new one:
+	cache.Remove("SharedTests_filecache.cam", first);
+	AFX_CHECK(second == cache.Find("SharedTests_filecache.cam"));
+
+	cache.Remove("SharedTests_filecache.cam", second);
+	AFX_CHECK(nullptr == cache.Find("SharedTests_filecache.cam"));
+
+	remove("SharedTests_filecache.cam");
+}
+
+AFX_TEST(AfxFileCache_Replaced)
+{
+	CAfxFileCache<CAfxFileCacheTestsFile> cache;
+	std::vector<std::unique_ptr<CAfxFileCacheTestsFile>> files;
+
+	AfxFileCacheTests_Write("SharedTests_filecache.cam", "aaaa");
+
+	CAfxFileCacheTestsFile * first = AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam");
+	AFX_CHECK(first && "aaaa" == first->Content);
+
+	// Same size, but another file moved in its place:
+	AfxFileCacheTests_Write("SharedTests_filecache.tmp", "bbbb");
+	remove("SharedTests_filecache.cam");
+	AFX_CHECK(0 == rename("SharedTests_filecache.tmp", "SharedTests_filecache.cam"));
+
+	CAfxFileCacheTestsFile * second = AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam");
+	AFX_CHECK(second && second != first && "bbbb" == second->Content);
+
+	// Gone:
+	remove("SharedTests_filecache.cam");
+	AFX_CHECK(nullptr == cache.Find("SharedTests_filecache.cam"));
+	AFX_CHECK(nullptr == AfxFileCacheTests_Import(cache, files, "SharedTests_filecache.cam"));
+}
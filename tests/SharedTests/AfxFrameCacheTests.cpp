@@ -0,0 +1,250 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxFrameCache.h>
+
+#include <vector>
+
+// Synthetic stand-in for the mirv_calcs nodes (AfxHookSource/MirvCalcs.cpp),
+// which can't be built without the Source SDK: CalcValue returns the result
+// cached for the frame, DoCalcValue adds the node's parameter to the values
+// of its parents.
+
+class CAfxFrameCacheTestNode
+{
+public:
+	CAfxFrameCacheTestNode(CAfxFrameCacheClock & clock, double param)
+		: m_Clock(clock)
+		, m_Param(param)
+		, m_Volatile(false)
+		, m_DoCalcs(0)
+	{
+	}
+
+	bool CalcValue(double & outValue)
+	{
+		return m_Cache.Get(m_Clock, outValue, [this](double & outValue) {
+			return DoCalcValue(outValue);
+		});
+	}
+
+	void AddParent(CAfxFrameCacheTestNode * parent)
+	{
+		m_Parents.push_back(parent);
+		m_Clock.Invalidate();
+	}
+
+	/// <summary>Like editing a calc with mirv_calcs.</summary>
+	void SetParam(double value)
+	{
+		m_Param = value;
+		m_Clock.Invalidate();
+	}
+
+	void SetVolatile(bool value)
+	{
+		m_Volatile = value;
+		m_Clock.Invalidate();
+	}
+
+	unsigned int GetDoCalcs(void) const
+	{
+		return m_DoCalcs;
+	}
+
+private:
+	CAfxFrameCacheClock & m_Clock;
+	std::vector<CAfxFrameCacheTestNode *> m_Parents;
+	double m_Param;
+	bool m_Volatile;
+	unsigned int m_DoCalcs;
+	CAfxFrameCached<double> m_Cache;
+
+	bool DoCalcValue(double & outValue)
+	{
+		++m_DoCalcs;
+
+		if (m_Volatile) m_Clock.MarkVolatile();
+
+		double value = m_Param;
+
+		for (size_t i = 0; i < m_Parents.size(); ++i)
+		{
+			double parentValue;
+			if (!m_Parents[i]->CalcValue(parentValue)) return false;
+			value += parentValue;
+		}
+
+		outValue = value;
+		return true;
+	}
+};
+
+/// <summary>Layers of nodes, each node reads two nodes of the layer below.</summary>
+class CAfxFrameCacheTestDag
+{
+public:
+	CAfxFrameCacheTestDag(CAfxFrameCacheClock & clock, size_t layers, size_t width)
+		: m_Width(width)
+	{
+		for (size_t layer = 0; layer < layers; ++layer)
+		{
+			for (size_t i = 0; i < width; ++i)
+			{
+				CAfxFrameCacheTestNode * node = new CAfxFrameCacheTestNode(clock, 1);
+
+				if (0 < layer)
+				{
+					node->AddParent(GetNode(layer - 1, i));
+					node->AddParent(GetNode(layer - 1, (i + 1) % width));
+				}
+
+				m_Nodes.push_back(node);
+			}
+		}
+	}
+
+	~CAfxFrameCacheTestDag()
+	{
+		for (size_t i = 0; i < m_Nodes.size(); ++i) delete m_Nodes[i];
+	}
+
+	CAfxFrameCacheTestNode * GetNode(size_t layer, size_t i)
+	{
+		return m_Nodes[layer * m_Width + i];
+	}
+
+	size_t GetSize(void) const
+	{
+		return m_Nodes.size();
+	}
+
+	/// <summary>Asks each node for its value once, like the consumers of the calcs do.</summary>
+	double CalcAll(void)
+	{
+		double sum = 0;
+
+		for (size_t i = 0; i < m_Nodes.size(); ++i)
+		{
+			double value;
+			if (m_Nodes[i]->CalcValue(value)) sum += value;
+		}
+
+		return sum;
+	}
+
+private:
+	size_t m_Width;
+	std::vector<CAfxFrameCacheTestNode *> m_Nodes;
+};
+
+AFX_TEST(AfxFrameCache_Dag_OncePerFrame)
+{
+	CAfxFrameCacheClock clock;
+	CAfxFrameCacheTestDag dag(clock, 10, 32);
+
+	clock.SetEnabled(false);
+	clock.BeginFrame();
+	double uncachedSum = dag.CalcAll();
+	clock.EndFrame();
+
+	unsigned int uncachedEvaluations = clock.GetEvaluations();
+
+	clock.SetEnabled(true);
+
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		clock.BeginFrame();
+		AFX_CHECK_NEAR(uncachedSum, dag.CalcAll(), 0.0001);
+		AFX_CHECK_NEAR(uncachedSum, dag.CalcAll(), 0.0001);
+		clock.EndFrame();
+
+		AFX_CHECK(dag.GetSize() == clock.GetEvaluations());
+	}
+
+	// A node in layer d (counting from 0) reads 2^(d+1) - 1 nodes when not cached:
+	AFX_CHECK(32 * (2046 - 10) == uncachedEvaluations);
+
+	clock.BeginFrame();
+	AFX_CHECK(dag.GetSize() == clock.GetLastEvaluations());
+	// Nodes read their parents in the first pass and each other in the second:
+	AFX_CHECK(2 * (dag.GetSize() - 32) + dag.GetSize() == clock.GetLastHits());
+	clock.EndFrame();
+}
+
+AFX_TEST(AfxFrameCache_Dag_Invalidate)
+{
+	CAfxFrameCacheClock clock;
+	CAfxFrameCacheTestDag dag(clock, 4, 4);
+
+	clock.BeginFrame();
+
+	double value = 0;
+	AFX_CHECK(dag.GetNode(3, 0)->CalcValue(value));
+	AFX_CHECK_NEAR(1 + 2 + 4 + 8, value, 0.0001);
+
+	// Editing a parent mid frame must not leave stale results in the dependents:
+	dag.GetNode(0, 1)->SetParam(2);
+
+	AFX_CHECK(dag.GetNode(3, 0)->CalcValue(value));
+	AFX_CHECK_NEAR(1 + 2 + 4 + 8 + 3, value, 0.0001);
+
+	unsigned int doCalcs = dag.GetNode(3, 0)->GetDoCalcs();
+	AFX_CHECK(dag.GetNode(3, 0)->CalcValue(value));
+	AFX_CHECK(doCalcs == dag.GetNode(3, 0)->GetDoCalcs());
+
+	clock.EndFrame();
+}
+
+AFX_TEST(AfxFrameCache_OutsideFrame)
+{
+	CAfxFrameCacheClock clock;
+	CAfxFrameCacheTestNode node(clock, 1);
+
+	double value;
+	AFX_CHECK(node.CalcValue(value));
+	AFX_CHECK(node.CalcValue(value));
+	AFX_CHECK(2 == node.GetDoCalcs());
+
+	clock.BeginFrame();
+	AFX_CHECK(node.CalcValue(value));
+	clock.EndFrame();
+
+	AFX_CHECK(node.CalcValue(value));
+	AFX_CHECK(4 == node.GetDoCalcs());
+}
+
+AFX_TEST(AfxFrameCache_Volatile)
+{
+	CAfxFrameCacheClock clock;
+
+	CAfxFrameCacheTestNode view(clock, 1);
+	CAfxFrameCacheTestNode constant(clock, 2);
+	CAfxFrameCacheTestNode dependent(clock, 0);
+	dependent.AddParent(&view);
+	dependent.AddParent(&constant);
+	CAfxFrameCacheTestNode independent(clock, 0);
+	independent.AddParent(&constant);
+
+	view.SetVolatile(true);
+
+	clock.BeginFrame();
+
+	double value = 0;
+	for (int i = 0; i < 2; ++i)
+	{
+		AFX_CHECK(dependent.CalcValue(value));
+		AFX_CHECK_NEAR(3, value, 0.0001);
+		AFX_CHECK(independent.CalcValue(value));
+		AFX_CHECK_NEAR(2, value, 0.0001);
+	}
+
+	// The volatile node and whoever reads it are evaluated each time, the rest once:
+	AFX_CHECK(2 == view.GetDoCalcs());
+	AFX_CHECK(2 == dependent.GetDoCalcs());
+	AFX_CHECK(1 == constant.GetDoCalcs());
+	AFX_CHECK(1 == independent.GetDoCalcs());
+
+	clock.EndFrame();
+}
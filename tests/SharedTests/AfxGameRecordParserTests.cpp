@@ -0,0 +1,449 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxGameRecordParser.h>
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+#define AFXGAMERECORDPARSERTESTS_BONES 10
+
+static void AfxGameRecordParserTests_WriteFile(wchar_t const * fileName, int version, int frames)
+{
+	CAfxGameRecordWriter writer;
+	if (!writer.Open(fileName, version)) return;
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		writer.WriteDictionary("afxFrame");
+		writer.Write(frame / 64.0f);
+		size_t hiddenOffset = writer.GetOffset();
+		writer.Write((int)0);
+
+		for (int entity = 1; entity <= 3; ++entity)
+		{
+			writer.WriteDictionary("entity_state");
+			writer.Write(entity);
+
+			writer.WriteDictionary("baseentity");
+			writer.WriteDictionary(1 == entity ? "models/player.mdl" : "models/weapon.mdl");
+			writer.Write(true);
+			float origin[6] = { (float)frame, (float)entity, 3.0f, 0.0f, 90.0f, 0.0f };
+			writer.Write(origin, 6);
+
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.BeginBones(entity, AFXGAMERECORDPARSERTESTS_BONES);
+			for (int bone = 0; bone < AFXGAMERECORDPARSERTESTS_BONES; ++bone)
+			{
+				float position[3] = { (float)frame, (float)bone, 0.25f * entity };
+				float rotation[4] = { 0, 0, 0, 1 };
+				writer.WriteBone(position, rotation);
+			}
+
+			if (1 == entity)
+			{
+				writer.WriteDictionary("camera");
+				writer.Write(false);
+				float eye[7] = { (float)frame, 0, 64, 0, 0, 0, 90 };
+				writer.Write(eye, 7);
+			}
+
+			writer.WriteDictionary("/");
+			writer.Write(3 == entity);
+		}
+
+		float cam[7] = { 1, 2, 3, 4, 5, 6, (float)frame };
+		writer.WriteDictionary("afxCam");
+		writer.Write(cam, 7);
+
+		writer.WriteDictionary("afxHidden");
+		writer.PatchInt(hiddenOffset, (int)(writer.GetOffset() - hiddenOffset));
+		writer.Write((int)1);
+		writer.Write(frame);
+
+		writer.WriteDictionary("afxFrameEnd");
+		writer.EndFrame();
+
+		// Deletions are recorded between frames:
+		if (0 == frame % 10)
+		{
+			writer.WriteDictionary("deleted");
+			writer.Write(1000 + frame);
+		}
+	}
+
+	writer.Close();
+}
+
+/// <summary>Checks the visited records against what AfxGameRecordParserTests_WriteFile wrote.</summary>
+class CAfxGameRecordParserTestsVisitor : public IAfxGameRecordVisitor
+{
+public:
+	int NextFrame;
+	int Frames = 0;
+	int Entities = 0;
+	int Deleted = 0;
+	bool Ok = true;
+
+	/// <param name="frameOffset">Difference between the written and the visited frame numbers.</param>
+	CAfxGameRecordParserTestsVisitor(int firstFrame, int frameOffset = 0)
+	: NextFrame(firstFrame)
+	, m_FrameOffset(frameOffset)
+	{
+	}
+
+	virtual void OnFrame(int frame, float frameTime)
+	{
+		Check(frame + m_FrameOffset == NextFrame && frameTime == NextFrame / 64.0f);
+		m_Entity = 1;
+	}
+
+	virtual void OnCamera(float const * values)
+	{
+		Check(values[0] == 1 && values[6] == (float)NextFrame);
+	}
+
+	virtual void OnEntity(AfxGameRecordEntity const & entity)
+	{
+		++Entities;
+
+		Check(entity.Handle == m_Entity && entity.HasBaseEntity && entity.Visible && entity.HasBaseAnimating && entity.HasBoneList);
+		Check(0 == strcmp(entity.ModelName, 1 == m_Entity ? "models/player.mdl" : "models/weapon.mdl"));
+		Check(entity.RenderOrigin[0] == (float)NextFrame && entity.RenderOrigin[1] == (float)m_Entity && entity.RenderAngles[1] == 90.0f);
+		Check(entity.NumBones == AFXGAMERECORDPARSERTESTS_BONES);
+		Check(entity.HasCamera == (1 == m_Entity) && entity.ViewModel == (3 == m_Entity));
+
+		if (entity.HasCamera)
+			Check(!entity.ThirdPerson && entity.EyePosition[0] == (float)NextFrame && entity.EyePosition[2] == 64 && entity.Fov == 90);
+
+		for (int bone = 0; bone < entity.NumBones; ++bone)
+		{
+			Check(entity.BonePositions[3 * bone + 0] == (float)NextFrame && entity.BonePositions[3 * bone + 1] == (float)bone && entity.BonePositions[3 * bone + 2] == 0.25f * m_Entity);
+			Check(entity.BoneRotations[4 * bone + 3] == 1.0f);
+		}
+
+		++m_Entity;
+	}
+
+	virtual void OnDeleted(int handle)
+	{
+		++Deleted;
+
+		Check(handle == 1000 + NextFrame - 1);
+	}
+
+	virtual void OnHidden(int count, int const * handles)
+	{
+		Check(1 == count && handles[0] == NextFrame);
+	}
+
+	virtual void OnFrameEnd(int frame)
+	{
+		Check(frame + m_FrameOffset == NextFrame && 4 == m_Entity);
+		++NextFrame;
+		++Frames;
+	}
+
+private:
+	int m_FrameOffset;
+	int m_Entity = 1;
+
+	void Check(bool value)
+	{
+		if (!value) Ok = false;
+	}
+};
+
+AFX_TEST(AfxGameRecordParser_Parse)
+{
+	int versions[2] = { AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		int frames = 2 * AFXGAMERECORD_BLOCK_FRAMES + 5;
+
+		AfxGameRecordParserTests_WriteFile(L"SharedTests_parser.agr", versions[i], frames);
+
+		CAfxGameRecordParser parser;
+		AFX_CHECK(parser.Open(L"SharedTests_parser.agr"));
+		AFX_CHECK(parser.GetVersion() == versions[i]);
+		AFX_CHECK(parser.GetFrameCount() == (AFXGAMERECORD_VERSION_COMPRESSED == versions[i] ? frames : -1));
+
+		CAfxGameRecordParserTestsVisitor visitor(0);
+		AFX_CHECK(parser.Parse(&visitor));
+		AFX_CHECK(visitor.Ok);
+		AFX_CHECK(visitor.Frames == frames);
+		AFX_CHECK(visitor.Entities == 3 * frames);
+		AFX_CHECK(visitor.Deleted == (frames + 9) / 10);
+
+		// Parsing again (validation only) works the same:
+		AFX_CHECK(parser.Parse(0));
+
+		parser.Close();
+	}
+
+	remove("SharedTests_parser.agr");
+
+	CAfxGameRecordParser parser;
+	AFX_CHECK(!parser.Open(L"SharedTests_does_not_exist.agr"));
+}
+
+AFX_TEST(AfxGameRecordParser_Slice)
+{
+	int versions[2] = { AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		int frames = 3 * AFXGAMERECORD_BLOCK_FRAMES;
+
+		AfxGameRecordParserTests_WriteFile(L"SharedTests_parser.agr", versions[i], frames);
+
+		CAfxGameRecordParser parser;
+		AFX_CHECK(parser.Open(L"SharedTests_parser.agr"));
+
+		// Mid block and across a block boundary:
+		{
+			CAfxGameRecordParserTestsVisitor visitor(AFXGAMERECORD_BLOCK_FRAMES + 60);
+			AFX_CHECK(parser.Parse(&visitor, AFXGAMERECORD_BLOCK_FRAMES + 60, 10));
+			AFX_CHECK(visitor.Ok);
+			AFX_CHECK(visitor.Frames == 10);
+		}
+
+		// The last frame and past the end:
+		{
+			CAfxGameRecordParserTestsVisitor visitor(frames - 1);
+			AFX_CHECK(parser.Parse(&visitor, frames - 1));
+			AFX_CHECK(visitor.Ok);
+			AFX_CHECK(visitor.Frames == 1);
+			AFX_CHECK(!parser.Parse(0, frames));
+		}
+
+		// Write a slice in the other version and read it back:
+		{
+			CAfxGameRecordWriter writer;
+			AFX_CHECK(writer.Open(L"SharedTests_parser_slice.agr", AFXGAMERECORD_VERSION_RAW == versions[i] ? AFXGAMERECORD_VERSION_COMPRESSED : AFXGAMERECORD_VERSION_RAW));
+
+			CAfxGameRecordWriteVisitor writeVisitor(writer);
+			AFX_CHECK(parser.Parse(&writeVisitor, 21, AFXGAMERECORD_BLOCK_FRAMES));
+			AFX_CHECK(writer.Close());
+
+			CAfxGameRecordParser sliceParser;
+			AFX_CHECK(sliceParser.Open(L"SharedTests_parser_slice.agr"));
+
+			// Frame numbers start at 0 again and the deletion before frame 21 is kept:
+			CAfxGameRecordParserTestsVisitor visitor(21, 21);
+			AFX_CHECK(sliceParser.Parse(&visitor));
+			AFX_CHECK(visitor.Ok);
+			AFX_CHECK(visitor.Frames == AFXGAMERECORD_BLOCK_FRAMES);
+			AFX_CHECK(visitor.Deleted == 7);
+		}
+
+		parser.Close();
+	}
+
+	remove("SharedTests_parser.agr");
+	remove("SharedTests_parser_slice.agr");
+}
+
+AFX_TEST(AfxGameRecordParser_InvalidData)
+{
+	int versions[2] = { AFXGAMERECORD_VERSION_RAW, AFXGAMERECORD_VERSION_COMPRESSED };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		AfxGameRecordParserTests_WriteFile(L"SharedTests_parser.agr", versions[i], 10);
+
+		std::vector<char> data;
+		{
+			FILE * file = fopen("SharedTests_parser.agr", "rb");
+			AFX_CHECK(file);
+			char buffer[4096];
+			size_t read;
+			while (0 < (read = fread(buffer, 1, sizeof(buffer), file))) data.insert(data.end(), buffer, buffer + read);
+			fclose(file);
+		}
+
+		// Truncated in the middle of the frames (also cuts the index off):
+		{
+			FILE * file = fopen("SharedTests_parser.agr", "wb");
+			AFX_CHECK(file);
+			fwrite(&data[0], 1, data.size() / 2, file);
+			fclose(file);
+		}
+
+		CAfxGameRecordParser parser;
+		AFX_CHECK(parser.Open(L"SharedTests_parser.agr"));
+		AFX_CHECK(!parser.Parse(0));
+		parser.Close();
+
+		// Not an AGR:
+		{
+			FILE * file = fopen("SharedTests_parser.agr", "wb");
+			AFX_CHECK(file);
+			fwrite("afxGameRecorX\0\5\0\0\0", 1, 18, file);
+			fclose(file);
+		}
+
+		AFX_CHECK(!parser.Open(L"SharedTests_parser.agr"));
+	}
+
+	remove("SharedTests_parser.agr");
+}
+
+/// <summary>Entity 1 moves, entity 2 is static, entity 3 jitters by 0.001 and is deleted and re-created in frame 50.</summary>
+static void AfxGameRecordParserTests_WriteUnchangedFile(wchar_t const * fileName, float threshold, int frames, CAfxGameRecordWriter & writer)
+{
+	writer.SetUnchangedThreshold(threshold);
+	if (!writer.Open(fileName, AFXGAMERECORD_VERSION_COMPRESSED)) return;
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		writer.WriteDictionary("afxFrame");
+		writer.Write(frame / 64.0f);
+		writer.Write((int)0);
+
+		for (int entity = 1; entity <= 3; ++entity)
+		{
+			float value = 1 == entity ? (float)frame : 3 == entity ? (50 <= frame ? 100.0f : 0.0f) + 0.001f * (frame % 2) : 0.0f;
+
+			writer.BeginEntity(entity);
+			writer.WriteDictionary("baseentity");
+			writer.WriteDictionary("models/player.mdl");
+			writer.Write(true);
+			float origin[6] = { value, (float)entity, 3.0f, 0.0f, 90.0f, 0.0f };
+			writer.Write(origin, 6);
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.BeginBones(entity, AFXGAMERECORDPARSERTESTS_BONES);
+			for (int bone = 0; bone < AFXGAMERECORDPARSERTESTS_BONES; ++bone)
+			{
+				float position[3] = { value, (float)bone, 0 };
+				float rotation[4] = { 0, 0, 0, 1 };
+				writer.WriteBone(position, rotation);
+			}
+			writer.WriteDictionary("/");
+			writer.Write(false);
+			writer.EndEntity();
+		}
+
+		writer.WriteDictionary("afxFrameEnd");
+		writer.EndFrame();
+
+		if (49 == frame)
+			writer.WriteDeleted(3);
+	}
+
+	writer.Close();
+}
+
+/// <summary>Collects the RenderOrigin[0] (and checks it's the same for the bones, within the quantization) of the entities per frame.</summary>
+class CAfxGameRecordParserTestsUnchangedVisitor : public IAfxGameRecordVisitor
+{
+public:
+	std::vector<float> Values;
+	bool Ok = true;
+
+	virtual void OnFrame(int /*frame*/, float /*frameTime*/) {}
+	virtual void OnCamera(float const * /*values*/) {}
+
+	virtual void OnEntity(AfxGameRecordEntity const & entity)
+	{
+		Values.push_back(entity.RenderOrigin[0]);
+
+		if (entity.NumBones != AFXGAMERECORDPARSERTESTS_BONES || 0.5 / 1024 < fabs(entity.BonePositions[3 * (entity.NumBones - 1)] - entity.RenderOrigin[0]) || 0 != strcmp(entity.ModelName, "models/player.mdl"))
+			Ok = false;
+	}
+
+	virtual void OnDeleted(int /*handle*/) {}
+	virtual void OnHidden(int /*count*/, int const * /*handles*/) {}
+	virtual void OnFrameEnd(int /*frame*/) {}
+};
+
+AFX_TEST(AfxGameRecordParser_Unchanged)
+{
+	int frames = 2 * AFXGAMERECORD_BLOCK_FRAMES + 10;
+
+	// Exact (default): Only entity 2 and every 2nd state of entity 3 can't be elided, except at block starts:
+	{
+		CAfxGameRecordWriter writer;
+		AfxGameRecordParserTests_WriteUnchangedFile(L"SharedTests_parser.agr", 0, frames, writer);
+
+		AFX_CHECK(writer.GetEntityCount() == 3 * frames);
+		AFX_CHECK(writer.GetUnchangedCount() == frames - 3);
+		AFX_CHECK(0 < writer.GetUnchangedBytesSaved());
+
+		CAfxGameRecordParser parser;
+		CAfxGameRecordParserTestsUnchangedVisitor visitor;
+		AFX_CHECK(parser.Open(L"SharedTests_parser.agr"));
+		AFX_CHECK(parser.Parse(&visitor));
+		AFX_CHECK(visitor.Ok);
+		AFX_CHECK(visitor.Values.size() == 3 * (size_t)frames);
+
+		for (int frame = 0; frame < frames && visitor.Values.size() == 3 * (size_t)frames; ++frame)
+		{
+			AFX_CHECK(visitor.Values[3 * frame + 0] == (float)frame);
+			AFX_CHECK(visitor.Values[3 * frame + 1] == 0.0f);
+			AFX_CHECK(visitor.Values[3 * frame + 2] == (50 <= frame ? 100.0f : 0.0f) + 0.001f * (frame % 2));
+		}
+
+		// Seeking into the block after the first one:
+		CAfxGameRecordParserTestsUnchangedVisitor seekVisitor;
+		AFX_CHECK(parser.Parse(&seekVisitor, AFXGAMERECORD_BLOCK_FRAMES + 3, 2));
+		AFX_CHECK(seekVisitor.Ok);
+		AFX_CHECK(seekVisitor.Values.size() == 6);
+
+		// Version 5 has no entity_unchanged, so they are expanded:
+		AFX_CHECK(AfxGameRecordConvert(L"SharedTests_parser.agr", L"SharedTests_parser5.agr", AFXGAMERECORD_VERSION_RAW));
+		// Version 5 is not compressed, so the token would show up in the dictionary:
+		{
+			std::string data;
+			FILE * file = fopen("SharedTests_parser5.agr", "rb");
+			AFX_CHECK(file);
+			char buffer[4096];
+			size_t read;
+			while (file && 0 < (read = fread(buffer, 1, sizeof(buffer), file))) data.append(buffer, read);
+			if (file) fclose(file);
+			AFX_CHECK(std::string::npos != data.find("entity_state"));
+			AFX_CHECK(std::string::npos == data.find("entity_unchanged"));
+		}
+
+		CAfxGameRecordParser parser5;
+		CAfxGameRecordParserTestsUnchangedVisitor visitor5;
+		AFX_CHECK(parser5.Open(L"SharedTests_parser5.agr"));
+		AFX_CHECK(parser5.Parse(&visitor5));
+		AFX_CHECK(visitor5.Values == visitor.Values);
+	}
+
+	// With a threshold the jitter of entity 3 is elided too:
+	{
+		CAfxGameRecordWriter writer;
+		AfxGameRecordParserTests_WriteUnchangedFile(L"SharedTests_parser.agr", 0.01f, frames, writer);
+
+		// Written: 3 per block start, entity 1 every frame, entity 3 after it was re-created.
+		AFX_CHECK(writer.GetUnchangedCount() == 3 * frames - (frames + 2 * 3 + 1));
+
+		CAfxGameRecordParser parser;
+		CAfxGameRecordParserTestsUnchangedVisitor visitor;
+		AFX_CHECK(parser.Open(L"SharedTests_parser.agr"));
+		AFX_CHECK(parser.Parse(&visitor));
+		AFX_CHECK(visitor.Ok);
+		AFX_CHECK(visitor.Values.size() == 3 * (size_t)frames);
+		AFX_CHECK(visitor.Values[3 * 1 + 2] == 0.0f);
+		AFX_CHECK(visitor.Values[3 * 51 + 2] == 100.0f);
+	}
+
+	// Disabled (default):
+	{
+		CAfxGameRecordWriter writer;
+		AFX_CHECK(writer.GetUnchangedThreshold() < 0);
+		AfxGameRecordParserTests_WriteUnchangedFile(L"SharedTests_parser.agr", writer.GetUnchangedThreshold(), frames, writer);
+
+		AFX_CHECK(0 == writer.GetUnchangedCount());
+	}
+
+	remove("SharedTests_parser.agr");
+	remove("SharedTests_parser5.agr");
+}
@@ -0,0 +1,335 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxGameRecord.h>
+#include <shared/AfxGameRecordParser.h>
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+#define AFXGAMERECORDTESTS_BONES 20
+
+static void AfxGameRecordTests_GetBone(int frame, int entity, int bone, float outPosition[3], float outRotation[4])
+{
+	outPosition[0] = 100.0f * entity + 0.37f * frame + bone;
+	outPosition[1] = -2000.0f + 1.5f * bone - 0.01f * frame * frame;
+	outPosition[2] = 64.125f;
+
+	double angle = 0.05 * frame + 0.3 * bone + entity;
+	double axis[3] = { 0.6, -0.48, 0.64 };
+	double s = sin(angle / 2);
+
+	outRotation[0] = (float)(axis[0] * s);
+	outRotation[1] = (float)(axis[1] * s);
+	outRotation[2] = (float)(axis[2] * s);
+	outRotation[3] = (float)cos(angle / 2);
+}
+
+static void AfxGameRecordTests_WriteFile(wchar_t const * fileName, int version, int frames)
+{
+	CAfxGameRecordWriter writer;
+	if (!writer.Open(fileName, version)) return;
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		writer.WriteDictionary("afxFrame");
+		writer.Write(1.0f / 30);
+		size_t hiddenOffset = writer.GetOffset();
+		writer.Write((int)0);
+
+		for (int entity = 1; entity <= 3; ++entity)
+		{
+			writer.WriteDictionary("entity_state");
+			writer.Write(entity);
+
+			writer.WriteDictionary("baseentity");
+			writer.WriteDictionary(1 == entity ? "models/player.mdl" : "models/weapon.mdl");
+			writer.Write(true);
+			float origin[6] = { (float)frame, 2.0f, 3.0f, 0.0f, 90.0f, 0.0f };
+			writer.Write(origin, 6);
+
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.BeginBones(entity, AFXGAMERECORDTESTS_BONES);
+			for (int bone = 0; bone < AFXGAMERECORDTESTS_BONES; ++bone)
+			{
+				float position[3];
+				float rotation[4];
+				AfxGameRecordTests_GetBone(frame, entity, bone, position, rotation);
+				writer.WriteBone(position, rotation);
+			}
+
+			writer.WriteDictionary("/");
+			writer.Write(false);
+		}
+
+		writer.WriteDictionary("afxHidden");
+		writer.PatchInt(hiddenOffset, (int)(writer.GetOffset() - hiddenOffset));
+		writer.Write((int)1);
+		writer.Write((int)42);
+
+		writer.WriteDictionary("afxFrameEnd");
+		writer.EndFrame();
+	}
+
+	writer.Close();
+}
+
+static bool AfxGameRecordTests_ReadFrames(CAfxGameRecordReader & reader, int firstFrame, int frames, double positionTolerance, double rotationTolerance)
+{
+	std::string token;
+	std::vector<float> positions;
+	std::vector<float> rotations;
+
+	for (int frame = firstFrame; frame < firstFrame + frames; ++frame)
+	{
+		float frameTime;
+		int hiddenOffset;
+		if (!reader.ReadDictionary(token) || token != "afxFrame" || !reader.Read(frameTime) || !reader.Read(hiddenOffset))
+			return false;
+
+		// Offset from the placeholder to the afxHidden token:
+		if (hiddenOffset <= 0)
+			return false;
+
+		for (int entity = 1; entity <= 3; ++entity)
+		{
+			int handle;
+			bool visible;
+			float origin[6];
+			bool hasBones;
+			bool viewModel;
+
+			if (!reader.ReadDictionary(token) || token != "entity_state" || !reader.Read(handle) || handle != entity)
+				return false;
+
+			if (!reader.ReadDictionary(token) || token != "baseentity" || !reader.ReadDictionary(token) || token != (1 == entity ? "models/player.mdl" : "models/weapon.mdl"))
+				return false;
+
+			if (!reader.Read(visible) || !visible || !reader.Read(origin, 6) || origin[0] != (float)frame || origin[4] != 90.0f)
+				return false;
+
+			if (!reader.ReadDictionary(token) || token != "baseanimating" || !reader.Read(hasBones) || !hasBones)
+				return false;
+
+			if (!reader.ReadBones(handle, positions, rotations) || positions.size() != 3 * AFXGAMERECORDTESTS_BONES || rotations.size() != 4 * AFXGAMERECORDTESTS_BONES)
+				return false;
+
+			for (int bone = 0; bone < AFXGAMERECORDTESTS_BONES; ++bone)
+			{
+				float position[3];
+				float rotation[4];
+				AfxGameRecordTests_GetBone(frame, entity, bone, position, rotation);
+
+				for (int i = 0; i < 3; ++i)
+				{
+					if (positionTolerance < fabs(positions[3 * bone + i] - position[i]))
+						return false;
+				}
+
+				// q and -q are the same rotation:
+				double dot = 0;
+				for (int i = 0; i < 4; ++i) dot += rotations[4 * bone + i] * rotation[i];
+				double sign = dot < 0 ? -1 : 1;
+
+				for (int i = 0; i < 4; ++i)
+				{
+					if (rotationTolerance < fabs(sign * rotations[4 * bone + i] - rotation[i]))
+						return false;
+				}
+			}
+
+			if (!reader.ReadDictionary(token) || token != "/" || !reader.Read(viewModel) || viewModel)
+				return false;
+		}
+
+		int count;
+		int hidden;
+		if (!reader.ReadDictionary(token) || token != "afxHidden" || !reader.Read(count) || 1 != count || !reader.Read(hidden) || 42 != hidden)
+			return false;
+
+		if (!reader.ReadDictionary(token) || token != "afxFrameEnd")
+			return false;
+	}
+
+	return true;
+}
+
+static bool AfxGameRecordTests_ReadFile(wchar_t const * fileName, int expectedVersion, int frames, double positionTolerance, double rotationTolerance)
+{
+	CAfxGameRecordReader reader;
+
+	if (!reader.Open(fileName) || reader.GetVersion() != expectedVersion)
+		return false;
+
+	return AfxGameRecordTests_ReadFrames(reader, 0, frames, positionTolerance, rotationTolerance) && reader.IsEnd();
+}
+
+AFX_TEST(AfxGameRecord_RoundTripRaw)
+{
+	AfxGameRecordTests_WriteFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_RAW, 100);
+
+	AFX_CHECK(AfxGameRecordTests_ReadFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_RAW, 100, 0, 0));
+
+	remove("SharedTests_record.agr");
+}
+
+AFX_TEST(AfxGameRecord_RoundTripCompressed)
+{
+	// More than one block on purpose:
+	AfxGameRecordTests_WriteFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_COMPRESSED, 2 * AFXGAMERECORD_BLOCK_FRAMES + 10);
+
+	AFX_CHECK(AfxGameRecordTests_ReadFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_COMPRESSED, 2 * AFXGAMERECORD_BLOCK_FRAMES + 10, 0.5 / 1024 + 1e-4, 5e-5));
+
+	remove("SharedTests_record.agr");
+}
+
+AFX_TEST(AfxGameRecord_SeekFrame)
+{
+	int frames = 3 * AFXGAMERECORD_BLOCK_FRAMES + 5;
+
+	AfxGameRecordTests_WriteFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_COMPRESSED, frames);
+
+	CAfxGameRecordReader reader;
+	AFX_CHECK(reader.Open(L"SharedTests_record.agr"));
+	AFX_CHECK(reader.GetFrameCount() == frames);
+
+	// Block starts, mid block and the last frame, out of order on purpose:
+	int seekFrames[] = { 2 * AFXGAMERECORD_BLOCK_FRAMES + 7, 0, AFXGAMERECORD_BLOCK_FRAMES, frames - 1, 1, AFXGAMERECORD_BLOCK_FRAMES - 1 };
+
+	for (size_t i = 0; i < sizeof(seekFrames) / sizeof(seekFrames[0]); ++i)
+	{
+		AFX_CHECK(reader.SeekFrame(seekFrames[i]));
+		AFX_CHECK(AfxGameRecordTests_ReadFrames(reader, seekFrames[i], 1, 0.5 / 1024 + 1e-4, 5e-5));
+	}
+
+	// Reading on after a seek:
+	AFX_CHECK(reader.SeekFrame(frames - 3));
+	AFX_CHECK(AfxGameRecordTests_ReadFrames(reader, frames - 3, 3, 0.5 / 1024 + 1e-4, 5e-5));
+	AFX_CHECK(reader.IsEnd());
+
+	AFX_CHECK(!reader.SeekFrame(frames));
+	AFX_CHECK(!reader.SeekFrame(-1));
+
+	reader.Close();
+
+	// Version 5 has no index, seeking still works, but has to decode all frames before:
+	AfxGameRecordTests_WriteFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_RAW, 10);
+
+	AFX_CHECK(reader.Open(L"SharedTests_record.agr"));
+	AFX_CHECK(reader.GetFrameCount() == -1);
+	AFX_CHECK(reader.SeekFrame(7));
+	AFX_CHECK(AfxGameRecordTests_ReadFrames(reader, 7, 3, 0, 0));
+	AFX_CHECK(reader.IsEnd());
+	AFX_CHECK(reader.SeekFrame(2));
+	AFX_CHECK(AfxGameRecordTests_ReadFrames(reader, 2, 1, 0, 0));
+	AFX_CHECK(!reader.SeekFrame(10));
+
+	reader.Close();
+
+	remove("SharedTests_record.agr");
+}
+
+AFX_TEST(AfxGameRecord_Convert)
+{
+	AfxGameRecordTests_WriteFile(L"SharedTests_record.agr", AFXGAMERECORD_VERSION_COMPRESSED, 100);
+
+	AFX_CHECK(AfxGameRecordConvert(L"SharedTests_record.agr", L"SharedTests_record5.agr", AFXGAMERECORD_VERSION_RAW));
+	AFX_CHECK(AfxGameRecordTests_ReadFile(L"SharedTests_record5.agr", AFXGAMERECORD_VERSION_RAW, 100, 0.5 / 1024 + 1e-4, 5e-5));
+
+	AFX_CHECK(AfxGameRecordConvert(L"SharedTests_record5.agr", L"SharedTests_record6.agr", AFXGAMERECORD_VERSION_COMPRESSED));
+	AFX_CHECK(AfxGameRecordTests_ReadFile(L"SharedTests_record6.agr", AFXGAMERECORD_VERSION_COMPRESSED, 100, 0.5 / 1024 + 1e-4, 5e-5));
+
+	AFX_CHECK(!AfxGameRecordConvert(L"SharedTests_does_not_exist.agr", L"SharedTests_record7.agr", AFXGAMERECORD_VERSION_RAW));
+
+	remove("SharedTests_record.agr");
+	remove("SharedTests_record5.agr");
+	remove("SharedTests_record6.agr");
+	remove("SharedTests_record7.agr");
+}
+
+AFX_TEST(AfxGameRecord_Dictionary)
+{
+	CAfxGameRecordDictionary dictionary;
+
+	AFX_CHECK(-1 == dictionary.FindOrAdd("entity_state"));
+	AFX_CHECK(0 == dictionary.FindOrAdd("entity_state"));
+	AFX_CHECK(-1 == dictionary.FindOrAdd(""));
+	AFX_CHECK(1 == dictionary.FindOrAdd(""));
+
+	// Enough strings to grow the table a few times, from a buffer that is reused, so the pointer is always the same:
+	char buffer[64];
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		_snprintf_s(buffer, _TRUNCATE, "models/props/prop_%i.mdl", i);
+		AFX_CHECK(-1 == dictionary.FindOrAdd(buffer));
+	}
+
+	AFX_CHECK(5002 == dictionary.GetCount());
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		_snprintf_s(buffer, _TRUNCATE, "models/props/prop_%i.mdl", i);
+		AFX_CHECK(2 + i == dictionary.FindOrAdd(buffer));
+		AFX_CHECK(0 == strcmp(buffer, dictionary.Get(2 + i)));
+
+		// A different pointer with the same content:
+		std::string copy(buffer);
+		AFX_CHECK(2 + i == dictionary.FindOrAdd(copy.c_str()));
+	}
+
+	AFX_CHECK(0 == dictionary.FindOrAdd("entity_state"));
+
+	dictionary.Clear();
+
+	AFX_CHECK(0 == dictionary.GetCount());
+	AFX_CHECK(-1 == dictionary.FindOrAdd("entity_state"));
+	AFX_CHECK(-1 == dictionary.FindOrAdd("models/props/prop_0.mdl"));
+	AFX_CHECK(1 == dictionary.FindOrAdd("models/props/prop_0.mdl"));
+}
+
+AFX_TEST(AfxGameRecord_BoneCoderEdgeCases)
+{
+	CAfxGameRecordBoneCoder encoder;
+	CAfxGameRecordBoneCoder decoder;
+	std::vector<unsigned char> data;
+
+	float positions[4][3] = { { 0, 0, 0 }, { 1e9f, -1e9f, 0 }, { NAN, 1, -1 }, { -0.25f, 0.5f, 123456.0f } };
+	float rotations[4][4] = { { 0, 0, 0, 1 }, { 0, 0, 0, 0 }, { NAN, 0, 0, 1 }, { 0, -1, 0, 0 } };
+
+	encoder.BeginBones(7, 4);
+	for (int i = 0; i < 4; ++i) encoder.EncodeBone(positions[i], rotations[i], data);
+
+	unsigned char const * pos = &data[0];
+	unsigned char const * end = pos + data.size();
+
+	float expectedPositions[4][3] = { { 0, 0, 0 }, { 1e6f, -1e6f, 0 }, { 0, 1, -1 }, { -0.25f, 0.5f, 123456.0f } };
+	float expectedRotations[4][4] = { { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, { 0, 1, 0, 0 } };
+
+	decoder.BeginBones(7, 4);
+	for (int i = 0; i < 4; ++i)
+	{
+		float position[3];
+		float rotation[4];
+		AFX_CHECK(decoder.DecodeBone(pos, end, position, rotation));
+
+		for (int j = 0; j < 3; ++j) AFX_CHECK_NEAR(position[j], expectedPositions[i][j], 1e-3);
+		for (int j = 0; j < 4; ++j) AFX_CHECK_NEAR(rotation[j], expectedRotations[i][j], 1e-4);
+	}
+
+	AFX_CHECK(pos == end);
+
+	// More bones than announced and truncated data:
+	float position[3];
+	float rotation[4];
+	AFX_CHECK(!decoder.DecodeBone(pos, end, position, rotation));
+
+	decoder.Reset();
+	decoder.BeginBones(7, 1);
+	pos = &data[0];
+	end = pos + 2;
+	AFX_CHECK(!decoder.DecodeBone(pos, end, position, rotation));
+}
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxInteropProtocol.h>
+#include <shared/AfxInteropReplay.h>
+#include <shared/AfxInteropStandIn.h>
+
+#include <stdio.h>
+
+#include <thread>
+
+static void AfxInteropReplayTests_RunClient(CAfxInteropStandInClient * client, bool * outResult)
+{
+	*outResult = client->Run();
+}
+
+static void AfxInteropReplayTests_StandIns(int version, int replyPadding = 0)
+{
+	AfxInteropStandInSettings settings;
+	settings.Version = version;
+	settings.Frames = 50;
+	settings.ReplyPadding = replyPadding;
+
+	CAfxInteropPipeTransport engineTransport;
+	CAfxInteropPipeTransport clientTransport;
+	AFX_CHECK(CAfxInteropPipeTransport::Connect(engineTransport, clientTransport));
+
+	CAfxInteropStandInEngine engine(&engineTransport, settings);
+	CAfxInteropStandInClient client(&clientTransport, settings);
+
+	bool clientResult = false;
+	std::thread clientThread(AfxInteropReplayTests_RunClient, &client, &clientResult);
+
+	AFX_CHECK(engine.Run());
+	engineTransport.CloseWrite();
+
+	clientThread.join();
+
+	AFX_CHECK(clientResult);
+	AFX_CHECK(settings.Frames == client.GetFrames());
+}
+
+AFX_TEST(AfxInteropReplay_StandIns_v7)
+{
+	AfxInteropReplayTests_StandIns(7);
+}
+
+AFX_TEST(AfxInteropReplay_StandIns_v8)
+{
+	AfxInteropReplayTests_StandIns(8);
+}
+
+AFX_TEST(AfxInteropReplay_StandIns_v8_ReplyPadding)
+{
+	// Like a newer client that adds fields to its replies:
+	AfxInteropReplayTests_StandIns(8, 5);
+}
+
+AFX_TEST(AfxInteropReplay_StandIns_v8_ReplyTooBig)
+{
+	AfxInteropStandInSettings settings;
+	settings.Frames = 50;
+	settings.ReplyPadding = -2;
+
+	CAfxInteropPipeTransport engineTransport;
+	CAfxInteropPipeTransport clientTransport;
+	AFX_CHECK(CAfxInteropPipeTransport::Connect(engineTransport, clientTransport));
+
+	CAfxInteropStandInEngine engine(&engineTransport, settings);
+	CAfxInteropStandInClient client(&clientTransport, settings);
+
+	bool clientResult = false;
+	std::thread clientThread(AfxInteropReplayTests_RunClient, &client, &clientResult);
+
+	// The engine must not read on when a reply is bigger than its size says:
+	AFX_CHECK(!engine.Run());
+	engineTransport.CloseWrite();
+
+	clientThread.join();
+}
+
+static void AfxInteropReplayTests_Replay(CAfxInteropRecording const * recording, IAfxInteropTransport * transport, AfxInteropReplayStats * outStats, bool * outResult)
+{
+	*outResult = recording->Replay(false, transport, *outStats);
+}
+
+static void AfxInteropReplayTests_RecordReplay(int version, int expectedMessage)
+{
+	AfxInteropStandInSettings settings;
+	settings.Version = version;
+	settings.Frames = 20;
+
+	// Record the stand-ins:
+	{
+		CAfxInteropPipeTransport engineTransport;
+		CAfxInteropPipeTransport clientTransport;
+		AFX_CHECK(CAfxInteropPipeTransport::Connect(engineTransport, clientTransport));
+
+		CAfxInteropRecorder recorder;
+		AFX_CHECK(recorder.Open(L"SharedTests_interop.rec", &engineTransport));
+
+		CAfxInteropStandInEngine engine(&recorder, settings);
+		CAfxInteropStandInClient client(&clientTransport, settings);
+
+		bool clientResult = false;
+		std::thread clientThread(AfxInteropReplayTests_RunClient, &client, &clientResult);
+
+		AFX_CHECK(engine.Run());
+		engineTransport.CloseWrite();
+
+		clientThread.join();
+
+		AFX_CHECK(clientResult);
+		AFX_CHECK(recorder.Close());
+	}
+
+	CAfxInteropRecording recording;
+	AFX_CHECK(recording.Load(L"SharedTests_interop.rec"));
+
+	std::vector<AfxInteropExchange> const & exchanges = recording.GetExchanges();
+	AFX_CHECK(settings.Frames < (int)exchanges.size());
+	AFX_CHECK(!exchanges.empty() && -1 == exchanges.front().Message);
+
+	int expectedCount = 0;
+	for (size_t i = 0; i < exchanges.size(); ++i)
+	{
+		if (expectedMessage == exchanges[i].Message) ++expectedCount;
+	}
+	AFX_CHECK(settings.Frames == expectedCount);
+
+	// Replay both sides against each other:
+
+	CAfxInteropPipeTransport engineTransport;
+	CAfxInteropPipeTransport clientTransport;
+	AFX_CHECK(CAfxInteropPipeTransport::Connect(engineTransport, clientTransport));
+
+	AfxInteropReplayStats engineStats;
+	AfxInteropReplayStats clientStats;
+
+	bool clientResult = false;
+	std::thread clientThread(AfxInteropReplayTests_Replay, &recording, &clientTransport, &clientStats, &clientResult);
+
+	AFX_CHECK(recording.Replay(true, &engineTransport, engineStats));
+
+	clientThread.join();
+
+	AFX_CHECK(clientResult);
+	AFX_CHECK(0 == engineStats.BytesDiffering && 0 == clientStats.BytesDiffering);
+	AFX_CHECK(engineStats.BytesWritten == clientStats.BytesRead);
+	AFX_CHECK(engineStats.BytesRead == clientStats.BytesWritten);
+	AFX_CHECK(exchanges.size() == engineStats.Exchanges);
+	AFX_CHECK(settings.Frames == (int)engineStats.Latencies[expectedMessage + 1].GetCount());
+
+	remove("SharedTests_interop.rec");
+}
+
+AFX_TEST(AfxInteropReplay_RecordReplay_v7)
+{
+	AfxInteropReplayTests_RecordReplay(7, AfxInteropProtocol::EngineMessage_BeforeFrameStart);
+}
+
+AFX_TEST(AfxInteropReplay_RecordReplay_v8)
+{
+	AfxInteropReplayTests_RecordReplay(8, AfxInteropProtocol::EngineMessage_Frame);
+}
+
+AFX_TEST(AfxInteropReplay_Load_Invalid)
+{
+	CAfxInteropRecording recording;
+	AFX_CHECK(!recording.Load(L"SharedTests_interop_missing.rec"));
+
+	FILE * file = fopen("SharedTests_interop.rec", "wb");
+	AFX_CHECK(nullptr != file);
+	if (nullptr != file)
+	{
+		// Valid header, truncated chunk:
+		unsigned char data[] = { 'A', 'X', 'I', 'R', 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 10, 0, 0, 0, 'x' };
+		fwrite(data, 1, sizeof(data), file);
+		fclose(file);
+	}
+	AFX_CHECK(!recording.Load(L"SharedTests_interop.rec"));
+
+	remove("SharedTests_interop.rec");
+}
+
+AFX_TEST(AfxInteropReplay_LatencyHistogram)
+{
+	CAfxInteropLatencyHistogram histogram;
+	AFX_CHECK(0 == histogram.GetPercentile(50));
+
+	for (int i = 0; i < 90; ++i) histogram.Add(10);
+	for (int i = 0; i < 10; ++i) histogram.Add(1000);
+
+	AFX_CHECK(100 == histogram.GetCount());
+	AFX_CHECK_NEAR(10, histogram.GetMin(), 0.0001);
+	AFX_CHECK_NEAR(1000, histogram.GetMax(), 0.0001);
+	AFX_CHECK_NEAR(109, histogram.GetMean(), 0.0001);
+
+	// Upper bounds of the buckets, which are less than 19% wide, but not above the maximum:
+	double median = histogram.GetPercentile(50);
+	AFX_CHECK(10 < median && median <= 10 * 1.19);
+	double p90 = histogram.GetPercentile(90);
+	AFX_CHECK(10 < p90 && p90 <= 10 * 1.19);
+	AFX_CHECK_NEAR(1000, histogram.GetPercentile(99), 0.0001);
+}
@@ -0,0 +1,136 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxInteropSharedMemory.h>
+#include <shared/AfxInteropStream.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string AfxInteropSharedMemoryTests_Name(char const * test)
+{
+	return std::string("afxInteropTest_") + test + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+AFX_TEST(AfxInteropSharedMemory_OpenClose)
+{
+	std::string name = AfxInteropSharedMemoryTests_Name("OpenClose");
+
+	CAfxInteropSharedMemoryTransport server;
+	CAfxInteropSharedMemoryTransport client;
+
+	AFX_CHECK(!client.Open(name.c_str()));
+	AFX_CHECK(server.Create(name.c_str(), 100));
+	AFX_CHECK(server.IsOpen() && !server.GetClosed());
+
+	CAfxInteropSharedMemoryTransport second;
+	AFX_CHECK(!second.Create(name.c_str()));
+
+	AFX_CHECK(client.Open(name.c_str()));
+
+	size_t readable;
+	AFX_CHECK(client.GetReadable(readable) && 0 == readable);
+	AFX_CHECK(server.WriteAll("abc", 3));
+	AFX_CHECK(client.GetReadable(readable) && 3 == readable);
+
+	// What was written before the close can still be read:
+	server.Close();
+	AFX_CHECK(!server.IsOpen() && client.GetClosed());
+
+	char data[8];
+	AFX_CHECK(2 == client.ReadSome(data, 2) && 'a' == data[0] && 'b' == data[1]);
+	AFX_CHECK(1 == client.ReadSome(data, 8) && 'c' == data[0]);
+	AFX_CHECK(0 == client.ReadSome(data, 8));
+	AFX_CHECK(!client.GetReadable(readable));
+	AFX_CHECK(!client.WriteAll("d", 1));
+
+	client.Close();
+	AFX_CHECK(!client.Open(name.c_str()));
+}
+
+AFX_TEST(AfxInteropSharedMemory_Wrap)
+{
+	std::string name = AfxInteropSharedMemoryTests_Name("Wrap");
+
+	CAfxInteropSharedMemoryTransport server;
+	CAfxInteropSharedMemoryTransport client;
+
+	AFX_CHECK(server.Create(name.c_str(), 4096));
+	AFX_CHECK(client.Open(name.c_str()));
+
+	// More than fits into the ring, so the writer has to wait for the reader (and sleep):
+	server.SetSpinCount(10);
+	client.SetSpinCount(10);
+
+	std::vector<unsigned char> sent(100 * 1000);
+	for (size_t i = 0; i < sent.size(); ++i) sent[i] = (unsigned char)(i * 7 + i / 256);
+
+	std::thread writer([&server, &sent] {
+		for (size_t pos = 0; pos < sent.size(); pos += 999)
+		{
+			size_t size = sent.size() - pos;
+			if (999 < size) size = 999;
+			if (!server.WriteAll(&sent[pos], size)) return;
+		}
+		server.Flush();
+	});
+
+	std::vector<unsigned char> received;
+	while (received.size() < sent.size())
+	{
+		unsigned char data[1500];
+		size_t count = client.ReadSome(data, sizeof(data));
+		if (0 == count) break;
+		received.insert(received.end(), data, data + count);
+	}
+
+	writer.join();
+
+	AFX_CHECK(sent == received);
+}
+
+// Stand-in for an interop client (the side that creates the memory),
+// answers each Int32 with it plus 1:
+static void AfxInteropSharedMemoryTests_StandIn(CAfxInteropSharedMemoryTransport * transport)
+{
+	CAfxInteropStream stream(transport);
+
+	while (true)
+	{
+		int value;
+		if (!stream.Read(&value, sizeof(value))) break;
+		++value;
+		if (!stream.Write(&value, sizeof(value)) || !stream.Send()) break;
+	}
+}
+
+AFX_TEST(AfxInteropSharedMemory_Stream)
+{
+	std::string name = AfxInteropSharedMemoryTests_Name("Stream");
+
+	CAfxInteropSharedMemoryTransport server;
+	CAfxInteropSharedMemoryTransport client;
+
+	AFX_CHECK(server.Create(name.c_str()));
+	AFX_CHECK(client.Open(name.c_str()));
+
+	std::thread standIn(AfxInteropSharedMemoryTests_StandIn, &server);
+
+	CAfxInteropStream stream(&client);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		int value = 2 * i;
+		AFX_CHECK(stream.Write(&value, sizeof(value)));
+		AFX_CHECK(stream.Read(&value, sizeof(value)));
+		AFX_CHECK(2 * i + 1 == value);
+	}
+
+	AFX_CHECK(stream.Flush());
+
+	client.Close();
+	standIn.join();
+}
@@ -0,0 +1,189 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxInteropStream.h>
+
+#include <string.h>
+
+#include <vector>
+
+// Answers each 4 byte request with 4 * 100 bytes (like a server that only
+// answers after it got the request):
+class CAfxInteropStreamTests_Transport : public IAfxInteropTransport
+{
+public:
+	std::vector<unsigned char> Written;
+	std::vector<unsigned char> Answer;
+	size_t AnswerPos = 0;
+	size_t RequestsAnswered = 0;
+	bool Broken = false;
+
+	virtual size_t ReadSome(void * data, size_t size) override
+	{
+		if (AnswerPos == Answer.size())
+		{
+			if (Broken || Written.size() < 4 * (RequestsAnswered + 1))
+				return 0; // Would block forever.
+
+			++RequestsAnswered;
+			Answer.clear();
+			AnswerPos = 0;
+			for (int i = 0; i < 100; ++i)
+			{
+				float value = (float)(RequestsAnswered * 1000 + i);
+				unsigned char bytes[sizeof(value)];
+				memcpy(bytes, &value, sizeof(value));
+				Answer.insert(Answer.end(), bytes, bytes + sizeof(value));
+			}
+		}
+
+		size_t count = Answer.size() - AnswerPos;
+		if (size < count) count = size;
+		memcpy(data, &Answer[AnswerPos], count);
+		AnswerPos += count;
+
+		return count;
+	}
+
+	virtual bool GetReadable(size_t & outSize) override
+	{
+		outSize = Answer.size() - AnswerPos;
+		return !Broken;
+	}
+
+	virtual bool WriteAll(void const * data, size_t size) override
+	{
+		if (Broken)
+			return false;
+
+		Written.insert(Written.end(), (unsigned char const *)data, (unsigned char const *)data + size);
+		return true;
+	}
+
+	virtual bool Flush(void) override
+	{
+		return !Broken;
+	}
+};
+
+static void AfxInteropStreamTests_Frame(CAfxInteropStream & stream, int frame)
+{
+	// Request, written field by field:
+	unsigned char request[4] = { 1, 2, 3, (unsigned char)frame };
+	for (int i = 0; i < 4; ++i) AFX_CHECK(stream.Write(&request[i], 1));
+	AFX_CHECK(stream.Flush());
+
+	// Answer, read field by field:
+	for (int i = 0; i < 100; ++i)
+	{
+		float value;
+		AFX_CHECK(stream.Read(&value, sizeof(value)));
+		AFX_CHECK((float)((frame + 1) * 1000 + i) == value);
+	}
+}
+
+AFX_TEST(AfxInteropStream_Buffered)
+{
+	CAfxInteropStreamTests_Transport transport;
+	CAfxInteropStream stream(&transport);
+
+	for (int frame = 0; frame < 10; ++frame) AfxInteropStreamTests_Frame(stream, frame);
+
+	AfxInteropStreamStats stats = stream.GetStats();
+	AFX_CHECK(10 == stats.Writes);
+	AFX_CHECK(10 == stats.Flushes);
+	AFX_CHECK(10 == stats.Reads);
+	AFX_CHECK(40 == stats.BytesWritten);
+	AFX_CHECK(10 * 400 == stats.BytesRead);
+	AFX_CHECK(40 == transport.Written.size() && 9 == transport.Written[39]);
+
+	// Unbuffered each field is a transport call:
+	stream.ResetStats();
+	stream.SetBuffered(false);
+	AfxInteropStreamTests_Frame(stream, 10);
+
+	stats = stream.GetStats();
+	AFX_CHECK(4 == stats.Writes);
+	AFX_CHECK(100 == stats.Reads);
+}
+
+AFX_TEST(AfxInteropStream_WritesBeforeBlockingRead)
+{
+	CAfxInteropStreamTests_Transport transport;
+	CAfxInteropStream stream(&transport, 16);
+
+	// Not flushed, but the read has to wait for the answer, so the request is written first:
+	unsigned char request[4] = { 1, 2, 3, 4 };
+	AFX_CHECK(stream.Write(request, sizeof(request)));
+	AFX_CHECK(4 == stream.GetPendingWriteSize() && transport.Written.empty());
+
+	float values[100];
+	AFX_CHECK(stream.Read(values, sizeof(values)));
+	AFX_CHECK(1000.0f == values[0] && 1099.0f == values[99]);
+	AFX_CHECK(0 == stream.GetPendingWriteSize() && 4 == transport.Written.size());
+
+	// Writes bigger than the buffer go directly:
+	unsigned char big[40] = { 0 };
+	AFX_CHECK(stream.Write(request, 2));
+	AFX_CHECK(stream.Write(big, sizeof(big)));
+	AFX_CHECK(4 + 2 + 40 == transport.Written.size());
+
+	AFX_CHECK(stream.Write(request, 3));
+	AFX_CHECK(stream.Send());
+	AFX_CHECK(0 == stream.GetPendingWriteSize() && 4 + 2 + 40 + 3 == transport.Written.size());
+
+	// The answer to that is read ahead into the buffer, which Reset discards:
+	size_t readable;
+	AFX_CHECK(stream.GetReadable(readable) && 0 == readable);
+	AFX_CHECK(stream.Read(values, 1));
+	AFX_CHECK(16 == transport.AnswerPos);
+	AFX_CHECK(stream.GetReadable(readable) && 399 == readable);
+	stream.Reset();
+	AFX_CHECK(stream.Read(values, sizeof(float)));
+	AFX_CHECK(2004.0f == values[0]);
+
+	// Errors fail:
+	transport.Broken = true;
+	transport.Answer.clear();
+	transport.AnswerPos = 0;
+	stream.Reset();
+	AFX_CHECK(stream.Write(request, 1));
+	AFX_CHECK(!stream.Flush());
+	AFX_CHECK(!stream.Read(values, 1));
+
+	CAfxInteropStream unconnected;
+	AFX_CHECK(!unconnected.Write(request, 1));
+	AFX_CHECK(!unconnected.Read(values, 1));
+	AFX_CHECK(!unconnected.GetReadable(readable));
+	AFX_CHECK(!unconnected.Send());
+	AFX_CHECK(!unconnected.Flush());
+}
+
+AFX_TEST(AfxInteropStream_SkipAndReadPosition)
+{
+	CAfxInteropStreamTests_Transport transport;
+	CAfxInteropStream stream(&transport, 16);
+
+	unsigned char request[4] = { 1, 2, 3, 4 };
+	AFX_CHECK(stream.Write(request, sizeof(request)));
+	AFX_CHECK(0 == stream.GetReadPosition());
+
+	float value;
+	AFX_CHECK(stream.Read(&value, sizeof(value)));
+	AFX_CHECK(1000.0f == value);
+
+	// More than the buffer and the skip buffer hold:
+	AFX_CHECK(stream.Skip(98 * sizeof(float)));
+	AFX_CHECK(99 * sizeof(float) == stream.GetReadPosition());
+
+	AFX_CHECK(stream.Read(&value, sizeof(value)));
+	AFX_CHECK(1099.0f == value);
+	AFX_CHECK(100 * sizeof(float) == stream.GetReadPosition());
+
+	stream.Reset();
+	AFX_CHECK(0 == stream.GetReadPosition());
+
+	// Nothing more to read:
+	AFX_CHECK(!stream.Skip(1));
+}
@@ -0,0 +1,120 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxMath.h>
+
+#include <math.h>
+#include <vector>
+
+using namespace Afx::Math;
+
+AFX_TEST(AfxMath_Quaternion_Normalized)
+{
+	Quaternion q = Quaternion(1, 2, 3, 4).Normalized();
+
+	AFX_CHECK_NEAR(q.Norm(), 1.0, 1e-12);
+}
+
+AFX_TEST(AfxMath_Quaternion_EulerRoundTrip)
+{
+	QEulerAngles angles(10.0, -35.0, 20.0);
+	Quaternion q = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(angles));
+	QEulerAngles result = q.ToQREulerAngles().ToQEulerAngles();
+
+	AFX_CHECK_NEAR(result.Pitch, angles.Pitch, 1e-9);
+	AFX_CHECK_NEAR(result.Yaw, angles.Yaw, 1e-9);
+	AFX_CHECK_NEAR(result.Roll, angles.Roll, 1e-9);
+}
+
+AFX_TEST(AfxMath_Quaternion_Slerp)
+{
+	Quaternion a = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(0, 0, 0)));
+	Quaternion b = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(0, 90, 0)));
+
+	AFX_CHECK_NEAR(fabs(DotProduct(a.Slerp(b, 0), a)), 1.0, 1e-12);
+	AFX_CHECK_NEAR(fabs(DotProduct(a.Slerp(b, 1), b)), 1.0, 1e-12);
+
+	QEulerAngles half = a.Slerp(b, 0.5).ToQREulerAngles().ToQEulerAngles();
+
+	AFX_CHECK_NEAR(half.Yaw, 45.0, 1e-9);
+}
+
+AFX_TEST(AfxMath_LUdecomposition_Solve)
+{
+	double A[4][4] = {
+		{ 4, 1, 0, 2 },
+		{ 1, 3, 1, 0 },
+		{ 0, 1, 5, 1 },
+		{ 2, 0, 1, 6 }
+	};
+	double x[4] = { 1, -2, 3, 0.5 };
+	double b[4];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		b[i] = 0;
+		for (int j = 0; j < 4; ++j) b[i] += A[i][j] * x[j];
+	}
+
+	unsigned char P[4], Q[4];
+	double L[4][4], U[4][4], result[4];
+
+	AFX_CHECK(LUdecomposition(A, P, Q, L, U));
+
+	SolveWithLU(L, U, P, Q, b, result);
+
+	for (int i = 0; i < 4; ++i) AFX_CHECK_NEAR(result[i], x[i], 1e-12);
+}
+
+AFX_TEST(AfxMath_Spline_PassesThroughPoints)
+{
+	double x[5] = { 0, 1, 2.5, 3, 5 };
+	double y[5] = { 1, -1, 2, 0, 4 };
+	double y2[5];
+
+	spline(x, y, 5, true, 0, true, 0, y2);
+
+	for (int i = 0; i < 5; ++i)
+	{
+		double value;
+		splint(x, y, y2, 5, x[i], &value);
+		AFX_CHECK_NEAR(value, y[i], 1e-12);
+	}
+}
+
+AFX_TEST(AfxMath_QSplineSegments_MatchesQSplineInterp)
+{
+	const int n = 6;
+
+	double x[n] = { 0, 0.5, 1.25, 2, 3, 3.5 };
+	double y[n][4];
+	double h[n - 1], dtheta[n - 1], e[n - 1][3], w[n][3];
+
+	for (int i = 0; i < n; ++i)
+	{
+		Quaternion q = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(10.0 * i, 25.0 * i - 40.0, 5.0 * (i % 3))));
+		y[i][0] = q.X;
+		y[i][1] = q.Y;
+		y[i][2] = q.Z;
+		y[i][3] = q.W;
+	}
+
+	double wi[3] = { 0, 0, 0 };
+	double wf[3] = { 0, 0, 0 };
+
+	qspline_init(n, 2, AFX_MATH_EPS, wi, wf, x, y, h, dtheta, e, w);
+
+	std::vector<QSplineSegment> segments(n - 1);
+	qspline_segments(n, x, y, h, dtheta, e, w, &segments[0]);
+
+	for (double t = x[0]; t <= x[n - 1]; t += 0.0625)
+	{
+		double q1[4], q2[4], omega[3], alpha[3];
+
+		qspline_interp(n, t, x, y, h, dtheta, e, w, q1, omega, alpha);
+		qspline_segments_interp(n, t, &segments[0], q2);
+
+		for (int j = 0; j < 4; ++j) AFX_CHECK_NEAR(q1[j], q2[j], 1e-12);
+	}
+}
@@ -0,0 +1,300 @@
+#include "stdafx.h"
+
+#include "Test.h"
+#include "WebSocketTestServer.h"
+
+#include <shared/AfxMessageQueue.h>
+#include <shared/AfxWebSocket.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+AFX_TEST(AfxMessageQueue_RateLimit)
+{
+	CAfxMessageQueue queue(1024);
+	queue.SetMaxLatestPerSecond(30);
+
+	int sent = 0;
+
+	// 2 seconds at 100 fps:
+	for (int i = 0; i < 200; ++i)
+	{
+		if (queue.BeginLatest(i / 100.0))
+		{
+			queue.Write("cam", 4);
+			AFX_CHECK(queue.End());
+			++sent;
+		}
+
+		queue.GetRing().Publish(queue.GetRing().GetWritePosition());
+		queue.GetRing().Consume(queue.GetRing().GetUsed());
+	}
+
+	AFX_CHECK(60 <= sent && sent <= 61);
+	AFX_CHECK(200 - sent == (int)queue.GetStats().Coalesced);
+	AFX_CHECK(sent == (int)queue.GetStats().Messages);
+	AFX_CHECK(4 * sent == (int)queue.GetStats().Bytes);
+
+	// After a pause the next one is sent right away:
+	AFX_CHECK(queue.BeginLatest(10.0));
+	AFX_CHECK(queue.End());
+	AFX_CHECK(!queue.BeginLatest(10.01));
+
+	queue.SetMaxLatestPerSecond(0);
+	AFX_CHECK(queue.BeginLatest(10.01));
+	AFX_CHECK(queue.End());
+}
+
+AFX_TEST(AfxMessageQueue_Bounded)
+{
+	CAfxMessageQueue queue(64);
+	AFX_CHECK(64 == queue.GetMaxBytes());
+
+	queue.SetMaxBytes(20);
+	AFX_CHECK(20 == queue.GetMaxBytes());
+
+	queue.Begin();
+	queue.Write("0123456789", 10);
+	AFX_CHECK(queue.End());
+
+	// Doesn't fit as a whole, so nothing of it is queued:
+	queue.Begin();
+	queue.Write("01234", 5);
+	queue.Write("56789", 5);
+	queue.Write("x", 1);
+	AFX_CHECK(!queue.End());
+	AFX_CHECK(10 == queue.GetRing().GetWritePosition());
+	AFX_CHECK(1 == queue.GetStats().Dropped);
+
+	queue.Begin();
+	queue.Write("abcdefghij", 10);
+	AFX_CHECK(queue.End());
+	AFX_CHECK(20 == queue.GetStats().MaxBacklog);
+
+	queue.GetRing().Publish(queue.GetRing().GetWritePosition());
+	queue.GetRing().Consume(10);
+
+	queue.Begin();
+	queue.Write("x", 1);
+	AFX_CHECK(queue.End());
+	AFX_CHECK(3 == queue.GetStats().Messages);
+
+	queue.SetMaxBytes(1000);
+	AFX_CHECK(64 == queue.GetMaxBytes());
+
+	queue.ResetStats();
+	AFX_CHECK(0 == queue.GetStats().Messages && 0 == queue.GetStats().Dropped && 0 == queue.GetStats().MaxBacklog);
+}
+
+struct AfxMessageQueueTests_Received
+{
+	std::vector<int> Events;
+	std::vector<int> Cams;
+};
+
+/// <summary>Stand-in for a slow server: takes a while for every batch it receives.</summary>
+static void AfxMessageQueueTests_SlowConsumer(CAfxByteRing * ring, int lastEvent, AfxMessageQueueTests_Received * outReceived)
+{
+	std::vector<unsigned char> buffer;
+
+	while (outReceived->Events.empty() || outReceived->Events.back() != lastEvent)
+	{
+		unsigned char const * data[2];
+		size_t size[2];
+		size_t readable = ring->GetReadable(data, size);
+
+		if (0 == readable)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		buffer.assign(data[0], data[0] + size[0]);
+		buffer.insert(buffer.end(), data[1], data[1] + size[1]);
+		ring->Consume(readable);
+
+		for (size_t pos = 0; pos + 5 <= buffer.size(); pos += 5)
+		{
+			int value;
+			memcpy(&value, &buffer[pos + 1], sizeof(value));
+
+			if ('e' == buffer[pos])
+				outReceived->Events.push_back(value);
+			else
+				outReceived->Cams.push_back(value);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+AFX_TEST(AfxMessageQueue_SlowConsumer)
+{
+	const int frames = 2000;
+
+	CAfxMessageQueue queue(64 * 1024);
+	queue.SetMaxLatestBacklog(100);
+
+	AfxMessageQueueTests_Received received;
+	std::thread consumer(AfxMessageQueueTests_SlowConsumer, &queue.GetRing(), frames - 1, &received);
+
+	// A frame is an event (lossless) and a cam (latest value), produced much faster than the consumer takes them:
+	for (int i = 0; i < frames; ++i)
+	{
+		queue.Begin();
+		queue.Write("e", 1);
+		queue.Write(&i, sizeof(i));
+		AFX_CHECK(queue.End());
+
+		if (queue.BeginLatest(i / 1000.0))
+		{
+			queue.Write("c", 1);
+			queue.Write(&i, sizeof(i));
+			AFX_CHECK(queue.End());
+		}
+
+		queue.GetRing().Publish(queue.GetRing().GetWritePosition());
+	}
+
+	consumer.join();
+
+	AFX_CHECK(0 == queue.GetStats().Dropped);
+	AFX_CHECK(frames == (int)received.Events.size());
+	for (int i = 0; i < (int)received.Events.size(); ++i) AFX_CHECK(i == received.Events[i]);
+
+	AFX_CHECK(0 < queue.GetStats().Coalesced);
+	AFX_CHECK(frames == (int)(received.Cams.size() + queue.GetStats().Coalesced));
+	for (size_t i = 1; i < received.Cams.size(); ++i) AFX_CHECK(received.Cams[i - 1] < received.Cams[i]);
+
+	// The backlog stays bounded by the events, the cams don't add to it:
+	AFX_CHECK(queue.GetStats().MaxBacklog < (size_t)(5 * frames + 100 + 5));
+}
+
+/// <summary>Like MirvPgl's send thread: sends from the ring, only consumes what the socket accepted.</summary>
+static void AfxMessageQueueTests_SendThread(CAfxByteRing * ring, CAfxWebSocket * webSocket, std::atomic_bool * quit, size_t * outMaxPending)
+{
+	while (!*quit && CAfxWebSocket::State_Open == webSocket->GetState())
+	{
+		unsigned char const * data[2];
+		size_t size[2];
+		size_t readable = ring->GetReadable(data, size);
+
+		if (0 < readable && webSocket->SendBinary(data, size, 2))
+			ring->Consume(readable);
+
+		if (*outMaxPending < webSocket->GetPendingSendSize()) *outMaxPending = webSocket->GetPendingSendSize();
+
+		webSocket->Poll(0);
+		webSocket->Wait(10);
+	}
+}
+
+/// <summary>Stand-in for a slow server on the other end of the TCP connection: reads about 5 MB/s.</summary>
+static void AfxMessageQueueTests_SlowPeer(CWebSocketTestServer * server, AfxMessageQueueTests_Received * outReceived, bool * outEnd)
+{
+	unsigned char opcode;
+	std::vector<unsigned char> payload;
+
+	while (!*outEnd && server->ReceiveFrame(opcode, payload))
+	{
+		for (size_t pos = 0; pos + 5 <= payload.size(); )
+		{
+			int value;
+			memcpy(&value, &payload[pos + 1], sizeof(value));
+
+			if ('e' == payload[pos])
+			{
+				outReceived->Events.push_back(value);
+				pos += 5 + 4096;
+			}
+			else if ('c' == payload[pos])
+			{
+				outReceived->Cams.push_back(value);
+				pos += 5;
+			}
+			else
+			{
+				*outEnd = true;
+				pos += 5;
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(payload.size() / 5));
+	}
+}
+
+AFX_TEST(AfxMessageQueue_SlowTcpPeer)
+{
+	const int frames = 2000;
+	static const unsigned char padding[4096] = {};
+
+	CWebSocketTestServer server;
+	server.SetReceiveBufferSize(64 * 1024);
+	CAfxWebSocket webSocket;
+	server.BeginAccept();
+	AFX_CHECK(webSocket.Open(server.GetUrl().c_str()));
+	AFX_CHECK(server.EndAccept());
+
+	CAfxMessageQueue queue(256 * 1024);
+	queue.SetMaxLatestBacklog(16 * 1024);
+
+	std::atomic_bool quit(false);
+	size_t maxPending = 0;
+	std::thread sendThread(AfxMessageQueueTests_SendThread, &queue.GetRing(), &webSocket, &quit, &maxPending);
+
+	AfxMessageQueueTests_Received received;
+	bool end = false;
+	std::thread peerThread(AfxMessageQueueTests_SlowPeer, &server, &received, &end);
+
+	// 8 MiB of events, a lot more than the socket buffers take, as fast as possible:
+	for (int i = 0; i < frames; ++i)
+	{
+		queue.Begin();
+		queue.Write("e", 1);
+		queue.Write(&i, sizeof(i));
+		queue.Write(padding, sizeof(padding));
+		queue.End();
+
+		if (queue.BeginLatest(i / 1000.0))
+		{
+			queue.Write("c", 1);
+			queue.Write(&i, sizeof(i));
+			queue.End();
+		}
+
+		queue.GetRing().Publish(queue.GetRing().GetWritePosition());
+		webSocket.Wake();
+
+		// Still faster than the peer reads, but gives the send thread time to keep up:
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+	for (bool queued = false; !queued; )
+	{
+		queue.Begin();
+		queue.Write("z", 1);
+		queue.Write(&frames, sizeof(frames));
+		queued = queue.End();
+
+		queue.GetRing().Publish(queue.GetRing().GetWritePosition());
+		webSocket.Wake();
+
+		if (!queued) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	peerThread.join();
+	quit = true;
+	webSocket.Wake();
+	sendThread.join();
+
+	AFX_CHECK(end);
+	AFX_CHECK(!received.Events.empty());
+	for (size_t i = 1; i < received.Events.size(); ++i) AFX_CHECK(received.Events[i - 1] < received.Events[i]);
+
+	// The backlog stayed in the queue, where its limits apply, instead of piling up in the socket:
+	AFX_CHECK(0 < queue.GetStats().Dropped);
+	AFX_CHECK(0 < queue.GetStats().Coalesced);
+	AFX_CHECK(maxPending <= webSocket.GetMaxPendingSendSize() + queue.GetRing().GetCapacity() + 16);
+}
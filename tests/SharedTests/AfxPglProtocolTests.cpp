@@ -0,0 +1,216 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxPglProtocol.h>
+
+#include <string>
+#include <vector>
+
+static std::vector<unsigned char> AfxPglProtocolTests_Take(CAfxMessageQueue & queue)
+{
+	CAfxByteRing & ring = queue.GetRing();
+	ring.Publish(ring.GetWritePosition());
+
+	unsigned char const * data[2];
+	size_t size[2];
+	size_t readable = ring.GetReadable(data, size);
+
+	std::vector<unsigned char> result(data[0], data[0] + size[0]);
+	result.insert(result.end(), data[1], data[1] + size[1]);
+	ring.Consume(readable);
+
+	return result;
+}
+
+static void AfxPglProtocolTests_WriteFrame(CAfxPglWriter & writer, int frame)
+{
+	writer.Begin();
+	writer.WriteMessage(AfxPglMessage_GameEvent);
+	writer.WriteInt32(0 == frame ? 0 : 7);
+	if (0 == frame)
+	{
+		writer.WriteInt32(7);
+		writer.WriteCString("player_hurt");
+		writer.WriteBoolean(true);
+		writer.WriteCString("weapon");
+		writer.WriteInt32(1);
+		writer.WriteBoolean(false);
+	}
+	writer.WriteCString(frame % 2 ? "ak47" : "awp");
+	writer.WriteInt16(-frame);
+	writer.WriteByte(0xfe);
+	writer.WriteUInt64(76561197960265728ull + frame);
+	writer.WriteFloat(0.5f * frame);
+	AFX_CHECK(writer.End());
+
+	float cam[8] = { frame / 128.0f, 100.0f + frame, -200.0f, 64.0f, 0.0f, 90.0f, 0.0f, 90.0f };
+
+	AFX_CHECK(writer.BeginLatest(frame));
+	writer.WriteMessage(AfxPglMessage_Cam);
+	writer.WriteCam(cam);
+	AFX_CHECK(writer.End());
+}
+
+static void AfxPglProtocolTests_ReadFrame(CAfxPglReader & reader, int frame)
+{
+	std::string value;
+
+	AFX_CHECK(AfxPglMessage_GameEvent == reader.ReadMessage());
+	AFX_CHECK((0 == frame ? 0 : 7) == reader.ReadInt32());
+	if (0 == frame)
+	{
+		AFX_CHECK(7 == reader.ReadInt32());
+		AFX_CHECK(reader.ReadCString(value) && "player_hurt" == value);
+		AFX_CHECK(reader.ReadBoolean());
+		AFX_CHECK(reader.ReadCString(value) && "weapon" == value);
+		AFX_CHECK(1 == reader.ReadInt32());
+		AFX_CHECK(!reader.ReadBoolean());
+	}
+	AFX_CHECK(reader.ReadCString(value) && (frame % 2 ? "ak47" : "awp") == value);
+	AFX_CHECK(-frame == reader.ReadInt16());
+	AFX_CHECK(0xfe == reader.ReadByte());
+	AFX_CHECK(76561197960265728ull + frame == reader.ReadUInt64());
+	AFX_CHECK(0.5f * frame == reader.ReadFloat());
+
+	float cam[8];
+	AFX_CHECK(AfxPglMessage_Cam == reader.ReadMessage());
+	reader.ReadCam(cam);
+	AFX_CHECK(frame / 128.0f == cam[0] && 100.0f + frame == cam[1] && -200.0f == cam[2] && 90.0f == cam[7]);
+}
+
+AFX_TEST(AfxPglProtocol_RoundTrip)
+{
+	CAfxMessageQueue queue(64 * 1024);
+	CAfxPglWriter writer(queue);
+	CAfxPglReader reader;
+
+	size_t sizes[2];
+
+	// Starts in version 2, the server requests 4, so the hello switching to it is still in version 2:
+	for (int i = 0; i < 2; ++i)
+	{
+		writer.Begin();
+		AFX_CHECK(writer.WriteHelloAndEnd(0 == i ? 2 : 4));
+
+		std::vector<unsigned char> data = AfxPglProtocolTests_Take(queue);
+		reader.SetData(data.data(), data.size());
+		AFX_CHECK(AfxPglMessage_Hello == reader.ReadMessage());
+		reader.SetVersion(reader.ReadUInt32());
+		AFX_CHECK(reader.Eof() && !reader.Failed());
+
+		for (int frame = 0; frame < 100; ++frame) AfxPglProtocolTests_WriteFrame(writer, frame);
+
+		data = AfxPglProtocolTests_Take(queue);
+		sizes[i] = data.size();
+		reader.SetData(data.data(), data.size());
+		for (int frame = 0; frame < 100; ++frame) AfxPglProtocolTests_ReadFrame(reader, frame);
+		AFX_CHECK(reader.Eof() && !reader.Failed());
+	}
+
+	AFX_CHECK(4 == writer.GetVersion() && 4 == reader.GetVersion());
+	AFX_CHECK(2 * sizes[1] < sizes[0]);
+
+	// "dataStop" resets the interned strings on both sides:
+	writer.Begin();
+	writer.WriteMessage(AfxPglMessage_DataStop);
+	AFX_CHECK(writer.End());
+	writer.Reset();
+	AfxPglProtocolTests_WriteFrame(writer, 0);
+
+	std::vector<unsigned char> data = AfxPglProtocolTests_Take(queue);
+	reader.SetData(data.data(), data.size());
+	AFX_CHECK(AfxPglMessage_DataStop == reader.ReadMessage());
+	reader.Reset();
+	AfxPglProtocolTests_ReadFrame(reader, 0);
+	AFX_CHECK(reader.Eof() && !reader.Failed());
+
+	// Truncated data fails:
+	reader.SetData(data.data(), data.size() - 1);
+	AFX_CHECK(AfxPglMessage_DataStop == reader.ReadMessage());
+	reader.Reset();
+	AFX_CHECK(AfxPglMessage_GameEvent == reader.ReadMessage());
+	float cam[8];
+	for (int i = 0; i < 10; ++i) reader.ReadCam(cam);
+	AFX_CHECK(reader.Failed() && reader.Eof());
+}
+
+AFX_TEST(AfxPglProtocol_DroppedMessagesRollBack)
+{
+	CAfxMessageQueue queue(64 * 1024);
+	CAfxPglWriter writer(queue);
+	CAfxPglReader reader;
+	writer.SetVersion(4);
+	reader.SetVersion(4);
+
+	queue.SetMaxBytes(40);
+
+	float cam[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	// Is dropped, so "weapon" and the cam must not be known to the server afterwards:
+	writer.Begin();
+	writer.WriteMessage(AfxPglMessage_GameEvent);
+	writer.WriteCString("weapon");
+	writer.WriteCam(cam);
+	writer.WriteCString(std::string(64, 'x').c_str());
+	AFX_CHECK(!writer.End());
+
+	queue.SetMaxBytes(64 * 1024);
+
+	float cam2[8] = { 1, 2, 3, 4, 5, 6, 7, 9 };
+
+	writer.Begin();
+	writer.WriteMessage(AfxPglMessage_GameEvent);
+	writer.WriteCString("weapon");
+	writer.WriteCString("weapon");
+	writer.WriteCam(cam2);
+	AFX_CHECK(writer.End());
+
+	std::vector<unsigned char> data = AfxPglProtocolTests_Take(queue);
+	reader.SetData(data.data(), data.size());
+
+	std::string value;
+	float readCam[8];
+	AFX_CHECK(AfxPglMessage_GameEvent == reader.ReadMessage());
+	AFX_CHECK(reader.ReadCString(value) && "weapon" == value);
+	AFX_CHECK(reader.ReadCString(value) && "weapon" == value);
+	reader.ReadCam(readCam);
+	AFX_CHECK(0 == memcmp(cam2, readCam, sizeof(cam2)));
+	AFX_CHECK(reader.Eof() && !reader.Failed());
+	AFX_CHECK(1 + 1 + 7 + 1 + 8 * 5 >= data.size());
+
+	// Long strings and strings beyond the table's limit are sent literally:
+	writer.Begin();
+	for (int i = 0; i < AFXPGL_MAX_INTERNED_STRINGS + 10; ++i) writer.WriteCString(std::to_string(i).c_str());
+	writer.WriteCString(std::string(AFXPGL_MAX_INTERNED_STRING_LENGTH + 1, 'y').c_str());
+	writer.WriteCString(std::to_string(AFXPGL_MAX_INTERNED_STRINGS + 5).c_str());
+	writer.WriteCString("1");
+	AFX_CHECK(writer.End());
+
+	data = AfxPglProtocolTests_Take(queue);
+	reader.SetData(data.data(), data.size());
+	for (int i = 0; i < AFXPGL_MAX_INTERNED_STRINGS + 10; ++i) AFX_CHECK(reader.ReadCString(value) && std::to_string(i) == value);
+	AFX_CHECK(reader.ReadCString(value) && std::string(AFXPGL_MAX_INTERNED_STRING_LENGTH + 1, 'y') == value);
+	AFX_CHECK(reader.ReadCString(value) && std::to_string(AFXPGL_MAX_INTERNED_STRINGS + 5) == value);
+	AFX_CHECK(reader.ReadCString(value) && "1" == value);
+	AFX_CHECK(reader.Eof() && !reader.Failed());
+
+	// Zig-zag:
+	writer.Begin();
+	writer.WriteInt32(-1);
+	writer.WriteInt32(INT32_MIN);
+	writer.WriteInt32(INT32_MAX);
+	writer.WriteInt16(INT16_MIN);
+	writer.WriteUInt64(UINT64_MAX);
+	AFX_CHECK(writer.End());
+
+	data = AfxPglProtocolTests_Take(queue);
+	AFX_CHECK(1 == data[0]);
+	reader.SetData(data.data(), data.size());
+	AFX_CHECK(-1 == reader.ReadInt32());
+	AFX_CHECK(INT32_MIN == reader.ReadInt32());
+	AFX_CHECK(INT32_MAX == reader.ReadInt32());
+	AFX_CHECK(INT16_MIN == reader.ReadInt16());
+	AFX_CHECK(UINT64_MAX == reader.ReadUInt64());
+	AFX_CHECK(reader.Eof() && !reader.Failed());
+}
@@ -0,0 +1,279 @@
+#include "stdafx.h"
+
+#include "Test.h"
+#include "WebSocketTestServer.h"
+
+#include <shared/AfxWebSocket.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class CAfxWebSocketTests_Receiver : public IAfxWebSocketReceiver
+{
+public:
+	std::vector<std::vector<unsigned char>> Messages;
+
+	virtual void OnBinaryMessage(unsigned char const * data, size_t size) override
+	{
+		Messages.push_back(std::vector<unsigned char>(data, data + size));
+	}
+};
+
+static bool AfxWebSocketTests_Open(CWebSocketTestServer & server, CAfxWebSocket & webSocket)
+{
+	server.BeginAccept();
+	bool opened = webSocket.Open(server.GetUrl().c_str());
+	return server.EndAccept() && opened && CAfxWebSocket::State_Open == webSocket.GetState();
+}
+
+/// <summary>Waits and polls until receiver has count messages or the connection is closed.</summary>
+static void AfxWebSocketTests_PollFor(CAfxWebSocket & webSocket, CAfxWebSocketTests_Receiver & receiver, size_t count)
+{
+	for (int i = 0; i < 100 && receiver.Messages.size() < count && CAfxWebSocket::State_Closed != webSocket.GetState(); ++i)
+	{
+		webSocket.Wait(100);
+		webSocket.Poll(&receiver);
+	}
+}
+
+AFX_TEST(AfxWebSocket_SendAndReceive)
+{
+	CWebSocketTestServer server;
+	CAfxWebSocket webSocket;
+	AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+
+	// Slices (i.e. of a ring) arrive as one message:
+	unsigned char const * data[2] = { (unsigned char const *)"hello\0", (unsigned char const *)"world" };
+	size_t size[2] = { 6, 5 };
+	webSocket.SendBinary(data, size, 2);
+
+	std::vector<unsigned char> big(70000);
+	for (size_t i = 0; i < big.size(); ++i) big[i] = (unsigned char)(i * 7);
+	webSocket.SendBinary(big.data(), big.size());
+
+	CAfxWebSocketTests_Receiver receiver;
+	webSocket.Poll(&receiver);
+
+	unsigned char opcode;
+	std::vector<unsigned char> payload;
+	AFX_CHECK(server.ReceiveFrame(opcode, payload));
+	AFX_CHECK(0x2 == opcode && 11 == payload.size() && 0 == memcmp(payload.data(), "hello\0world", 11));
+
+	// The rest of the big one is sent as the socket becomes writable:
+	std::thread thread([&] {
+		while (0 < webSocket.GetPendingSendSize())
+		{
+			webSocket.Wait(100);
+			webSocket.Poll(&receiver);
+		}
+	});
+	AFX_CHECK(server.ReceiveFrame(opcode, payload));
+	thread.join();
+	AFX_CHECK(0x2 == opcode && big == payload);
+
+	// Server to client, also fragmented, text is ignored:
+	AFX_CHECK(server.SendFrame(0x2, "abc", 3));
+	AFX_CHECK(server.SendFrame(0x1, "text", 4));
+	AFX_CHECK(server.SendFrame(0x2, "de", 2, false));
+	AFX_CHECK(server.SendFrame(0x0, "fg", 2));
+	AFX_CHECK(server.SendFrame(0x2, big.data(), big.size()));
+
+	AfxWebSocketTests_PollFor(webSocket, receiver, 3);
+	AFX_CHECK(3 == receiver.Messages.size());
+	AFX_CHECK(std::vector<unsigned char>({ 'a', 'b', 'c' }) == receiver.Messages[0]);
+	AFX_CHECK(std::vector<unsigned char>({ 'd', 'e', 'f', 'g' }) == receiver.Messages[1]);
+	AFX_CHECK(3 == receiver.Messages.size() && big == receiver.Messages[2]);
+}
+
+AFX_TEST(AfxWebSocket_PingAndClose)
+{
+	CWebSocketTestServer server;
+	CAfxWebSocket webSocket;
+	AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+
+	CAfxWebSocketTests_Receiver receiver;
+
+	AFX_CHECK(server.SendFrame(0x9, "ping", 4));
+	webSocket.Wait(1000);
+	webSocket.Poll(&receiver);
+
+	unsigned char opcode;
+	std::vector<unsigned char> payload;
+	AFX_CHECK(server.ReceiveFrame(opcode, payload));
+	AFX_CHECK(0xa == opcode && std::vector<unsigned char>({ 'p', 'i', 'n', 'g' }) == payload);
+
+	// Queued data is still sent before the close:
+	webSocket.SendBinary("last", 4);
+	webSocket.Close();
+	AFX_CHECK(CAfxWebSocket::State_Closing == webSocket.GetState());
+	webSocket.Poll(&receiver);
+	AFX_CHECK(CAfxWebSocket::State_Closed == webSocket.GetState());
+
+	AFX_CHECK(server.ReceiveFrame(opcode, payload));
+	AFX_CHECK(0x2 == opcode && 4 == payload.size());
+	AFX_CHECK(server.ReceiveFrame(opcode, payload));
+	AFX_CHECK(0x8 == opcode);
+
+	// Close by the server is answered:
+	CWebSocketTestServer server2;
+	CAfxWebSocket webSocket2;
+	AFX_CHECK(AfxWebSocketTests_Open(server2, webSocket2));
+	AFX_CHECK(server2.SendFrame(0x8, "", 0));
+	AfxWebSocketTests_PollFor(webSocket2, receiver, 1);
+	AFX_CHECK(CAfxWebSocket::State_Closed == webSocket2.GetState());
+	AFX_CHECK(server2.ReceiveFrame(opcode, payload));
+	AFX_CHECK(0x8 == opcode);
+
+	// Lost connection:
+	CWebSocketTestServer server3;
+	CAfxWebSocket webSocket3;
+	AFX_CHECK(AfxWebSocketTests_Open(server3, webSocket3));
+	server3.Disconnect();
+	AfxWebSocketTests_PollFor(webSocket3, receiver, 1);
+	AFX_CHECK(CAfxWebSocket::State_Closed == webSocket3.GetState());
+
+	AFX_CHECK(0 == receiver.Messages.size());
+	AFX_CHECK(!webSocket3.Open("ws://127.0.0.1:1/"));
+	AFX_CHECK(!webSocket3.Open("http://127.0.0.1/"));
+}
+
+AFX_TEST(AfxWebSocket_MaxPendingSendSize)
+{
+	CWebSocketTestServer server;
+	CAfxWebSocket webSocket;
+	AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+	AFX_CHECK(64 * 1024 == webSocket.GetMaxPendingSendSize());
+
+	CAfxWebSocketTests_Receiver receiver;
+
+	// The server doesn't read, so once the socket buffers are full, SendBinary refuses:
+	std::vector<unsigned char> message(16 * 1024, 'x');
+	size_t sent = 0;
+	for (int i = 0; i < 100000 && webSocket.SendBinary(message.data(), message.size()); ++i)
+	{
+		++sent;
+		webSocket.Poll(&receiver);
+	}
+
+	AFX_CHECK(webSocket.GetMaxPendingSendSize() <= webSocket.GetPendingSendSize());
+	AFX_CHECK(webSocket.GetPendingSendSize() < webSocket.GetMaxPendingSendSize() + message.size() + 16);
+
+	// Once the server reads, it's sent and SendBinary accepts again:
+	std::thread thread([&] {
+		while (0 < webSocket.GetPendingSendSize() && CAfxWebSocket::State_Open == webSocket.GetState())
+		{
+			webSocket.Wait(100);
+			webSocket.Poll(&receiver);
+		}
+	});
+
+	unsigned char opcode;
+	std::vector<unsigned char> payload;
+	size_t received = 0;
+	while (received < sent && server.ReceiveFrame(opcode, payload) && message == payload)
+		++received;
+
+	thread.join();
+
+	AFX_CHECK(sent == received);
+	AFX_CHECK(webSocket.SendBinary(message.data(), message.size()));
+}
+
+AFX_TEST(AfxWebSocket_WaitAndWake)
+{
+	CWebSocketTestServer server;
+	CAfxWebSocket webSocket;
+	AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+
+	CAfxWebSocketTests_Receiver receiver;
+
+	// Idle: Wait blocks until the timeout, instead of spinning:
+	auto start = std::chrono::steady_clock::now();
+	int waits = 0;
+	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50))
+	{
+		webSocket.Wait(20);
+		webSocket.Poll(&receiver);
+		++waits;
+	}
+	AFX_CHECK(waits <= 4);
+
+	// Wake from another thread ends a Wait without timeout:
+	std::thread thread([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		webSocket.Wake();
+	});
+	webSocket.Wait();
+	thread.join();
+
+	// Wakes before the Wait are not lost:
+	webSocket.Wake();
+	webSocket.Wake();
+	webSocket.Wait();
+
+	// Received data ends it too:
+	AFX_CHECK(server.SendFrame(0x2, "x", 1));
+	webSocket.Wait();
+	webSocket.Poll(&receiver);
+	AFX_CHECK(1 == receiver.Messages.size());
+
+	// And all wakes have been consumed:
+	start = std::chrono::steady_clock::now();
+	webSocket.Wait(20);
+	AFX_CHECK(std::chrono::milliseconds(15) <= std::chrono::steady_clock::now() - start);
+}
+
+AFX_TEST(AfxWebSocket_Deflate)
+{
+	CAfxWebSocketTests_Receiver receiver;
+	unsigned char opcode;
+	std::vector<unsigned char> payload;
+
+	std::vector<unsigned char> message;
+	for (int i = 0; i < 1000; ++i) message.insert(message.end(), (unsigned char const *)"cam\0gameEvent\0", (unsigned char const *)"cam\0gameEvent\0" + 14);
+
+	// Not accepted by the server (i.e. an older one), so not used:
+	{
+		CWebSocketTestServer server;
+		CAfxWebSocket webSocket;
+		webSocket.SetDeflate(true);
+		AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+		AFX_CHECK(!webSocket.GetDeflateActive());
+
+		webSocket.SendBinary(message.data(), message.size());
+		webSocket.Poll(&receiver);
+		AFX_CHECK(server.ReceiveFrame(opcode, payload));
+		AFX_CHECK(!server.GetReceivedCompressed() && message == payload);
+	}
+
+	CWebSocketTestServer server;
+	server.SetDeflate(true);
+	CAfxWebSocket webSocket;
+	webSocket.SetDeflate(true);
+	AFX_CHECK(AfxWebSocketTests_Open(server, webSocket));
+	AFX_CHECK(webSocket.GetDeflateActive());
+
+	// The context is kept between messages, so repeated ones get smaller:
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned char const * data[2] = { message.data(), message.data() + 100 };
+		size_t size[2] = { 100, message.size() - 100 };
+		webSocket.SendBinary(data, size, 2);
+		webSocket.Poll(&receiver);
+
+		size_t receivedBytes = server.GetReceivedBytes();
+		AFX_CHECK(server.ReceiveFrame(opcode, payload));
+		AFX_CHECK(server.GetReceivedCompressed() && 0x2 == opcode && message == payload);
+		AFX_CHECK(server.GetReceivedBytes() - receivedBytes < (0 == i ? 100 : 50));
+	}
+
+	// Compressed and uncompressed from the server:
+	AFX_CHECK(server.SendFrame(0x2, message.data(), message.size(), true, true));
+	AFX_CHECK(server.SendFrame(0x2, "abc", 3));
+	AFX_CHECK(server.SendFrame(0x2, message.data(), message.size(), true, true));
+
+	AfxWebSocketTests_PollFor(webSocket, receiver, 3);
+	AFX_CHECK(3 == receiver.Messages.size());
+	AFX_CHECK(3 == receiver.Messages.size() && message == receiver.Messages[0] && 3 == receiver.Messages[1].size() && message == receiver.Messages[2]);
+}
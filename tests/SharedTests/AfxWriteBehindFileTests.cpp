@@ -0,0 +1,117 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/AfxWriteBehindFile.h>
+
+#include <zlib.h>
+
+#include <vector>
+
+AFX_TEST(AfxWriteBehindFile_WritesInOrder)
+{
+	std::vector<unsigned char> expected;
+
+	{
+		CAfxWriteBehindFile file;
+		AFX_CHECK(file.Open(L"SharedTests_writebehind.bin"));
+		AFX_CHECK(file.IsOpen());
+
+		std::vector<unsigned char> buffer;
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			for (int j = 0; j <= i % 37; ++j)
+			{
+				buffer.push_back((unsigned char)(i + j));
+			}
+
+			expected.insert(expected.end(), buffer.begin(), buffer.end());
+
+			file.Write(buffer);
+			AFX_CHECK(buffer.empty());
+			AFX_CHECK(file.GetSize() == expected.size());
+		}
+
+		AFX_CHECK(file.Close());
+		AFX_CHECK(!file.IsOpen());
+	}
+
+	std::vector<unsigned char> data;
+
+	if (FILE * file = fopen("SharedTests_writebehind.bin", "rb"))
+	{
+		int c;
+		while (EOF != (c = fgetc(file))) data.push_back((unsigned char)c);
+		fclose(file);
+	}
+
+	remove("SharedTests_writebehind.bin");
+
+	AFX_CHECK(data == expected);
+}
+
+AFX_TEST(AfxWriteBehindFile_NotOpen)
+{
+	CAfxWriteBehindFile file;
+
+	std::vector<unsigned char> buffer(10, 1);
+	file.Write(buffer);
+
+	AFX_CHECK(!file.IsOpen());
+	AFX_CHECK(buffer.empty());
+	AFX_CHECK(0 == file.GetSize());
+	AFX_CHECK(file.Close());
+}
+
+AFX_TEST(AfxWriteBehindFile_CompressedBlocks)
+{
+	{
+		CAfxWriteBehindFile file;
+		AFX_CHECK(file.Open(L"SharedTests_writebehind.bin"));
+
+		std::vector<unsigned char> buffer(3, 'a');
+		file.Write(buffer);
+
+		buffer.assign(100000, 'b');
+		file.Write(buffer, true);
+		AFX_CHECK(buffer.empty());
+
+		buffer.assign(2, 'c');
+		file.Write(buffer);
+
+		AFX_CHECK(file.GetSize() == 100005);
+		AFX_CHECK(file.Close());
+	}
+
+	std::vector<unsigned char> data;
+
+	if (FILE * file = fopen("SharedTests_writebehind.bin", "rb"))
+	{
+		int c;
+		while (EOF != (c = fgetc(file))) data.push_back((unsigned char)c);
+		fclose(file);
+	}
+
+	remove("SharedTests_writebehind.bin");
+
+	AFX_CHECK(3 + 8 + 2 < data.size());
+	if (data.size() <= 3 + 8 + 2) return;
+
+	AFX_CHECK(data[0] == 'a' && data[2] == 'a');
+
+	uLong rawSize = data[3] | (data[4] << 8) | (data[5] << 16) | ((uLong)data[6] << 24);
+	uLong compressedSize = data[7] | (data[8] << 8) | (data[9] << 16) | ((uLong)data[10] << 24);
+
+	AFX_CHECK(rawSize == 100000);
+	AFX_CHECK(compressedSize < 1000);
+	AFX_CHECK(data.size() == 3 + 8 + compressedSize + 2);
+	if (data.size() != 3 + 8 + compressedSize + 2) return;
+
+	std::vector<unsigned char> raw(rawSize);
+	uLongf rawLen = rawSize;
+	AFX_CHECK(Z_OK == uncompress(&raw[0], &rawLen, &data[11], compressedSize));
+	AFX_CHECK(rawLen == 100000 && raw == std::vector<unsigned char>(100000, 'b'));
+
+	AFX_CHECK(data[11 + compressedSize] == 'c' && data[12 + compressedSize] == 'c');
+}
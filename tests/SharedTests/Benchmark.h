@@ -0,0 +1,46 @@
+#pragma once
+
+// Minimal benchmark registry, results can be written as JSON for tracking
+// them over time.
+
+#include <stddef.h>
+
+namespace AfxBenchmark {
+
+class State
+{
+public:
+	/// <summary>Number of operations the benchmark has to run.</summary>
+	size_t Iterations;
+
+	/// <summary>Call after expensive setup, so it is not measured.</summary>
+	void StartTimer(void);
+
+	/// <summary>Call before expensive cleanup, so it is not measured.</summary>
+	void StopTimer(void);
+
+	double TimerStart;
+
+	/// <summary>0 if not stopped.</summary>
+	double TimerStop;
+
+	/// <summary>Optional output size per operation (e.g. bytes per encoded frame), reported if not 0.</summary>
+	double BytesPerOp;
+
+	/// <summary>Optional count per operation (e.g. node evaluations per frame), reported if not 0.</summary>
+	double ItemsPerOp;
+};
+
+typedef void (* BenchmarkFn_t)(State & state);
+
+bool Register(char const * name, BenchmarkFn_t fn);
+
+/// <summary>Sink for results, so the compiler can't optimize the work away.</summary>
+extern volatile double g_Sink;
+
+} // namespace AfxBenchmark {
+
+#define AFX_BENCHMARK(name) \
+	static void AfxBenchmark_##name(AfxBenchmark::State & state); \
+	static bool AfxBenchmark_##name##_registered = AfxBenchmark::Register(#name, AfxBenchmark_##name); \
+	static void AfxBenchmark_##name(AfxBenchmark::State & state)
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+
+#include "Benchmark.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace AfxBenchmark {
+
+struct Benchmark
+{
+	char const * Name;
+	BenchmarkFn_t Fn;
+};
+
+static std::vector<Benchmark> & GetBenchmarks()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+volatile double g_Sink = 0;
+
+static double GetSeconds(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void State::StartTimer(void)
+{
+	TimerStart = GetSeconds();
+	TimerStop = 0;
+}
+
+void State::StopTimer(void)
+{
+	TimerStop = GetSeconds();
+}
+
+bool Register(char const * name, BenchmarkFn_t fn)
+{
+	Benchmark benchmark = { name, fn };
+	GetBenchmarks().push_back(benchmark);
+	return true;
+}
+
+} // namespace AfxBenchmark {
+
+/// <summary>
+///   Usage: SharedBenchmarks [--quick] [--json &lt;file&gt;] [prefix]<br />
+///   --quick only checks that the benchmarks run (used by ctest).
+/// </summary>
+int main(int argc, char * argv[])
+{
+	bool quick = false;
+	char const * jsonFileName = nullptr;
+	char const * filter = "";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (0 == strcmp("--quick", argv[i])) quick = true;
+		else if (0 == strcmp("--json", argv[i]) && i + 1 < argc) jsonFileName = argv[++i];
+		else filter = argv[i];
+	}
+
+	double minSeconds = quick ? 0.0 : 0.25;
+
+	std::string json = "{\"benchmarks\":[";
+	bool first = true;
+
+	std::vector<AfxBenchmark::Benchmark> & benchmarks = AfxBenchmark::GetBenchmarks();
+
+	for (size_t i = 0; i < benchmarks.size(); ++i)
+	{
+		if (0 != strncmp(filter, benchmarks[i].Name, strlen(filter))) continue;
+
+		AfxBenchmark::State state;
+		double seconds;
+
+		// Double the iterations until the run takes long enough to be meaningful:
+		for (state.Iterations = 1; ; state.Iterations *= 2)
+		{
+			state.BytesPerOp = 0;
+			state.ItemsPerOp = 0;
+			state.StartTimer();
+			benchmarks[i].Fn(state);
+			seconds = (state.TimerStop ? state.TimerStop : AfxBenchmark::GetSeconds()) - state.TimerStart;
+
+			if (minSeconds <= seconds || ((size_t)1 << 30) <= state.Iterations) break;
+		}
+
+		double nsPerOp = 1e9 * seconds / state.Iterations;
+
+		char entry[512];
+
+		printf("%-40s %12zu %16.1f ns/op", benchmarks[i].Name, state.Iterations, nsPerOp);
+		_snprintf_s(entry, _TRUNCATE, "%s{\"name\":\"%s\",\"iterations\":%zu,\"ns_per_op\":%.3f", first ? "" : ",", benchmarks[i].Name, state.Iterations, nsPerOp);
+		json += entry;
+
+		if (state.BytesPerOp)
+		{
+			printf(" %12.1f bytes/op", state.BytesPerOp);
+			_snprintf_s(entry, _TRUNCATE, ",\"bytes_per_op\":%.3f", state.BytesPerOp);
+			json += entry;
+		}
+
+		if (state.ItemsPerOp)
+		{
+			printf(" %12.1f items/op", state.ItemsPerOp);
+			_snprintf_s(entry, _TRUNCATE, ",\"items_per_op\":%.3f", state.ItemsPerOp);
+			json += entry;
+		}
+
+		printf("\n");
+		json += "}";
+		first = false;
+	}
+
+	json += "]}\n";
+
+	if (jsonFileName)
+	{
+		FILE * file = fopen(jsonFileName, "wb");
+		if (nullptr == file || 1 != fwrite(json.c_str(), json.size(), 1, file))
+		{
+			fprintf(stderr, "Error: Could not write %s.\n", jsonFileName);
+			if (file) fclose(file);
+			return 1;
+		}
+		fclose(file);
+	}
+
+	return 0;
+}
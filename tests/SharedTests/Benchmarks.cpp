@@ -0,0 +1,1662 @@
+#include "stdafx.h"
+
+#include "Benchmark.h"
+#include "WebSocketTestServer.h"
+
+#include <shared/AfxByteRing.h>
+#include <shared/AfxColorLut.h>
+#include <shared/AfxEventIdCache.h>
+#include <shared/AfxFrameCache.h>
+#include <shared/AfxGameRecord.h>
+#include <shared/AfxGameRecordParser.h>
+#include <shared/AfxInteropReplay.h>
+#include <shared/AfxInteropSharedMemory.h>
+#include <shared/AfxInteropStandIn.h>
+#include <shared/AfxInteropStream.h>
+#include <shared/AfxPglProtocol.h>
+#include <shared/AfxWebSocket.h>
+#include <shared/AfxWriteBehindFile.h>
+#include <shared/bvhexport.h>
+#include <shared/bvhimport.h>
+#include <shared/CamPath.h>
+#include <shared/CamPathTrajectory.h>
+#include <shared/EasySampler.h>
+#include <shared/ParseTools.h>
+#include <shared/RawOutput.h>
+
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void Benchmarks_FillCamPath(CamPath & camPath, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		camPath.Add(i + 0.3 * (i % 2), CamPathValue(100.0 * i, 50.0 * sin((double)i), 10.0 * i, 5.0 * sin(0.1 * i), 20.0 * i, 0.0, 90.0));
+	}
+}
+
+static void Benchmarks_EvalCamPath(AfxBenchmark::State & state, CamPath::SpeedInterp speedInterp)
+{
+	CamPath camPath;
+	Benchmarks_FillCamPath(camPath, 100);
+	camPath.SpeedInterpMethod_set(speedInterp);
+
+	double lower = camPath.GetLowerBound();
+	double range = camPath.GetUpperBound() - lower;
+
+	camPath.Eval(lower); // Rebuild outside of timing.
+
+	state.StartTimer();
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		sum += camPath.Eval(lower + range * (double)(i % 1000) / 1000).X;
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(CamPath_Eval_DefaultSpeed)
+{
+	Benchmarks_EvalCamPath(state, CamPath::SI_DEFAULT);
+}
+
+AFX_BENCHMARK(CamPath_Eval_ConstantSpeed)
+{
+	Benchmarks_EvalCamPath(state, CamPath::SI_CONSTANT);
+}
+
+AFX_BENCHMARK(CamPath_ArcLength_Rebuild)
+{
+	CamPath camPath;
+	Benchmarks_FillCamPath(camPath, 100);
+	camPath.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+
+	state.StartTimer();
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		// Changing the interpolation method rebuilds the whole table:
+		camPath.PositionInterpMethod_set(0 == i % 2 ? CamPath::DI_CUBIC : CamPath::DI_DEFAULT);
+		sum += camPath.GetArcLength();
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(CamPath_ArcLength_EditKey_500Keys)
+{
+	CamPath camPath;
+	Benchmarks_FillCamPath(camPath, 500);
+	camPath.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+	camPath.GetArcLength();
+
+	CamPathIterator it = camPath.GetBegin();
+	for (int i = 0; i < 250; ++i) ++it;
+	double time = it.GetTime();
+	CamPathValue value = it.GetValue();
+
+	state.StartTimer();
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		// Like dragging a keyframe in the middle of the path:
+		value.X += 0 == i % 2 ? 10.0 : -10.0;
+		camPath.Add(time, value);
+		sum += camPath.GetArcLength();
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(CamPath_SaveLoadBinary_10k)
+{
+	CamPath camPath;
+	Benchmarks_FillCamPath(camPath, 10000);
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		CamPath loaded;
+		camPath.SaveBinary(L"SharedBenchmarks_campath.bin");
+		loaded.Load(L"SharedBenchmarks_campath.bin");
+		AfxBenchmark::g_Sink = (double)loaded.GetSize();
+	}
+
+	remove("SharedBenchmarks_campath.bin");
+}
+
+struct Benchmarks_QSpline
+{
+	static const int N = 50;
+
+	double X[N];
+	double Y[N][4];
+	double H[N - 1];
+	double DTheta[N - 1];
+	double E[N - 1][3];
+	double W[N][3];
+
+	std::vector<QSplineSegment> Segments;
+
+	Benchmarks_QSpline()
+	: Segments(N - 1)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			Quaternion q = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(10.0 * sin(0.3 * i), 25.0 * i, 0.0)));
+			X[i] = i;
+			Y[i][0] = q.X;
+			Y[i][1] = q.Y;
+			Y[i][2] = q.Z;
+			Y[i][3] = q.W;
+		}
+
+		double wi[3] = { 0, 0, 0 };
+		double wf[3] = { 0, 0, 0 };
+
+		qspline_init(N, 2, AFX_MATH_EPS, wi, wf, X, Y, H, DTheta, E, W);
+		qspline_segments(N, X, Y, H, DTheta, E, W, &Segments[0]);
+	}
+};
+
+AFX_BENCHMARK(AfxMath_QSpline_Interp)
+{
+	Benchmarks_QSpline qspline;
+
+	state.StartTimer();
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		double q[4], omega[3], alpha[3];
+		qspline_interp(qspline.N, (double)(i % 4900) / 100, qspline.X, qspline.Y, qspline.H, qspline.DTheta, qspline.E, qspline.W, q, omega, alpha);
+		sum += q[3];
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(AfxMath_QSpline_SegmentsInterp)
+{
+	Benchmarks_QSpline qspline;
+
+	state.StartTimer();
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		double q[4];
+		qspline_segments_interp(qspline.N, (double)(i % 4900) / 100, &qspline.Segments[0], q);
+		sum += q[3];
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+class Benchmarks_NullPrinter : public IFramePrinter
+{
+public:
+	virtual void Print(unsigned char const * data)
+	{
+		AfxBenchmark::g_Sink = data[0];
+	}
+};
+
+AFX_BENCHMARK(EasyByteSampler_Sample_1280x720)
+{
+	const int width = 1280 * 3;
+	const int height = 720;
+
+	std::vector<unsigned char> input(width * height, 100);
+	Benchmarks_NullPrinter printer;
+	EasySamplerSettings settings(width, height, EasySamplerSettings::ESM_Trapezoid, 1.0 / 30, 0, 1.0, 1.0f);
+	EasyByteSampler sampler(settings, width, &printer);
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		sampler.Sample(&input[0], i / 120.0);
+	}
+}
+
+static int __stdcall Benchmarks_Invert(float r, float g, float b, float a, float & outR, float & outG, float & outB, float & outA)
+{
+	outR = 1.0f - r;
+	outG = 1.0f - g;
+	outB = 1.0f - b;
+	outA = a;
+	return 1;
+}
+
+AFX_BENCHMARK(AfxColorLut_Query)
+{
+	CAfxColorLut lut;
+	lut.New(32, 32, 32, 2);
+	lut.IteratePut(Benchmarks_Invert);
+
+	state.StartTimer();
+
+	float sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		float r, g, b, a;
+		lut.Query((i % 97) / 97.0f, (i % 89) / 89.0f, (i % 83) / 83.0f, 1.0f, r, g, b, a);
+		sum += r;
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(RawOutput_WriteRawTarga_1280x720)
+{
+	const int width = 1280;
+	const int height = 720;
+	const int pitch = CalcPitch(width, 3, 4);
+
+	std::vector<unsigned char> pixels(pitch * height, 0x7f);
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		WriteRawTarga(&pixels[0], L"SharedBenchmarks_raw.tga", width, height, 24, false, pitch);
+	}
+
+	remove("SharedBenchmarks_raw.tga");
+}
+
+static void Benchmarks_FillTrajectoryCamPath(CamPath & camPath, int count, double lift)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		camPath.Add(i, CamPathValue(100.0 * i, 300.0 * sin(0.7 * i), 20.0 * i + (count / 2 == i ? lift : 0.0), 0.0, 10.0 * i, 0.0, 90.0));
+	}
+}
+
+AFX_BENCHMARK(CamPathTrajectory_Build_500Keys)
+{
+	CamPath camPath;
+	Benchmarks_FillTrajectoryCamPath(camPath, 500, 0);
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		CamPathTrajectory trajectory(1.0, 1024);
+		trajectory.Update(camPath);
+		AfxBenchmark::g_Sink = (double)trajectory.GetPoints().size();
+	}
+}
+
+AFX_BENCHMARK(CamPathTrajectory_DragKeyframe_500Keys)
+{
+	CamPath camPath;
+	Benchmarks_FillTrajectoryCamPath(camPath, 500, 0);
+
+	CamPathTrajectory trajectory(1.0, 1024);
+	trajectory.Update(camPath);
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		camPath.Add(250, CamPathValue(100.0 * 250, 300.0 * sin(0.7 * 250), 20.0 * 250 + (double)(1 + i % 50), 0.0, 10.0 * 250, 0.0, 90.0));
+		trajectory.Update(camPath);
+		AfxBenchmark::g_Sink = (double)trajectory.GetPoints().size();
+	}
+}
+
+static const char Benchmarks_CamLine[] = "123.456789 -1024.500000 2048.250000 64.031250 0.000000 -12.750000 179.999990 90.000000\n";
+
+AFX_BENCHMARK(ParseTools_ParseDouble_CamLine)
+{
+	char const * end = Benchmarks_CamLine + sizeof(Benchmarks_CamLine) - 1;
+
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		char const * pos = Benchmarks_CamLine;
+		double value;
+
+		for (int j = 0; j < 8; ++j)
+		{
+			ParseSkipBlanks(pos, end);
+			ParseDouble(pos, end, value);
+			sum += value;
+		}
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(ParseTools_Strtod_CamLine)
+{
+	double sum = 0;
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		char * pos = const_cast<char *>(Benchmarks_CamLine);
+
+		for (int j = 0; j < 8; ++j)
+		{
+			sum += strtod(pos, &pos);
+		}
+	}
+	AfxBenchmark::g_Sink = sum;
+}
+
+AFX_BENCHMARK(BvhImport_Load_10kFrames)
+{
+	if (FILE * file = fopen("SharedBenchmarks_import.bvh", "wb"))
+	{
+		fputs("HIERARCHY\nROOT MdtCam\n{\n\tOFFSET 0.00 0.00 0.00\n\tCHANNELS 6 Xposition Yposition Zposition Zrotation Xrotation Yrotation\n\tEnd Site\n\t{\n\t\tOFFSET 0.00 0.00 -1.00\n\t}\n}\n", file);
+		fputs("MOTION\nFrames:       10000\nFrame Time: 0.010000\n", file);
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			fprintf(file, "%f %f %f %f %f %f\n", 100.0 * sin(0.01 * i), 100.0 * cos(0.01 * i), 0.5 * i, 0.0, 10.0 * sin(0.02 * i), 0.1 * i);
+		}
+
+		fclose(file);
+	}
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		BvhImport bvhImport;
+		bvhImport.LoadMotionFile(L"SharedBenchmarks_import.bvh");
+
+		double camData[6];
+		bvhImport.GetCamPosition(50.0, camData);
+		AfxBenchmark::g_Sink = camData[0];
+	}
+
+	remove("SharedBenchmarks_import.bvh");
+}
+
+AFX_BENCHMARK(BvhBatchExport_WriteFrame_64Entities)
+{
+	const int files = 64;
+
+	BvhBatchExport * bvhExport = new BvhBatchExport(0.01);
+
+	int indices[files];
+
+	for (int i = 0; i < files; ++i)
+	{
+		char fileName[64];
+		_snprintf_s(fileName, _TRUNCATE, "SharedBenchmarks_export_%i.bvh", i);
+
+		std::wstring wideFileName(fileName, fileName + strlen(fileName));
+
+		indices[i] = bvhExport->AddFile(wideFileName.c_str(), "MdtCam");
+	}
+
+	state.StartTimer();
+
+	// One iteration is one frame with all entities (what the render thread pays):
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		for (int j = 0; j < files; ++j)
+		{
+			bvhExport->WriteFrame(indices[j], (double)j, (double)i, 0.5 * i, 0.0, 1.0, 2.0);
+		}
+	}
+
+	state.StopTimer();
+
+	delete bvhExport;
+
+	for (int i = 0; i < files; ++i)
+	{
+		char fileName[64];
+		_snprintf_s(fileName, _TRUNCATE, "SharedBenchmarks_export_%i.bvh", i);
+		remove(fileName);
+	}
+}
+
+AFX_BENCHMARK(AfxWriteBehindFile_AgrFrame_10Players)
+{
+	CAfxWriteBehindFile file;
+	file.Open(L"SharedBenchmarks_writebehind.bin");
+
+	std::vector<unsigned char> buffer;
+
+	state.StartTimer();
+
+	// One iteration is encoding and handing over a frame with 10 players with 128 bones (position and quaternion) each:
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		for (int j = 0; j < 10 * 128; ++j)
+		{
+			float values[7] = { (float)i, (float)j, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+			unsigned char const * bytes = (unsigned char const *)values;
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(values));
+		}
+
+		file.Write(buffer);
+	}
+
+	state.StopTimer();
+
+	file.Close();
+
+	remove("SharedBenchmarks_writebehind.bin");
+}
+
+/// <summary>Model names of a typical CS:GO frame (48 entities), owned by the &quot;engine&quot;, so the pointers are stable.</summary>
+static std::vector<std::string> const & Benchmarks_GetCsgoModelNames(void)
+{
+	static std::vector<std::string> modelNames;
+
+	if (modelNames.empty())
+	{
+		char const * players[4] = { "tm_phoenix_variantf", "tm_leet_variantb", "ctm_sas_variantd", "ctm_fbi_varianta" };
+		char const * weapons[8] = { "rif_ak47", "rif_m4a1_s", "pist_glock18", "pist_hkp2000", "snip_awp", "eq_flashbang", "eq_smokegrenade", "knife_default_ct" };
+
+		// 10 players, 10 weapons in hand, 20 dropped weapons / grenades, 8 other (view models, props):
+		for (int i = 0; i < 10; ++i) modelNames.push_back(std::string("models/player/custom_player/legacy/") + players[i % 4] + ".mdl");
+		for (int i = 0; i < 30; ++i) modelNames.push_back(std::string("models/weapons/w_") + weapons[(3 * i) % 8] + (10 <= i ? "_dropped.mdl" : ".mdl"));
+		for (int i = 0; i < 8; ++i) modelNames.push_back(std::string(i < 2 ? "models/weapons/v_models/arms/glove_hardknuckle/v_glove_hardknuckle.mdl" : "models/props/de_dust/hr_dust/dust_crates/dust_crate_style_01_32x32x32.mdl"));
+	}
+
+	return modelNames;
+}
+
+/// <summary>Dictionary lookups of one AGR frame, as CClientTools does them.</summary>
+template<typename Dictionary> static void Benchmarks_DictionaryFrame(Dictionary & dictionary, std::vector<std::string> const & modelNames, bool copyModelNames)
+{
+	char modelName[128];
+	int sum = dictionary.FindOrAdd("afxFrame");
+
+	for (size_t i = 0; i < modelNames.size(); ++i)
+	{
+		sum += dictionary.FindOrAdd("entity_state");
+		sum += dictionary.FindOrAdd("baseentity");
+
+		if (copyModelNames)
+		{
+			// I.e. a name that was built on the stack:
+			memcpy(modelName, modelNames[i].c_str(), modelNames[i].size() + 1);
+			sum += dictionary.FindOrAdd(modelName);
+		}
+		else
+			sum += dictionary.FindOrAdd(modelNames[i].c_str());
+
+		sum += dictionary.FindOrAdd("baseanimating");
+		sum += dictionary.FindOrAdd("/");
+	}
+
+	sum += dictionary.FindOrAdd("afxCam");
+	sum += dictionary.FindOrAdd("afxHidden");
+	sum += dictionary.FindOrAdd("afxFrameEnd");
+
+	AfxBenchmark::g_Sink += sum;
+}
+
+/// <summary>The dictionary CAfxGameRecordWriter had before CAfxGameRecordDictionary, for comparison.</summary>
+class CBenchmarksMapDictionary
+{
+public:
+	int FindOrAdd(char const * value)
+	{
+		std::string sValue(value);
+
+		std::map<std::string, int>::iterator it = m_Dictionary.find(sValue);
+
+		if (it != m_Dictionary.end())
+			return it->second;
+
+		int index = (int)m_Dictionary.size();
+		m_Dictionary[sValue] = index;
+
+		return -1;
+	}
+
+private:
+	std::map<std::string, int> m_Dictionary;
+};
+
+template<typename Dictionary> static void Benchmarks_Dictionary(AfxBenchmark::State & state, bool copyModelNames)
+{
+	std::vector<std::string> const & modelNames = Benchmarks_GetCsgoModelNames();
+	Dictionary dictionary;
+
+	state.StartTimer();
+
+	// One iteration is a frame with 48 entities (244 lookups):
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		Benchmarks_DictionaryFrame(dictionary, modelNames, copyModelNames);
+	}
+
+	state.StopTimer();
+}
+
+AFX_BENCHMARK(AfxGameRecordDictionary_CsgoFrame)
+{
+	Benchmarks_Dictionary<CAfxGameRecordDictionary>(state, false);
+}
+
+AFX_BENCHMARK(AfxGameRecordDictionary_CsgoFrame_CopiedNames)
+{
+	Benchmarks_Dictionary<CAfxGameRecordDictionary>(state, true);
+}
+
+AFX_BENCHMARK(AfxGameRecordDictionary_CsgoFrame_StdMap)
+{
+	Benchmarks_Dictionary<CBenchmarksMapDictionary>(state, false);
+}
+
+static void Benchmarks_WriteAgrFile(AfxBenchmark::State & state, int version)
+{
+	CAfxGameRecordWriter writer;
+	writer.Open(L"SharedBenchmarks_record.agr", version);
+
+	state.StartTimer();
+
+	// One iteration is a frame with 10 players with 128 bones each, moving like in a real demo (small changes between frames):
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		writer.WriteDictionary("afxFrame");
+		writer.Write(1.0f / 60);
+		writer.Write((int)0);
+
+		for (int player = 0; player < 10; ++player)
+		{
+			writer.WriteDictionary("entity_state");
+			writer.Write(player);
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.BeginBones(player, 128);
+
+			for (int bone = 0; bone < 128; ++bone)
+			{
+				double t = 0.02 * i + 0.1 * bone + player;
+				float position[3] = { (float)(100 * player + 5 * sin(t) + 0.5 * i), (float)(-300 + bone + 3 * cos(t)), (float)(64 + 0.25 * bone) };
+				float rotation[4] = { (float)(0.5 * sin(t)), (float)(0.25 * cos(t)), 0.1f, (float)sqrt(1 - 0.25 * sin(t) * sin(t) - 0.0625 * cos(t) * cos(t) - 0.01) };
+				writer.WriteBone(position, rotation);
+			}
+
+			writer.WriteDictionary("/");
+			writer.Write(false);
+		}
+
+		writer.WriteDictionary("afxFrameEnd");
+		writer.EndFrame();
+	}
+
+	state.StopTimer();
+
+	writer.Close();
+}
+
+static void Benchmarks_WriteAgr(AfxBenchmark::State & state, int version)
+{
+	Benchmarks_WriteAgrFile(state, version);
+
+	if (FILE * file = fopen("SharedBenchmarks_record.agr", "rb"))
+	{
+		fseek(file, 0, SEEK_END);
+		state.BytesPerOp = (double)ftell(file) / state.Iterations;
+		fclose(file);
+	}
+
+	remove("SharedBenchmarks_record.agr");
+}
+
+AFX_BENCHMARK(AfxGameRecord_Write_v5_10Players)
+{
+	Benchmarks_WriteAgr(state, AFXGAMERECORD_VERSION_RAW);
+}
+
+AFX_BENCHMARK(AfxGameRecord_Write_v6_10Players)
+{
+	Benchmarks_WriteAgr(state, AFXGAMERECORD_VERSION_COMPRESSED);
+}
+
+/// <summary>
+///   One iteration is a frame of a typical CS:GO round: 8 alive players (128 bones), 2 dead players (static ragdolls),
+///   8 weapons in hand (moving with the players) and 20 dropped weapons / static props (7 bones each).
+/// </summary>
+static void Benchmarks_WriteAgrScene(AfxBenchmark::State & state, float unchangedThreshold)
+{
+	CAfxGameRecordWriter writer;
+	writer.SetUnchangedThreshold(unchangedThreshold);
+	writer.Open(L"SharedBenchmarks_record.agr", AFXGAMERECORD_VERSION_COMPRESSED);
+
+	std::vector<std::string> const & modelNames = Benchmarks_GetCsgoModelNames();
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		writer.WriteDictionary("afxFrame");
+		writer.Write(1.0f / 60);
+		writer.Write((int)0);
+
+		for (int entity = 0; entity < 38; ++entity)
+		{
+			bool moving = entity < 8 || (10 <= entity && entity < 18);
+			int numBones = entity < 10 ? 128 : 7;
+			double t = moving ? 0.02 * i : 0;
+
+			writer.BeginEntity(entity);
+			writer.WriteDictionary("baseentity");
+			writer.WriteDictionary(modelNames[entity].c_str());
+			writer.Write(true);
+			float origin[6] = { (float)(100 * entity + (moving ? 0.5 * i : 0)), -300.0f, 64.0f, 0.0f, (float)(90 + 10 * sin(t)), 0.0f };
+			writer.Write(origin, 6);
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.BeginBones(entity, numBones);
+
+			for (int bone = 0; bone < numBones; ++bone)
+			{
+				double u = t + 0.1 * bone + entity;
+				float position[3] = { (float)(origin[0] + 5 * sin(u)), (float)(-300 + bone + 3 * cos(u)), (float)(64 + 0.25 * bone) };
+				float rotation[4] = { (float)(0.5 * sin(u)), (float)(0.25 * cos(u)), 0.1f, (float)sqrt(1 - 0.25 * sin(u) * sin(u) - 0.0625 * cos(u) * cos(u) - 0.01) };
+				writer.WriteBone(position, rotation);
+			}
+
+			writer.WriteDictionary("/");
+			writer.Write(false);
+			writer.EndEntity();
+		}
+
+		writer.WriteDictionary("afxFrameEnd");
+		writer.EndFrame();
+	}
+
+	state.StopTimer();
+
+	writer.Close();
+
+	if (FILE * file = fopen("SharedBenchmarks_record.agr", "rb"))
+	{
+		fseek(file, 0, SEEK_END);
+		state.BytesPerOp = (double)ftell(file) / state.Iterations;
+		fclose(file);
+	}
+
+	remove("SharedBenchmarks_record.agr");
+}
+
+AFX_BENCHMARK(AfxGameRecord_Write_v6_CsgoScene)
+{
+	Benchmarks_WriteAgrScene(state, -1);
+}
+
+AFX_BENCHMARK(AfxGameRecord_Write_v6_CsgoScene_Unchanged)
+{
+	Benchmarks_WriteAgrScene(state, 0);
+}
+
+static void Benchmarks_ReadAgr(AfxBenchmark::State & state, int version)
+{
+	// Writing is not measured here:
+	AfxBenchmark::State writeState = state;
+	Benchmarks_WriteAgrFile(writeState, version);
+
+	CAfxGameRecordReader reader;
+	reader.Open(L"SharedBenchmarks_record.agr");
+
+	std::string token;
+	std::vector<float> positions;
+	std::vector<float> rotations;
+	size_t bones = 0;
+
+	state.StartTimer();
+
+	while (!reader.IsEnd() && reader.ReadDictionary(token))
+	{
+		if (0 == token.compare("afxFrame"))
+		{
+			float frameTime;
+			int hiddenOffset;
+			reader.Read(frameTime);
+			reader.Read(hiddenOffset);
+		}
+		else if (0 == token.compare("entity_state"))
+		{
+			int handle;
+			bool hasBones;
+			bool viewModel;
+			reader.Read(handle);
+			reader.ReadDictionary(token);
+			reader.Read(hasBones);
+			reader.ReadBones(handle, positions, rotations);
+			bones += positions.size() / 3;
+			reader.ReadDictionary(token);
+			reader.Read(viewModel);
+		}
+	}
+
+	state.StopTimer();
+
+	AfxBenchmark::g_Sink = (double)bones;
+
+	reader.Close();
+
+	remove("SharedBenchmarks_record.agr");
+}
+
+AFX_BENCHMARK(AfxGameRecord_Read_v5_10Players)
+{
+	Benchmarks_ReadAgr(state, AFXGAMERECORD_VERSION_RAW);
+}
+
+AFX_BENCHMARK(AfxGameRecord_Read_v6_10Players)
+{
+	Benchmarks_ReadAgr(state, AFXGAMERECORD_VERSION_COMPRESSED);
+}
+
+class CBenchmarksAgrVisitor : public IAfxGameRecordVisitor
+{
+public:
+	size_t Bones = 0;
+
+	virtual void OnFrame(int /*frame*/, float /*frameTime*/) {}
+	virtual void OnCamera(float const * /*values*/) {}
+	virtual void OnEntity(AfxGameRecordEntity const & entity) { Bones += entity.NumBones; }
+	virtual void OnDeleted(int /*handle*/) {}
+	virtual void OnHidden(int /*count*/, int const * /*handles*/) {}
+	virtual void OnFrameEnd(int /*frame*/) {}
+};
+
+static void Benchmarks_ParseAgr(AfxBenchmark::State & state, int version)
+{
+	// Writing is not measured here:
+	AfxBenchmark::State writeState = state;
+	Benchmarks_WriteAgrFile(writeState, version);
+
+	CAfxGameRecordParser parser;
+	CBenchmarksAgrVisitor visitor;
+
+	state.StartTimer();
+
+	parser.Open(L"SharedBenchmarks_record.agr");
+	parser.Parse(&visitor);
+
+	state.StopTimer();
+
+	state.BytesPerOp = (double)parser.GetFileSize() / state.Iterations;
+	AfxBenchmark::g_Sink = (double)visitor.Bones;
+
+	parser.Close();
+
+	remove("SharedBenchmarks_record.agr");
+}
+
+AFX_BENCHMARK(AfxGameRecordParser_Parse_v5_10Players)
+{
+	Benchmarks_ParseAgr(state, AFXGAMERECORD_VERSION_RAW);
+}
+
+AFX_BENCHMARK(AfxGameRecordParser_Parse_v6_10Players)
+{
+	Benchmarks_ParseAgr(state, AFXGAMERECORD_VERSION_COMPRESSED);
+}
+
+/// <summary>
+///   Stand-in for MirvPgl's WebSocket connection and server: frames the data
+///   like the client (header and masked payload in a tx buffer, as
+///   easywsclient does) and parses it like a server would (unmask, walk the
+///   messages).
+/// </summary>
+class CBenchmarksWebSocketStandIn
+{
+public:
+	size_t Messages;
+	size_t Bytes;
+
+	CBenchmarksWebSocketStandIn()
+	: Messages(0)
+	, Bytes(0)
+	{
+	}
+
+	void SendBinary(std::vector<unsigned char> const & message)
+	{
+		static const unsigned char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+		size_t size = message.size();
+
+		m_TxBuffer.clear();
+		m_TxBuffer.push_back(0x82); // FIN, binary frame.
+		if (size < 126)
+			m_TxBuffer.push_back((unsigned char)(0x80 | size));
+		else if (size < 65536)
+		{
+			m_TxBuffer.push_back(0x80 | 126);
+			for (int i = 1; i >= 0; --i) m_TxBuffer.push_back((unsigned char)(size >> (8 * i)));
+		}
+		else
+		{
+			m_TxBuffer.push_back(0x80 | 127);
+			for (int i = 7; i >= 0; --i) m_TxBuffer.push_back((unsigned char)((unsigned long long)size >> (8 * i)));
+		}
+		m_TxBuffer.insert(m_TxBuffer.end(), mask, mask + 4);
+
+		size_t headerSize = m_TxBuffer.size();
+		m_TxBuffer.insert(m_TxBuffer.end(), message.begin(), message.end());
+		for (size_t i = 0; i < size; ++i) m_TxBuffer[headerSize + i] ^= mask[i & 3];
+
+		// Server:
+
+		m_RxBuffer.resize(size);
+		for (size_t i = 0; i < size; ++i) m_RxBuffer[i] = m_TxBuffer[headerSize + i] ^ mask[i & 3];
+
+		char const * pos = (char const *)m_RxBuffer.data();
+		char const * end = pos + size;
+
+		while (pos < end)
+		{
+			char const * cmd = pos;
+			pos += strlen(pos) + 1;
+
+			if (0 == strcmp("cam", cmd))
+				pos += 8 * sizeof(float);
+			else if (0 == strcmp("gameEvent", cmd))
+			{
+				pos += strlen(pos) + 1; // Event name.
+				pos += sizeof(int) + 3 * sizeof(float);
+			}
+
+			++Messages;
+		}
+
+		Bytes += size;
+	}
+
+private:
+	std::vector<unsigned char> m_TxBuffer;
+	std::vector<unsigned char> m_RxBuffer;
+};
+
+/// <summary>Serializes a frame with 4 game events and a cam message (194 bytes).</summary>
+template<typename Out> static void Benchmarks_PglFrame(Out & out, size_t frame)
+{
+	char const * eventNames[4] = { "player_footstep", "weapon_fire", "player_hurt", "bullet_impact" };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int userId = (int)(frame % 10);
+		float origin[3] = { (float)frame, (float)i, 64.0f };
+
+		out.Begin();
+		out.Append("gameEvent", 10);
+		out.Append(eventNames[i], strlen(eventNames[i]) + 1);
+		out.Append(&userId, sizeof(userId));
+		out.Append(origin, sizeof(origin));
+		out.End();
+	}
+
+	float cam[8] = { (float)frame / 128, 100.0f, 200.0f, 64.0f, 0.0f, (float)frame, 0.0f, 90.0f };
+
+	out.Begin();
+	out.Append("cam", 4);
+	out.Append(cam, sizeof(cam));
+	out.End();
+}
+
+/// <summary>The transport MirvPgl had before CAfxByteRing (pooled thread data vector, send vector, send thread vector), for comparison.</summary>
+class CBenchmarksPglVectorTransport
+{
+public:
+	CBenchmarksPglVectorTransport()
+	: m_Quit(false)
+	{
+	}
+
+	void Begin(void)
+	{
+	}
+
+	void Append(void const * data, size_t size)
+	{
+		m_Data->insert(m_Data->end(), (unsigned char const *)data, (unsigned char const *)data + size);
+	}
+
+	void End(void)
+	{
+	}
+
+	void Run(AfxBenchmark::State & state, CBenchmarksWebSocketStandIn & webSocket)
+	{
+		std::thread thread(SendThread, this, &webSocket);
+
+		for (size_t i = 0; i < state.Iterations; ++i)
+		{
+			// Main thread (in reality the cam is appended to m_ThreadData on the drawing thread), CThreadDataPool::Acquire:
+			m_Data = &m_NextThreadData;
+			Benchmarks_PglFrame(*this, i);
+			m_ThreadData = m_NextThreadData;
+			m_NextThreadData.clear();
+
+			// Drawing thread, DrawingThread_UnleashData:
+			{
+				std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+				m_DataForSendThread.insert(m_DataForSendThread.end(), m_ThreadData.begin(), m_ThreadData.end());
+			}
+			m_DataForSendThreadCondition.notify_one();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+			m_Quit = true;
+		}
+		m_DataForSendThreadCondition.notify_one();
+
+		thread.join();
+	}
+
+private:
+	std::vector<unsigned char> * m_Data;
+	std::vector<unsigned char> m_NextThreadData;
+	std::vector<unsigned char> m_ThreadData;
+	std::vector<unsigned char> m_DataForSendThread;
+	std::mutex m_DataForSendThreadMutex;
+	std::condition_variable m_DataForSendThreadCondition;
+	bool m_Quit;
+
+	static void SendThread(CBenchmarksPglVectorTransport * self, CBenchmarksWebSocketStandIn * webSocket)
+	{
+		std::vector<unsigned char> sendThreadTempData;
+
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(self->m_DataForSendThreadMutex);
+
+			while (self->m_DataForSendThread.empty() && !self->m_Quit)
+				self->m_DataForSendThreadCondition.wait(lock);
+
+			if (self->m_DataForSendThread.empty())
+				break;
+
+			sendThreadTempData = std::move(self->m_DataForSendThread);
+			self->m_DataForSendThread.clear();
+			lock.unlock();
+
+			webSocket->SendBinary(sendThreadTempData);
+
+			sendThreadTempData.clear();
+		}
+	}
+};
+
+/// <summary>MirvPgl's transport: serialized into a CAfxByteRing in place, sent from its slices.</summary>
+class CBenchmarksPglRingTransport
+{
+public:
+	CBenchmarksPglRingTransport()
+	: m_Ring(1024 * 1024)
+	, m_Quit(false)
+	{
+	}
+
+	void Begin(void)
+	{
+	}
+
+	void Append(void const * data, size_t size)
+	{
+		// MirvPgl drops the message if the ring is full, here all data is supposed to arrive:
+		while (!m_Ring.Write(data, size))
+			std::this_thread::yield();
+	}
+
+	void End(void)
+	{
+	}
+
+	void Run(AfxBenchmark::State & state, CBenchmarksWebSocketStandIn & webSocket)
+	{
+		std::thread thread(SendThread, this, &webSocket);
+
+		for (size_t i = 0; i < state.Iterations; ++i)
+		{
+			Benchmarks_PglFrame(*this, i);
+
+			{
+				std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+				m_Ring.Publish(m_Ring.GetWritePosition());
+			}
+			m_DataForSendThreadCondition.notify_one();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+			m_Quit = true;
+		}
+		m_DataForSendThreadCondition.notify_one();
+
+		thread.join();
+	}
+
+private:
+	CAfxByteRing m_Ring;
+	std::mutex m_DataForSendThreadMutex;
+	std::condition_variable m_DataForSendThreadCondition;
+	bool m_Quit;
+
+	static void SendThread(CBenchmarksPglRingTransport * self, CBenchmarksWebSocketStandIn * webSocket)
+	{
+		std::vector<unsigned char> sendBuffer;
+		unsigned char const * data[2];
+		size_t size[2];
+
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(self->m_DataForSendThreadMutex);
+
+			size_t readable;
+			while (0 == (readable = self->m_Ring.GetReadable(data, size)) && !self->m_Quit)
+				self->m_DataForSendThreadCondition.wait(lock);
+
+			if (0 == readable)
+				break;
+
+			lock.unlock();
+
+			sendBuffer.assign(data[0], data[0] + size[0]);
+			sendBuffer.insert(sendBuffer.end(), data[1], data[1] + size[1]);
+
+			webSocket->SendBinary(sendBuffer);
+
+			self->m_Ring.Consume(readable);
+		}
+	}
+};
+
+template<typename Transport> static void Benchmarks_PglTransport(AfxBenchmark::State & state)
+{
+	Transport transport;
+	CBenchmarksWebSocketStandIn webSocket;
+
+	state.StartTimer();
+
+	// One iteration is a frame, measured until the stand-in server parsed all of them:
+	transport.Run(state, webSocket);
+
+	state.StopTimer();
+
+	state.BytesPerOp = (double)webSocket.Bytes / state.Iterations;
+	AfxBenchmark::g_Sink = (double)webSocket.Messages;
+}
+
+AFX_BENCHMARK(MirvPgl_Transport_Vectors)
+{
+	Benchmarks_PglTransport<CBenchmarksPglVectorTransport>(state);
+}
+
+AFX_BENCHMARK(MirvPgl_Transport_ByteRing)
+{
+	Benchmarks_PglTransport<CBenchmarksPglRingTransport>(state);
+}
+
+/// <summary>
+///   MirvPgl's network thread against a local echo server: a message is
+///   published into the ring, sent and the echo received, one iteration is
+///   such a round trip.
+/// </summary>
+class CBenchmarksPglRoundTrip : public IAfxWebSocketReceiver
+{
+public:
+	/// <param name="polling">Wait like MirvPgl did before (condition variable with 1 ms timeout, received data is only noticed after it), instead of CAfxWebSocket::Wait.</param>
+	CBenchmarksPglRoundTrip(bool polling)
+	: m_Polling(polling)
+	, m_Ring(64 * 1024)
+	, m_Received(0)
+	, m_Quit(false)
+	{
+	}
+
+	virtual void OnBinaryMessage(unsigned char const * /*data*/, size_t /*size*/) override
+	{
+		++m_Received;
+	}
+
+	void Run(AfxBenchmark::State & state)
+	{
+		CWebSocketTestServer server;
+
+		server.BeginAccept();
+		bool opened = m_WebSocket.Open(server.GetUrl().c_str());
+		if (!server.EndAccept() || !opened)
+			return;
+
+		std::thread echoThread(EchoThread, &server);
+		std::thread networkThread(NetworkThread, this);
+
+		state.StartTimer();
+
+		for (size_t i = 0; i < state.Iterations; ++i)
+		{
+			m_Ring.Write("exec\0echo\0", 10);
+
+			{
+				std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
+				m_Ring.Publish(m_Ring.GetWritePosition());
+			}
+
+			if (m_Polling)
+				m_DataForSendThreadCondition.notify_one();
+			else
+				m_WebSocket.Wake();
+
+			while (m_Received <= i)
+				std::this_thread::yield();
+		}
+
+		state.StopTimer();
+
+		m_Quit = true;
+		m_WebSocket.Wake();
+		m_DataForSendThreadCondition.notify_one();
+
+		networkThread.join();
+		server.Disconnect();
+		echoThread.join();
+	}
+
+private:
+	bool m_Polling;
+	CAfxWebSocket m_WebSocket;
+	CAfxByteRing m_Ring;
+	std::atomic<size_t> m_Received;
+	std::atomic_bool m_Quit;
+	std::mutex m_DataForSendThreadMutex;
+	std::condition_variable m_DataForSendThreadCondition;
+
+	static void NetworkThread(CBenchmarksPglRoundTrip * self)
+	{
+		while (!self->m_Quit && CAfxWebSocket::State_Closed != self->m_WebSocket.GetState())
+		{
+			self->m_WebSocket.Poll(self);
+
+			if (self->m_Polling)
+			{
+				std::unique_lock<std::mutex> lock(self->m_DataForSendThreadMutex);
+				unsigned char const * data[2];
+				size_t size[2];
+				self->m_DataForSendThreadCondition.wait_for(lock, std::chrono::milliseconds(1), [self, &data, &size] { return 0 != self->m_Ring.GetReadable(data, size) || self->m_Quit; });
+			}
+
+			unsigned char const * data[2];
+			size_t size[2];
+			size_t readable = self->m_Ring.GetReadable(data, size);
+
+			if (0 < readable && self->m_WebSocket.SendBinary(data, size, 2))
+			{
+				self->m_Ring.Consume(readable);
+				self->m_WebSocket.Poll(self);
+			}
+
+			if (!self->m_Polling)
+				self->m_WebSocket.Wait();
+		}
+
+		self->m_WebSocket.Disconnect();
+	}
+
+	static void EchoThread(CWebSocketTestServer * server)
+	{
+		unsigned char opcode;
+		std::vector<unsigned char> payload;
+
+		while (server->ReceiveFrame(opcode, payload) && 0x2 == opcode)
+		{
+			if (!server->SendFrame(0x2, payload.data(), payload.size()))
+				break;
+		}
+	}
+};
+
+AFX_BENCHMARK(MirvPgl_RoundTrip_Polling1ms)
+{
+	CBenchmarksPglRoundTrip roundTrip(true);
+	roundTrip.Run(state);
+}
+
+AFX_BENCHMARK(MirvPgl_RoundTrip_Wait)
+{
+	CBenchmarksPglRoundTrip roundTrip(false);
+	roundTrip.Run(state);
+}
+
+/// <summary>
+///   A second of a match as MirvPgl sends it (with the enrichments the example
+///   server.js requests): 128 frames with a cam each and the game events of
+///   10 players (footsteps, weapon_fire, bullet_impact, player_hurt, ...).
+/// </summary>
+/// <remarks>One frame is one WebSocket message, compressed per message (context kept) like permessage-deflate.</remarks>
+static void Benchmarks_PglMatch(AfxBenchmark::State & state, uint32_t version, bool deflate)
+{
+	struct Event
+	{
+		int Id;
+		char const * Name;
+		/// <summary>Per second (of all players).</summary>
+		int Rate;
+		char const * Keys[3];
+	};
+
+	static const Event events[] = {
+		{ 101, "player_footstep", 30, { "userid", 0, 0 } },
+		{ 102, "weapon_fire", 6, { "userid", "weapon", 0 } },
+		{ 103, "bullet_impact", 12, { "userid", "x", "y" } },
+		{ 104, "player_hurt", 1, { "userid", "attacker", "weapon" } },
+		{ 105, "weapon_reload", 1, { "userid", 0, 0 } },
+		{ 106, "player_jump", 2, { "userid", 0, 0 } },
+	};
+	static char const * const weapons[] = { "weapon_ak47", "weapon_m4a1", "weapon_awp", "weapon_deagle", "weapon_usp_silencer" };
+
+	CAfxMessageQueue queue(1024 * 1024);
+	CAfxPglWriter writer(queue);
+	writer.SetVersion(version);
+
+	z_stream deflater;
+	memset(&deflater, 0, sizeof(deflater));
+	deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	std::vector<unsigned char> deflated(64 * 1024);
+
+	std::map<int, bool> knownEvents;
+	size_t bytes = 0;
+	size_t frame = 0;
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		for (int tick = 0; tick < 128; ++tick, ++frame)
+		{
+			for (size_t e = 0; e < sizeof(events) / sizeof(events[0]); ++e)
+			{
+				Event const & event = events[e];
+
+				// Spread evenly over the second:
+				if ((tick * event.Rate) / 128 == ((tick + 1) * event.Rate) / 128)
+					continue;
+
+				int player = (int)((frame * 7 + e) % 10);
+
+				writer.Begin();
+				writer.WriteMessage(AfxPglMessage_GameEvent);
+
+				if (knownEvents[event.Id])
+					writer.WriteInt32(event.Id);
+				else
+				{
+					knownEvents[event.Id] = true;
+					writer.WriteInt32(0);
+					writer.WriteInt32(event.Id);
+					writer.WriteCString(event.Name);
+					for (int k = 0; k < 3 && event.Keys[k]; ++k)
+					{
+						writer.WriteBoolean(true);
+						writer.WriteCString(event.Keys[k]);
+						writer.WriteInt32(0 == strcmp("weapon", event.Keys[k]) ? 1 : ('x' == event.Keys[k][0] || 'y' == event.Keys[k][0] ? 2 : 4));
+					}
+					writer.WriteBoolean(false);
+				}
+
+				writer.WriteFloat(frame / 128.0f); // clientTime
+
+				for (int k = 0; k < 3 && event.Keys[k]; ++k)
+				{
+					if (0 == strcmp("weapon", event.Keys[k]))
+						writer.WriteCString(weapons[(frame / 128 + player) % 5]);
+					else if ('x' == event.Keys[k][0] || 'y' == event.Keys[k][0])
+						writer.WriteFloat(1000.0f * (float)sin(0.01 * frame + k));
+					else
+					{
+						int userId = 2 + (player + k) % 10;
+						writer.WriteInt16((int16_t)userId);
+
+						// useridWithSteamId, useridWithEyePosition, useridWithEyeAngles:
+						writer.WriteUInt64(76561197960265728ull + 1000 * userId);
+						for (int j = 0; j < 3; ++j) writer.WriteFloat(500.0f * (float)sin(0.002 * frame + userId + j));
+						for (int j = 0; j < 3; ++j) writer.WriteFloat(90.0f * (float)cos(0.003 * frame + userId + j));
+					}
+				}
+
+				writer.End();
+			}
+
+			float cam[8] = { frame / 128.0f, 1000.0f + 0.5f * frame, -300.0f + 0.25f * frame, 64.0f, (float)(5 * sin(0.01 * frame)), (float)(0.3 * frame), 0.0f, 90.0f };
+
+			writer.BeginLatest(frame / 128.0);
+			writer.WriteMessage(AfxPglMessage_Cam);
+			writer.WriteCam(cam);
+			writer.End();
+
+			// Send thread:
+
+			CAfxByteRing & ring = queue.GetRing();
+			ring.Publish(ring.GetWritePosition());
+
+			unsigned char const * data[2];
+			size_t size[2];
+			size_t readable = ring.GetReadable(data, size);
+
+			if (deflate)
+			{
+				deflater.next_out = deflated.data();
+				deflater.avail_out = (uInt)deflated.size();
+				for (int j = 0; j < 2; ++j)
+				{
+					deflater.next_in = (Bytef *)data[j];
+					deflater.avail_in = (uInt)size[j];
+					::deflate(&deflater, 0 == j ? Z_NO_FLUSH : Z_SYNC_FLUSH);
+				}
+				bytes += deflated.size() - deflater.avail_out - 4;
+			}
+			else
+			{
+				AfxBenchmark::g_Sink = data[0][0];
+				bytes += readable;
+			}
+
+			ring.Consume(readable);
+		}
+	}
+
+	state.StopTimer();
+
+	deflateEnd(&deflater);
+
+	state.BytesPerOp = (double)bytes / state.Iterations;
+}
+
+AFX_BENCHMARK(MirvPgl_MatchSecond_v2)
+{
+	Benchmarks_PglMatch(state, 2, false);
+}
+
+AFX_BENCHMARK(MirvPgl_MatchSecond_v4)
+{
+	Benchmarks_PglMatch(state, 4, false);
+}
+
+AFX_BENCHMARK(MirvPgl_MatchSecond_v2_Deflate)
+{
+	Benchmarks_PglMatch(state, 2, true);
+}
+
+AFX_BENCHMARK(MirvPgl_MatchSecond_v4_Deflate)
+{
+	Benchmarks_PglMatch(state, 4, true);
+}
+
+/// <summary>Stand-in for an interop client: reads a 256 byte frame (about the calc results and commands of a frame) and answers with 64 bytes.</summary>
+static void Benchmarks_InteropStandIn(IAfxInteropTransport * transport)
+{
+	CAfxInteropStream stream(transport);
+	unsigned char frame[256];
+	unsigned char reply[64] = { 0 };
+
+	while (stream.Read(frame, sizeof(frame)))
+	{
+		if (!stream.Write(reply, sizeof(reply)) || !stream.Send()) break;
+	}
+}
+
+/// <summary>One iteration is a frame's round trip: send 256 bytes, wait for the 64 byte reply.</summary>
+static void Benchmarks_InteropRoundTrip(AfxBenchmark::State & state, IAfxInteropTransport * transport)
+{
+	CAfxInteropStream stream(transport);
+	unsigned char frame[256] = { 0 };
+	unsigned char reply[64];
+
+	state.StartTimer();
+
+	for (size_t i = 0; i < state.Iterations; ++i)
+	{
+		frame[0] = (unsigned char)i;
+		if (!stream.Write(frame, sizeof(frame)) || !stream.Read(reply, sizeof(reply))) break;
+	}
+
+	state.StopTimer();
+}
+
+AFX_BENCHMARK(AfxInterop_RoundTrip_Pipe)
+{
+	CAfxInteropPipeTransport engine;
+	CAfxInteropPipeTransport client;
+	if (!CAfxInteropPipeTransport::Connect(engine, client))
+		return;
+
+	std::thread standIn(Benchmarks_InteropStandIn, &client);
+
+	Benchmarks_InteropRoundTrip(state, &engine);
+
+	engine.CloseWrite();
+	standIn.join();
+}
+
+AFX_BENCHMARK(AfxInterop_RoundTrip_SharedMemory)
+{
+	std::string name = "afxInteropBenchmark_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+	CAfxInteropSharedMemoryTransport client;
+	CAfxInteropSharedMemoryTransport engine;
+	if (!client.Create(name.c_str()) || !engine.Open(name.c_str()))
+		return;
+
+	std::thread standIn(Benchmarks_InteropStandIn, &client);
+
+	Benchmarks_InteropRoundTrip(state, &engine);
+
+	engine.Close();
+	standIn.join();
+}
+
+static void Benchmarks_InteropStandInClient(CAfxInteropStandInClient * client)
+{
+	client->Run();
+}
+
+/// <summary>One iteration is a frame of the stand-in engine against the stand-in client (calcs, view, translucent and Hud messages).</summary>
+static void Benchmarks_InteropStandInFrames(AfxBenchmark::State & state, int version)
+{
+	AfxInteropStandInSettings settings;
+	settings.Version = version;
+	settings.Frames = (int)state.Iterations;
+
+	CAfxInteropPipeTransport engineTransport;
+	CAfxInteropPipeTransport clientTransport;
+	if (!CAfxInteropPipeTransport::Connect(engineTransport, clientTransport))
+		return;
+
+	CAfxInteropStandInEngine engine(&engineTransport, settings);
+	CAfxInteropStandInClient client(&clientTransport, settings);
+
+	std::thread standIn(Benchmarks_InteropStandInClient, &client);
+
+	state.StartTimer();
+
+	engine.Run();
+
+	state.StopTimer();
+
+	engineTransport.CloseWrite();
+	standIn.join();
+
+	state.BytesPerOp = (double)engine.GetStream().GetStats().BytesWritten / state.Iterations;
+}
+
+AFX_BENCHMARK(AfxInterop_StandIn_Frame_v7)
+{
+	Benchmarks_InteropStandInFrames(state, 7);
+}
+
+AFX_BENCHMARK(AfxInterop_StandIn_Frame_v8)
+{
+	Benchmarks_InteropStandInFrames(state, 8);
+}
+
+// Synthetic mirv_calcs graph (see AfxFrameCacheTests.cpp): 10 layers of 32
+// nodes, each node reads two nodes of the layer below, each node is asked
+// for once per frame. items/op are the node evaluations per frame.
+
+class CBenchmarksCalcNode
+{
+public:
+	CBenchmarksCalcNode(CAfxFrameCacheClock & clock, CBenchmarksCalcNode * parentA, CBenchmarksCalcNode * parentB)
+		: m_Clock(clock)
+		, m_ParentA(parentA)
+		, m_ParentB(parentB)
+	{
+	}
+
+	bool CalcValue(double & outValue)
+	{
+		return m_Cache.Get(m_Clock, outValue, [this](double & outValue) {
+			double a = 0;
+			double b = 0;
+			if (m_ParentA && !m_ParentA->CalcValue(a)) return false;
+			if (m_ParentB && !m_ParentB->CalcValue(b)) return false;
+			outValue = 1 + 0.5 * (a + b);
+			return true;
+		});
+	}
+
+private:
+	CAfxFrameCacheClock & m_Clock;
+	CBenchmarksCalcNode * m_ParentA;
+	CBenchmarksCalcNode * m_ParentB;
+	CAfxFrameCached<double> m_Cache;
+};
+
+static void Benchmarks_CalcDag(AfxBenchmark::State & state, bool cached)
+{
+	const size_t layers = 10;
+	const size_t width = 32;
+
+	CAfxFrameCacheClock clock;
+	clock.SetEnabled(cached);
+
+	std::vector<CBenchmarksCalcNode> nodes;
+	nodes.reserve(layers * width);
+
+	for (size_t layer = 0; layer < layers; ++layer)
+	{
+		for (size_t i = 0; i < width; ++i)
+		{
+			if (0 == layer)
+				nodes.emplace_back(clock, nullptr, nullptr);
+			else
+				nodes.emplace_back(clock, &nodes[(layer - 1) * width + i], &nodes[(layer - 1) * width + (i + 1) % width]);
+		}
+	}
+
+	state.StartTimer();
+
+	double evaluations = 0;
+
+	for (size_t it = 0; it < state.Iterations; ++it)
+	{
+		clock.BeginFrame();
+
+		double sum = 0;
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			double value;
+			if (nodes[i].CalcValue(value)) sum += value;
+		}
+
+		clock.EndFrame();
+
+		evaluations += clock.GetEvaluations();
+		AfxBenchmark::g_Sink = sum;
+	}
+
+	state.StopTimer();
+
+	state.ItemsPerOp = evaluations / state.Iterations;
+}
+
+AFX_BENCHMARK(MirvCalcs_Dag320_Uncached)
+{
+	Benchmarks_CalcDag(state, false);
+}
+
+AFX_BENCHMARK(MirvCalcs_Dag320_Cached)
+{
+	Benchmarks_CalcDag(state, true);
+}
+
+/// <summary>Names of frequent CS:GO game events, filtered by a white list like the mirv_pgl / mirv_gameevents users set up.</summary>
+static std::vector<std::string> const & Benchmarks_GetCsgoEventNames()
+{
+	static std::vector<std::string> names = {
+		"player_footstep", "weapon_fire", "player_hurt", "player_death", "bullet_impact", "weapon_reload",
+		"weapon_zoom", "item_pickup", "item_equip", "player_jump", "round_start", "round_end",
+		"bomb_planted", "bomb_defused", "hegrenade_detonate", "flashbang_detonate", "smokegrenade_detonate", "player_blind",
+		"buytime_ended", "round_freeze_end", "player_spawn", "cs_pre_restart", "round_poststart", "other_death"
+	};
+
+	return names;
+}
+
+static void Benchmarks_GameEventsFilter(AfxBenchmark::State & state, bool useCache)
+{
+	std::vector<std::string> const & names = Benchmarks_GetCsgoEventNames();
+	std::set<std::string> whiteList = { "player_death", "player_hurt", "weapon_fire", "round_start", "round_end", "bomb_planted", "bomb_defused" };
+	CAfxEventIdCache<bool> allowedCache;
+	int dummyKeys[1];
+
+	state.StartTimer();
+
+	size_t allowed = 0;
+
+	// One iteration is 1000 events, the frequent ones first in the list get fired more often:
+	for (size_t it = 0; it < state.Iterations; ++it)
+	{
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			size_t eventId = (i * i) % names.size();
+			char const * eventName = names[eventId].c_str();
+
+			if (useCache)
+			{
+				bool stale;
+				bool & isAllowed = allowedCache.Get(eventId, eventName, dummyKeys, stale);
+				if (stale) isAllowed = whiteList.end() != whiteList.find(eventName);
+				if (isAllowed) ++allowed;
+			}
+			else if (whiteList.end() != whiteList.find(eventName)) ++allowed;
+		}
+	}
+
+	state.StopTimer();
+
+	state.ItemsPerOp = 1000;
+	AfxBenchmark::g_Sink += (double)allowed;
+}
+
+AFX_BENCHMARK(GameEvents_Filter_WhiteList)
+{
+	Benchmarks_GameEventsFilter(state, false);
+}
+
+AFX_BENCHMARK(GameEvents_Filter_EventIdCache)
+{
+	Benchmarks_GameEventsFilter(state, true);
+}
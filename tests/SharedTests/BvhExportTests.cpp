@@ -0,0 +1,77 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/bvhexport.h>
+#include <shared/bvhimport.h>
+
+AFX_TEST(BvhExport_RoundTrip)
+{
+	{
+		BvhExport bvhExport(L"SharedTests_export.bvh", "MdtCam", 0.01);
+
+		for (int i = 0; i < 10; ++i)
+		{
+			bvhExport.WriteFrame(i, -i, 0.5, 1.0, 2.0, 3.0);
+		}
+	}
+
+	BvhImport bvhImport;
+	AFX_CHECK(bvhImport.LoadMotionFile(L"SharedTests_export.bvh"));
+	remove("SharedTests_export.bvh");
+
+	double camData[6];
+	AFX_CHECK(bvhImport.GetCamPosition(0.09, camData));
+	AFX_CHECK(camData[0] == 9.0 && camData[1] == -9.0 && camData[5] == 3.0);
+	AFX_CHECK(!bvhImport.GetCamPosition(0.10, camData));
+}
+
+AFX_TEST(BvhBatchExport_RoundTrip)
+{
+	const int files = 70;
+	const int frames = 1000;
+
+	{
+		BvhBatchExport bvhExport(0.01);
+
+		int indices[files];
+
+		for (int i = 0; i < files; ++i)
+		{
+			char fileName[64];
+			_snprintf_s(fileName, _TRUNCATE, "SharedTests_export_%i.bvh", i);
+
+			std::wstring wideFileName(fileName, fileName + strlen(fileName));
+
+			indices[i] = bvhExport.AddFile(wideFileName.c_str(), "MdtCam");
+			AFX_CHECK(i == indices[i]);
+		}
+
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (int i = 0; i < files; ++i)
+			{
+				bvhExport.WriteFrame(indices[i], i, frame, 0.25, -1.0 * frame, 0.0, 180.0);
+			}
+		}
+	}
+
+	for (int i = 0; i < files; ++i)
+	{
+		char fileName[64];
+		_snprintf_s(fileName, _TRUNCATE, "SharedTests_export_%i.bvh", i);
+
+		std::wstring wideFileName(fileName, fileName + strlen(fileName));
+
+		BvhImport bvhImport;
+		AFX_CHECK(bvhImport.LoadMotionFile(wideFileName.c_str()));
+		remove(fileName);
+
+		double camData[6];
+		AFX_CHECK(bvhImport.GetCamPosition(0.01 * (frames - 1), camData));
+		AFX_CHECK(camData[0] == i && camData[1] == frames - 1 && camData[3] == 1.0 - frames);
+		AFX_CHECK(bvhImport.GetCamPosition(0.0, camData));
+		AFX_CHECK(camData[0] == i && camData[1] == 0 && camData[2] == 0.25);
+		AFX_CHECK(!bvhImport.GetCamPosition(0.01 * frames, camData));
+	}
+}
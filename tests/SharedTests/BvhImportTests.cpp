@@ -0,0 +1,148 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/bvhimport.h>
+
+#include <string>
+
+static void BvhImportTests_WriteFile(char const * fileName, char const * channels, int frames, char const * lineBreak, int framesWritten)
+{
+	FILE * file = fopen(fileName, "wb");
+	if (!file) return;
+
+	fprintf(file, "HIERARCHY%s", lineBreak);
+	fprintf(file, "ROOT MdtCam%s{%s\tOFFSET 0.00 0.00 0.00%s", lineBreak, lineBreak, lineBreak);
+	fprintf(file, "\tCHANNELS 6 %s%s", channels, lineBreak);
+	fprintf(file, "\tEnd Site%s\t{%s\t\tOFFSET 0.00 0.00 -1.00%s\t}%s}%s", lineBreak, lineBreak, lineBreak, lineBreak, lineBreak);
+	fprintf(file, "MOTION%s", lineBreak);
+	fprintf(file, "Frames: %11i%s", frames, lineBreak);
+	fprintf(file, "Frame Time: %f%s", 0.01, lineBreak);
+
+	for (int i = 0; i < framesWritten; ++i)
+	{
+		fprintf(file, "%f %f %f %f %f %f%s", i + 0.5, -2.0 * i, 3.25, 10.0, 20.0 + i, -30.0, lineBreak);
+	}
+
+	fclose(file);
+}
+
+AFX_TEST(BvhImport_GetCamPosition)
+{
+	BvhImportTests_WriteFile("SharedTests_import.bvh", "Xposition Yposition Zposition Zrotation Xrotation Yrotation", 100, "\r\n", 100);
+
+	BvhImport bvhImport;
+	AFX_CHECK(bvhImport.LoadMotionFile(L"SharedTests_import.bvh"));
+	remove("SharedTests_import.bvh");
+
+	AFX_CHECK(bvhImport.IsActive());
+
+	// Out of order on purpose:
+	int frames[] = { 42, 0, 99, 41, 7 };
+
+	for (int i = 0; i < 5; ++i)
+	{
+		double camData[6];
+
+		AFX_CHECK(bvhImport.GetCamPosition(frames[i] * 0.01 + 0.004, camData));
+		AFX_CHECK(camData[0] == frames[i] + 0.5);
+		AFX_CHECK(camData[1] == -2.0 * frames[i]);
+		AFX_CHECK(camData[2] == 3.25);
+		AFX_CHECK(camData[3] == 10.0);
+		AFX_CHECK(camData[4] == 20.0 + frames[i]);
+		AFX_CHECK(camData[5] == -30.0);
+	}
+
+	double camData[6];
+	AFX_CHECK(!bvhImport.GetCamPosition(-0.01, camData));
+	AFX_CHECK(!bvhImport.GetCamPosition(1.0, camData));
+
+	bvhImport.CloseMotionFile();
+	AFX_CHECK(!bvhImport.IsActive());
+	AFX_CHECK(!bvhImport.GetCamPosition(0, camData));
+}
+
+AFX_TEST(BvhImport_ChannelOrder)
+{
+	BvhImportTests_WriteFile("SharedTests_import.bvh", "Yrotation Xrotation Zrotation Zposition Yposition Xposition", 1, "\n", 1);
+
+	BvhImport bvhImport;
+	AFX_CHECK(bvhImport.LoadMotionFile(L"SharedTests_import.bvh"));
+	remove("SharedTests_import.bvh");
+
+	double camData[6];
+	AFX_CHECK(bvhImport.GetCamPosition(0, camData));
+
+	// Output is always Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation:
+	AFX_CHECK(camData[0] == -30.0);
+	AFX_CHECK(camData[1] == 20.0);
+	AFX_CHECK(camData[2] == 10.0);
+	AFX_CHECK(camData[3] == 3.25);
+	AFX_CHECK(camData[4] == 0.0);
+	AFX_CHECK(camData[5] == 0.5);
+}
+
+AFX_TEST(BvhImport_MultipleFiles)
+{
+	BvhImportTests_WriteFile("SharedTests_import1.bvh", "Xposition Yposition Zposition Zrotation Xrotation Yrotation", 10, "\n", 10);
+	BvhImportTests_WriteFile("SharedTests_import2.bvh", "Yposition Xposition Zposition Zrotation Xrotation Yrotation", 20, "\n", 20);
+
+	BvhImport bvhImport1;
+	BvhImport bvhImport2;
+	AFX_CHECK(bvhImport1.LoadMotionFile(L"SharedTests_import1.bvh"));
+	AFX_CHECK(bvhImport2.LoadMotionFile(L"SharedTests_import2.bvh"));
+	remove("SharedTests_import1.bvh");
+	remove("SharedTests_import2.bvh");
+
+	double camData1[6];
+	double camData2[6];
+	AFX_CHECK(bvhImport1.GetCamPosition(0.05, camData1));
+	AFX_CHECK(bvhImport2.GetCamPosition(0.05, camData2));
+	AFX_CHECK(camData1[0] == 5.5 && camData1[1] == -10.0);
+	AFX_CHECK(camData2[0] == -10.0 && camData2[1] == 5.5);
+
+	AFX_CHECK(!bvhImport1.GetCamPosition(0.15, camData1));
+	AFX_CHECK(bvhImport2.GetCamPosition(0.15, camData2));
+}
+
+AFX_TEST(BvhImport_CopyToCampath)
+{
+	BvhImportTests_WriteFile("SharedTests_import.bvh", "Xposition Yposition Zposition Zrotation Xrotation Yrotation", 5, "\n", 5);
+
+	BvhImport bvhImport;
+	AFX_CHECK(bvhImport.LoadMotionFile(L"SharedTests_import.bvh"));
+	remove("SharedTests_import.bvh");
+
+	CamPath camPath;
+	AFX_CHECK(bvhImport.CopyToCampath(100.0, 90.0, camPath));
+	AFX_CHECK(camPath.GetSize() == 5);
+	AFX_CHECK_NEAR(camPath.GetLowerBound(), 100.0, 1e-9);
+	AFX_CHECK_NEAR(camPath.GetUpperBound(), 100.04, 1e-9);
+
+	CamPathIterator it = camPath.GetBegin();
+	++it;
+	CamPathValue value = it.GetValue();
+	AFX_CHECK(value.X == -3.25);
+	AFX_CHECK(value.Y == -1.5);
+	AFX_CHECK(value.Z == -2.0);
+	AFX_CHECK(value.Fov == 90.0);
+}
+
+AFX_TEST(BvhImport_BadFiles)
+{
+	BvhImport bvhImport;
+
+	AFX_CHECK(!bvhImport.LoadMotionFile(L"SharedTests_does_not_exist.bvh"));
+	AFX_CHECK(!bvhImport.IsActive());
+
+	// Less frames than announced:
+	BvhImportTests_WriteFile("SharedTests_import.bvh", "Xposition Yposition Zposition Zrotation Xrotation Yrotation", 10, "\n", 9);
+	AFX_CHECK(!bvhImport.LoadMotionFile(L"SharedTests_import.bvh"));
+	AFX_CHECK(!bvhImport.IsActive());
+
+	// Unknown channel:
+	BvhImportTests_WriteFile("SharedTests_import.bvh", "Xposition Yposition Zposition Zrotation Xrotation Wrotation", 1, "\n", 1);
+	AFX_CHECK(!bvhImport.LoadMotionFile(L"SharedTests_import.bvh"));
+
+	remove("SharedTests_import.bvh");
+}
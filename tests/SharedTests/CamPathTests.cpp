@@ -0,0 +1,236 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/CamPath.h>
+
+#include <math.h>
+
+static void CamPathTests_Fill(CamPath & camPath, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		// Uneven key spacing and speeds, so constant speed has something to do:
+		double t = i + 0.3 * (i % 2);
+		camPath.Add(t, CamPathValue(100.0 * i * i, 50.0 * sin((double)i), 10.0 * i, 5.0 * i, 20.0 * i, 0.0, 90.0 + i));
+	}
+}
+
+static double CamPathTests_Distance(CamPathValue const & a, CamPathValue const & b)
+{
+	double dx = b.X - a.X;
+	double dy = b.Y - a.Y;
+	double dz = b.Z - a.Z;
+
+	return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+AFX_TEST(CamPath_Eval_HitsKeyframes)
+{
+	CamPath::DoubleInterp methods[2] = { CamPath::DI_LINEAR, CamPath::DI_CUBIC };
+
+	for (int m = 0; m < 2; ++m)
+	{
+		CamPath camPath;
+		CamPathTests_Fill(camPath, 8);
+		camPath.PositionInterpMethod_set(methods[m]);
+		camPath.FovInterpMethod_set(methods[m]);
+
+		AFX_CHECK(camPath.CanEval());
+
+		for (CamPathIterator it = camPath.GetBegin(); it != camPath.GetEnd(); ++it)
+		{
+			CamPathValue key = it.GetValue();
+			CamPathValue value = camPath.Eval(it.GetTime());
+
+			AFX_CHECK_NEAR(CamPathTests_Distance(key, value), 0.0, 1e-9);
+			AFX_CHECK_NEAR(value.Fov, key.Fov, 1e-9);
+			AFX_CHECK_NEAR(fabs(DotProduct(value.R, key.R)), 1.0, 1e-9);
+		}
+	}
+}
+
+AFX_TEST(CamPath_Eval_RotationNormalized)
+{
+	CamPath::QuaternionInterp methods[2] = { CamPath::QI_SLINEAR, CamPath::QI_SCUBIC };
+
+	for (int m = 0; m < 2; ++m)
+	{
+		CamPath camPath;
+		CamPathTests_Fill(camPath, 8);
+		camPath.RotationInterpMethod_set(methods[m]);
+
+		for (double t = camPath.GetLowerBound(); t <= camPath.GetUpperBound(); t += 0.05)
+		{
+			AFX_CHECK_NEAR(camPath.Eval(t).R.Norm(), 1.0, 1e-6);
+		}
+	}
+}
+
+AFX_TEST(CamPath_SpeedInterp_Constant)
+{
+	CamPath camPath;
+	CamPathTests_Fill(camPath, 8);
+	camPath.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+
+	double lower = camPath.GetLowerBound();
+	double upper = camPath.GetUpperBound();
+
+	// Same end points as the default speed:
+	AFX_CHECK_NEAR(CamPathTests_Distance(camPath.Eval(lower), camPath.EvalDirect(lower)), 0.0, 1e-6);
+	AFX_CHECK_NEAR(CamPathTests_Distance(camPath.Eval(upper), camPath.EvalDirect(upper)), 0.0, 1e-6);
+
+	const int steps = 50;
+	const int subSteps = 20; // Measure arc lengths, not chords.
+	double expected = camPath.GetArcLength() / steps;
+	double dt = (upper - lower) / (steps * subSteps);
+
+	AFX_CHECK(0 < expected);
+
+	CamPathValue last = camPath.Eval(lower);
+	for (int i = 0; i < steps; ++i)
+	{
+		double length = 0;
+		for (int j = 1; j <= subSteps; ++j)
+		{
+			CamPathValue cur = camPath.Eval(lower + (i * subSteps + j) * dt);
+			length += CamPathTests_Distance(last, cur);
+			last = cur;
+		}
+		AFX_CHECK_NEAR(length / expected, 1.0, 0.01);
+	}
+}
+
+/// <summary>Compares the arc length of camPath with the one of a new path with the same keyframes (built from scratch).</summary>
+static void CamPathTests_CheckArcLength(CamPath & camPath)
+{
+	CamPath fresh;
+	for (CamPathIterator it = camPath.GetBegin(); it != camPath.GetEnd(); ++it) fresh.Add(it.GetTime(), it.GetValue());
+	fresh.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+
+	double length = fresh.GetArcLength();
+	AFX_CHECK_NEAR(camPath.GetArcLength() / length, 1.0, 1e-6);
+
+	double lower = fresh.GetLowerBound();
+	double upper = fresh.GetUpperBound();
+
+	for (int i = 0; i <= 100; ++i)
+	{
+		double t = lower + (upper - lower) * i / 100;
+		AFX_CHECK_NEAR(CamPathTests_Distance(camPath.Eval(t), fresh.Eval(t)) / length, 0.0, 1e-6);
+	}
+}
+
+AFX_TEST(CamPath_ArcLength_Incremental)
+{
+	CamPath camPath;
+	CamPathTests_Fill(camPath, 50);
+	camPath.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+	CamPathTests_CheckArcLength(camPath);
+
+	// Move a keyframe:
+	CamPathIterator it = camPath.GetBegin();
+	for (int i = 0; i < 20; ++i) ++it;
+	double t = it.GetTime();
+	CamPathValue value = it.GetValue();
+	value.X += 500.0;
+	value.Z -= 30.0;
+	camPath.Add(t, value);
+	CamPathTests_CheckArcLength(camPath);
+
+	// Remove and add keyframes:
+	camPath.Remove(t);
+	CamPathTests_CheckArcLength(camPath);
+	camPath.Add(t + 0.25, value);
+	CamPathTests_CheckArcLength(camPath);
+	camPath.Add(camPath.GetUpperBound() + 2.0, value);
+	CamPathTests_CheckArcLength(camPath);
+
+	// Changes that don't move the curve:
+	camPath.SelectAll();
+	camPath.SetOffset(2.0);
+	CamPathTests_CheckArcLength(camPath);
+
+	camPath.PositionInterpMethod_set(CamPath::DI_LINEAR);
+	CamPath linear;
+	for (CamPathIterator itLinear = camPath.GetBegin(); itLinear != camPath.GetEnd(); ++itLinear) linear.Add(itLinear.GetTime(), itLinear.GetValue());
+	linear.PositionInterpMethod_set(CamPath::DI_LINEAR);
+	AFX_CHECK_NEAR(camPath.GetArcLength() / linear.GetArcLength(), 1.0, 1e-6);
+}
+
+AFX_TEST(CamPath_SaveBinary_RoundTrip)
+{
+	CamPath camPath;
+	CamPathTests_Fill(camPath, 50);
+	camPath.SetOffset(1.5);
+	camPath.PositionInterpMethod_set(CamPath::DI_LINEAR);
+	camPath.SpeedInterpMethod_set(CamPath::SI_CONSTANT);
+	camPath.SelectAdd((size_t)3, (size_t)7);
+
+	AFX_CHECK(camPath.SaveBinary(L"SharedTests_campath.bin"));
+
+	CamPath loaded;
+	AFX_CHECK(loaded.Load(L"SharedTests_campath.bin"));
+
+	remove("SharedTests_campath.bin");
+
+	AFX_CHECK(loaded.GetSize() == camPath.GetSize());
+	AFX_CHECK(loaded.GetOffset() == camPath.GetOffset());
+	AFX_CHECK(loaded.PositionInterpMethod_get() == CamPath::DI_LINEAR);
+	AFX_CHECK(loaded.SpeedInterpMethod_get() == CamPath::SI_CONSTANT);
+
+	CamPathIterator itLoaded = loaded.GetBegin();
+	for (CamPathIterator it = camPath.GetBegin(); it != camPath.GetEnd() && itLoaded != loaded.GetEnd(); ++it, ++itLoaded)
+	{
+		CamPathValue a = it.GetValue();
+		CamPathValue b = itLoaded.GetValue();
+
+		AFX_CHECK(it.GetTime() == itLoaded.GetTime());
+		AFX_CHECK(a.X == b.X && a.Y == b.Y && a.Z == b.Z);
+		AFX_CHECK(a.R.W == b.R.W && a.R.X == b.R.X && a.R.Y == b.R.Y && a.R.Z == b.R.Z);
+		AFX_CHECK(a.Fov == b.Fov);
+		AFX_CHECK(a.Selected == b.Selected);
+	}
+}
+
+AFX_TEST(CamPath_SaveBinary_Empty)
+{
+	CamPath camPath;
+	AFX_CHECK(camPath.SaveBinary(L"SharedTests_campath.bin"));
+
+	CamPath loaded;
+	CamPathTests_Fill(loaded, 5);
+	AFX_CHECK(loaded.Load(L"SharedTests_campath.bin"));
+	AFX_CHECK(0 == loaded.GetSize());
+
+	remove("SharedTests_campath.bin");
+}
+
+AFX_TEST(CamPath_LoadBinary_CorruptCount)
+{
+	FILE * file = fopen("SharedTests_campath.bin", "wb");
+	AFX_CHECK(nullptr != file);
+	if (nullptr != file)
+	{
+		// Valid magic and header, but a count the file is much too short for:
+		int version = 1;
+		unsigned char interp[4] = { 0, 0, 0, 0 };
+		double offset = 0;
+		unsigned int count = 0xFFFFFFFF;
+		double value = 1;
+		fwrite("afxCamPathB", 12, 1, file);
+		fwrite(&version, sizeof(version), 1, file);
+		fwrite(interp, sizeof(interp), 1, file);
+		fwrite(&offset, sizeof(offset), 1, file);
+		fwrite(&count, sizeof(count), 1, file);
+		for (int i = 0; i < 9; ++i) fwrite(&value, sizeof(value), 1, file);
+		fclose(file);
+	}
+
+	CamPath loaded;
+	CamPathTests_Fill(loaded, 5);
+	AFX_CHECK(!loaded.Load(L"SharedTests_campath.bin"));
+	AFX_CHECK(5 == loaded.GetSize());
+
+	remove("SharedTests_campath.bin");
+}
@@ -0,0 +1,163 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/CamPathTrajectory.h>
+
+#include <math.h>
+
+static CamPathValue CamPathTrajectoryTests_Value(int i, double lift)
+{
+	return CamPathValue(100.0 * i, 300.0 * sin(0.7 * i), 20.0 * i + lift, 0.0, 10.0 * i, 0.0, 90.0);
+}
+
+static void CamPathTrajectoryTests_Fill(CamPath & camPath, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		camPath.Add(i, CamPathTrajectoryTests_Value(i, 0));
+	}
+}
+
+static double CamPathTrajectoryTests_DistanceToLine(Vector3 const & y, Vector3 const & start, Vector3 const & end)
+{
+	Vector3 es = end - start;
+	double dESdES = es.X * es.X + es.Y * es.Y + es.Z * es.Z;
+	double t = dESdES ? ((y.X - start.X) * es.X + (y.Y - start.Y) * es.Y + (y.Z - start.Z) * es.Z) / dESdES : 0.0;
+
+	if (t < 0) t = 0;
+	if (1 < t) t = 1;
+
+	return (y - (start + t * es)).Length();
+}
+
+/// <summary>Checks the points are in order, start / end at the keyframes and are within epsilon of the path.</summary>
+static void CamPathTrajectoryTests_CheckPoints(CamPath & camPath, CamPathTrajectory const & trajectory, double epsilon)
+{
+	std::vector<CamPathTrajectory::Point> const & points = trajectory.GetPoints();
+
+	AFX_CHECK(2 <= points.size());
+	if (points.size() < 2) return;
+
+	AFX_CHECK(points.front().T == camPath.GetLowerBound());
+	AFX_CHECK(points.back().T == camPath.GetUpperBound());
+
+	for (size_t i = 0; i + 1 < points.size(); ++i)
+	{
+		AFX_CHECK(points[i].T < points[i + 1].T);
+
+		for (int j = 0; j <= 16; ++j)
+		{
+			double t = points[i].T + (points[i + 1].T - points[i].T) * j / 16.0;
+			double d = CamPathTrajectoryTests_DistanceToLine(camPath.EvalDirectPosition(t), points[i].Y, points[i + 1].Y);
+
+			AFX_CHECK(d <= 1.1 * epsilon + 1e-9);
+		}
+	}
+}
+
+AFX_TEST(CamPathTrajectory_Update_Simplifies)
+{
+	CamPath camPath;
+	CamPathTrajectoryTests_Fill(camPath, 20);
+
+	CamPathTrajectory trajectory(1.0, 1024);
+
+	AFX_CHECK(19 == trajectory.Update(camPath));
+	AFX_CHECK(trajectory.GetPoints().size() < 19 * 1024 / 4);
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+}
+
+AFX_TEST(CamPathTrajectory_Update_Unchanged)
+{
+	CamPath camPath;
+	CamPathTrajectoryTests_Fill(camPath, 20);
+
+	CamPathTrajectory trajectory(1.0, 1024);
+	trajectory.Update(camPath);
+
+	size_t numPoints = trajectory.GetPoints().size();
+
+	AFX_CHECK(0 == trajectory.Update(camPath));
+	AFX_CHECK(numPoints == trajectory.GetPoints().size());
+}
+
+AFX_TEST(CamPathTrajectory_Update_MovedKeyframe)
+{
+	CamPath camPath;
+	CamPathTrajectoryTests_Fill(camPath, 100);
+
+	CamPathTrajectory trajectory(1.0, 1024);
+	trajectory.Update(camPath);
+
+	camPath.Add(50, CamPathTrajectoryTests_Value(50, 50.0));
+
+	size_t resampled = trajectory.Update(camPath);
+
+	AFX_CHECK(2 <= resampled && resampled <= 16);
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+
+	// Linear only affects the two neighbouring segments:
+
+	camPath.PositionInterpMethod_set(CamPath::DI_LINEAR);
+	trajectory.Update(camPath);
+
+	camPath.Add(50, CamPathTrajectoryTests_Value(50, 0.0));
+
+	AFX_CHECK(2 == trajectory.Update(camPath));
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+}
+
+AFX_TEST(CamPathTrajectory_Update_InsertedAndSelected)
+{
+	CamPath camPath;
+	CamPathTrajectoryTests_Fill(camPath, 30);
+	camPath.PositionInterpMethod_set(CamPath::DI_LINEAR);
+
+	CamPathTrajectory trajectory(1.0, 64);
+	trajectory.Update(camPath);
+
+	// Splits one segment into two:
+	camPath.Add(10.5, camPath.EvalDirect(10.5));
+
+	AFX_CHECK(2 == trajectory.Update(camPath));
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+
+	camPath.SelectAdd(20.0, 21.0);
+
+	AFX_CHECK(3 == trajectory.Update(camPath));
+
+	std::vector<CamPathTrajectory::Point> const & points = trajectory.GetPoints();
+
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		AFX_CHECK(points[i].Selected == (20.0 <= points[i].T && points[i].T <= 21.0));
+	}
+}
+
+AFX_TEST(CamPathTrajectory_Update_LargeMoveAndRemoved)
+{
+	CamPath camPath;
+	CamPathTrajectoryTests_Fill(camPath, 100);
+
+	CamPathTrajectory trajectory(1.0, 1024);
+	trajectory.Update(camPath);
+
+	// Moves the cubic curve noticeably several keyframes away, all of it must be re-sampled:
+	camPath.Add(50, CamPathTrajectoryTests_Value(50, 5000.0));
+
+	size_t resampled = trajectory.Update(camPath);
+	AFX_CHECK(4 < resampled && resampled < 99);
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+
+	camPath.Remove(50);
+
+	AFX_CHECK(0 < trajectory.Update(camPath));
+
+	CamPathTrajectoryTests_CheckPoints(camPath, trajectory, 1.0);
+}
@@ -0,0 +1,56 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/EasySampler.h>
+
+#include <vector>
+
+class EasySamplerTests_Printer : public IFramePrinter
+{
+public:
+	std::vector<unsigned char> LastFrame;
+	int Frames;
+
+	EasySamplerTests_Printer(size_t length)
+	: LastFrame(length)
+	, Frames(0)
+	{
+	}
+
+	virtual void Print(unsigned char const * data)
+	{
+		memcpy(&LastFrame[0], data, LastFrame.size());
+		++Frames;
+	}
+};
+
+AFX_TEST(EasyByteSampler_ConstantInput)
+{
+	const int width = 16;
+	const int height = 4;
+
+	EasySamplerSettings::Method methods[2] = { EasySamplerSettings::ESM_Rectangle, EasySamplerSettings::ESM_Trapezoid };
+
+	for (int m = 0; m < 2; ++m)
+	{
+		EasySamplerTests_Printer printer(width * height);
+		EasySamplerSettings settings(width, height, methods[m], 1.0 / 30, 0, 1.0, 1.0f);
+		EasyByteSampler sampler(settings, width, &printer);
+
+		std::vector<unsigned char> input(width * height, 200);
+
+		// 4 samples per frame:
+		for (int i = 0; i <= 40; ++i)
+		{
+			sampler.Sample(&input[0], i / 120.0);
+		}
+
+		AFX_CHECK(9 <= printer.Frames);
+
+		for (size_t i = 0; i < printer.LastFrame.size(); ++i)
+		{
+			AFX_CHECK_NEAR(printer.LastFrame[i], 200, 1);
+		}
+	}
+}
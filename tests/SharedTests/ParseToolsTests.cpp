@@ -0,0 +1,98 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/ParseTools.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool ParseToolsTests_Parse(char const * text, double & outValue, size_t & outLength)
+{
+	char const * pos = text;
+	bool result = ParseDouble(pos, text + strlen(text), outValue);
+	outLength = pos - text;
+	return result;
+}
+
+AFX_TEST(ParseTools_ParseDouble_MatchesStrtod)
+{
+	char const * texts[] = {
+		"0", "-0.000000", "1", "+2.5", "-123.456789", "0.1", "0.000001", "3.141592653589793",
+		"1e10", "1.5E-5", "-2.5e+3", "123456789012345678901234567890", "0.30000000000000004",
+		"1e-320", "1.7976931348623157e308", "9007199254740993", "12345.678900 rest"
+	};
+
+	for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+	{
+		double value;
+		size_t length;
+
+		AFX_CHECK(ParseToolsTests_Parse(texts[i], value, length));
+
+		char * strtodEnd;
+		double expected = strtod(texts[i], &strtodEnd);
+
+		AFX_CHECK(value == expected);
+		AFX_CHECK(length == (size_t)(strtodEnd - texts[i]));
+	}
+}
+
+AFX_TEST(ParseTools_ParseDouble_RoundTrip)
+{
+	unsigned int seed = 1;
+
+	for (int i = 0; i < 10000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		double original = ((double)seed / 4294967296.0 - 0.5) * 20000.0;
+
+		char text[64];
+		_snprintf_s(text, _TRUNCATE, 0 == i % 2 ? "%f" : "%.17g", original);
+
+		double value;
+		size_t length;
+
+		AFX_CHECK(ParseToolsTests_Parse(text, value, length));
+		AFX_CHECK(value == strtod(text, 0));
+	}
+}
+
+AFX_TEST(ParseTools_ParseDouble_Invalid)
+{
+	char const * texts[] = { "", "-", ".", "e5", "abc", "+.e1" };
+
+	for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+	{
+		double value;
+		size_t length;
+
+		AFX_CHECK(!ParseToolsTests_Parse(texts[i], value, length));
+		AFX_CHECK(0 == length);
+	}
+
+	// Not 0-terminated, must stop at end:
+	char const text[] = "1234";
+	char const * pos = text;
+	double value;
+
+	AFX_CHECK(ParseDouble(pos, text + 2, value));
+	AFX_CHECK(12 == value);
+	AFX_CHECK(text + 2 == pos);
+}
+
+AFX_TEST(ParseTools_SkipLine)
+{
+	char const text[] = "  \t1 2\r\nnext";
+	char const * pos = text;
+	char const * end = text + strlen(text);
+
+	ParseSkipBlanks(pos, end);
+	AFX_CHECK('1' == *pos);
+
+	ParseSkipLine(pos, end);
+	AFX_CHECK(0 == strcmp(pos, "next"));
+
+	ParseSkipLine(pos, end);
+	AFX_CHECK(end == pos);
+}
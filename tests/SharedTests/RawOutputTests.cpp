@@ -0,0 +1,79 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <shared/RawOutput.h>
+
+#include <vector>
+
+static std::vector<unsigned char> RawOutputTests_ReadAndRemove(char const * fileName)
+{
+	std::vector<unsigned char> result;
+
+	if (FILE * file = fopen(fileName, "rb"))
+	{
+		int c;
+		while (EOF != (c = fgetc(file))) result.push_back((unsigned char)c);
+		fclose(file);
+	}
+
+	remove(fileName);
+
+	return result;
+}
+
+static unsigned int RawOutputTests_U32(std::vector<unsigned char> const & data, size_t offset)
+{
+	return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((unsigned int)data[offset + 3] << 24);
+}
+
+AFX_TEST(RawOutput_CalcPitch)
+{
+	AFX_CHECK(CalcPitch(3, 3, 4) == 12);
+	AFX_CHECK(CalcPitch(4, 3, 4) == 12);
+	AFX_CHECK(CalcPitch(5, 4, 1) == 20);
+}
+
+AFX_TEST(RawOutput_WriteRawTarga)
+{
+	const int width = 3;
+	const int height = 2;
+	const int pitch = CalcPitch(width, 3, 4);
+
+	std::vector<unsigned char> pixels(pitch * height, 0x7f);
+
+	AFX_CHECK(WriteRawTarga(&pixels[0], L"SharedTests_raw.tga", width, height, 24, false, pitch));
+
+	std::vector<unsigned char> data = RawOutputTests_ReadAndRemove("SharedTests_raw.tga");
+
+	AFX_CHECK(18 + width * height * 3 <= data.size());
+	if (data.size() < 18) return;
+
+	AFX_CHECK(data[2] == 2); // uncompressed true-color
+	AFX_CHECK((data[12] | (data[13] << 8)) == width);
+	AFX_CHECK((data[14] | (data[15] << 8)) == height);
+	AFX_CHECK(data[16] == 24);
+}
+
+AFX_TEST(RawOutput_WriteRawBitmap)
+{
+	const int width = 3;
+	const int height = 2;
+	const int pitch = CalcPitch(width, 3, 4);
+
+	std::vector<unsigned char> pixels(pitch * height, 0x7f);
+
+	AFX_CHECK(WriteRawBitmap(&pixels[0], L"SharedTests_raw.bmp", width, height, 24, pitch));
+
+	std::vector<unsigned char> data = RawOutputTests_ReadAndRemove("SharedTests_raw.bmp");
+
+	AFX_CHECK((size_t)(14 + 40 + pitch * height) == data.size());
+	if (data.size() < 14 + 40) return;
+
+	AFX_CHECK(data[0] == 'B' && data[1] == 'M');
+	AFX_CHECK(RawOutputTests_U32(data, 10) == 14 + 40); // bfOffBits
+	AFX_CHECK(RawOutputTests_U32(data, 14) == 40); // biSize
+	AFX_CHECK(RawOutputTests_U32(data, 18) == width);
+	AFX_CHECK(RawOutputTests_U32(data, 22) == height);
+	AFX_CHECK((data[28] | (data[29] << 8)) == 24); // biBitCount
+}
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+
+#include "Test.h"
+
+#include <vector>
+
+namespace AfxTest {
+
+struct TestCase
+{
+	char const * Name;
+	TestFn_t Fn;
+};
+
+static std::vector<TestCase> & GetTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+static int g_Failures = 0;
+
+bool Register(char const * name, TestFn_t fn)
+{
+	TestCase testCase = { name, fn };
+	GetTests().push_back(testCase);
+	return true;
+}
+
+void Fail(char const * file, int line, char const * expression)
+{
+	++g_Failures;
+	fprintf(stderr, "%s(%i): check failed: %s\n", file, line, expression);
+}
+
+} // namespace AfxTest {
+
+/// <summary>Runs all tests or only the ones whose name starts with argv[1].</summary>
+int main(int argc, char * argv[])
+{
+	char const * filter = 2 <= argc ? argv[1] : "";
+	int failedTests = 0;
+	int ranTests = 0;
+
+	std::vector<AfxTest::TestCase> & tests = AfxTest::GetTests();
+
+	for (size_t i = 0; i < tests.size(); ++i)
+	{
+		if (0 != strncmp(filter, tests[i].Name, strlen(filter))) continue;
+
+		int failures = AfxTest::g_Failures;
+
+		tests[i].Fn();
+		++ranTests;
+
+		bool ok = failures == AfxTest::g_Failures;
+		if (!ok) ++failedTests;
+
+		printf("[%s] %s\n", ok ? "OK" : "FAILED", tests[i].Name);
+	}
+
+	printf("%i of %i tests passed.\n", ranTests - failedTests, ranTests);
+
+	return 0 == failedTests && 0 < ranTests ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Minimal test registry, so the tests don't need external dependencies.
+
+namespace AfxTest {
+
+typedef void (* TestFn_t)(void);
+
+bool Register(char const * name, TestFn_t fn);
+
+void Fail(char const * file, int line, char const * expression);
+
+} // namespace AfxTest {
+
+#define AFX_TEST(name) \
+	static void AfxTest_##name(void); \
+	static bool AfxTest_##name##_registered = AfxTest::Register(#name, AfxTest_##name); \
+	static void AfxTest_##name(void)
+
+#define AFX_CHECK(expression) \
+	do { if (!(expression)) AfxTest::Fail(__FILE__, __LINE__, #expression); } while (false)
+
+#define AFX_CHECK_NEAR(a, b, eps) \
+	do { double afxCheckDelta = (double)(a) - (double)(b); if (!(-(eps) <= afxCheckDelta && afxCheckDelta <= (eps))) AfxTest::Fail(__FILE__, __LINE__, #a " ~= " #b); } while (false)
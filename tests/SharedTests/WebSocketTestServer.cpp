@@ -0,0 +1,289 @@
+#include "stdafx.h"
+
+#include "WebSocketTestServer.h"
+
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment( lib, "ws2_32" )
+#define WEBSOCKETTESTSERVER_INVALID_SOCKET ((uintptr_t)INVALID_SOCKET)
+#define WEBSOCKETTESTSERVER_SEND_FLAGS 0
+#define WebSocketTestServer_CloseSocket(socket) closesocket((SOCKET)(socket))
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define WEBSOCKETTESTSERVER_INVALID_SOCKET (-1)
+#define WEBSOCKETTESTSERVER_SEND_FLAGS MSG_NOSIGNAL
+#define WebSocketTestServer_CloseSocket(socket) close(socket)
+#endif
+
+CWebSocketTestServer::CWebSocketTestServer()
+: m_Listen(WEBSOCKETTESTSERVER_INVALID_SOCKET)
+, m_Client(WEBSOCKETTESTSERVER_INVALID_SOCKET)
+, m_Port(0)
+, m_AcceptThread(0)
+, m_Accepted(false)
+, m_Deflate(false)
+, m_Inflater(0)
+, m_Deflater(0)
+, m_ReceivedCompressed(false)
+, m_ReceivedBytes(0)
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	m_Listen = (Socket_t)socket(AF_INET, SOCK_STREAM, 0);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+
+	socklen_t addressSize = sizeof(address);
+
+	if (0 == bind(m_Listen, (sockaddr const *)&address, sizeof(address))
+		&& 0 == listen(m_Listen, 1)
+		&& 0 == getsockname(m_Listen, (sockaddr *)&address, &addressSize))
+	{
+		m_Port = ntohs(address.sin_port);
+	}
+}
+
+CWebSocketTestServer::~CWebSocketTestServer()
+{
+	if (m_AcceptThread)
+		EndAccept();
+
+	Disconnect();
+
+	if (m_Inflater)
+	{
+		inflateEnd(m_Inflater);
+		delete m_Inflater;
+	}
+
+	if (m_Deflater)
+	{
+		deflateEnd(m_Deflater);
+		delete m_Deflater;
+	}
+
+	if (WEBSOCKETTESTSERVER_INVALID_SOCKET != m_Listen)
+		WebSocketTestServer_CloseSocket(m_Listen);
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+std::string CWebSocketTestServer::GetUrl(void) const
+{
+	return "ws://127.0.0.1:" + std::to_string(m_Port) + "/mirv";
+}
+
+void CWebSocketTestServer::SetDeflate(bool value)
+{
+	m_Deflate = value;
+}
+
+void CWebSocketTestServer::SetReceiveBufferSize(int size)
+{
+	setsockopt(m_Listen, SOL_SOCKET, SO_RCVBUF, (char const *)&size, sizeof(size));
+}
+
+bool CWebSocketTestServer::GetReceivedCompressed(void) const
+{
+	return m_ReceivedCompressed;
+}
+
+size_t CWebSocketTestServer::GetReceivedBytes(void) const
+{
+	return m_ReceivedBytes;
+}
+
+void CWebSocketTestServer::BeginAccept(void)
+{
+	m_Accepted = false;
+	m_AcceptThread = new std::thread(&CWebSocketTestServer::Accept, this);
+}
+
+bool CWebSocketTestServer::EndAccept(void)
+{
+	m_AcceptThread->join();
+	delete m_AcceptThread;
+	m_AcceptThread = 0;
+
+	return m_Accepted;
+}
+
+void CWebSocketTestServer::Accept(void)
+{
+	m_Client = (Socket_t)accept(m_Listen, 0, 0);
+	if (WEBSOCKETTESTSERVER_INVALID_SOCKET == m_Client)
+		return;
+
+	int noDelay = 1;
+	setsockopt(m_Client, IPPROTO_TCP, TCP_NODELAY, (char const *)&noDelay, sizeof(noDelay));
+
+	std::string request;
+	while (std::string::npos == request.find("\r\n\r\n"))
+	{
+		char c;
+		if (1 != recv(m_Client, &c, 1, 0))
+			return;
+		request += c;
+	}
+
+	if (0 != request.compare(0, 10, "GET /mirv ")
+		|| std::string::npos == request.find("Upgrade: websocket\r\n")
+		|| std::string::npos == request.find("Sec-WebSocket-Key: ")
+		|| std::string::npos == request.find("Sec-WebSocket-Version: 13\r\n"))
+		return;
+
+	bool deflate = m_Deflate && std::string::npos != request.find("Sec-WebSocket-Extensions: permessage-deflate\r\n");
+
+	if (deflate)
+	{
+		m_Inflater = new z_stream;
+		memset(m_Inflater, 0, sizeof(z_stream));
+		inflateInit2(m_Inflater, -15);
+
+		m_Deflater = new z_stream;
+		memset(m_Deflater, 0, sizeof(z_stream));
+		deflateInit2(m_Deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	}
+
+	// The client doesn't verify Sec-WebSocket-Accept, so no need to compute it:
+	std::string response =
+		"HTTP/1.1 101 Switching Protocols\r\n"
+		"Upgrade: websocket\r\n"
+		"Connection: Upgrade\r\n"
+		"Sec-WebSocket-Accept: dummy\r\n"
+		+ std::string(deflate ? "Sec-WebSocket-Extensions: permessage-deflate\r\n" : "")
+		+ "\r\n";
+
+	m_Accepted = (int)response.size() == send(m_Client, response.c_str(), (int)response.size(), WEBSOCKETTESTSERVER_SEND_FLAGS);
+}
+
+bool CWebSocketTestServer::ReceiveExactly(void * data, size_t size)
+{
+	for (size_t received = 0; received < size; )
+	{
+		int result = recv(m_Client, (char *)data + received, (int)(size - received), 0);
+		if (result <= 0)
+			return false;
+		received += result;
+	}
+
+	return true;
+}
+
+bool CWebSocketTestServer::ReceiveFrame(unsigned char & outOpcode, std::vector<unsigned char> & outPayload)
+{
+	unsigned char header[2];
+	if (!ReceiveExactly(header, 2))
+		return false;
+
+	outOpcode = header[0] & 0x0f;
+	m_ReceivedCompressed = 0 != (header[0] & 0x40);
+
+	uint64_t size = header[1] & 0x7f;
+	if (126 == size || 127 == size)
+	{
+		unsigned char extended[8];
+		int extendedSize = 126 == size ? 2 : 8;
+		if (!ReceiveExactly(extended, extendedSize))
+			return false;
+		size = 0;
+		for (int i = 0; i < extendedSize; ++i) size = (size << 8) | extended[i];
+	}
+
+	unsigned char mask[4];
+	if (0 == (header[1] & 0x80) || !ReceiveExactly(mask, 4))
+		return false;
+
+	outPayload.resize((size_t)size);
+	if (!ReceiveExactly(outPayload.data(), outPayload.size()))
+		return false;
+
+	for (size_t i = 0; i < outPayload.size(); ++i) outPayload[i] ^= mask[i & 3];
+
+	m_ReceivedBytes += outPayload.size();
+
+	if (m_ReceivedCompressed)
+	{
+		if (!m_Inflater)
+			return false;
+
+		static const unsigned char tail[4] = { 0x00, 0x00, 0xff, 0xff };
+		outPayload.insert(outPayload.end(), tail, tail + 4);
+
+		std::vector<unsigned char> inflated(64 * 1024 + 20 * outPayload.size());
+		m_Inflater->next_in = outPayload.data();
+		m_Inflater->avail_in = (uInt)outPayload.size();
+		m_Inflater->next_out = inflated.data();
+		m_Inflater->avail_out = (uInt)inflated.size();
+
+		if (Z_OK != inflate(m_Inflater, Z_SYNC_FLUSH) || 0 < m_Inflater->avail_in)
+			return false;
+
+		inflated.resize(inflated.size() - m_Inflater->avail_out);
+		outPayload.swap(inflated);
+	}
+
+	return true;
+}
+
+bool CWebSocketTestServer::SendFrame(unsigned char opcode, void const * data, size_t size, bool fin, bool compress)
+{
+	std::vector<unsigned char> deflated;
+
+	if (compress)
+	{
+		deflated.resize(64 + 2 * size);
+		m_Deflater->next_in = (Bytef *)data;
+		m_Deflater->avail_in = (uInt)size;
+		m_Deflater->next_out = deflated.data();
+		m_Deflater->avail_out = (uInt)deflated.size();
+		deflate(m_Deflater, Z_SYNC_FLUSH);
+		deflated.resize(deflated.size() - m_Deflater->avail_out - 4);
+
+		data = deflated.data();
+		size = deflated.size();
+	}
+
+	std::vector<unsigned char> frame;
+	frame.push_back((fin ? 0x80 : 0x00) | (compress ? 0x40 : 0x00) | opcode);
+	if (size < 126)
+		frame.push_back((unsigned char)size);
+	else if (size < 65536)
+	{
+		frame.push_back(126);
+		for (int i = 1; i >= 0; --i) frame.push_back((unsigned char)(size >> (8 * i)));
+	}
+	else
+	{
+		frame.push_back(127);
+		for (int i = 7; i >= 0; --i) frame.push_back((unsigned char)((unsigned long long)size >> (8 * i)));
+	}
+	frame.insert(frame.end(), (unsigned char const *)data, (unsigned char const *)data + size);
+
+	return (int)frame.size() == send(m_Client, (char const *)frame.data(), (int)frame.size(), WEBSOCKETTESTSERVER_SEND_FLAGS);
+}
+
+void CWebSocketTestServer::Disconnect(void)
+{
+	if (WEBSOCKETTESTSERVER_INVALID_SOCKET != m_Client)
+	{
+		WebSocketTestServer_CloseSocket(m_Client);
+		m_Client = WEBSOCKETTESTSERVER_INVALID_SOCKET;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Minimal blocking WebSocket server on 127.0.0.1 for testing CAfxWebSocket
+// against, accepts a single client.
+
+#include <stdint.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+struct z_stream_s;
+
+class CWebSocketTestServer
+{
+public:
+	/// <summary>Listens on a free port (and initializes WinSock on Windows).</summary>
+	CWebSocketTestServer();
+
+	~CWebSocketTestServer();
+
+	/// <returns>ws:// URL to connect to.</returns>
+	std::string GetUrl(void) const;
+
+	/// <summary>Whether to accept permessage-deflate if the client offers it, default is false.</summary>
+	void SetDeflate(bool value);
+
+	/// <summary>Limits the socket's receive buffer (SO_RCVBUF) of the next accepted client, so a slow reader makes the client's sends block soon.</summary>
+	void SetReceiveBufferSize(int size);
+
+	/// <summary>Accepts a client and answers its handshake on a thread, so the client can Open meanwhile.</summary>
+	void BeginAccept(void);
+
+	/// <returns>false if there was no valid handshake.</returns>
+	bool EndAccept(void);
+
+	/// <summary>Blocks until a complete frame has been received, the payload is unmasked.</summary>
+	/// <returns>false on error, closed connection or if the client frame was not masked.</returns>
+	bool ReceiveFrame(unsigned char & outOpcode, std::vector<unsigned char> & outPayload);
+
+	/// <returns>If the last received frame was compressed.</returns>
+	bool GetReceivedCompressed(void) const;
+
+	/// <returns>Payload bytes received (as on the wire, i.e. compressed).</returns>
+	size_t GetReceivedBytes(void) const;
+
+	/// <summary>Sends an unmasked frame.</summary>
+	/// <param name="compress">Compress it (permessage-deflate must have been accepted).</param>
+	bool SendFrame(unsigned char opcode, void const * data, size_t size, bool fin = true, bool compress = false);
+
+	/// <summary>Closes the client connection without closing handshake.</summary>
+	void Disconnect(void);
+
+private:
+#ifdef _WIN32
+	typedef uintptr_t Socket_t;
+#else
+	typedef int Socket_t;
+#endif
+
+	Socket_t m_Listen;
+	Socket_t m_Client;
+	int m_Port;
+	std::thread * m_AcceptThread;
+	bool m_Accepted;
+	bool m_Deflate;
+	z_stream_s * m_Inflater;
+	z_stream_s * m_Deflater;
+	bool m_ReceivedCompressed;
+	size_t m_ReceivedBytes;
+
+	void Accept(void);
+
+	bool ReceiveExactly(void * data, size_t size);
+};
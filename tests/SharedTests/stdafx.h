@@ -0,0 +1,43 @@
+#pragma once
+
+// Portability layer for the shared/ code under test, so it builds without
+// Windows headers (MSVC provides all of this natively).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#ifndef _WIN32
+
+#include <strings.h>
+#include <string>
+
+#define abstract
+#define __declspec(x)
+#define __stdcall
+
+#define _stricmp strcasecmp
+#define _fseeki64 fseeko
+#define _ftelli64 ftello
+#define _TRUNCATE ((size_t)-1)
+
+template<size_t size, typename ... Args> int _snprintf_s(char (& buffer)[size], size_t /*count*/, char const * format, Args ... args)
+{
+	return snprintf(buffer, size, format, args ...);
+}
+
+inline int _wfopen_s(FILE ** pFile, wchar_t const * fileName, wchar_t const * mode)
+{
+	std::string narrowFileName;
+	std::string narrowMode;
+
+	for (; *fileName; ++fileName) narrowFileName += (char)*fileName;
+	for (; *mode; ++mode) narrowMode += (char)*mode;
+
+	*pFile = fopen(narrowFileName.c_str(), narrowMode.c_str());
+
+	return *pFile ? 0 : 1;
+}
+
+#endif